@@ -13,6 +13,8 @@ set CACHEBLOCKSTORE_SRC=%BASE_DIR%lib\cacheblockstore\*.c
 
 set FILESTORAGE_SRC=%BASE_DIR%lib\*.c
 
+set FASTCDCCHUNKER_SRC=%BASE_DIR%lib\fastcdcchunker\*.c
+
 set FSBLOCKSTORE_SRC=%BASE_DIR%lib\fsblockstore\*.c
 
 set HPCDCCHUNKER_SRC=%BASE_DIR%lib\hpcdcchunker\*.c
@@ -33,6 +35,8 @@ set HASH_REGISTRY_SRC=%BASE_DIR%lib\hashregistry\*.c
 
 set SHAREBLOCKSTORE_SRC=%BASE_DIR%lib\shareblockstore\*.c
 
+set SEEDBLOCKSTORE_SRC=%BASE_DIR%lib\seedblockstore\*.c
+
 set BIKESHED_SRC=%BASE_DIR%lib\bikeshed\*.c
 
 set BLAKE2_SRC=%BASE_DIR%lib\blake2\*.c
@@ -55,7 +59,7 @@ set ZSTD_SRC=%BASE_DIR%lib\zstd\*.c
 set ZSTD_THIRDPARTY_SRC=%BASE_DIR%lib\zstd\ext\common\*.c %BASE_DIR%lib\zstd\ext\compress\*.c %BASE_DIR%lib\zstd\ext\decompress\*.c
 set ZSTD_THIRDPARTY_GCC_SRC=%BASE_DIR%lib\zstd\ext\decompress\*.S
 
-set SRC=%BASE_DIR%src\*.c %LIB_SRC% %ARCHIVEBLOCKSTORE_SRC% %ATOMICCANCEL_SRC% %BLOCKSTORESTORAGE_SRC% %COMPRESSBLOCKSTORE_SRC% %CACHEBLOCKSTORE_SRC% %SHAREBLOCKSTORE_SRC% %FILESTORAGE_SRC% %FSBLOCKSTORE_SRC% %HPCDCCHUNKER_SRC% %LRUBLOCKSTORE_SRC% %MEMSTORAGE_SRC% %MEMTRACER_SRC% %MEOWHASH_SRC% %RATELIMITEDPROGRESS_SRC% %COMPRESSION_REGISTRY_SRC% %HASH_REGISTRY_SRC% %BIKESHED_SRC% %BLAKE2_SRC% %BLAKE3_SRC% %LZ4_SRC% %BROTLI_SRC% %ZSTD_SRC%
+set SRC=%BASE_DIR%src\*.c %LIB_SRC% %ARCHIVEBLOCKSTORE_SRC% %ATOMICCANCEL_SRC% %BLOCKSTORESTORAGE_SRC% %COMPRESSBLOCKSTORE_SRC% %CACHEBLOCKSTORE_SRC% %SHAREBLOCKSTORE_SRC% %SEEDBLOCKSTORE_SRC% %FILESTORAGE_SRC% %FASTCDCCHUNKER_SRC% %FSBLOCKSTORE_SRC% %HPCDCCHUNKER_SRC% %LRUBLOCKSTORE_SRC% %MEMSTORAGE_SRC% %MEMTRACER_SRC% %MEOWHASH_SRC% %RATELIMITEDPROGRESS_SRC% %COMPRESSION_REGISTRY_SRC% %HASH_REGISTRY_SRC% %BIKESHED_SRC% %BLAKE2_SRC% %BLAKE3_SRC% %LZ4_SRC% %BROTLI_SRC% %ZSTD_SRC%
 set THIRDPARTY_SRC=%LIB_THIRDPARTY_SRC% %BLAKE2_THIRDPARTY_SRC% %BLAKE3_THIRDPARTY_SRC% %LZ4_THIRDPARTY_SRC% %BROTLI_THIRDPARTY_SRC% %ZSTD_THIRDPARTY_SRC%
 set THIRDPARTY_SRC_SSE42=%BLAKE3_THIRDPARTY_SSE42%
 set THIRDPARTY_SRC_AVX2=%BLAKE3_THIRDPARTY_AVX2%
@@ -15,6 +15,8 @@ CACHEBLOCKSTORE_SRC="${BASE_DIR}lib/cacheblockstore/*.c"
 
 FILESTORAGE_SRC="${BASE_DIR}lib/*.c"
 
+FASTCDCCHUNKER_SRC="${BASE_DIR}lib/fastcdcchunker/*.c"
+
 FSBLOCKSTORAGE_SRC="${BASE_DIR}lib/fsblockstore/*.c"
 
 HPCDCCHUNKER_SRC="${BASE_DIR}lib/hpcdcchunker/*.c"
@@ -35,6 +37,8 @@ HASH_REGISTRY_SRC="${BASE_DIR}lib/hashregistry/*.c"
 
 SHAREBLOCKSTORE_SRC="${BASE_DIR}lib/shareblockstore/*.c"
 
+SEEDBLOCKSTORE_SRC="${BASE_DIR}lib/seedblockstore/*.c"
+
 BIKESHED_SRC="${BASE_DIR}lib/bikeshed/*.c"
 
 BLAKE2_SRC="${BASE_DIR}lib/blake2/*.c"
@@ -57,7 +61,7 @@ ZSTD_SRC="${BASE_DIR}lib/zstd/*.c"
 ZSTD_THIRDPARTY_SRC="${BASE_DIR}lib/zstd/ext/common/*.c ${BASE_DIR}lib/zstd/ext/compress/*.c ${BASE_DIR}lib/zstd/ext/decompress/*.c"
 ZSTD_THIRDPARTY_GCC_SRC="${BASE_DIR}lib/zstd/ext/decompress/*.S"
 
-export SRC="${BASE_DIR}src/*.c $LIB_SRC $ARCHIVEBLOCKSTORE_SRC $ATOMICCANCEL_SRC $BLOCKSTORESTORAGE_SRC $COMPRESSBLOCKSTORE_SRC $CACHEBLOCKSTORE_SRC $SHAREBLOCKSTORE_SRC $FILESTORAGE_SRC $FSBLOCKSTORAGE_SRC $HPCDCCHUNKER_SRC $LRUBLOCKSTORE_SRC $MEMSTORAGE_SRC $MEMTRACER_SRC $MEOWHASH_SRC $RATELIMITEDPROGRESS_SRC $COMPRESSION_REGISTRY_SRC $HASH_REGISTRY_SRC $BIKESHED_SRC $BLAKE2_SRC $BLAKE3_SRC $LZ4_SRC $BROTLI_SRC $ZSTD_SRC"
+export SRC="${BASE_DIR}src/*.c $LIB_SRC $ARCHIVEBLOCKSTORE_SRC $ATOMICCANCEL_SRC $BLOCKSTORESTORAGE_SRC $COMPRESSBLOCKSTORE_SRC $CACHEBLOCKSTORE_SRC $SHAREBLOCKSTORE_SRC $SEEDBLOCKSTORE_SRC $FILESTORAGE_SRC $FASTCDCCHUNKER_SRC $FSBLOCKSTORAGE_SRC $HPCDCCHUNKER_SRC $LRUBLOCKSTORE_SRC $MEMSTORAGE_SRC $MEMTRACER_SRC $MEOWHASH_SRC $RATELIMITEDPROGRESS_SRC $COMPRESSION_REGISTRY_SRC $HASH_REGISTRY_SRC $BIKESHED_SRC $BLAKE2_SRC $BLAKE3_SRC $LZ4_SRC $BROTLI_SRC $ZSTD_SRC"
 export THIRDPARTY_SRC="$LIB_THIRDPARTY_SRC $BLAKE2_THIRDPARTY_SRC $BLAKE3_THIRDPARTY_SRC $LZ4_THIRDPARTY_SRC $BROTLI_THIRDPARTY_SRC $ZSTD_THIRDPARTY_SRC"
 export THIRDPARTY_SRC_SSE42="$BLAKE3_THIRDPARTY_SSE42"
 export THIRDPARTY_SRC_AVX2="$BLAKE3_THIRDPARTY_AVX2"
@@ -11,6 +11,7 @@
 #include "../lib/blockstorestorage/longtail_blockstorestorage.h"
 #include "../lib/cacheblockstore/longtail_cacheblockstore.h"
 #include "../lib/compressionregistry/longtail_full_compression_registry.h"
+#include "../lib/fastcdcchunker/longtail_fastcdcchunker.h"
 #include "../lib/fsblockstore/longtail_fsblockstore.h"
 #include "../lib/hpcdcchunker/longtail_hpcdcchunker.h"
 #include "../lib/filestorage/longtail_filestorage.h"
@@ -33,6 +34,9 @@
 #include <inttypes.h>
 #include <stdarg.h>
 
+// Resident size of decompressed blocks kept in memory, 32 blocks of the default 8 MB target block size
+#define LRU_BLOCK_STORE_MAX_SIZE (32u * 8388608u)
+
 static void AssertFailure(const char* expression, const char* file, int line)
 {
     fprintf(stderr, "%s(%d): Assert failed `%s`\n", file, line, expression);
@@ -212,6 +216,15 @@ uint32_t ParseCompressionType(const char* compression_algorithm) {
     {
         return Longtail_GetZStdMaxQuality();
     }
+    if (strncmp("zstd_dict_", compression_algorithm, 10) == 0)
+    {
+        char* id_end = 0;
+        unsigned long dictionary_id = strtoul(&compression_algorithm[10], &id_end, 16);
+        if (id_end != &compression_algorithm[10] && *id_end == '\0' && dictionary_id <= 0xffff)
+        {
+            return Longtail_GetZStdDictionaryQuality((uint32_t)dictionary_id);
+        }
+    }
     return 0xffffffff;
 }
 
@@ -232,6 +245,31 @@ uint32_t ParseHashingType(const char* hashing_type)
     return 0xffffffff;
 }
 
+#define CHUNKER_TYPE_HPCDC      0u
+#define CHUNKER_TYPE_FASTCDC    1u
+
+uint32_t ParseChunkerType(const char* chunker_type)
+{
+    if (0 == chunker_type || (strcmp("hpcdc", chunker_type) == 0))
+    {
+        return CHUNKER_TYPE_HPCDC;
+    }
+    if (strcmp("fastcdc", chunker_type) == 0)
+    {
+        return CHUNKER_TYPE_FASTCDC;
+    }
+    return 0xffffffff;
+}
+
+static struct Longtail_ChunkerAPI* CreateChunkerAPI(uint32_t chunker_type)
+{
+    if (chunker_type == CHUNKER_TYPE_FASTCDC)
+    {
+        return Longtail_CreateFastCDCChunkerAPI();
+    }
+    return Longtail_CreateHPCDCChunkerAPI();
+}
+
 static char* NormalizePath(const char* path)
 {
     if (!path)
@@ -331,36 +369,124 @@ static int SyncGetExistingContent(struct Longtail_BlockStoreAPI* block_store, ui
     return 0;
 }
 
+// The scan cache holds the file infos and version index of the previous upsync of a source folder so the next
+// upsync only needs to read files whose size or modification time changed
+// Zstd dictionaries for a store live in the `dictionaries` folder of the store
+static struct Longtail_CompressionRegistryAPI* CreateStoreCompressionRegistry(struct Longtail_StorageAPI* storage_api, const char* storage_path)
+{
+    char* dictionary_folder = storage_api->ConcatPath(storage_api, storage_path, "dictionaries");
+    struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullDictionaryCompressionRegistry(storage_api, dictionary_folder);
+    Longtail_Free(dictionary_folder);
+    return compression_registry;
+}
+
+static int ReadScanCache(
+    struct Longtail_StorageAPI* storage_api,
+    const char* scan_cache_path,
+    struct Longtail_FileInfos** out_file_infos,
+    struct Longtail_VersionIndex** out_version_index)
+{
+    char* file_infos_path = storage_api->ConcatPath(storage_api, scan_cache_path, "scan.lfi");
+    char* version_index_path = storage_api->ConcatPath(storage_api, scan_cache_path, "scan.lvi");
+    struct Longtail_FileInfos* file_infos = 0;
+    struct Longtail_VersionIndex* version_index = 0;
+    int err = Longtail_ReadFileInfos(storage_api, file_infos_path, &file_infos);
+    if (err == 0)
+    {
+        err = Longtail_ReadVersionIndex(storage_api, version_index_path, &version_index);
+        if (err)
+        {
+            Longtail_Free(file_infos);
+        }
+    }
+    Longtail_Free(version_index_path);
+    Longtail_Free(file_infos_path);
+    if (err)
+    {
+        return err;
+    }
+    *out_file_infos = file_infos;
+    *out_version_index = version_index;
+    return 0;
+}
+
+static int WriteScanCache(
+    struct Longtail_StorageAPI* storage_api,
+    const char* scan_cache_path,
+    const struct Longtail_FileInfos* file_infos,
+    struct Longtail_VersionIndex* version_index)
+{
+    char* file_infos_path = storage_api->ConcatPath(storage_api, scan_cache_path, "scan.lfi");
+    char* version_index_path = storage_api->ConcatPath(storage_api, scan_cache_path, "scan.lvi");
+    int err = Longtail_WriteVersionIndex(storage_api, version_index, version_index_path);
+    if (err == 0)
+    {
+        err = Longtail_WriteFileInfos(storage_api, file_infos, file_infos_path);
+    }
+    Longtail_Free(version_index_path);
+    Longtail_Free(file_infos_path);
+    return err;
+}
+
 int UpSync(
     const char* storage_uri_raw,
     const char* source_path,
     const char* optional_source_index_path,
+    const char* optional_scan_cache_path,
     const char* target_index_path,
     uint32_t target_chunk_size,
     uint32_t target_block_size,
     uint32_t max_chunks_per_block,
     uint32_t min_block_usage_percent,
     uint32_t hashing_type,
+    uint32_t chunker_type,
     uint32_t compression_type)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(storage_uri_raw, "%s"),
         LONGTAIL_LOGFIELD(source_path, "%s"),
         LONGTAIL_LOGFIELD(optional_source_index_path, "%p"),
+        LONGTAIL_LOGFIELD(optional_scan_cache_path, "%p"),
         LONGTAIL_LOGFIELD(target_index_path, "%s"),
         LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
         LONGTAIL_LOGFIELD(target_block_size, "%u"),
         LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
         LONGTAIL_LOGFIELD(min_block_usage_percent, "%u"),
         LONGTAIL_LOGFIELD(hashing_type, "%u"),
+        LONGTAIL_LOGFIELD(chunker_type, "%u"),
         LONGTAIL_LOGFIELD(compression_type, "%u")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     const char* storage_path = NormalizePath(storage_uri_raw);
     struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
     struct Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
-    struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
     struct Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+    struct Longtail_CompressionRegistryAPI* compression_registry = CreateStoreCompressionRegistry(storage_api, storage_path);
+    if (!compression_registry)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to create compression registry for `%s`", storage_path);
+        SAFE_DISPOSE_API(storage_api);
+        SAFE_DISPOSE_API(job_api);
+        SAFE_DISPOSE_API(hash_registry);
+        Longtail_Free((char*)storage_path);
+        return ENOMEM;
+    }
+    if (compression_type != 0)
+    {
+        struct Longtail_CompressionAPI* compression_api;
+        uint32_t compression_settings;
+        int err = compression_registry->GetCompressionAPI(compression_registry, compression_type, &compression_api, &compression_settings);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Compression type %u is not available for `%s`, missing dictionary?", compression_type, storage_path);
+            SAFE_DISPOSE_API(compression_registry);
+            SAFE_DISPOSE_API(storage_api);
+            SAFE_DISPOSE_API(job_api);
+            SAFE_DISPOSE_API(hash_registry);
+            Longtail_Free((char*)storage_path);
+            return err;
+        }
+    }
     struct Longtail_BlockStoreAPI* store_block_fsstore_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, storage_path, 0);
     struct Longtail_BlockStoreAPI* store_block_store_api = Longtail_CreateCompressBlockStoreAPI(store_block_fsstore_api, compression_registry);
 
@@ -389,7 +515,7 @@ int UpSync(
         SAFE_DISPOSE_API(hash_registry);
         return err;
     }
-    struct Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    struct Longtail_ChunkerAPI* chunker_api = CreateChunkerAPI(chunker_type);
     if (!chunker_api)
     {
         Longtail_Free(source_version_index);
@@ -404,11 +530,13 @@ int UpSync(
         return ENOMEM;
     }
 
+    struct Longtail_FileInfos* file_infos = 0;
+    uint32_t* tags = 0;
     if (source_version_index == 0)
     {
-        struct Longtail_FileInfos* file_infos;
-        err = Longtail_GetFilesRecursively(
+        err = Longtail_GetFilesRecursivelyParallel(
             storage_api,
+            job_api,
             0,
             0,
             0,
@@ -427,16 +555,85 @@ int UpSync(
             Longtail_Free((char*)storage_path);
             return err;
         }
-        uint32_t* tags = (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * file_infos->m_Count);
+        tags = (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * file_infos->m_Count);
         for (uint32_t i = 0; i < file_infos->m_Count; ++i)
         {
             tags[i] = compression_type;
         }
 
-        struct Longtail_ProgressAPI* progress = MakeProgressAPI("Indexing version");
+        struct Longtail_FileInfos* previous_file_infos = 0;
+        struct Longtail_VersionIndex* previous_version_index = 0;
+        if (optional_scan_cache_path)
+        {
+            err = ReadScanCache(storage_api, optional_scan_cache_path, &previous_file_infos, &previous_version_index);
+            if (err && err != ENOENT)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to read scan cache from `%s`, %d", optional_scan_cache_path, err);
+            }
+        }
+        if (previous_version_index)
+        {
+            // Only changed files are read, the blocks are written below the same way as for a pre-computed source index
+            struct Longtail_ProgressAPI* progress = MakeProgressAPI("Indexing version");
+            if (progress)
+            {
+                err = Longtail_CreateVersionIndexIncremental(
+                    storage_api,
+                    hash_api,
+                    chunker_api,
+                    job_api,
+                    progress,
+                    0,
+                    0,
+                    source_path,
+                    file_infos,
+                    tags,
+                    target_chunk_size,
+                    previous_version_index,
+                    previous_file_infos,
+                    &source_version_index);
+                SAFE_DISPOSE_API(progress);
+            }
+            else
+            {
+                err = ENOMEM;
+            }
+            Longtail_Free(previous_version_index);
+            Longtail_Free(previous_file_infos);
+            Longtail_Free(tags);
+            tags = 0;
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to create version index for `%s`, %d", source_path, err);
+                Longtail_Free(file_infos);
+                SAFE_DISPOSE_API(chunker_api);
+                SAFE_DISPOSE_API(store_block_store_api);
+                SAFE_DISPOSE_API(store_block_fsstore_api);
+                SAFE_DISPOSE_API(storage_api);
+                SAFE_DISPOSE_API(compression_registry);
+                SAFE_DISPOSE_API(hash_registry);
+                SAFE_DISPOSE_API(job_api);
+                Longtail_Free((char*)storage_path);
+                return err;
+            }
+            err = WriteScanCache(storage_api, optional_scan_cache_path, file_infos, source_version_index);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to write scan cache to `%s`, %d", optional_scan_cache_path, err);
+            }
+            Longtail_Free(file_infos);
+            file_infos = 0;
+        }
+    }
+
+    if (source_version_index == 0)
+    {
+        // Without a source index we index the version and write the missing blocks in one pass over the source data
+        struct Longtail_StoreIndex* written_store_index = 0;
+        struct Longtail_ProgressAPI* progress = MakeProgressAPI("Indexing version and writing blocks");
         if (progress)
         {
-            err = Longtail_CreateVersionIndex(
+            err = Longtail_CreateVersionIndexAndWriteContent(
                 storage_api,
                 hash_api,
                 chunker_api,
@@ -444,11 +641,16 @@ int UpSync(
                 progress,
                 0,
                 0,
+                store_block_store_api,
                 source_path,
                 file_infos,
                 tags,
                 target_chunk_size,
-                &source_version_index);
+                target_block_size,
+                max_chunks_per_block,
+                min_block_usage_percent,
+                &source_version_index,
+                &written_store_index);
             SAFE_DISPOSE_API(progress);
         }
         else
@@ -457,10 +659,18 @@ int UpSync(
         }
 
         Longtail_Free(tags);
+        if (err == 0 && optional_scan_cache_path)
+        {
+            int cache_err = WriteScanCache(storage_api, optional_scan_cache_path, file_infos, source_version_index);
+            if (cache_err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to write scan cache to `%s`, %d", optional_scan_cache_path, cache_err);
+            }
+        }
         Longtail_Free(file_infos);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to create version index for `%s`, %d", source_path, err);
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to create version index and store blocks for `%s` to `%s`, %d", source_path, storage_uri_raw, err);
             SAFE_DISPOSE_API(chunker_api);
             SAFE_DISPOSE_API(store_block_store_api);
             SAFE_DISPOSE_API(store_block_fsstore_api);
@@ -471,6 +681,27 @@ int UpSync(
             Longtail_Free((char*)storage_path);
             return err;
         }
+        Longtail_Free(written_store_index);
+
+        err = Longtail_WriteVersionIndex(
+            storage_api,
+            source_version_index,
+            target_index_path);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to write version index for `%s` to `%s`, %d", source_path, target_index_path, err);
+        }
+
+        Longtail_Free(source_version_index);
+        SAFE_DISPOSE_API(chunker_api);
+        SAFE_DISPOSE_API(store_block_store_api);
+        SAFE_DISPOSE_API(store_block_fsstore_api);
+        SAFE_DISPOSE_API(storage_api);
+        SAFE_DISPOSE_API(compression_registry);
+        SAFE_DISPOSE_API(hash_registry);
+        SAFE_DISPOSE_API(job_api);
+        Longtail_Free((char*)storage_path);
+        return err;
     }
 
     struct Longtail_StoreIndex* existing_remote_store_index;
@@ -620,6 +851,8 @@ int DownSync(
     const char* source_path,
     const char* target_path,
     const char* optional_target_index_path,
+    const char* optional_journal_path,
+    uint32_t chunker_type,
     int retain_permissions)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -628,14 +861,25 @@ int DownSync(
         LONGTAIL_LOGFIELD(source_path, "%s"),
         LONGTAIL_LOGFIELD(target_path, "%s"),
         LONGTAIL_LOGFIELD(optional_target_index_path, "%p"),
+        LONGTAIL_LOGFIELD(optional_journal_path, "%p"),
+        LONGTAIL_LOGFIELD(chunker_type, "%u"),
         LONGTAIL_LOGFIELD(retain_permissions, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     const char* storage_path = NormalizePath(storage_uri_raw);
     struct Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
     struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
-    struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
     struct Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+    struct Longtail_CompressionRegistryAPI* compression_registry = CreateStoreCompressionRegistry(storage_api, storage_path);
+    if (!compression_registry)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to create compression registry for `%s`", storage_path);
+        SAFE_DISPOSE_API(storage_api);
+        SAFE_DISPOSE_API(hash_registry);
+        SAFE_DISPOSE_API(job_api);
+        Longtail_Free((void*)storage_path);
+        return ENOMEM;
+    }
     struct Longtail_BlockStoreAPI* store_block_remotestore_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, storage_path, 0);
     struct Longtail_BlockStoreAPI* store_block_localstore_api = 0;
     struct Longtail_BlockStoreAPI* store_block_cachestore_api = 0;
@@ -651,7 +895,7 @@ int DownSync(
         compress_block_store_api = Longtail_CreateCompressBlockStoreAPI(store_block_remotestore_api, compression_registry);
     }
 
-    struct Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(compress_block_store_api, 32);
+    struct Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateSizedLRUBlockStoreAPI(compress_block_store_api, LRU_BLOCK_STORE_MAX_SIZE);
     struct Longtail_BlockStoreAPI* store_block_store_api = Longtail_CreateShareBlockStoreAPI(lru_block_store_api);
 
     struct Longtail_VersionIndex* source_version_index = 0;
@@ -693,7 +937,7 @@ int DownSync(
         return err;
     }
 
-    struct Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    struct Longtail_ChunkerAPI* chunker_api = CreateChunkerAPI(chunker_type);
     if (!chunker_api)
     {
         Longtail_Free(source_version_index);
@@ -726,8 +970,9 @@ int DownSync(
     if (target_version_index == 0)
     {
         struct Longtail_FileInfos* file_infos;
-        err = Longtail_GetFilesRecursively(
+        err = Longtail_GetFilesRecursivelyParallel(
             storage_api,
+            job_api,
             0,
             0,
             0,
@@ -829,6 +1074,7 @@ int DownSync(
     }
 
     if ((*version_diff->m_SourceRemovedCount == 0) &&
+        (*version_diff->m_MovedCount == 0) &&
         (*version_diff->m_ModifiedContentCount == 0) &&
         (*version_diff->m_TargetAddedCount == 0) &&
         (*version_diff->m_ModifiedPermissionsCount == 0 || !retain_permissions) )
@@ -914,7 +1160,7 @@ int DownSync(
     struct Longtail_ProgressAPI* progress = MakeProgressAPI("Updating version");
     if (progress)
     {
-        err = Longtail_ChangeVersion(
+        err = Longtail_ChangeVersionJournaled(
             store_block_store_api,
             storage_api,
             hash_api,
@@ -927,6 +1173,7 @@ int DownSync(
             source_version_index,
             version_diff,
             target_path,
+            optional_journal_path,
             retain_permissions ? 1 : 0);
         SAFE_DISPOSE_API(progress);
     }
@@ -1220,8 +1467,17 @@ int VersionIndex_cp(
 
     struct Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
     struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
-    struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
     struct Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+    struct Longtail_CompressionRegistryAPI* compression_registry = CreateStoreCompressionRegistry(storage_api, storage_path);
+    if (!compression_registry)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to create compression registry for `%s`", storage_path);
+        SAFE_DISPOSE_API(storage_api);
+        SAFE_DISPOSE_API(hash_registry);
+        SAFE_DISPOSE_API(job_api);
+        Longtail_Free((void*)storage_path);
+        return ENOMEM;
+    }
     struct Longtail_BlockStoreAPI* store_block_remotestore_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, storage_path, 0);
     struct Longtail_BlockStoreAPI* store_block_localstore_api = 0;
     struct Longtail_BlockStoreAPI* store_block_cachestore_api = 0;
@@ -1237,7 +1493,7 @@ int VersionIndex_cp(
         compress_block_store_api = Longtail_CreateCompressBlockStoreAPI(store_block_remotestore_api, compression_registry);
     }
 
-    struct Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(compress_block_store_api, 32);
+    struct Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateSizedLRUBlockStoreAPI(compress_block_store_api, LRU_BLOCK_STORE_MAX_SIZE);
     struct Longtail_BlockStoreAPI* store_block_store_api = Longtail_CreateShareBlockStoreAPI(lru_block_store_api);
 
     struct Longtail_VersionIndex* version_index = 0;
@@ -1525,6 +1781,7 @@ int Pack(
     uint32_t max_chunks_per_block,
     uint32_t min_block_usage_percent,
     uint32_t hashing_type,
+    uint32_t chunker_type,
     uint32_t compression_type)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -1535,6 +1792,7 @@ int Pack(
         LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
         LONGTAIL_LOGFIELD(min_block_usage_percent, "%u"),
         LONGTAIL_LOGFIELD(hashing_type, "%u"),
+        LONGTAIL_LOGFIELD(chunker_type, "%u"),
         LONGTAIL_LOGFIELD(compression_type, "%u")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
@@ -1543,6 +1801,22 @@ int Pack(
     struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
     struct Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
 
+    if (compression_type != 0)
+    {
+        struct Longtail_CompressionAPI* compression_api;
+        uint32_t compression_settings;
+        int err = compression_registry->GetCompressionAPI(compression_registry, compression_type, &compression_api, &compression_settings);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Compression type %u is not supported for archives", compression_type);
+            SAFE_DISPOSE_API(storage_api);
+            SAFE_DISPOSE_API(compression_registry);
+            SAFE_DISPOSE_API(job_api);
+            SAFE_DISPOSE_API(hash_registry);
+            return err;
+        }
+    }
+
     struct Longtail_HashAPI* hash_api;
     int err = hash_registry->GetHashAPI(hash_registry, hashing_type, &hash_api);
     if (err)
@@ -1553,7 +1827,7 @@ int Pack(
         SAFE_DISPOSE_API(hash_registry);
         return err;
     }
-    struct Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    struct Longtail_ChunkerAPI* chunker_api = CreateChunkerAPI(chunker_type);
     if (!chunker_api)
     {
         SAFE_DISPOSE_API(storage_api);
@@ -1566,8 +1840,9 @@ int Pack(
     struct Longtail_VersionIndex* source_version_index = 0;
     {
         struct Longtail_FileInfos* file_infos;
-        err = Longtail_GetFilesRecursively(
+        err = Longtail_GetFilesRecursivelyParallel(
             storage_api,
+            job_api,
             0,
             0,
             0,
@@ -1788,11 +2063,13 @@ int Pack(
 int Unpack(
     const char* source_path,
     const char* target_path,
+    uint32_t chunker_type,
     int retain_permissions)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(source_path, "%s"),
         LONGTAIL_LOGFIELD(target_path, "%s"),
+        LONGTAIL_LOGFIELD(chunker_type, "%u"),
         LONGTAIL_LOGFIELD(retain_permissions, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
@@ -1824,7 +2101,7 @@ int Unpack(
         SAFE_DISPOSE_API(hash_registry);
         return err;
     }
-    struct Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    struct Longtail_ChunkerAPI* chunker_api = CreateChunkerAPI(chunker_type);
     if (chunker_api == 0)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to create chunking api from `%s`, %d", source_path, err);
@@ -1838,8 +2115,9 @@ int Unpack(
     struct Longtail_VersionIndex* target_version_index = 0;
     {
         struct Longtail_FileInfos* file_infos;
-        err = Longtail_GetFilesRecursively(
+        err = Longtail_GetFilesRecursivelyParallel(
             storage_api,
+            job_api,
             0,
             0,
             0,
@@ -1927,7 +2205,7 @@ int Unpack(
         return ENOMEM;
     }
 
-    struct Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(compress_block_store_api, 32);
+    struct Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateSizedLRUBlockStoreAPI(compress_block_store_api, LRU_BLOCK_STORE_MAX_SIZE);
     if (lru_block_store_api == 0)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to create lru block store `%s`, %d", source_path, err);
@@ -1975,6 +2253,7 @@ int Unpack(
     }
 
     if ((*version_diff->m_SourceRemovedCount == 0) &&
+        (*version_diff->m_MovedCount == 0) &&
         (*version_diff->m_ModifiedContentCount == 0) &&
         (*version_diff->m_TargetAddedCount == 0) &&
         (*version_diff->m_ModifiedPermissionsCount == 0 || !retain_permissions) )
@@ -2042,6 +2321,115 @@ int Unpack(
     return err;
 }
 
+int BuildDictionary(
+    const char* storage_uri_raw,
+    const char* source_path,
+    uint32_t dictionary_id,
+    uint32_t max_dictionary_size,
+    uint32_t max_sample_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_uri_raw, "%s"),
+        LONGTAIL_LOGFIELD(source_path, "%s"),
+        LONGTAIL_LOGFIELD(dictionary_id, "%u"),
+        LONGTAIL_LOGFIELD(max_dictionary_size, "%u"),
+        LONGTAIL_LOGFIELD(max_sample_size, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    const char* storage_path = NormalizePath(storage_uri_raw);
+    struct Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+
+    struct Longtail_FileInfos* file_infos = 0;
+    int err = Longtail_GetFilesRecursively(
+        storage_api,
+        0,
+        0,
+        0,
+        source_path,
+        &file_infos);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to scan samples from `%s`, %d", source_path, err);
+        SAFE_DISPOSE_API(storage_api);
+        Longtail_Free((void*)storage_path);
+        return err;
+    }
+
+    // Each file is one sample, large files only contribute their first max_sample_size bytes
+    uint32_t file_count = file_infos->m_Count;
+    void** samples = (void**)Longtail_Alloc(0, (sizeof(void*) + sizeof(uint32_t)) * (file_count + 1));
+    uint32_t* sample_sizes = (uint32_t*)&samples[file_count + 1];
+    uint32_t sample_count = 0;
+    for (uint32_t i = 0; i < file_count && err == 0; ++i)
+    {
+        uint64_t file_size = file_infos->m_Sizes[i];
+        if (file_size == 0)
+        {
+            continue;
+        }
+        uint32_t sample_size = file_size < max_sample_size ? (uint32_t)file_size : max_sample_size;
+        char* file_path = storage_api->ConcatPath(storage_api, source_path, Longtail_FileInfos_GetPath(file_infos, i));
+        Longtail_StorageAPI_HOpenFile f;
+        err = storage_api->OpenReadFile(storage_api, file_path, &f);
+        if (err == 0)
+        {
+            void* sample = Longtail_Alloc(0, sample_size);
+            err = storage_api->Read(storage_api, f, 0, sample_size, sample);
+            storage_api->CloseFile(storage_api, f);
+            if (err == 0)
+            {
+                samples[sample_count] = sample;
+                sample_sizes[sample_count] = sample_size;
+                ++sample_count;
+            }
+            else
+            {
+                Longtail_Free(sample);
+            }
+        }
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to read sample from `%s`, %d", file_path, err);
+        }
+        Longtail_Free(file_path);
+    }
+
+    void* dictionary = 0;
+    uint32_t dictionary_size = 0;
+    if (err == 0)
+    {
+        err = Longtail_ZStdBuildDictionary(sample_count, (const void* const*)samples, sample_sizes, max_dictionary_size, &dictionary, &dictionary_size);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to build dictionary from `%s`, %d", source_path, err);
+        }
+    }
+    if (err == 0)
+    {
+        char* dictionary_folder = storage_api->ConcatPath(storage_api, storage_path, "dictionaries");
+        err = Longtail_ZStdWriteDictionary(storage_api, dictionary_folder, dictionary_id, dictionary, dictionary_size);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to write dictionary to `%s`, %d", dictionary_folder, err);
+        }
+        Longtail_Free(dictionary_folder);
+    }
+
+    if (dictionary)
+    {
+        Longtail_Free(dictionary);
+    }
+    for (uint32_t s = 0; s < sample_count; ++s)
+    {
+        Longtail_Free(samples[s]);
+    }
+    Longtail_Free(samples);
+    Longtail_Free(file_infos);
+    SAFE_DISPOSE_API(storage_api);
+    Longtail_Free((void*)storage_path);
+    return err;
+}
+
 int main(int argc, char** argv)
 {
 #if defined(_CRTDBG_MAP_ALLOC)
@@ -2059,7 +2447,7 @@ int main(int argc, char** argv)
 
     if (argc < 2)
     {
-        kgflags_set_custom_description("Use command `upsync`, `downsync`, `validate`, `ls`, `cp`, `pack` or `unpack`");
+        kgflags_set_custom_description("Use command `upsync`, `downsync`, `validate`, `ls`, `cp`, `pack`, `unpack` or `dictionary`");
         kgflags_print_usage();
         return 1;
     }
@@ -2071,9 +2459,10 @@ int main(int argc, char** argv)
         (strcmp(command, "ls") != 0) &&
         (strcmp(command, "cp") != 0) &&
         (strcmp(command, "pack") != 0) &&
-        (strcmp(command, "unpack") != 0))
+        (strcmp(command, "unpack") != 0) &&
+        (strcmp(command, "dictionary") != 0))
     {
-        kgflags_set_custom_description("Use command `upsync`, `downsync`, `validate`, `ls`, `cp`, `pack` or `unpack`");
+        kgflags_set_custom_description("Use command `upsync`, `downsync`, `validate`, `ls`, `cp`, `pack`, `unpack` or `dictionary`");
         kgflags_print_usage();
         return 1;
     }
@@ -2086,17 +2475,23 @@ int main(int argc, char** argv)
         const char* hasing_raw = 0;
         kgflags_string("hash-algorithm", "blake3", "Hashing algorithm: blake2, blake3, meow", false, &hasing_raw);
 
+        const char* chunker_raw = 0;
+        kgflags_string("chunker", "hpcdc", "Chunking algorithm: hpcdc, fastcdc", false, &chunker_raw);
+
         const char* source_path_raw = 0;
         kgflags_string("source-path", 0, "Source folder path", true, &source_path_raw);
 
         const char* source_index_raw = 0;
         kgflags_string("source-index-path", 0, "Optional pre-computed index of source-path", false, &source_index_raw);
 
+        const char* scan_cache_raw = 0;
+        kgflags_string("scan-cache-path", 0, "Optional folder where the scan of source-path is kept so the next upsync only reads changed files", false, &scan_cache_raw);
+
         const char* target_path_raw = 0;
         kgflags_string("target-path", 0, "Target file path", true, &target_path_raw);
 
         const char* compression_raw = 0;
-        kgflags_string("compression-algorithm", "zstd", "Compression algorithm: none, brotli, brotli_min, brotli_max, brotli_text, brotli_text_min, brotli_text_max, lz4, zstd, zstd_min, zstd_max", false, &compression_raw);
+        kgflags_string("compression-algorithm", "zstd", "Compression algorithm: none, brotli, brotli_min, brotli_max, brotli_text, brotli_text_min, brotli_text_max, lz4, zstd, zstd_min, zstd_max, zstd_dict_<id> where <id> is the hex id of a dictionary created with the `dictionary` command", false, &compression_raw);
 
         int32_t target_chunk_size = 8;
         kgflags_int("target-chunk-size", 32768, "Target chunk size", false, &target_chunk_size);
@@ -2140,24 +2535,35 @@ int main(int argc, char** argv)
             return 1;
         }
 
+        uint32_t chunker = ParseChunkerType(chunker_raw);
+        if (chunker == 0xffffffff)
+        {
+            printf("Invalid chunking algorithm `%s`\n", chunker_raw);
+            return 1;
+        }
+
         const char* source_path = NormalizePath(source_path_raw);
         const char* source_index = source_index_raw ? NormalizePath(source_index_raw) : 0;
+        const char* scan_cache = scan_cache_raw ? NormalizePath(scan_cache_raw) : 0;
         const char* target_path = NormalizePath(target_path_raw);
 
         err = UpSync(
             storage_uri_raw,
             source_path,
             source_index,
+            scan_cache,
             target_path,
             target_chunk_size,
             target_block_size,
             max_chunks_per_block,
             min_block_usage_percent,
             hashing,
+            chunker,
             compression);
 
         Longtail_Free((void*)source_path);
         Longtail_Free((void*)source_index);
+        Longtail_Free((void*)scan_cache);
         Longtail_Free((void*)target_path);
     }
     else if (strcmp(command, "downsync") == 0)
@@ -2174,9 +2580,15 @@ int main(int argc, char** argv)
         const char* target_index_raw = 0;
         kgflags_string("target-index-path", 0, "Optional pre-computed index of target-path", false, &target_index_raw);
 
+        const char* journal_path_raw = 0;
+        kgflags_string("journal-path", 0, "Optional path outside target-path for a journal that lets an interrupted downsync resume", false, &journal_path_raw);
+
         const char* source_path_raw = 0;
         kgflags_string("source-path", 0, "Source file path", true, &source_path_raw);
 
+        const char* chunker_raw = 0;
+        kgflags_string("chunker", "hpcdc", "Chunking algorithm: hpcdc, fastcdc", false, &chunker_raw);
+
         bool retain_permission_raw = 0;
         kgflags_bool("retain-permissions", true, "Disable setting permission on file/directories from source", false, &retain_permission_raw);
 
@@ -2196,9 +2608,17 @@ int main(int argc, char** argv)
             Longtail_SetAllocAndFree(Longtail_MemTracer_Alloc, Longtail_MemTracer_Free);
         }
 
+        uint32_t chunker = ParseChunkerType(chunker_raw);
+        if (chunker == 0xffffffff)
+        {
+            printf("Invalid chunking algorithm `%s`\n", chunker_raw);
+            return 1;
+        }
+
         const char* cache_path = cache_path_raw ? NormalizePath(cache_path_raw) : 0;
         const char* target_path = NormalizePath(target_path_raw);
         const char* target_index = target_index_raw ? NormalizePath(target_index_raw) : 0;
+        const char* journal_path = journal_path_raw ? NormalizePath(journal_path_raw) : 0;
         const char* source_path = NormalizePath(source_path_raw);
 
         // Downsync!
@@ -2208,9 +2628,12 @@ int main(int argc, char** argv)
             source_path,
             target_path,
             target_index,
+            journal_path,
+            chunker,
             retain_permission_raw);
 
         Longtail_Free((void*)source_path);
+        Longtail_Free((void*)journal_path);
         Longtail_Free((void*)target_index);
         Longtail_Free((void*)target_path);
         Longtail_Free((void*)cache_path);
@@ -2333,6 +2756,9 @@ int main(int argc, char** argv)
         const char* hasing_raw = 0;
         kgflags_string("hash-algorithm", "blake3", "Hashing algorithm: blake2, blake3, meow", false, &hasing_raw);
 
+        const char* chunker_raw = 0;
+        kgflags_string("chunker", "hpcdc", "Chunking algorithm: hpcdc, fastcdc", false, &chunker_raw);
+
         const char* source_path_raw = 0;
         kgflags_string("source-path", 0, "Source folder path", true, &source_path_raw);
 
@@ -2384,6 +2810,13 @@ int main(int argc, char** argv)
             return 1;
         }
 
+        uint32_t chunker = ParseChunkerType(chunker_raw);
+        if (chunker == 0xffffffff)
+        {
+            printf("Invalid chunking algorithm `%s`\n", chunker_raw);
+            return 1;
+        }
+
         const char* source_path = NormalizePath(source_path_raw);
 
         const char* target_path = NormalizePath(target_path_raw);
@@ -2396,6 +2829,7 @@ int main(int argc, char** argv)
             max_chunks_per_block,
             min_block_usage_percent,
             hashing,
+            chunker,
             compression);
 
         Longtail_Free((void*)source_path);
@@ -2409,6 +2843,9 @@ int main(int argc, char** argv)
         const char* target_path_raw = 0;
         kgflags_string("target-path", 0, "Target file path", true, &target_path_raw);
 
+        const char* chunker_raw = 0;
+        kgflags_string("chunker", "hpcdc", "Chunking algorithm: hpcdc, fastcdc", false, &chunker_raw);
+
         bool retain_permission_raw = 0;
         kgflags_bool("retain-permissions", true, "Disable setting permission on file/directories from source", false, &retain_permission_raw);
 
@@ -2428,17 +2865,83 @@ int main(int argc, char** argv)
             Longtail_SetAllocAndFree(Longtail_MemTracer_Alloc, Longtail_MemTracer_Free);
         }
 
+        uint32_t chunker = ParseChunkerType(chunker_raw);
+        if (chunker == 0xffffffff)
+        {
+            printf("Invalid chunking algorithm `%s`\n", chunker_raw);
+            return 1;
+        }
+
         const char* source_path = NormalizePath(source_path_raw);
         const char* target_path = NormalizePath(target_path_raw);
 
         err = Unpack(
             source_path,
             target_path,
+            chunker,
             retain_permission_raw);
 
         Longtail_Free((void*)source_path);
         Longtail_Free((void*)target_path);
     }
+    else if (strcmp(command, "dictionary") == 0)
+    {
+        const char* storage_uri_raw = 0;
+        kgflags_string("storage-uri", 0, "URI for chunks and store index for store", true, &storage_uri_raw);
+
+        const char* source_path_raw = 0;
+        kgflags_string("source-path", 0, "Folder with sample files of the content the dictionary should compress", true, &source_path_raw);
+
+        const char* dictionary_id_raw = 0;
+        kgflags_string("dictionary-id", 0, "Hex id of the dictionary, select it with compression algorithm zstd_dict_<id>", true, &dictionary_id_raw);
+
+        int32_t max_dictionary_size = 0;
+        kgflags_int("max-dictionary-size", 112640, "Max size of the dictionary", false, &max_dictionary_size);
+
+        int32_t max_sample_size = 0;
+        kgflags_int("max-sample-size", 131072, "Max number of bytes used as sample from each file", false, &max_sample_size);
+
+        if (!kgflags_parse(argc, argv)) {
+            kgflags_print_errors();
+            kgflags_print_usage();
+            return 1;
+        }
+
+        if (SetLogLevel(log_level_raw))
+        {
+            return 1;
+        }
+
+        if (enable_mem_tracer_raw) {
+            Longtail_MemTracer_Init();
+            Longtail_SetAllocAndFree(Longtail_MemTracer_Alloc, Longtail_MemTracer_Free);
+        }
+
+        char* id_end = 0;
+        unsigned long dictionary_id = strtoul(dictionary_id_raw, &id_end, 16);
+        if (id_end == dictionary_id_raw || *id_end != '\0' || dictionary_id > 0xffff)
+        {
+            printf("Invalid dictionary id `%s`\n", dictionary_id_raw);
+            return 1;
+        }
+
+        if (max_dictionary_size <= 0 || max_sample_size <= 0)
+        {
+            printf("Invalid dictionary or sample size\n");
+            return 1;
+        }
+
+        const char* source_path = NormalizePath(source_path_raw);
+
+        err = BuildDictionary(
+            storage_uri_raw,
+            source_path,
+            (uint32_t)dictionary_id,
+            (uint32_t)max_dictionary_size,
+            (uint32_t)max_sample_size);
+
+        Longtail_Free((void*)source_path);
+    }
 #if defined(_CRTDBG_MAP_ALLOC)
     _CrtDumpMemoryLeaks();
 #endif
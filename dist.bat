@@ -26,6 +26,7 @@ mkdir dist\include\lib\brotli
 mkdir dist\include\lib\cacheblockstore
 mkdir dist\include\lib\compressblockstore
 mkdir dist\include\lib\compressionregistry
+mkdir dist\include\lib\fastcdcchunker
 mkdir dist\include\lib\filestorage
 mkdir dist\include\lib\fsblockstore
 mkdir dist\include\lib\hpcdcchunker
@@ -37,6 +38,7 @@ mkdir dist\include\lib\memtracer
 mkdir dist\include\lib\meowhash
 mkdir dist\include\lib\ratelimitedprogress
 mkdir dist\include\lib\shareblockstore
+mkdir dist\include\lib\seedblockstore
 mkdir dist\include\lib\zstd
 cp src/*.h dist/include/src
 cp lib/archiveblockstore/*.h dist/include/lib/archiveblockstore
@@ -49,6 +51,7 @@ cp lib/brotli/*.h dist/include/lib/brotli
 cp lib/cacheblockstore/*.h dist/include/lib/cacheblockstore
 cp lib/compressblockstore/*.h dist/include/lib/compressblockstore
 cp lib/compressionregistry/*.h dist/include/lib/compressionregistry
+cp lib/fastcdcchunker/*.h dist/include/lib/fastcdcchunker
 cp lib/filestorage/*.h dist/include/lib/filestorage
 cp lib/fsblockstore/*.h dist/include/lib/fsblockstore
 cp lib/hpcdcchunker/*.h dist/include/lib/hpcdcchunker
@@ -59,5 +62,6 @@ cp lib/memstorage/*.h dist/include/lib/memstorage
 cp lib/memtracer/*.h dist/include/lib/memtracer
 cp lib/meowhash/*.h dist/include/lib/meowhash
 cp lib/shareblockstore/*.h dist/include/lib/shareblockstore
+cp lib/seedblockstore/*.h dist/include/lib/seedblockstore
 cp lib/ratelimitedprogress/*.h dist/include/lib/ratelimitedprogress
 cp lib/zstd/*.h dist/include/lib/zstd
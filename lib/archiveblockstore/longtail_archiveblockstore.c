@@ -209,6 +209,33 @@ static int ArchiveBlockStore_GetStoredBlock(
     return 0;
 }
 
+static int ArchiveBlockStore_GetStoredBlockChunks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    // Blocks are stored whole in the archive so the full block is returned
+    return ArchiveBlockStore_GetStoredBlock(block_store_api, block_hash, async_complete_api);
+}
+
 static int ArchiveBlockStore_GetExistingContent(
     struct Longtail_BlockStoreAPI* block_store_api,
     uint32_t chunk_count,
@@ -374,6 +401,8 @@ static int ArchiveBlockStore_Init(
         return EINVAL;
     }
 
+    block_store_api->GetStoredBlockChunks = ArchiveBlockStore_GetStoredBlockChunks;
+
     struct ArchiveBlockStoreAPI* api = (struct ArchiveBlockStoreAPI*)block_store_api;
 
     api->m_StorageAPI = storage_api;
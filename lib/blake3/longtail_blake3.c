@@ -1,6 +1,7 @@
 #include "longtail_blake3.h"
 
 #include "ext/blake3.h"
+#include "ext/blake3_impl.h"
 #include <errno.h>
 
 const uint32_t LONGTAIL_BLAKE3_HASH_TYPE = (((uint32_t)'b') << 24) + (((uint32_t)'l') << 16) + (((uint32_t)'k') << 8) + ((uint32_t)'3');
@@ -101,6 +102,109 @@ static int Blake3Hash_HashBuffer(struct Longtail_HashAPI* hash_api, uint32_t len
     return 0;
 }
 
+// An input of at most one BLAKE3 chunk is hashed by compressing its blocks in order, the last block is
+// compressed with the CHUNK_END and ROOT flags. The full blocks before the last one of inputs with the
+// same block count are compressed side by side with blake3_hash_many(), one input per SIMD lane.
+#define BLAKE3_BLOCKS_PER_CHUNK (BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN)
+
+static uint64_t Blake3Hash_FinishChunk(uint32_t cv[8], const uint8_t* data, uint32_t length, uint32_t full_block_count)
+{
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    uint32_t last_block_length = length - full_block_count * BLAKE3_BLOCK_LEN;
+    memset(block, 0, sizeof(block));
+    memcpy(block, &data[full_block_count * BLAKE3_BLOCK_LEN], last_block_length);
+    uint8_t flags = CHUNK_END | ROOT | (full_block_count == 0 ? CHUNK_START : 0);
+    blake3_compress_in_place(cv, block, (uint8_t)last_block_length, 0, flags);
+    return ((uint64_t)cv[0]) | (((uint64_t)cv[1]) << 32);
+}
+
+static void Blake3Hash_HashLanes(
+    const uint32_t* lane_indexes,
+    uint32_t lane_count,
+    uint32_t full_block_count,
+    const uint32_t* lengths,
+    const void* const* datas,
+    uint64_t* out_hashes)
+{
+    const uint8_t* inputs[MAX_SIMD_DEGREE_OR_2] = {0};
+    uint8_t cvs[MAX_SIMD_DEGREE_OR_2 * BLAKE3_OUT_LEN];
+    for (uint32_t l = 0; l < lane_count; ++l)
+    {
+        inputs[l] = (const uint8_t*)datas[lane_indexes[l]];
+    }
+    blake3_hash_many(inputs, lane_count, full_block_count, IV, 0, false, 0, CHUNK_START, 0, cvs);
+    for (uint32_t l = 0; l < lane_count; ++l)
+    {
+        uint32_t i = lane_indexes[l];
+        uint32_t cv[8];
+        for (uint32_t w = 0; w < 8; ++w)
+        {
+            cv[w] = load32(&cvs[l * BLAKE3_OUT_LEN + w * 4]);
+        }
+        out_hashes[i] = Blake3Hash_FinishChunk(cv, (const uint8_t*)datas[i], lengths[i], full_block_count);
+    }
+}
+
+static int Blake3Hash_HashBuffers(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(count, "%u"),
+        LONGTAIL_LOGFIELD(lengths, "%p"),
+        LONGTAIL_LOGFIELD(datas, "%p"),
+        LONGTAIL_LOGFIELD(out_hashes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, hash_api, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, count == 0 || lengths, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, count == 0 || datas, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, count == 0 || out_hashes, return EINVAL)
+
+    uint32_t simd_degree = (uint32_t)blake3_simd_degree();
+    uint32_t lane_indexes[BLAKE3_BLOCKS_PER_CHUNK][MAX_SIMD_DEGREE_OR_2];
+    uint32_t lane_counts[BLAKE3_BLOCKS_PER_CHUNK];
+    memset(lane_counts, 0, sizeof(lane_counts));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t length = lengths[i];
+        if (length > BLAKE3_CHUNK_LEN)
+        {
+            blake3_hasher hasher;
+            blake3_hasher_init(&hasher);
+            blake3_hasher_update(&hasher, datas[i], (size_t)length);
+            blake3_hasher_finalize(&hasher, (uint8_t*)&out_hashes[i], sizeof(uint64_t));
+            continue;
+        }
+        uint32_t full_block_count = length == 0 ? 0 : (length - 1) / BLAKE3_BLOCK_LEN;
+        if (full_block_count == 0)
+        {
+            uint32_t cv[8];
+            memcpy(cv, IV, sizeof(cv));
+            out_hashes[i] = Blake3Hash_FinishChunk(cv, (const uint8_t*)datas[i], length, 0);
+            continue;
+        }
+        lane_indexes[full_block_count][lane_counts[full_block_count]++] = i;
+        if (lane_counts[full_block_count] == simd_degree)
+        {
+            Blake3Hash_HashLanes(lane_indexes[full_block_count], simd_degree, full_block_count, lengths, datas, out_hashes);
+            lane_counts[full_block_count] = 0;
+        }
+    }
+    for (uint32_t full_block_count = 1; full_block_count < BLAKE3_BLOCKS_PER_CHUNK; ++full_block_count)
+    {
+        if (lane_counts[full_block_count] > 0)
+        {
+            Blake3Hash_HashLanes(lane_indexes[full_block_count], lane_counts[full_block_count], full_block_count, lengths, datas, out_hashes);
+        }
+    }
+    return 0;
+}
+
 static void Blake3Hash_Dispose(struct Longtail_API* hash_api)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -124,6 +228,7 @@ static void Blake3Hash_Init(struct Blake3HashAPI* hash_api)
     hash_api->m_Blake3HashAPI.Hash = Blake3Hash_Hash;
     hash_api->m_Blake3HashAPI.EndContext = Blake3Hash_EndContext;
     hash_api->m_Blake3HashAPI.HashBuffer = Blake3Hash_HashBuffer;
+    hash_api->m_Blake3HashAPI.HashBuffers = Blake3Hash_HashBuffers;
 }
 
 struct Longtail_HashAPI* Longtail_CreateBlake3HashAPI()
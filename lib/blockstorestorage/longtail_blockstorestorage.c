@@ -386,10 +386,25 @@ static int BlockStoreStorageAPI_ReadFromBlockJob(void* context, uint32_t job_id,
         complete_cb->m_JobID = job_id;
         complete_cb->m_Data = data;
 
-        int err = data->m_BlockStoreFS->m_BlockStore->GetStoredBlock(data->m_BlockStoreFS->m_BlockStore, data->m_Range->m_BlockHash, &complete_cb->m_API);
+        // Only ask for the chunks of the range so the block store can skip decoding the rest of the block
+        uint32_t range_chunk_count = data->m_Range->m_ChunkEnd - data->m_Range->m_ChunkStart;
+        TLongtail_Hash* range_chunk_hashes = (TLongtail_Hash*)Longtail_Alloc("BlockStoreStorageAPI", sizeof(TLongtail_Hash) * range_chunk_count);
+        if (range_chunk_hashes == 0)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            data->m_Err = ENOMEM;
+            return 0;
+        }
+        const TLongtail_Hash* version_chunk_hashes = data->m_BlockStoreFS->m_VersionIndex->m_ChunkHashes;
+        for (uint32_t c = 0; c < range_chunk_count; ++c)
+        {
+            range_chunk_hashes[c] = version_chunk_hashes[data->m_ChunkIndexes[data->m_Range->m_ChunkStart + c]];
+        }
+        int err = Longtail_BlockStore_GetStoredBlockChunks(data->m_BlockStoreFS->m_BlockStore, data->m_Range->m_BlockHash, range_chunk_count, range_chunk_hashes, &complete_cb->m_API);
+        Longtail_Free(range_chunk_hashes);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "data->m_BlockStoreFS->m_BlockStore->GetStoredBlock() failed with %d",
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BlockStore_GetStoredBlockChunks() failed with %d",
                 context, job_id, is_cancelled,
                 err)
             data->m_Err = err;
@@ -1212,6 +1227,7 @@ static int BlockStoreStorageAPI_GetEntryProperties(
     out_properties->m_IsDir = is_dir;
     out_properties->m_Permissions = block_store_fs->m_VersionIndex->m_Permissions[path_entry->m_AssetIndex];
     out_properties->m_Size = block_store_fs->m_VersionIndex->m_AssetSizes[path_entry->m_AssetIndex];
+    out_properties->m_ModificationTime = 0;
     return 0;
 }
 
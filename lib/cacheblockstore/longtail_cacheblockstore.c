@@ -622,26 +622,28 @@ static void OnGetStoredBlockGetLocalComplete(struct Longtail_AsyncGetStoredBlock
     CacheBlockStore_CompleteRequest(cacheblockstore_api);
 }
 
-static int CacheBlockStore_GetStoredBlock(
-    struct Longtail_BlockStoreAPI* block_store_api,
+// Reads the block from the local store, chunk_hashes is zero when the full block is requested.
+// A block missing from the local store is fetched whole from the remote store so the local
+// store only ever caches full blocks
+static int CacheBlockStore_GetStoredBlockFromLocal(
+    struct CacheBlockStoreAPI* cacheblockstore_api,
     uint64_t block_hash,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
     struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(cacheblockstore_api, "%p"),
         LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
         LONGTAIL_LOGFIELD(async_complete_api, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
-
-    struct CacheBlockStoreAPI* cacheblockstore_api = (struct CacheBlockStoreAPI*)block_store_api;
-
     Longtail_AtomicAdd64(&cacheblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count], 1);
 
     size_t on_get_stored_block_get_local_complete_api_size = sizeof(struct OnGetStoredBlockGetLocalComplete_API);
@@ -658,7 +660,9 @@ static int CacheBlockStore_GetStoredBlock(
     on_get_stored_block_get_local_complete_api->block_hash = block_hash;
     on_get_stored_block_get_local_complete_api->async_complete_api = async_complete_api;
     Longtail_AtomicAdd32(&cacheblockstore_api->m_PendingRequestCount, 1);
-    int err = cacheblockstore_api->m_LocalBlockStoreAPI->GetStoredBlock(cacheblockstore_api->m_LocalBlockStoreAPI, block_hash, &on_get_stored_block_get_local_complete_api->m_API);
+    int err = chunk_hashes ?
+        Longtail_BlockStore_GetStoredBlockChunks(cacheblockstore_api->m_LocalBlockStoreAPI, block_hash, chunk_count, chunk_hashes, &on_get_stored_block_get_local_complete_api->m_API) :
+        cacheblockstore_api->m_LocalBlockStoreAPI->GetStoredBlock(cacheblockstore_api->m_LocalBlockStoreAPI, block_hash, &on_get_stored_block_get_local_complete_api->m_API);
     if (err)
     {
         Longtail_AtomicAdd64(&cacheblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
@@ -668,6 +672,53 @@ static int CacheBlockStore_GetStoredBlock(
     return 0;
 }
 
+static int CacheBlockStore_GetStoredBlock(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    return CacheBlockStore_GetStoredBlockFromLocal((struct CacheBlockStoreAPI*)block_store_api, block_hash, 0, 0, async_complete_api);
+}
+
+static int CacheBlockStore_GetStoredBlockChunks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    return CacheBlockStore_GetStoredBlockFromLocal((struct CacheBlockStoreAPI*)block_store_api, block_hash, chunk_count, chunk_hashes, async_complete_api);
+}
+
 struct GetExistingContext_GetExistingRemoteContent_Context
 {
     struct Longtail_AsyncGetExistingContentAPI m_AsyncCompleteAPI;
@@ -947,6 +998,8 @@ static int CacheBlockStore_Init(
         return EINVAL;
     }
 
+    block_store_api->GetStoredBlockChunks = CacheBlockStore_GetStoredBlockChunks;
+
     struct CacheBlockStoreAPI* api = (struct CacheBlockStoreAPI*)block_store_api;
 
     api->m_LocalBlockStoreAPI = local_block_store;
@@ -12,6 +12,7 @@ struct CompressBlockStoreAPI
     struct Longtail_BlockStoreAPI m_BlockStoreAPI;
     struct Longtail_BlockStoreAPI* m_BackingBlockStore;
     struct Longtail_CompressionRegistryAPI* m_CompressionRegistryAPI;
+    uint32_t m_TargetFrameSize;
     struct Longtail_BlockStore_Stats m_Stats;
 
     TLongtail_Atomic64 m_StatU64[Longtail_BlockStoreAPI_StatU64_Count];
@@ -64,14 +65,125 @@ static int CompressedStoredBlock_Dispose(struct Longtail_StoredBlock* stored_blo
     return 0;
 }
 
+// The compressed chunk data of a block starts with a [uncompressed size, compressed size] header.
+// A seekable block stores this marker in place of the compressed size, followed by the frame count
+// and a [chunk count, compressed size] entry for each frame
+#define LONGTAIL_COMPRESS_BLOCK_SEEKABLE_MARKER 0xffffffffu
+
+static uint32_t GetFrameChunkCount(
+    const uint32_t* chunk_sizes,
+    uint32_t chunk_count,
+    uint32_t first_chunk_index,
+    uint32_t target_frame_size,
+    uint32_t* out_frame_size)
+{
+    uint32_t frame_size = 0;
+    uint32_t chunk_index = first_chunk_index;
+    while (chunk_index < chunk_count && frame_size < target_frame_size)
+    {
+        frame_size += chunk_sizes[chunk_index++];
+    }
+    *out_frame_size = frame_size;
+    return chunk_index - first_chunk_index;
+}
+
+static int CompressBlockSeekable(
+    struct Longtail_CompressionAPI* compression_api,
+    uint32_t compression_settings,
+    uint32_t target_frame_size,
+    uint32_t frame_count,
+    struct Longtail_StoredBlock* uncompressed_stored_block,
+    struct Longtail_StoredBlock** out_compressed_stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_api, "%p"),
+        LONGTAIL_LOGFIELD(compression_settings, "%u"),
+        LONGTAIL_LOGFIELD(target_frame_size, "%u"),
+        LONGTAIL_LOGFIELD(frame_count, "%u"),
+        LONGTAIL_LOGFIELD(uncompressed_stored_block, "%p"),
+        LONGTAIL_LOGFIELD(out_compressed_stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    uint32_t chunk_count = *uncompressed_stored_block->m_BlockIndex->m_ChunkCount;
+    const uint32_t* chunk_sizes = uncompressed_stored_block->m_BlockIndex->m_ChunkSizes;
+    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
+    size_t header_size = sizeof(uint32_t) * (3 + 2 * frame_count);
+    size_t max_compressed_frames_size = 0;
+    uint32_t chunk_index = 0;
+    while (chunk_index < chunk_count)
+    {
+        uint32_t frame_size;
+        chunk_index += GetFrameChunkCount(chunk_sizes, chunk_count, chunk_index, target_frame_size, &frame_size);
+        max_compressed_frames_size += compression_api->GetMaxCompressedSize(compression_api, compression_settings, frame_size);
+    }
+    size_t compressed_stored_block_size = sizeof(struct Longtail_StoredBlock) + block_index_size + header_size + max_compressed_frames_size;
+    struct Longtail_StoredBlock* compressed_stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("CompressBlockStore", compressed_stored_block_size);
+    if (!compressed_stored_block)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    compressed_stored_block->m_BlockIndex = Longtail_InitBlockIndex(&compressed_stored_block[1], chunk_count);
+    LONGTAIL_FATAL_ASSERT(ctx, compressed_stored_block->m_BlockIndex != 0, return EINVAL; )
+
+    uint32_t* header_ptr = (uint32_t*)(&((uint8_t*)compressed_stored_block->m_BlockIndex)[block_index_size]);
+    compressed_stored_block->m_BlockData = header_ptr;
+    memmove(compressed_stored_block->m_BlockIndex, uncompressed_stored_block->m_BlockIndex, block_index_size);
+
+    const char* uncompressed_data = (const char*)uncompressed_stored_block->m_BlockData;
+    char* compressed_data = (char*)&header_ptr[3 + 2 * frame_count];
+    size_t uncompressed_offset = 0;
+    size_t compressed_offset = 0;
+    chunk_index = 0;
+    for (uint32_t f = 0; f < frame_count; ++f)
+    {
+        uint32_t frame_size;
+        uint32_t frame_chunk_count = GetFrameChunkCount(chunk_sizes, chunk_count, chunk_index, target_frame_size, &frame_size);
+        size_t compressed_frame_size;
+        int err = compression_api->Compress(
+            compression_api,
+            compression_settings,
+            &uncompressed_data[uncompressed_offset],
+            &compressed_data[compressed_offset],
+            frame_size,
+            max_compressed_frames_size - compressed_offset,
+            &compressed_frame_size);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "compression_api->Compress() failed with %d", err)
+            Longtail_Free(compressed_stored_block);
+            return err;
+        }
+        header_ptr[3 + 2 * f] = frame_chunk_count;
+        header_ptr[4 + 2 * f] = (uint32_t)compressed_frame_size;
+        chunk_index += frame_chunk_count;
+        uncompressed_offset += frame_size;
+        compressed_offset += compressed_frame_size;
+    }
+    LONGTAIL_FATAL_ASSERT(ctx, chunk_index == chunk_count, return EINVAL; )
+    header_ptr[0] = uncompressed_stored_block->m_BlockChunksDataSize;
+    header_ptr[1] = LONGTAIL_COMPRESS_BLOCK_SEEKABLE_MARKER;
+    header_ptr[2] = frame_count;
+    compressed_stored_block->m_BlockChunksDataSize = (uint32_t)(header_size + compressed_offset);
+    compressed_stored_block->Dispose = CompressedStoredBlock_Dispose;
+    *out_compressed_stored_block = compressed_stored_block;
+    return 0;
+}
+
 static int CompressBlock(
     struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t target_frame_size,
     struct Longtail_StoredBlock* uncompressed_stored_block,
     struct Longtail_StoredBlock** out_compressed_stored_block)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(target_frame_size, "%u"),
         LONGTAIL_LOGFIELD(uncompressed_stored_block, "%p"),
         LONGTAIL_LOGFIELD(out_compressed_stored_block, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
@@ -102,6 +214,32 @@ static int CompressBlock(
     }
     uint32_t block_chunk_data_size = uncompressed_stored_block->m_BlockChunksDataSize;
     uint32_t chunk_count = *uncompressed_stored_block->m_BlockIndex->m_ChunkCount;
+    if (target_frame_size > 0)
+    {
+        uint32_t frame_count = 0;
+        uint32_t chunk_index = 0;
+        while (chunk_index < chunk_count)
+        {
+            uint32_t frame_size;
+            chunk_index += GetFrameChunkCount(uncompressed_stored_block->m_BlockIndex->m_ChunkSizes, chunk_count, chunk_index, target_frame_size, &frame_size);
+            ++frame_count;
+        }
+        if (frame_count > 1)
+        {
+            err = CompressBlockSeekable(
+                compression_api,
+                compression_settings,
+                target_frame_size,
+                frame_count,
+                uncompressed_stored_block,
+                out_compressed_stored_block);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlockSeekable() failed with %d", err)
+            }
+            return err;
+        }
+    }
     size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
     size_t max_compressed_chunk_data_size = compression_api->GetMaxCompressedSize(compression_api, compression_settings, block_chunk_data_size);
     size_t compressed_stored_block_size = sizeof(struct Longtail_StoredBlock) + block_index_size + sizeof(uint32_t) + sizeof(uint32_t) + max_compressed_chunk_data_size;
@@ -202,7 +340,7 @@ static int CompressBlockStore_PutStoredBlock(
 
     struct Longtail_StoredBlock* compressed_stored_block;
 
-    int err = CompressBlock(block_store->m_CompressionRegistryAPI, stored_block, &compressed_stored_block);
+    int err = CompressBlock(block_store->m_CompressionRegistryAPI, block_store->m_TargetFrameSize, stored_block, &compressed_stored_block);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlock() failed with %d", err)
@@ -268,6 +406,156 @@ static int CompressBlockStore_PreflightGet(
     return err;
 }
 
+static int DecompressFrames(
+    struct Longtail_CompressionAPI* compression_api,
+    const struct Longtail_BlockIndex* block_index,
+    const uint32_t* header_ptr,
+    uint32_t compressed_data_size,
+    uint32_t first_chunk_index,
+    uint32_t chunk_count,
+    char* out_chunks_data)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_api, "%p"),
+        LONGTAIL_LOGFIELD(block_index, "%p"),
+        LONGTAIL_LOGFIELD(header_ptr, "%p"),
+        LONGTAIL_LOGFIELD(compressed_data_size, "%u"),
+        LONGTAIL_LOGFIELD(first_chunk_index, "%u"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(out_chunks_data, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    const uint32_t* chunk_sizes = block_index->m_ChunkSizes;
+    uint32_t block_chunk_count = *block_index->m_ChunkCount;
+    uint32_t end_chunk_index = first_chunk_index + chunk_count;
+
+    // The header comes from the backing store, make sure it matches the block index before using any of its sizes
+    if (compressed_data_size < sizeof(uint32_t) * 2)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Compressed block data size %u is too small for the header", compressed_data_size)
+        return EBADF;
+    }
+    uint64_t block_chunks_size = 0;
+    for (uint32_t c = 0; c < block_chunk_count; ++c)
+    {
+        block_chunks_size += chunk_sizes[c];
+    }
+    if (block_chunks_size != header_ptr[0])
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Block chunks size %" PRIu64 " does not match uncompressed size %u", block_chunks_size, header_ptr[0])
+        return EBADF;
+    }
+
+    // A block in the regular format is a single frame holding all chunks
+    uint32_t frame_count = 1;
+    const uint32_t* frame_table = 0;
+    const char* compressed_data = (const char*)&header_ptr[2];
+    uint64_t frames_data_size = compressed_data_size - sizeof(uint32_t) * 2;
+    if (header_ptr[1] == LONGTAIL_COMPRESS_BLOCK_SEEKABLE_MARKER)
+    {
+        uint64_t header_size = sizeof(uint32_t) * 3;
+        if (compressed_data_size >= header_size)
+        {
+            header_size += sizeof(uint32_t) * 2 * (uint64_t)header_ptr[2];
+        }
+        if (header_size > compressed_data_size)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Compressed block data size %u is too small for the frame table", compressed_data_size)
+            return EBADF;
+        }
+        frame_count = header_ptr[2];
+        frame_table = &header_ptr[3];
+        compressed_data = (const char*)&header_ptr[3 + 2 * frame_count];
+        frames_data_size = compressed_data_size - header_size;
+
+        uint64_t frames_chunk_count = 0;
+        uint64_t compressed_frames_size = 0;
+        for (uint32_t f = 0; f < frame_count; ++f)
+        {
+            frames_chunk_count += frame_table[2 * f];
+            compressed_frames_size += frame_table[2 * f + 1];
+        }
+        if (frames_chunk_count != block_chunk_count || compressed_frames_size > frames_data_size)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Frame table with %u frames does not match block with %u chunks", frame_count, block_chunk_count)
+            return EBADF;
+        }
+    }
+    else if (header_ptr[1] > frames_data_size)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Compressed size %u exceeds compressed block data size %u", header_ptr[1], compressed_data_size)
+        return EBADF;
+    }
+
+    uint32_t frame_chunk_start = 0;
+    size_t compressed_offset = 0;
+    size_t out_offset = 0;
+    for (uint32_t f = 0; f < frame_count && frame_chunk_start < end_chunk_index; ++f)
+    {
+        uint32_t frame_chunk_count = frame_table ? frame_table[2 * f] : block_chunk_count;
+        uint32_t compressed_frame_size = frame_table ? frame_table[2 * f + 1] : header_ptr[1];
+        uint32_t frame_chunk_end = frame_chunk_start + frame_chunk_count;
+        if (frame_chunk_end > first_chunk_index)
+        {
+            uint32_t frame_size = 0;
+            uint32_t skip_size = 0;
+            uint32_t copy_size = 0;
+            for (uint32_t c = frame_chunk_start; c < frame_chunk_end; ++c)
+            {
+                if (c < first_chunk_index)
+                {
+                    skip_size += chunk_sizes[c];
+                }
+                else if (c < end_chunk_index)
+                {
+                    copy_size += chunk_sizes[c];
+                }
+                frame_size += chunk_sizes[c];
+            }
+            // Frames that are only partially requested are decompressed to a scratch buffer
+            char* scratch_data = 0;
+            if (copy_size != frame_size)
+            {
+                scratch_data = (char*)Longtail_Alloc("CompressBlockStore", frame_size);
+                if (!scratch_data)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+                    return ENOMEM;
+                }
+            }
+            size_t real_frame_size = 0;
+            int err = compression_api->Decompress(
+                compression_api,
+                &compressed_data[compressed_offset],
+                scratch_data ? scratch_data : &out_chunks_data[out_offset],
+                compressed_frame_size,
+                frame_size,
+                &real_frame_size);
+            if (err == 0 && real_frame_size != frame_size)
+            {
+                err = EBADF;
+            }
+            if (scratch_data)
+            {
+                if (err == 0)
+                {
+                    memcpy(&out_chunks_data[out_offset], &scratch_data[skip_size], copy_size);
+                }
+                Longtail_Free(scratch_data);
+            }
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "compression_api->Decompress() failed with %d", err)
+                return err;
+            }
+            out_offset += copy_size;
+        }
+        frame_chunk_start = frame_chunk_end;
+        compressed_offset += compressed_frame_size;
+    }
+    return 0;
+}
+
 static int DecompressBlock(
     struct Longtail_CompressionRegistryAPI* compression_registry,
     struct Longtail_StoredBlock* compressed_stored_block,
@@ -296,12 +584,15 @@ static int DecompressBlock(
         return err;
     }
 
+    if (compressed_stored_block->m_BlockChunksDataSize < sizeof(uint32_t) * 2)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Compressed block data size %u is too small for the header", compressed_stored_block->m_BlockChunksDataSize)
+        return EBADF;
+    }
     uint32_t chunk_count = *compressed_stored_block->m_BlockIndex->m_ChunkCount;
     uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(chunk_count);
-    uint32_t* header_ptr = (uint32_t*)compressed_stored_block->m_BlockData;
-    void* compressed_chunks_data = &header_ptr[2];
+    const uint32_t* header_ptr = (const uint32_t*)compressed_stored_block->m_BlockData;
     uint32_t uncompressed_size = header_ptr[0];
-    uint32_t compressed_size = header_ptr[1];
 
     uint32_t uncompressed_block_data_size = block_index_data_size + uncompressed_size;
     size_t uncompressed_stored_block_size = Longtail_GetStoredBlockSize(uncompressed_block_data_size);
@@ -317,19 +608,19 @@ static int DecompressBlock(
     uncompressed_stored_block->m_BlockChunksDataSize = uncompressed_size;
     memmove(&uncompressed_stored_block->m_BlockIndex[1], &compressed_stored_block->m_BlockIndex[1], block_index_data_size);
 
-    size_t real_uncompressed_size = 0;
-    err = compression_api->Decompress(
+    err = DecompressFrames(
         compression_api,
-        (const char*)compressed_chunks_data,
-        (char*)uncompressed_stored_block->m_BlockData,
-        compressed_size,
-        uncompressed_size,
-        &real_uncompressed_size);
-    if (real_uncompressed_size != uncompressed_size)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "compression_api->Decompress() failed with %d", ENOMEM)
+        compressed_stored_block->m_BlockIndex,
+        header_ptr,
+        compressed_stored_block->m_BlockChunksDataSize,
+        0,
+        chunk_count,
+        (char*)uncompressed_stored_block->m_BlockData);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "DecompressFrames() failed with %d", err)
         Longtail_Free(uncompressed_stored_block);
-        return EBADF;
+        return err;
     }
     compressed_stored_block->Dispose(compressed_stored_block);
     uncompressed_stored_block->Dispose = CompressedStoredBlock_Dispose;
@@ -337,11 +628,108 @@ static int DecompressBlock(
     return 0;
 }
 
+static int DecompressBlockChunkRange(
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    struct Longtail_StoredBlock* compressed_stored_block,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    struct Longtail_StoredBlock** out_stored_block)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(compressed_stored_block, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    const struct Longtail_BlockIndex* block_index = compressed_stored_block->m_BlockIndex;
+    uint32_t block_chunk_count = *block_index->m_ChunkCount;
+
+    void* chunk_lookup_mem = Longtail_Alloc("CompressBlockStore", Longtail_LookupTable_GetSize(chunk_count));
+    if (!chunk_lookup_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct Longtail_LookupTable* chunk_lookup = Longtail_LookupTable_Create(chunk_lookup_mem, chunk_count, 0);
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        Longtail_LookupTable_PutUnique(chunk_lookup, chunk_hashes[c], c);
+    }
+    // Decode the smallest range of chunks that covers all the requested chunks
+    uint32_t first_chunk_index = block_chunk_count;
+    uint32_t end_chunk_index = 0;
+    for (uint32_t c = 0; c < block_chunk_count; ++c)
+    {
+        if (Longtail_LookupTable_Get(chunk_lookup, block_index->m_ChunkHashes[c]))
+        {
+            first_chunk_index = first_chunk_index < c ? first_chunk_index : c;
+            end_chunk_index = c + 1;
+        }
+    }
+    Longtail_Free(chunk_lookup_mem);
+
+    if (first_chunk_index >= end_chunk_index || (first_chunk_index == 0 && end_chunk_index == block_chunk_count))
+    {
+        return DecompressBlock(compression_registry, compressed_stored_block, out_stored_block);
+    }
+
+    uint32_t range_chunk_count = end_chunk_index - first_chunk_index;
+    uint64_t range_chunks_size = 0;
+    for (uint32_t c = first_chunk_index; c < end_chunk_index; ++c)
+    {
+        range_chunks_size += block_index->m_ChunkSizes[c];
+    }
+    if (range_chunks_size > 0xffffffffu)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Chunk range size %" PRIu64 " is too large", range_chunks_size)
+        return EBADF;
+    }
+    uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(range_chunk_count);
+    size_t stored_block_size = Longtail_GetStoredBlockSize(block_index_data_size + (size_t)range_chunks_size);
+    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("CompressBlockStore", stored_block_size);
+    if (!stored_block)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    stored_block->m_BlockIndex = Longtail_InitBlockIndex(&stored_block[1], range_chunk_count);
+    LONGTAIL_FATAL_ASSERT(ctx, stored_block->m_BlockIndex, return EINVAL; )
+    *stored_block->m_BlockIndex->m_BlockHash = *block_index->m_BlockHash;
+    *stored_block->m_BlockIndex->m_HashIdentifier = *block_index->m_HashIdentifier;
+    *stored_block->m_BlockIndex->m_ChunkCount = range_chunk_count;
+    *stored_block->m_BlockIndex->m_Tag = *block_index->m_Tag;
+    memmove(stored_block->m_BlockIndex->m_ChunkHashes, &block_index->m_ChunkHashes[first_chunk_index], sizeof(TLongtail_Hash) * range_chunk_count);
+    memmove(stored_block->m_BlockIndex->m_ChunkSizes, &block_index->m_ChunkSizes[first_chunk_index], sizeof(uint32_t) * range_chunk_count);
+    stored_block->m_BlockData = &((uint8_t*)(&stored_block->m_BlockIndex[1]))[block_index_data_size];
+    stored_block->m_BlockChunksDataSize = (uint32_t)range_chunks_size;
+
+    int err = Longtail_DecompressBlockChunks(
+        compression_registry,
+        compressed_stored_block,
+        first_chunk_index,
+        range_chunk_count,
+        stored_block->m_BlockData);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_DecompressBlockChunks() failed with %d", err)
+        Longtail_Free(stored_block);
+        return err;
+    }
+    compressed_stored_block->Dispose(compressed_stored_block);
+    stored_block->Dispose = CompressedStoredBlock_Dispose;
+    *out_stored_block = stored_block;
+    return 0;
+}
+
 struct OnGetBackingStoreAsync_API
 {
     struct Longtail_AsyncGetStoredBlockAPI m_API;
     struct CompressBlockStoreAPI* m_BlockStore;
     struct Longtail_AsyncGetStoredBlockAPI* m_AsyncCompleteAPI;
+    uint32_t m_ChunkCount;
+    const TLongtail_Hash* m_ChunkHashes;
 };
 
 static void OnGetBackingStoreComplete(struct Longtail_AsyncGetStoredBlockAPI* async_complete_api, struct Longtail_StoredBlock* stored_block, int err)
@@ -384,13 +772,29 @@ static void OnGetBackingStoreComplete(struct Longtail_AsyncGetStoredBlockAPI* as
         return;
     }
 
-    err = DecompressBlock(
-        async_block_store->m_BlockStore->m_CompressionRegistryAPI,
-        stored_block,
-        &stored_block);
+    // Only a seekable block can be decoded in part, any other block is decoded in full
+    const uint32_t* header_ptr = (const uint32_t*)stored_block->m_BlockData;
+    if (async_block_store->m_ChunkCount > 0 &&
+        stored_block->m_BlockChunksDataSize >= sizeof(uint32_t) * 2 &&
+        header_ptr[1] == LONGTAIL_COMPRESS_BLOCK_SEEKABLE_MARKER)
+    {
+        err = DecompressBlockChunkRange(
+            async_block_store->m_BlockStore->m_CompressionRegistryAPI,
+            stored_block,
+            async_block_store->m_ChunkCount,
+            async_block_store->m_ChunkHashes,
+            &stored_block);
+    }
+    else
+    {
+        err = DecompressBlock(
+            async_block_store->m_BlockStore->m_CompressionRegistryAPI,
+            stored_block,
+            &stored_block);
+    }
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "DecompressBlock() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Decompressing block failed with %d", err)
         Longtail_AtomicAdd64(&blockstore->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
         stored_block->Dispose(stored_block);
         async_block_store->m_AsyncCompleteAPI->OnComplete(async_block_store->m_AsyncCompleteAPI, 0, err);
@@ -403,29 +807,29 @@ static void OnGetBackingStoreComplete(struct Longtail_AsyncGetStoredBlockAPI* as
     CompressBlockStore_CompleteRequest(blockstore);
 }
 
-static int CompressBlockStore_GetStoredBlock(
-    struct Longtail_BlockStoreAPI* block_store_api,
+static int CompressBlockStore_GetBackingStoredBlock(
+    struct CompressBlockStoreAPI* block_store,
     uint64_t block_hash,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
     struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
+        LONGTAIL_LOGFIELD(block_store, "%p"),
         LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
         LONGTAIL_LOGFIELD(async_complete_api, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
-
-    struct CompressBlockStoreAPI* block_store = (struct CompressBlockStoreAPI*)block_store_api;
-
     Longtail_AtomicAdd64(&block_store->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count], 1);
 
-    size_t on_fetch_backing_store_async_api_size = sizeof(struct OnGetBackingStoreAsync_API);
+    // The requested chunk hashes are only valid during the call, keep a copy until the block is decompressed
+    size_t on_fetch_backing_store_async_api_size = sizeof(struct OnGetBackingStoreAsync_API) + sizeof(TLongtail_Hash) * chunk_count;
     struct OnGetBackingStoreAsync_API* on_fetch_backing_store_async_api = (struct OnGetBackingStoreAsync_API*)Longtail_Alloc("CompressBlockStore", on_fetch_backing_store_async_api_size);
     if (!on_fetch_backing_store_async_api)
     {
@@ -437,6 +841,12 @@ static int CompressBlockStore_GetStoredBlock(
     on_fetch_backing_store_async_api->m_API.m_API.Dispose = 0;
     on_fetch_backing_store_async_api->m_BlockStore = block_store;
     on_fetch_backing_store_async_api->m_AsyncCompleteAPI = async_complete_api;
+    on_fetch_backing_store_async_api->m_ChunkCount = chunk_count;
+    on_fetch_backing_store_async_api->m_ChunkHashes = (const TLongtail_Hash*)&on_fetch_backing_store_async_api[1];
+    if (chunk_count > 0)
+    {
+        memcpy(&on_fetch_backing_store_async_api[1], chunk_hashes, sizeof(TLongtail_Hash) * chunk_count);
+    }
 
     Longtail_AtomicAdd32(&block_store->m_PendingRequestCount, 1);
     int err = block_store->m_BackingBlockStore->GetStoredBlock(block_store->m_BackingBlockStore, block_hash, &on_fetch_backing_store_async_api->m_API);
@@ -454,6 +864,55 @@ static int CompressBlockStore_GetStoredBlock(
     return 0;
 }
 
+static int CompressBlockStore_GetStoredBlock(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    struct CompressBlockStoreAPI* block_store = (struct CompressBlockStoreAPI*)block_store_api;
+    return CompressBlockStore_GetBackingStoredBlock(block_store, block_hash, 0, 0, async_complete_api);
+}
+
+static int CompressBlockStore_GetStoredBlockChunks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    struct CompressBlockStoreAPI* block_store = (struct CompressBlockStoreAPI*)block_store_api;
+    return CompressBlockStore_GetBackingStoredBlock(block_store, block_hash, chunk_count, chunk_hashes, async_complete_api);
+}
+
 static int CompressBlockStore_GetExistingContent(
     struct Longtail_BlockStoreAPI* block_store_api,
     uint32_t chunk_count,
@@ -578,12 +1037,14 @@ static int CompressBlockStore_Init(
     void* mem,
     struct Longtail_BlockStoreAPI* backing_block_store,
     struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t target_frame_size,
     struct Longtail_BlockStoreAPI** out_block_store_api)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(mem, "%p"),
         LONGTAIL_LOGFIELD(backing_block_store, "%p"),
         LONGTAIL_LOGFIELD(compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(target_frame_size, "%u"),
         LONGTAIL_LOGFIELD(out_block_store_api, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
@@ -607,10 +1068,13 @@ static int CompressBlockStore_Init(
         return EINVAL;
     }
 
+    block_store_api->GetStoredBlockChunks = CompressBlockStore_GetStoredBlockChunks;
+
     struct CompressBlockStoreAPI* api = (struct CompressBlockStoreAPI*)block_store_api;
 
     api->m_BackingBlockStore = backing_block_store;
     api->m_CompressionRegistryAPI = compression_registry;
+    api->m_TargetFrameSize = target_frame_size;
     api->m_PendingRequestCount = 0;
     api->m_PendingAsyncFlushAPIs = 0;
 
@@ -653,6 +1117,7 @@ struct Longtail_BlockStoreAPI* Longtail_CreateCompressBlockStoreAPI(
         mem,
         backing_block_store,
         compression_registry,
+        0,
         &block_store_api);
     if (err)
     {
@@ -662,3 +1127,112 @@ struct Longtail_BlockStoreAPI* Longtail_CreateCompressBlockStoreAPI(
     }
     return block_store_api;
 }
+
+struct Longtail_BlockStoreAPI* Longtail_CreateSeekableCompressBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t target_frame_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(backing_block_store, "%p"),
+        LONGTAIL_LOGFIELD(compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(target_frame_size, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, backing_block_store, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, compression_registry, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, target_frame_size > 0, return 0)
+
+    size_t api_size = sizeof(struct CompressBlockStoreAPI);
+    void* mem = Longtail_Alloc("CompressBlockStore", api_size);
+    if (!mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
+    struct Longtail_BlockStoreAPI* block_store_api;
+    int err = CompressBlockStore_Init(
+        mem,
+        backing_block_store,
+        compression_registry,
+        target_frame_size,
+        &block_store_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlockStore_Init() failed with %d", err)
+        Longtail_Free(mem);
+        return 0;
+    }
+    return block_store_api;
+}
+
+int Longtail_DecompressBlockChunks(
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    const struct Longtail_StoredBlock* compressed_stored_block,
+    uint32_t first_chunk_index,
+    uint32_t chunk_count,
+    void* out_chunks_data)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(compressed_stored_block, "%p"),
+        LONGTAIL_LOGFIELD(first_chunk_index, "%u"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(out_chunks_data, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, compression_registry, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, compressed_stored_block, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (uint64_t)first_chunk_index + chunk_count <= *compressed_stored_block->m_BlockIndex->m_ChunkCount, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (out_chunks_data != 0), return EINVAL)
+
+    const struct Longtail_BlockIndex* block_index = compressed_stored_block->m_BlockIndex;
+    uint32_t compressionType = *block_index->m_Tag;
+    if (compressionType == 0)
+    {
+        uint32_t chunk_offset = 0;
+        for (uint32_t c = 0; c < first_chunk_index; ++c)
+        {
+            chunk_offset += block_index->m_ChunkSizes[c];
+        }
+        uint32_t chunks_size = 0;
+        for (uint32_t c = first_chunk_index; c < first_chunk_index + chunk_count; ++c)
+        {
+            chunks_size += block_index->m_ChunkSizes[c];
+        }
+        if ((uint64_t)chunk_offset + chunks_size > compressed_stored_block->m_BlockChunksDataSize)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Chunks end at %" PRIu64 ", block data size is %u", (uint64_t)chunk_offset + chunks_size, compressed_stored_block->m_BlockChunksDataSize)
+            return EBADF;
+        }
+        memcpy(out_chunks_data, &((const char*)compressed_stored_block->m_BlockData)[chunk_offset], chunks_size);
+        return 0;
+    }
+
+    struct Longtail_CompressionAPI* compression_api;
+    uint32_t compression_settings;
+    int err = compression_registry->GetCompressionAPI(
+        compression_registry,
+        compressionType,
+        &compression_api,
+        &compression_settings);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "compression_registry->GetCompressionAPI() failed with %d", err)
+        return err;
+    }
+    err = DecompressFrames(
+        compression_api,
+        block_index,
+        (const uint32_t*)compressed_stored_block->m_BlockData,
+        compressed_stored_block->m_BlockChunksDataSize,
+        first_chunk_index,
+        chunk_count,
+        (char*)out_chunks_data);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "DecompressFrames() failed with %d", err)
+        return err;
+    }
+    return 0;
+}
@@ -13,6 +13,24 @@ LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateCompressBlo
     struct Longtail_BlockStoreAPI* backing_block_store,
     struct Longtail_CompressionRegistryAPI* compression_registry);
 
+// Compresses the chunks of a block as independent frames of consecutive chunks, each holding at least
+// target_frame_size uncompressed bytes unless it is the last frame, so Longtail_DecompressBlockChunks() only
+// decompresses the frames holding the requested chunks. Blocks that fit in one frame use the regular format.
+LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateSeekableCompressBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t target_frame_size);
+
+// Writes the uncompressed data of chunks [first_chunk_index, first_chunk_index + chunk_count) of a block as
+// stored in the backing block store of a compress block store to out_chunks_data.
+// Only the frames holding the chunks are decompressed if the block was stored in the seekable format.
+LONGTAIL_EXPORT extern int Longtail_DecompressBlockChunks(
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    const struct Longtail_StoredBlock* compressed_stored_block,
+    uint32_t first_chunk_index,
+    uint32_t chunk_count,
+    void* out_chunks_data);
+
 #ifdef __cplusplus
 }
 #endif
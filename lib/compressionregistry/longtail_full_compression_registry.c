@@ -6,7 +6,11 @@
 #include "../lz4/longtail_lz4.h"
 #include "../zstd/longtail_zstd.h"
 
-struct Longtail_CompressionRegistryAPI* Longtail_CreateFullCompressionRegistry()
+#define FULL_COMPRESSION_REGISTRY_TYPE_COUNT 10u
+
+static struct Longtail_CompressionRegistryAPI* CreateFullCompressionRegistry(
+    struct Longtail_StorageAPI* optional_storage_api,
+    const char* optional_dictionary_folder)
 {
     struct Longtail_CompressionAPI* lz4_compression = Longtail_CreateLZ4CompressionAPI();
     if (lz4_compression == 0)
@@ -29,47 +33,63 @@ struct Longtail_CompressionRegistryAPI* Longtail_CreateFullCompressionRegistry()
         return 0;
     }
 
-    uint32_t compression_types[13] = {
-        Longtail_GetBrotliGenericMinQuality(),
-        Longtail_GetBrotliGenericDefaultQuality(),
-        Longtail_GetBrotliGenericMaxQuality(),
-        Longtail_GetBrotliTextMinQuality(),
-        Longtail_GetBrotliTextDefaultQuality(),
-        Longtail_GetBrotliTextMaxQuality(),
+    uint32_t dictionary_count = 0;
+    uint32_t* dictionary_ids = 0;
+    if (optional_dictionary_folder)
+    {
+        int err = Longtail_ZStdLoadDictionaries(zstd_compression, optional_storage_api, optional_dictionary_folder, &dictionary_count, &dictionary_ids);
+        if (err)
+        {
+            SAFE_DISPOSE_API(lz4_compression);
+            SAFE_DISPOSE_API(brotli_compression);
+            SAFE_DISPOSE_API(zstd_compression);
+            return 0;
+        }
+    }
 
-        Longtail_GetLZ4DefaultQuality(),
+    uint32_t compression_type_count = FULL_COMPRESSION_REGISTRY_TYPE_COUNT + dictionary_count;
+    size_t work_mem_size = (sizeof(struct Longtail_CompressionAPI*) * compression_type_count) +
+        (sizeof(uint32_t) * compression_type_count);
+    void* work_mem = Longtail_Alloc("FullCompressionRegistry", work_mem_size);
+    if (work_mem == 0)
+    {
+        Longtail_Free(dictionary_ids);
+        SAFE_DISPOSE_API(lz4_compression);
+        SAFE_DISPOSE_API(brotli_compression);
+        SAFE_DISPOSE_API(zstd_compression);
+        return 0;
+    }
+    struct Longtail_CompressionAPI** compression_apis = (struct Longtail_CompressionAPI**)work_mem;
+    uint32_t* compression_types = (uint32_t*)&compression_apis[compression_type_count];
 
-        Longtail_GetZStdMinQuality(),
-        Longtail_GetZStdDefaultQuality(),
-        Longtail_GetZStdMaxQuality()};
-    struct Longtail_CompressionAPI* compression_apis[10] = {
-        brotli_compression,
-        brotli_compression,
-        brotli_compression,
-        brotli_compression,
-        brotli_compression,
-        brotli_compression,
-        lz4_compression,
-        zstd_compression,
-        zstd_compression,
-        zstd_compression};
-    uint32_t compression_settings[10] = {
-        Longtail_GetBrotliGenericMinQuality(),
-        Longtail_GetBrotliGenericDefaultQuality(),
-        Longtail_GetBrotliGenericMaxQuality(),
-        Longtail_GetBrotliTextMinQuality(),
-        Longtail_GetBrotliTextDefaultQuality(),
-        Longtail_GetBrotliTextMaxQuality(),
-        Longtail_GetLZ4DefaultQuality(),
-        Longtail_GetZStdMinQuality(),
-        Longtail_GetZStdDefaultQuality(),
-        Longtail_GetZStdMaxQuality()};
+    compression_types[0] = Longtail_GetBrotliGenericMinQuality();
+    compression_types[1] = Longtail_GetBrotliGenericDefaultQuality();
+    compression_types[2] = Longtail_GetBrotliGenericMaxQuality();
+    compression_types[3] = Longtail_GetBrotliTextMinQuality();
+    compression_types[4] = Longtail_GetBrotliTextDefaultQuality();
+    compression_types[5] = Longtail_GetBrotliTextMaxQuality();
+    compression_types[6] = Longtail_GetLZ4DefaultQuality();
+    compression_types[7] = Longtail_GetZStdMinQuality();
+    compression_types[8] = Longtail_GetZStdDefaultQuality();
+    compression_types[9] = Longtail_GetZStdMaxQuality();
+    for (uint32_t d = 0; d < dictionary_count; ++d)
+    {
+        compression_types[FULL_COMPRESSION_REGISTRY_TYPE_COUNT + d] = Longtail_GetZStdDictionaryQuality(dictionary_ids[d]);
+    }
+    Longtail_Free(dictionary_ids);
 
+    for (uint32_t t = 0; t < compression_type_count; ++t)
+    {
+        compression_apis[t] = (t < 6) ? brotli_compression : (t < 7) ? lz4_compression : zstd_compression;
+    }
+
+    // The settings id for each compression type is the type itself
     struct Longtail_CompressionRegistryAPI* registry = Longtail_CreateDefaultCompressionRegistry(
-        10,
+        compression_type_count,
         (const uint32_t*)compression_types,
         (const struct Longtail_CompressionAPI **)compression_apis,
-        compression_settings);
+        compression_types);
+    Longtail_Free(work_mem);
     if (registry == 0)
     {
         SAFE_DISPOSE_API(lz4_compression);
@@ -79,3 +99,19 @@ struct Longtail_CompressionRegistryAPI* Longtail_CreateFullCompressionRegistry()
     }
     return registry;
 }
+
+struct Longtail_CompressionRegistryAPI* Longtail_CreateFullCompressionRegistry()
+{
+    return CreateFullCompressionRegistry(0, 0);
+}
+
+struct Longtail_CompressionRegistryAPI* Longtail_CreateFullDictionaryCompressionRegistry(
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder)
+{
+    if (storage_api == 0 || dictionary_folder == 0)
+    {
+        return 0;
+    }
+    return CreateFullCompressionRegistry(storage_api, dictionary_folder);
+}
@@ -8,6 +8,12 @@ extern "C" {
 
 LONGTAIL_EXPORT struct Longtail_CompressionRegistryAPI* Longtail_CreateFullCompressionRegistry();
 
+// Same as Longtail_CreateFullCompressionRegistry but also registers every zstd dictionary found in dictionary_folder
+// as its own compression type, see Longtail_GetZStdDictionaryQuality
+LONGTAIL_EXPORT struct Longtail_CompressionRegistryAPI* Longtail_CreateFullDictionaryCompressionRegistry(
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder);
+
 #ifdef __cplusplus
 }
 #endif
@@ -37,3 +37,63 @@ struct Longtail_CompressionRegistryAPI* Longtail_CreateZStdCompressionRegistry()
     }
     return registry;
 }
+
+struct Longtail_CompressionRegistryAPI* Longtail_CreateZStdDictionaryCompressionRegistry(
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder)
+{
+    struct Longtail_CompressionAPI* zstd_compression = Longtail_CreateZStdCompressionAPI();
+    if (zstd_compression == 0)
+    {
+        return 0;
+    }
+
+    uint32_t dictionary_count = 0;
+    uint32_t* dictionary_ids = 0;
+    int err = Longtail_ZStdLoadDictionaries(zstd_compression, storage_api, dictionary_folder, &dictionary_count, &dictionary_ids);
+    if (err)
+    {
+        SAFE_DISPOSE_API(zstd_compression);
+        return 0;
+    }
+
+    uint32_t compression_type_count = 3 + dictionary_count;
+    size_t work_mem_size = (sizeof(uint32_t) * compression_type_count) +
+        (sizeof(struct Longtail_CompressionAPI*) * compression_type_count);
+    void* work_mem = Longtail_Alloc("ZStdDictionaryCompressionRegistry", work_mem_size);
+    if (work_mem == 0)
+    {
+        Longtail_Free(dictionary_ids);
+        SAFE_DISPOSE_API(zstd_compression);
+        return 0;
+    }
+    struct Longtail_CompressionAPI** compression_apis = (struct Longtail_CompressionAPI**)work_mem;
+    uint32_t* compression_types = (uint32_t*)&compression_apis[compression_type_count];
+
+    compression_types[0] = Longtail_GetZStdMinQuality();
+    compression_types[1] = Longtail_GetZStdDefaultQuality();
+    compression_types[2] = Longtail_GetZStdMaxQuality();
+    for (uint32_t d = 0; d < dictionary_count; ++d)
+    {
+        compression_types[3 + d] = Longtail_GetZStdDictionaryQuality(dictionary_ids[d]);
+    }
+    for (uint32_t t = 0; t < compression_type_count; ++t)
+    {
+        compression_apis[t] = zstd_compression;
+    }
+    Longtail_Free(dictionary_ids);
+
+    // The settings id for a zstd compression type is the type itself
+    struct Longtail_CompressionRegistryAPI* registry = Longtail_CreateDefaultCompressionRegistry(
+        compression_type_count,
+        (const uint32_t*)compression_types,
+        (const struct Longtail_CompressionAPI **)compression_apis,
+        compression_types);
+    Longtail_Free(work_mem);
+    if (registry == 0)
+    {
+        SAFE_DISPOSE_API(zstd_compression);
+        return 0;
+    }
+    return registry;
+}
@@ -8,6 +8,12 @@ extern "C" {
 
 LONGTAIL_EXPORT struct Longtail_CompressionRegistryAPI* Longtail_CreateZStdCompressionRegistry();
 
+// Same as Longtail_CreateZStdCompressionRegistry but also registers every dictionary found in dictionary_folder
+// as its own compression type, see Longtail_GetZStdDictionaryQuality
+LONGTAIL_EXPORT struct Longtail_CompressionRegistryAPI* Longtail_CreateZStdDictionaryCompressionRegistry(
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder);
+
 #ifdef __cplusplus
 }
 #endif
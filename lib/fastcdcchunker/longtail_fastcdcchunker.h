@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../../src/longtail.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Gear hash chunker with normalized chunking, boundaries are harder to hit before the average chunk size
+// and easier after it which gives a tighter chunk size distribution than the HPCDC chunker
+LONGTAIL_EXPORT extern struct Longtail_ChunkerAPI* Longtail_CreateFastCDCChunkerAPI();
+
+#ifdef __cplusplus
+}
+#endif
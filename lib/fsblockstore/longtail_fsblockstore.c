@@ -14,8 +14,43 @@ struct BlockHashToBlockState
     uint32_t value;
 };
 
+struct BlockHashToPendingGets
+{
+    uint64_t key;
+    struct Longtail_AsyncGetStoredBlockAPI** value;
+};
+
 #define TMP_EXTENSION_LENGTH (1 + 16)
 
+#define PACK_SEGMENT_NAME_LENGTH    (16 + 1 + 8)
+
+struct PackedBlockLocation
+{
+    uint64_t m_Offset;
+    uint32_t m_Size;
+    uint32_t m_SegmentIndex;
+};
+
+struct BlockHashToPackedBlockLocation
+{
+    uint64_t key;
+    struct PackedBlockLocation value;
+};
+
+struct PackSegment
+{
+    char m_Name[PACK_SEGMENT_NAME_LENGTH + 1];
+    char* m_Path;
+    TLongtail_Hash* m_BlockHashes;
+    uint32_t m_IsSealed;
+};
+
+struct PackSegmentNameToIndex
+{
+    char* key;
+    uint32_t value;
+};
+
 struct FSBlockStoreAPI
 {
     struct Longtail_BlockStoreAPI m_BlockStoreAPI;
@@ -29,11 +64,26 @@ struct FSBlockStoreAPI
 
     struct Longtail_StoreIndex* m_StoreIndex;
     struct BlockHashToBlockState* m_BlockState;
+    struct BlockHashToPendingGets* m_PendingGets;
     struct Longtail_BlockIndex** m_AddedBlockIndexes;
     const char* m_BlockExtension;
     const char* m_StoreIndexLockPath;
     uint32_t m_StoreIndexIsDirty;
+    uint32_t m_MergedBlockIndexCount;
+    uint32_t m_NextJournalSequence;
     char m_TmpExtension[TMP_EXTENSION_LENGTH + 1];
+
+    uint64_t m_MaxSegmentSize;
+    HLongtail_Sema m_SegmentWriteSema;
+    struct PackSegment* m_Segments;
+    struct PackSegmentNameToIndex* m_SegmentLookup;
+    struct BlockHashToPackedBlockLocation* m_PackedBlocks;
+    Longtail_StorageAPI_HOpenFile m_ActiveSegmentFile;
+    uint32_t m_ActiveSegmentIndex;
+    uint32_t m_ActiveSegmentPersistedBlockCount;
+    uint32_t m_NextSegmentSequence;
+    uint64_t m_ActiveSegmentSize;
+    uint64_t m_LastSegmentScanTime;
 };
 
 #define BLOCK_NAME_LENGTH   23
@@ -142,10 +192,312 @@ static char* GetTempBlockPath(
     return storage_api->ConcatPath(storage_api, store_path, file_name);
 }
 
-static int SafeWriteStoreIndex(struct FSBlockStoreAPI* api)
+int EndsWith(const char *str, const char *suffix)
+{
+    if (!str || !suffix)
+        return 0;
+    size_t lenstr = strlen(str);
+    size_t lensuffix = strlen(suffix);
+    if (lensuffix >  lenstr)
+        return 0;
+    return strncmp(str + lenstr - lensuffix, suffix, lensuffix) == 0;
+}
+
+// Store index journal
+//
+// A flush does not rewrite `store.lsi`, it writes the blocks added since the last flush as a small store index
+// in `journal/`. Readers merge the snapshot in `store.lsi` with all journal entries. Once the journal grows past
+// STORE_INDEX_JOURNAL_COMPACT_COUNT entries it is compacted back into the snapshot. All access to the snapshot and
+// the journal is done with the store index lock file held.
+
+#define STORE_INDEX_JOURNAL_COMPACT_COUNT   32
+#define JOURNAL_ENTRY_NAME_LENGTH           (16 + 1 + 8)
+
+static char* GetJournalEntryPath(
+    struct Longtail_StorageAPI* storage_api,
+    const char* store_path,
+    const char* entry_name)
+{
+    char file_name[8 + JOURNAL_ENTRY_NAME_LENGTH + 4 + 1];
+    strcpy(file_name, "journal/");
+    strcpy(&file_name[8], entry_name);
+    return storage_api->ConcatPath(storage_api, store_path, file_name);
+}
+
+static void FreeJournalEntries(char** entry_names)
+{
+    size_t entry_count = arrlen(entry_names);
+    for (size_t e = 0; e < entry_count; ++e)
+    {
+        Longtail_Free(entry_names[e]);
+    }
+    arrfree(entry_names);
+}
+
+static int GetJournalEntries(
+    struct FSBlockStoreAPI* api,
+    char*** out_entry_names)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(api, "%p")
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(out_entry_names, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    char* journal_path = storage_api->ConcatPath(storage_api, api->m_StorePath, "journal");
+    if (!journal_path)
+    {
+        return ENOMEM;
+    }
+    char** entry_names = 0;
+    Longtail_StorageAPI_HIterator it;
+    int err = storage_api->StartFind(storage_api, journal_path, &it);
+    Longtail_Free(journal_path);
+    if (err == ENOENT)
+    {
+        *out_entry_names = 0;
+        return 0;
+    }
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->StartFind() failed with %d", err)
+        return err;
+    }
+    while (err == 0)
+    {
+        struct Longtail_StorageAPI_EntryProperties properties;
+        err = storage_api->GetEntryProperties(storage_api, it, &properties);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetEntryProperties() failed with %d", err)
+            break;
+        }
+        if (!properties.m_IsDir && EndsWith(properties.m_Name, ".lsj"))
+        {
+            char* entry_name = Longtail_Strdup(properties.m_Name);
+            if (!entry_name)
+            {
+                err = ENOMEM;
+                break;
+            }
+            arrput(entry_names, entry_name);
+        }
+        err = storage_api->FindNext(storage_api, it);
+    }
+    storage_api->CloseFind(storage_api, it);
+    if (err != ENOENT)
+    {
+        FreeJournalEntries(entry_names);
+        return err;
+    }
+    *out_entry_names = entry_names;
+    return 0;
+}
+
+// Reads the snapshot and merges the journal entries into it, out_store_index is set to zero if neither exists
+static int ReadJournaledStoreIndex(
+    struct FSBlockStoreAPI* api,
+    char** entry_names,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(entry_names, "%p"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    struct Longtail_StoreIndex* store_index = 0;
+
+    const char* store_index_path = storage_api->ConcatPath(storage_api, api->m_StorePath, "store.lsi");
+    if (storage_api->IsFile(storage_api, store_index_path))
+    {
+        int err = Longtail_ReadStoreIndex(storage_api, store_index_path, &store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_ReadStoreIndex() failed with %d", err)
+            Longtail_Free((void*)store_index_path);
+            return err;
+        }
+    }
+    Longtail_Free((void*)store_index_path);
+
+    size_t entry_count = arrlen(entry_names);
+    if (entry_count == 0)
+    {
+        *out_store_index = store_index;
+        return 0;
+    }
+
+    struct Longtail_StoreIndex** entry_store_indexes = (struct Longtail_StoreIndex**)Longtail_Alloc("FSBlockStoreAPI", sizeof(struct Longtail_StoreIndex*) * entry_count);
+    if (!entry_store_indexes)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(store_index);
+        return ENOMEM;
+    }
+    int err = 0;
+    size_t read_count = 0;
+    while (read_count < entry_count)
+    {
+        char* entry_path = GetJournalEntryPath(storage_api, api->m_StorePath, entry_names[read_count]);
+        err = Longtail_ReadStoreIndex(storage_api, entry_path, &entry_store_indexes[read_count]);
+        Longtail_Free(entry_path);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_ReadStoreIndex() failed with %d", err)
+            break;
+        }
+        ++read_count;
+    }
+
+    // Merge the entries with each other pairwise first so the blocks of each entry are only copied a
+    // few times, then merge the result into the snapshot once
+    size_t merge_count = read_count;
+    while (err == 0 && merge_count > 1)
+    {
+        size_t merged_count = 0;
+        for (size_t e = 0; e < merge_count; e += 2)
+        {
+            if (e + 1 == merge_count)
+            {
+                entry_store_indexes[merged_count++] = entry_store_indexes[e];
+                continue;
+            }
+            struct Longtail_StoreIndex* merged_store_index = 0;
+            if (err == 0)
+            {
+                err = Longtail_MergeStoreIndex(entry_store_indexes[e + 1], entry_store_indexes[e], &merged_store_index);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_MergeStoreIndex() failed with %d", err)
+                }
+            }
+            Longtail_Free(entry_store_indexes[e]);
+            Longtail_Free(entry_store_indexes[e + 1]);
+            if (merged_store_index)
+            {
+                entry_store_indexes[merged_count++] = merged_store_index;
+            }
+        }
+        merge_count = merged_count;
+    }
+    if (err)
+    {
+        for (size_t e = 0; e < merge_count; ++e)
+        {
+            Longtail_Free(entry_store_indexes[e]);
+        }
+        Longtail_Free(entry_store_indexes);
+        Longtail_Free(store_index);
+        return err;
+    }
+
+    struct Longtail_StoreIndex* journal_store_index = entry_store_indexes[0];
+    Longtail_Free(entry_store_indexes);
+    if (!store_index)
+    {
+        *out_store_index = journal_store_index;
+        return 0;
+    }
+    struct Longtail_StoreIndex* merged_store_index;
+    err = Longtail_MergeStoreIndex(journal_store_index, store_index, &merged_store_index);
+    Longtail_Free(journal_store_index);
+    Longtail_Free(store_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_MergeStoreIndex() failed with %d", err)
+        return err;
+    }
+    *out_store_index = merged_store_index;
+    return 0;
+}
+
+static void RemoveJournalEntries(
+    struct FSBlockStoreAPI* api,
+    char** entry_names)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(entry_names, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    size_t entry_count = arrlen(entry_names);
+    for (size_t e = 0; e < entry_count; ++e)
+    {
+        char* entry_path = GetJournalEntryPath(storage_api, api->m_StorePath, entry_names[e]);
+        int err = storage_api->RemoveFile(storage_api, entry_path);
+        if (err)
+        {
+            // Harmless, the entry is already part of the snapshot and merging it again does not change anything
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->RemoveFile() failed to remove `%s`, error %d", entry_path, err)
+        }
+        Longtail_Free(entry_path);
+    }
+}
+
+static int AppendStoreIndexJournal(
+    struct FSBlockStoreAPI* api,
+    struct Longtail_StoreIndex* added_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(added_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    char entry_name[JOURNAL_ENTRY_NAME_LENGTH + 4 + 1];
+    char* entry_path = 0;
+    while (!entry_path)
+    {
+        snprintf(entry_name, sizeof(entry_name), "%.16s-%08x.lsj", &api->m_TmpExtension[1], api->m_NextJournalSequence++);
+        entry_path = GetJournalEntryPath(storage_api, api->m_StorePath, entry_name);
+        if (!entry_path)
+        {
+            return ENOMEM;
+        }
+        if (storage_api->IsFile(storage_api, entry_path))
+        {
+            Longtail_Free(entry_path);
+            entry_path = 0;
+        }
+    }
+
+    // Readers only look at `.lsj` files, write under a temporary name so they never see a partial entry
+    memcpy(&entry_name[JOURNAL_ENTRY_NAME_LENGTH], ".tmp", 4);
+    char* tmp_entry_path = GetJournalEntryPath(storage_api, api->m_StorePath, entry_name);
+    if (!tmp_entry_path)
+    {
+        Longtail_Free(entry_path);
+        return ENOMEM;
+    }
+    int err = Longtail_WriteStoreIndex(storage_api, added_store_index, tmp_entry_path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_WriteStoreIndex() failed with %d", err)
+        Longtail_Free(tmp_entry_path);
+        Longtail_Free(entry_path);
+        return err;
+    }
+    err = storage_api->RenameFile(storage_api, tmp_entry_path, entry_path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->RenameFile() failed with %d", err)
+        storage_api->RemoveFile(storage_api, tmp_entry_path);
+    }
+    Longtail_Free(tmp_entry_path);
+    Longtail_Free(entry_path);
+    return err;
+}
+
+// Writes a new snapshot and removes the journal entries it covers, must be called with the store index lock file held.
+// With merge_existing set the snapshot and journal on disk are merged with m_StoreIndex, otherwise m_StoreIndex replaces them.
+static int SafeWriteStoreIndex(struct FSBlockStoreAPI* api, int merge_existing)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(merge_existing, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
@@ -163,82 +515,110 @@ static int SafeWriteStoreIndex(struct FSBlockStoreAPI* api)
         return err;
     }
 
-    const char* store_index_path = storage_api->ConcatPath(storage_api, store_path, "store.lsi");
+    char** entry_names = 0;
+    err = GetJournalEntries(api, &entry_names);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "GetJournalEntries() failed with %d", err)
+        Longtail_Free((void*)store_index_path_tmp);
+        return err;
+    }
 
     struct Longtail_StoreIndex* store_index = api->m_StoreIndex;
-    if (storage_api->IsFile(storage_api, store_index_path))
+    if (merge_existing)
     {
         struct Longtail_StoreIndex* existing_store_index = 0;
-        err = Longtail_ReadStoreIndex(storage_api, store_index_path, &existing_store_index);
+        err = ReadJournaledStoreIndex(api, entry_names, &existing_store_index);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_ReadStoreIndex() failed with %d", err)
-            Longtail_Free((void*)store_index_path);
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ReadJournaledStoreIndex() failed with %d", err)
+            FreeJournalEntries(entry_names);
             Longtail_Free((void*)store_index_path_tmp);
             return err;
         }
-        struct Longtail_StoreIndex* merged_store_index = 0;
-        err = Longtail_MergeStoreIndex(
-            store_index, // Our opinion of the store index has precedence
-            existing_store_index,
-            &merged_store_index);
-        if (err)
+        if (existing_store_index && store_index)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_MergeStoreIndex() failed with %d", err)
+            struct Longtail_StoreIndex* merged_store_index = 0;
+            err = Longtail_MergeStoreIndex(
+                store_index, // Our opinion of the store index has precedence
+                existing_store_index,
+                &merged_store_index);
             Longtail_Free(existing_store_index);
-            Longtail_Free((void*)store_index_path);
-            Longtail_Free((void*)store_index_path_tmp);
-            return err;
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_MergeStoreIndex() failed with %d", err)
+                FreeJournalEntries(entry_names);
+                Longtail_Free((void*)store_index_path_tmp);
+                return err;
+            }
+            store_index = merged_store_index;
+        }
+        else if (existing_store_index)
+        {
+            store_index = existing_store_index;
         }
-        Longtail_Free(existing_store_index);
-        store_index = merged_store_index;
+    }
+    if (!store_index)
+    {
+        FreeJournalEntries(entry_names);
+        Longtail_Free((void*)store_index_path_tmp);
+        return 0;
     }
 
+    const char* store_index_path = storage_api->ConcatPath(storage_api, store_path, "store.lsi");
     err = Longtail_WriteStoreIndex(storage_api, store_index, store_index_path_tmp);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_WriteStoreIndex() failed with %d", err)
-        Longtail_Free((void*)store_index_path);
-        Longtail_Free((void*)store_index_path_tmp);
-        return err;
     }
 
-    if (storage_api->IsFile(storage_api, store_index_path))
+    if (!err && storage_api->IsFile(storage_api, store_index_path))
     {
         err = storage_api->RemoveFile(storage_api, store_index_path);
         if (err)
         {
             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->RemoveFile() failed with %d", err)
-            Longtail_Free((void*)store_index_path);
             storage_api->RemoveFile(storage_api, store_index_path_tmp);
-            Longtail_Free((void*)store_index_path_tmp);
-            return err;
         }
     }
 
-    err = storage_api->RenameFile(storage_api, store_index_path_tmp, store_index_path);
-    if (err)
+    if (!err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->RenameFile() failed with %d", err)
-        storage_api->RemoveFile(storage_api, store_index_path_tmp);
+        err = storage_api->RenameFile(storage_api, store_index_path_tmp, store_index_path);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->RenameFile() failed with %d", err)
+            storage_api->RemoveFile(storage_api, store_index_path_tmp);
+        }
     }
 
     if (!err)
     {
-        if (api->m_StoreIndex != store_index)
+        RemoveJournalEntries(api, entry_names);
+        api->m_StoreIndexIsDirty = 0;
+    }
+
+    if (store_index != api->m_StoreIndex)
+    {
+        if (!err && api->m_StoreIndex)
         {
             Longtail_Free(api->m_StoreIndex);
             api->m_StoreIndex = store_index;
         }
-        api->m_StoreIndexIsDirty = 0;
+        else
+        {
+            // Compacting without a loaded store index, don't adopt it as that would bypass the block state setup
+            Longtail_Free(store_index);
+        }
     }
 
+    FreeJournalEntries(entry_names);
     Longtail_Free((void*)store_index_path);
     Longtail_Free((void*)store_index_path_tmp);
 
     return err;
-
 }
+
 static int SafeWriteStoredBlock(
     struct FSBlockStoreAPI* api,
     struct Longtail_StorageAPI* storage_api,
@@ -320,18 +700,20 @@ static int SafeWriteStoredBlock(
 
 static int UpdateStoreIndex(
     struct Longtail_StoreIndex* current_store_index,
+    uint32_t added_block_count,
     struct Longtail_BlockIndex** added_block_indexes,
     struct Longtail_StoreIndex** out_store_index)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(current_store_index, "%p"),
+        LONGTAIL_LOGFIELD(added_block_count, "%u"),
         LONGTAIL_LOGFIELD(added_block_indexes, "%p"),
         LONGTAIL_LOGFIELD(out_store_index, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     struct Longtail_StoreIndex* added_store_index;
     int err = Longtail_CreateStoreIndexFromBlocks(
-        (uint32_t)(arrlen(added_block_indexes)),
+        added_block_count,
         (const struct Longtail_BlockIndex** )added_block_indexes,
         &added_store_index);
     if (err)
@@ -381,18 +763,7 @@ struct ScanBlockJob
     int m_Err;
 };
 
-int EndsWith(const char *str, const char *suffix)
-{
-    if (!str || !suffix)
-        return 0;
-    size_t lenstr = strlen(str);
-    size_t lensuffix = strlen(suffix);
-    if (lensuffix >  lenstr)
-        return 0;
-    return strncmp(str + lenstr - lensuffix, suffix, lensuffix) == 0;
-}
-
-static int ScanBlock(void* context, uint32_t job_id, int is_cancelled)
+static int ScanBlock(void* context, uint32_t job_id, int is_cancelled)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(context, "%p"),
@@ -426,20 +797,1131 @@ static int ScanBlock(void* context, uint32_t job_id, int is_cancelled)
 
     if (job->m_Err == 0)
     {
-        TLongtail_Hash block_hash = *job->m_BlockIndex->m_BlockHash;
-        char* validate_file_name = GetBlockPath(storage_api, job->m_StorePath, job->m_BlockExtension, block_hash);
-        if (strcmp(validate_file_name, full_block_path) != 0)
+        TLongtail_Hash block_hash = *job->m_BlockIndex->m_BlockHash;
+        char* validate_file_name = GetBlockPath(storage_api, job->m_StorePath, job->m_BlockExtension, block_hash);
+        if (strcmp(validate_file_name, full_block_path) != 0)
+        {
+            Longtail_Free(job->m_BlockIndex);
+            job->m_BlockIndex = 0;
+            job->m_Err = EBADF;
+        }
+        Longtail_Free(validate_file_name);
+    }
+
+    Longtail_Free(full_block_path);
+    full_block_path = 0;
+    return 0;
+}
+
+// Packed layout
+//
+// When created with a max segment size the store appends blocks to segment files in `packs/` instead of
+// writing one file per block. A segment is only ever written by the store instance that created it and
+// is never opened for write again once sealed. Sealing writes a compact offset index next to the segment,
+// segments without an offset index were never sealed (the writer died) and are ignored, just as
+// left-over temp block files are.
+//
+// Offset index (`.lpi`) layout:
+//   uint32_t       magic
+//   uint32_t       block_count
+//   TLongtail_Hash block_hashes[block_count]
+//   uint64_t       block_offsets[block_count]
+//   uint32_t       block_sizes[block_count]
+
+#define PACK_INDEX_MAGIC            0x4b50544cu
+#define PACK_SEGMENT_NONE           0xffffffffu
+
+#define PACK_SEGMENT_RESCAN_INTERVAL_US 1000000u
+
+static size_t GetPackIndexSize(uint32_t block_count)
+{
+    return sizeof(uint32_t) + sizeof(uint32_t) +
+        (sizeof(TLongtail_Hash) + sizeof(uint64_t) + sizeof(uint32_t)) * block_count;
+}
+
+static char* GetPackSegmentPath(
+    struct Longtail_StorageAPI* storage_api,
+    const char* store_path,
+    const char* segment_name,
+    const char* extension)
+{
+    char file_name[6 + PACK_SEGMENT_NAME_LENGTH + 4 + 1];
+    strcpy(file_name, "packs/");
+    strcpy(&file_name[6], segment_name);
+    strcpy(&file_name[6 + PACK_SEGMENT_NAME_LENGTH], extension);
+    return storage_api->ConcatPath(storage_api, store_path, file_name);
+}
+
+// Must be called with m_Lock held
+static int AddPackSegment(
+    struct FSBlockStoreAPI* api,
+    const char* segment_name,
+    uint32_t is_sealed,
+    uint32_t* out_segment_index)
+{
+    char* path = GetPackSegmentPath(api->m_StorageAPI, api->m_StorePath, segment_name, ".lps");
+    if (!path)
+    {
+        return ENOMEM;
+    }
+    struct PackSegment segment;
+    memcpy(segment.m_Name, segment_name, sizeof(segment.m_Name));
+    segment.m_Path = path;
+    segment.m_BlockHashes = 0;
+    segment.m_IsSealed = is_sealed;
+    uint32_t segment_index = (uint32_t)arrlen(api->m_Segments);
+    arrput(api->m_Segments, segment);
+    shput(api->m_SegmentLookup, segment_name, segment_index);
+    *out_segment_index = segment_index;
+    return 0;
+}
+
+// Reads and validates the offset index of a segment, ".lpi" for a sealed segment and ".tmp" for the flushed
+// part of a segment that is still being written. Does not touch the store state
+static int ReadPackSegmentIndex(
+    struct Longtail_StorageAPI* storage_api,
+    const char* store_path,
+    const char* segment_name,
+    uint32_t is_sealed,
+    uint8_t** out_index_data,
+    uint32_t* out_block_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(store_path, "%s"),
+        LONGTAIL_LOGFIELD(segment_name, "%s"),
+        LONGTAIL_LOGFIELD(is_sealed, "%u"),
+        LONGTAIL_LOGFIELD(out_index_data, "%p"),
+        LONGTAIL_LOGFIELD(out_block_count, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    char* index_path = GetPackSegmentPath(storage_api, store_path, segment_name, is_sealed ? ".lpi" : ".tmp");
+    if (!index_path)
+    {
+        return ENOMEM;
+    }
+
+    Longtail_StorageAPI_HOpenFile f;
+    int err = storage_api->OpenReadFile(storage_api, index_path, &f);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->OpenReadFile() failed with %d", err)
+        Longtail_Free(index_path);
+        return err;
+    }
+    uint64_t index_size;
+    err = storage_api->GetSize(storage_api, f, &index_size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->GetSize() failed with %d", err)
+        storage_api->CloseFile(storage_api, f);
+        Longtail_Free(index_path);
+        return err;
+    }
+    if (index_size < GetPackIndexSize(0))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Pack index `%s` is truncated, failed with %d", index_path, EBADF)
+        storage_api->CloseFile(storage_api, f);
+        Longtail_Free(index_path);
+        return EBADF;
+    }
+    uint8_t* index_data = (uint8_t*)Longtail_Alloc("FSBlockStoreAPI", (size_t)index_size);
+    if (!index_data)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        storage_api->CloseFile(storage_api, f);
+        Longtail_Free(index_path);
+        return ENOMEM;
+    }
+    err = storage_api->Read(storage_api, f, 0, index_size, index_data);
+    storage_api->CloseFile(storage_api, f);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->Read() failed with %d", err)
+        Longtail_Free(index_data);
+        Longtail_Free(index_path);
+        return err;
+    }
+
+    uint32_t magic;
+    uint32_t block_count;
+    memcpy(&magic, &index_data[0], sizeof(uint32_t));
+    memcpy(&block_count, &index_data[sizeof(uint32_t)], sizeof(uint32_t));
+    if (magic != PACK_INDEX_MAGIC || index_size != GetPackIndexSize(block_count))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Pack index `%s` is malformed, failed with %d", index_path, EBADF)
+        Longtail_Free(index_data);
+        Longtail_Free(index_path);
+        return EBADF;
+    }
+    Longtail_Free(index_path);
+    *out_index_data = index_data;
+    *out_block_count = block_count;
+    return 0;
+}
+
+// Adds the blocks of a segment, must be called with m_Lock held. A segment that is still being written
+// only ever has blocks appended to its offset index so only blocks after the ones we already know are added
+static int AddPackSegmentIndex(
+    struct FSBlockStoreAPI* api,
+    const char* segment_name,
+    uint32_t is_sealed,
+    const uint8_t* index_data,
+    uint32_t block_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(segment_name, "%s"),
+        LONGTAIL_LOGFIELD(is_sealed, "%u"),
+        LONGTAIL_LOGFIELD(index_data, "%p"),
+        LONGTAIL_LOGFIELD(block_count, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    uint32_t segment_index;
+    intptr_t segment_ptr = shgeti(api->m_SegmentLookup, segment_name);
+    if (segment_ptr != -1)
+    {
+        segment_index = api->m_SegmentLookup[segment_ptr].value;
+        struct PackSegment* segment = &api->m_Segments[segment_index];
+        if (segment->m_IsSealed || !segment->m_Path || segment_index == api->m_ActiveSegmentIndex)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        int err = AddPackSegment(api, segment_name, is_sealed, &segment_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AddPackSegment() failed with %d", err)
+            return err;
+        }
+    }
+    api->m_Segments[segment_index].m_IsSealed = is_sealed;
+
+    const uint8_t* block_hashes = &index_data[GetPackIndexSize(0)];
+    const uint8_t* block_offsets = &block_hashes[sizeof(TLongtail_Hash) * block_count];
+    const uint8_t* block_sizes = &block_offsets[sizeof(uint64_t) * block_count];
+    for (uint32_t b = (uint32_t)arrlen(api->m_Segments[segment_index].m_BlockHashes); b < block_count; ++b)
+    {
+        struct PackedBlockLocation location;
+        TLongtail_Hash block_hash;
+        memcpy(&block_hash, &block_hashes[sizeof(TLongtail_Hash) * b], sizeof(TLongtail_Hash));
+        memcpy(&location.m_Offset, &block_offsets[sizeof(uint64_t) * b], sizeof(uint64_t));
+        memcpy(&location.m_Size, &block_sizes[sizeof(uint32_t) * b], sizeof(uint32_t));
+        location.m_SegmentIndex = segment_index;
+        arrput(api->m_Segments[segment_index].m_BlockHashes, block_hash);
+        if (hmgeti(api->m_PackedBlocks, block_hash) == -1)
+        {
+            hmput(api->m_PackedBlocks, block_hash, location);
+        }
+    }
+    return 0;
+}
+
+// Lists the names of all segments with an offset index, does not touch the store state
+static int ListPackSegments(
+    struct Longtail_StorageAPI* storage_api,
+    const char* store_path,
+    struct PackSegment** out_segments)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(store_path, "%s"),
+        LONGTAIL_LOGFIELD(out_segments, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    char* packs_path = storage_api->ConcatPath(storage_api, store_path, "packs");
+    if (!packs_path)
+    {
+        return ENOMEM;
+    }
+    Longtail_StorageAPI_HIterator it;
+    int err = storage_api->StartFind(storage_api, packs_path, &it);
+    Longtail_Free(packs_path);
+    if (err == ENOENT)
+    {
+        *out_segments = 0;
+        return 0;
+    }
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->StartFind() failed with %d", err)
+        return err;
+    }
+    // Collect the names first, the storage may not allow other calls while iterating
+    struct PackSegment* segments = 0;
+    while (err == 0)
+    {
+        struct Longtail_StorageAPI_EntryProperties properties;
+        err = storage_api->GetEntryProperties(storage_api, it, &properties);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetEntryProperties() failed with %d", err)
+            break;
+        }
+        if (!properties.m_IsDir &&
+            strlen(properties.m_Name) == PACK_SEGMENT_NAME_LENGTH + 4 &&
+            (EndsWith(properties.m_Name, ".lpi") || EndsWith(properties.m_Name, ".tmp")))
+        {
+            struct PackSegment segment;
+            memcpy(segment.m_Name, properties.m_Name, PACK_SEGMENT_NAME_LENGTH);
+            segment.m_Name[PACK_SEGMENT_NAME_LENGTH] = 0;
+            segment.m_Path = 0;
+            segment.m_BlockHashes = 0;
+            segment.m_IsSealed = EndsWith(properties.m_Name, ".lpi");
+            arrput(segments, segment);
+        }
+        err = storage_api->FindNext(storage_api, it);
+    }
+    storage_api->CloseFind(storage_api, it);
+    if (err != ENOENT)
+    {
+        arrfree(segments);
+        return err;
+    }
+
+    // A segment that was sealed while we listed may show up with both indexes, the sealed one wins.
+    // There is at most one unsealed segment per writing store so this stays cheap
+    size_t segment_count = arrlen(segments);
+    size_t kept_count = 0;
+    for (size_t s = 0; s < segment_count; ++s)
+    {
+        int is_replaced = 0;
+        for (size_t o = 0; o < segment_count && !segments[s].m_IsSealed && !is_replaced; ++o)
+        {
+            is_replaced = segments[o].m_IsSealed && strcmp(segments[o].m_Name, segments[s].m_Name) == 0;
+        }
+        if (!is_replaced)
+        {
+            segments[kept_count++] = segments[s];
+        }
+    }
+    arrsetlen(segments, kept_count);
+    *out_segments = segments;
+    return 0;
+}
+
+// Returns 1 if there is nothing more to read from the offset index of the segment, must be called with m_Lock held.
+// Segments that other store instances are still writing are read again to pick up the blocks they flushed since
+static int IsPackSegmentComplete(struct FSBlockStoreAPI* api, const char* segment_name)
+{
+    intptr_t segment_ptr = shgeti(api->m_SegmentLookup, segment_name);
+    if (segment_ptr == -1)
+    {
+        return 0;
+    }
+    uint32_t segment_index = api->m_SegmentLookup[segment_ptr].value;
+    return api->m_Segments[segment_index].m_IsSealed || segment_index == api->m_ActiveSegmentIndex;
+}
+
+// Picks up segments written by other store instances, must be called with m_Lock held
+static int LoadPackSegmentIndexes(struct FSBlockStoreAPI* api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    struct PackSegment* segments;
+    int err = ListPackSegments(storage_api, api->m_StorePath, &segments);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ListPackSegments() failed with %d", err)
+        return err;
+    }
+    api->m_LastSegmentScanTime = Longtail_GetMonotonicTimeUS();
+
+    size_t segment_count = arrlen(segments);
+    for (size_t s = 0; s < segment_count && err != ENOMEM; ++s)
+    {
+        if (IsPackSegmentComplete(api, segments[s].m_Name))
+        {
+            continue;
+        }
+        uint8_t* index_data;
+        uint32_t block_count;
+        // A broken offset index only makes its segment unavailable
+        err = ReadPackSegmentIndex(storage_api, api->m_StorePath, segments[s].m_Name, segments[s].m_IsSealed, &index_data, &block_count);
+        if (err == 0)
+        {
+            err = AddPackSegmentIndex(api, segments[s].m_Name, segments[s].m_IsSealed, index_data, block_count);
+            Longtail_Free(index_data);
+        }
+    }
+    arrfree(segments);
+    return (err == ENOMEM) ? err : 0;
+}
+
+// Picks up segments written by other store instances when a block is not found, must be called without m_Lock held.
+// The directory is scanned at most once per PACK_SEGMENT_RESCAN_INTERVAL_US so a run of gets for blocks
+// that are not in the store does not list it for every block, and no file is read while m_Lock is held.
+static int RefreshPackSegmentIndexes(struct FSBlockStoreAPI* api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+
+    uint64_t now = Longtail_GetMonotonicTimeUS();
+    Longtail_LockSpinLock(api->m_Lock);
+    if (api->m_LastSegmentScanTime != 0 && now - api->m_LastSegmentScanTime < PACK_SEGMENT_RESCAN_INTERVAL_US)
+    {
+        Longtail_UnlockSpinLock(api->m_Lock);
+        return 0;
+    }
+    api->m_LastSegmentScanTime = now;
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    struct PackSegment* segments;
+    int err = ListPackSegments(storage_api, api->m_StorePath, &segments);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ListPackSegments() failed with %d", err)
+        return err;
+    }
+
+    size_t segment_count = arrlen(segments);
+    for (size_t s = 0; s < segment_count && err != ENOMEM; ++s)
+    {
+        Longtail_LockSpinLock(api->m_Lock);
+        int is_complete = IsPackSegmentComplete(api, segments[s].m_Name);
+        Longtail_UnlockSpinLock(api->m_Lock);
+        if (is_complete)
+        {
+            continue;
+        }
+        uint8_t* index_data;
+        uint32_t block_count;
+        // A broken offset index only makes its segment unavailable
+        err = ReadPackSegmentIndex(storage_api, api->m_StorePath, segments[s].m_Name, segments[s].m_IsSealed, &index_data, &block_count);
+        if (err == 0)
+        {
+            Longtail_LockSpinLock(api->m_Lock);
+            err = AddPackSegmentIndex(api, segments[s].m_Name, segments[s].m_IsSealed, index_data, block_count);
+            Longtail_UnlockSpinLock(api->m_Lock);
+            Longtail_Free(index_data);
+        }
+    }
+    arrfree(segments);
+    return (err == ENOMEM) ? err : 0;
+}
+
+// Must be called with m_SegmentWriteSema held
+static int OpenPackSegment(struct FSBlockStoreAPI* api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    char segment_name[PACK_SEGMENT_NAME_LENGTH + 1];
+    char* segment_path = 0;
+    while (!segment_path)
+    {
+        snprintf(segment_name, sizeof(segment_name), "%.16s-%08x", &api->m_TmpExtension[1], api->m_NextSegmentSequence++);
+        segment_path = GetPackSegmentPath(storage_api, api->m_StorePath, segment_name, ".lps");
+        if (!segment_path)
+        {
+            return ENOMEM;
+        }
+        // A previous store with the same identity may have left segments behind, never overwrite them
+        if (storage_api->IsFile(storage_api, segment_path))
+        {
+            Longtail_Free(segment_path);
+            segment_path = 0;
+        }
+    }
+
+    int err = EnsureParentPathExists(storage_api, segment_path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+        Longtail_Free(segment_path);
+        return err;
+    }
+    Longtail_StorageAPI_HOpenFile segment_file;
+    err = storage_api->OpenWriteFile(storage_api, segment_path, 0, &segment_file);
+    Longtail_Free(segment_path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile() failed with %d", err)
+        return err;
+    }
+
+    Longtail_LockSpinLock(api->m_Lock);
+    uint32_t segment_index;
+    err = AddPackSegment(api, segment_name, 0, &segment_index);
+    if (err)
+    {
+        Longtail_UnlockSpinLock(api->m_Lock);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AddPackSegment() failed with %d", err)
+        storage_api->CloseFile(storage_api, segment_file);
+        return err;
+    }
+    api->m_ActiveSegmentIndex = segment_index;
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    api->m_ActiveSegmentFile = segment_file;
+    api->m_ActiveSegmentSize = 0;
+    api->m_ActiveSegmentPersistedBlockCount = 0;
+    return 0;
+}
+
+// Writes the offset index of the active segment to its ".tmp" file so the blocks written so far can be found
+// by other store instances and survive a crash, must be called with m_SegmentWriteSema held
+static int PersistPackSegmentIndex(struct FSBlockStoreAPI* api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+
+    Longtail_LockSpinLock(api->m_Lock);
+    uint32_t segment_index = api->m_ActiveSegmentIndex;
+    char segment_name[PACK_SEGMENT_NAME_LENGTH + 1];
+    memcpy(segment_name, api->m_Segments[segment_index].m_Name, sizeof(segment_name));
+    const TLongtail_Hash* segment_block_hashes = api->m_Segments[segment_index].m_BlockHashes;
+    uint32_t block_count = (uint32_t)arrlen(segment_block_hashes);
+    size_t index_size = GetPackIndexSize(block_count);
+    uint8_t* index_data = (uint8_t*)Longtail_Alloc("FSBlockStoreAPI", index_size);
+    if (!index_data)
+    {
+        Longtail_UnlockSpinLock(api->m_Lock);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    uint32_t magic = PACK_INDEX_MAGIC;
+    memcpy(&index_data[0], &magic, sizeof(uint32_t));
+    memcpy(&index_data[sizeof(uint32_t)], &block_count, sizeof(uint32_t));
+    uint8_t* block_hashes = &index_data[GetPackIndexSize(0)];
+    uint8_t* block_offsets = &block_hashes[sizeof(TLongtail_Hash) * block_count];
+    uint8_t* block_sizes = &block_offsets[sizeof(uint64_t) * block_count];
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        TLongtail_Hash block_hash = segment_block_hashes[b];
+        struct PackedBlockLocation location = hmget(api->m_PackedBlocks, block_hash);
+        memcpy(&block_hashes[sizeof(TLongtail_Hash) * b], &block_hash, sizeof(TLongtail_Hash));
+        memcpy(&block_offsets[sizeof(uint64_t) * b], &location.m_Offset, sizeof(uint64_t));
+        memcpy(&block_sizes[sizeof(uint32_t) * b], &location.m_Size, sizeof(uint32_t));
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    char* tmp_index_path = GetPackSegmentPath(storage_api, api->m_StorePath, segment_name, ".tmp");
+    if (!tmp_index_path)
+    {
+        Longtail_Free(index_data);
+        return ENOMEM;
+    }
+    Longtail_StorageAPI_HOpenFile index_file;
+    int err = storage_api->OpenWriteFile(storage_api, tmp_index_path, 0, &index_file);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile() failed with %d", err)
+        Longtail_Free(tmp_index_path);
+        Longtail_Free(index_data);
+        return err;
+    }
+    err = storage_api->Write(storage_api, index_file, 0, index_size, index_data);
+    storage_api->CloseFile(storage_api, index_file);
+    Longtail_Free(index_data);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to write pack index `%s`, failed with %d", tmp_index_path, err)
+        Longtail_Free(tmp_index_path);
+        return err;
+    }
+    Longtail_Free(tmp_index_path);
+    api->m_ActiveSegmentPersistedBlockCount = block_count;
+    return 0;
+}
+
+// Closes the active segment and renames its offset index to ".lpi", must be called with m_SegmentWriteSema held
+static int SealPackSegment(struct FSBlockStoreAPI* api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    if (api->m_ActiveSegmentIndex == PACK_SEGMENT_NONE)
+    {
+        return 0;
+    }
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    storage_api->CloseFile(storage_api, api->m_ActiveSegmentFile);
+    api->m_ActiveSegmentFile = 0;
+
+    int err = PersistPackSegmentIndex(api);
+
+    Longtail_LockSpinLock(api->m_Lock);
+    uint32_t segment_index = api->m_ActiveSegmentIndex;
+    char segment_name[PACK_SEGMENT_NAME_LENGTH + 1];
+    memcpy(segment_name, api->m_Segments[segment_index].m_Name, sizeof(segment_name));
+    api->m_Segments[segment_index].m_IsSealed = 1;
+    api->m_ActiveSegmentIndex = PACK_SEGMENT_NONE;
+    Longtail_UnlockSpinLock(api->m_Lock);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PersistPackSegmentIndex() failed with %d", err)
+        return err;
+    }
+
+    char* tmp_index_path = GetPackSegmentPath(storage_api, api->m_StorePath, segment_name, ".tmp");
+    char* index_path = GetPackSegmentPath(storage_api, api->m_StorePath, segment_name, ".lpi");
+    if (!tmp_index_path || !index_path)
+    {
+        Longtail_Free(tmp_index_path);
+        Longtail_Free(index_path);
+        return ENOMEM;
+    }
+    // Readers prefer the sealed offset index, rename so they never see a partial one
+    err = storage_api->RenameFile(storage_api, tmp_index_path, index_path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to write pack index `%s`, failed with %d", index_path, err)
+    }
+    Longtail_Free(tmp_index_path);
+    Longtail_Free(index_path);
+    return err;
+}
+
+static int WritePackedStoredBlock(
+    struct FSBlockStoreAPI* api,
+    struct Longtail_StoredBlock* stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    TLongtail_Hash block_hash = *stored_block->m_BlockIndex->m_BlockHash;
+
+    // The block is already in a segment, it is just the store index that is out of sync
+    Longtail_LockSpinLock(api->m_Lock);
+    intptr_t location_ptr = hmgeti(api->m_PackedBlocks, block_hash);
+    Longtail_UnlockSpinLock(api->m_Lock);
+    if (location_ptr != -1)
+    {
+        return 0;
+    }
+
+    void* block_data;
+    size_t block_data_size;
+    int err = Longtail_WriteStoredBlockToBuffer(stored_block, &block_data, &block_data_size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_WriteStoredBlockToBuffer() failed with %d", err)
+        return err;
+    }
+
+    // Appends are serialized, a segment is a single sequential stream of writes
+    Longtail_WaitSema(api->m_SegmentWriteSema, LONGTAIL_TIMEOUT_INFINITE);
+    if (api->m_ActiveSegmentIndex != PACK_SEGMENT_NONE &&
+        api->m_ActiveSegmentSize > 0 &&
+        api->m_ActiveSegmentSize + block_data_size > api->m_MaxSegmentSize)
+    {
+        err = SealPackSegment(api);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SealPackSegment() failed with %d", err)
+            Longtail_PostSema(api->m_SegmentWriteSema, 1);
+            Longtail_Free(block_data);
+            return err;
+        }
+    }
+    if (api->m_ActiveSegmentIndex == PACK_SEGMENT_NONE)
+    {
+        err = OpenPackSegment(api);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "OpenPackSegment() failed with %d", err)
+            Longtail_PostSema(api->m_SegmentWriteSema, 1);
+            Longtail_Free(block_data);
+            return err;
+        }
+    }
+
+    struct PackedBlockLocation location;
+    location.m_Offset = api->m_ActiveSegmentSize;
+    location.m_Size = (uint32_t)block_data_size;
+    location.m_SegmentIndex = api->m_ActiveSegmentIndex;
+    err = api->m_StorageAPI->Write(api->m_StorageAPI, api->m_ActiveSegmentFile, location.m_Offset, block_data_size, block_data);
+    if (err)
+    {
+        // Nothing refers to the failed range, the next block will overwrite it
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "m_StorageAPI->Write() failed with %d", err)
+        Longtail_PostSema(api->m_SegmentWriteSema, 1);
+        Longtail_Free(block_data);
+        return err;
+    }
+    api->m_ActiveSegmentSize += block_data_size;
+    Longtail_Free(block_data);
+
+    Longtail_LockSpinLock(api->m_Lock);
+    hmput(api->m_PackedBlocks, block_hash, location);
+    arrput(api->m_Segments[location.m_SegmentIndex].m_BlockHashes, block_hash);
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    Longtail_PostSema(api->m_SegmentWriteSema, 1);
+    return 0;
+}
+
+static struct Longtail_StoredBlock* AllocPackedStoredBlock(uint32_t block_size, void** out_block_data)
+{
+    size_t block_mem_size = Longtail_GetStoredBlockSize(block_size);
+    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("FSBlockStoreAPI", block_mem_size);
+    if (stored_block)
+    {
+        *out_block_data = &((uint8_t*)stored_block)[block_mem_size - block_size];
+    }
+    return stored_block;
+}
+
+// Must be called with m_SegmentWriteSema held, returns ENOENT if the block is not in the active segment.
+// Not all storage APIs can open a file for read while it is open for write, and not all of them can read
+// through a handle opened for write, so we try both and only seal the segment if neither works
+static int ReadActiveSegmentBlock(
+    struct FSBlockStoreAPI* api,
+    const char* segment_name,
+    const struct PackedBlockLocation* location,
+    struct Longtail_StoredBlock** out_stored_block,
+    void** out_block_data)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(segment_name, "%s"),
+        LONGTAIL_LOGFIELD(location, "%p"),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p"),
+        LONGTAIL_LOGFIELD(out_block_data, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    if (location->m_SegmentIndex != api->m_ActiveSegmentIndex)
+    {
+        return ENOENT;
+    }
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    char* segment_path = GetPackSegmentPath(storage_api, api->m_StorePath, segment_name, ".lps");
+    if (!segment_path)
+    {
+        return ENOMEM;
+    }
+    void* block_data;
+    struct Longtail_StoredBlock* stored_block = AllocPackedStoredBlock(location->m_Size, &block_data);
+    if (!stored_block)
+    {
+        Longtail_Free(segment_path);
+        return ENOMEM;
+    }
+    Longtail_StorageAPI_HOpenFile f;
+    int err = storage_api->OpenReadFile(storage_api, segment_path, &f);
+    Longtail_Free(segment_path);
+    if (err == 0)
+    {
+        err = storage_api->Read(storage_api, f, location->m_Offset, location->m_Size, block_data);
+        storage_api->CloseFile(storage_api, f);
+    }
+    else
+    {
+        err = storage_api->Read(storage_api, api->m_ActiveSegmentFile, location->m_Offset, location->m_Size, block_data);
+    }
+    if (err)
+    {
+        Longtail_Free(stored_block);
+        err = SealPackSegment(api);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SealPackSegment() failed with %d", err)
+            return err;
+        }
+        // The segment is sealed, let the caller read the block from the segment file
+        return ENOENT;
+    }
+    *out_stored_block = stored_block;
+    *out_block_data = block_data;
+    return 0;
+}
+
+static int ReadPackedStoredBlock(
+    struct FSBlockStoreAPI* api,
+    TLongtail_Hash block_hash,
+    struct Longtail_StoredBlock** out_stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    Longtail_LockSpinLock(api->m_Lock);
+    intptr_t location_ptr = hmgeti(api->m_PackedBlocks, block_hash);
+    Longtail_UnlockSpinLock(api->m_Lock);
+    if (location_ptr == -1)
+    {
+        int err = RefreshPackSegmentIndexes(api);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "RefreshPackSegmentIndexes() failed with %d", err)
+            return err;
+        }
+    }
+
+    // The segments array may be reallocated and a pruned segment loses its path once m_Lock is released,
+    // take a copy of the segment name and build the path from it
+    char segment_name[PACK_SEGMENT_NAME_LENGTH + 1];
+    Longtail_LockSpinLock(api->m_Lock);
+    location_ptr = hmgeti(api->m_PackedBlocks, block_hash);
+    if (location_ptr == -1)
+    {
+        Longtail_UnlockSpinLock(api->m_Lock);
+        return ENOENT;
+    }
+    struct PackedBlockLocation location = api->m_PackedBlocks[location_ptr].value;
+    int is_active_segment = location.m_SegmentIndex == api->m_ActiveSegmentIndex;
+    int is_removed = api->m_Segments[location.m_SegmentIndex].m_Path == 0;
+    memcpy(segment_name, api->m_Segments[location.m_SegmentIndex].m_Name, sizeof(segment_name));
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    struct Longtail_StoredBlock* stored_block = 0;
+    void* block_data = 0;
+    int err = ENOENT;
+    if (is_active_segment)
+    {
+        Longtail_WaitSema(api->m_SegmentWriteSema, LONGTAIL_TIMEOUT_INFINITE);
+        err = ReadActiveSegmentBlock(api, segment_name, &location, &stored_block, &block_data);
+        Longtail_PostSema(api->m_SegmentWriteSema, 1);
+        if (err && err != ENOENT)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ReadActiveSegmentBlock() failed with %d", err)
+            return err;
+        }
+        // ENOENT means the segment is sealed, read the block from the segment file
+    }
+    if (err == ENOENT)
+    {
+        if (is_removed)
+        {
+            return ENOENT;
+        }
+        struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+        char* segment_path = GetPackSegmentPath(storage_api, api->m_StorePath, segment_name, ".lps");
+        if (!segment_path)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "GetPackSegmentPath() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
+        Longtail_StorageAPI_HOpenFile f;
+        err = storage_api->OpenReadFile(storage_api, segment_path, &f);
+        Longtail_Free(segment_path);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+            return err;
+        }
+        stored_block = AllocPackedStoredBlock(location.m_Size, &block_data);
+        if (!stored_block)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            storage_api->CloseFile(storage_api, f);
+            return ENOMEM;
+        }
+        err = storage_api->Read(storage_api, f, location.m_Offset, location.m_Size, block_data);
+        storage_api->CloseFile(storage_api, f);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
+            Longtail_Free(stored_block);
+            return err;
+        }
+    }
+    err = Longtail_InitStoredBlockFromData(stored_block, block_data, location.m_Size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitStoredBlockFromData() failed with %d", err)
+        Longtail_Free(stored_block);
+        return err;
+    }
+    stored_block->Dispose = FSStoredBlock_Dispose;
+    *out_stored_block = stored_block;
+    return 0;
+}
+
+// Removes sealed segments where every block has been pruned, must be called with m_Lock held.
+// Segments that are not sealed may still be written to by another store instance and are left alone
+static void RemoveDeadPackSegments(struct FSBlockStoreAPI* api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_StorageAPI* storage_api = api->m_StorageAPI;
+    uint32_t segment_count = (uint32_t)arrlen(api->m_Segments);
+    for (uint32_t s = 0; s < segment_count; ++s)
+    {
+        struct PackSegment* segment = &api->m_Segments[s];
+        if (!segment->m_Path || !segment->m_IsSealed)
+        {
+            continue;
+        }
+        int is_live = 0;
+        size_t block_count = arrlen(segment->m_BlockHashes);
+        for (size_t b = 0; b < block_count && !is_live; ++b)
+        {
+            intptr_t location_ptr = hmgeti(api->m_PackedBlocks, segment->m_BlockHashes[b]);
+            is_live = (location_ptr != -1) && (api->m_PackedBlocks[location_ptr].value.m_SegmentIndex == s);
+        }
+        if (is_live)
+        {
+            continue;
+        }
+        // Remove the offset index first so a failure never leaves an index pointing to a missing segment
+        char* index_path = GetPackSegmentPath(storage_api, api->m_StorePath, segment->m_Name, ".lpi");
+        if (!index_path)
+        {
+            return;
+        }
+        int err = storage_api->RemoveFile(storage_api, index_path);
+        Longtail_Free(index_path);
+        if (err == 0)
+        {
+            err = storage_api->RemoveFile(storage_api, segment->m_Path);
+        }
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to remove pack segment `%s`, error %d", segment->m_Path, err)
+            continue;
+        }
+        Longtail_Free(segment->m_Path);
+        segment->m_Path = 0;
+        arrfree(segment->m_BlockHashes);
+        segment->m_BlockHashes = 0;
+    }
+}
+
+struct ScanPackSegmentJob
+{
+    struct Longtail_StorageAPI* m_StorageAPI;
+    const char* m_SegmentPath;
+    uint32_t m_BlockCount;
+    const TLongtail_Hash* m_BlockHashes;
+    const struct PackedBlockLocation* m_Locations;
+    struct Longtail_BlockIndex** m_BlockIndexes;
+    int m_Err;
+};
+
+static int ScanPackSegment(void* context, uint32_t job_id, int is_cancelled)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+    struct ScanPackSegmentJob* job = (struct ScanPackSegmentJob*)context;
+    if (is_cancelled)
+    {
+        job->m_Err = ECANCELED;
+        return 0;
+    }
+
+    struct Longtail_StorageAPI* storage_api = job->m_StorageAPI;
+    Longtail_StorageAPI_HOpenFile f;
+    job->m_Err = storage_api->OpenReadFile(storage_api, job->m_SegmentPath, &f);
+    if (job->m_Err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->OpenReadFile() failed with %d", job->m_Err)
+        return 0;
+    }
+
+    // Only the block index at the start of each block is needed, read the header to find out how large it is
+    const size_t header_size = Longtail_GetBlockIndexDataSize(0);
+    uint8_t* index_data = 0;
+    for (uint32_t b = 0; b < job->m_BlockCount; ++b)
+    {
+        const struct PackedBlockLocation* location = &job->m_Locations[b];
+        if (location->m_Size < header_size)
+        {
+            continue;
+        }
+        uint8_t header[sizeof(TLongtail_Hash) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint32_t)];
+        if (storage_api->Read(storage_api, f, location->m_Offset, header_size, header))
+        {
+            continue;
+        }
+        uint32_t chunk_count;
+        memcpy(&chunk_count, &header[sizeof(TLongtail_Hash) + sizeof(uint32_t)], sizeof(uint32_t));
+        size_t index_size = Longtail_GetBlockIndexDataSize(chunk_count);
+        if (index_size > location->m_Size)
+        {
+            continue;
+        }
+        arrsetlen(index_data, index_size);
+        if (storage_api->Read(storage_api, f, location->m_Offset, index_size, index_data))
+        {
+            continue;
+        }
+        struct Longtail_BlockIndex* block_index;
+        if (Longtail_ReadBlockIndexFromBuffer(index_data, index_size, &block_index))
+        {
+            continue;
+        }
+        if (*block_index->m_BlockHash != job->m_BlockHashes[b])
+        {
+            Longtail_Free(block_index);
+            continue;
+        }
+        job->m_BlockIndexes[b] = block_index;
+    }
+    arrfree(index_data);
+    storage_api->CloseFile(storage_api, f);
+    return 0;
+}
+
+// Rebuilds the store index from the sealed segments, must be called with m_Lock held
+static int ReadPackedContent(
+    struct FSBlockStoreAPI* api,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    int err = LoadPackSegmentIndexes(api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "LoadPackSegmentIndexes() failed with %d", err)
+        return err;
+    }
+
+    uint32_t segment_count = (uint32_t)arrlen(api->m_Segments);
+    size_t location_count = hmlen(api->m_PackedBlocks);
+    if (location_count == 0)
+    {
+        return Longtail_CreateStoreIndexFromBlocks(0, 0, out_store_index);
+    }
+
+    size_t scan_mem_size =
+        sizeof(struct ScanPackSegmentJob) * segment_count +
+        sizeof(TLongtail_Hash) * location_count +
+        sizeof(struct PackedBlockLocation) * location_count +
+        sizeof(struct Longtail_BlockIndex*) * location_count;
+    void* scan_mem = Longtail_Alloc("FSBlockStoreAPI", scan_mem_size);
+    if (!scan_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct ScanPackSegmentJob* scan_jobs = (struct ScanPackSegmentJob*)scan_mem;
+    struct PackedBlockLocation* locations = (struct PackedBlockLocation*)&scan_jobs[segment_count];
+    TLongtail_Hash* block_hashes = (TLongtail_Hash*)&locations[location_count];
+    struct Longtail_BlockIndex** block_indexes = (struct Longtail_BlockIndex**)&block_hashes[location_count];
+    memset(block_indexes, 0, sizeof(struct Longtail_BlockIndex*) * location_count);
+
+    // Blocks in the active segment are not readable yet, they are tracked in m_AddedBlockIndexes
+    uint32_t job_count = 0;
+    size_t block_offset = 0;
+    for (uint32_t s = 0; s < segment_count; ++s)
+    {
+        const struct PackSegment* segment = &api->m_Segments[s];
+        if (!segment->m_Path || s == api->m_ActiveSegmentIndex)
+        {
+            continue;
+        }
+        struct ScanPackSegmentJob* job = &scan_jobs[job_count];
+        job->m_StorageAPI = api->m_StorageAPI;
+        job->m_SegmentPath = segment->m_Path;
+        job->m_BlockCount = 0;
+        job->m_BlockHashes = &block_hashes[block_offset];
+        job->m_Locations = &locations[block_offset];
+        job->m_BlockIndexes = &block_indexes[block_offset];
+        job->m_Err = EINVAL;
+        size_t segment_block_count = arrlen(segment->m_BlockHashes);
+        for (size_t b = 0; b < segment_block_count && block_offset < location_count; ++b)
+        {
+            TLongtail_Hash block_hash = segment->m_BlockHashes[b];
+            intptr_t location_ptr = hmgeti(api->m_PackedBlocks, block_hash);
+            if (location_ptr == -1 || api->m_PackedBlocks[location_ptr].value.m_SegmentIndex != s)
+            {
+                continue;
+            }
+            block_hashes[block_offset] = block_hash;
+            locations[block_offset] = api->m_PackedBlocks[location_ptr].value;
+            ++block_offset;
+            ++job->m_BlockCount;
+        }
+        if (job->m_BlockCount > 0)
+        {
+            ++job_count;
+        }
+    }
+
+    if (job_count > 0)
+    {
+        struct Longtail_JobAPI* job_api = api->m_JobAPI;
+        Longtail_JobAPI_Group job_group;
+        err = job_api->ReserveJobs(job_api, job_count, &job_group);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+            Longtail_Free(scan_mem);
+            return err;
+        }
+        for (uint32_t j = 0; j < job_count; ++j)
+        {
+            Longtail_JobAPI_JobFunc job_func[] = {ScanPackSegment};
+            void* ctxs[] = {&scan_jobs[j]};
+            Longtail_JobAPI_Jobs jobs;
+            err = job_api->CreateJobs(job_api, job_group, 1, job_func, ctxs, &jobs);
+            LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+            err = job_api->ReadyJobs(job_api, 1, jobs);
+            LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+        }
+        err = job_api->WaitForAllJobs(job_api, job_group, 0, 0, 0);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+            for (size_t b = 0; b < block_offset; ++b)
+            {
+                Longtail_Free(block_indexes[b]);
+            }
+            Longtail_Free(scan_mem);
+            return err;
+        }
+    }
+
+    uint32_t block_count = 0;
+    for (size_t b = 0; b < block_offset; ++b)
+    {
+        if (block_indexes[b])
         {
-            Longtail_Free(job->m_BlockIndex);
-            job->m_BlockIndex = 0;
-            job->m_Err = EBADF;
+            block_indexes[block_count++] = block_indexes[b];
         }
-        Longtail_Free(validate_file_name);
     }
-
-    Longtail_Free(full_block_path);
-    full_block_path = 0;
-    return 0;
+    err = Longtail_CreateStoreIndexFromBlocks(
+        block_count,
+        (const struct Longtail_BlockIndex**)block_indexes,
+        out_store_index);
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        Longtail_Free(block_indexes[b]);
+    }
+    Longtail_Free(scan_mem);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+    }
+    return err;
 }
 
 static int ReadContent(
@@ -469,8 +1951,9 @@ static int ReadContent(
     }
 
     struct Longtail_FileInfos* file_infos;
-    int err = Longtail_GetFilesRecursively(
+    int err = Longtail_GetFilesRecursivelyParallel(
         storage_api,
+        job_api,
         0,
         0,
         0,
@@ -478,7 +1961,7 @@ static int ReadContent(
         &file_infos);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Longtail_GetFilesRecursively() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Longtail_GetFilesRecursivelyParallel() failed with %d", err)
         Longtail_Free((void*)chunks_path);
         return err;
     }
@@ -625,37 +2108,52 @@ int FSBlockStore_GetStoreIndexFromStorage(
         return err;
     }
 
-    const char* store_index_path = storage_api->ConcatPath(storage_api, store_path, "store.lsi");
-
-    if (storage_api->IsFile(storage_api, store_index_path))
+    char** entry_names = 0;
+    err = GetJournalEntries(fsblockstore_api, &entry_names);
+    if (err)
     {
-        int err = Longtail_ReadStoreIndex(storage_api, store_index_path, &store_index);
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_ReadStoreIndex() failed with %d", err)
-            Longtail_Free((void*)store_index_path);
-            storage_api->UnlockFile(storage_api, store_index_lock_file);
-            return err;
-        }
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "GetJournalEntries() failed with %d", err)
+        storage_api->UnlockFile(storage_api, store_index_lock_file);
+        return err;
     }
+    err = ReadJournaledStoreIndex(fsblockstore_api, entry_names, &store_index);
+    FreeJournalEntries(entry_names);
     storage_api->UnlockFile(storage_api, store_index_lock_file);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ReadJournaledStoreIndex() failed with %d", err)
+        return err;
+    }
 
-    Longtail_Free((void*)store_index_path);
     if (store_index)
     {
         *out_store_index = store_index;
         return 0;
     }
-    err = ReadContent(
-        storage_api,
-        job_api,
-        store_path,
-        block_extension,
-        &store_index);
-    if (err)
+    if (fsblockstore_api->m_MaxSegmentSize)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ReadContent() failed with %d", err)
-        return err;
+        err = ReadPackedContent(
+            fsblockstore_api,
+            &store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ReadPackedContent() failed with %d", err)
+            return err;
+        }
+    }
+    else
+    {
+        err = ReadContent(
+            storage_api,
+            job_api,
+            store_path,
+            block_extension,
+            &store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ReadContent() failed with %d", err)
+            return err;
+        }
     }
     *out_store_index = store_index;
     fsblockstore_api->m_StoreIndexIsDirty = 1;
@@ -710,13 +2208,16 @@ static int FSBlockStore_UpdateStoreIndex(
         }
     }
 
-    intptr_t new_block_count = arrlen(fsblockstore_api->m_AddedBlockIndexes);
-    if (new_block_count > 0)
+    // Added blocks are kept until Flush has written them to the journal, only merge the ones we have not seen yet
+    uint32_t added_block_count = (uint32_t)arrlen(fsblockstore_api->m_AddedBlockIndexes);
+    uint32_t merged_block_count = fsblockstore_api->m_MergedBlockIndexCount;
+    if (added_block_count > merged_block_count)
     {
         struct Longtail_StoreIndex* new_store_index;
         int err = UpdateStoreIndex(
             fsblockstore_api->m_StoreIndex,
-            fsblockstore_api->m_AddedBlockIndexes,
+            added_block_count - merged_block_count,
+            &fsblockstore_api->m_AddedBlockIndexes[merged_block_count],
             &new_store_index);
         if (err)
         {
@@ -726,14 +2227,7 @@ static int FSBlockStore_UpdateStoreIndex(
 
         Longtail_Free(fsblockstore_api->m_StoreIndex);
         fsblockstore_api->m_StoreIndex = new_store_index;
-
-        while(new_block_count-- > 0)
-        {
-            struct Longtail_BlockIndex* block_index = fsblockstore_api->m_AddedBlockIndexes[new_block_count];
-            Longtail_Free(block_index);
-        }
-        arrfree(fsblockstore_api->m_AddedBlockIndexes);
-        fsblockstore_api->m_StoreIndexIsDirty = 1;
+        fsblockstore_api->m_MergedBlockIndexCount = added_block_count;
     }
 
     return 0;
@@ -771,6 +2265,84 @@ static int FSBlockStore_GetIndexSync(
     return 0;
 }
 
+static int FSBlockStore_ReadStoredBlock(
+    struct FSBlockStoreAPI* fsblockstore_api,
+    uint64_t block_hash,
+    struct Longtail_StoredBlock** out_stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(fsblockstore_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    struct Longtail_StoredBlock* stored_block;
+    int err = 0;
+    if (fsblockstore_api->m_MaxSegmentSize)
+    {
+        err = ReadPackedStoredBlock(fsblockstore_api, block_hash, &stored_block);
+    }
+    else
+    {
+        char* block_path = GetBlockPath(fsblockstore_api->m_StorageAPI, fsblockstore_api->m_StorePath, fsblockstore_api->m_BlockExtension, block_hash);
+        err = Longtail_ReadStoredBlock(fsblockstore_api->m_StorageAPI, block_path, &stored_block);
+        Longtail_Free(block_path);
+    }
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_WARNING, "Failed to read stored block, failed with %d", err)
+        Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+        return err;
+    }
+    Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *stored_block->m_BlockIndex->m_ChunkCount);
+    Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], Longtail_GetBlockIndexDataSize(*stored_block->m_BlockIndex->m_ChunkCount) + stored_block->m_BlockChunksDataSize);
+
+    *out_stored_block = stored_block;
+    return 0;
+}
+
+// Must be called with m_Lock held
+static struct Longtail_AsyncGetStoredBlockAPI** TakePendingGets(
+    struct FSBlockStoreAPI* fsblockstore_api,
+    uint64_t block_hash)
+{
+    intptr_t pending_ptr = hmgeti(fsblockstore_api->m_PendingGets, block_hash);
+    if (pending_ptr == -1)
+    {
+        return 0;
+    }
+    struct Longtail_AsyncGetStoredBlockAPI** pending_gets = fsblockstore_api->m_PendingGets[pending_ptr].value;
+    hmdel(fsblockstore_api->m_PendingGets, block_hash);
+    return pending_gets;
+}
+
+// Completes gets that arrived while the block was being written, must be called without m_Lock held
+static void CompletePendingGets(
+    struct FSBlockStoreAPI* fsblockstore_api,
+    uint64_t block_hash,
+    struct Longtail_AsyncGetStoredBlockAPI** pending_gets,
+    int put_err)
+{
+    size_t pending_count = arrlen(pending_gets);
+    for (size_t i = 0; i < pending_count; ++i)
+    {
+        if (put_err)
+        {
+            Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+            pending_gets[i]->OnComplete(pending_gets[i], 0, put_err);
+            continue;
+        }
+        struct Longtail_StoredBlock* stored_block = 0;
+        int err = FSBlockStore_ReadStoredBlock(fsblockstore_api, block_hash, &stored_block);
+        pending_gets[i]->OnComplete(pending_gets[i], err ? 0 : stored_block, err);
+    }
+    arrfree(pending_gets);
+}
+
 static int FSBlockStore_PutStoredBlock(
     struct Longtail_BlockStoreAPI* block_store_api,
     struct Longtail_StoredBlock* stored_block,
@@ -810,14 +2382,18 @@ static int FSBlockStore_PutStoredBlock(
     hmput(fsblockstore_api->m_BlockState, block_hash, 0);
     Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
 
-    int err = SafeWriteStoredBlock(fsblockstore_api, fsblockstore_api->m_StorageAPI, fsblockstore_api->m_StorePath, fsblockstore_api->m_BlockExtension, stored_block);
+    int err = fsblockstore_api->m_MaxSegmentSize ?
+        WritePackedStoredBlock(fsblockstore_api, stored_block) :
+        SafeWriteStoredBlock(fsblockstore_api, fsblockstore_api->m_StorageAPI, fsblockstore_api->m_StorePath, fsblockstore_api->m_BlockExtension, stored_block);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SafeWriteStoredBlock() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to write stored block, failed with %d", err)
         Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_FailCount], 1);
         Longtail_LockSpinLock(fsblockstore_api->m_Lock);
         hmdel(fsblockstore_api->m_BlockState, block_hash);
+        struct Longtail_AsyncGetStoredBlockAPI** pending_gets = TakePendingGets(fsblockstore_api, block_hash);
         Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
+        CompletePendingGets(fsblockstore_api, block_hash, pending_gets, err);
         async_complete_api->OnComplete(async_complete_api, err);
         return 0;
     }
@@ -828,6 +2404,12 @@ static int FSBlockStore_PutStoredBlock(
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_FailCount], 1);
+        // The block is on disk but not registered in the store index, forget the state so a later put can retry
+        Longtail_LockSpinLock(fsblockstore_api->m_Lock);
+        hmdel(fsblockstore_api->m_BlockState, block_hash);
+        struct Longtail_AsyncGetStoredBlockAPI** pending_gets = TakePendingGets(fsblockstore_api, block_hash);
+        Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
+        CompletePendingGets(fsblockstore_api, block_hash, pending_gets, 0);
         async_complete_api->OnComplete(async_complete_api, ENOMEM);
         return 0;
     }
@@ -835,8 +2417,10 @@ static int FSBlockStore_PutStoredBlock(
     Longtail_LockSpinLock(fsblockstore_api->m_Lock);
     hmput(fsblockstore_api->m_BlockState, block_hash, 1);
     arrput(fsblockstore_api->m_AddedBlockIndexes, block_index_copy);
+    struct Longtail_AsyncGetStoredBlockAPI** pending_gets = TakePendingGets(fsblockstore_api, block_hash);
     Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
 
+    CompletePendingGets(fsblockstore_api, block_hash, pending_gets, 0);
     async_complete_api->OnComplete(async_complete_api, 0);
     return 0;
 }
@@ -939,7 +2523,28 @@ static int FSBlockStore_GetStoredBlock(
 
     Longtail_LockSpinLock(fsblockstore_api->m_Lock);
     intptr_t block_ptr = hmgeti(fsblockstore_api->m_BlockState, block_hash);
-    if (block_ptr == -1)
+    if (block_ptr == -1 && fsblockstore_api->m_MaxSegmentSize)
+    {
+        if (hmgeti(fsblockstore_api->m_PackedBlocks, block_hash) == -1)
+        {
+            Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
+            int err = RefreshPackSegmentIndexes(fsblockstore_api);
+            Longtail_LockSpinLock(fsblockstore_api->m_Lock);
+            if (err || hmgeti(fsblockstore_api->m_PackedBlocks, block_hash) == -1)
+            {
+                Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
+                return err ? err : ENOENT;
+            }
+        }
+        // A put of the block may have started while m_Lock was released
+        block_ptr = hmgeti(fsblockstore_api->m_BlockState, block_hash);
+        if (block_ptr == -1)
+        {
+            hmput(fsblockstore_api->m_BlockState, block_hash, 1);
+            block_ptr = hmgeti(fsblockstore_api->m_BlockState, block_hash);
+        }
+    }
+    else if (block_ptr == -1)
     {
         char* block_path = GetBlockPath(fsblockstore_api->m_StorageAPI, fsblockstore_api->m_StorePath, fsblockstore_api->m_BlockExtension, block_hash);
         if (!fsblockstore_api->m_StorageAPI->IsFile(fsblockstore_api->m_StorageAPI, block_path))
@@ -953,29 +2558,31 @@ static int FSBlockStore_GetStoredBlock(
         block_ptr = hmgeti(fsblockstore_api->m_BlockState, block_hash);
     }
     uint32_t state = fsblockstore_api->m_BlockState[block_ptr].value;
-    Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
-    while (state == 0)
+    if (state == 0)
     {
-        Longtail_Sleep(1000);
-        Longtail_LockSpinLock(fsblockstore_api->m_Lock);
-        state = hmget(fsblockstore_api->m_BlockState, block_hash);
+        // Block is being written by PutStoredBlock, it will complete this get once the write is done
+        intptr_t pending_ptr = hmgeti(fsblockstore_api->m_PendingGets, block_hash);
+        if (pending_ptr != -1)
+        {
+            arrput(fsblockstore_api->m_PendingGets[pending_ptr].value, async_complete_api);
+        }
+        else
+        {
+            struct Longtail_AsyncGetStoredBlockAPI** pending_gets = 0;
+            arrput(pending_gets, async_complete_api);
+            hmput(fsblockstore_api->m_PendingGets, block_hash, pending_gets);
+        }
         Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
+        return 0;
     }
-    char* block_path = GetBlockPath(fsblockstore_api->m_StorageAPI, fsblockstore_api->m_StorePath, fsblockstore_api->m_BlockExtension, block_hash);
+    Longtail_UnlockSpinLock(fsblockstore_api->m_Lock);
 
     struct Longtail_StoredBlock* stored_block;
-    int err = Longtail_ReadStoredBlock(fsblockstore_api->m_StorageAPI, block_path, &stored_block);
+    int err = FSBlockStore_ReadStoredBlock(fsblockstore_api, block_hash, &stored_block);
     if (err)
     {
-        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_WARNING, "Longtail_ReadStoredBlock() failed with %d", err)
-        Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
-        Longtail_Free((char*)block_path);
         return err;
     }
-    Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *stored_block->m_BlockIndex->m_ChunkCount);
-    Longtail_AtomicAdd64(&fsblockstore_api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], Longtail_GetBlockIndexDataSize(*stored_block->m_BlockIndex->m_ChunkCount) + stored_block->m_BlockChunksDataSize);
-
-    Longtail_Free(block_path);
 
     async_complete_api->OnComplete(async_complete_api, stored_block, 0);
     return 0;
@@ -1096,7 +2703,8 @@ static int FSBlockStore_PruneBlocks(
     }
     api->m_StoreIndexIsDirty = 0;
 
-    err = SafeWriteStoreIndex(api);
+    // The pruned index replaces the snapshot and journal on disk, merging them back in would resurrect the pruned blocks
+    err = SafeWriteStoreIndex(api, 0);
     if (err != 0) {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SafeWriteStoreIndex() failed with %d", err)
         api->m_StorageAPI->UnlockFile(api->m_StorageAPI, store_index_lock_file);
@@ -1106,6 +2714,18 @@ static int FSBlockStore_PruneBlocks(
         return err;
     }
 
+    // Added blocks that were merged into the index we just pruned are covered by the new snapshot
+    uint32_t merged_block_count = api->m_MergedBlockIndexCount;
+    if (merged_block_count > 0)
+    {
+        for (uint32_t b = 0; b < merged_block_count; ++b)
+        {
+            Longtail_Free(api->m_AddedBlockIndexes[b]);
+        }
+        arrdeln(api->m_AddedBlockIndexes, 0, merged_block_count);
+        api->m_MergedBlockIndexCount = 0;
+    }
+
     uint32_t old_block_count = *store_index->m_BlockCount;
     uint32_t block_count = *pruned_store_index->m_BlockCount;
     uint32_t pruned_count = *store_index->m_BlockCount - block_count;
@@ -1129,29 +2749,52 @@ static int FSBlockStore_PruneBlocks(
             Longtail_LookupTable_PutUnique(kept_block_lookup, block_hash, b);
         }
 
-        for (uint32_t b = 0; b < old_block_count; ++b)
+        if (api->m_MaxSegmentSize)
         {
-            TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
-            if (Longtail_LookupTable_Get(kept_block_lookup, block_hash))
+            err = LoadPackSegmentIndexes(api);
+            if (err)
             {
-                continue;
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "LoadPackSegmentIndexes() failed with %d", err)
             }
-            char* block_path = GetBlockPath(api->m_StorageAPI, api->m_StorePath, api->m_BlockExtension, block_hash);
-
-            // Check if block exists, if it does it is just the store store index that is out of sync.
-            // Don't write the block unless we have to
-            if (!api->m_StorageAPI->IsFile(api->m_StorageAPI, block_path))
+            for (uint32_t b = 0; b < old_block_count; ++b)
             {
-                Longtail_Free((void*)block_path);
-                continue;
+                TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
+                if (Longtail_LookupTable_Get(kept_block_lookup, block_hash))
+                {
+                    continue;
+                }
+                hmdel(api->m_PackedBlocks, block_hash);
+                hmdel(api->m_BlockState, block_hash);
             }
-            err = api->m_StorageAPI->RemoveFile(api->m_StorageAPI, block_path);
-            if (err != 0)
+            // Blocks are never moved between segments, a segment is only removed once none of its blocks are kept
+            RemoveDeadPackSegments(api);
+        }
+        else
+        {
+            for (uint32_t b = 0; b < old_block_count; ++b)
             {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "FSBlockStore_PruneBlocks() failed to remove file `%s`, error %d", block_path, err);
+                TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
+                if (Longtail_LookupTable_Get(kept_block_lookup, block_hash))
+                {
+                    continue;
+                }
+                char* block_path = GetBlockPath(api->m_StorageAPI, api->m_StorePath, api->m_BlockExtension, block_hash);
+
+                // Check if block exists, if it does it is just the store store index that is out of sync.
+                // Don't write the block unless we have to
+                if (!api->m_StorageAPI->IsFile(api->m_StorageAPI, block_path))
+                {
+                    Longtail_Free((void*)block_path);
+                    continue;
+                }
+                err = api->m_StorageAPI->RemoveFile(api->m_StorageAPI, block_path);
+                if (err != 0)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "FSBlockStore_PruneBlocks() failed to remove file `%s`, error %d", block_path, err);
+                }
+                Longtail_Free((void*)block_path);
+                hmdel(api->m_BlockState, block_hash);
             }
-            Longtail_Free((void*)block_path);
-            hmdel(api->m_BlockState, block_hash);
         }
         Longtail_Free(kept_block_lookup_mem);
     }
@@ -1196,43 +2839,116 @@ static int FSBlockStore_Flush(struct Longtail_BlockStoreAPI* block_store_api, st
     struct FSBlockStoreAPI* api = (struct FSBlockStoreAPI*)block_store_api;
     Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_Flush_Count], 1);
 
-    Longtail_LockSpinLock(api->m_Lock);
-    intptr_t new_block_count = arrlen(api->m_AddedBlockIndexes);
     int err = 0;
-    if (new_block_count > 0)
+    if (api->m_MaxSegmentSize)
+    {
+        // The offset index must be on disk before the store index refers to the blocks in the segment.
+        // The segment is not sealed so flushing often does not leave lots of small segments behind
+        Longtail_WaitSema(api->m_SegmentWriteSema, LONGTAIL_TIMEOUT_INFINITE);
+        Longtail_LockSpinLock(api->m_Lock);
+        int has_unpersisted_blocks = api->m_ActiveSegmentIndex != PACK_SEGMENT_NONE &&
+            arrlen(api->m_Segments[api->m_ActiveSegmentIndex].m_BlockHashes) != api->m_ActiveSegmentPersistedBlockCount;
+        Longtail_UnlockSpinLock(api->m_Lock);
+        if (has_unpersisted_blocks)
+        {
+            err = PersistPackSegmentIndex(api);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PersistPackSegmentIndex() failed with %d", err)
+            }
+        }
+        Longtail_PostSema(api->m_SegmentWriteSema, 1);
+    }
+
+    Longtail_LockSpinLock(api->m_Lock);
+    uint32_t added_block_count = (uint32_t)arrlen(api->m_AddedBlockIndexes);
+    int write_snapshot = api->m_StoreIndex && api->m_StoreIndexIsDirty;
+    if ((err == 0) && ((added_block_count > 0) || write_snapshot))
     {
-        err = FSBlockStore_UpdateStoreIndex(api);
+        err = EnsureParentPathExists(api->m_StorageAPI, api->m_StoreIndexLockPath);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FSBlockStore_UpdateStoreIndex() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
         }
     }
 
-    if ((err == 0) && api->m_StoreIndex && api->m_StoreIndexIsDirty)
+    if ((err == 0) && (added_block_count > 0))
     {
-        int err = EnsureParentPathExists(api->m_StorageAPI, api->m_StoreIndexLockPath);
+        // Only the added blocks are written, the snapshot is rewritten when the journal grows too long
+        struct Longtail_StoreIndex* added_store_index = 0;
+        err = Longtail_CreateStoreIndexFromBlocks(
+            added_block_count,
+            (const struct Longtail_BlockIndex**)api->m_AddedBlockIndexes,
+            &added_store_index);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
         }
         else
         {
-            const char* store_index_path = api->m_StorageAPI->ConcatPath(api->m_StorageAPI, api->m_StorePath, "store.lsi");
             Longtail_StorageAPI_HLockFile store_index_lock_file;
-            int err = api->m_StorageAPI->LockFile(api->m_StorageAPI, api->m_StoreIndexLockPath, &store_index_lock_file);
-            if (!err)
+            err = api->m_StorageAPI->LockFile(api->m_StorageAPI, api->m_StoreIndexLockPath, &store_index_lock_file);
+            if (err)
             {
-                if (new_block_count > 0 || (!api->m_StorageAPI->IsFile(api->m_StorageAPI, store_index_path)))
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "m_StorageAPI->LockFile() failed with %d", err)
+            }
+            else
+            {
+                err = AppendStoreIndexJournal(api, added_store_index);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AppendStoreIndexJournal() failed with %d", err)
+                }
+                else
                 {
-                    err = SafeWriteStoreIndex(api);
-                    if (err)
+                    if (api->m_StoreIndex)
+                    {
+                        err = FSBlockStore_UpdateStoreIndex(api);
+                        if (err)
+                        {
+                            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FSBlockStore_UpdateStoreIndex() failed with %d", err)
+                        }
+                    }
+                    // The blocks are safely on disk in the journal even if we failed to merge them, don't write them again
+                    for (uint32_t b = 0; b < added_block_count; ++b)
+                    {
+                        Longtail_Free(api->m_AddedBlockIndexes[b]);
+                    }
+                    arrfree(api->m_AddedBlockIndexes);
+                    api->m_MergedBlockIndexCount = 0;
+
+                    char** entry_names = 0;
+                    int compact_err = GetJournalEntries(api, &entry_names);
+                    if (compact_err == 0 && arrlen(entry_names) >= STORE_INDEX_JOURNAL_COMPACT_COUNT)
+                    {
+                        compact_err = SafeWriteStoreIndex(api, 1);
+                        write_snapshot = 0;
+                    }
+                    if (compact_err)
                     {
-                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "SafeWriteStoreIndex() failed with %d", err);
+                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to compact store index journal, error %d", compact_err)
                     }
+                    FreeJournalEntries(entry_names);
                 }
                 api->m_StorageAPI->UnlockFile(api->m_StorageAPI, store_index_lock_file);
             }
-            Longtail_Free((void*)store_index_path);
+            Longtail_Free(added_store_index);
+        }
+    }
+
+    if ((err == 0) && write_snapshot)
+    {
+        // The store index was rebuilt from the block files, write it out so the next open does not have to scan them
+        Longtail_StorageAPI_HLockFile store_index_lock_file;
+        int err = api->m_StorageAPI->LockFile(api->m_StorageAPI, api->m_StoreIndexLockPath, &store_index_lock_file);
+        if (!err)
+        {
+            err = SafeWriteStoreIndex(api, 1);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "SafeWriteStoreIndex() failed with %d", err);
+            }
+            api->m_StorageAPI->UnlockFile(api->m_StorageAPI, store_index_lock_file);
         }
     }
 
@@ -1266,7 +2982,41 @@ static void FSBlockStore_Dispose(struct Longtail_API* api)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "FSBlockStore_Flush() failed with %d", err);
     }
+    if (fsblockstore_api->m_MaxSegmentSize)
+    {
+        Longtail_WaitSema(fsblockstore_api->m_SegmentWriteSema, LONGTAIL_TIMEOUT_INFINITE);
+        err = SealPackSegment(fsblockstore_api);
+        Longtail_PostSema(fsblockstore_api->m_SegmentWriteSema, 1);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "SealPackSegment() failed with %d", err);
+        }
+    }
 
+    LONGTAIL_FATAL_ASSERT(ctx, hmlen(fsblockstore_api->m_PendingGets) == 0, return)
+    hmfree(fsblockstore_api->m_PendingGets);
+    fsblockstore_api->m_PendingGets = 0;
+    size_t added_block_count = arrlen(fsblockstore_api->m_AddedBlockIndexes);
+    for (size_t b = 0; b < added_block_count; ++b)
+    {
+        Longtail_Free(fsblockstore_api->m_AddedBlockIndexes[b]);
+    }
+    arrfree(fsblockstore_api->m_AddedBlockIndexes);
+    if (fsblockstore_api->m_MaxSegmentSize)
+    {
+        LONGTAIL_FATAL_ASSERT(ctx, fsblockstore_api->m_ActiveSegmentIndex == PACK_SEGMENT_NONE, return)
+        size_t segment_count = arrlen(fsblockstore_api->m_Segments);
+        for (size_t s = 0; s < segment_count; ++s)
+        {
+            Longtail_Free(fsblockstore_api->m_Segments[s].m_Path);
+            arrfree(fsblockstore_api->m_Segments[s].m_BlockHashes);
+        }
+        arrfree(fsblockstore_api->m_Segments);
+        shfree(fsblockstore_api->m_SegmentLookup);
+        hmfree(fsblockstore_api->m_PackedBlocks);
+        Longtail_DeleteSema(fsblockstore_api->m_SegmentWriteSema);
+        Longtail_Free(fsblockstore_api->m_SegmentWriteSema);
+    }
     hmfree(fsblockstore_api->m_BlockState);
     fsblockstore_api->m_BlockState = 0;
     Longtail_DeleteSpinLock(fsblockstore_api->m_Lock);
@@ -1283,6 +3033,7 @@ static int FSBlockStore_Init(
     struct Longtail_StorageAPI* storage_api,
     const char* content_path,
     const char* optional_extension,
+    uint64_t max_segment_size,
     uint64_t unique_id,
     struct Longtail_BlockStoreAPI** out_block_store_api)
 {
@@ -1292,6 +3043,7 @@ static int FSBlockStore_Init(
         LONGTAIL_LOGFIELD(storage_api, "%p"),
         LONGTAIL_LOGFIELD(content_path, "%s"),
         LONGTAIL_LOGFIELD(optional_extension, "%p"),
+        LONGTAIL_LOGFIELD(max_segment_size, "%" PRIu64),
         LONGTAIL_LOGFIELD(unique_id, "%" PRIu64),
         LONGTAIL_LOGFIELD(out_block_store_api, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
@@ -1323,12 +3075,27 @@ static int FSBlockStore_Init(
     api->m_StorePath = Longtail_Strdup(content_path);
     api->m_StoreIndex = 0;
     api->m_BlockState = 0;
+    api->m_PendingGets = 0;
     api->m_AddedBlockIndexes = 0;
     api->m_BlockExtension = optional_extension ? optional_extension : ".lrb";
     api->m_StoreIndexLockPath = storage_api->ConcatPath(storage_api, content_path, "store.lsi.sync");
 
     GetUniqueExtension(unique_id, api->m_TmpExtension);
     api->m_StoreIndexIsDirty = 0;
+    api->m_MergedBlockIndexCount = 0;
+    api->m_NextJournalSequence = 0;
+
+    api->m_MaxSegmentSize = max_segment_size;
+    api->m_SegmentWriteSema = 0;
+    api->m_Segments = 0;
+    api->m_SegmentLookup = 0;
+    api->m_PackedBlocks = 0;
+    api->m_ActiveSegmentFile = 0;
+    api->m_ActiveSegmentIndex = PACK_SEGMENT_NONE;
+    api->m_ActiveSegmentPersistedBlockCount = 0;
+    api->m_NextSegmentSequence = 0;
+    api->m_ActiveSegmentSize = 0;
+    api->m_LastSegmentScanTime = 0;
 
     for (uint32_t s = 0; s < Longtail_BlockStoreAPI_StatU64_Count; ++s)
     {
@@ -1344,26 +3111,36 @@ static int FSBlockStore_Init(
         api->m_StoreIndex = 0;
         return err;
     }
+    if (max_segment_size)
+    {
+        err = Longtail_CreateSema(Longtail_Alloc("FSBlockStoreAPI", Longtail_GetSemaSize()), 1, &api->m_SegmentWriteSema);
+        if (err)
+        {
+            Longtail_DeleteSpinLock(api->m_Lock);
+            Longtail_Free(api->m_Lock);
+            return err;
+        }
+        sh_new_strdup(api->m_SegmentLookup);
+    }
     *out_block_store_api = block_store_api;
     return 0;
 }
 
-struct Longtail_BlockStoreAPI* Longtail_CreateFSBlockStoreAPI(
+static struct Longtail_BlockStoreAPI* CreateFSBlockStoreAPI(
     struct Longtail_JobAPI* job_api,
     struct Longtail_StorageAPI* storage_api,
     const char* content_path,
-    const char* optional_extension)
+    const char* optional_extension,
+    uint64_t max_segment_size)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(job_api, "%p"),
         LONGTAIL_LOGFIELD(storage_api, "%p"),
         LONGTAIL_LOGFIELD(content_path, "%s"),
-        LONGTAIL_LOGFIELD(optional_extension, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+        LONGTAIL_LOGFIELD(optional_extension, "%p"),
+        LONGTAIL_LOGFIELD(max_segment_size, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return 0)
-    LONGTAIL_VALIDATE_INPUT(ctx, content_path != 0, return 0)
-    LONGTAIL_VALIDATE_INPUT(ctx, optional_extension == 0 || strlen(optional_extension) < 15, return 0)
     size_t api_size = sizeof(struct FSBlockStoreAPI);
     void* mem = Longtail_Alloc("FSBlockStoreAPI", api_size);
     if (!mem)
@@ -1382,6 +3159,7 @@ struct Longtail_BlockStoreAPI* Longtail_CreateFSBlockStoreAPI(
         storage_api,
         content_path,
         optional_extension,
+        max_segment_size,
         unique_id,
         &block_store_api);
     if (err)
@@ -1392,3 +3170,41 @@ struct Longtail_BlockStoreAPI* Longtail_CreateFSBlockStoreAPI(
     }
     return block_store_api;
 }
+
+struct Longtail_BlockStoreAPI* Longtail_CreateFSBlockStoreAPI(
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_StorageAPI* storage_api,
+    const char* content_path,
+    const char* optional_extension)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(content_path, "%s"),
+        LONGTAIL_LOGFIELD(optional_extension, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, content_path != 0, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, optional_extension == 0 || strlen(optional_extension) < 15, return 0)
+    return CreateFSBlockStoreAPI(job_api, storage_api, content_path, optional_extension, 0);
+}
+
+struct Longtail_BlockStoreAPI* Longtail_CreatePackedFSBlockStoreAPI(
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_StorageAPI* storage_api,
+    const char* content_path,
+    uint64_t max_segment_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(content_path, "%s"),
+        LONGTAIL_LOGFIELD(max_segment_size, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, content_path != 0, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, max_segment_size != 0, return 0)
+    return CreateFSBlockStoreAPI(job_api, storage_api, content_path, 0, max_segment_size);
+}
@@ -12,6 +12,17 @@ LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateFSBlockStor
     const char* content_path,
     const char* optional_extension);
 
+// Appends blocks to shared segment files of up to max_segment_size bytes instead of writing one file per block.
+// A block larger than max_segment_size gets a segment of its own.
+// A segment is sealed when it is full or when the store is disposed, a flush only writes the offset index
+// of the segment being written to a .tmp file so frequent flushes do not leave lots of small segments behind.
+// Segments written by other store instances are picked up when a block is not found, at most once per second.
+LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreatePackedFSBlockStoreAPI(
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_StorageAPI* storage_api,
+    const char* content_path,
+    uint64_t max_segment_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,11 +6,36 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    define LONGTAIL_HPCDC_X86
+#    if defined(_MSC_VER)
+#        include <intrin.h>
+#        define LONGTAIL_HPCDC_TARGET_SSE41
+#        define LONGTAIL_HPCDC_TARGET_AVX2
+#    else
+#        include <cpuid.h>
+#        include <immintrin.h>
+#        define LONGTAIL_HPCDC_TARGET_SSE41 __attribute__((target("sse4.1")))
+#        define LONGTAIL_HPCDC_TARGET_AVX2 __attribute__((target("avx2")))
+#    endif
+#endif
+
 // ChunkerWindowSize is the number of bytes in the rolling hash window
 #define ChunkerWindowSize 48u
 
+// HPCDCLaneSpan is the number of bytes each SIMD lane scans per round, each lane
+// warms up its own hash window so the span needs to be large compared to ChunkerWindowSize
+#define HPCDCLaneSpan 512u
+
 struct Longtail_HPCDCChunker;
 
+typedef uint32_t (*HPCDCScanFunc)(
+    struct Longtail_HPCDCChunker* c,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t hash);
+
 struct Longtail_HPCDCChunkerParams
 {
     uint32_t min;
@@ -97,6 +122,18 @@ struct HPCDCArray
     uint32_t len;
 };
 
+// Precomputed constants to test `hash % d == d - 1` without a division, used by the SIMD scanners.
+// With d = q * 2^shift where q is odd, n is divisible by d if and only if
+// rotr(n * inverse(q), shift) <= (2^32 - 1) / d (Granlund-Montgomery)
+// `hash % d == d - 1` is then the same as `hash >= d - 1 && (hash - (d - 1)) % d == 0`
+struct HPCDCDivisibility
+{
+    uint32_t dm1;
+    uint32_t inverse;
+    uint32_t shift;
+    uint32_t limit;
+};
+
 struct Longtail_HPCDCChunker
 {
     struct Longtail_HPCDCChunkerParams params;
@@ -106,6 +143,8 @@ struct Longtail_HPCDCChunker
     uint32_t hValue;
     uint8_t hWindow[ChunkerWindowSize];
     uint32_t hDiscriminator;
+    struct HPCDCDivisibility hDivisibility;
+    HPCDCScanFunc fScan;
     Longtail_Chunker_Feeder fFeeder;
     void* cFeederContext;
     uint64_t processed_count;
@@ -116,8 +155,37 @@ static uint32_t HPCDCDiscriminatorFromAvg(double avg)
     return (uint32_t)(avg / (-1.42888852e-7*avg + 1.33237515));
 }
 
+static void HPCDCInitDivisibility(uint32_t d, struct HPCDCDivisibility* out_divisibility)
+{
+    uint32_t shift = 0;
+    uint32_t q = d;
+    while ((q & 1) == 0)
+    {
+        q >>= 1;
+        ++shift;
+    }
+    // Newton iteration for the multiplicative inverse of an odd number modulo 2^32, each step doubles the number of correct bits
+    uint32_t inverse = q;
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        inverse *= 2u - q * inverse;
+    }
+    out_divisibility->dm1 = d - 1;
+    out_divisibility->inverse = inverse;
+    out_divisibility->shift = shift;
+    out_divisibility->limit = 0xffffffffu / d;
+}
+
+static uint32_t HPCDCScanScalar(
+    struct Longtail_HPCDCChunker* c,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t hash);
+
 int Longtail_HPCDCCreateChunker(
     struct Longtail_HPCDCChunkerParams* params,
+    HPCDCScanFunc scan_func,
     struct Longtail_HPCDCChunker** out_chunker)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -151,6 +219,8 @@ int Longtail_HPCDCCreateChunker(
     c->off = 0;
     c->hValue = 0;
     c->hDiscriminator = HPCDCDiscriminatorFromAvg((double)params->avg);
+    HPCDCInitDivisibility(c->hDiscriminator, &c->hDivisibility);
+    c->fScan = scan_func ? scan_func : HPCDCScanScalar;
     c->processed_count = 0;
     *out_chunker = c;
     return 0;
@@ -197,6 +267,347 @@ static int FeedChunker(
 #  define LONGTAIL_rotl32(x,r) ((x << r) | (x >> (32 - r)))
 #endif
 
+// Scans for a chunk boundary in buf[pos..end), hash is the rolling hash of the window ending at buf[pos - 1]
+// and c->hWindow holds that window. Returns the position just after the boundary, or end if no boundary was found
+static uint32_t HPCDCScanScalar(
+    struct Longtail_HPCDCChunker* c,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t hash)
+{
+    uint32_t idx = 0;
+    uint8_t* window = c->hWindow;
+    const uint32_t discriminator = c->hDiscriminator - 1;
+    const uint32_t d = c->hDiscriminator;
+    while(pos < end)
+    {
+        uint8_t in = buf[pos++];
+        uint8_t out = window[idx];
+        window[idx++] = in;
+        hash = LONGTAIL_rotl32(hash, 1) ^
+            LONGTAIL_rotl32(hashTable[out], (int)(ChunkerWindowSize & 31)) ^
+            hashTable[in];
+
+        if ((hash % d) == discriminator)
+        {
+            break;
+        }
+        if (idx == ChunkerWindowSize)
+        {
+            idx = 0;
+        }
+    }
+    return pos;
+}
+
+#if defined(LONGTAIL_HPCDC_X86)
+
+// The rolling hash of the window ending at buf[p] only depends on the ChunkerWindowSize bytes in the window:
+//   hash(p) = XOR(k = 0..ChunkerWindowSize-1) rotl32(hashTable[buf[p - k]], k & 31)
+// so the SIMD scanners split the buffer into consecutive spans of HPCDCLaneSpan bytes, one span per lane, and
+// warm up the hash of each lane from the bytes preceding its span. Each lane then rolls its hash exactly as
+// the scalar scanner does and the boundary found is the first one in the lowest lane that has one.
+//
+// The window bytes leaving the hash are read from buf[p - ChunkerWindowSize] instead of c->hWindow, the
+// caller guarantees that there are at least ChunkerWindowSize bytes in buf before pos.
+
+static uint32_t HPCDCScanTail(
+    struct Longtail_HPCDCChunker* c,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t hash)
+{
+    const uint32_t discriminator = c->hDiscriminator - 1;
+    const uint32_t d = c->hDiscriminator;
+    while(pos < end)
+    {
+        uint8_t in = buf[pos];
+        uint8_t out = buf[pos - ChunkerWindowSize];
+        ++pos;
+        hash = LONGTAIL_rotl32(hash, 1) ^
+            LONGTAIL_rotl32(hashTable[out], (int)(ChunkerWindowSize & 31)) ^
+            hashTable[in];
+        if ((hash % d) == discriminator)
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+static uint32_t HPCDCFirstLaneHit(uint32_t hit_lanes, const uint32_t* lane_hit_pos)
+{
+    uint32_t lane = 0;
+    while ((hit_lanes & (1u << lane)) == 0)
+    {
+        ++lane;
+    }
+    return lane_hit_pos[lane];
+}
+
+#define HPCDC_SSE_ROTL32(x, r) _mm_or_si128(_mm_slli_epi32(x, r), _mm_srli_epi32(x, 32 - (r)))
+
+LONGTAIL_HPCDC_TARGET_SSE41
+static __m128i HPCDCMatchSSE41(__m128i hash, __m128i dm1, __m128i inverse, __m128i shift, __m128i rshift, __m128i limit)
+{
+    __m128i m = _mm_mullo_epi32(_mm_sub_epi32(hash, dm1), inverse);
+    __m128i r = _mm_or_si128(_mm_srl_epi32(m, shift), _mm_sll_epi32(m, rshift));
+    __m128i divisible = _mm_cmpeq_epi32(_mm_min_epu32(r, limit), r);
+    __m128i in_range = _mm_cmpeq_epi32(_mm_max_epu32(hash, dm1), hash);
+    return _mm_and_si128(divisible, in_range);
+}
+
+LONGTAIL_HPCDC_TARGET_SSE41
+static uint32_t HPCDCScanSSE41(
+    struct Longtail_HPCDCChunker* c,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t hash)
+{
+    const uint32_t lane_count = 4;
+    const uint32_t round_size = lane_count * HPCDCLaneSpan;
+    const __m128i dm1 = _mm_set1_epi32((int)c->hDivisibility.dm1);
+    const __m128i inverse = _mm_set1_epi32((int)c->hDivisibility.inverse);
+    const __m128i shift = _mm_cvtsi32_si128((int)c->hDivisibility.shift);
+    const __m128i rshift = _mm_cvtsi32_si128((int)(32u - c->hDivisibility.shift));
+    const __m128i limit = _mm_set1_epi32((int)c->hDivisibility.limit);
+    while (end - pos >= round_size)
+    {
+        const uint8_t* l0 = &buf[pos];
+        const uint8_t* l1 = &l0[HPCDCLaneSpan];
+        const uint8_t* l2 = &l1[HPCDCLaneSpan];
+        const uint8_t* l3 = &l2[HPCDCLaneSpan];
+        __m128i h = _mm_setzero_si128();
+        for (int32_t i = -(int32_t)ChunkerWindowSize; i < 0; ++i)
+        {
+            __m128i t = _mm_setr_epi32((int)hashTable[l0[i]], (int)hashTable[l1[i]], (int)hashTable[l2[i]], (int)hashTable[l3[i]]);
+            h = _mm_xor_si128(HPCDC_SSE_ROTL32(h, 1), t);
+        }
+        uint32_t hit_lanes = 0;
+        uint32_t lane_hit_pos[4];
+        for (uint32_t i = 0; i < HPCDCLaneSpan; ++i)
+        {
+            const int32_t o = (int32_t)i - (int32_t)ChunkerWindowSize;
+            __m128i t_in = _mm_setr_epi32((int)hashTable[l0[i]], (int)hashTable[l1[i]], (int)hashTable[l2[i]], (int)hashTable[l3[i]]);
+            __m128i t_out = _mm_setr_epi32((int)hashTable[l0[o]], (int)hashTable[l1[o]], (int)hashTable[l2[o]], (int)hashTable[l3[o]]);
+            h = _mm_xor_si128(_mm_xor_si128(HPCDC_SSE_ROTL32(h, 1), HPCDC_SSE_ROTL32(t_out, ChunkerWindowSize & 31)), t_in);
+            uint32_t mask = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(HPCDCMatchSSE41(h, dm1, inverse, shift, rshift, limit)));
+            uint32_t new_hits = mask & ~hit_lanes;
+            if (new_hits)
+            {
+                if (new_hits & 1)
+                {
+                    // Nothing can come before a boundary in the first lane
+                    return pos + i + 1;
+                }
+                for (uint32_t lane = 1; lane < lane_count; ++lane)
+                {
+                    if (new_hits & (1u << lane))
+                    {
+                        lane_hit_pos[lane] = pos + lane * HPCDCLaneSpan + i + 1;
+                    }
+                }
+                hit_lanes |= new_hits;
+            }
+        }
+        if (hit_lanes)
+        {
+            return HPCDCFirstLaneHit(hit_lanes, lane_hit_pos);
+        }
+        hash = (uint32_t)_mm_extract_epi32(h, 3);
+        pos += round_size;
+    }
+    return HPCDCScanTail(c, buf, pos, end, hash);
+}
+
+#define HPCDC_AVX2_ROTL32(x, r) _mm256_or_si256(_mm256_slli_epi32(x, r), _mm256_srli_epi32(x, 32 - (r)))
+
+LONGTAIL_HPCDC_TARGET_AVX2
+static uint32_t HPCDCScanAVX2(
+    struct Longtail_HPCDCChunker* c,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t hash)
+{
+    const uint32_t lane_count = 8;
+    const uint32_t round_size = lane_count * HPCDCLaneSpan;
+    const __m256i dm1 = _mm256_set1_epi32((int)c->hDivisibility.dm1);
+    const __m256i inverse = _mm256_set1_epi32((int)c->hDivisibility.inverse);
+    const __m128i shift = _mm_cvtsi32_si128((int)c->hDivisibility.shift);
+    const __m128i rshift = _mm_cvtsi32_si128((int)(32u - c->hDivisibility.shift));
+    const __m256i limit = _mm256_set1_epi32((int)c->hDivisibility.limit);
+    const __m256i byte_mask = _mm256_set1_epi32(0xff);
+    const __m256i lane_offsets = _mm256_setr_epi32(
+        0 * (int)HPCDCLaneSpan, 1 * (int)HPCDCLaneSpan, 2 * (int)HPCDCLaneSpan, 3 * (int)HPCDCLaneSpan,
+        4 * (int)HPCDCLaneSpan, 5 * (int)HPCDCLaneSpan, 6 * (int)HPCDCLaneSpan, 7 * (int)HPCDCLaneSpan);
+    const int* table = (const int*)hashTable;
+    while (end - pos >= round_size)
+    {
+        // Four bytes per lane are fetched with each gather and split up into the individual bytes
+        __m256i offsets = _mm256_add_epi32(_mm256_set1_epi32((int)(pos - ChunkerWindowSize)), lane_offsets);
+        __m256i h = _mm256_setzero_si256();
+        for (uint32_t i = 0; i < ChunkerWindowSize; i += 4)
+        {
+            __m256i bytes = _mm256_i32gather_epi32((const int*)buf, offsets, 1);
+            for (uint32_t b = 0; b < 4; ++b)
+            {
+                __m256i t = _mm256_i32gather_epi32(table, _mm256_and_si256(bytes, byte_mask), 4);
+                h = _mm256_xor_si256(HPCDC_AVX2_ROTL32(h, 1), t);
+                bytes = _mm256_srli_epi32(bytes, 8);
+            }
+            offsets = _mm256_add_epi32(offsets, _mm256_set1_epi32(4));
+        }
+        uint32_t hit_lanes = 0;
+        uint32_t lane_hit_pos[8];
+        __m256i out_offsets = _mm256_add_epi32(_mm256_set1_epi32((int)(pos - ChunkerWindowSize)), lane_offsets);
+        __m256i in_offsets = _mm256_add_epi32(_mm256_set1_epi32((int)pos), lane_offsets);
+        for (uint32_t i = 0; i < HPCDCLaneSpan; i += 4)
+        {
+            __m256i in_bytes = _mm256_i32gather_epi32((const int*)buf, in_offsets, 1);
+            __m256i out_bytes = _mm256_i32gather_epi32((const int*)buf, out_offsets, 1);
+            uint32_t masks = 0;
+            for (uint32_t b = 0; b < 4; ++b)
+            {
+                __m256i t_in = _mm256_i32gather_epi32(table, _mm256_and_si256(in_bytes, byte_mask), 4);
+                __m256i t_out = _mm256_i32gather_epi32(table, _mm256_and_si256(out_bytes, byte_mask), 4);
+                h = _mm256_xor_si256(_mm256_xor_si256(HPCDC_AVX2_ROTL32(h, 1), HPCDC_AVX2_ROTL32(t_out, ChunkerWindowSize & 31)), t_in);
+                __m256i m = _mm256_mullo_epi32(_mm256_sub_epi32(h, dm1), inverse);
+                __m256i r = _mm256_or_si256(_mm256_srl_epi32(m, shift), _mm256_sll_epi32(m, rshift));
+                __m256i divisible = _mm256_cmpeq_epi32(_mm256_min_epu32(r, limit), r);
+                __m256i in_range = _mm256_cmpeq_epi32(_mm256_max_epu32(h, dm1), h);
+                masks |= ((uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(divisible, in_range)))) << (b * 8);
+                in_bytes = _mm256_srli_epi32(in_bytes, 8);
+                out_bytes = _mm256_srli_epi32(out_bytes, 8);
+            }
+            if (masks)
+            {
+                for (uint32_t b = 0; b < 4; ++b)
+                {
+                    uint32_t new_hits = ((masks >> (b * 8)) & 0xffu) & ~hit_lanes;
+                    if (new_hits == 0)
+                    {
+                        continue;
+                    }
+                    if (new_hits & 1)
+                    {
+                        // Nothing can come before a boundary in the first lane
+                        return pos + i + b + 1;
+                    }
+                    for (uint32_t lane = 1; lane < lane_count; ++lane)
+                    {
+                        if (new_hits & (1u << lane))
+                        {
+                            lane_hit_pos[lane] = pos + lane * HPCDCLaneSpan + i + b + 1;
+                        }
+                    }
+                    hit_lanes |= new_hits;
+                }
+            }
+            in_offsets = _mm256_add_epi32(in_offsets, _mm256_set1_epi32(4));
+            out_offsets = _mm256_add_epi32(out_offsets, _mm256_set1_epi32(4));
+        }
+        if (hit_lanes)
+        {
+            return HPCDCFirstLaneHit(hit_lanes, lane_hit_pos);
+        }
+        hash = (uint32_t)_mm256_extract_epi32(h, 7);
+        pos += round_size;
+    }
+    return HPCDCScanTail(c, buf, pos, end, hash);
+}
+
+#if !defined(_MSC_VER)
+static void HPCDCCPUID(uint32_t out[4], uint32_t id, uint32_t sub_id)
+{
+    __cpuid_count(id, sub_id, out[0], out[1], out[2], out[3]);
+}
+
+static uint64_t HPCDCXGetBV()
+{
+    uint32_t eax = 0, edx = 0;
+    __asm__ __volatile__("xgetbv\n" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+#else
+static void HPCDCCPUID(uint32_t out[4], uint32_t id, uint32_t sub_id)
+{
+    __cpuidex((int*)out, (int)id, (int)sub_id);
+}
+
+static uint64_t HPCDCXGetBV()
+{
+    return _xgetbv(0);
+}
+#endif
+
+static int HPCDCHasSSE41()
+{
+    uint32_t regs[4];
+    HPCDCCPUID(regs, 1, 0);
+    return (regs[2] & (1u << 19)) != 0;     // SSE4.1
+}
+
+static int HPCDCHasAVX2()
+{
+    uint32_t regs[4];
+    HPCDCCPUID(regs, 0, 0);
+    const uint32_t max_id = regs[0];
+    if (max_id < 7)
+    {
+        return 0;
+    }
+    HPCDCCPUID(regs, 1, 0);
+    const uint32_t ecx = regs[2];
+    // XGETBV is only available if the OS has enabled it (OSXSAVE), and the OS must save the
+    // SSE and AVX register state on context switches or the upper halves of the ymm registers get lost
+    if ((ecx & (1u << 27)) == 0 || (ecx & (1u << 28)) == 0)     // OSXSAVE, AVX
+    {
+        return 0;
+    }
+    if ((HPCDCXGetBV() & 6) != 6)   // XCR0 SSE and AVX state
+    {
+        return 0;
+    }
+    HPCDCCPUID(regs, 7, 0);
+    return (regs[1] & (1u << 5)) != 0;      // AVX2
+}
+
+static HPCDCScanFunc HPCDCGetSSE41ScanFunc()
+{
+    return HPCDCHasSSE41() ? HPCDCScanSSE41 : 0;
+}
+
+static HPCDCScanFunc HPCDCGetBestScanFunc()
+{
+    if (HPCDCHasAVX2())
+    {
+        return HPCDCScanAVX2;
+    }
+    if (HPCDCHasSSE41())
+    {
+        return HPCDCScanSSE41;
+    }
+    return HPCDCScanScalar;
+}
+
+#else // defined(LONGTAIL_HPCDC_X86)
+
+static HPCDCScanFunc HPCDCGetSSE41ScanFunc()
+{
+    return 0;
+}
+
+static HPCDCScanFunc HPCDCGetBestScanFunc()
+{
+    return HPCDCScanScalar;
+}
+
+#endif // defined(LONGTAIL_HPCDC_X86)
+
 static const struct Longtail_Chunker_ChunkRange EmptyChunkRange = {0, 0, 0};
 
 struct Longtail_Chunker_ChunkRange Longtail_HPCDCNextChunk(
@@ -255,32 +666,9 @@ struct Longtail_Chunker_ChunkRange Longtail_HPCDCNextChunk(
         }
     }
 
-    uint32_t pos = c->params.min;
-    uint32_t idx = 0;
-
     uint32_t data_len = scoped_data.len > c->params.max ? c->params.max : scoped_data.len;
-    uint8_t* window = c->hWindow;
-    const uint32_t discriminator = c->hDiscriminator - 1;
     const uint8_t* scoped_buf = scoped_data.buf;
-    const uint32_t d = c->hDiscriminator;
-    while(pos < data_len)
-    {
-        uint8_t in = scoped_buf[pos++];
-        uint8_t out = window[idx];
-        window[idx++] = in;
-        hash = LONGTAIL_rotl32(hash, 1) ^
-            LONGTAIL_rotl32(hashTable[out], (int)(ChunkerWindowSize & 31)) ^
-            hashTable[in];
-
-        if ((hash % d) == discriminator)
-        {
-            break;
-        }
-        if (idx == ChunkerWindowSize)
-        {
-            idx = 0;
-        }
-    }
+    uint32_t pos = c->fScan(c, scoped_buf, c->params.min, data_len, hash);
     struct Longtail_Chunker_ChunkRange r = {scoped_buf, c->processed_count + c->off, pos};
     c->off += pos;
     return r;
@@ -290,6 +678,7 @@ struct Longtail_HPCDCChunkerAPI
 {
     struct Longtail_ChunkerAPI m_API;
 	uint32_t m_TargetChunkSize;
+    HPCDCScanFunc m_ScanFunc;
 };
 
 void HPCDCChunker_Dispose(struct Longtail_API* base_api)
@@ -345,7 +734,12 @@ int HPCDCChunker_CreateChunker(
     chunker_params.max = max_chunk_size;
 
 	struct Longtail_HPCDCChunker* chunker;
-	Longtail_HPCDCCreateChunker(&chunker_params, &chunker);
+	int err = Longtail_HPCDCCreateChunker(&chunker_params, api->m_ScanFunc, &chunker);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_HPCDCCreateChunker() failed with %d", err)
+        return err;
+    }
 
 	*out_chunker = (Longtail_ChunkerAPI_HChunker)chunker;
 
@@ -405,10 +799,12 @@ int HPCDCChunker_DisposeChunker(struct Longtail_ChunkerAPI* chunker_api, Longtai
 
 static int HPCDCChunker_Init(
     void* mem,
+    HPCDCScanFunc scan_func,
     struct Longtail_ChunkerAPI** out_chunker_api)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(mem, "%p"),
+        LONGTAIL_LOGFIELD(scan_func, "%p"),
         LONGTAIL_LOGFIELD(out_chunker_api, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
@@ -428,12 +824,13 @@ static int HPCDCChunker_Init(
     }
 
 	struct Longtail_HPCDCChunkerAPI* api = (struct Longtail_HPCDCChunkerAPI*)chunker_api;
+    api->m_ScanFunc = scan_func;
 
 	*out_chunker_api = chunker_api;
 	return 0;
 }
 
-struct Longtail_ChunkerAPI* Longtail_CreateHPCDCChunkerAPI()
+static struct Longtail_ChunkerAPI* CreateHPCDCChunkerAPI(HPCDCScanFunc scan_func)
 {
     MAKE_LOG_CONTEXT(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
 
@@ -449,6 +846,7 @@ struct Longtail_ChunkerAPI* Longtail_CreateHPCDCChunkerAPI()
     struct Longtail_ChunkerAPI* chunker_api;
     int err = HPCDCChunker_Init(
         mem,
+        scan_func,
         &chunker_api);
     if (err)
     {
@@ -459,3 +857,23 @@ struct Longtail_ChunkerAPI* Longtail_CreateHPCDCChunkerAPI()
     return chunker_api;
 
 }
+
+struct Longtail_ChunkerAPI* Longtail_CreateHPCDCChunkerAPI()
+{
+    return CreateHPCDCChunkerAPI(HPCDCGetBestScanFunc());
+}
+
+struct Longtail_ChunkerAPI* Longtail_CreateHPCDCScalarChunkerAPI()
+{
+    return CreateHPCDCChunkerAPI(HPCDCScanScalar);
+}
+
+struct Longtail_ChunkerAPI* Longtail_CreateHPCDCSSE41ChunkerAPI()
+{
+    HPCDCScanFunc scan_func = HPCDCGetSSE41ScanFunc();
+    if (!scan_func)
+    {
+        return 0;
+    }
+    return CreateHPCDCChunkerAPI(scan_func);
+}
@@ -7,8 +7,15 @@
 extern "C" {
 #endif
 
+// Uses the fastest boundary scanner the CPU supports (AVX2, SSE4.1 or scalar), all of them find the same chunk boundaries
 LONGTAIL_EXPORT extern struct Longtail_ChunkerAPI* Longtail_CreateHPCDCChunkerAPI();
 
+// Always uses the scalar boundary scanner
+LONGTAIL_EXPORT extern struct Longtail_ChunkerAPI* Longtail_CreateHPCDCScalarChunkerAPI();
+
+// Always uses the SSE4.1 boundary scanner, returns 0 if the CPU does not support SSE4.1
+LONGTAIL_EXPORT extern struct Longtail_ChunkerAPI* Longtail_CreateHPCDCSSE41ChunkerAPI();
+
 #ifdef __cplusplus
 }
 #endif
@@ -135,6 +135,15 @@ void Longtail_Sleep(uint64_t timeout_us)
     Sleep(wait_ms);
 }
 
+uint64_t Longtail_GetMonotonicTimeUS()
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((counter.QuadPart / frequency.QuadPart) * 1000000 + ((counter.QuadPart % frequency.QuadPart) * 1000000) / frequency.QuadPart);
+}
+
 int32_t Longtail_AtomicAdd32(TLongtail_Atomic32* value, int32_t amount)
 {
     return (int32_t)InterlockedAdd((LONG volatile*)value, (LONG)amount);
@@ -540,11 +549,12 @@ const char* Longtail_GetDirectoryName(HLongtail_FSIterator fs_iterator)
     return 0;
 }
 
-int Longtail_GetEntryProperties(HLongtail_FSIterator fs_iterator, uint64_t* out_size, uint16_t* out_permissions, int* out_is_dir)
+int Longtail_GetEntryProperties(HLongtail_FSIterator fs_iterator, uint64_t* out_size, uint64_t* out_modification_time, uint16_t* out_permissions, int* out_is_dir)
 {
     DWORD high = fs_iterator->m_FindData.nFileSizeHigh;
     DWORD low = fs_iterator->m_FindData.nFileSizeLow;
     *out_size = (((uint64_t)high) << 32) + (uint64_t)low;
+    *out_modification_time = (((uint64_t)fs_iterator->m_FindData.ftLastWriteTime.dwHighDateTime) << 32) + (uint64_t)fs_iterator->m_FindData.ftLastWriteTime.dwLowDateTime;
     uint16_t permissions = Longtail_StorageAPI_UserReadAccess | Longtail_StorageAPI_GroupReadAccess | Longtail_StorageAPI_OtherReadAccess;
     if (fs_iterator->m_FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
     {
@@ -703,18 +713,23 @@ int Longtail_GetFilePermissions(const char* path, uint16_t* out_permissions)
     return 0;
 }
 
+// The offset is passed with the OVERLAPPED struct instead of moving the shared file pointer first so
+// concurrent reads and writes of the same handle at different offsets do not race, like pread/pwrite
 int Longtail_Read(HLongtail_OpenFile handle, uint64_t offset, uint64_t length, void* output)
 {
     HANDLE h = (HANDLE)(handle);
-    LONG low = (LONG)(offset & 0xffffffff);
-    LONG high = (LONG)(offset >> 32);
-    if (INVALID_SET_FILE_POINTER == SetFilePointer(h, low, &high, FILE_BEGIN))
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = (DWORD)(offset & 0xffffffff);
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD read_count = 0;
+    if (FALSE == ReadFile(h, output, (DWORD)length, &read_count, &overlapped))
     {
         return Win32ErrorToErrno(GetLastError());
     }
-    if (FALSE == ReadFile(h, output, (LONG)length, 0, 0))
+    if (read_count != (DWORD)length)
     {
-        return Win32ErrorToErrno(GetLastError());
+        return EIO;
     }
     return 0;
 }
@@ -722,15 +737,18 @@ int Longtail_Read(HLongtail_OpenFile handle, uint64_t offset, uint64_t length, v
 int Longtail_Write(HLongtail_OpenFile handle, uint64_t offset, uint64_t length, const void* input)
 {
     HANDLE h = (HANDLE)(handle);
-    LONG low = (LONG)(offset & 0xffffffff);
-    LONG high = (LONG)(offset >> 32);
-    if (INVALID_SET_FILE_POINTER == SetFilePointer(h, low, &high, FILE_BEGIN))
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = (DWORD)(offset & 0xffffffff);
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD written_count = 0;
+    if (FALSE == WriteFile(h, input, (DWORD)length, &written_count, &overlapped))
     {
         return Win32ErrorToErrno(GetLastError());
     }
-    if (FALSE == WriteFile(h, input, (LONG)length, 0, 0))
+    if (written_count != (DWORD)length)
     {
-        return Win32ErrorToErrno(GetLastError());
+        return EIO;
     }
     return 0;
 }
@@ -886,6 +904,7 @@ int Longtail_UnlockFile(HLongtail_FileLock file_lock)
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/file.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <pwd.h>
 
@@ -899,6 +918,13 @@ void Longtail_Sleep(uint64_t timeout_us)
     usleep((useconds_t)timeout_us);
 }
 
+uint64_t Longtail_GetMonotonicTimeUS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
 int32_t Longtail_AtomicAdd32(TLongtail_Atomic32* value, int32_t amount)
 {
     return __sync_fetch_and_add(value, amount) + amount;
@@ -1455,11 +1481,16 @@ int Longtail_RemoveFile(const char* path)
     return errno;
 }
 
+// Entries are inspected relative to the open directory with fstatat() so we never build a full path or
+// have the kernel walk it again, d_type is used to classify entries without a stat call when the file system provides it.
+// When we do need a stat the result is cached for the current entry so classifying and querying it only costs one call.
+// Symbolic links are never followed so a link cycle can not make a recursive scan loop
 struct Longtail_FSIterator_private
 {
-    char* m_DirPath;
     DIR* m_DirStream;
     struct dirent * m_DirEntry;
+    struct stat m_Stat;
+    int m_StatResult;
 };
 
 size_t Longtail_GetFSIteratorSize()
@@ -1467,13 +1498,28 @@ size_t Longtail_GetFSIteratorSize()
     return sizeof(struct Longtail_FSIterator_private);
 }
 
-static int IsSkippableFile(HLongtail_FSIterator fs_iterator)
+static void ReadEntry(HLongtail_FSIterator fs_iterator)
 {
-    if ((fs_iterator->m_DirEntry->d_type != DT_DIR) &&
-        (fs_iterator->m_DirEntry->d_type != DT_REG))
+    fs_iterator->m_DirEntry = readdir(fs_iterator->m_DirStream);
+    fs_iterator->m_StatResult = -1;
+}
+
+static int StatEntry(HLongtail_FSIterator fs_iterator, const struct stat** out_stat_buf)
+{
+    if (fs_iterator->m_StatResult == -1)
     {
-        return 0;
+        fs_iterator->m_StatResult = 0;
+        if (fstatat(dirfd(fs_iterator->m_DirStream), fs_iterator->m_DirEntry->d_name, &fs_iterator->m_Stat, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            fs_iterator->m_StatResult = errno;
+        }
     }
+    *out_stat_buf = &fs_iterator->m_Stat;
+    return fs_iterator->m_StatResult;
+}
+
+static int IsDotEntry(HLongtail_FSIterator fs_iterator)
+{
     const char* p = fs_iterator->m_DirEntry->d_name;
     if ((*p++) != '.')
     {
@@ -1494,39 +1540,90 @@ static int IsSkippableFile(HLongtail_FSIterator fs_iterator)
     return 0;
 }
 
+static int IsSkippableFile(HLongtail_FSIterator fs_iterator)
+{
+    if (IsDotEntry(fs_iterator))
+    {
+        return 1;
+    }
+    switch (fs_iterator->m_DirEntry->d_type)
+    {
+        case DT_DIR:
+        case DT_REG:
+            return 0;
+        case DT_UNKNOWN:
+        {
+            // d_type is DT_UNKNOWN for all entries on some file systems so classify those with a stat,
+            // links resolve to S_IFLNK and are skipped just like DT_LNK entries
+            const struct stat* stat_buf;
+            if (StatEntry(fs_iterator, &stat_buf))
+            {
+                return 1;
+            }
+            return (S_ISDIR(stat_buf->st_mode) || S_ISREG(stat_buf->st_mode)) ? 0 : 1;
+        }
+        default:
+            // Links, fifos, sockets and devices are not part of a version
+            return 1;
+    }
+}
+
 static int Skip(HLongtail_FSIterator fs_iterator)
 {
     while (IsSkippableFile(fs_iterator))
     {
-        fs_iterator->m_DirEntry = readdir(fs_iterator->m_DirStream);
+        ReadEntry(fs_iterator);
         if (fs_iterator->m_DirEntry == 0)
         {
-                return ENOENT;
-            }
+            return ENOENT;
         }
+    }
     return 0;
 }
 
+static int IsDirEntry(HLongtail_FSIterator fs_iterator)
+{
+    switch (fs_iterator->m_DirEntry->d_type)
+    {
+        case DT_DIR:
+            return 1;
+        case DT_REG:
+            return 0;
+        default:
+        {
+            // Skip() has already made sure this resolves to a file or a directory
+            const struct stat* stat_buf;
+            if (StatEntry(fs_iterator, &stat_buf))
+            {
+                return 0;
+            }
+            return S_ISDIR(stat_buf->st_mode) ? 1 : 0;
+        }
+    }
+}
+
 int Longtail_StartFind(HLongtail_FSIterator fs_iterator, const char* path)
 {
     if (path[0] == '~')
     {
         struct passwd *pw = getpwuid(getuid());
         const char *homedir = pw->pw_dir;
-        fs_iterator->m_DirPath = (char*)Longtail_Alloc("FSIterator", strlen(homedir) + strlen(path));
-        strcpy(fs_iterator->m_DirPath, homedir);
-        strcpy(&fs_iterator->m_DirPath[strlen(homedir)], &path[1]);
+        char* home_path = (char*)Longtail_Alloc("FSIterator", strlen(homedir) + strlen(path));
+        strcpy(home_path, homedir);
+        strcpy(&home_path[strlen(homedir)], &path[1]);
+        fs_iterator->m_DirStream = opendir(home_path);
+        int e = errno;
+        Longtail_Free(home_path);
+        errno = e;
     }
     else
     {
-        fs_iterator->m_DirPath = Longtail_Strdup(path);
+        fs_iterator->m_DirStream = opendir(path);
     }
 
-    fs_iterator->m_DirStream = opendir(fs_iterator->m_DirPath);
     if (0 == fs_iterator->m_DirStream)
     {
         int e = errno;
-        Longtail_Free(fs_iterator->m_DirPath);
         if (e == 0)
         {
             return ENOENT;
@@ -1534,13 +1631,11 @@ int Longtail_StartFind(HLongtail_FSIterator fs_iterator, const char* path)
         return e;
     }
 
-    fs_iterator->m_DirEntry = readdir(fs_iterator->m_DirStream);
+    ReadEntry(fs_iterator);
     if (fs_iterator->m_DirEntry == 0)
     {
         closedir(fs_iterator->m_DirStream);
         fs_iterator->m_DirStream = 0;
-        Longtail_Free(fs_iterator->m_DirPath);
-        fs_iterator->m_DirPath = 0;
         return ENOENT;
     }
     int err = Skip(fs_iterator);
@@ -1548,8 +1643,6 @@ int Longtail_StartFind(HLongtail_FSIterator fs_iterator, const char* path)
     {
         closedir(fs_iterator->m_DirStream);
         fs_iterator->m_DirStream = 0;
-        Longtail_Free(fs_iterator->m_DirPath);
-        fs_iterator->m_DirPath = 0;
         return err;
     }
     return 0;
@@ -1557,7 +1650,7 @@ int Longtail_StartFind(HLongtail_FSIterator fs_iterator, const char* path)
 
 int Longtail_FindNext(HLongtail_FSIterator fs_iterator)
 {
-    fs_iterator->m_DirEntry = readdir(fs_iterator->m_DirStream);
+    ReadEntry(fs_iterator);
     if (fs_iterator->m_DirEntry == 0)
     {
         return ENOENT;
@@ -1569,13 +1662,11 @@ void Longtail_CloseFind(HLongtail_FSIterator fs_iterator)
 {
     closedir(fs_iterator->m_DirStream);
     fs_iterator->m_DirStream = 0;
-    Longtail_Free(fs_iterator->m_DirPath);
-    fs_iterator->m_DirPath = 0;
 }
 
 const char* Longtail_GetFileName(HLongtail_FSIterator fs_iterator)
 {
-    if (fs_iterator->m_DirEntry->d_type != DT_REG)
+    if (IsDirEntry(fs_iterator))
     {
         return 0;
     }
@@ -1584,87 +1675,91 @@ const char* Longtail_GetFileName(HLongtail_FSIterator fs_iterator)
 
 const char* Longtail_GetDirectoryName(HLongtail_FSIterator fs_iterator)
 {
-    if (fs_iterator->m_DirEntry->d_type != DT_DIR)
+    if (!IsDirEntry(fs_iterator))
     {
         return 0;
     }
     return fs_iterator->m_DirEntry->d_name;
 }
 
-int Longtail_GetEntryProperties(HLongtail_FSIterator fs_iterator, uint64_t* out_size, uint16_t* out_permissions, int* out_is_dir)
+int Longtail_GetEntryProperties(HLongtail_FSIterator fs_iterator, uint64_t* out_size, uint64_t* out_modification_time, uint16_t* out_permissions, int* out_is_dir)
 {
-    size_t dir_len = strlen(fs_iterator->m_DirPath);
-    size_t file_len = strlen(fs_iterator->m_DirEntry->d_name);
-    char* path = (char*)Longtail_Alloc("FSIterator", dir_len + 1 + file_len + 1);
-    memcpy(&path[0], fs_iterator->m_DirPath, dir_len);
-    path[dir_len] = '/';
-    memcpy(&path[dir_len + 1], fs_iterator->m_DirEntry->d_name, file_len);
-    path[dir_len + 1 + file_len] = '\0';
-    struct stat stat_buf;
-    int res = stat(path, &stat_buf);
-    if (res == 0)
+    // Directory permissions are part of the version index so we need the stat even when d_type tells us it is a directory
+    const struct stat* stat_buf;
+    int err = StatEntry(fs_iterator, &stat_buf);
+    if (err)
     {
-        *out_permissions = (uint16_t)(stat_buf.st_mode & 0x1FF);
-        if ((stat_buf.st_mode & S_IFDIR) == S_IFDIR)
-        {
-            *out_is_dir = 1;
-            *out_size = 0;
-        }
-        else
-        {
-            *out_is_dir = 0;
-            *out_size = (uint64_t)stat_buf.st_size;
-        }
+        return err;
+    }
+    *out_permissions = (uint16_t)(stat_buf->st_mode & 0x1FF);
+#if defined(__APPLE__)
+    *out_modification_time = (uint64_t)stat_buf->st_mtimespec.tv_sec * 1000000000u + (uint64_t)stat_buf->st_mtimespec.tv_nsec;
+#else
+    *out_modification_time = (uint64_t)stat_buf->st_mtim.tv_sec * 1000000000u + (uint64_t)stat_buf->st_mtim.tv_nsec;
+#endif
+    if (S_ISDIR(stat_buf->st_mode))
+    {
+        *out_is_dir = 1;
+        *out_size = 0;
     }
     else
     {
-        res = errno;
+        *out_is_dir = 0;
+        *out_size = (uint64_t)stat_buf->st_size;
     }
-    Longtail_Free(path);
-    return res;
+    return 0;
+}
+
+// Files are plain file descriptors accessed with pread/pwrite, there is no shared file position so
+// multiple jobs can read from the same handle. The descriptor is offset by one so a valid handle is never null.
+static HLongtail_OpenFile FileDescriptorToOpenFile(int fd)
+{
+    return (HLongtail_OpenFile)(uintptr_t)(fd + 1);
+}
+
+static int OpenFileToFileDescriptor(HLongtail_OpenFile handle)
+{
+    return (int)((uintptr_t)handle - 1);
 }
 
 int Longtail_OpenReadFile(const char* path, HLongtail_OpenFile* out_read_file)
 {
-    FILE* f = fopen(path, "rb");
-    if (f == 0)
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
     {
         return errno;
     }
-    *out_read_file = (HLongtail_OpenFile)f;
+    *out_read_file = FileDescriptorToOpenFile(fd);
     return 0;
 }
 
 int Longtail_OpenWriteFile(const char* path, uint64_t initial_size, HLongtail_OpenFile* out_write_file)
 {
-    FILE* f = fopen(path, "wb");
-    if (!f)
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd == -1)
     {
-        int e = errno;
-        return e;
+        return errno;
     }
     if  (initial_size > 0)
     {
-        int err = ftruncate64(fileno(f), (off64_t)initial_size);
+        int err = ftruncate(fd, (off_t)initial_size);
         if (err != 0)
         {
             int e = errno;
-            fclose(f);
+            close(fd);
             return e;
         }
     }
-    *out_write_file = (HLongtail_OpenFile)f;
+    *out_write_file = FileDescriptorToOpenFile(fd);
     return 0;
 }
 
 int Longtail_SetFileSize(HLongtail_OpenFile handle, uint64_t length)
 {
-    FILE* f = (FILE*)handle;
-    fflush(f);
-    int err = ftruncate(fileno(f), (off_t)length);
+    int fd = OpenFileToFileDescriptor(handle);
+    int err = ftruncate(fd, (off_t)length);
     if (err == 0)
     {
-        fflush(f);
         return 0;
     }
     return errno;
@@ -1690,49 +1785,69 @@ int Longtail_GetFilePermissions(const char* path, uint16_t* out_permissions)
 
 int Longtail_Read(HLongtail_OpenFile handle, uint64_t offset, uint64_t length, void* output)
 {
-    FILE* f = (FILE*)handle;
-    if (-1 == fseek(f, (long int)offset, SEEK_SET))
+    int fd = OpenFileToFileDescriptor(handle);
+    char* p = (char*)output;
+    while (length > 0)
     {
-        return errno;
-    }
-    size_t read = fread(output, (size_t)length, 1, f);
-    if (read != 1u)
-    {
-        return errno;
+        ssize_t read_count = pread(fd, p, (size_t)length, (off_t)offset);
+        if (read_count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return errno;
+        }
+        if (read_count == 0)
+        {
+            // Reading past end of file
+            return EIO;
+        }
+        p += read_count;
+        offset += (uint64_t)read_count;
+        length -= (uint64_t)read_count;
     }
     return 0;
 }
 
 int Longtail_Write(HLongtail_OpenFile handle, uint64_t offset, uint64_t length, const void* input)
 {
-    FILE* f = (FILE*)handle;
-    if (-1 == fseek(f, (long int )offset, SEEK_SET))
-    {
-        return errno;
-    }
-    size_t written = fwrite(input, (size_t)length, 1, f);
-    if (written != 1u)
+    int fd = OpenFileToFileDescriptor(handle);
+    const char* p = (const char*)input;
+    while (length > 0)
     {
-        return errno;
+        ssize_t written_count = pwrite(fd, p, (size_t)length, (off_t)offset);
+        if (written_count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return errno;
+        }
+        p += written_count;
+        offset += (uint64_t)written_count;
+        length -= (uint64_t)written_count;
     }
     return 0;
 }
 
 int Longtail_GetFileSize(HLongtail_OpenFile handle, uint64_t* out_size)
 {
-    FILE* f = (FILE*)handle;
-    if (-1 == fseek(f, 0, SEEK_END))
+    int fd = OpenFileToFileDescriptor(handle);
+    struct stat stat_buf;
+    if (fstat(fd, &stat_buf) == -1)
     {
         return errno;
     }
-    *out_size = (uint64_t)ftell(f);
+    *out_size = (uint64_t)stat_buf.st_size;
     return 0;
 }
 
 void Longtail_CloseFile(HLongtail_OpenFile handle)
 {
-    FILE* f = (FILE*)handle;
-    fclose(f);
+    int fd = OpenFileToFileDescriptor(handle);
+    close(fd);
 }
 
 const char* Longtail_ConcatPath(const char* folder, const char* file)
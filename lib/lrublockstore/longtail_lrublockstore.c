@@ -7,32 +7,86 @@
 #include <errno.h>
 #include <inttypes.h>
 
+struct LRUBlockStoreAPI;
+
+struct LRUStoredBlock {
+    struct Longtail_StoredBlock m_StoredBlock;
+    struct Longtail_StoredBlock* m_OriginalStoredBlock;
+    struct LRUBlockStoreAPI* m_LRUBlockStoreAPI;
+    struct LRUStoredBlock* m_Prev;
+    struct LRUStoredBlock* m_Next;
+    uint64_t m_Size;
+    TLongtail_Atomic32 m_RefCount;
+};
+
+// Intrusive doubly linked list of the resident blocks, least recently used first
 struct LRU
 {
-    struct LRUStoredBlock** m_StoredBlocks;
+    struct LRUStoredBlock* m_Oldest;
+    struct LRUStoredBlock* m_Newest;
+    uint64_t m_MaxSize;
+    uint64_t m_Size;
     uint32_t m_MaxCount;
-    uint32_t m_AllocatedCount;
+    uint32_t m_Count;
 };
 
-size_t LRU_GetSize(uint32_t max_count)
+void LRU_Init(struct LRU* lru, uint32_t max_count, uint64_t max_size)
 {
-    return sizeof(struct LRU) +
-        sizeof(struct LRUStoredBlock*) * max_count;
+    lru->m_Oldest = 0;
+    lru->m_Newest = 0;
+    lru->m_MaxSize = max_size;
+    lru->m_MaxCount = max_count;
+    lru->m_Size = 0;
+    lru->m_Count = 0;
 }
 
-struct LRU* LRU_Create(void* mem, uint32_t max_count)
+static void LRU_Unlink(struct LRU* lru, struct LRUStoredBlock* stored_block)
 {
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(mem, "%p"),
-        LONGTAIL_LOGFIELD(max_count, "%u")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+    if (stored_block->m_Prev)
+    {
+        stored_block->m_Prev->m_Next = stored_block->m_Next;
+    }
+    else
+    {
+        lru->m_Oldest = stored_block->m_Next;
+    }
+    if (stored_block->m_Next)
+    {
+        stored_block->m_Next->m_Prev = stored_block->m_Prev;
+    }
+    else
+    {
+        lru->m_Newest = stored_block->m_Prev;
+    }
+    stored_block->m_Prev = 0;
+    stored_block->m_Next = 0;
+}
 
-    LONGTAIL_FATAL_ASSERT(ctx, mem, return 0)
-    struct LRU* lru = (struct LRU*)mem;
-    lru->m_StoredBlocks = (struct LRUStoredBlock**)&lru[1];
-    lru->m_MaxCount = max_count;
-    lru->m_AllocatedCount = 0;
-    return lru;
+static void LRU_Link(struct LRU* lru, struct LRUStoredBlock* stored_block)
+{
+    stored_block->m_Prev = lru->m_Newest;
+    stored_block->m_Next = 0;
+    if (lru->m_Newest)
+    {
+        lru->m_Newest->m_Next = stored_block;
+    }
+    else
+    {
+        lru->m_Oldest = stored_block;
+    }
+    lru->m_Newest = stored_block;
+}
+
+// Returns non-zero if stored_block can be cached at all, once all other blocks are evicted
+int LRU_CanHold(const struct LRU* lru, const struct LRUStoredBlock* stored_block)
+{
+    return lru->m_MaxCount > 0 && stored_block->m_Size <= lru->m_MaxSize;
+}
+
+// Returns non-zero if stored_block does not fit in the LRU without evicting other blocks first
+int LRU_NeedsEvict(const struct LRU* lru, const struct LRUStoredBlock* stored_block)
+{
+    return lru->m_Count > 0 && (lru->m_Count >= lru->m_MaxCount || lru->m_Size + stored_block->m_Size > lru->m_MaxSize);
 }
 
 struct LRUStoredBlock* LRU_Evict(struct LRU* lru)
@@ -46,31 +100,30 @@ struct LRUStoredBlock* LRU_Evict(struct LRU* lru)
 #endif // defined(LONGTAIL_ASSERTS)
 
     LONGTAIL_FATAL_ASSERT(ctx, lru, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, lru->m_AllocatedCount > 0, return 0)
-    struct LRUStoredBlock* stored_block = lru->m_StoredBlocks[0];
-    --lru->m_AllocatedCount;
-    for(uint32_t scan = 0; scan < lru->m_AllocatedCount; ++scan)
-    {
-        lru->m_StoredBlocks[scan] = lru->m_StoredBlocks[scan + 1];
-    }
+    LONGTAIL_FATAL_ASSERT(ctx, lru->m_Count > 0, return 0)
+    struct LRUStoredBlock* stored_block = lru->m_Oldest;
+    LRU_Unlink(lru, stored_block);
+    lru->m_Size -= stored_block->m_Size;
+    --lru->m_Count;
     return stored_block;
 }
 
-struct LRUStoredBlock** LRU_Put(struct LRU* lru)
+void LRU_Put(struct LRU* lru, struct LRUStoredBlock* stored_block)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(lru, "%p")
+        LONGTAIL_LOGFIELD(lru, "%p"),
+        LONGTAIL_LOGFIELD(stored_block, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_FATAL_ASSERT(ctx, lru, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, lru->m_AllocatedCount != lru->m_MaxCount, return 0)
-    struct LRUStoredBlock** slot = &lru->m_StoredBlocks[lru->m_AllocatedCount];
-    ++lru->m_AllocatedCount;
-    return slot;
+    LONGTAIL_FATAL_ASSERT(ctx, lru, return)
+    LONGTAIL_FATAL_ASSERT(ctx, !LRU_NeedsEvict(lru, stored_block), return)
+    LRU_Link(lru, stored_block);
+    lru->m_Size += stored_block->m_Size;
+    ++lru->m_Count;
 }
 
 void LRU_Refresh(struct LRU* lru, struct LRUStoredBlock* stored_block)
@@ -85,30 +138,15 @@ void LRU_Refresh(struct LRU* lru, struct LRUStoredBlock* stored_block)
 #endif // defined(LONGTAIL_ASSERTS)
 
     LONGTAIL_FATAL_ASSERT(ctx, lru, return)
-    for (uint32_t i = 0; i < lru->m_AllocatedCount; ++i)
+    LONGTAIL_FATAL_ASSERT(ctx, lru->m_Count > 0, return)
+    if (lru->m_Newest == stored_block)
     {
-        if (lru->m_StoredBlocks[i] == stored_block)
-        {
-            while(++i < lru->m_AllocatedCount)
-            {
-                lru->m_StoredBlocks[i - 1] = lru->m_StoredBlocks[i];
-            }
-            lru->m_StoredBlocks[lru->m_AllocatedCount - 1] = stored_block;
-            return;
-        }
+        return;
     }
-    LONGTAIL_FATAL_ASSERT(ctx, 0, return)
+    LRU_Unlink(lru, stored_block);
+    LRU_Link(lru, stored_block);
 }
 
-struct LRUBlockStoreAPI;
-
-struct LRUStoredBlock {
-    struct Longtail_StoredBlock m_StoredBlock;
-    struct Longtail_StoredBlock* m_OriginalStoredBlock;
-    struct LRUBlockStoreAPI* m_LRUBlockStoreAPI;
-    TLongtail_Atomic32 m_RefCount;
-};
-
 struct BlockHashToLRUStoredBlock
 {
     TLongtail_Hash key;
@@ -130,7 +168,7 @@ struct LRUBlockStoreAPI
 
     HLongtail_SpinLock m_Lock;
     struct Longtail_AsyncFlushAPI** m_PendingAsyncFlushAPIs;
-    struct LRU* m_LRU;
+    struct LRU m_LRU;
     struct BlockHashToLRUStoredBlock* m_BlockHashToLRUStoredBlock;
     struct BlockHashToCompleteCallbacks* m_BlockHashToCompleteCallbacks;
 
@@ -176,36 +214,16 @@ int LRUStoredBlock_Dispose(struct Longtail_StoredBlock* stored_block)
 
     LONGTAIL_FATAL_ASSERT(ctx, stored_block != 0, return EINVAL)
     struct LRUStoredBlock* b = (struct LRUStoredBlock*)stored_block;
-    TLongtail_Hash block_hash = *stored_block->m_BlockIndex->m_BlockHash;
     int32_t ref_count = Longtail_AtomicAdd32(&b->m_RefCount, -1);
-    if (ref_count > 1)
-    {
-        return 0;
-    }
-    struct LRUBlockStoreAPI* api = b->m_LRUBlockStoreAPI;
-    if (ref_count == 1)
+    if (ref_count > 0)
     {
-        // We dipped down to just our LRU ref count - see if it is still around and refresh LRU position if so
-        Longtail_LockSpinLock(api->m_Lock);
-        intptr_t tmp;
-        intptr_t find_ptr = hmgeti_ts(api->m_BlockHashToLRUStoredBlock, block_hash, tmp);
-        if (find_ptr == -1)
-        {
-            Longtail_UnlockSpinLock(api->m_Lock);
-            return 0;
-        }
-        struct LRUStoredBlock* stored_block = api->m_BlockHashToLRUStoredBlock[find_ptr].value;
-        LRU_Refresh(api->m_LRU, stored_block);
-        Longtail_UnlockSpinLock(api->m_Lock);
+        // Recency in the LRU is updated when the block is requested, not when it is released
         return 0;
     }
-    if (b->m_RefCount == 0)
+    struct Longtail_StoredBlock* original_stored_block = b->m_OriginalStoredBlock;
+    if (original_stored_block->Dispose)
     {
-        struct Longtail_StoredBlock* original_stored_block = b->m_OriginalStoredBlock;
-        if (original_stored_block->Dispose)
-        {
-            original_stored_block->Dispose(original_stored_block);
-        }
+        original_stored_block->Dispose(original_stored_block);
     }
     Longtail_Free(b);
     return 0;
@@ -222,10 +240,17 @@ struct LRUStoredBlock* CreateLRUBlock(struct LRUBlockStoreAPI* api, struct Longt
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    TLongtail_Hash block_hash = *original_stored_block->m_BlockIndex->m_BlockHash;
     struct LRUStoredBlock* allocated_block = (struct LRUStoredBlock*)Longtail_Alloc("LRUBlockStoreAPI", sizeof(struct LRUStoredBlock));
+    if (!allocated_block)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
     allocated_block->m_OriginalStoredBlock = original_stored_block;
     allocated_block->m_LRUBlockStoreAPI = api;
+    allocated_block->m_Prev = 0;
+    allocated_block->m_Next = 0;
+    allocated_block->m_Size = Longtail_GetBlockIndexDataSize(*original_stored_block->m_BlockIndex->m_ChunkCount) + original_stored_block->m_BlockChunksDataSize;
     allocated_block->m_StoredBlock.Dispose = LRUStoredBlock_Dispose;
     allocated_block->m_StoredBlock.m_BlockChunksDataSize = original_stored_block->m_BlockChunksDataSize;
     allocated_block->m_StoredBlock.m_BlockData = original_stored_block->m_BlockData;
@@ -252,8 +277,8 @@ struct LRUStoredBlock* GetLRUBlock(struct LRUBlockStoreAPI* api, TLongtail_Hash
         return 0;
     }
     struct LRUStoredBlock* stored_block = api->m_BlockHashToLRUStoredBlock[find_ptr].value;
-//    LRU_Refresh(api->m_LRU, block_index);
     LONGTAIL_FATAL_ASSERT(ctx, stored_block->m_RefCount > 0, return 0)
+    LRU_Refresh(&api->m_LRU, stored_block);
     Longtail_AtomicAdd32(&stored_block->m_RefCount, 1);
     return stored_block;
 }
@@ -399,31 +424,46 @@ static void LRUBlockStore_AsyncGetStoredBlockAPI_OnComplete(struct Longtail_Asyn
     }
 
     struct Longtail_AsyncGetStoredBlockAPI** list;
-    struct Longtail_StoredBlock* dispose_block = 0;
+    struct LRUStoredBlock** dispose_blocks = 0;
 
     Longtail_LockSpinLock(api->m_Lock);
-    if (api->m_LRU->m_AllocatedCount == api->m_LRU->m_MaxCount)
-    {
-        dispose_block = &LRU_Evict(api->m_LRU)->m_StoredBlock;
-        hmdel(api->m_BlockHashToLRUStoredBlock, *dispose_block->m_BlockIndex->m_BlockHash);
-    }
-    *LRU_Put(api->m_LRU) = shared_stored_block;
-    hmput(api->m_BlockHashToLRUStoredBlock, block_hash, shared_stored_block);
-
     list = hmget(api->m_BlockHashToCompleteCallbacks, block_hash);
     hmdel(api->m_BlockHashToCompleteCallbacks, block_hash);
     size_t wait_count = arrlen(list);
-    Longtail_AtomicAdd32(&shared_stored_block->m_RefCount, (int32_t)wait_count);
+
+    if (LRU_CanHold(&api->m_LRU, shared_stored_block))
+    {
+        while (LRU_NeedsEvict(&api->m_LRU, shared_stored_block))
+        {
+            struct LRUStoredBlock* evicted_block = LRU_Evict(&api->m_LRU);
+            hmdel(api->m_BlockHashToLRUStoredBlock, *evicted_block->m_StoredBlock.m_BlockIndex->m_BlockHash);
+            arrput(dispose_blocks, evicted_block);
+        }
+        LRU_Put(&api->m_LRU, shared_stored_block);
+        hmput(api->m_BlockHashToLRUStoredBlock, block_hash, shared_stored_block);
+        Longtail_AtomicAdd32(&shared_stored_block->m_RefCount, (int32_t)wait_count);
+    }
+    else
+    {
+        // Block does not fit in the LRU at all, only hand it to the waiting requests
+        Longtail_AtomicAdd32(&shared_stored_block->m_RefCount, (int32_t)wait_count - 1);
+    }
 
     Longtail_UnlockSpinLock(api->m_Lock);
 
-    if (dispose_block && dispose_block->Dispose)
+    size_t dispose_count = arrlen(dispose_blocks);
+    for (size_t i = 0; i < dispose_count; ++i)
     {
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_CacheEvict_Count], 1);
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_CacheEvict_Byte_Count], dispose_blocks[i]->m_Size);
+        struct Longtail_StoredBlock* dispose_block = &dispose_blocks[i]->m_StoredBlock;
         dispose_block->Dispose(dispose_block);
     }
+    arrfree(dispose_blocks);
 
-    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *shared_stored_block->m_StoredBlock.m_BlockIndex->m_ChunkCount);
-    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], Longtail_GetBlockIndexDataSize(*shared_stored_block->m_StoredBlock.m_BlockIndex->m_ChunkCount) + shared_stored_block->m_StoredBlock.m_BlockChunksDataSize);
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheMiss_Byte_Count], shared_stored_block->m_Size * wait_count);
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *shared_stored_block->m_StoredBlock.m_BlockIndex->m_ChunkCount * wait_count);
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], shared_stored_block->m_Size * wait_count);
     for (size_t i = 0; i < wait_count; ++i)
     {
         list[i]->OnComplete(list[i], &shared_stored_block->m_StoredBlock, 0);
@@ -459,11 +499,14 @@ static int LRUBlockStore_GetStoredBlock(
     if (lru_block != 0 && lru_block->m_RefCount > 0)
     {
         Longtail_UnlockSpinLock(api->m_Lock);
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Count], 1);
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Byte_Count], lru_block->m_Size);
         Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *lru_block->m_StoredBlock.m_BlockIndex->m_ChunkCount);
-        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], Longtail_GetBlockIndexDataSize(*lru_block->m_StoredBlock.m_BlockIndex->m_ChunkCount) + lru_block->m_StoredBlock.m_BlockChunksDataSize);
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], lru_block->m_Size);
         async_complete_api->OnComplete(async_complete_api, &lru_block->m_StoredBlock, 0);
         return 0;
     }
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheMiss_Count], 1);
 
     intptr_t find_wait_list_ptr = hmgeti(api->m_BlockHashToCompleteCallbacks, block_hash);
     if (find_wait_list_ptr != -1)
@@ -509,6 +552,49 @@ static int LRUBlockStore_GetStoredBlock(
     return 0;
 }
 
+static int LRUBlockStore_GetStoredBlockChunks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api->OnComplete, return EINVAL)
+    struct LRUBlockStoreAPI* api = (struct LRUBlockStoreAPI*)block_store_api;
+
+    Longtail_LockSpinLock(api->m_Lock);
+    struct LRUStoredBlock* lru_block = GetLRUBlock(api, block_hash);
+    Longtail_UnlockSpinLock(api->m_Lock);
+    if (lru_block != 0)
+    {
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count], 1);
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Count], 1);
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Byte_Count], lru_block->m_Size);
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *lru_block->m_StoredBlock.m_BlockIndex->m_ChunkCount);
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], lru_block->m_Size);
+        async_complete_api->OnComplete(async_complete_api, &lru_block->m_StoredBlock, 0);
+        return 0;
+    }
+
+    // A partial block can not serve other requests so it bypasses the cache
+    return Longtail_BlockStore_GetStoredBlockChunks(api->m_BackingBlockStore, block_hash, chunk_count, chunk_hashes, async_complete_api);
+}
+
 static int LRUBlockStore_GetExistingContent(
     struct Longtail_BlockStoreAPI* block_store_api,
     uint32_t chunk_count,
@@ -622,9 +708,9 @@ static void LRUBlockStore_Dispose(struct Longtail_API* base_api)
             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Waiting for %d pending requests", (int32_t)api->m_PendingRequestCount);
         }
     }
-    while (api->m_LRU->m_AllocatedCount > 0)
+    while (api->m_LRU.m_Count > 0)
     {
-        struct Longtail_StoredBlock* lru_block = &LRU_Evict(api->m_LRU)->m_StoredBlock;
+        struct Longtail_StoredBlock* lru_block = &LRU_Evict(&api->m_LRU)->m_StoredBlock;
         hmdel(api->m_BlockHashToLRUStoredBlock, *lru_block->m_BlockIndex->m_BlockHash);
         if (lru_block->Dispose)
         {
@@ -642,12 +728,14 @@ static int LRUBlockStore_Init(
     void* mem,
     struct Longtail_BlockStoreAPI* backing_block_store,
     uint32_t max_lru_count,
+    uint64_t max_lru_bytes,
     struct Longtail_BlockStoreAPI** out_block_store_api)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(mem, "%p"),
         LONGTAIL_LOGFIELD(backing_block_store, "%p"),
         LONGTAIL_LOGFIELD(max_lru_count, "%u"),
+        LONGTAIL_LOGFIELD(max_lru_bytes, "%" PRIu64),
         LONGTAIL_LOGFIELD(out_block_store_api, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
@@ -669,6 +757,7 @@ static int LRUBlockStore_Init(
     {
         return EINVAL;
     }
+    block_store_api->GetStoredBlockChunks = LRUBlockStore_GetStoredBlockChunks;
 
     struct LRUBlockStoreAPI* api = (struct LRUBlockStoreAPI*)block_store_api;
     api->m_BackingBlockStore = backing_block_store;
@@ -677,7 +766,7 @@ static int LRUBlockStore_Init(
     api->m_PendingRequestCount = 0;
     api->m_PendingAsyncFlushAPIs = 0;
 
-    api->m_LRU = LRU_Create(&api[1], max_lru_count);
+    LRU_Init(&api->m_LRU, max_lru_count, max_lru_bytes);
 
     int err =Longtail_CreateSpinLock(Longtail_Alloc("LRUBlockStoreAPI", Longtail_GetSpinLockSize()), &api->m_Lock);
     if (err)
@@ -695,21 +784,18 @@ static int LRUBlockStore_Init(
     return 0;
 }
 
-struct Longtail_BlockStoreAPI* Longtail_CreateLRUBlockStoreAPI(
+static struct Longtail_BlockStoreAPI* CreateLRUBlockStoreAPI(
     struct Longtail_BlockStoreAPI* backing_block_store,
-    uint32_t max_lru_count)
+    uint32_t max_lru_count,
+    uint64_t max_lru_bytes)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(backing_block_store, "%p"),
-        LONGTAIL_LOGFIELD(max_lru_count, "%u")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, backing_block_store, return 0)
+        LONGTAIL_LOGFIELD(max_lru_count, "%u"),
+        LONGTAIL_LOGFIELD(max_lru_bytes, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    size_t api_size =
-        sizeof(struct LRUBlockStoreAPI) +
-        sizeof(struct LRUStoredBlock) * max_lru_count +
-        LRU_GetSize(max_lru_count);
+    size_t api_size = sizeof(struct LRUBlockStoreAPI);
 
     void* mem = Longtail_Alloc("LRUBlockStoreAPI", api_size);
     if (!mem)
@@ -722,6 +808,7 @@ struct Longtail_BlockStoreAPI* Longtail_CreateLRUBlockStoreAPI(
         mem,
         backing_block_store,
         max_lru_count,
+        max_lru_bytes,
         &block_store_api);
     if (err)
     {
@@ -731,3 +818,31 @@ struct Longtail_BlockStoreAPI* Longtail_CreateLRUBlockStoreAPI(
     }
     return block_store_api;
 }
+
+struct Longtail_BlockStoreAPI* Longtail_CreateLRUBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    uint32_t max_lru_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(backing_block_store, "%p"),
+        LONGTAIL_LOGFIELD(max_lru_count, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, backing_block_store, return 0)
+
+    return CreateLRUBlockStoreAPI(backing_block_store, max_lru_count, UINT64_MAX);
+}
+
+struct Longtail_BlockStoreAPI* Longtail_CreateSizedLRUBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    uint64_t max_lru_bytes)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(backing_block_store, "%p"),
+        LONGTAIL_LOGFIELD(max_lru_bytes, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, backing_block_store, return 0)
+
+    return CreateLRUBlockStoreAPI(backing_block_store, UINT32_MAX, max_lru_bytes);
+}
@@ -6,10 +6,17 @@
 extern "C" {
 #endif
 
+// Keeps at most max_lru_count blocks, evicting the least recently used block first
 LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateLRUBlockStoreAPI(
     struct Longtail_BlockStoreAPI* backing_block_store,
     uint32_t max_lru_count);
 
+// Blocks are evicted in least recently used order when their combined size (block index data
+// plus chunk data) would exceed max_lru_bytes, a block larger than max_lru_bytes is not cached
+LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateSizedLRUBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    uint64_t max_lru_bytes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,8 @@
 #include "longtail_lz4.h"
 
+#include "../../src/ext/stb_ds.h"
+#include "../longtail_platform.h"
+#define LZ4_STATIC_LINKING_ONLY
 #include "ext/lz4.h"
 
 #include <errno.h>
@@ -21,16 +24,54 @@ static int SettingsIDToCompressionSetting(uint32_t settings_id)
     return LZ4CompressionAPI_DefaultCompressionSetting;
 }
 
+// Compression states are pooled and reused across calls so only the first compression with a state pays for
+// a full reset, decompression is stateless. At most LONGTAIL_LZ4_MAX_POOLED_STREAMS idle states are kept
+#define LONGTAIL_LZ4_MAX_POOLED_STREAMS 16
+
 struct LZ4CompressionAPI
 {
     struct Longtail_CompressionAPI m_LZ4CompressionAPI;
+    HLongtail_SpinLock m_Lock;
+    LZ4_stream_t** m_FreeStreams;
 };
 
 void LZ4CompressionAPI_Dispose(struct Longtail_API* compression_api)
 {
+    struct LZ4CompressionAPI* api = (struct LZ4CompressionAPI*)compression_api;
+    for (ptrdiff_t i = 0; i < arrlen(api->m_FreeStreams); ++i)
+    {
+        LZ4_freeStream(api->m_FreeStreams[i]);
+    }
+    arrfree(api->m_FreeStreams);
+    Longtail_DeleteSpinLock(api->m_Lock);
     Longtail_Free(compression_api);
 }
 
+static LZ4_stream_t* LZ4CompressionAPI_AcquireStream(struct LZ4CompressionAPI* api)
+{
+    LZ4_stream_t* stream = 0;
+    Longtail_LockSpinLock(api->m_Lock);
+    if (arrlen(api->m_FreeStreams) > 0)
+    {
+        stream = arrpop(api->m_FreeStreams);
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return stream ? stream : LZ4_createStream();
+}
+
+static void LZ4CompressionAPI_ReleaseStream(struct LZ4CompressionAPI* api, LZ4_stream_t* stream)
+{
+    Longtail_LockSpinLock(api->m_Lock);
+    if (arrlen(api->m_FreeStreams) < LONGTAIL_LZ4_MAX_POOLED_STREAMS)
+    {
+        arrput(api->m_FreeStreams, stream);
+        Longtail_UnlockSpinLock(api->m_Lock);
+        return;
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    LZ4_freeStream(stream);
+}
+
 static size_t LZ4CompressionAPI_GetMaxCompressedSize(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, size_t size)
 {
     return (size_t)LZ4_COMPRESSBOUND((unsigned)size);
@@ -52,11 +93,19 @@ int LZ4CompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api,
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
+    struct LZ4CompressionAPI* api = (struct LZ4CompressionAPI*)compression_api;
+    LZ4_stream_t* stream = LZ4CompressionAPI_AcquireStream(api);
+    if (!stream)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "LZ4_createStream() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
     int compression_setting = SettingsIDToCompressionSetting(settings_id);
-    int compressed_size = LZ4_compress_fast(uncompressed, compressed, (int)uncompressed_size, (int)max_compressed_size, compression_setting);
+    int compressed_size = LZ4_compress_fast_extState_fastReset(stream, uncompressed, compressed, (int)uncompressed_size, (int)max_compressed_size, compression_setting);
+    LZ4CompressionAPI_ReleaseStream(api, stream);
     if (compressed_size == 0)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "LZ4_compress_fast() failed with %d", ENOMEM);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "LZ4_compress_fast_extState_fastReset() failed with %d", ENOMEM);
         return ENOMEM;
     }
     *out_compressed_size = (size_t)compressed_size;
@@ -88,23 +137,31 @@ static int LZ4CompressionAPI_Decompress(struct Longtail_CompressionAPI* compress
     return 0;
 }
 
-static void LZ4CompressionAPI_Init(struct LZ4CompressionAPI* compression_api)
+static int LZ4CompressionAPI_Init(struct LZ4CompressionAPI* compression_api)
 {
     compression_api->m_LZ4CompressionAPI.m_API.Dispose = LZ4CompressionAPI_Dispose;
     compression_api->m_LZ4CompressionAPI.GetMaxCompressedSize = LZ4CompressionAPI_GetMaxCompressedSize;
     compression_api->m_LZ4CompressionAPI.Compress = LZ4CompressionAPI_Compress;
     compression_api->m_LZ4CompressionAPI.Decompress = LZ4CompressionAPI_Decompress;
+    compression_api->m_FreeStreams = 0;
+    return Longtail_CreateSpinLock(&compression_api[1], &compression_api->m_Lock);
 }
 
 struct Longtail_CompressionAPI* Longtail_CreateLZ4CompressionAPI()
 {
     MAKE_LOG_CONTEXT(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-    struct LZ4CompressionAPI* compression_api = (struct LZ4CompressionAPI*)Longtail_Alloc("LZ4CompressionAPI", sizeof(struct LZ4CompressionAPI));
+    struct LZ4CompressionAPI* compression_api = (struct LZ4CompressionAPI*)Longtail_Alloc("LZ4CompressionAPI", sizeof(struct LZ4CompressionAPI) + Longtail_GetSpinLockSize());
     if (!compression_api)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return 0;
     }
-    LZ4CompressionAPI_Init(compression_api);
+    int err = LZ4CompressionAPI_Init(compression_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "LZ4CompressionAPI_Init() failed with %d", err)
+        Longtail_Free(compression_api);
+        return 0;
+    }
     return &compression_api->m_LZ4CompressionAPI;
 }
@@ -67,6 +67,7 @@ struct PathEntry
     char* m_FileName;
     uint32_t m_ParentHash;
     uint8_t* m_Content;
+    uint64_t m_ModificationTime;
     uint16_t m_Permissions;
     uint8_t m_IsOpenWrite;
     uint32_t m_IsOpenRead;
@@ -83,6 +84,7 @@ struct InMemStorageAPI
     struct Longtail_StorageAPI m_InMemStorageAPI;
     struct Lookup* m_PathHashToContent;
     struct PathEntry* m_PathEntries;
+    uint64_t m_ModificationCounter;   // Stands in for a clock, every change gets a unique modification time
     HLongtail_SpinLock m_SpinLock;
 };
 
@@ -330,12 +332,14 @@ static int InMemStorageAPI_OpenWriteFile(struct Longtail_StorageAPI* storage_api
         path_entry->m_FileName = Longtail_Strdup(InMemStorageAPI_GetFileNamePart(path));
         path_entry->m_Content = 0;
         path_entry->m_Permissions = 0644;
+        path_entry->m_ModificationTime = ++instance->m_ModificationCounter;
         path_entry->m_IsOpenRead = 0;
         path_entry->m_IsOpenWrite = 1;
         hmput(instance->m_PathHashToContent, path_hash, (uint32_t)entry_index);
     }
     arrsetcap(path_entry->m_Content, initial_size == 0 ? 16 : (uint32_t)initial_size);
     arrsetlen(path_entry->m_Content, (uint32_t)initial_size);
+    path_entry->m_ModificationTime = ++instance->m_ModificationCounter;
     Longtail_UnlockSpinLock(instance->m_SpinLock);
     *out_open_file = (Longtail_StorageAPI_HOpenFile)(uintptr_t)path_hash;
     return 0;
@@ -383,6 +387,7 @@ static int InMemStorageAPI_Write(struct Longtail_StorageAPI* storage_api, Longta
     arrsetcap(path_entry->m_Content, size == 0 ? 16 : (uint32_t)size);
     arrsetlen(path_entry->m_Content, (uint32_t)size);
     memcpy(&(path_entry->m_Content)[offset], input, length);
+    path_entry->m_ModificationTime = ++instance->m_ModificationCounter;
     Longtail_UnlockSpinLock(instance->m_SpinLock);
     return 0;
 }
@@ -413,6 +418,7 @@ static int InMemStorageAPI_SetSize(struct Longtail_StorageAPI* storage_api, Long
     }
     struct PathEntry* path_entry = &instance->m_PathEntries[instance->m_PathHashToContent[it].value];
     arrsetlen(path_entry->m_Content, (uint32_t)length);
+    path_entry->m_ModificationTime = ++instance->m_ModificationCounter;
     Longtail_UnlockSpinLock(instance->m_SpinLock);
     return 0;
 }
@@ -569,6 +575,7 @@ static int InMemStorageAPI_CreateDir(struct Longtail_StorageAPI* storage_api, co
     path_entry->m_FileName = Longtail_Strdup(InMemStorageAPI_GetFileNamePart(path));
     path_entry->m_Content = 0;
     path_entry->m_Permissions = 0775;
+    path_entry->m_ModificationTime = ++instance->m_ModificationCounter;
     path_entry->m_IsOpenRead = 0;
     path_entry->m_IsOpenWrite = 0;
     hmput(instance->m_PathHashToContent, path_hash, (uint32_t)entry_index);
@@ -953,6 +960,7 @@ static int InMemStorageAPI_GetEntryProperties(struct Longtail_StorageAPI* storag
         out_properties->m_Size = (uint64_t)arrlen(instance->m_PathEntries[*i].m_Content);
         out_properties->m_IsDir = 0;
     }
+    out_properties->m_ModificationTime = instance->m_PathEntries[*i].m_ModificationTime;
     out_properties->m_Permissions = instance->m_PathEntries[*i].m_Permissions;
     out_properties->m_Name = instance->m_PathEntries[*i].m_FileName;
     return 0;
@@ -1007,6 +1015,7 @@ static int InMemStorageAPI_LockFile(struct Longtail_StorageAPI* storage_api, con
     path_entry->m_FileName = Longtail_Strdup(InMemStorageAPI_GetFileNamePart(path));
     path_entry->m_Content = 0;
     path_entry->m_Permissions = 0644;
+    path_entry->m_ModificationTime = ++instance->m_ModificationCounter;
     path_entry->m_IsOpenRead = 0;
     path_entry->m_IsOpenWrite = 2;
     hmput(instance->m_PathHashToContent, path_hash, (uint32_t)entry_index);
@@ -1097,6 +1106,7 @@ static int InMemStorageAPI_Init(
 
     storage_api->m_PathHashToContent = 0;
     storage_api->m_PathEntries = 0;
+    storage_api->m_ModificationCounter = 0;
     int err = Longtail_CreateSpinLock(&storage_api[1], &storage_api->m_SpinLock);
     if (err)
     {
@@ -59,6 +59,7 @@ static void MeowHash_Init(struct MeowHashAPI* hash_api)
     hash_api->m_MeowHashAPI.Hash = MeowHash_Hash;
     hash_api->m_MeowHashAPI.EndContext = MeowHash_EndContext;
     hash_api->m_MeowHashAPI.HashBuffer = MeowHash_HashBuffer;
+    hash_api->m_MeowHashAPI.HashBuffers = 0;
 }
 
 struct Longtail_HashAPI* Longtail_CreateMeowHashAPI()
@@ -0,0 +1,1243 @@
+#include "longtail_seedblockstore.h"
+
+#include "../../src/ext/stb_ds.h"
+#include "../longtail_platform.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Limits for the synthetic blocks created from seed chunks
+#define SEEDBLOCKSTORE_MAX_BLOCK_SIZE         (8u * 1024u * 1024u)
+#define SEEDBLOCKSTORE_MAX_CHUNKS_PER_BLOCK   1024u
+
+// The spin lock is placed right after the api struct, padded so the arrays that follow stay 8 byte aligned
+#define SEEDBLOCKSTORE_LOCK_SIZE              ((Longtail_GetSpinLockSize() + 7u) & ~((size_t)7u))
+
+struct SeedBlock
+{
+    struct Longtail_BlockIndex* m_BlockIndex;
+    uint32_t* m_ChunkIndexes;   // Chunk indexes in the seed version index, one per block chunk
+};
+
+struct BlockHashToSeedBlock
+{
+    TLongtail_Hash key;
+    struct SeedBlock* value;
+};
+
+struct SeedBlockStoreAPI
+{
+    struct Longtail_BlockStoreAPI m_BlockStoreAPI;
+    struct Longtail_BlockStoreAPI* m_BackingBlockStore;
+    struct Longtail_StorageAPI* m_StorageAPI;
+    struct Longtail_HashAPI* m_HashAPI;
+    const struct Longtail_VersionIndex* m_VersionIndex;
+    const char* m_SeedPath;
+
+    // First location of each version index chunk in the seed folder
+    uint64_t* m_ChunkAssetOffsets;
+    uint32_t* m_ChunkAssetIndexes;
+    struct Longtail_LookupTable* m_ChunkHashToChunkIndex;
+
+    HLongtail_SpinLock m_Lock;
+    struct BlockHashToSeedBlock* m_SeedBlocks;
+
+    TLongtail_Atomic64 m_StatU64[Longtail_BlockStoreAPI_StatU64_Count];
+
+    TLongtail_Atomic32 m_PendingRequestCount;
+};
+
+struct SeedChunkLocation
+{
+    uint32_t m_AssetIndex;
+    uint32_t m_ChunkIndex;
+    uint64_t m_Offset;
+};
+
+static int SeedChunkLocation_Compare(const void* a_ptr, const void* b_ptr)
+{
+    const struct SeedChunkLocation* a = (const struct SeedChunkLocation*)a_ptr;
+    const struct SeedChunkLocation* b = (const struct SeedChunkLocation*)b_ptr;
+    if (a->m_AssetIndex != b->m_AssetIndex)
+    {
+        return a->m_AssetIndex < b->m_AssetIndex ? -1 : 1;
+    }
+    if (a->m_Offset != b->m_Offset)
+    {
+        return a->m_Offset < b->m_Offset ? -1 : 1;
+    }
+    return 0;
+}
+
+static struct SeedBlock* SeedBlockStore_GetSeedBlock(struct SeedBlockStoreAPI* api, TLongtail_Hash block_hash)
+{
+    Longtail_LockSpinLock(api->m_Lock);
+    intptr_t find_ptr = hmgeti(api->m_SeedBlocks, block_hash);
+    struct SeedBlock* seed_block = (find_ptr == -1) ? 0 : api->m_SeedBlocks[find_ptr].value;
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return seed_block;
+}
+
+// Creates a block for the chunks and registers it, returns the registered block if one with the same hash already exists
+static int SeedBlockStore_AddSeedBlock(
+    struct SeedBlockStoreAPI* api,
+    uint32_t chunk_count,
+    const uint32_t* chunk_indexes,
+    struct SeedBlock** out_seed_block)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_indexes, "%p"),
+        LONGTAIL_LOGFIELD(out_seed_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct Longtail_BlockIndex* block_index;
+    int err = Longtail_CreateBlockIndex(
+        api->m_HashAPI,
+        0,
+        chunk_count,
+        chunk_indexes,
+        api->m_VersionIndex->m_ChunkHashes,
+        api->m_VersionIndex->m_ChunkSizes,
+        &block_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateBlockIndex() failed with %d", err)
+        return err;
+    }
+
+    TLongtail_Hash block_hash = *block_index->m_BlockHash;
+    Longtail_LockSpinLock(api->m_Lock);
+    intptr_t find_ptr = hmgeti(api->m_SeedBlocks, block_hash);
+    if (find_ptr != -1)
+    {
+        *out_seed_block = api->m_SeedBlocks[find_ptr].value;
+        Longtail_UnlockSpinLock(api->m_Lock);
+        Longtail_Free(block_index);
+        return 0;
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    struct SeedBlock* seed_block = (struct SeedBlock*)Longtail_Alloc("SeedBlockStoreAPI", sizeof(struct SeedBlock) + sizeof(uint32_t) * chunk_count);
+    if (!seed_block)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(block_index);
+        return ENOMEM;
+    }
+    seed_block->m_BlockIndex = block_index;
+    seed_block->m_ChunkIndexes = (uint32_t*)&seed_block[1];
+    memcpy(seed_block->m_ChunkIndexes, chunk_indexes, sizeof(uint32_t) * chunk_count);
+
+    Longtail_LockSpinLock(api->m_Lock);
+    find_ptr = hmgeti(api->m_SeedBlocks, block_hash);
+    if (find_ptr != -1)
+    {
+        *out_seed_block = api->m_SeedBlocks[find_ptr].value;
+        Longtail_UnlockSpinLock(api->m_Lock);
+        Longtail_Free(seed_block);
+        Longtail_Free(block_index);
+        return 0;
+    }
+    hmput(api->m_SeedBlocks, block_hash, seed_block);
+    Longtail_UnlockSpinLock(api->m_Lock);
+    *out_seed_block = seed_block;
+    return 0;
+}
+
+// Reads the block chunks from the seed folder, contiguous chunks in the same asset are read with a single read.
+// Block chunk indexes of chunks that do not match their hash are returned in out_bad_chunk_indexes (stb_ds array)
+static int SeedBlockStore_ReadSeedBlock(
+    struct SeedBlockStoreAPI* api,
+    const struct SeedBlock* seed_block,
+    struct Longtail_StoredBlock** out_stored_block,
+    uint32_t** out_bad_chunk_indexes)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(seed_block, "%p"),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p"),
+        LONGTAIL_LOGFIELD(out_bad_chunk_indexes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    const struct Longtail_VersionIndex* version_index = api->m_VersionIndex;
+    const struct Longtail_BlockIndex* block_index = seed_block->m_BlockIndex;
+    uint32_t chunk_count = *block_index->m_ChunkCount;
+
+    uint32_t block_data_size = 0;
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        block_data_size += block_index->m_ChunkSizes[c];
+    }
+
+    struct Longtail_StoredBlock* stored_block;
+    int err = Longtail_CreateStoredBlock(
+        *block_index->m_BlockHash,
+        *block_index->m_HashIdentifier,
+        chunk_count,
+        *block_index->m_Tag,
+        block_index->m_ChunkHashes,
+        block_index->m_ChunkSizes,
+        block_data_size,
+        &stored_block);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoredBlock() failed with %d", err)
+        return err;
+    }
+
+    uint8_t* block_data = (uint8_t*)stored_block->m_BlockData;
+    uint32_t open_asset_index = 0xffffffffu;
+    Longtail_StorageAPI_HOpenFile f = 0;
+    uint32_t write_offset = 0;
+    uint32_t c = 0;
+    while (c < chunk_count)
+    {
+        uint32_t chunk_index = seed_block->m_ChunkIndexes[c];
+        uint32_t asset_index = api->m_ChunkAssetIndexes[chunk_index];
+        uint64_t asset_offset = api->m_ChunkAssetOffsets[chunk_index];
+        uint64_t read_size = version_index->m_ChunkSizes[chunk_index];
+        ++c;
+        while (c < chunk_count)
+        {
+            uint32_t next_chunk_index = seed_block->m_ChunkIndexes[c];
+            if (api->m_ChunkAssetIndexes[next_chunk_index] != asset_index ||
+                api->m_ChunkAssetOffsets[next_chunk_index] != asset_offset + read_size)
+            {
+                break;
+            }
+            read_size += version_index->m_ChunkSizes[next_chunk_index];
+            ++c;
+        }
+
+        if (asset_index != open_asset_index)
+        {
+            if (f)
+            {
+                api->m_StorageAPI->CloseFile(api->m_StorageAPI, f);
+                f = 0;
+            }
+            const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[asset_index]];
+            char* full_path = api->m_StorageAPI->ConcatPath(api->m_StorageAPI, api->m_SeedPath, asset_path);
+            err = api->m_StorageAPI->OpenReadFile(api->m_StorageAPI, full_path, &f);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_StorageAPI->OpenReadFile() failed with %d", err)
+                Longtail_Free(full_path);
+                stored_block->Dispose(stored_block);
+                return err;
+            }
+            Longtail_Free(full_path);
+            open_asset_index = asset_index;
+        }
+
+        err = api->m_StorageAPI->Read(api->m_StorageAPI, f, asset_offset, read_size, &block_data[write_offset]);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_StorageAPI->Read() failed with %d", err)
+            api->m_StorageAPI->CloseFile(api->m_StorageAPI, f);
+            stored_block->Dispose(stored_block);
+            return err;
+        }
+        write_offset += (uint32_t)read_size;
+    }
+    if (f)
+    {
+        api->m_StorageAPI->CloseFile(api->m_StorageAPI, f);
+    }
+
+    // The seed folder may have changed since the version index was created, verify the chunk data
+    size_t verify_mem_size = sizeof(const void*) * chunk_count + sizeof(TLongtail_Hash) * chunk_count;
+    void* verify_mem = Longtail_Alloc("SeedBlockStoreAPI", verify_mem_size);
+    if (!verify_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        stored_block->Dispose(stored_block);
+        return ENOMEM;
+    }
+    TLongtail_Hash* chunk_hashes = (TLongtail_Hash*)verify_mem;
+    const void** chunk_datas = (const void**)&chunk_hashes[chunk_count];
+    uint32_t chunk_offset = 0;
+    for (uint32_t i = 0; i < chunk_count; ++i)
+    {
+        chunk_datas[i] = &block_data[chunk_offset];
+        chunk_offset += block_index->m_ChunkSizes[i];
+    }
+    err = Longtail_Hash_HashBuffers(api->m_HashAPI, chunk_count, block_index->m_ChunkSizes, chunk_datas, chunk_hashes);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Hash_HashBuffers() failed with %d", err)
+        Longtail_Free(verify_mem);
+        stored_block->Dispose(stored_block);
+        return err;
+    }
+    uint32_t* bad_chunk_indexes = 0;
+    for (uint32_t i = 0; i < chunk_count; ++i)
+    {
+        if (chunk_hashes[i] != block_index->m_ChunkHashes[i])
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Seed chunk 0x%" PRIx64 " does not match the seed folder content", block_index->m_ChunkHashes[i])
+            arrput(bad_chunk_indexes, i);
+        }
+    }
+    Longtail_Free(verify_mem);
+
+    *out_stored_block = stored_block;
+    *out_bad_chunk_indexes = bad_chunk_indexes;
+    return 0;
+}
+
+struct SeedBlockStore_RepairBlock;
+
+struct SeedBlockStore_RepairGetBlockAPI
+{
+    struct Longtail_AsyncGetStoredBlockAPI m_AsyncGetStoredBlockAPI;
+    struct SeedBlockStore_RepairBlock* m_RepairBlock;
+    uint32_t m_BlockSlot;
+};
+
+// Seed chunks that do not match the seed folder content are read from the backing store. The backing store is first asked
+// which blocks hold the chunks, those blocks are then read and the chunks are copied into the seed block
+struct SeedBlockStore_RepairBlock
+{
+    struct Longtail_AsyncGetExistingContentAPI m_AsyncGetExistingContentAPI;
+    struct SeedBlockStoreAPI* m_SeedBlockStoreAPI;
+    struct Longtail_StoredBlock* m_StoredBlock;
+    struct Longtail_AsyncGetStoredBlockAPI* m_AsyncCompleteAPI;
+    uint32_t m_BadChunkCount;
+    TLongtail_Hash* m_BadChunkHashes;
+    uint32_t* m_BadChunkOffsets;
+    uint32_t* m_BadChunkBlockSlots;
+    struct SeedBlockStore_RepairGetBlockAPI* m_GetBlockAPIs;
+    TLongtail_Atomic32 m_PendingCount;
+    int m_Err;
+};
+
+static void SeedBlockStore_RepairBlock_Complete(struct SeedBlockStore_RepairBlock* repair_block)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(repair_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    struct SeedBlockStoreAPI* api = repair_block->m_SeedBlockStoreAPI;
+    struct Longtail_StoredBlock* stored_block = repair_block->m_StoredBlock;
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api = repair_block->m_AsyncCompleteAPI;
+    int err = repair_block->m_Err;
+    if (repair_block->m_GetBlockAPIs)
+    {
+        Longtail_Free(repair_block->m_GetBlockAPIs);
+    }
+    Longtail_Free(repair_block);
+
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Reading seed chunks from backing store failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+        stored_block->Dispose(stored_block);
+        async_complete_api->OnComplete(async_complete_api, 0, err);
+        Longtail_AtomicAdd32(&api->m_PendingRequestCount, -1);
+        return;
+    }
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *stored_block->m_BlockIndex->m_ChunkCount);
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], Longtail_GetBlockIndexDataSize(*stored_block->m_BlockIndex->m_ChunkCount) + stored_block->m_BlockChunksDataSize);
+    async_complete_api->OnComplete(async_complete_api, stored_block, 0);
+    Longtail_AtomicAdd32(&api->m_PendingRequestCount, -1);
+}
+
+static void SeedBlockStore_RepairGetBlockAPI_OnComplete(struct Longtail_AsyncGetStoredBlockAPI* async_complete_api, struct Longtail_StoredBlock* stored_block, int err)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
+        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(err, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, async_complete_api != 0, return)
+    struct SeedBlockStore_RepairGetBlockAPI* get_block_api = (struct SeedBlockStore_RepairGetBlockAPI*)async_complete_api;
+    struct SeedBlockStore_RepairBlock* repair_block = get_block_api->m_RepairBlock;
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetStoredBlock() failed with %d", err)
+        repair_block->m_Err = err;
+    }
+    else
+    {
+        // Each bad chunk is copied from the one block it was assigned to
+        const struct Longtail_BlockIndex* block_index = stored_block->m_BlockIndex;
+        uint32_t block_chunk_count = *block_index->m_ChunkCount;
+        uint8_t* seed_block_data = (uint8_t*)repair_block->m_StoredBlock->m_BlockData;
+        for (uint32_t b = 0; b < repair_block->m_BadChunkCount; ++b)
+        {
+            if (repair_block->m_BadChunkBlockSlots[b] != get_block_api->m_BlockSlot)
+            {
+                continue;
+            }
+            uint32_t chunk_offset = 0;
+            uint32_t c = 0;
+            while (c < block_chunk_count && block_index->m_ChunkHashes[c] != repair_block->m_BadChunkHashes[b])
+            {
+                chunk_offset += block_index->m_ChunkSizes[c];
+                ++c;
+            }
+            if (c == block_chunk_count)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Chunk 0x%" PRIx64 " is not in block 0x%" PRIx64 ", failed with %d", repair_block->m_BadChunkHashes[b], *block_index->m_BlockHash, EBADF)
+                repair_block->m_Err = EBADF;
+                break;
+            }
+            memcpy(&seed_block_data[repair_block->m_BadChunkOffsets[b]], &((const uint8_t*)stored_block->m_BlockData)[chunk_offset], block_index->m_ChunkSizes[c]);
+        }
+        stored_block->Dispose(stored_block);
+    }
+    if (Longtail_AtomicAdd32(&repair_block->m_PendingCount, -1) == 0)
+    {
+        SeedBlockStore_RepairBlock_Complete(repair_block);
+    }
+}
+
+static void SeedBlockStore_RepairBlock_OnExistingContent(struct Longtail_AsyncGetExistingContentAPI* async_complete_api, struct Longtail_StoreIndex* store_index, int err)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(err, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, async_complete_api != 0, return)
+    struct SeedBlockStore_RepairBlock* repair_block = (struct SeedBlockStore_RepairBlock*)async_complete_api;
+    struct SeedBlockStoreAPI* api = repair_block->m_SeedBlockStoreAPI;
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetExistingContent() failed with %d", err)
+        repair_block->m_Err = err;
+        SeedBlockStore_RepairBlock_Complete(repair_block);
+        return;
+    }
+
+    // Assign each bad chunk to the first block in the store index that holds it
+    uint32_t bad_chunk_count = repair_block->m_BadChunkCount;
+    uint32_t block_count = *store_index->m_BlockCount;
+    uint32_t used_block_count = 0;
+    for (uint32_t b = 0; b < bad_chunk_count; ++b)
+    {
+        repair_block->m_BadChunkBlockSlots[b] = 0xffffffffu;
+    }
+    TLongtail_Hash* used_block_hashes = 0;
+    for (uint32_t block_index = 0; block_index < block_count; ++block_index)
+    {
+        uint32_t chunk_offset = store_index->m_BlockChunksOffsets[block_index];
+        uint32_t chunk_count = store_index->m_BlockChunkCounts[block_index];
+        int is_used = 0;
+        for (uint32_t b = 0; b < bad_chunk_count; ++b)
+        {
+            if (repair_block->m_BadChunkBlockSlots[b] != 0xffffffffu)
+            {
+                continue;
+            }
+            for (uint32_t c = 0; c < chunk_count; ++c)
+            {
+                if (store_index->m_ChunkHashes[chunk_offset + c] == repair_block->m_BadChunkHashes[b])
+                {
+                    repair_block->m_BadChunkBlockSlots[b] = used_block_count;
+                    is_used = 1;
+                    break;
+                }
+            }
+        }
+        if (is_used)
+        {
+            arrput(used_block_hashes, store_index->m_BlockHashes[block_index]);
+            ++used_block_count;
+        }
+    }
+    Longtail_Free(store_index);
+
+    for (uint32_t b = 0; b < bad_chunk_count; ++b)
+    {
+        if (repair_block->m_BadChunkBlockSlots[b] == 0xffffffffu)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Seed chunk 0x%" PRIx64 " does not match the seed folder content and is not in backing store, failed with %d", repair_block->m_BadChunkHashes[b], EBADF)
+            arrfree(used_block_hashes);
+            repair_block->m_Err = EBADF;
+            SeedBlockStore_RepairBlock_Complete(repair_block);
+            return;
+        }
+    }
+
+    repair_block->m_GetBlockAPIs = (struct SeedBlockStore_RepairGetBlockAPI*)Longtail_Alloc("SeedBlockStoreAPI", sizeof(struct SeedBlockStore_RepairGetBlockAPI) * used_block_count);
+    if (!repair_block->m_GetBlockAPIs)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        arrfree(used_block_hashes);
+        repair_block->m_Err = ENOMEM;
+        SeedBlockStore_RepairBlock_Complete(repair_block);
+        return;
+    }
+
+    // One extra pending count so the repair does not complete while requests are still being issued
+    repair_block->m_PendingCount = (int32_t)used_block_count + 1;
+    for (uint32_t u = 0; u < used_block_count; ++u)
+    {
+        struct SeedBlockStore_RepairGetBlockAPI* get_block_api = &repair_block->m_GetBlockAPIs[u];
+        get_block_api->m_AsyncGetStoredBlockAPI.m_API.Dispose = 0;
+        get_block_api->m_AsyncGetStoredBlockAPI.OnComplete = SeedBlockStore_RepairGetBlockAPI_OnComplete;
+        get_block_api->m_RepairBlock = repair_block;
+        get_block_api->m_BlockSlot = u;
+        err = api->m_BackingBlockStore->GetStoredBlock(api->m_BackingBlockStore, used_block_hashes[u], &get_block_api->m_AsyncGetStoredBlockAPI);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetStoredBlock() failed with %d", err)
+            repair_block->m_Err = err;
+            Longtail_AtomicAdd32(&repair_block->m_PendingCount, -1);
+        }
+    }
+    arrfree(used_block_hashes);
+    if (Longtail_AtomicAdd32(&repair_block->m_PendingCount, -1) == 0)
+    {
+        SeedBlockStore_RepairBlock_Complete(repair_block);
+    }
+}
+
+// Replaces the bad chunks of the seed block with chunks from the backing store, async_complete_api is called when done
+static int SeedBlockStore_RepairSeedBlock(
+    struct SeedBlockStoreAPI* api,
+    struct Longtail_StoredBlock* stored_block,
+    const uint32_t* bad_chunk_indexes,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(bad_chunk_indexes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    uint32_t bad_chunk_count = (uint32_t)arrlen(bad_chunk_indexes);
+    size_t repair_block_size = sizeof(struct SeedBlockStore_RepairBlock) +
+        sizeof(TLongtail_Hash) * bad_chunk_count +
+        sizeof(uint32_t) * bad_chunk_count +
+        sizeof(uint32_t) * bad_chunk_count;
+    struct SeedBlockStore_RepairBlock* repair_block = (struct SeedBlockStore_RepairBlock*)Longtail_Alloc("SeedBlockStoreAPI", repair_block_size);
+    if (!repair_block)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    repair_block->m_AsyncGetExistingContentAPI.m_API.Dispose = 0;
+    repair_block->m_AsyncGetExistingContentAPI.OnComplete = SeedBlockStore_RepairBlock_OnExistingContent;
+    repair_block->m_SeedBlockStoreAPI = api;
+    repair_block->m_StoredBlock = stored_block;
+    repair_block->m_AsyncCompleteAPI = async_complete_api;
+    repair_block->m_BadChunkCount = bad_chunk_count;
+    repair_block->m_BadChunkHashes = (TLongtail_Hash*)&repair_block[1];
+    repair_block->m_BadChunkOffsets = (uint32_t*)&repair_block->m_BadChunkHashes[bad_chunk_count];
+    repair_block->m_BadChunkBlockSlots = &repair_block->m_BadChunkOffsets[bad_chunk_count];
+    repair_block->m_GetBlockAPIs = 0;
+    repair_block->m_PendingCount = 0;
+    repair_block->m_Err = 0;
+
+    const struct Longtail_BlockIndex* block_index = stored_block->m_BlockIndex;
+    uint32_t chunk_offset = 0;
+    uint32_t b = 0;
+    for (uint32_t c = 0; c < *block_index->m_ChunkCount && b < bad_chunk_count; ++c)
+    {
+        if (bad_chunk_indexes[b] == c)
+        {
+            repair_block->m_BadChunkHashes[b] = block_index->m_ChunkHashes[c];
+            repair_block->m_BadChunkOffsets[b] = chunk_offset;
+            ++b;
+        }
+        chunk_offset += block_index->m_ChunkSizes[c];
+    }
+
+    Longtail_AtomicAdd32(&api->m_PendingRequestCount, 1);
+    int err = api->m_BackingBlockStore->GetExistingContent(
+        api->m_BackingBlockStore,
+        bad_chunk_count,
+        repair_block->m_BadChunkHashes,
+        0,
+        &repair_block->m_AsyncGetExistingContentAPI);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetExistingContent() failed with %d", err)
+        Longtail_Free(repair_block);
+        Longtail_AtomicAdd32(&api->m_PendingRequestCount, -1);
+        return err;
+    }
+    return 0;
+}
+
+static int SeedBlockStore_PutStoredBlock(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StoredBlock* stored_block,
+    struct Longtail_AsyncPutStoredBlockAPI* async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, stored_block, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Count], 1);
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_FailCount], 1);
+    return ENOTSUP;
+}
+
+static int SeedBlockStore_PreflightGet(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint32_t block_count,
+    const TLongtail_Hash* block_hashes,
+    struct Longtail_AsyncPreflightStartedAPI* optional_async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_count, "%u"),
+        LONGTAIL_LOGFIELD(block_hashes, "%p"),
+        LONGTAIL_LOGFIELD(optional_async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (block_count == 0) || (block_hashes != 0), return EINVAL)
+
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PreflightGet_Count], 1);
+
+    TLongtail_Hash* backing_block_hashes = (TLongtail_Hash*)Longtail_Alloc("SeedBlockStoreAPI", sizeof(TLongtail_Hash) * (block_count + 1));
+    if (!backing_block_hashes)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PreflightGet_FailCount], 1);
+        return ENOMEM;
+    }
+
+    // Seed blocks are read from the seed folder, only preflight the blocks of the backing store
+    uint32_t backing_block_count = 0;
+    Longtail_LockSpinLock(api->m_Lock);
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        if (hmgeti(api->m_SeedBlocks, block_hashes[b]) == -1)
+        {
+            backing_block_hashes[backing_block_count++] = block_hashes[b];
+        }
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    int err = 0;
+    if (backing_block_count > 0)
+    {
+        err = api->m_BackingBlockStore->PreflightGet(
+            api->m_BackingBlockStore,
+            backing_block_count,
+            backing_block_hashes,
+            0);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "api->m_BackingBlockStore->PreflightGet() failed with %d", err)
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PreflightGet_FailCount], 1);
+        }
+    }
+    if (optional_async_complete_api)
+    {
+        optional_async_complete_api->OnComplete(optional_async_complete_api, backing_block_count, backing_block_hashes, err);
+    }
+    Longtail_Free(backing_block_hashes);
+    return err;
+}
+
+static int SeedBlockStore_GetStoredBlock(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api->OnComplete, return EINVAL)
+
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count], 1);
+
+    struct SeedBlock* seed_block = SeedBlockStore_GetSeedBlock(api, block_hash);
+    if (!seed_block)
+    {
+        int err = api->m_BackingBlockStore->GetStoredBlock(
+            api->m_BackingBlockStore,
+            block_hash,
+            async_complete_api);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetStoredBlock() failed with %d", err)
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+        }
+        return err;
+    }
+
+    struct Longtail_StoredBlock* stored_block;
+    uint32_t* bad_chunk_indexes = 0;
+    int err = SeedBlockStore_ReadSeedBlock(api, seed_block, &stored_block, &bad_chunk_indexes);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SeedBlockStore_ReadSeedBlock() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+        return err;
+    }
+    if (bad_chunk_indexes)
+    {
+        // The seed folder changed since the seed version index was created
+        err = SeedBlockStore_RepairSeedBlock(api, stored_block, bad_chunk_indexes, async_complete_api);
+        arrfree(bad_chunk_indexes);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SeedBlockStore_RepairSeedBlock() failed with %d", err)
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+            stored_block->Dispose(stored_block);
+        }
+        return err;
+    }
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *stored_block->m_BlockIndex->m_ChunkCount);
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], Longtail_GetBlockIndexDataSize(*stored_block->m_BlockIndex->m_ChunkCount) + stored_block->m_BlockChunksDataSize);
+    async_complete_api->OnComplete(async_complete_api, stored_block, 0);
+    return 0;
+}
+
+static int SeedBlockStore_GetStoredBlockChunks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api->OnComplete, return EINVAL)
+
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)block_store_api;
+    if (SeedBlockStore_GetSeedBlock(api, block_hash))
+    {
+        // Seed blocks are read from the seed files in one go
+        return SeedBlockStore_GetStoredBlock(block_store_api, block_hash, async_complete_api);
+    }
+
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count], 1);
+    int err = Longtail_BlockStore_GetStoredBlockChunks(
+        api->m_BackingBlockStore,
+        block_hash,
+        chunk_count,
+        chunk_hashes,
+        async_complete_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BlockStore_GetStoredBlockChunks() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+    }
+    return err;
+}
+
+struct SeedBlockStore_AsyncGetExistingContentAPI
+{
+    struct Longtail_AsyncGetExistingContentAPI m_AsyncGetExistingContentAPI;
+    struct SeedBlockStoreAPI* m_SeedBlockStoreAPI;
+    struct Longtail_StoreIndex* m_SeedStoreIndex;
+    struct Longtail_AsyncGetExistingContentAPI* m_AsyncCompleteAPI;
+};
+
+static void SeedBlockStore_AsyncGetExistingContentAPI_OnComplete(struct Longtail_AsyncGetExistingContentAPI* async_complete_api, struct Longtail_StoreIndex* store_index, int err)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(err, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, async_complete_api != 0, return)
+    struct SeedBlockStore_AsyncGetExistingContentAPI* async_api = (struct SeedBlockStore_AsyncGetExistingContentAPI*)async_complete_api;
+    struct SeedBlockStoreAPI* api = async_api->m_SeedBlockStoreAPI;
+    struct Longtail_StoreIndex* seed_store_index = async_api->m_SeedStoreIndex;
+    struct Longtail_AsyncGetExistingContentAPI* final_async_complete_api = async_api->m_AsyncCompleteAPI;
+    Longtail_Free(async_api);
+
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetExistingContent() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_FailCount], 1);
+        Longtail_Free(seed_store_index);
+        final_async_complete_api->OnComplete(final_async_complete_api, 0, err);
+        Longtail_AtomicAdd32(&api->m_PendingRequestCount, -1);
+        return;
+    }
+
+    // Seed blocks go first so their chunks are picked over the same chunks in the backing store
+    struct Longtail_StoreIndex* merged_store_index;
+    err = Longtail_MergeStoreIndex(seed_store_index, store_index, &merged_store_index);
+    Longtail_Free(store_index);
+    Longtail_Free(seed_store_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_MergeStoreIndex() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_FailCount], 1);
+        final_async_complete_api->OnComplete(final_async_complete_api, 0, err);
+        Longtail_AtomicAdd32(&api->m_PendingRequestCount, -1);
+        return;
+    }
+    final_async_complete_api->OnComplete(final_async_complete_api, merged_store_index, 0);
+    Longtail_AtomicAdd32(&api->m_PendingRequestCount, -1);
+}
+
+// Packs the chunks found in the seed folder into seed blocks in asset layout order and creates a store index for them,
+// chunks not found in the seed folder are returned in out_remaining_chunk_hashes
+static int SeedBlockStore_CreateSeedStoreIndex(
+    struct SeedBlockStoreAPI* api,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    uint32_t* out_remaining_chunk_count,
+    TLongtail_Hash* out_remaining_chunk_hashes,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(out_remaining_chunk_count, "%p"),
+        LONGTAIL_LOGFIELD(out_remaining_chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    const struct Longtail_VersionIndex* version_index = api->m_VersionIndex;
+
+    size_t work_mem_size =
+        Longtail_LookupTable_GetSize(chunk_count) +
+        sizeof(struct SeedChunkLocation) * chunk_count +
+        sizeof(uint32_t) * chunk_count +
+        sizeof(const struct Longtail_BlockIndex*) * chunk_count;
+    void* work_mem = Longtail_Alloc("SeedBlockStoreAPI", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct Longtail_LookupTable* requested_chunks = Longtail_LookupTable_Create(work_mem, chunk_count, 0);
+    struct SeedChunkLocation* seed_chunks = (struct SeedChunkLocation*)((uint8_t*)work_mem + Longtail_LookupTable_GetSize(chunk_count));
+    const struct Longtail_BlockIndex** block_indexes = (const struct Longtail_BlockIndex**)&seed_chunks[chunk_count];
+    uint32_t* block_chunk_indexes = (uint32_t*)&block_indexes[chunk_count];
+
+    uint32_t seed_chunk_count = 0;
+    uint32_t remaining_chunk_count = 0;
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        TLongtail_Hash chunk_hash = chunk_hashes[c];
+        if (Longtail_LookupTable_PutUnique(requested_chunks, chunk_hash, c))
+        {
+            continue;
+        }
+        const uint32_t* chunk_index_ptr = Longtail_LookupTable_Get(api->m_ChunkHashToChunkIndex, chunk_hash);
+        if (chunk_index_ptr == 0 || api->m_ChunkAssetIndexes[*chunk_index_ptr] == 0xffffffffu)
+        {
+            out_remaining_chunk_hashes[remaining_chunk_count++] = chunk_hash;
+            continue;
+        }
+        struct SeedChunkLocation* seed_chunk = &seed_chunks[seed_chunk_count++];
+        seed_chunk->m_ChunkIndex = *chunk_index_ptr;
+        seed_chunk->m_AssetIndex = api->m_ChunkAssetIndexes[*chunk_index_ptr];
+        seed_chunk->m_Offset = api->m_ChunkAssetOffsets[*chunk_index_ptr];
+    }
+
+    qsort(seed_chunks, seed_chunk_count, sizeof(struct SeedChunkLocation), SeedChunkLocation_Compare);
+
+    uint32_t block_count = 0;
+    uint32_t c = 0;
+    while (c < seed_chunk_count)
+    {
+        uint32_t block_chunk_count = 0;
+        uint32_t block_size = 0;
+        while (c < seed_chunk_count && block_chunk_count < SEEDBLOCKSTORE_MAX_CHUNKS_PER_BLOCK)
+        {
+            uint32_t chunk_index = seed_chunks[c].m_ChunkIndex;
+            uint32_t chunk_size = version_index->m_ChunkSizes[chunk_index];
+            if (block_chunk_count > 0 && block_size + chunk_size > SEEDBLOCKSTORE_MAX_BLOCK_SIZE)
+            {
+                break;
+            }
+            block_chunk_indexes[block_chunk_count++] = chunk_index;
+            block_size += chunk_size;
+            ++c;
+        }
+        struct SeedBlock* seed_block;
+        int err = SeedBlockStore_AddSeedBlock(api, block_chunk_count, block_chunk_indexes, &seed_block);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SeedBlockStore_AddSeedBlock() failed with %d", err)
+            Longtail_Free(work_mem);
+            return err;
+        }
+        block_indexes[block_count++] = seed_block->m_BlockIndex;
+    }
+
+    int err = Longtail_CreateStoreIndexFromBlocks(block_count, block_indexes, out_store_index);
+    Longtail_Free(work_mem);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+        return err;
+    }
+    *out_remaining_chunk_count = remaining_chunk_count;
+    return 0;
+}
+
+static int SeedBlockStore_GetExistingContent(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    uint32_t min_block_usage_percent,
+    struct Longtail_AsyncGetExistingContentAPI* async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(min_block_usage_percent, "%u"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_Count], 1);
+
+    size_t async_api_size = sizeof(struct SeedBlockStore_AsyncGetExistingContentAPI) + sizeof(TLongtail_Hash) * chunk_count;
+    struct SeedBlockStore_AsyncGetExistingContentAPI* async_api = (struct SeedBlockStore_AsyncGetExistingContentAPI*)Longtail_Alloc("SeedBlockStoreAPI", async_api_size);
+    if (!async_api)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_FailCount], 1);
+        return ENOMEM;
+    }
+    TLongtail_Hash* remaining_chunk_hashes = (TLongtail_Hash*)&async_api[1];
+
+    uint32_t remaining_chunk_count = 0;
+    struct Longtail_StoreIndex* seed_store_index = 0;
+    if (chunk_count > 0)
+    {
+        int err = SeedBlockStore_CreateSeedStoreIndex(api, chunk_count, chunk_hashes, &remaining_chunk_count, remaining_chunk_hashes, &seed_store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SeedBlockStore_CreateSeedStoreIndex() failed with %d", err)
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_FailCount], 1);
+            Longtail_Free(async_api);
+            return err;
+        }
+    }
+
+    if (chunk_count > 0 && remaining_chunk_count == 0)
+    {
+        Longtail_Free(async_api);
+        async_complete_api->OnComplete(async_complete_api, seed_store_index, 0);
+        return 0;
+    }
+
+    if (seed_store_index == 0 || *seed_store_index->m_BlockCount == 0)
+    {
+        Longtail_Free(seed_store_index);
+        int err = api->m_BackingBlockStore->GetExistingContent(
+            api->m_BackingBlockStore,
+            chunk_count,
+            chunk_hashes,
+            min_block_usage_percent,
+            async_complete_api);
+        Longtail_Free(async_api);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetExistingContent() failed with %d", err)
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_FailCount], 1);
+        }
+        return err;
+    }
+
+    async_api->m_AsyncGetExistingContentAPI.m_API.Dispose = 0;
+    async_api->m_AsyncGetExistingContentAPI.OnComplete = SeedBlockStore_AsyncGetExistingContentAPI_OnComplete;
+    async_api->m_SeedBlockStoreAPI = api;
+    async_api->m_SeedStoreIndex = seed_store_index;
+    async_api->m_AsyncCompleteAPI = async_complete_api;
+
+    Longtail_AtomicAdd32(&api->m_PendingRequestCount, 1);
+    int err = api->m_BackingBlockStore->GetExistingContent(
+        api->m_BackingBlockStore,
+        remaining_chunk_count,
+        remaining_chunk_hashes,
+        min_block_usage_percent,
+        &async_api->m_AsyncGetExistingContentAPI);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetExistingContent() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_FailCount], 1);
+        Longtail_Free(seed_store_index);
+        Longtail_Free(async_api);
+        Longtail_AtomicAdd32(&api->m_PendingRequestCount, -1);
+        return err;
+    }
+    return 0;
+}
+
+static int SeedBlockStore_PruneBlocks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint32_t block_keep_count,
+    const TLongtail_Hash* block_keep_hashes,
+    struct Longtail_AsyncPruneBlocksAPI* async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_keep_count, "%u"),
+        LONGTAIL_LOGFIELD(block_keep_hashes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (block_keep_count == 0) || (block_keep_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+    return ENOTSUP;
+}
+
+static int SeedBlockStore_GetStats(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_BlockStore_Stats* out_stats)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(out_stats, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_stats, return EINVAL)
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStats_Count], 1);
+    memset(out_stats, 0, sizeof(struct Longtail_BlockStore_Stats));
+    for (uint32_t s = 0; s < Longtail_BlockStoreAPI_StatU64_Count; ++s)
+    {
+        out_stats->m_StatU64[s] = api->m_StatU64[s];
+    }
+    return 0;
+}
+
+static int SeedBlockStore_Flush(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_AsyncFlushAPI* async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_Flush_Count], 1);
+    int err = api->m_BackingBlockStore->Flush(api->m_BackingBlockStore, async_complete_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->Flush() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_Flush_FailCount], 1);
+    }
+    return err;
+}
+
+static void SeedBlockStore_Dispose(struct Longtail_API* base_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(base_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, base_api, return)
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)base_api;
+    while (api->m_PendingRequestCount > 0)
+    {
+        Longtail_Sleep(1000);
+        if (api->m_PendingRequestCount > 0)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Waiting for %d pending requests", (int32_t)api->m_PendingRequestCount);
+        }
+    }
+    size_t seed_block_count = hmlen(api->m_SeedBlocks);
+    for (size_t b = 0; b < seed_block_count; ++b)
+    {
+        struct SeedBlock* seed_block = api->m_SeedBlocks[b].value;
+        Longtail_Free(seed_block->m_BlockIndex);
+        Longtail_Free(seed_block);
+    }
+    hmfree(api->m_SeedBlocks);
+    Longtail_DeleteSpinLock(api->m_Lock);
+    Longtail_Free(api);
+}
+
+static int SeedBlockStore_Init(
+    void* mem,
+    struct Longtail_StorageAPI* seed_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    const char* seed_path,
+    const struct Longtail_VersionIndex* seed_version_index,
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    struct Longtail_BlockStoreAPI** out_block_store_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(mem, "%p"),
+        LONGTAIL_LOGFIELD(seed_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(seed_path, "%s"),
+        LONGTAIL_LOGFIELD(seed_version_index, "%p"),
+        LONGTAIL_LOGFIELD(backing_block_store, "%p"),
+        LONGTAIL_LOGFIELD(out_block_store_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, mem, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, out_block_store_api, return EINVAL)
+
+    struct Longtail_BlockStoreAPI* block_store_api = Longtail_MakeBlockStoreAPI(
+        mem,
+        SeedBlockStore_Dispose,
+        SeedBlockStore_PutStoredBlock,
+        SeedBlockStore_PreflightGet,
+        SeedBlockStore_GetStoredBlock,
+        SeedBlockStore_GetExistingContent,
+        SeedBlockStore_PruneBlocks,
+        SeedBlockStore_GetStats,
+        SeedBlockStore_Flush);
+    if (!block_store_api)
+    {
+        return EINVAL;
+    }
+
+    block_store_api->GetStoredBlockChunks = SeedBlockStore_GetStoredBlockChunks;
+
+    uint32_t asset_count = *seed_version_index->m_AssetCount;
+    uint32_t chunk_count = *seed_version_index->m_ChunkCount;
+
+    struct SeedBlockStoreAPI* api = (struct SeedBlockStoreAPI*)block_store_api;
+    api->m_BackingBlockStore = backing_block_store;
+    api->m_StorageAPI = seed_storage_api;
+    api->m_HashAPI = hash_api;
+    api->m_VersionIndex = seed_version_index;
+    void* lock_mem = &api[1];
+    api->m_ChunkAssetOffsets = (uint64_t*)((uint8_t*)lock_mem + SEEDBLOCKSTORE_LOCK_SIZE);
+    api->m_ChunkHashToChunkIndex = Longtail_LookupTable_Create(&api->m_ChunkAssetOffsets[chunk_count], chunk_count, 0);
+    api->m_ChunkAssetIndexes = (uint32_t*)((uint8_t*)api->m_ChunkHashToChunkIndex + Longtail_LookupTable_GetSize(chunk_count));
+    api->m_SeedPath = (const char*)&api->m_ChunkAssetIndexes[chunk_count];
+    strcpy((char*)api->m_SeedPath, seed_path);
+    api->m_SeedBlocks = 0;
+    api->m_PendingRequestCount = 0;
+
+    for (uint32_t s = 0; s < Longtail_BlockStoreAPI_StatU64_Count; ++s)
+    {
+        api->m_StatU64[s] = 0;
+    }
+
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        api->m_ChunkAssetIndexes[c] = 0xffffffffu;
+        api->m_ChunkAssetOffsets[c] = 0;
+        Longtail_LookupTable_Put(api->m_ChunkHashToChunkIndex, seed_version_index->m_ChunkHashes[c], c);
+    }
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        uint32_t asset_chunk_start = seed_version_index->m_AssetChunkIndexStarts[a];
+        uint32_t asset_chunk_count = seed_version_index->m_AssetChunkCounts[a];
+        uint64_t asset_offset = 0;
+        for (uint32_t i = 0; i < asset_chunk_count; ++i)
+        {
+            uint32_t chunk_index = seed_version_index->m_AssetChunkIndexes[asset_chunk_start + i];
+            if (api->m_ChunkAssetIndexes[chunk_index] == 0xffffffffu)
+            {
+                api->m_ChunkAssetIndexes[chunk_index] = a;
+                api->m_ChunkAssetOffsets[chunk_index] = asset_offset;
+            }
+            asset_offset += seed_version_index->m_ChunkSizes[chunk_index];
+        }
+    }
+
+    int err = Longtail_CreateSpinLock(lock_mem, &api->m_Lock);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateSpinLock() failed with %d", err)
+        return err;
+    }
+    *out_block_store_api = block_store_api;
+    return 0;
+}
+
+struct Longtail_BlockStoreAPI* Longtail_CreateSeedBlockStoreAPI(
+    struct Longtail_StorageAPI* seed_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    const char* seed_path,
+    const struct Longtail_VersionIndex* seed_version_index,
+    struct Longtail_BlockStoreAPI* backing_block_store)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(seed_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(seed_path, "%s"),
+        LONGTAIL_LOGFIELD(seed_version_index, "%p"),
+        LONGTAIL_LOGFIELD(backing_block_store, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, seed_storage_api, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, seed_path, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, seed_version_index, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, backing_block_store, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, *seed_version_index->m_HashIdentifier == hash_api->GetIdentifier(hash_api), return 0)
+
+    uint32_t chunk_count = *seed_version_index->m_ChunkCount;
+    size_t api_size =
+        sizeof(struct SeedBlockStoreAPI) +
+        SEEDBLOCKSTORE_LOCK_SIZE +
+        sizeof(uint64_t) * chunk_count +
+        Longtail_LookupTable_GetSize(chunk_count) +
+        sizeof(uint32_t) * chunk_count +
+        strlen(seed_path) + 1;
+    void* mem = Longtail_Alloc("SeedBlockStoreAPI", api_size);
+    if (!mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
+    struct Longtail_BlockStoreAPI* block_store_api;
+    int err = SeedBlockStore_Init(
+        mem,
+        seed_storage_api,
+        hash_api,
+        seed_path,
+        seed_version_index,
+        backing_block_store,
+        &block_store_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SeedBlockStore_Init() failed with %d", err)
+        Longtail_Free(mem);
+        return 0;
+    }
+    return block_store_api;
+}
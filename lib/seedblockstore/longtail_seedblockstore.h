@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../../src/longtail.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Read-only block store that serves chunks found in seed_version_index by reading them from the
+// files in seed_path, all other chunks are fetched from backing_block_store. The seed folder must
+// not change while the store is in use and seed_version_index must outlive the store
+LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateSeedBlockStoreAPI(
+    struct Longtail_StorageAPI* seed_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    const char* seed_path,
+    const struct Longtail_VersionIndex* seed_version_index,
+    struct Longtail_BlockStoreAPI* backing_block_store);
+
+#ifdef __cplusplus
+}
+#endif
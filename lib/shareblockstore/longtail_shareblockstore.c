@@ -379,6 +379,43 @@ static int ShareBlockStore_GetStoredBlock(
     return 0;
 }
 
+static int ShareBlockStore_GetStoredBlockChunks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api->OnComplete, return EINVAL)
+    struct ShareBlockStoreAPI* api = (struct ShareBlockStoreAPI*)block_store_api;
+
+    // A partial block can not be shared with other requests, only share blocks that are already fetched in full
+    Longtail_LockSpinLock(api->m_Lock);
+    intptr_t find_block_ptr = hmgeti(api->m_BlockHashToSharedStoredBlock, block_hash);
+    if (find_block_ptr == -1)
+    {
+        Longtail_UnlockSpinLock(api->m_Lock);
+        return Longtail_BlockStore_GetStoredBlockChunks(api->m_BackingBlockStore, block_hash, chunk_count, chunk_hashes, async_complete_api);
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return ShareBlockStore_GetStoredBlock(block_store_api, block_hash, async_complete_api);
+}
+
 static int ShareBlockStore_GetExistingContent(
     struct Longtail_BlockStoreAPI* block_store_api,
     uint32_t chunk_count,
@@ -528,6 +565,7 @@ static int ShareBlockStore_Init(
     {
         return EINVAL;
     }
+    block_store_api->GetStoredBlockChunks = ShareBlockStore_GetStoredBlockChunks;
 
     struct ShareBlockStoreAPI* api = (struct ShareBlockStoreAPI*)block_store_api;
     api->m_BackingBlockStore = backing_block_store;
@@ -1,10 +1,14 @@
 #include "longtail_zstd.h"
 
+#include "../../src/ext/stb_ds.h"
+#include "../longtail_platform.h"
 #include "ext/zstd.h"
 #include "ext/zstd_errors.h"
 
 #include <errno.h>
 #include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
 
 
 const int LONGTAIL_ZSTD_MIN_COMPRESSION_LEVEL      = 0;
@@ -19,6 +23,29 @@ uint32_t Longtail_GetZStdMinQuality() { return LONGTAIL_ZSTD_MIN_COMPRESSION_TYP
 uint32_t Longtail_GetZStdDefaultQuality() { return LONGTAIL_ZSTD_DEFAULT_COMPRESSION_TYPE; }
 uint32_t Longtail_GetZStdMaxQuality() { return LONGTAIL_ZSTD_MAX_COMPRESSION_TYPE; }
 
+#define LONGTAIL_ZSTD_DICTIONARY_COMPRESSION_TYPE_BASE  ((((uint32_t)'z') << 24) + (((uint32_t)'d') << 16))
+#define LONGTAIL_ZSTD_DICTIONARY_ID_MASK                0xffffu
+#define LONGTAIL_ZSTD_IS_DICTIONARY_TYPE(settings_id)   (((settings_id) & ~LONGTAIL_ZSTD_DICTIONARY_ID_MASK) == LONGTAIL_ZSTD_DICTIONARY_COMPRESSION_TYPE_BASE)
+
+// Skippable frame holding the dictionary id: [magic, payload size = 4, dictionary id], all little endian
+#define LONGTAIL_ZSTD_DICTIONARY_FRAME_MAGIC            (ZSTD_MAGIC_SKIPPABLE_START + 0xd)
+#define LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE             12u
+
+uint32_t Longtail_GetZStdDictionaryQuality(uint32_t dictionary_id) { return LONGTAIL_ZSTD_DICTIONARY_COMPRESSION_TYPE_BASE + (dictionary_id & LONGTAIL_ZSTD_DICTIONARY_ID_MASK); }
+
+static void WriteU32LE(uint8_t* p, uint32_t value)
+{
+    p[0] = (uint8_t)(value);
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t ReadU32LE(const uint8_t* p)
+{
+    return ((uint32_t)p[0]) | (((uint32_t)p[1]) << 8) | (((uint32_t)p[2]) << 16) | (((uint32_t)p[3]) << 24);
+}
+
 static int SettingsIDToCompressionSetting(uint32_t settings_id)
 {
     switch(settings_id)
@@ -34,19 +61,130 @@ static int SettingsIDToCompressionSetting(uint32_t settings_id)
     }
 }
 
+struct ZStdDictionary
+{
+    uint32_t m_DictionaryID;
+    ZSTD_CDict* m_CDict;
+    ZSTD_DDict* m_DDict;
+};
+
+// Compression and decompression contexts are pooled and reused across calls, ZSTD_compress() and
+// ZSTD_decompress() allocate and initialize a new context on every call.
+// The pool keeps at most LONGTAIL_ZSTD_MAX_POOLED_CONTEXTS idle contexts of each kind, and a context that has
+// grown past LONGTAIL_ZSTD_MAX_POOLED_CONTEXT_SIZE (high compression levels, large blocks) is freed on release
+// rather than holding on to that memory for the lifetime of the API
+#define LONGTAIL_ZSTD_MAX_POOLED_CONTEXTS       16
+#define LONGTAIL_ZSTD_MAX_POOLED_CONTEXT_SIZE   (8u * 1024u * 1024u)
+
 struct ZStdCompressionAPI
 {
     struct Longtail_CompressionAPI m_ZStdCompressionAPI;
+    HLongtail_SpinLock m_Lock;
+    ZSTD_CCtx** m_FreeCCtxs;
+    ZSTD_DCtx** m_FreeDCtxs;
+    struct ZStdDictionary* m_Dictionaries;
 };
 
 void ZStdCompressionAPI_Dispose(struct Longtail_API* compression_api)
 {
+    struct ZStdCompressionAPI* api = (struct ZStdCompressionAPI*)compression_api;
+    for (ptrdiff_t i = 0; i < arrlen(api->m_FreeCCtxs); ++i)
+    {
+        ZSTD_freeCCtx(api->m_FreeCCtxs[i]);
+    }
+    arrfree(api->m_FreeCCtxs);
+    for (ptrdiff_t i = 0; i < arrlen(api->m_FreeDCtxs); ++i)
+    {
+        ZSTD_freeDCtx(api->m_FreeDCtxs[i]);
+    }
+    arrfree(api->m_FreeDCtxs);
+    for (ptrdiff_t i = 0; i < arrlen(api->m_Dictionaries); ++i)
+    {
+        ZSTD_freeCDict(api->m_Dictionaries[i].m_CDict);
+        ZSTD_freeDDict(api->m_Dictionaries[i].m_DDict);
+    }
+    arrfree(api->m_Dictionaries);
+    Longtail_DeleteSpinLock(api->m_Lock);
     Longtail_Free(compression_api);
 }
 
+static ZSTD_CCtx* ZStdCompressionAPI_AcquireCCtx(struct ZStdCompressionAPI* api)
+{
+    ZSTD_CCtx* cctx = 0;
+    Longtail_LockSpinLock(api->m_Lock);
+    if (arrlen(api->m_FreeCCtxs) > 0)
+    {
+        cctx = arrpop(api->m_FreeCCtxs);
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return cctx ? cctx : ZSTD_createCCtx();
+}
+
+static void ZStdCompressionAPI_ReleaseCCtx(struct ZStdCompressionAPI* api, ZSTD_CCtx* cctx)
+{
+    if (ZSTD_sizeof_CCtx(cctx) <= LONGTAIL_ZSTD_MAX_POOLED_CONTEXT_SIZE)
+    {
+        Longtail_LockSpinLock(api->m_Lock);
+        if (arrlen(api->m_FreeCCtxs) < LONGTAIL_ZSTD_MAX_POOLED_CONTEXTS)
+        {
+            arrput(api->m_FreeCCtxs, cctx);
+            Longtail_UnlockSpinLock(api->m_Lock);
+            return;
+        }
+        Longtail_UnlockSpinLock(api->m_Lock);
+    }
+    ZSTD_freeCCtx(cctx);
+}
+
+static ZSTD_DCtx* ZStdCompressionAPI_AcquireDCtx(struct ZStdCompressionAPI* api)
+{
+    ZSTD_DCtx* dctx = 0;
+    Longtail_LockSpinLock(api->m_Lock);
+    if (arrlen(api->m_FreeDCtxs) > 0)
+    {
+        dctx = arrpop(api->m_FreeDCtxs);
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return dctx ? dctx : ZSTD_createDCtx();
+}
+
+static void ZStdCompressionAPI_ReleaseDCtx(struct ZStdCompressionAPI* api, ZSTD_DCtx* dctx)
+{
+    if (ZSTD_sizeof_DCtx(dctx) <= LONGTAIL_ZSTD_MAX_POOLED_CONTEXT_SIZE)
+    {
+        Longtail_LockSpinLock(api->m_Lock);
+        if (arrlen(api->m_FreeDCtxs) < LONGTAIL_ZSTD_MAX_POOLED_CONTEXTS)
+        {
+            arrput(api->m_FreeDCtxs, dctx);
+            Longtail_UnlockSpinLock(api->m_Lock);
+            return;
+        }
+        Longtail_UnlockSpinLock(api->m_Lock);
+    }
+    ZSTD_freeDCtx(dctx);
+}
+
+// Dictionaries are never removed so the returned dictionary stays valid for the lifetime of the API
+static int ZStdCompressionAPI_FindDictionary(struct ZStdCompressionAPI* api, uint32_t dictionary_id, struct ZStdDictionary* out_dictionary)
+{
+    int found = 0;
+    Longtail_LockSpinLock(api->m_Lock);
+    for (ptrdiff_t i = 0; i < arrlen(api->m_Dictionaries); ++i)
+    {
+        if (api->m_Dictionaries[i].m_DictionaryID == dictionary_id)
+        {
+            *out_dictionary = api->m_Dictionaries[i];
+            found = 1;
+            break;
+        }
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return found;
+}
+
 static size_t ZStdCompressionAPI_GetMaxCompressedSize(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, size_t size)
 {
-    return ZSTD_COMPRESSBOUND(size);
+    return ZSTD_COMPRESSBOUND(size) + (LONGTAIL_ZSTD_IS_DICTIONARY_TYPE(settings_id) ? LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE : 0);
 }
 
 int ZStdCompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size)
@@ -65,12 +203,50 @@ int ZStdCompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api,
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
+    struct ZStdCompressionAPI* api = (struct ZStdCompressionAPI*)compression_api;
+    ZSTD_CCtx* cctx = ZStdCompressionAPI_AcquireCCtx(api);
+    if (!cctx)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createCCtx() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
+    if (LONGTAIL_ZSTD_IS_DICTIONARY_TYPE(settings_id))
+    {
+        uint32_t dictionary_id = settings_id & LONGTAIL_ZSTD_DICTIONARY_ID_MASK;
+        struct ZStdDictionary dictionary;
+        if (!ZStdCompressionAPI_FindDictionary(api, dictionary_id, &dictionary))
+        {
+            ZStdCompressionAPI_ReleaseCCtx(api, cctx);
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Dictionary %u is not registered, failed with %d", dictionary_id, ENOENT);
+            return ENOENT;
+        }
+        if (max_compressed_size < LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE)
+        {
+            ZStdCompressionAPI_ReleaseCCtx(api, cctx);
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Output buffer too small, failed with %d", ENOMEM);
+            return ENOMEM;
+        }
+        WriteU32LE((uint8_t*)&compressed[0], LONGTAIL_ZSTD_DICTIONARY_FRAME_MAGIC);
+        WriteU32LE((uint8_t*)&compressed[4], 4);
+        WriteU32LE((uint8_t*)&compressed[8], dictionary_id);
+        size_t size = ZSTD_compress_usingCDict(cctx, &compressed[LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE], max_compressed_size - LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE, uncompressed, uncompressed_size, dictionary.m_CDict);
+        ZStdCompressionAPI_ReleaseCCtx(api, cctx);
+        if (ZSTD_isError(size))
+        {
+            int err = ZSTD_getErrorCode(size);
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_compress_usingCDict() failed with %d", err);
+            return EINVAL;
+        }
+        *out_compressed_size = LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE + size;
+        return 0;
+    }
     int compression_setting = SettingsIDToCompressionSetting(settings_id);
-    size_t size = ZSTD_compress(compressed, max_compressed_size, uncompressed, uncompressed_size, compression_setting);
+    size_t size = ZSTD_compressCCtx(cctx, compressed, max_compressed_size, uncompressed, uncompressed_size, compression_setting);
+    ZStdCompressionAPI_ReleaseCCtx(api, cctx);
     if (ZSTD_isError(size))
     {
         int err = ZSTD_getErrorCode(size);
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_compress() failed with %d", err);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_compressCCtx() failed with %d", err);
         return EINVAL;
     }
     *out_compressed_size = size;
@@ -93,34 +269,375 @@ int ZStdCompressionAPI_Decompress(struct Longtail_CompressionAPI* compression_ap
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    size_t size = ZSTD_decompress(uncompressed, max_uncompressed_size, compressed, compressed_size);
+    struct ZStdCompressionAPI* api = (struct ZStdCompressionAPI*)compression_api;
+    ZSTD_DCtx* dctx = ZStdCompressionAPI_AcquireDCtx(api);
+    if (!dctx)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createDCtx() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
+    size_t size;
+    const uint8_t* header = (const uint8_t*)compressed;
+    if (compressed_size >= LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE &&
+        ReadU32LE(&header[0]) == LONGTAIL_ZSTD_DICTIONARY_FRAME_MAGIC &&
+        ReadU32LE(&header[4]) == 4)
+    {
+        uint32_t dictionary_id = ReadU32LE(&header[8]);
+        struct ZStdDictionary dictionary;
+        if (!ZStdCompressionAPI_FindDictionary(api, dictionary_id, &dictionary))
+        {
+            ZStdCompressionAPI_ReleaseDCtx(api, dctx);
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Dictionary %u is not registered, failed with %d", dictionary_id, ENOENT);
+            return ENOENT;
+        }
+        size = ZSTD_decompress_usingDDict(dctx, uncompressed, max_uncompressed_size, &compressed[LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE], compressed_size - LONGTAIL_ZSTD_DICTIONARY_FRAME_SIZE, dictionary.m_DDict);
+    }
+    else
+    {
+        size = ZSTD_decompressDCtx(dctx, uncompressed, max_uncompressed_size, compressed, compressed_size);
+    }
+    ZStdCompressionAPI_ReleaseDCtx(api, dctx);
     if (ZSTD_isError(size))
     {
         int err = ZSTD_getErrorCode(size);
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_decompress() failed with %d", err);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_decompressDCtx() failed with %d", err);
         return EINVAL;
     }
     *out_uncompressed_size = size;
     return 0;
 }
 
-static void ZStdCompressionAPI_Init(struct ZStdCompressionAPI* compression_api)
+static int ZStdCompressionAPI_Init(struct ZStdCompressionAPI* compression_api)
 {
     compression_api->m_ZStdCompressionAPI.m_API.Dispose = ZStdCompressionAPI_Dispose;
     compression_api->m_ZStdCompressionAPI.GetMaxCompressedSize = ZStdCompressionAPI_GetMaxCompressedSize;
     compression_api->m_ZStdCompressionAPI.Compress = ZStdCompressionAPI_Compress;
     compression_api->m_ZStdCompressionAPI.Decompress = ZStdCompressionAPI_Decompress;
+    compression_api->m_FreeCCtxs = 0;
+    compression_api->m_FreeDCtxs = 0;
+    compression_api->m_Dictionaries = 0;
+    return Longtail_CreateSpinLock(&compression_api[1], &compression_api->m_Lock);
 }
 
 struct Longtail_CompressionAPI* Longtail_CreateZStdCompressionAPI()
 {
     MAKE_LOG_CONTEXT(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-    struct ZStdCompressionAPI* compression_api = (struct ZStdCompressionAPI*)Longtail_Alloc("ZStdCompressionAPI", sizeof(struct ZStdCompressionAPI));
+    struct ZStdCompressionAPI* compression_api = (struct ZStdCompressionAPI*)Longtail_Alloc("ZStdCompressionAPI", sizeof(struct ZStdCompressionAPI) + Longtail_GetSpinLockSize());
     if (!compression_api)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return 0;
     }
-    ZStdCompressionAPI_Init(compression_api);
+    int err = ZStdCompressionAPI_Init(compression_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZStdCompressionAPI_Init() failed with %d", err)
+        Longtail_Free(compression_api);
+        return 0;
+    }
     return &compression_api->m_ZStdCompressionAPI;
 }
+
+int Longtail_ZStdBuildDictionary(
+    uint32_t sample_count,
+    const void* const* samples,
+    const uint32_t* sample_sizes,
+    uint32_t max_dictionary_size,
+    void** out_dictionary,
+    uint32_t* out_dictionary_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(sample_count, "%u"),
+        LONGTAIL_LOGFIELD(samples, "%p"),
+        LONGTAIL_LOGFIELD(sample_sizes, "%p"),
+        LONGTAIL_LOGFIELD(max_dictionary_size, "%u"),
+        LONGTAIL_LOGFIELD(out_dictionary, "%p"),
+        LONGTAIL_LOGFIELD(out_dictionary_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, (sample_count == 0) || (samples != 0 && sample_sizes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, max_dictionary_size > 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_dictionary != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_dictionary_size != 0, return EINVAL)
+
+    // Pick samples from the back, a sample that does not fit is skipped in favour of smaller earlier ones
+    uint32_t dictionary_size = 0;
+    for (uint32_t s = sample_count; s-- > 0;)
+    {
+        if (sample_sizes[s] <= max_dictionary_size - dictionary_size)
+        {
+            dictionary_size += sample_sizes[s];
+        }
+    }
+    if (dictionary_size == 0)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "No samples fit in the dictionary, failed with %d", EINVAL)
+        return EINVAL;
+    }
+    uint8_t* dictionary = (uint8_t*)Longtail_Alloc("ZStdDictionary", dictionary_size);
+    if (!dictionary)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    uint32_t offset = dictionary_size;
+    for (uint32_t s = sample_count; s-- > 0;)
+    {
+        if (sample_sizes[s] <= offset)
+        {
+            offset -= sample_sizes[s];
+            memcpy(&dictionary[offset], samples[s], sample_sizes[s]);
+        }
+    }
+    LONGTAIL_FATAL_ASSERT(ctx, offset == 0, return EINVAL)
+    *out_dictionary = dictionary;
+    *out_dictionary_size = dictionary_size;
+    return 0;
+}
+
+int Longtail_ZStdAddDictionary(
+    struct Longtail_CompressionAPI* compression_api,
+    uint32_t dictionary_id,
+    const void* dictionary,
+    uint32_t dictionary_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_api, "%p"),
+        LONGTAIL_LOGFIELD(dictionary_id, "%u"),
+        LONGTAIL_LOGFIELD(dictionary, "%p"),
+        LONGTAIL_LOGFIELD(dictionary_size, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, compression_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary_id <= LONGTAIL_ZSTD_DICTIONARY_ID_MASK, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary_size > 0, return EINVAL)
+
+    struct ZStdCompressionAPI* api = (struct ZStdCompressionAPI*)compression_api;
+    struct ZStdDictionary existing_dictionary;
+    if (ZStdCompressionAPI_FindDictionary(api, dictionary_id, &existing_dictionary))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Dictionary is already registered, failed with %d", EEXIST)
+        return EEXIST;
+    }
+
+    struct ZStdDictionary new_dictionary;
+    new_dictionary.m_DictionaryID = dictionary_id;
+    new_dictionary.m_CDict = ZSTD_createCDict(dictionary, dictionary_size, LONGTAIL_ZSTD_DEFAULT_COMPRESSION_LEVEL);
+    new_dictionary.m_DDict = ZSTD_createDDict(dictionary, dictionary_size);
+    if (!new_dictionary.m_CDict || !new_dictionary.m_DDict)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createCDict() failed with %d", ENOMEM)
+        ZSTD_freeCDict(new_dictionary.m_CDict);
+        ZSTD_freeDDict(new_dictionary.m_DDict);
+        return ENOMEM;
+    }
+    Longtail_LockSpinLock(api->m_Lock);
+    arrput(api->m_Dictionaries, new_dictionary);
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return 0;
+}
+
+static char* GetDictionaryPath(struct Longtail_StorageAPI* storage_api, const char* dictionary_folder, uint32_t dictionary_id)
+{
+    char file_name[16];
+    snprintf(file_name, sizeof(file_name), "%04x.zdict", dictionary_id);
+    return storage_api->ConcatPath(storage_api, dictionary_folder, file_name);
+}
+
+int Longtail_ZStdWriteDictionary(
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder,
+    uint32_t dictionary_id,
+    const void* dictionary,
+    uint32_t dictionary_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(dictionary_folder, "%s"),
+        LONGTAIL_LOGFIELD(dictionary_id, "%u"),
+        LONGTAIL_LOGFIELD(dictionary, "%p"),
+        LONGTAIL_LOGFIELD(dictionary_size, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary_folder != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary_id <= LONGTAIL_ZSTD_DICTIONARY_ID_MASK, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary != 0, return EINVAL)
+
+    char* path = GetDictionaryPath(storage_api, dictionary_folder, dictionary_id);
+    if (!path)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->ConcatPath() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    int err = EnsureParentPathExists(storage_api, path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+        Longtail_Free(path);
+        return err;
+    }
+    Longtail_StorageAPI_HOpenFile f;
+    err = storage_api->OpenWriteFile(storage_api, path, 0, &f);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile() failed with %d", err)
+        Longtail_Free(path);
+        return err;
+    }
+    err = storage_api->Write(storage_api, f, 0, dictionary_size, dictionary);
+    storage_api->CloseFile(storage_api, f);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
+        storage_api->RemoveFile(storage_api, path);
+    }
+    Longtail_Free(path);
+    return err;
+}
+
+static int ReadDictionary(
+    struct Longtail_CompressionAPI* compression_api,
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder,
+    uint32_t dictionary_id)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_api, "%p"),
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(dictionary_folder, "%s"),
+        LONGTAIL_LOGFIELD(dictionary_id, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    char* path = GetDictionaryPath(storage_api, dictionary_folder, dictionary_id);
+    if (!path)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->ConcatPath() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    Longtail_StorageAPI_HOpenFile f;
+    int err = storage_api->OpenReadFile(storage_api, path, &f);
+    Longtail_Free(path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+        return err;
+    }
+    uint64_t size;
+    err = storage_api->GetSize(storage_api, f, &size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetSize() failed with %d", err)
+        storage_api->CloseFile(storage_api, f);
+        return err;
+    }
+    if (size == 0 || size > 0xffffffffu)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Dictionary size %" PRIu64 " is invalid, failed with %d", size, EBADF)
+        storage_api->CloseFile(storage_api, f);
+        return EBADF;
+    }
+    void* dictionary = Longtail_Alloc("ZStdDictionary", (size_t)size);
+    if (!dictionary)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        storage_api->CloseFile(storage_api, f);
+        return ENOMEM;
+    }
+    err = storage_api->Read(storage_api, f, 0, size, dictionary);
+    storage_api->CloseFile(storage_api, f);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
+        Longtail_Free(dictionary);
+        return err;
+    }
+    err = Longtail_ZStdAddDictionary(compression_api, dictionary_id, dictionary, (uint32_t)size);
+    Longtail_Free(dictionary);
+    return err;
+}
+
+int Longtail_ZStdLoadDictionaries(
+    struct Longtail_CompressionAPI* compression_api,
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder,
+    uint32_t* out_dictionary_count,
+    uint32_t** out_dictionary_ids)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_api, "%p"),
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(dictionary_folder, "%s"),
+        LONGTAIL_LOGFIELD(out_dictionary_count, "%p"),
+        LONGTAIL_LOGFIELD(out_dictionary_ids, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, compression_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary_folder != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_dictionary_count != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_dictionary_ids != 0, return EINVAL)
+
+    // Collect the ids first, the storage may not allow other calls while iterating
+    uint32_t* dictionary_ids = 0;
+    Longtail_StorageAPI_HIterator it;
+    int err = storage_api->StartFind(storage_api, dictionary_folder, &it);
+    if (err == 0)
+    {
+        while (err == 0)
+        {
+            struct Longtail_StorageAPI_EntryProperties properties;
+            err = storage_api->GetEntryProperties(storage_api, it, &properties);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetEntryProperties() failed with %d", err)
+                break;
+            }
+            unsigned int dictionary_id;
+            char extension[7];
+            if (!properties.m_IsDir &&
+                strlen(properties.m_Name) == 10 &&
+                sscanf(properties.m_Name, "%4x.%5s", &dictionary_id, extension) == 2 &&
+                strcmp(extension, "zdict") == 0)
+            {
+                arrput(dictionary_ids, (uint32_t)dictionary_id);
+            }
+            err = storage_api->FindNext(storage_api, it);
+        }
+        storage_api->CloseFind(storage_api, it);
+    }
+    if (err != ENOENT)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Listing dictionaries failed with %d", err)
+        arrfree(dictionary_ids);
+        return err;
+    }
+
+    uint32_t dictionary_count = (uint32_t)arrlen(dictionary_ids);
+    for (uint32_t d = 0; d < dictionary_count; ++d)
+    {
+        err = ReadDictionary(compression_api, storage_api, dictionary_folder, dictionary_ids[d]);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ReadDictionary() failed with %d", err)
+            arrfree(dictionary_ids);
+            return err;
+        }
+    }
+    uint32_t* result_ids = (uint32_t*)Longtail_Alloc("ZStdDictionary", sizeof(uint32_t) * (dictionary_count + 1));
+    if (!result_ids)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        arrfree(dictionary_ids);
+        return ENOMEM;
+    }
+    if (dictionary_count > 0)
+    {
+        memcpy(result_ids, dictionary_ids, sizeof(uint32_t) * dictionary_count);
+    }
+    arrfree(dictionary_ids);
+    *out_dictionary_count = dictionary_count;
+    *out_dictionary_ids = result_ids;
+    return 0;
+}
@@ -12,6 +12,45 @@ LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdMinQuality();
 LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdDefaultQuality();
 LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdMaxQuality();
 
+// Compression type for content compressed with the dictionary registered as dictionary_id, which must be below 65536.
+// The dictionary id is written in a skippable frame ahead of the compressed data so decompression can find it
+LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdDictionaryQuality(uint32_t dictionary_id);
+
+// Builds a raw content dictionary of at most max_dictionary_size bytes from sample chunks of similar content.
+// Later samples are placed closer to the end of the dictionary where matches are cheapest to reference.
+// out_dictionary is allocated with Longtail_Alloc()
+LONGTAIL_EXPORT extern int Longtail_ZStdBuildDictionary(
+    uint32_t sample_count,
+    const void* const* samples,
+    const uint32_t* sample_sizes,
+    uint32_t max_dictionary_size,
+    void** out_dictionary,
+    uint32_t* out_dictionary_size);
+
+// Registers a dictionary with a compression API created by Longtail_CreateZStdCompressionAPI()
+LONGTAIL_EXPORT extern int Longtail_ZStdAddDictionary(
+    struct Longtail_CompressionAPI* compression_api,
+    uint32_t dictionary_id,
+    const void* dictionary,
+    uint32_t dictionary_size);
+
+// Dictionaries are stored alongside a block store as <dictionary_folder>/<dictionary_id>.zdict
+LONGTAIL_EXPORT extern int Longtail_ZStdWriteDictionary(
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder,
+    uint32_t dictionary_id,
+    const void* dictionary,
+    uint32_t dictionary_size);
+
+// Registers all dictionaries in dictionary_folder with compression_api, a missing folder holds no dictionaries.
+// out_dictionary_ids is allocated with Longtail_Alloc()
+LONGTAIL_EXPORT extern int Longtail_ZStdLoadDictionaries(
+    struct Longtail_CompressionAPI* compression_api,
+    struct Longtail_StorageAPI* storage_api,
+    const char* dictionary_folder,
+    uint32_t* out_dictionary_count,
+    uint32_t** out_dictionary_ids);
+
 #ifdef __cplusplus
 }
 #endif
@@ -46,6 +46,8 @@ void Longtail_NukeFree(void* p);
 #define LONGTAIL_VERSION_INDEX_VERSION_0_0_2  LONGTAIL_VERSION(0,0,2)
 #define LONGTAIL_STORE_INDEX_VERSION_1_0_0    LONGTAIL_VERSION(1,0,0)
 #define LONGTAIL_ARCHIVE_VERSION_0_0_1        LONGTAIL_VERSION(0,0,1)
+#define LONGTAIL_FILE_INFOS_VERSION_0_0_1     LONGTAIL_VERSION(0,0,1)
+#define LONGTAIL_FILE_INFOS_TAG               0x4946544cu  // "LTFI"
 
 uint32_t Longtail_CurrentVersionIndexVersion = LONGTAIL_VERSION_INDEX_VERSION_0_0_2;
 uint32_t Longtail_CurrentStoreIndexVersion = LONGTAIL_STORE_INDEX_VERSION_1_0_0;
@@ -134,6 +136,20 @@ uint64_t Longtail_GetHashAPISize()
     return sizeof(struct Longtail_HashAPI);
 }
 
+// Used for hash apis that can't hash buffers side by side, so HashBuffers is always callable
+static int HashAPI_HashBuffersFallback(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        int err = hash_api->HashBuffer(hash_api, lengths[i], datas[i], &out_hashes[i]);
+        if (err)
+        {
+            return err;
+        }
+    }
+    return 0;
+}
+
 struct Longtail_HashAPI* Longtail_MakeHashAPI(
     void* mem,
     Longtail_DisposeFunc dispose_func,
@@ -142,6 +158,27 @@ struct Longtail_HashAPI* Longtail_MakeHashAPI(
     Longtail_Hash_HashFunc hash_func,
     Longtail_Hash_EndContextFunc end_context_func,
     Longtail_Hash_HashBufferFunc hash_buffer_func)
+{
+    return Longtail_MakeHashAPIWithBatch(
+        mem,
+        dispose_func,
+        get_identifier_func,
+        begin_context_func,
+        hash_func,
+        end_context_func,
+        hash_buffer_func,
+        0);
+}
+
+struct Longtail_HashAPI* Longtail_MakeHashAPIWithBatch(
+    void* mem,
+    Longtail_DisposeFunc dispose_func,
+    Longtail_Hash_GetIdentifierFunc get_identifier_func,
+    Longtail_Hash_BeginContextFunc begin_context_func,
+    Longtail_Hash_HashFunc hash_func,
+    Longtail_Hash_EndContextFunc end_context_func,
+    Longtail_Hash_HashBufferFunc hash_buffer_func,
+    Longtail_Hash_HashBuffersFunc optional_hash_buffers_func)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(mem, "%p"),
@@ -150,7 +187,8 @@ struct Longtail_HashAPI* Longtail_MakeHashAPI(
         LONGTAIL_LOGFIELD(begin_context_func, "%p"),
         LONGTAIL_LOGFIELD(hash_func, "%p"),
         LONGTAIL_LOGFIELD(end_context_func, "%p"),
-        LONGTAIL_LOGFIELD(hash_buffer_func, "%p")
+        LONGTAIL_LOGFIELD(hash_buffer_func, "%p"),
+        LONGTAIL_LOGFIELD(optional_hash_buffers_func, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
 
     LONGTAIL_VALIDATE_INPUT(ctx, mem != 0, return 0)
@@ -161,6 +199,7 @@ struct Longtail_HashAPI* Longtail_MakeHashAPI(
     api->Hash = hash_func;
     api->EndContext = end_context_func;
     api->HashBuffer = hash_buffer_func;
+    api->HashBuffers = optional_hash_buffers_func ? optional_hash_buffers_func : HashAPI_HashBuffersFallback;
     return api;
 }
 
@@ -170,6 +209,15 @@ void Longtail_Hash_Hash(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HCon
 uint64_t Longtail_Hash_EndContext(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context) { return hash_api->EndContext(hash_api, context); }
 int Longtail_Hash_HashBuffer(struct Longtail_HashAPI* hash_api, uint32_t length, const void* data, uint64_t* out_hash) { return hash_api->HashBuffer(hash_api, length, data, out_hash); }
 
+int Longtail_Hash_HashBuffers(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes)
+{
+    if (hash_api->HashBuffers)
+    {
+        return hash_api->HashBuffers(hash_api, count, lengths, datas, out_hashes);
+    }
+    return HashAPI_HashBuffersFallback(hash_api, count, lengths, datas, out_hashes);
+}
+
 
 uint64_t Longtail_GetHashRegistrySize()
 {
@@ -690,6 +738,7 @@ struct Longtail_BlockStoreAPI* Longtail_MakeBlockStoreAPI(
     api->PruneBlocks = prune_blocks_func;
     api->GetStats = get_stats_func;
     api->Flush = flush_func;
+    api->GetStoredBlockChunks = 0;
     return api;
 }
 
@@ -701,6 +750,15 @@ int Longtail_BlockStore_PruneBlocks(struct Longtail_BlockStoreAPI* block_store_a
 int Longtail_BlockStore_GetStats(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_BlockStore_Stats* out_stats) { return block_store_api->GetStats(block_store_api, out_stats); }
 int Longtail_BlockStore_Flush(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_AsyncFlushAPI* async_complete_api) {return block_store_api->Flush(block_store_api, async_complete_api); }
 
+int Longtail_BlockStore_GetStoredBlockChunks(struct Longtail_BlockStoreAPI* block_store_api, uint64_t block_hash, uint32_t chunk_count, const TLongtail_Hash* chunk_hashes, struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+    if (block_store_api->GetStoredBlockChunks)
+    {
+        return block_store_api->GetStoredBlockChunks(block_store_api, block_hash, chunk_count, chunk_hashes, async_complete_api);
+    }
+    return block_store_api->GetStoredBlock(block_store_api, block_hash, async_complete_api);
+}
+
 Longtail_Assert Longtail_Assert_private = 0;
 
 void Longtail_SetAssert(Longtail_Assert assert_func)
@@ -881,57 +939,142 @@ char* Longtail_Strdup(const char* path)
 
 //////////////////////////////// Longtail_LookupTable
 
+// Open addressing hash table probed one group of LOOKUPTABLE_GROUP_SIZE slots at a time.
+// Each slot has a control byte that is either LOOKUPTABLE_EMPTY_SLOT or seven bits of the
+// key hash, a group probe compares all control bytes of the group at once and only touches
+// the keys of slots with a matching control byte. Entries are never removed so the probe
+// for a key stops at the first group with an empty slot.
+
+#define LOOKUPTABLE_GROUP_SIZE  16u
+#define LOOKUPTABLE_EMPTY_SLOT  0x80u
+
+// The key is split in two halves to keep the slot at 12 bytes
+struct LookupTableSlot
+{
+    uint32_t m_KeyLow;
+    uint32_t m_KeyHigh;
+    uint32_t m_Value;
+};
+
+// The control bytes are kept in their own array, one byte per slot, so the control bytes of a
+// table with millions of entries mostly stay in cache and finding a slot usually only misses
+// on the slot itself
 struct Longtail_LookupTable
 {
-    uint32_t  m_BucketCount;
+    uint32_t m_GroupCount;
 
     uint32_t m_Capacity;
     uint32_t m_Count;
 
-    uint32_t* m_Buckets;
-    uint64_t* m_Keys;
-    uint32_t* m_Values;
-    uint32_t* m_NextIndex;
+    uint8_t* m_Control;
+    struct LookupTableSlot* m_Slots;
 };
 
-int Longtail_LookupTable_Put(struct Longtail_LookupTable* lut, uint64_t key, uint32_t value)
+static uint64_t LookupTable_HashKey(uint64_t key)
 {
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(lut, "%p"),
-        LONGTAIL_LOGFIELD(key, "%" PRIu64),
-        LONGTAIL_LOGFIELD(value, "%" PRIu64)
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-    LONGTAIL_FATAL_ASSERT(ctx, lut->m_Count < lut->m_Capacity, return ENOMEM)
+    // Keys are usually hashes already but small integer keys are used as well, spread them out
+    return key * 0x9e3779b97f4a7c15ull;
+}
+
+static uint32_t LookupTable_GetStartGroup(const struct Longtail_LookupTable* lut, uint64_t hash)
+{
+    return (uint32_t)(((hash >> 32) * lut->m_GroupCount) >> 32);
+}
+
+static uint8_t LookupTable_GetControl(uint64_t hash)
+{
+    return (uint8_t)((hash >> 25) & 0x7fu);
+}
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static uint32_t LookupTable_LowestBit(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (uint32_t)index;
 #else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
+    return (uint32_t)__builtin_ctz(mask);
+#endif
+}
 
-    uint32_t entry_index = lut->m_Count++;
-    lut->m_Keys[entry_index] = key;
-    lut->m_Values[entry_index] = value;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
 
-    uint32_t bucket_index = (uint32_t)(key & (lut->m_BucketCount - 1));
-    uint32_t* buckets = lut->m_Buckets;
-    uint32_t index = buckets[bucket_index];
-    if (index == 0xffffffffu)
+#include <emmintrin.h>
+
+// Returns a bit mask with bit N set if control byte N of the group equals control
+static uint32_t LookupTable_MatchGroup(const uint8_t* group_control, uint8_t control)
+{
+    __m128i c = _mm_loadu_si128((const __m128i*)group_control);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8((char)control)));
+}
+
+#else
+
+static uint32_t LookupTable_MatchGroup(const uint8_t* group_control, uint8_t control)
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < LOOKUPTABLE_GROUP_SIZE; ++i)
     {
-        buckets[bucket_index] = entry_index;
-        return 0;
+        mask |= (uint32_t)(group_control[i] == control) << i;
     }
-    uint32_t* next_index = lut->m_NextIndex;
-    uint32_t next = next_index[index];
-    while (next != 0xffffffffu)
+    return mask;
+}
+
+#endif
+
+// Returns the slot of key if it is present, otherwise the first empty slot in its probe sequence
+static struct LookupTableSlot* LookupTable_FindSlot(const struct Longtail_LookupTable* lut, uint64_t key, uint8_t** out_control)
+{
+    uint64_t hash = LookupTable_HashKey(key);
+    uint8_t control = LookupTable_GetControl(hash);
+    uint32_t group_index = LookupTable_GetStartGroup(lut, hash);
+    uint32_t key_low = (uint32_t)key;
+    uint32_t key_high = (uint32_t)(key >> 32);
+    while (1)
     {
-        index = next;
-        next = next_index[index];
+        uint8_t* group_control = &lut->m_Control[group_index * LOOKUPTABLE_GROUP_SIZE];
+        struct LookupTableSlot* group_slots = &lut->m_Slots[group_index * LOOKUPTABLE_GROUP_SIZE];
+        uint32_t match = LookupTable_MatchGroup(group_control, control);
+        while (match)
+        {
+            struct LookupTableSlot* slot = &group_slots[LookupTable_LowestBit(match)];
+            if (slot->m_KeyLow == key_low && slot->m_KeyHigh == key_high)
+            {
+                *out_control = 0;
+                return slot;
+            }
+            match &= match - 1;
+        }
+        uint32_t empty = LookupTable_MatchGroup(group_control, LOOKUPTABLE_EMPTY_SLOT);
+        if (empty)
+        {
+            uint32_t slot_index = LookupTable_LowestBit(empty);
+            *out_control = &group_control[slot_index];
+            return &group_slots[slot_index];
+        }
+        if (++group_index == lut->m_GroupCount)
+        {
+            group_index = 0;
+        }
     }
+}
 
-    next_index[index] = entry_index;
-    return 0;
+static void LookupTable_Insert(struct Longtail_LookupTable* lut, uint8_t* control, struct LookupTableSlot* slot, uint64_t key, uint32_t value)
+{
+    *control = LookupTable_GetControl(LookupTable_HashKey(key));
+    slot->m_KeyLow = (uint32_t)key;
+    slot->m_KeyHigh = (uint32_t)(key >> 32);
+    slot->m_Value = value;
+    ++lut->m_Count;
 }
 
-uint32_t* Longtail_LookupTable_PutUnique(struct Longtail_LookupTable* lut, uint64_t key, uint32_t value)
+// Put and PutUnique are called once per chunk when building tables over a whole store, the log
+// context is only set up when the table is full so it does not add to the cost of every insert
+static int LookupTable_AssertSpaceLeft(const struct Longtail_LookupTable* lut, uint64_t key, uint32_t value)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -943,92 +1086,67 @@ uint32_t* Longtail_LookupTable_PutUnique(struct Longtail_LookupTable* lut, uint6
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    uint32_t bucket_index = (uint32_t)(key & (lut->m_BucketCount - 1));
-    uint32_t* buckets = lut->m_Buckets;
-    uint32_t index = buckets[bucket_index];
-    if (index == 0xffffffffu)
+    LONGTAIL_FATAL_ASSERT(ctx, lut->m_Count < lut->m_Capacity, return 0)
+    return 1;
+}
+
+int Longtail_LookupTable_Put(struct Longtail_LookupTable* lut, uint64_t key, uint32_t value)
+{
+    uint8_t* control;
+    struct LookupTableSlot* slot = LookupTable_FindSlot(lut, key, &control);
+    if (control == 0)
     {
-        LONGTAIL_FATAL_ASSERT(ctx, lut->m_Count < lut->m_Capacity, return 0)
-        uint32_t entry_index = lut->m_Count++;
-        lut->m_Keys[entry_index] = key;
-        lut->m_Values[entry_index] = value;
-        buckets[bucket_index] = entry_index;
+        // Get always returned the first value put for a key, keep it
         return 0;
     }
-    if (lut->m_Keys[index] == key)
-    {
-        return &lut->m_Values[index];
-    }
-    uint64_t* keys = lut->m_Keys;
-    uint32_t* next_index = lut->m_NextIndex;
-    uint32_t next = next_index[index];
-    while (next != 0xffffffffu)
+    if (lut->m_Count >= lut->m_Capacity && !LookupTable_AssertSpaceLeft(lut, key, value))
     {
-        index = next;
-        if (keys[index] == key)
-        {
-            return &lut->m_Values[index];
-        }
-        next = next_index[index];
+        return ENOMEM;
     }
-
-    LONGTAIL_FATAL_ASSERT(ctx, lut->m_Count < lut->m_Capacity, return 0)
-    uint32_t entry_index = lut->m_Count++;
-    keys[entry_index] = key;
-    lut->m_Values[entry_index] = value;
-    next_index[index] = entry_index;
+    LookupTable_Insert(lut, control, slot, key, value);
     return 0;
 }
 
-uint32_t* Longtail_LookupTable_Get(const struct Longtail_LookupTable* lut, uint64_t key)
+uint32_t* Longtail_LookupTable_PutUnique(struct Longtail_LookupTable* lut, uint64_t key, uint32_t value)
 {
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(lut, "%p"),
-        LONGTAIL_LOGFIELD(key, "%" PRIu64)
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
-    uint32_t bucket_index = (uint32_t)(key & (lut->m_BucketCount - 1));
-    uint32_t index = lut->m_Buckets[bucket_index];
-    const uint64_t* keys = lut->m_Keys;
-    const uint32_t* next_index = lut->m_NextIndex;
-    while (index != 0xffffffffu)
+    uint8_t* control;
+    struct LookupTableSlot* slot = LookupTable_FindSlot(lut, key, &control);
+    if (control == 0)
     {
-        if (keys[index] == key)
-        {
-            return &lut->m_Values[index];
-        }
-        index = next_index[index];
+        return &slot->m_Value;
+    }
+    if (lut->m_Count >= lut->m_Capacity && !LookupTable_AssertSpaceLeft(lut, key, value))
+    {
+        return 0;
     }
+    LookupTable_Insert(lut, control, slot, key, value);
     return 0;
 }
 
+uint32_t* Longtail_LookupTable_Get(const struct Longtail_LookupTable* lut, uint64_t key)
+{
+    uint8_t* control;
+    struct LookupTableSlot* slot = LookupTable_FindSlot(lut, key, &control);
+    return control == 0 ? &slot->m_Value : 0;
+}
+
 uint32_t Longtail_LookupTable_GetSpaceLeft(const struct Longtail_LookupTable* lut)
 {
     return lut->m_Capacity - lut->m_Count;
 }
 
-static uint32_t GetLookupTableSize(uint32_t capacity)
+static uint32_t GetLookupTableGroupCount(uint32_t capacity)
 {
-    uint32_t table_size = 1;
-    while (table_size < (capacity / 4))
-    {
-        table_size <<= 1;
-    }
-    return table_size;
+    // Tables are usually filled to capacity, keep the load factor at or below 4/5 so probe
+    // sequences stay short and make sure there is always at least one empty slot
+    uint64_t slot_count = (uint64_t)capacity + capacity / 4 + 1;
+    return (uint32_t)((slot_count + LOOKUPTABLE_GROUP_SIZE - 1) / LOOKUPTABLE_GROUP_SIZE);
 }
 
 size_t Longtail_LookupTable_GetSize(uint32_t capacity)
 {
-    uint32_t table_size = GetLookupTableSize(capacity);
     size_t mem_size = sizeof(struct Longtail_LookupTable) +
-        sizeof(uint32_t) * table_size +
-        sizeof(uint64_t) * capacity +
-        sizeof(uint32_t) * capacity +
-        sizeof(uint32_t) * capacity;
+        (sizeof(struct LookupTableSlot) + sizeof(uint8_t)) * LOOKUPTABLE_GROUP_SIZE * GetLookupTableGroupCount(capacity);
     return mem_size;
 }
 
@@ -1041,34 +1159,30 @@ struct Longtail_LookupTable* Longtail_LookupTable_Create(void* mem, uint32_t cap
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
     struct Longtail_LookupTable* lut = (struct Longtail_LookupTable*)mem;
-    uint32_t table_size = GetLookupTableSize(capacity);
-    lut->m_BucketCount = table_size;
+    uint32_t group_count = GetLookupTableGroupCount(capacity);
+    lut->m_GroupCount = group_count;
     lut->m_Capacity = capacity;
     lut->m_Count = 0;
-    lut->m_Buckets = (uint32_t*)&lut[1];
-    lut->m_Keys = (uint64_t*)&lut->m_Buckets[table_size];
-    lut->m_Values = (uint32_t*)&lut->m_Keys[capacity];
-    lut->m_NextIndex = &lut->m_Values[capacity];
+    lut->m_Slots = (struct LookupTableSlot*)&lut[1];
+    lut->m_Control = (uint8_t*)&lut->m_Slots[group_count * LOOKUPTABLE_GROUP_SIZE];
 
-    memset(lut->m_Buckets, 0xff, sizeof(uint32_t) * table_size);
-    memset(lut->m_NextIndex, 0xff, sizeof(uint32_t) * capacity);
+    memset(lut->m_Control, LOOKUPTABLE_EMPTY_SLOT, group_count * LOOKUPTABLE_GROUP_SIZE);
 
     if (optional_source_entries == 0)
     {
         return lut;
     }
-    for (uint32_t i = 0; i < optional_source_entries->m_BucketCount; ++i)
+    LONGTAIL_FATAL_ASSERT(ctx, optional_source_entries->m_Count <= capacity, return lut)
+    uint32_t source_slot_count = optional_source_entries->m_GroupCount * LOOKUPTABLE_GROUP_SIZE;
+    for (uint32_t i = 0; i < source_slot_count; ++i)
     {
-        if (optional_source_entries->m_Buckets[i] != 0xffffffffu)
+        if (optional_source_entries->m_Control[i] != LOOKUPTABLE_EMPTY_SLOT)
         {
-            uint32_t index = optional_source_entries->m_Buckets[i];
-            while (index != 0xffffffffu)
-            {
-                uint64_t key = optional_source_entries->m_Keys[index];
-                uint32_t value = optional_source_entries->m_Values[index];
-                Longtail_LookupTable_Put(lut, key, value);
-                index = optional_source_entries->m_NextIndex[index];
-            }
+            const struct LookupTableSlot* source_slot = &optional_source_entries->m_Slots[i];
+            uint64_t key = ((uint64_t)source_slot->m_KeyHigh << 32) | source_slot->m_KeyLow;
+            uint8_t* control;
+            struct LookupTableSlot* slot = LookupTable_FindSlot(lut, key, &control);
+            LookupTable_Insert(lut, control, slot, key, source_slot->m_Value);
         }
     }
     return lut;
@@ -1397,12 +1511,290 @@ static int RecurseTree(
     return err;
 }
 
+struct ScanFolderEntry
+{
+    uint32_t m_AssetPathOffset;
+    uint32_t m_NameOffset;
+    uint64_t m_Size;
+    uint64_t m_ModificationTime;
+    uint16_t m_Permissions;
+    int m_IsDir;
+};
+
+struct ScanFolderJob
+{
+    struct Longtail_StorageAPI* m_StorageAPI;
+    struct Longtail_PathFilterAPI* m_PathFilterAPI;
+    const char* m_RootFolder;
+    char* m_FullSearchPath;
+    char* m_RelativeParentPath;
+    char* m_PathData;
+    struct ScanFolderEntry* m_Entries;
+    int m_Err;
+};
+
+// Lists one folder, the entries are kept in enumeration order so the result can be stitched together
+// in the same order as a single threaded breadth first walk would produce
+static int ScanFolder(void* context, uint32_t job_id, int is_cancelled)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+    struct ScanFolderJob* job = (struct ScanFolderJob*)context;
+    if (is_cancelled)
+    {
+        job->m_Err = ECANCELED;
+        return 0;
+    }
+
+    struct Longtail_StorageAPI* storage_api = job->m_StorageAPI;
+    Longtail_StorageAPI_HIterator fs_iterator = 0;
+    int err = storage_api->StartFind(storage_api, job->m_FullSearchPath, &fs_iterator);
+    if (err == ENOENT)
+    {
+        job->m_Err = 0;
+        return 0;
+    }
+    else if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->StartFind() failed with %d", err)
+        job->m_Err = err;
+        return 0;
+    }
+    size_t relative_parent_path_length = job->m_RelativeParentPath ? strlen(job->m_RelativeParentPath) : 0;
+    while (err == 0)
+    {
+        struct Longtail_StorageAPI_EntryProperties properties;
+        err = storage_api->GetEntryProperties(storage_api, fs_iterator, &properties);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->GetEntryProperties() failed with %d", err)
+            break;
+        }
+        size_t name_length = strlen(properties.m_Name);
+        uint32_t asset_path_offset = (uint32_t)arrlen(job->m_PathData);
+        uint32_t name_offset = asset_path_offset;
+        if (job->m_RelativeParentPath)
+        {
+            size_t parent_offset = arraddn(job->m_PathData, relative_parent_path_length + 1);
+            memcpy(&job->m_PathData[parent_offset], job->m_RelativeParentPath, relative_parent_path_length);
+            job->m_PathData[parent_offset + relative_parent_path_length] = '/';
+            name_offset += (uint32_t)(relative_parent_path_length + 1);
+        }
+        size_t name_data_offset = arraddn(job->m_PathData, name_length + 1);
+        memcpy(&job->m_PathData[name_data_offset], properties.m_Name, name_length + 1);
+
+        if (!job->m_PathFilterAPI
+            || job->m_PathFilterAPI->Include(
+                job->m_PathFilterAPI,
+                job->m_RootFolder,
+                &job->m_PathData[asset_path_offset],
+                properties.m_Name,
+                properties.m_IsDir,
+                properties.m_Size,
+                properties.m_Permissions)
+            )
+        {
+            struct ScanFolderEntry entry = {asset_path_offset, name_offset, properties.m_Size, properties.m_ModificationTime, properties.m_Permissions, properties.m_IsDir};
+            arrput(job->m_Entries, entry);
+        }
+        else
+        {
+            arrsetlen(job->m_PathData, asset_path_offset);
+        }
+        err = storage_api->FindNext(storage_api, fs_iterator);
+        if (err == ENOENT)
+        {
+            err = 0;
+            break;
+        }
+    }
+    storage_api->CloseFind(storage_api, fs_iterator);
+    job->m_Err = err;
+    return 0;
+}
+
+static void FreeScanFolderJob(struct ScanFolderJob* job)
+{
+    Longtail_Free(job->m_FullSearchPath);
+    Longtail_Free(job->m_RelativeParentPath);
+    arrfree(job->m_PathData);
+    arrfree(job->m_Entries);
+}
+
+// Same walk and ordering as RecurseTree but all folders at the same depth are listed in parallel.
+// The path filter is called from the job threads, entry_processor is only called from the calling thread.
+static int RecurseTreeParallel(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_PathFilterAPI* optional_path_filter_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_folder,
+    ProcessEntry entry_processor,
+    void* context)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_path_filter_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_folder, "%s"),
+        LONGTAIL_LOGFIELD(entry_processor, "%p"),
+        LONGTAIL_LOGFIELD(context, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, root_folder != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, entry_processor != 0, return EINVAL)
+
+    struct ScanFolderJob* folder_jobs = 0;
+    struct ScanFolderJob* next_folder_jobs = 0;
+    Longtail_JobAPI_JobFunc* funcs = 0;
+    void** ctxs = 0;
+
+    struct ScanFolderJob root_job;
+    memset(&root_job, 0, sizeof(root_job));
+    root_job.m_FullSearchPath = Longtail_Strdup(root_folder);
+    if (!root_job.m_FullSearchPath)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Strdup() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    arrput(folder_jobs, root_job);
+
+    int err = 0;
+    while (arrlen(folder_jobs) > 0)
+    {
+        if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
+        {
+            err = ECANCELED;
+            break;
+        }
+
+        uint32_t folder_count = (uint32_t)arrlen(folder_jobs);
+        for (uint32_t f = 0; f < folder_count; ++f)
+        {
+            struct ScanFolderJob* job = &folder_jobs[f];
+            job->m_StorageAPI = storage_api;
+            job->m_PathFilterAPI = optional_path_filter_api;
+            job->m_RootFolder = root_folder;
+            job->m_Err = EINVAL;
+        }
+
+        if (folder_count == 1)
+        {
+            // Not worth the job overhead, this is always the case for the root folder
+            ScanFolder(&folder_jobs[0], 0, 0);
+        }
+        else
+        {
+            Longtail_JobAPI_Group job_group = 0;
+            err = job_api->ReserveJobs(job_api, folder_count, &job_group);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+                break;
+            }
+            arrsetlen(funcs, folder_count);
+            arrsetlen(ctxs, folder_count);
+            for (uint32_t f = 0; f < folder_count; ++f)
+            {
+                funcs[f] = ScanFolder;
+                ctxs[f] = &folder_jobs[f];
+            }
+            Longtail_JobAPI_Jobs jobs;
+            err = job_api->CreateJobs(job_api, job_group, folder_count, funcs, ctxs, &jobs);
+            LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+            err = job_api->ReadyJobs(job_api, folder_count, jobs);
+            LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+            err = job_api->WaitForAllJobs(job_api, job_group, 0, optional_cancel_api, optional_cancel_token);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+                break;
+            }
+        }
+
+        for (uint32_t f = 0; f < folder_count && err == 0; ++f)
+        {
+            struct ScanFolderJob* job = &folder_jobs[f];
+            uint32_t entry_count = (uint32_t)arrlen(job->m_Entries);
+            for (uint32_t e = 0; e < entry_count; ++e)
+            {
+                const struct ScanFolderEntry* entry = &job->m_Entries[e];
+                const char* asset_path = &job->m_PathData[entry->m_AssetPathOffset];
+                struct Longtail_StorageAPI_EntryProperties properties;
+                properties.m_Name = &job->m_PathData[entry->m_NameOffset];
+                properties.m_Size = entry->m_Size;
+                properties.m_ModificationTime = entry->m_ModificationTime;
+                properties.m_Permissions = entry->m_Permissions;
+                properties.m_IsDir = entry->m_IsDir;
+                err = entry_processor(context, job->m_FullSearchPath, asset_path, &properties);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "entry_processor() failed with %d", err)
+                    break;
+                }
+                if (properties.m_IsDir)
+                {
+                    struct ScanFolderJob sub_folder_job;
+                    memset(&sub_folder_job, 0, sizeof(sub_folder_job));
+                    sub_folder_job.m_FullSearchPath = storage_api->ConcatPath(storage_api, job->m_FullSearchPath, properties.m_Name);
+                    sub_folder_job.m_RelativeParentPath = Longtail_Strdup(asset_path);
+                    arrput(next_folder_jobs, sub_folder_job);
+                    if (!sub_folder_job.m_FullSearchPath || !sub_folder_job.m_RelativeParentPath)
+                    {
+                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to allocate folder path, error %d", ENOMEM)
+                        err = ENOMEM;
+                        break;
+                    }
+                }
+            }
+            // Folders are reported in order, the first failing folder decides the result just as in RecurseTree
+            err = err ? err : job->m_Err;
+        }
+
+        uint32_t job_count = (uint32_t)arrlen(folder_jobs);
+        for (uint32_t f = 0; f < job_count; ++f)
+        {
+            FreeScanFolderJob(&folder_jobs[f]);
+        }
+        arrsetlen(folder_jobs, 0);
+        struct ScanFolderJob* tmp = folder_jobs;
+        folder_jobs = next_folder_jobs;
+        next_folder_jobs = tmp;
+        if (err)
+        {
+            break;
+        }
+    }
+
+    uint32_t job_count = (uint32_t)arrlen(folder_jobs);
+    for (uint32_t f = 0; f < job_count; ++f)
+    {
+        FreeScanFolderJob(&folder_jobs[f]);
+    }
+    arrfree(folder_jobs);
+    arrfree(next_folder_jobs);
+    arrfree(ctxs);
+    arrfree(funcs);
+    return err;
+}
+
 static size_t GetFileInfosSize(uint32_t path_count, uint32_t path_data_size)
 {
     return sizeof(struct Longtail_FileInfos) +
         sizeof(uint32_t) * path_count +    // m_Permissions[path_count]
         sizeof(uint32_t) * path_count +    // m_Offsets[path_count]
         sizeof(uint64_t) * path_count +    // m_Sizes[path_count]
+        sizeof(uint64_t) * path_count +    // m_ModificationTimes[path_count]
         path_data_size;
 };
 
@@ -1426,6 +1818,8 @@ static struct Longtail_FileInfos* CreateFileInfos(uint32_t path_count, uint32_t
     file_infos->m_PathDataSize = 0;
     file_infos->m_Sizes = (uint64_t*)p;
     p += sizeof(uint64_t) * path_count;
+    file_infos->m_ModificationTimes = (uint64_t*)p;
+    p += sizeof(uint64_t) * path_count;
     file_infos->m_PathStartOffsets = (uint32_t*)p;
     p += sizeof(uint32_t) * path_count;
     file_infos->m_Permissions = (uint16_t*)p;
@@ -1470,6 +1864,7 @@ int Longtail_MakeFileInfos(
     {
         uint32_t length = (uint32_t)strlen(path_names[i]) + 1;
         file_infos->m_Sizes[i] = file_sizes[i];
+        file_infos->m_ModificationTimes[i] = 0;
         file_infos->m_Permissions[i] = file_permissions[i];
         file_infos->m_PathStartOffsets[i] = offset;
         memmove(&file_infos->m_PathData[offset], path_names[i], length);
@@ -1485,6 +1880,7 @@ static int AppendPath(
     struct Longtail_FileInfos** file_infos,
     const char* path,
     uint64_t file_size,
+    uint64_t file_modification_time,
     uint16_t file_permissions,
     uint32_t* max_path_count,
     uint32_t* max_data_size,
@@ -1496,6 +1892,7 @@ static int AppendPath(
         LONGTAIL_LOGFIELD(file_infos, "%p"),
         LONGTAIL_LOGFIELD(path, "%s"),
         LONGTAIL_LOGFIELD(file_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(file_modification_time, "%" PRIu64),
         LONGTAIL_LOGFIELD(file_permissions, "%u"),
         LONGTAIL_LOGFIELD(max_path_count, "%p"),
         LONGTAIL_LOGFIELD(max_data_size, "%p"),
@@ -1533,6 +1930,7 @@ static int AppendPath(
         new_file_infos->m_Count = (*file_infos)->m_Count;
 
         memmove(new_file_infos->m_Sizes, (*file_infos)->m_Sizes, sizeof(uint64_t) * (*file_infos)->m_Count);
+        memmove(new_file_infos->m_ModificationTimes, (*file_infos)->m_ModificationTimes, sizeof(uint64_t) * (*file_infos)->m_Count);
         memmove(new_file_infos->m_PathStartOffsets, (*file_infos)->m_PathStartOffsets, sizeof(uint32_t) * (*file_infos)->m_Count);
         memmove(new_file_infos->m_Permissions, (*file_infos)->m_Permissions, sizeof(uint32_t) * (*file_infos)->m_Count);
         memmove(new_file_infos->m_PathData, (*file_infos)->m_PathData, (*file_infos)->m_PathDataSize);
@@ -1545,6 +1943,7 @@ static int AppendPath(
     (*file_infos)->m_PathStartOffsets[(*file_infos)->m_Count] = (*file_infos)->m_PathDataSize;
     (*file_infos)->m_PathDataSize += path_size;
     (*file_infos)->m_Sizes[(*file_infos)->m_Count] = file_size;
+    (*file_infos)->m_ModificationTimes[(*file_infos)->m_Count] = file_modification_time;
     (*file_infos)->m_Permissions[(*file_infos)->m_Count] = file_permissions;
     (*file_infos)->m_Count++;
 
@@ -1588,7 +1987,7 @@ static int AddFile(void* context, const char* root_path, const char* asset_path,
         full_path[asset_path_length + 1] = 0;
     }
 
-    int err = AppendPath(&paths_context->m_FileInfos, full_path, properties->m_Size, properties->m_Permissions, &paths_context->m_ReservedPathCount, &paths_context->m_ReservedPathSize, 512, 128);
+    int err = AppendPath(&paths_context->m_FileInfos, full_path, properties->m_Size, properties->m_ModificationTime, properties->m_Permissions, &paths_context->m_ReservedPathCount, &paths_context->m_ReservedPathSize, 512, 128);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AppendPath() failed with %d", err)
@@ -1653,6 +2052,56 @@ int Longtail_GetFilesRecursively(
     return 0;
 }
 
+int Longtail_GetFilesRecursivelyParallel(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_PathFilterAPI* optional_path_filter_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    struct Longtail_FileInfos** out_file_infos)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_path_filter_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(out_file_infos, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, root_path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_file_infos != 0, return EINVAL)
+
+    const uint32_t default_path_count = 512;
+    const uint32_t default_path_data_size = default_path_count * 128;
+
+    struct Longtail_FileInfos* file_infos = CreateFileInfos(default_path_count, default_path_data_size);
+    if (!file_infos)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateFileInfos() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct AddFile_Context context = {storage_api, default_path_count, default_path_data_size, (uint32_t)(strlen(root_path)), file_infos};
+    file_infos = 0;
+
+    int err = RecurseTreeParallel(storage_api, job_api, optional_path_filter_api, optional_cancel_api, optional_cancel_token, root_path, AddFile, &context);
+    if(err)
+    {
+        LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "RecurseTreeParallel() failed with %d", err)
+        Longtail_Free(context.m_FileInfos);
+        context.m_FileInfos = 0;
+        return err;
+    }
+
+    *out_file_infos = context.m_FileInfos;
+    context.m_FileInfos = 0;
+    return 0;
+}
+
 struct StorageChunkFeederContext
 {
     struct Longtail_StorageAPI* m_StorageAPI;
@@ -1713,13 +2162,32 @@ struct HashJob
     const char* m_Path;
     uint64_t m_StartRange;
     uint64_t m_SizeRange;
+    uint64_t m_AssetSize;
     uint32_t* m_AssetChunkCount;
     TLongtail_Hash* m_ChunkHashes;
     uint32_t* m_ChunkSizes;
+    uint8_t* m_ChunkData;
     uint32_t m_TargetChunkSize;
+    int m_RetainChunkData;
     int m_Err;
+    // Storage for the single chunk of an asset hashed by DynamicChunkingBatch, m_ChunkHashes/m_ChunkSizes point here
+    TLongtail_Hash m_SmallChunkHash;
+    uint32_t m_SmallChunkSize;
 };
 
+static void FreeHashJobChunks(struct HashJob* hash_jobs, uint32_t hash_job_count)
+{
+    for (uint32_t i = 0; i < hash_job_count; ++i)
+    {
+        if (hash_jobs[i].m_ChunkHashes != &hash_jobs[i].m_SmallChunkHash)
+        {
+            Longtail_Free(hash_jobs[i].m_ChunkHashes);
+        }
+        hash_jobs[i].m_ChunkHashes = 0;
+        hash_jobs[i].m_ChunkSizes = 0;
+    }
+}
+
 #define MIN_CHUNKER_SIZE(min_chunk_size, target_chunk_size) (((target_chunk_size / 8) < min_chunk_size) ? min_chunk_size : (target_chunk_size / 8))
 #define AVG_CHUNKER_SIZE(min_chunk_size, target_chunk_size) (((target_chunk_size / 2) < min_chunk_size) ? min_chunk_size : (target_chunk_size / 2))
 #define MAX_CHUNKER_SIZE(min_chunk_size, target_chunk_size) (((target_chunk_size * 2) < min_chunk_size) ? min_chunk_size : (target_chunk_size * 2))
@@ -1833,7 +2301,14 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                 return 0;
             }
 
-            Longtail_Free(buffer);
+            if (hash_job->m_RetainChunkData)
+            {
+                hash_job->m_ChunkData = (uint8_t*)buffer;
+            }
+            else
+            {
+                Longtail_Free(buffer);
+            }
             buffer = 0;
 
             hash_job->m_ChunkSizes[0] = (uint32_t)hash_size;
@@ -1861,13 +2336,33 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                 return 0;
             }
 
+            if (hash_job->m_RetainChunkData)
+            {
+                // The last chunk can extend up to one max chunk size past the end of our range
+                hash_job->m_ChunkData = (uint8_t*)Longtail_Alloc("DynamicChunking", (size_t)(hash_size + max_chunk_size));
+                if (!hash_job->m_ChunkData)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+                    hash_job->m_ChunkerAPI->DisposeChunker(hash_job->m_ChunkerAPI, chunker);
+                    chunker = 0;
+                    storage_api->CloseFile(storage_api, file_handle);
+                    file_handle = 0;
+                    Longtail_Free(path);
+                    path = 0;
+                    hash_job->m_Err = ENOMEM;
+                    return 0;
+                }
+            }
+
+            // The feeder can read past the end of our range, the chunk that crosses the end of the range is
+            // found exactly as a chunker running over the whole asset would find it from the same start
             struct StorageChunkFeederContext feeder_context =
             {
                 storage_api,
                 file_handle,
                 path,
                 hash_job->m_StartRange,
-                hash_size,
+                hash_job->m_AssetSize - hash_job->m_StartRange,
                 0
             };
 
@@ -1922,9 +2417,19 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                     return 0;
                 }
                 hash_job->m_ChunkSizes[chunk_count] = chunk_range.len;
+                if (hash_job->m_ChunkData)
+                {
+                    memcpy(&hash_job->m_ChunkData[chunk_range.offset], chunk_range.buf, chunk_range.len);
+                }
 
                 ++chunk_count;
 
+                if (chunk_range.offset + chunk_range.len >= hash_size)
+                {
+                    // The rest belongs to the next part of the asset, see AssetStitcher
+                    break;
+                }
+
                 err = hash_job->m_ChunkerAPI->NextChunk(hash_job->m_ChunkerAPI, chunker, StorageChunkFeederFunc, &feeder_context, &chunk_range);
             }
 
@@ -1944,510 +2449,466 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
     return 0;
 }
 
-struct ChunkAssetsData {
-    uint32_t m_ChunkCount;
-    TLongtail_Hash* m_ChunkHashes;
-    uint32_t* m_ChunkSizes;
-    uint32_t* m_ChunkTags;
-};
+// Assets that are no larger than the minimum chunk size always end up as a single chunk covering the whole
+// asset, for trees with lots of small files the cost of scheduling one job per asset dominates so consecutive
+// small assets are read by one job into a shared buffer and hashed with a single Longtail_Hash_HashBuffers() call
+#define SMALL_ASSET_BATCH_MAX_COUNT 256u
+#define SMALL_ASSET_BATCH_MAX_SIZE (1024u * 1024u)
 
-struct ChunkAssetsData* AllocChunkAssetsData(uint32_t chunk_count)
+struct HashBatchJob
 {
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(chunk_count, "%u")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-    size_t size = sizeof(struct ChunkAssetsData) +
-        sizeof(TLongtail_Hash) * chunk_count +
-        sizeof(uint32_t) * chunk_count +
-        sizeof(uint32_t) * chunk_count;
-    void* mem = Longtail_Alloc("AllocChunkAssetsData", size);
-    if (!mem)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return 0;
-    }
-    struct ChunkAssetsData* chunk_assets_data = (struct ChunkAssetsData*)mem;
-    chunk_assets_data->m_ChunkCount = chunk_count;
-    chunk_assets_data->m_ChunkHashes = (TLongtail_Hash*)&chunk_assets_data[1];
-    chunk_assets_data->m_ChunkSizes = (uint32_t*)&chunk_assets_data->m_ChunkHashes[chunk_count];
-    chunk_assets_data->m_ChunkTags = (uint32_t*)&chunk_assets_data->m_ChunkSizes[chunk_count];
-    return chunk_assets_data;
-}
+    struct HashJob* m_HashJobs;
+    uint32_t m_HashJobCount;
+    uint32_t m_BatchSize;
+};
 
-static int ChunkAssets(
-    struct Longtail_StorageAPI* storage_api,
-    struct Longtail_HashAPI* hash_api,
-    struct Longtail_ChunkerAPI* chunker_api,
-    struct Longtail_JobAPI* job_api,
-    struct Longtail_ProgressAPI* progress_api,
-    struct Longtail_CancelAPI* optional_cancel_api,
-    Longtail_CancelAPI_HCancelToken optional_cancel_token,
-    const char* root_path,
-    const struct Longtail_FileInfos* file_infos,
-    TLongtail_Hash* path_hashes,
-    TLongtail_Hash* content_hashes,
-    const uint32_t* optional_asset_tags,
-    uint32_t* asset_chunk_start_index,
-    uint32_t* asset_chunk_counts,
-    uint32_t target_chunk_size,
-    struct ChunkAssetsData** out_chunk_assets_data)
+static int DynamicChunkingBatch(void* context, uint32_t job_id, int is_cancelled)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(storage_api, "%p"),
-        LONGTAIL_LOGFIELD(hash_api, "%p"),
-        LONGTAIL_LOGFIELD(chunker_api, "%p"),
-        LONGTAIL_LOGFIELD(job_api, "%p"),
-        LONGTAIL_LOGFIELD(progress_api, "%p"),
-        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
-        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
-        LONGTAIL_LOGFIELD(root_path, "%s"),
-        LONGTAIL_LOGFIELD(file_infos, "%p"),
-        LONGTAIL_LOGFIELD(path_hashes, "%p"),
-        LONGTAIL_LOGFIELD(content_hashes, "%p"),
-        LONGTAIL_LOGFIELD(optional_asset_tags, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_start_index, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
-        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
-        LONGTAIL_LOGFIELD(out_chunk_assets_data, "%p")
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    LONGTAIL_FATAL_ASSERT(ctx, storage_api != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, hash_api != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, job_api != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, root_path != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, file_infos != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, path_hashes != 0, return EINVAL)
-
-    LONGTAIL_FATAL_ASSERT(ctx, content_hashes != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, asset_chunk_start_index != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, asset_chunk_counts != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, target_chunk_size != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, out_chunk_assets_data != 0, return EINVAL)
-
-    uint32_t asset_count = file_infos->m_Count;
-
-    uint64_t max_hash_size = target_chunk_size * 1024;
-    uint32_t job_count = 0;
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
+    struct HashBatchJob* batch_job = (struct HashBatchJob*)context;
+    uint32_t hash_job_count = batch_job->m_HashJobCount;
 
-    for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
+    if (is_cancelled)
     {
-        uint64_t asset_size = file_infos->m_Sizes[asset_index];
-        uint64_t asset_part_count = 1 + (asset_size / max_hash_size);
-        job_count += (uint32_t)asset_part_count;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Cancelled with errno %d", ECANCELED)
+        for (uint32_t i = 0; i < hash_job_count; ++i)
+        {
+            batch_job->m_HashJobs[i].m_Err = ECANCELED;
         }
-
-    if (job_count == 0)
-    {
         return 0;
     }
 
-    Longtail_JobAPI_Group job_group = 0;
-    int err = job_api->ReserveJobs(job_api, job_count, &job_group);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
-        return err;
-    }
-
-    size_t work_mem_size = (sizeof(uint32_t) * job_count) +
-        (sizeof(struct HashJob) * job_count) +
-        (sizeof(Longtail_JobAPI_JobFunc) * job_count) +
-        (sizeof(void*) * job_count);
-    void* work_mem = Longtail_Alloc("ChunkAssets", work_mem_size);
+    size_t work_mem_size =
+        (sizeof(uint32_t) * hash_job_count) +
+        (sizeof(const void*) * hash_job_count) +
+        (sizeof(uint64_t) * hash_job_count) +
+        (sizeof(uint32_t) * hash_job_count) +
+        batch_job->m_BatchSize;
+    void* work_mem = Longtail_Alloc("DynamicChunkingBatch", work_mem_size);
     if (!work_mem)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
-    }
-
-    uint32_t* tmp_job_chunk_counts = (uint32_t*)work_mem;
-    struct HashJob* tmp_hash_jobs = (struct HashJob*)&tmp_job_chunk_counts[job_count];
-    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)&tmp_hash_jobs[job_count];
-    void** ctxs = (void**)&funcs[job_count];
-
-    uint32_t jobs_started = 0;
-    uint64_t chunks_offset = 0;
-    for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
-    {
-        uint64_t asset_size = file_infos->m_Sizes[asset_index];
-        uint64_t asset_part_count = 1 + (asset_size / max_hash_size);
-
-        for (uint64_t job_part = 0; job_part < asset_part_count; ++job_part)
+        for (uint32_t i = 0; i < hash_job_count; ++i)
         {
-            LONGTAIL_FATAL_ASSERT(ctx, jobs_started < job_count, return EINVAL)
-
-            uint64_t range_start = job_part * max_hash_size;
-            uint64_t job_size = (asset_size - range_start) > max_hash_size ? max_hash_size : (asset_size - range_start);
-
-            struct HashJob* job = &tmp_hash_jobs[jobs_started];
-            job->m_StorageAPI = storage_api;
-            job->m_HashAPI = hash_api;
-            job->m_ChunkerAPI = chunker_api;
-            job->m_RootPath = root_path;
-            job->m_Path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[asset_index]];
-            job->m_PathHash = (job_part == 0) ? &path_hashes[asset_index] : 0;
-            job->m_AssetIndex = asset_index;
-            job->m_StartRange = range_start;
-            job->m_SizeRange = job_size;
-            job->m_AssetChunkCount = &tmp_job_chunk_counts[jobs_started];
-            job->m_ChunkHashes = 0;
-            job->m_ChunkSizes = 0;
-            job->m_TargetChunkSize = target_chunk_size;
-            job->m_Err = EINVAL;
-            funcs[jobs_started] = DynamicChunking;
-            ctxs[jobs_started] = job;
-            ++jobs_started;
+            batch_job->m_HashJobs[i].m_Err = ENOMEM;
         }
+        return 0;
     }
+    const void** datas = (const void**)work_mem;
+    uint64_t* hashes = (uint64_t*)&datas[hash_job_count];
+    uint32_t* lengths = (uint32_t*)&hashes[hash_job_count];
+    uint32_t* hash_job_indexes = &lengths[hash_job_count];
+    char* buffer = (char*)&hash_job_indexes[hash_job_count];
 
-    // TODO: Add logic here if we end up creating more jobs than can be held in a uint32_t
-    LONGTAIL_FATAL_ASSERT(ctx, jobs_started < 0xffffffff, return ENOMEM);
-    Longtail_JobAPI_Jobs jobs;
-    err = job_api->CreateJobs(job_api, job_group, (uint32_t)jobs_started, funcs, ctxs, &jobs);
-    LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
-    err = job_api->ReadyJobs(job_api, (uint32_t)jobs_started, jobs);
-    LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
-
-    err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
-    if (err)
+    uint32_t hash_count = 0;
+    uint32_t buffer_offset = 0;
+    for (uint32_t i = 0; i < hash_job_count; ++i)
     {
-        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
-        for (uint32_t i = 0; i < jobs_started; ++i)
+        struct HashJob* hash_job = &batch_job->m_HashJobs[i];
+        LONGTAIL_FATAL_ASSERT(ctx, hash_job->m_StartRange == 0, return EINVAL)
+        LONGTAIL_FATAL_ASSERT(ctx, buffer_offset + hash_job->m_SizeRange <= batch_job->m_BatchSize, return EINVAL)
+        LONGTAIL_FATAL_ASSERT(ctx, hash_job->m_RetainChunkData == 0, return EINVAL)
+
+        if (hash_job->m_PathHash)
         {
-            Longtail_Free(tmp_hash_jobs[i].m_ChunkHashes);
+            hash_job->m_Err = Longtail_GetPathHash(hash_job->m_HashAPI, hash_job->m_Path, hash_job->m_PathHash);
+            if (hash_job->m_Err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_GetPathHash() failed with %d", hash_job->m_Err)
+                continue;
+            }
         }
-        Longtail_Free(work_mem);
-        return err;
-    }
 
-    err = 0;
-    for (uint32_t i = 0; i < jobs_started; ++i)
-    {
-        if (tmp_hash_jobs[i].m_Err)
+        *hash_job->m_AssetChunkCount = 0;
+        if (IsDirPath(hash_job->m_Path))
         {
-            LONGTAIL_LOG(ctx, (tmp_hash_jobs[i].m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "tmp_hash_jobs[i].m_Err failed with %d", tmp_hash_jobs[i].m_Err)
-            err = err ? err : tmp_hash_jobs[i].m_Err;
+            hash_job->m_Err = 0;
+            continue;
         }
-    }
 
-    if (!err)
-    {
-        uint32_t built_chunk_count = 0;
-        for (uint32_t i = 0; i < jobs_started; ++i)
+        struct Longtail_StorageAPI* storage_api = hash_job->m_StorageAPI;
+        char* path = storage_api->ConcatPath(storage_api, hash_job->m_RootPath, hash_job->m_Path);
+        Longtail_StorageAPI_HOpenFile file_handle;
+        int err = storage_api->OpenReadFile(storage_api, path, &file_handle);
+        if (err)
         {
-            built_chunk_count += *tmp_hash_jobs[i].m_AssetChunkCount;
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+            Longtail_Free(path);
+            path = 0;
+            hash_job->m_Err = err;
+            continue;
         }
 
-        struct ChunkAssetsData* cad = AllocChunkAssetsData(built_chunk_count);
-        if (!cad)
+        uint32_t hash_size = (uint32_t)hash_job->m_SizeRange;
+        if (hash_size > 0)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AllocChunkAssetsData() failed with %d", ENOMEM)
-            for (uint32_t i = 0; i < jobs_started; ++i)
+            err = storage_api->Read(storage_api, file_handle, 0, hash_size, &buffer[buffer_offset]);
+            if (err)
             {
-                Longtail_Free(tmp_hash_jobs[i].m_ChunkHashes);
-            }
-            Longtail_Free(work_mem);
-            return ENOMEM;
-        }
-
-        uint32_t chunk_offset = 0;
-        for (uint32_t i = 0; i < jobs_started; ++i)
-        {
-            uint32_t asset_index = tmp_hash_jobs[i].m_AssetIndex;
-            if (tmp_hash_jobs[i].m_StartRange == 0)
-            {
-                asset_chunk_start_index[asset_index] = chunk_offset;
-                asset_chunk_counts[asset_index] = 0;
-            }
-            uint32_t job_chunk_count = *tmp_hash_jobs[i].m_AssetChunkCount;
-            asset_chunk_counts[asset_index] += job_chunk_count;
-            for (uint32_t chunk_index = 0; chunk_index < job_chunk_count; ++chunk_index)
-            {
-                cad->m_ChunkSizes[chunk_offset] = tmp_hash_jobs[i].m_ChunkSizes[chunk_index];
-                cad->m_ChunkHashes[chunk_offset] = tmp_hash_jobs[i].m_ChunkHashes[chunk_index];
-                cad->m_ChunkTags[chunk_offset] = optional_asset_tags ? optional_asset_tags[asset_index] : 0;
-                ++chunk_offset;
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
             }
-        }
-        for (uint32_t a = 0; a < asset_count; ++a)
-        {
-            uint32_t chunk_start_index = asset_chunk_start_index[a];
-            uint32_t hash_size = (uint32_t)(sizeof(TLongtail_Hash) * asset_chunk_counts[a]);
-            err = hash_api->HashBuffer(hash_api, hash_size, &cad->m_ChunkHashes[chunk_start_index], &content_hashes[a]);
-            if (err)
+            else
             {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_api->HashBuffer() failed with %d", err)
-                Longtail_Free(cad);
-                for (uint32_t i = 0; i < jobs_started; ++i)
-                {
-                    Longtail_Free(tmp_hash_jobs[i].m_ChunkHashes);
-                }
-                Longtail_Free(work_mem);
-                return err;
+                datas[hash_count] = &buffer[buffer_offset];
+                lengths[hash_count] = hash_size;
+                hash_job_indexes[hash_count] = i;
+                ++hash_count;
+                buffer_offset += hash_size;
             }
         }
-        *out_chunk_assets_data = cad;
+
+        storage_api->CloseFile(storage_api, file_handle);
+        file_handle = 0;
+        Longtail_Free(path);
+        path = 0;
+
+        hash_job->m_Err = err;
     }
 
-    for (uint32_t i = 0; i < jobs_started; ++i)
+    int err = Longtail_Hash_HashBuffers(batch_job->m_HashJobs[0].m_HashAPI, hash_count, lengths, datas, hashes);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Hash_HashBuffers() failed with %d", err)
+    }
+    for (uint32_t h = 0; h < hash_count; ++h)
     {
-        Longtail_Free(tmp_hash_jobs[i].m_ChunkHashes);
+        struct HashJob* hash_job = &batch_job->m_HashJobs[hash_job_indexes[h]];
+        if (err)
+        {
+            hash_job->m_Err = err;
+            continue;
+        }
+        hash_job->m_SmallChunkHash = hashes[h];
+        hash_job->m_SmallChunkSize = lengths[h];
+        hash_job->m_ChunkHashes = &hash_job->m_SmallChunkHash;
+        hash_job->m_ChunkSizes = &hash_job->m_SmallChunkSize;
+        *hash_job->m_AssetChunkCount = 1;
     }
+
     Longtail_Free(work_mem);
-    return err;
+    work_mem = 0;
+    return 0;
 }
 
-static size_t Longtail_GetVersionIndexDataSize(
-    uint32_t asset_count,
-    uint32_t chunk_count,
-    uint32_t asset_chunk_index_count,
-    uint32_t path_data_size)
+// Large assets are chunked in parts by parallel jobs, each part chunks from the start of its range until it has
+// found the chunk that crosses the end of the range. Only the first part is guaranteed to find the same boundaries
+// as a single chunking pass over the whole asset, the other parts are in sync once one of their chunk starts is a
+// boundary of the single pass.
+// The AssetStitcher is fed the parts of an asset in order and picks up the chunks of a part from the first chunk
+// start that matches the current boundary, if there is no match it runs the chunker from the current boundary until
+// it reaches a chunk start of a part.
+struct AssetStitcher
 {
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(asset_count, "%u"),
-        LONGTAIL_LOGFIELD(chunk_count, "%u"),
-        LONGTAIL_LOGFIELD(asset_chunk_index_count, "%u"),
-        LONGTAIL_LOGFIELD(path_data_size, "%u"),
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-    LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_index_count >= chunk_count, return EINVAL)
+    struct Longtail_StorageAPI* m_StorageAPI;
+    struct Longtail_HashAPI* m_HashAPI;
+    struct Longtail_ChunkerAPI* m_ChunkerAPI;
+    const char* m_RootPath;
+    uint32_t m_TargetChunkSize;
+    uint64_t m_AssetSize;
+    uint64_t m_Pos;
+    char* m_Path;
+    Longtail_StorageAPI_HOpenFile m_AssetFile;
+    Longtail_ChunkerAPI_HChunker m_Chunker;
+    struct StorageChunkFeederContext m_FeederContext;
+    uint32_t m_ResyncCount;
+};
 
-    size_t version_index_data_size =
-        sizeof(uint32_t) +                              // m_Version
-        sizeof(uint32_t) +                              // m_HashIdentifier
-        sizeof(uint32_t) +                              // m_TargetChunkSize
-        sizeof(uint32_t) +                              // m_AssetCount
-        sizeof(uint32_t) +                              // m_ChunkCount
-        sizeof(uint32_t) +                              // m_AssetChunkIndexCount
-        (sizeof(TLongtail_Hash) * asset_count) +        // m_PathHashes
-        (sizeof(TLongtail_Hash) * asset_count) +        // m_ContentHashes
-        (sizeof(uint64_t) * asset_count) +              // m_AssetSizes
-        (sizeof(uint32_t) * asset_count) +              // m_AssetChunkCounts
-        (sizeof(uint32_t) * asset_count) +              // m_AssetChunkIndexStarts
-        (sizeof(uint32_t) * asset_chunk_index_count) +  // m_AssetChunkIndexes
-        (sizeof(TLongtail_Hash) * chunk_count) +        // m_ChunkHashes
-        (sizeof(uint32_t) * chunk_count) +              // m_ChunkSizes
-        (sizeof(uint32_t) * chunk_count) +              // m_ChunkTags
-        (sizeof(uint32_t) * asset_count) +              // m_NameOffsets
-        (sizeof(uint16_t) * asset_count) +              // m_Permissions
-        path_data_size;
+// chunk_data is zero unless the part retained its chunk data, data for rechunked chunks is only valid during the call
+typedef int (*AssetStitcher_OnChunkFunc)(void* context, TLongtail_Hash chunk_hash, uint32_t chunk_size, const uint8_t* chunk_data, int is_rechunked);
 
-    return version_index_data_size;
+static void InitAssetStitcher(
+    struct AssetStitcher* stitcher,
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    const char* root_path,
+    uint32_t target_chunk_size,
+    uint64_t asset_size)
+{
+    stitcher->m_StorageAPI = storage_api;
+    stitcher->m_HashAPI = hash_api;
+    stitcher->m_ChunkerAPI = chunker_api;
+    stitcher->m_RootPath = root_path;
+    stitcher->m_TargetChunkSize = target_chunk_size;
+    stitcher->m_AssetSize = asset_size;
+    stitcher->m_Pos = 0;
+    stitcher->m_Path = 0;
+    stitcher->m_AssetFile = 0;
+    stitcher->m_Chunker = 0;
+    stitcher->m_ResyncCount = 0;
 }
 
-size_t Longtail_GetVersionIndexSize(
-    uint32_t asset_count,
-    uint32_t chunk_count,
-    uint32_t asset_chunk_index_count,
-    uint32_t path_data_size)
+static void DisposeAssetStitcher(struct AssetStitcher* stitcher)
 {
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(asset_count, "%u"),
-        LONGTAIL_LOGFIELD(chunk_count, "%u"),
-        LONGTAIL_LOGFIELD(asset_chunk_index_count, "%u"),
-        LONGTAIL_LOGFIELD(path_data_size, "%u"),
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-    LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_index_count >= chunk_count, return EINVAL)
-    return sizeof(struct Longtail_VersionIndex) +
-            Longtail_GetVersionIndexDataSize(asset_count, chunk_count, asset_chunk_index_count, path_data_size);
+    if (stitcher->m_Chunker)
+    {
+        stitcher->m_ChunkerAPI->DisposeChunker(stitcher->m_ChunkerAPI, stitcher->m_Chunker);
+        stitcher->m_Chunker = 0;
+    }
+    if (stitcher->m_AssetFile)
+    {
+        stitcher->m_StorageAPI->CloseFile(stitcher->m_StorageAPI, stitcher->m_AssetFile);
+        stitcher->m_AssetFile = 0;
+    }
+    Longtail_Free(stitcher->m_Path);
+    stitcher->m_Path = 0;
 }
 
-static int InitVersionIndexFromData(
-    struct Longtail_VersionIndex* version_index,
-    void* data,
-    size_t data_size)
+static int StitchAssetPart(
+    struct AssetStitcher* stitcher,
+    const struct HashJob* part,
+    AssetStitcher_OnChunkFunc on_chunk_func,
+    void* context)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(data, "%p"),
-        LONGTAIL_LOGFIELD(data_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(stitcher, "%p"),
+        LONGTAIL_LOGFIELD(part, "%p"),
+        LONGTAIL_LOGFIELD(on_chunk_func, "%p"),
+        LONGTAIL_LOGFIELD(context, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-    LONGTAIL_FATAL_ASSERT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, data != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, data_size >= sizeof(uint32_t), return EBADF)
-
-    char* p = (char*)data;
 
-    size_t version_index_data_start = (size_t)(uintptr_t)p;
+    LONGTAIL_FATAL_ASSERT(ctx, part->m_AssetSize == stitcher->m_AssetSize, return EINVAL)
 
-    version_index->m_Version = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+    struct Longtail_StorageAPI* storage_api = stitcher->m_StorageAPI;
+    struct Longtail_ChunkerAPI* chunker_api = stitcher->m_ChunkerAPI;
 
-    if ((*version_index->m_Version) != LONGTAIL_VERSION_INDEX_VERSION_0_0_2)
+    uint32_t part_chunk_count = *part->m_AssetChunkCount;
+    uint64_t part_end = part->m_StartRange;
+    for (uint32_t c = 0; c < part_chunk_count; ++c)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Missmatching versions in version index data %" PRIu64 " != %" PRIu64 "", (void*)version_index->m_Version, Longtail_CurrentVersionIndexVersion);
-        return EBADF;
+        part_end += part->m_ChunkSizes[c];
     }
 
-    version_index->m_HashIdentifier = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+    uint64_t part_pos = part->m_StartRange;
+    uint32_t part_chunk_index = 0;
+    while (stitcher->m_Pos < part_end)
+    {
+        while (part_chunk_index < part_chunk_count && part_pos < stitcher->m_Pos)
+        {
+            part_pos += part->m_ChunkSizes[part_chunk_index++];
+        }
+        if (part_pos == stitcher->m_Pos)
+        {
+            if (stitcher->m_Chunker)
+            {
+                chunker_api->DisposeChunker(chunker_api, stitcher->m_Chunker);
+                stitcher->m_Chunker = 0;
+            }
+            while (part_chunk_index < part_chunk_count)
+            {
+                uint32_t chunk_size = part->m_ChunkSizes[part_chunk_index];
+                const uint8_t* chunk_data = part->m_ChunkData ? &part->m_ChunkData[part_pos - part->m_StartRange] : 0;
+                int err = on_chunk_func(context, part->m_ChunkHashes[part_chunk_index], chunk_size, chunk_data, 0);
+                if (err)
+                {
+                    return err;
+                }
+                part_pos += chunk_size;
+                stitcher->m_Pos += chunk_size;
+                ++part_chunk_index;
+            }
+            return 0;
+        }
 
-    version_index->m_TargetChunkSize = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+        if (!stitcher->m_Chunker)
+        {
+            if (!stitcher->m_AssetFile)
+            {
+                char* path = storage_api->ConcatPath(storage_api, stitcher->m_RootPath, part->m_Path);
+                int err = storage_api->OpenReadFile(storage_api, path, &stitcher->m_AssetFile);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+                    Longtail_Free(path);
+                    stitcher->m_AssetFile = 0;
+                    return err;
+                }
+                stitcher->m_Path = path;
+            }
+            uint32_t chunker_min_size;
+            int err = chunker_api->GetMinChunkSize(chunker_api, &chunker_min_size);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "chunker_api->GetMinChunkSize() failed with %d", err)
+                return err;
+            }
+            err = chunker_api->CreateChunker(
+                chunker_api,
+                MIN_CHUNKER_SIZE(chunker_min_size, stitcher->m_TargetChunkSize),
+                AVG_CHUNKER_SIZE(chunker_min_size, stitcher->m_TargetChunkSize),
+                MAX_CHUNKER_SIZE(chunker_min_size, stitcher->m_TargetChunkSize),
+                &stitcher->m_Chunker);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "chunker_api->CreateChunker() failed with %d", err)
+                stitcher->m_Chunker = 0;
+                return err;
+            }
+            stitcher->m_FeederContext.m_StorageAPI = storage_api;
+            stitcher->m_FeederContext.m_AssetFile = stitcher->m_AssetFile;
+            stitcher->m_FeederContext.m_AssetPath = stitcher->m_Path;
+            stitcher->m_FeederContext.m_StartRange = stitcher->m_Pos;
+            stitcher->m_FeederContext.m_Size = stitcher->m_AssetSize - stitcher->m_Pos;
+            stitcher->m_FeederContext.m_Offset = 0;
+        }
 
-    version_index->m_AssetCount = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+        struct Longtail_Chunker_ChunkRange chunk_range;
+        int err = chunker_api->NextChunk(chunker_api, stitcher->m_Chunker, StorageChunkFeederFunc, &stitcher->m_FeederContext, &chunk_range);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "chunker_api->NextChunk() failed with %d", err)
+            return err;
+        }
+        TLongtail_Hash chunk_hash;
+        err = stitcher->m_HashAPI->HashBuffer(stitcher->m_HashAPI, chunk_range.len, (void*)chunk_range.buf, &chunk_hash);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_api->HashBuffer() failed with %d", err)
+            return err;
+        }
+        err = on_chunk_func(context, chunk_hash, chunk_range.len, chunk_range.buf, 1);
+        if (err)
+        {
+            return err;
+        }
+        stitcher->m_Pos += chunk_range.len;
+        ++stitcher->m_ResyncCount;
+    }
+    return 0;
+}
 
-    uint32_t asset_count = *version_index->m_AssetCount;
+struct StitchedChunks
+{
+    TLongtail_Hash* m_ChunkHashes;
+    uint32_t* m_ChunkSizes;
+};
 
-    version_index->m_ChunkCount = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+static int AddStitchedChunk(void* context, TLongtail_Hash chunk_hash, uint32_t chunk_size, const uint8_t* chunk_data, int is_rechunked)
+{
+    struct StitchedChunks* stitched_chunks = (struct StitchedChunks*)context;
+    arrpush(stitched_chunks->m_ChunkHashes, chunk_hash);
+    arrpush(stitched_chunks->m_ChunkSizes, chunk_size);
+    return 0;
+}
 
-    uint32_t chunk_count = *version_index->m_ChunkCount;
+// StitchAssetParts stitches all the parts of an asset and replaces the chunks of the first part with the result.
+static int StitchAssetParts(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    const char* root_path,
+    uint32_t target_chunk_size,
+    struct HashJob* part_jobs,
+    uint32_t part_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(part_jobs, "%p"),
+        LONGTAIL_LOGFIELD(part_count, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    version_index->m_AssetChunkIndexCount = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+    LONGTAIL_FATAL_ASSERT(ctx, part_count > 1, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, part_jobs[0].m_StartRange == 0, return EINVAL)
 
-    uint32_t asset_chunk_index_count = *version_index->m_AssetChunkIndexCount;
+    uint64_t asset_size = part_jobs[0].m_AssetSize;
 
-    size_t versiom_index_data_size = Longtail_GetVersionIndexDataSize(asset_count, chunk_count, asset_chunk_index_count, 0);
-    if (versiom_index_data_size > data_size)
+    struct StitchedChunks stitched_chunks = { 0, 0 };
+    arrsetcap(stitched_chunks.m_ChunkHashes, 1024);
+    arrsetcap(stitched_chunks.m_ChunkSizes, 1024);
+
+    struct AssetStitcher stitcher;
+    InitAssetStitcher(&stitcher, storage_api, hash_api, chunker_api, root_path, target_chunk_size, asset_size);
+
+    int err = 0;
+    for (uint32_t p = 0; p < part_count && stitcher.m_Pos < asset_size; ++p)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Version index data is truncated: %" PRIu64 " <= %" PRIu64, data_size, versiom_index_data_size)
-        return EBADF;
+        err = StitchAssetPart(&stitcher, &part_jobs[p], AddStitchedChunk, &stitched_chunks);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "StitchAssetPart() failed with %d", err)
+            break;
+        }
     }
 
-    version_index->m_PathHashes = (TLongtail_Hash*)(void*)p;
-    p += (sizeof(TLongtail_Hash) * asset_count);
-
-    version_index->m_ContentHashes = (TLongtail_Hash*)(void*)p;
-    p += (sizeof(TLongtail_Hash) * asset_count);
+    uint64_t pos = stitcher.m_Pos;
+    uint32_t resync_count = stitcher.m_ResyncCount;
+    DisposeAssetStitcher(&stitcher);
 
-    version_index->m_AssetSizes = (uint64_t*)(void*)p;
-    p += (sizeof(uint64_t) * asset_count);
+    LONGTAIL_FATAL_ASSERT(ctx, err || pos == asset_size, err = EINVAL)
 
-    version_index->m_AssetChunkCounts = (uint32_t*)(void*)p;
-    p += (sizeof(uint32_t) * asset_count);
+    if (!err)
+    {
+        uint32_t chunk_count = (uint32_t)arrlen(stitched_chunks.m_ChunkHashes);
+        void* output_mem = Longtail_Alloc("StitchAssetParts", sizeof(TLongtail_Hash) * chunk_count + sizeof(uint32_t) * chunk_count);
+        if (!output_mem)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            err = ENOMEM;
+        }
+        else
+        {
+            TLongtail_Hash* output_chunk_hashes = (TLongtail_Hash*)output_mem;
+            uint32_t* output_chunk_sizes = (uint32_t*)&output_chunk_hashes[chunk_count];
+            memcpy(output_chunk_hashes, stitched_chunks.m_ChunkHashes, sizeof(TLongtail_Hash) * chunk_count);
+            memcpy(output_chunk_sizes, stitched_chunks.m_ChunkSizes, sizeof(uint32_t) * chunk_count);
+            Longtail_Free(part_jobs[0].m_ChunkHashes);
+            part_jobs[0].m_ChunkHashes = output_chunk_hashes;
+            part_jobs[0].m_ChunkSizes = output_chunk_sizes;
+            *part_jobs[0].m_AssetChunkCount = chunk_count;
+            for (uint32_t p = 1; p < part_count; ++p)
+            {
+                *part_jobs[p].m_AssetChunkCount = 0;
+            }
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Stitched %u parts into %u chunks, rechunked %u chunks", part_count, chunk_count, resync_count)
+        }
+    }
 
-    version_index->m_AssetChunkIndexStarts = (uint32_t*)(void*)p;
-    p += (sizeof(uint32_t) * asset_count);
+    arrfree(stitched_chunks.m_ChunkSizes);
+    arrfree(stitched_chunks.m_ChunkHashes);
+    return err;
+}
 
-    version_index->m_AssetChunkIndexes = (uint32_t*)(void*)p;
-    p += (sizeof(uint32_t) * asset_chunk_index_count);
+struct ChunkAssetsData {
+    uint32_t m_ChunkCount;
+    TLongtail_Hash* m_ChunkHashes;
+    uint32_t* m_ChunkSizes;
+    uint32_t* m_ChunkTags;
+};
 
-    version_index->m_ChunkHashes = (TLongtail_Hash*)(void*)p;
-    p += (sizeof(TLongtail_Hash) * chunk_count);
-
-    version_index->m_ChunkSizes = (uint32_t*)(void*)p;
-    p += (sizeof(uint32_t) * chunk_count);
-
-    version_index->m_ChunkTags = (uint32_t*)(void*)p;
-    p += (sizeof(uint32_t) * chunk_count);
-
-    version_index->m_NameOffsets = (uint32_t*)(void*)p;
-    p += (sizeof(uint32_t) * asset_count);
-
-    version_index->m_Permissions = (uint16_t*)(void*)p;
-    p += (sizeof(uint16_t) * asset_count);
-
-    size_t version_index_name_data_start = (size_t)p;
-
-    version_index->m_NameDataSize = (uint32_t)(data_size - (version_index_name_data_start - version_index_data_start));
-
-    version_index->m_NameData = (char*)p;
-
-    return 0;
-}
-
-int Longtail_BuildVersionIndex(
-    void* mem,
-    size_t mem_size,
-    const struct Longtail_FileInfos* file_infos,
-    const TLongtail_Hash* path_hashes,
-    const TLongtail_Hash* content_hashes,
-    const uint32_t* asset_chunk_index_starts,
-    const uint32_t* asset_chunk_counts,
-    uint32_t asset_chunk_index_count,
-    const uint32_t* asset_chunk_indexes,
-    uint32_t chunk_count,
-    const uint32_t* chunk_sizes,
-    const TLongtail_Hash* chunk_hashes,
-    const uint32_t* optional_chunk_tags,
-    uint32_t hash_api_identifier,
-    uint32_t target_chunk_size,
-    struct Longtail_VersionIndex** out_version_index)
+struct ChunkAssetsData* AllocChunkAssetsData(uint32_t chunk_count)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(mem, "%p"),
-        LONGTAIL_LOGFIELD(mem_size, "%p"),
-        LONGTAIL_LOGFIELD(file_infos, "%p"),
-        LONGTAIL_LOGFIELD(path_hashes, "%p"),
-        LONGTAIL_LOGFIELD(content_hashes, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_index_starts, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_index_count, "%u"),
-        LONGTAIL_LOGFIELD(asset_chunk_indexes, "%p"),
-        LONGTAIL_LOGFIELD(chunk_count, "%u"),
-        LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
-        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
-        LONGTAIL_LOGFIELD(optional_chunk_tags, "%p"),
-        LONGTAIL_LOGFIELD(hash_api_identifier, "%u"),
-        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
-        LONGTAIL_LOGFIELD(out_version_index, "%p")
+        LONGTAIL_LOGFIELD(chunk_count, "%u")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-    LONGTAIL_VALIDATE_INPUT(ctx, mem != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, mem_size != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || path_hashes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || content_hashes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_counts == 0 || asset_chunk_index_starts != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || asset_chunk_counts != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_index_count >= chunk_count, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || asset_chunk_indexes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
-
-    uint32_t asset_count = file_infos == 0 ? 0u : file_infos->m_Count;
-    struct Longtail_VersionIndex* version_index = (struct Longtail_VersionIndex*)mem;
-    uint32_t* p = (uint32_t*)(void*)&version_index[1];
-    version_index->m_Version = &p[0];
-    version_index->m_HashIdentifier = &p[1];
-    version_index->m_TargetChunkSize = &p[2];
-    version_index->m_AssetCount = &p[3];
-    version_index->m_ChunkCount = &p[4];
-    version_index->m_AssetChunkIndexCount = &p[5];
-    *version_index->m_Version = Longtail_CurrentVersionIndexVersion;
-    *version_index->m_HashIdentifier = hash_api_identifier;
-    *version_index->m_TargetChunkSize = target_chunk_size;
-    *version_index->m_AssetCount = asset_count;
-    *version_index->m_ChunkCount = chunk_count;
-    *version_index->m_AssetChunkIndexCount = asset_chunk_index_count;
-
-    size_t index_data_size = mem_size - sizeof(struct Longtail_VersionIndex);
-    int err = InitVersionIndexFromData(version_index, &version_index[1], index_data_size);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "InitVersionIndexFromData() failed with %d", err);
-        return err;
-    }
-
-    if (asset_count > 0)
+    size_t size = sizeof(struct ChunkAssetsData) +
+        sizeof(TLongtail_Hash) * chunk_count +
+        sizeof(uint32_t) * chunk_count +
+        sizeof(uint32_t) * chunk_count;
+    void* mem = Longtail_Alloc("AllocChunkAssetsData", size);
+    if (!mem)
     {
-        memmove(version_index->m_PathHashes, path_hashes, sizeof(TLongtail_Hash) * asset_count);
-        memmove(version_index->m_ContentHashes, content_hashes, sizeof(TLongtail_Hash) * asset_count);
-        memmove(version_index->m_AssetSizes, file_infos->m_Sizes, sizeof(uint64_t) * asset_count);
-        memmove(version_index->m_AssetChunkCounts, asset_chunk_counts, sizeof(uint32_t) * asset_count);
-        memmove(version_index->m_AssetChunkIndexStarts, asset_chunk_index_starts, sizeof(uint32_t) * asset_count);
-        memmove(version_index->m_AssetChunkIndexes, asset_chunk_indexes, sizeof(uint32_t) * asset_chunk_index_count);
-        memmove(version_index->m_ChunkHashes, chunk_hashes, sizeof(TLongtail_Hash) * chunk_count);
-        memmove(version_index->m_ChunkSizes, chunk_sizes, sizeof(uint32_t) * chunk_count);
-        if (optional_chunk_tags)
-        {
-            memmove(version_index->m_ChunkTags, optional_chunk_tags, sizeof(uint32_t) * chunk_count);
-        }
-        else
-        {
-            memset(version_index->m_ChunkTags, 0, sizeof(uint32_t) * chunk_count);
-        }
-        memmove(version_index->m_NameOffsets, file_infos->m_PathStartOffsets, sizeof(uint32_t) * asset_count);
-        memmove(version_index->m_Permissions, file_infos->m_Permissions, sizeof(uint16_t) * asset_count);
-        memmove(version_index->m_NameData, file_infos->m_PathData, file_infos->m_PathDataSize);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
     }
-
-    *out_version_index = version_index;
-    return 0;
+    struct ChunkAssetsData* chunk_assets_data = (struct ChunkAssetsData*)mem;
+    chunk_assets_data->m_ChunkCount = chunk_count;
+    chunk_assets_data->m_ChunkHashes = (TLongtail_Hash*)&chunk_assets_data[1];
+    chunk_assets_data->m_ChunkSizes = (uint32_t*)&chunk_assets_data->m_ChunkHashes[chunk_count];
+    chunk_assets_data->m_ChunkTags = (uint32_t*)&chunk_assets_data->m_ChunkSizes[chunk_count];
+    return chunk_assets_data;
 }
 
-int Longtail_CreateVersionIndex(
+static int ChunkAssets(
     struct Longtail_StorageAPI* storage_api,
     struct Longtail_HashAPI* hash_api,
     struct Longtail_ChunkerAPI* chunker_api,
@@ -2457,9 +2918,13 @@ int Longtail_CreateVersionIndex(
     Longtail_CancelAPI_HCancelToken optional_cancel_token,
     const char* root_path,
     const struct Longtail_FileInfos* file_infos,
+    TLongtail_Hash* path_hashes,
+    TLongtail_Hash* content_hashes,
     const uint32_t* optional_asset_tags,
+    uint32_t* asset_chunk_start_index,
+    uint32_t* asset_chunk_counts,
     uint32_t target_chunk_size,
-    struct Longtail_VersionIndex** out_version_index)
+    struct ChunkAssetsData** out_chunk_assets_data)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(storage_api, "%p"),
@@ -2471,3328 +2936,7886 @@ int Longtail_CreateVersionIndex(
         LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
         LONGTAIL_LOGFIELD(root_path, "%s"),
         LONGTAIL_LOGFIELD(file_infos, "%p"),
-        LONGTAIL_LOGFIELD(optional_asset_tags, "%u"),
+        LONGTAIL_LOGFIELD(path_hashes, "%p"),
+        LONGTAIL_LOGFIELD(content_hashes, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_tags, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_start_index, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
         LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
-        LONGTAIL_LOGFIELD(out_version_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+        LONGTAIL_LOGFIELD(out_chunk_assets_data, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || root_path != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || target_chunk_size > 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || out_version_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, root_path != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, file_infos != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, path_hashes != 0, return EINVAL)
 
-    uint32_t path_count = file_infos == 0 ? 0u : file_infos->m_Count;
+    LONGTAIL_FATAL_ASSERT(ctx, content_hashes != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, asset_chunk_start_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, asset_chunk_counts != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, target_chunk_size != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, out_chunk_assets_data != 0, return EINVAL)
 
-    if (path_count == 0)
+    uint32_t asset_count = file_infos->m_Count;
+
+    uint64_t max_hash_size = target_chunk_size * 1024;
+    uint32_t job_count = 0;
+
+    for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
     {
-        size_t version_index_size = Longtail_GetVersionIndexSize(path_count, 0, 0, 0);
-        void* version_index_mem = Longtail_Alloc("CreateVersionIndex", version_index_size);
-        if (!version_index_mem)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-            return ENOMEM;
-        }
+        uint64_t asset_size = file_infos->m_Sizes[asset_index];
+        uint64_t asset_part_count = 1 + (asset_size / max_hash_size);
+        job_count += (uint32_t)asset_part_count;
+    }
 
-        struct Longtail_VersionIndex* version_index;
-        int err = Longtail_BuildVersionIndex(
-            version_index_mem,              // mem
-            version_index_size,             // mem_size
-            file_infos,                          // paths
-            0,                    // path_hashes
-            0,                 // content_hashes
-            0,        // asset_chunk_index_starts
-            0,             // asset_chunk_counts
-            0,       // asset_chunk_index_count
-            0,            // asset_chunk_indexes
-            0,             // chunk_count
-            0,           // chunk_sizes
-            0,           // chunk_hashes
-            0,          // chunk_tags
-            hash_api->GetIdentifier(hash_api),
-            target_chunk_size,
-            &version_index);
+    if (job_count == 0)
+    {
+        return 0;
+    }
+
+    // Assets no larger than the minimum chunk size are a single chunk and are hashed in batches, see DynamicChunkingBatch
+    uint32_t small_asset_max_size = 0;
+    if (chunker_api)
+    {
+        uint32_t chunker_min_size;
+        int err = chunker_api->GetMinChunkSize(chunker_api, &chunker_min_size);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndex() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "chunker_api->GetMinChunkSize() failed with %d", err)
             return err;
         }
-        *out_version_index = version_index;
-        return 0;
+        small_asset_max_size = MIN_CHUNKER_SIZE(chunker_min_size, target_chunk_size);
     }
 
-    size_t work_mem_size = (sizeof(TLongtail_Hash) * path_count) +
-        (sizeof(TLongtail_Hash) * path_count) +
-        (sizeof(uint32_t) * path_count) +
-        (sizeof(uint32_t) * path_count);
-    void* work_mem = Longtail_Alloc("CreateVersionIndex", work_mem_size);
+    size_t work_mem_size = (sizeof(uint32_t) * job_count) +
+        (sizeof(struct HashJob) * job_count) +
+        (sizeof(struct HashBatchJob) * job_count) +
+        (sizeof(Longtail_JobAPI_JobFunc) * job_count) +
+        (sizeof(void*) * job_count);
+    void* work_mem = Longtail_Alloc("ChunkAssets", work_mem_size);
     if (!work_mem)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
 
-    TLongtail_Hash* tmp_path_hashes = (TLongtail_Hash*)work_mem;
-    TLongtail_Hash* tmp_content_hashes = (TLongtail_Hash*)&tmp_path_hashes[path_count];
-    uint32_t* tmp_asset_chunk_counts = (uint32_t*)&tmp_content_hashes[path_count];
-    uint32_t* tmp_asset_chunk_start_index = (uint32_t*)&tmp_asset_chunk_counts[path_count];
-
-    struct ChunkAssetsData* chunk_assets_data;
+    uint32_t* tmp_job_chunk_counts = (uint32_t*)work_mem;
+    struct HashJob* tmp_hash_jobs = (struct HashJob*)&tmp_job_chunk_counts[job_count];
+    struct HashBatchJob* batch_jobs = (struct HashBatchJob*)&tmp_hash_jobs[job_count];
+    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)&batch_jobs[job_count];
+    void** ctxs = (void**)&funcs[job_count];
 
-    int err = ChunkAssets(
-        storage_api,
-        hash_api,
-        chunker_api,
-        job_api,
-        progress_api,
-        optional_cancel_api,
-        optional_cancel_token,
-        root_path,
-        file_infos,
-        tmp_path_hashes,
-        tmp_content_hashes,
-        optional_asset_tags,
-        tmp_asset_chunk_start_index,
-        tmp_asset_chunk_counts,
-        target_chunk_size,
-        &chunk_assets_data);
-    if (err)
+    uint32_t hash_jobs_count = 0;
+    uint32_t jobs_started = 0;
+    struct HashBatchJob* current_batch = 0;
+    for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
     {
-        LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "ChunkAssets() failed with %d", err)
-        Longtail_Free(work_mem);
-        return err;
-    }
+        uint64_t asset_size = file_infos->m_Sizes[asset_index];
+        uint64_t asset_part_count = 1 + (asset_size / max_hash_size);
 
-    uint32_t assets_chunk_index_count = chunk_assets_data->m_ChunkCount;
-    uint32_t* asset_chunk_sizes = chunk_assets_data->m_ChunkSizes;
-    uint32_t* asset_chunk_tags = chunk_assets_data->m_ChunkTags;
-    TLongtail_Hash* asset_chunk_hashes = chunk_assets_data->m_ChunkHashes;
+        for (uint64_t job_part = 0; job_part < asset_part_count; ++job_part)
+        {
+            LONGTAIL_FATAL_ASSERT(ctx, hash_jobs_count < job_count, return EINVAL)
 
-    size_t work_mem_compact_size = (sizeof(uint32_t) * assets_chunk_index_count) +
-        (sizeof(TLongtail_Hash) * assets_chunk_index_count) + 
-        (sizeof(uint32_t) * assets_chunk_index_count) +
-        (sizeof(uint32_t) * assets_chunk_index_count) +
-        Longtail_LookupTable_GetSize(assets_chunk_index_count);
-    void* work_mem_compact = Longtail_Alloc("CreateVersionIndex", work_mem_compact_size);
-    if (!work_mem_compact)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        Longtail_Free(chunk_assets_data);
-        Longtail_Free(work_mem);
-        return ENOMEM;
-    }
+            uint64_t range_start = job_part * max_hash_size;
+            uint64_t job_size = (asset_size - range_start) > max_hash_size ? max_hash_size : (asset_size - range_start);
 
-    uint32_t* tmp_asset_chunk_indexes = (uint32_t*)work_mem_compact;
-    TLongtail_Hash* tmp_compact_chunk_hashes = (TLongtail_Hash*)&tmp_asset_chunk_indexes[assets_chunk_index_count];
-    uint32_t* tmp_compact_chunk_sizes =  (uint32_t*)&tmp_compact_chunk_hashes[assets_chunk_index_count];
-    uint32_t* tmp_compact_chunk_tags =  (uint32_t*)&tmp_compact_chunk_sizes[assets_chunk_index_count];
+            struct HashJob* job = &tmp_hash_jobs[hash_jobs_count];
+            job->m_StorageAPI = storage_api;
+            job->m_HashAPI = hash_api;
+            job->m_ChunkerAPI = chunker_api;
+            job->m_RootPath = root_path;
+            job->m_Path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[asset_index]];
+            job->m_PathHash = (job_part == 0) ? &path_hashes[asset_index] : 0;
+            job->m_AssetIndex = asset_index;
+            job->m_StartRange = range_start;
+            job->m_SizeRange = job_size;
+            job->m_AssetSize = asset_size;
+            job->m_AssetChunkCount = &tmp_job_chunk_counts[hash_jobs_count];
+            job->m_ChunkHashes = 0;
+            job->m_ChunkSizes = 0;
+            job->m_ChunkData = 0;
+            job->m_TargetChunkSize = target_chunk_size;
+            job->m_RetainChunkData = 0;
+            job->m_Err = EINVAL;
+            job->m_SmallChunkHash = 0;
+            job->m_SmallChunkSize = 0;
+            ++hash_jobs_count;
 
-    uint32_t unique_chunk_count = 0;
-    struct Longtail_LookupTable* chunk_hash_to_index = Longtail_LookupTable_Create(&tmp_compact_chunk_tags[assets_chunk_index_count], assets_chunk_index_count, 0);
+            if (asset_size > small_asset_max_size)
+            {
+                current_batch = 0;
+                funcs[jobs_started] = DynamicChunking;
+                ctxs[jobs_started] = job;
+                ++jobs_started;
+                continue;
+            }
 
-    for (uint32_t c = 0; c < assets_chunk_index_count; ++c)
-    {
-        TLongtail_Hash h = asset_chunk_hashes[c];
-        uint32_t* chunk_index = Longtail_LookupTable_PutUnique(chunk_hash_to_index, h, unique_chunk_count);
-        if (chunk_index == 0)
-        {
-            tmp_compact_chunk_hashes[unique_chunk_count] = h;
-            tmp_compact_chunk_sizes[unique_chunk_count] = asset_chunk_sizes[c];
-            tmp_compact_chunk_tags[unique_chunk_count] = asset_chunk_tags[c];
-            tmp_asset_chunk_indexes[c] = unique_chunk_count;
-            ++unique_chunk_count;
-        }
-        else
-        {
-            tmp_asset_chunk_indexes[c] = *chunk_index;
+            if (current_batch == 0 ||
+                current_batch->m_HashJobCount == SMALL_ASSET_BATCH_MAX_COUNT ||
+                current_batch->m_BatchSize + asset_size > SMALL_ASSET_BATCH_MAX_SIZE)
+            {
+                current_batch = &batch_jobs[jobs_started];
+                current_batch->m_HashJobs = job;
+                current_batch->m_HashJobCount = 0;
+                current_batch->m_BatchSize = 0;
+                funcs[jobs_started] = DynamicChunkingBatch;
+                ctxs[jobs_started] = current_batch;
+                ++jobs_started;
+            }
+            ++current_batch->m_HashJobCount;
+            current_batch->m_BatchSize += (uint32_t)asset_size;
         }
     }
 
-    size_t version_index_size = Longtail_GetVersionIndexSize(path_count, unique_chunk_count, assets_chunk_index_count, file_infos->m_PathDataSize);
-    void* version_index_mem = Longtail_Alloc("CreateVersionIndex", version_index_size);
-    if (!version_index_mem)
+    Longtail_JobAPI_Group job_group = 0;
+    int err = job_api->ReserveJobs(job_api, jobs_started, &job_group);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        Longtail_Free(work_mem_compact);
-        Longtail_Free(chunk_assets_data);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
         Longtail_Free(work_mem);
-        return ENOMEM;
+        return err;
     }
 
-    struct Longtail_VersionIndex* version_index;
-    err = Longtail_BuildVersionIndex(
-        version_index_mem,              // mem
-        version_index_size,             // mem_size
-        file_infos,                          // paths
-        tmp_path_hashes,                    // path_hashes
-        tmp_content_hashes,                 // content_hashes
-        tmp_asset_chunk_start_index,        // asset_chunk_index_starts
-        tmp_asset_chunk_counts,             // asset_chunk_counts
-        assets_chunk_index_count,       // asset_chunk_index_count
-        tmp_asset_chunk_indexes,            // asset_chunk_indexes
-        unique_chunk_count,             // chunk_count
-        tmp_compact_chunk_sizes,            // chunk_sizes
-        tmp_compact_chunk_hashes,           // chunk_hashes
-        tmp_compact_chunk_tags,// chunk_tags
-        hash_api->GetIdentifier(hash_api),
-        target_chunk_size,
-        &version_index);
+    // TODO: Add logic here if we end up creating more jobs than can be held in a uint32_t
+    LONGTAIL_FATAL_ASSERT(ctx, jobs_started < 0xffffffff, return ENOMEM);
+    Longtail_JobAPI_Jobs jobs;
+    err = job_api->CreateJobs(job_api, job_group, (uint32_t)jobs_started, funcs, ctxs, &jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+    err = job_api->ReadyJobs(job_api, (uint32_t)jobs_started, jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+
+    err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndex() failed with %d", err)
-        Longtail_Free(work_mem_compact);
-        Longtail_Free(version_index_mem);
-        Longtail_Free(chunk_assets_data);
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        FreeHashJobChunks(tmp_hash_jobs, hash_jobs_count);
         Longtail_Free(work_mem);
         return err;
     }
 
-    Longtail_Free(work_mem_compact);
-    Longtail_Free(chunk_assets_data);
-    Longtail_Free(work_mem);
-
-    *out_version_index = version_index;
-    return 0;
-}
+    err = 0;
+    for (uint32_t i = 0; i < hash_jobs_count; ++i)
+    {
+        if (tmp_hash_jobs[i].m_Err)
+        {
+            LONGTAIL_LOG(ctx, (tmp_hash_jobs[i].m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "tmp_hash_jobs[i].m_Err failed with %d", tmp_hash_jobs[i].m_Err)
+            err = err ? err : tmp_hash_jobs[i].m_Err;
+        }
+    }
 
-int Longtail_WriteVersionIndexToBuffer(
-    const struct Longtail_VersionIndex* version_index,
-    void** out_buffer,
-    size_t* out_size)
-{
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(out_buffer, "%p"),
-        LONGTAIL_LOGFIELD(out_size, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_buffer != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_size != 0, return EINVAL)
+    for (uint32_t i = 0; i < hash_jobs_count && !err; ++i)
+    {
+        uint32_t part_count = 1;
+        while ((i + part_count < hash_jobs_count) && (tmp_hash_jobs[i + part_count].m_AssetIndex == tmp_hash_jobs[i].m_AssetIndex))
+        {
+            ++part_count;
+        }
+        if (part_count > 1)
+        {
+            err = StitchAssetParts(
+                storage_api,
+                hash_api,
+                chunker_api,
+                root_path,
+                target_chunk_size,
+                &tmp_hash_jobs[i],
+                part_count);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "StitchAssetParts() failed with %d", err)
+            }
+        }
+        i += part_count - 1;
+    }
 
-    size_t index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
-    *out_buffer = Longtail_Alloc("WriteVersionIndexToBuffer", index_data_size);
-    if (!(*out_buffer))
+    if (!err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
+        uint32_t built_chunk_count = 0;
+        for (uint32_t i = 0; i < hash_jobs_count; ++i)
+        {
+            built_chunk_count += *tmp_hash_jobs[i].m_AssetChunkCount;
+        }
+
+        struct ChunkAssetsData* cad = AllocChunkAssetsData(built_chunk_count);
+        if (!cad)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AllocChunkAssetsData() failed with %d", ENOMEM)
+            FreeHashJobChunks(tmp_hash_jobs, hash_jobs_count);
+            Longtail_Free(work_mem);
+            return ENOMEM;
+        }
+
+        uint32_t chunk_offset = 0;
+        for (uint32_t i = 0; i < hash_jobs_count; ++i)
+        {
+            uint32_t asset_index = tmp_hash_jobs[i].m_AssetIndex;
+            if (tmp_hash_jobs[i].m_StartRange == 0)
+            {
+                asset_chunk_start_index[asset_index] = chunk_offset;
+                asset_chunk_counts[asset_index] = 0;
+            }
+            uint32_t job_chunk_count = *tmp_hash_jobs[i].m_AssetChunkCount;
+            asset_chunk_counts[asset_index] += job_chunk_count;
+            for (uint32_t chunk_index = 0; chunk_index < job_chunk_count; ++chunk_index)
+            {
+                cad->m_ChunkSizes[chunk_offset] = tmp_hash_jobs[i].m_ChunkSizes[chunk_index];
+                cad->m_ChunkHashes[chunk_offset] = tmp_hash_jobs[i].m_ChunkHashes[chunk_index];
+                cad->m_ChunkTags[chunk_offset] = optional_asset_tags ? optional_asset_tags[asset_index] : 0;
+                ++chunk_offset;
+            }
+        }
+        FreeHashJobChunks(tmp_hash_jobs, hash_jobs_count);
+
+        size_t content_hash_mem_size = (sizeof(const void*) * asset_count) + (sizeof(uint32_t) * asset_count);
+        void* content_hash_mem = Longtail_Alloc("ChunkAssets", content_hash_mem_size);
+        if (!content_hash_mem)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            Longtail_Free(cad);
+            Longtail_Free(work_mem);
+            return ENOMEM;
+        }
+        const void** content_datas = (const void**)content_hash_mem;
+        uint32_t* content_lengths = (uint32_t*)&content_datas[asset_count];
+        for (uint32_t a = 0; a < asset_count; ++a)
+        {
+            content_datas[a] = &cad->m_ChunkHashes[asset_chunk_start_index[a]];
+            content_lengths[a] = (uint32_t)(sizeof(TLongtail_Hash) * asset_chunk_counts[a]);
+        }
+        err = Longtail_Hash_HashBuffers(hash_api, asset_count, content_lengths, content_datas, content_hashes);
+        Longtail_Free(content_hash_mem);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Hash_HashBuffers() failed with %d", err)
+            Longtail_Free(cad);
+            Longtail_Free(work_mem);
+            return err;
+        }
+        *out_chunk_assets_data = cad;
     }
-    memcpy(*out_buffer, &version_index[1], index_data_size);
-    *out_size = index_data_size;
-    return 0;
+
+    FreeHashJobChunks(tmp_hash_jobs, hash_jobs_count);
+    Longtail_Free(work_mem);
+    return err;
 }
 
-int Longtail_WriteVersionIndex(
+// Chunks the assets that changed since @p previous_version_index was created and copies the chunks of the
+// unchanged assets from it. An asset is unchanged if its path, size and modification time all match the
+// entry in @p previous_file_infos, the file infos that @p previous_version_index was created from.
+// The result is identical to what ChunkAssets() would produce for all of @p file_infos.
+static int ChunkChangedAssets(
     struct Longtail_StorageAPI* storage_api,
-    struct Longtail_VersionIndex* version_index,
-    const char* path)
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const struct Longtail_VersionIndex* previous_version_index,
+    const struct Longtail_FileInfos* previous_file_infos,
+    TLongtail_Hash* path_hashes,
+    TLongtail_Hash* content_hashes,
+    const uint32_t* optional_asset_tags,
+    uint32_t* asset_chunk_start_index,
+    uint32_t* asset_chunk_counts,
+    uint32_t target_chunk_size,
+    struct ChunkAssetsData** out_chunk_assets_data)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(storage_api, "%p"),
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(path, "%s")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
+        LONGTAIL_LOGFIELD(previous_version_index, "%p"),
+        LONGTAIL_LOGFIELD(previous_file_infos, "%p"),
+        LONGTAIL_LOGFIELD(path_hashes, "%p"),
+        LONGTAIL_LOGFIELD(content_hashes, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_tags, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_start_index, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(out_chunk_assets_data, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    size_t index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
+    LONGTAIL_FATAL_ASSERT(ctx, previous_version_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, previous_file_infos != 0, return EINVAL)
 
-    int err = EnsureParentPathExists(storage_api, path);
-    if (err)
+    uint32_t asset_count = file_infos->m_Count;
+    uint32_t previous_asset_count = *previous_version_index->m_AssetCount;
+
+    if ((*previous_version_index->m_HashIdentifier != hash_api->GetIdentifier(hash_api)) ||
+        (*previous_version_index->m_TargetChunkSize != target_chunk_size) ||
+        (previous_file_infos->m_Count != previous_asset_count))
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
-        return err;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Previous version index was created with different settings, chunking all %u assets", asset_count)
+        return ChunkAssets(
+            storage_api,
+            hash_api,
+            chunker_api,
+            job_api,
+            progress_api,
+            optional_cancel_api,
+            optional_cancel_token,
+            root_path,
+            file_infos,
+            path_hashes,
+            content_hashes,
+            optional_asset_tags,
+            asset_chunk_start_index,
+            asset_chunk_counts,
+            target_chunk_size,
+            out_chunk_assets_data);
+    }
+
+    size_t work_mem_size = (sizeof(uint32_t) * asset_count) +
+        (sizeof(uint32_t) * asset_count) +
+        (sizeof(uint32_t) * asset_count) +
+        (sizeof(TLongtail_Hash) * asset_count) +
+        (sizeof(TLongtail_Hash) * asset_count) +
+        (sizeof(uint32_t) * asset_count) +
+        (sizeof(uint32_t) * asset_count) +
+        Longtail_LookupTable_GetSize(previous_asset_count);
+    void* work_mem = Longtail_Alloc("ChunkChangedAssets", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
     }
-    Longtail_StorageAPI_HOpenFile file_handle;
-    err = storage_api->OpenWriteFile(storage_api, path, 0, &file_handle);
-    if (err)
+    uint32_t* previous_asset_indexes = (uint32_t*)work_mem;
+    uint32_t* changed_asset_indexes = &previous_asset_indexes[asset_count];
+    uint32_t* changed_asset_tags = &changed_asset_indexes[asset_count];
+    TLongtail_Hash* changed_path_hashes = (TLongtail_Hash*)&changed_asset_tags[asset_count];
+    TLongtail_Hash* changed_content_hashes = &changed_path_hashes[asset_count];
+    uint32_t* changed_chunk_start_index = (uint32_t*)&changed_content_hashes[asset_count];
+    uint32_t* changed_chunk_counts = &changed_chunk_start_index[asset_count];
+    struct Longtail_LookupTable* previous_path_hash_to_index = Longtail_LookupTable_Create(&changed_chunk_counts[asset_count], previous_asset_count, 0);
+
+    for (uint32_t a = 0; a < previous_asset_count; ++a)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile) failed with %d",err)
-        return err;
+        Longtail_LookupTable_PutUnique(previous_path_hash_to_index, previous_version_index->m_PathHashes[a], a);
     }
-    err = storage_api->Write(storage_api, file_handle, 0, index_data_size, &version_index[1]);
-    if (err)
+
+    uint32_t changed_asset_count = 0;
+    uint32_t changed_path_data_size = 0;
+    uint32_t reused_chunk_count = 0;
+    for (uint32_t a = 0; a < asset_count; ++a)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
-        storage_api->CloseFile(storage_api, file_handle);
-        file_handle = 0;
-        return err;
+        const char* path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[a]];
+        int err = Longtail_GetPathHash(hash_api, path, &path_hashes[a]);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_GetPathHash() failed with %d", err)
+            Longtail_Free(work_mem);
+            return err;
+        }
+        previous_asset_indexes[a] = 0xffffffffu;
+        const uint32_t* previous_index_ptr = Longtail_LookupTable_Get(previous_path_hash_to_index, path_hashes[a]);
+        // A zero modification time means the storage does not track it, we can't tell if the content changed
+        if (previous_index_ptr && (file_infos->m_ModificationTimes[a] != 0))
+        {
+            uint32_t p = *previous_index_ptr;
+            if ((file_infos->m_ModificationTimes[a] == previous_file_infos->m_ModificationTimes[p]) &&
+                (file_infos->m_Sizes[a] == previous_file_infos->m_Sizes[p]) &&
+                (file_infos->m_Sizes[a] == previous_version_index->m_AssetSizes[p]) &&
+                (strcmp(path, &previous_file_infos->m_PathData[previous_file_infos->m_PathStartOffsets[p]]) == 0) &&
+                (strcmp(path, &previous_version_index->m_NameData[previous_version_index->m_NameOffsets[p]]) == 0))
+            {
+                previous_asset_indexes[a] = p;
+                reused_chunk_count += previous_version_index->m_AssetChunkCounts[p];
+                continue;
+            }
+        }
+        changed_asset_indexes[changed_asset_count] = a;
+        changed_asset_tags[changed_asset_count] = optional_asset_tags ? optional_asset_tags[a] : 0;
+        changed_path_data_size += (uint32_t)strlen(path) + 1;
+        ++changed_asset_count;
     }
-    storage_api->CloseFile(storage_api, file_handle);
-    file_handle = 0;
 
-    return 0;
-}
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Reusing chunks for %u out of %u assets", asset_count - changed_asset_count, asset_count)
 
-int Longtail_ReadVersionIndexFromBuffer(
-    const void* buffer,
-    size_t size,
-    struct Longtail_VersionIndex** out_version_index)
-{
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(buffer, "%p"),
-        LONGTAIL_LOGFIELD(size, "%" PRIu64),
-        LONGTAIL_LOGFIELD(out_version_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-    LONGTAIL_VALIDATE_INPUT(ctx, buffer != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, size != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
+    struct ChunkAssetsData* changed_chunk_assets_data = 0;
+    if (changed_asset_count > 0)
+    {
+        struct Longtail_FileInfos* changed_file_infos = CreateFileInfos(changed_asset_count, changed_path_data_size);
+        if (!changed_file_infos)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateFileInfos() failed with %d", ENOMEM)
+            Longtail_Free(work_mem);
+            return ENOMEM;
+        }
+        for (uint32_t c = 0; c < changed_asset_count; ++c)
+        {
+            uint32_t a = changed_asset_indexes[c];
+            const char* path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[a]];
+            uint32_t path_size = (uint32_t)strlen(path) + 1;
+            changed_file_infos->m_Sizes[c] = file_infos->m_Sizes[a];
+            changed_file_infos->m_ModificationTimes[c] = file_infos->m_ModificationTimes[a];
+            changed_file_infos->m_Permissions[c] = file_infos->m_Permissions[a];
+            changed_file_infos->m_PathStartOffsets[c] = changed_file_infos->m_PathDataSize;
+            memcpy(&changed_file_infos->m_PathData[changed_file_infos->m_PathDataSize], path, path_size);
+            changed_file_infos->m_PathDataSize += path_size;
+        }
+        changed_file_infos->m_Count = changed_asset_count;
 
-    size_t version_index_size = sizeof(struct Longtail_VersionIndex) + size;
-    struct Longtail_VersionIndex* version_index = (struct Longtail_VersionIndex*)Longtail_Alloc("ReadVersionIndexFromBuffer", version_index_size);
-    if (!version_index)
+        int err = ChunkAssets(
+            storage_api,
+            hash_api,
+            chunker_api,
+            job_api,
+            progress_api,
+            optional_cancel_api,
+            optional_cancel_token,
+            root_path,
+            changed_file_infos,
+            changed_path_hashes,
+            changed_content_hashes,
+            optional_asset_tags ? changed_asset_tags : 0,
+            changed_chunk_start_index,
+            changed_chunk_counts,
+            target_chunk_size,
+            &changed_chunk_assets_data);
+        Longtail_Free(changed_file_infos);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "ChunkAssets() failed with %d", err)
+            Longtail_Free(work_mem);
+            return err;
+        }
+    }
+
+    uint32_t chunk_count = reused_chunk_count + (changed_chunk_assets_data ? changed_chunk_assets_data->m_ChunkCount : 0);
+    struct ChunkAssetsData* cad = AllocChunkAssetsData(chunk_count);
+    if (!cad)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AllocChunkAssetsData() failed with %d", ENOMEM)
+        Longtail_Free(changed_chunk_assets_data);
+        Longtail_Free(work_mem);
         return ENOMEM;
     }
-    memcpy(&version_index[1], buffer, size);
-    int err = InitVersionIndexFromData(version_index, &version_index[1], size);
-    if (err)
+
+    // Assets are laid out in the same order as ChunkAssets() would have done for all assets
+    uint32_t chunk_offset = 0;
+    uint32_t changed_index = 0;
+    for (uint32_t a = 0; a < asset_count; ++a)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "InitVersionIndexFromData() failed with %d", err)
-        Longtail_Free(version_index);
-        return err;
+        uint32_t asset_tag = optional_asset_tags ? optional_asset_tags[a] : 0;
+        asset_chunk_start_index[a] = chunk_offset;
+        uint32_t p = previous_asset_indexes[a];
+        if (p != 0xffffffffu)
+        {
+            uint32_t previous_chunk_count = previous_version_index->m_AssetChunkCounts[p];
+            const uint32_t* previous_chunk_indexes = &previous_version_index->m_AssetChunkIndexes[previous_version_index->m_AssetChunkIndexStarts[p]];
+            for (uint32_t c = 0; c < previous_chunk_count; ++c)
+            {
+                uint32_t chunk_index = previous_chunk_indexes[c];
+                cad->m_ChunkHashes[chunk_offset] = previous_version_index->m_ChunkHashes[chunk_index];
+                cad->m_ChunkSizes[chunk_offset] = previous_version_index->m_ChunkSizes[chunk_index];
+                cad->m_ChunkTags[chunk_offset] = asset_tag;
+                ++chunk_offset;
+            }
+            asset_chunk_counts[a] = previous_chunk_count;
+            content_hashes[a] = previous_version_index->m_ContentHashes[p];
+            continue;
+        }
+        LONGTAIL_FATAL_ASSERT(ctx, changed_asset_indexes[changed_index] == a, return EINVAL)
+        uint32_t changed_chunk_count = changed_chunk_counts[changed_index];
+        uint32_t changed_chunk_start = changed_chunk_start_index[changed_index];
+        memcpy(&cad->m_ChunkHashes[chunk_offset], &changed_chunk_assets_data->m_ChunkHashes[changed_chunk_start], sizeof(TLongtail_Hash) * changed_chunk_count);
+        memcpy(&cad->m_ChunkSizes[chunk_offset], &changed_chunk_assets_data->m_ChunkSizes[changed_chunk_start], sizeof(uint32_t) * changed_chunk_count);
+        memcpy(&cad->m_ChunkTags[chunk_offset], &changed_chunk_assets_data->m_ChunkTags[changed_chunk_start], sizeof(uint32_t) * changed_chunk_count);
+        chunk_offset += changed_chunk_count;
+        asset_chunk_counts[a] = changed_chunk_count;
+        content_hashes[a] = changed_content_hashes[changed_index];
+        ++changed_index;
     }
-    *out_version_index = version_index;
+    LONGTAIL_FATAL_ASSERT(ctx, chunk_offset == chunk_count, return EINVAL)
+
+    Longtail_Free(changed_chunk_assets_data);
+    Longtail_Free(work_mem);
+    *out_chunk_assets_data = cad;
     return 0;
 }
 
-int Longtail_ReadVersionIndex(
-    struct Longtail_StorageAPI* storage_api,
-    const char* path,
-    struct Longtail_VersionIndex** out_version_index)
+static size_t Longtail_GetVersionIndexDataSize(
+    uint32_t asset_count,
+    uint32_t chunk_count,
+    uint32_t asset_chunk_index_count,
+    uint32_t path_data_size)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(storage_api, "%p"),
-        LONGTAIL_LOGFIELD(path, "%s"),
-        LONGTAIL_LOGFIELD(out_version_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
-
-    Longtail_StorageAPI_HOpenFile file_handle;
-    int err = storage_api->OpenReadFile(storage_api, path, &file_handle);
-    if (err != 0)
-    {
-        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_WARNING : LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
-        return err;
-    }
-    uint64_t version_index_data_size;
-    err = storage_api->GetSize(storage_api, file_handle, &version_index_data_size);
-    if (err != 0)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetSize() failed with %d", err)
-        return err;
-    }
-    size_t version_index_size = version_index_data_size + sizeof(struct Longtail_VersionIndex);
-    struct Longtail_VersionIndex* version_index = (struct Longtail_VersionIndex*)Longtail_Alloc("ReadVersionIndex", version_index_size);
-    if (!version_index)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        Longtail_Free(version_index);
-        storage_api->CloseFile(storage_api, file_handle);
-        return err;
-    }
-    err = storage_api->Read(storage_api, file_handle, 0, version_index_data_size, &version_index[1]);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
-        Longtail_Free(version_index);
-        storage_api->CloseFile(storage_api, file_handle);
-        return err;
-    }
-    err = InitVersionIndexFromData(version_index, &version_index[1], version_index_data_size);
-    storage_api->CloseFile(storage_api, file_handle);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "InitVersionIndexFromData() failed with %d", err)
-        Longtail_Free(version_index);
-        return err;
-    }
+        LONGTAIL_LOGFIELD(asset_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(asset_chunk_index_count, "%u"),
+        LONGTAIL_LOGFIELD(path_data_size, "%u"),
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+    LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_index_count >= chunk_count, return EINVAL)
 
-    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Read version index containing %u assets in %u chunks",
-        *version_index->m_AssetCount, *version_index->m_ChunkCount)
+    size_t version_index_data_size =
+        sizeof(uint32_t) +                              // m_Version
+        sizeof(uint32_t) +                              // m_HashIdentifier
+        sizeof(uint32_t) +                              // m_TargetChunkSize
+        sizeof(uint32_t) +                              // m_AssetCount
+        sizeof(uint32_t) +                              // m_ChunkCount
+        sizeof(uint32_t) +                              // m_AssetChunkIndexCount
+        (sizeof(TLongtail_Hash) * asset_count) +        // m_PathHashes
+        (sizeof(TLongtail_Hash) * asset_count) +        // m_ContentHashes
+        (sizeof(uint64_t) * asset_count) +              // m_AssetSizes
+        (sizeof(uint32_t) * asset_count) +              // m_AssetChunkCounts
+        (sizeof(uint32_t) * asset_count) +              // m_AssetChunkIndexStarts
+        (sizeof(uint32_t) * asset_chunk_index_count) +  // m_AssetChunkIndexes
+        (sizeof(TLongtail_Hash) * chunk_count) +        // m_ChunkHashes
+        (sizeof(uint32_t) * chunk_count) +              // m_ChunkSizes
+        (sizeof(uint32_t) * chunk_count) +              // m_ChunkTags
+        (sizeof(uint32_t) * asset_count) +              // m_NameOffsets
+        (sizeof(uint16_t) * asset_count) +              // m_Permissions
+        path_data_size;
 
-    *out_version_index = version_index;
-    return 0;
+    return version_index_data_size;
 }
 
-size_t Longtail_GetBlockIndexDataSize(uint32_t chunk_count)
+size_t Longtail_GetVersionIndexSize(
+    uint32_t asset_count,
+    uint32_t chunk_count,
+    uint32_t asset_chunk_index_count,
+    uint32_t path_data_size)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(chunk_count, "%u")
+        LONGTAIL_LOGFIELD(asset_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(asset_chunk_index_count, "%u"),
+        LONGTAIL_LOGFIELD(path_data_size, "%u"),
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-    return
-        sizeof(TLongtail_Hash) +                    // m_BlockHash
-        sizeof(uint32_t) +                          // m_HashIdentifier
-        sizeof(uint32_t) +                          // m_ChunkCount
-        sizeof(uint32_t) +                          // m_Tag
-        (sizeof(TLongtail_Hash) * chunk_count) +    // m_ChunkHashes
-        (sizeof(uint32_t) * chunk_count);           // m_ChunkSizes
+    LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_index_count >= chunk_count, return EINVAL)
+    return sizeof(struct Longtail_VersionIndex) +
+            Longtail_GetVersionIndexDataSize(asset_count, chunk_count, asset_chunk_index_count, path_data_size);
 }
 
-struct Longtail_BlockIndex* Longtail_InitBlockIndex(void* mem, uint32_t chunk_count)
+static int InitVersionIndexFromData(
+    struct Longtail_VersionIndex* version_index,
+    void* data,
+    size_t data_size)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(mem, "%p"),
-        LONGTAIL_LOGFIELD(chunk_count, "%u")
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(data, "%p"),
+        LONGTAIL_LOGFIELD(data_size, "%" PRIu64),
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-    LONGTAIL_VALIDATE_INPUT(ctx, mem != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, data != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, data_size >= sizeof(uint32_t), return EBADF)
 
-    struct Longtail_BlockIndex* block_index = (struct Longtail_BlockIndex*)mem;
-    char* p = (char*)&block_index[1];
+    char* p = (char*)data;
 
-    block_index->m_BlockHash = (TLongtail_Hash*)(void*)p;
-    p += sizeof(TLongtail_Hash);
+    size_t version_index_data_start = (size_t)(uintptr_t)p;
 
-    block_index->m_HashIdentifier = (uint32_t*)(void*)p;
+    version_index->m_Version = (uint32_t*)(void*)p;
     p += sizeof(uint32_t);
 
-    block_index->m_ChunkCount = (uint32_t*)(void*)p;
+    if ((*version_index->m_Version) != LONGTAIL_VERSION_INDEX_VERSION_0_0_2)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Missmatching versions in version index data %" PRIu64 " != %" PRIu64 "", (void*)version_index->m_Version, Longtail_CurrentVersionIndexVersion);
+        return EBADF;
+    }
+
+    version_index->m_HashIdentifier = (uint32_t*)(void*)p;
     p += sizeof(uint32_t);
 
-    block_index->m_Tag = (uint32_t*)(void*)p;
+    version_index->m_TargetChunkSize = (uint32_t*)(void*)p;
     p += sizeof(uint32_t);
 
-    block_index->m_ChunkHashes = (TLongtail_Hash*)(void*)p;
-    p += sizeof(TLongtail_Hash) * chunk_count;
+    version_index->m_AssetCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
 
-    block_index->m_ChunkSizes = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t) * chunk_count;
+    uint32_t asset_count = *version_index->m_AssetCount;
 
-    return block_index;
-}
+    version_index->m_ChunkCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
 
-struct Longtail_BlockIndex* Longtail_CopyBlockIndex(struct Longtail_BlockIndex* block_index)
-{
-    uint32_t chunk_count = *block_index->m_ChunkCount;
-    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
-    void* mem = Longtail_Alloc("Longtail_CopyBlockIndex", block_index_size);
-    struct Longtail_BlockIndex* copy_block_index = Longtail_InitBlockIndex(mem, chunk_count);
-    *copy_block_index->m_BlockHash = *block_index->m_BlockHash;
-    *copy_block_index->m_HashIdentifier = *block_index->m_HashIdentifier;
-    *copy_block_index->m_ChunkCount = *block_index->m_ChunkCount;
-    *copy_block_index->m_Tag = *block_index->m_Tag;
-    memcpy(copy_block_index->m_ChunkHashes, block_index->m_ChunkHashes, sizeof(TLongtail_Hash) * chunk_count);
-    memcpy(copy_block_index->m_ChunkSizes, block_index->m_ChunkSizes, sizeof(uint32_t) * chunk_count);
-    return copy_block_index;
-}
+    uint32_t chunk_count = *version_index->m_ChunkCount;
 
-int Longtail_InitBlockIndexFromData(
-    struct Longtail_BlockIndex* block_index,
-    void* data,
-    uint64_t data_size)
-{
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(block_index, "%p"),
-        LONGTAIL_LOGFIELD(data, "%p"),
-        LONGTAIL_LOGFIELD(data_size, "%" PRIu64)
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-    LONGTAIL_VALIDATE_INPUT(ctx, block_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, data != 0, return EINVAL)
+    version_index->m_AssetChunkIndexCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
 
-    char* p = (char*)data;
+    uint32_t asset_chunk_index_count = *version_index->m_AssetChunkIndexCount;
 
-    block_index->m_BlockHash = (TLongtail_Hash*)(void*)p;
-    p += sizeof(TLongtail_Hash);
+    size_t versiom_index_data_size = Longtail_GetVersionIndexDataSize(asset_count, chunk_count, asset_chunk_index_count, 0);
+    if (versiom_index_data_size > data_size)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Version index data is truncated: %" PRIu64 " <= %" PRIu64, data_size, versiom_index_data_size)
+        return EBADF;
+    }
 
-    block_index->m_HashIdentifier = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+    version_index->m_PathHashes = (TLongtail_Hash*)(void*)p;
+    p += (sizeof(TLongtail_Hash) * asset_count);
 
-    block_index->m_ChunkCount = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+    version_index->m_ContentHashes = (TLongtail_Hash*)(void*)p;
+    p += (sizeof(TLongtail_Hash) * asset_count);
 
-    block_index->m_Tag = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
+    version_index->m_AssetSizes = (uint64_t*)(void*)p;
+    p += (sizeof(uint64_t) * asset_count);
 
-    uint32_t chunk_count = *block_index->m_ChunkCount;
+    version_index->m_AssetChunkCounts = (uint32_t*)(void*)p;
+    p += (sizeof(uint32_t) * asset_count);
 
-    size_t block_index_data_size = Longtail_GetBlockIndexDataSize(chunk_count);
-    if (block_index_data_size > data_size)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Chunk count results in block index data %" PRIu64 " larger that data size (%" PRIu64 ")", block_index_data_size, data)
-        return EBADF;
-    }
+    version_index->m_AssetChunkIndexStarts = (uint32_t*)(void*)p;
+    p += (sizeof(uint32_t) * asset_count);
 
-    block_index->m_ChunkHashes = (TLongtail_Hash*)(void*)p;
-    p += sizeof(TLongtail_Hash) * chunk_count;
+    version_index->m_AssetChunkIndexes = (uint32_t*)(void*)p;
+    p += (sizeof(uint32_t) * asset_chunk_index_count);
 
-    block_index->m_ChunkSizes = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t) * chunk_count;
+    version_index->m_ChunkHashes = (TLongtail_Hash*)(void*)p;
+    p += (sizeof(TLongtail_Hash) * chunk_count);
 
-    return 0;
-}
+    version_index->m_ChunkSizes = (uint32_t*)(void*)p;
+    p += (sizeof(uint32_t) * chunk_count);
 
-size_t Longtail_GetBlockIndexSize(uint32_t chunk_count)
-{
-    size_t block_index_size =
-        sizeof(struct Longtail_BlockIndex) +
-        Longtail_GetBlockIndexDataSize(chunk_count);
+    version_index->m_ChunkTags = (uint32_t*)(void*)p;
+    p += (sizeof(uint32_t) * chunk_count);
 
-    return block_index_size;
+    version_index->m_NameOffsets = (uint32_t*)(void*)p;
+    p += (sizeof(uint32_t) * asset_count);
+
+    version_index->m_Permissions = (uint16_t*)(void*)p;
+    p += (sizeof(uint16_t) * asset_count);
+
+    size_t version_index_name_data_start = (size_t)p;
+
+    version_index->m_NameDataSize = (uint32_t)(data_size - (version_index_name_data_start - version_index_data_start));
+
+    version_index->m_NameData = (char*)p;
+
+    return 0;
 }
 
-int Longtail_CreateBlockIndex(
-    struct Longtail_HashAPI* hash_api,
-    uint32_t tag,
+int Longtail_BuildVersionIndex(
+    void* mem,
+    size_t mem_size,
+    const struct Longtail_FileInfos* file_infos,
+    const TLongtail_Hash* path_hashes,
+    const TLongtail_Hash* content_hashes,
+    const uint32_t* asset_chunk_index_starts,
+    const uint32_t* asset_chunk_counts,
+    uint32_t asset_chunk_index_count,
+    const uint32_t* asset_chunk_indexes,
     uint32_t chunk_count,
-    const uint32_t* chunk_indexes,
-    const TLongtail_Hash* chunk_hashes,
     const uint32_t* chunk_sizes,
-    struct Longtail_BlockIndex** out_block_index)
+    const TLongtail_Hash* chunk_hashes,
+    const uint32_t* optional_chunk_tags,
+    uint32_t hash_api_identifier,
+    uint32_t target_chunk_size,
+    struct Longtail_VersionIndex** out_version_index)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(hash_api, "%p"),
-        LONGTAIL_LOGFIELD(tag, "%u"),
+        LONGTAIL_LOGFIELD(mem, "%p"),
+        LONGTAIL_LOGFIELD(mem_size, "%p"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
+        LONGTAIL_LOGFIELD(path_hashes, "%p"),
+        LONGTAIL_LOGFIELD(content_hashes, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_index_starts, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_index_count, "%u"),
+        LONGTAIL_LOGFIELD(asset_chunk_indexes, "%p"),
         LONGTAIL_LOGFIELD(chunk_count, "%u"),
-        LONGTAIL_LOGFIELD(chunk_indexes, "%p"),
         LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
-        LONGTAIL_LOGFIELD(out_block_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(optional_chunk_tags, "%p"),
+        LONGTAIL_LOGFIELD(hash_api_identifier, "%u"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(out_version_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+    LONGTAIL_VALIDATE_INPUT(ctx, mem != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, mem_size != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || path_hashes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || content_hashes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_counts == 0 || asset_chunk_index_starts != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || asset_chunk_counts != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_index_count >= chunk_count, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || asset_chunk_indexes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_indexes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_hashes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_sizes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_block_index != 0, return EINVAL)
+    uint32_t asset_count = file_infos == 0 ? 0u : file_infos->m_Count;
+    struct Longtail_VersionIndex* version_index = (struct Longtail_VersionIndex*)mem;
+    uint32_t* p = (uint32_t*)(void*)&version_index[1];
+    version_index->m_Version = &p[0];
+    version_index->m_HashIdentifier = &p[1];
+    version_index->m_TargetChunkSize = &p[2];
+    version_index->m_AssetCount = &p[3];
+    version_index->m_ChunkCount = &p[4];
+    version_index->m_AssetChunkIndexCount = &p[5];
+    *version_index->m_Version = Longtail_CurrentVersionIndexVersion;
+    *version_index->m_HashIdentifier = hash_api_identifier;
+    *version_index->m_TargetChunkSize = target_chunk_size;
+    *version_index->m_AssetCount = asset_count;
+    *version_index->m_ChunkCount = chunk_count;
+    *version_index->m_AssetChunkIndexCount = asset_chunk_index_count;
 
-    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
-    void* mem = Longtail_Alloc("CreateBlockIndex", block_index_size);
-    if (mem == 0)
+    size_t index_data_size = mem_size - sizeof(struct Longtail_VersionIndex);
+    int err = InitVersionIndexFromData(version_index, &version_index[1], index_data_size);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "InitVersionIndexFromData() failed with %d", err);
+        return err;
     }
 
-    struct Longtail_BlockIndex* block_index = Longtail_InitBlockIndex(mem, chunk_count);
-    for (uint32_t i = 0; i < chunk_count; ++i)
-    {
-        uint32_t chunk_index = chunk_indexes[i];
-        block_index->m_ChunkHashes[i] = chunk_hashes[chunk_index];
-        block_index->m_ChunkSizes[i] = chunk_sizes[chunk_index];
-    }
-    size_t hash_buffer_size = sizeof(TLongtail_Hash) * chunk_count;
-    int err = hash_api->HashBuffer(hash_api, (uint32_t)(hash_buffer_size), (void*)block_index->m_ChunkHashes, block_index->m_BlockHash);
-    if (err != 0)
+    if (asset_count > 0)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_api->HashBuffer() failed with %d", err)
-        Longtail_Free(mem);
-        return err;
+        memmove(version_index->m_PathHashes, path_hashes, sizeof(TLongtail_Hash) * asset_count);
+        memmove(version_index->m_ContentHashes, content_hashes, sizeof(TLongtail_Hash) * asset_count);
+        memmove(version_index->m_AssetSizes, file_infos->m_Sizes, sizeof(uint64_t) * asset_count);
+        memmove(version_index->m_AssetChunkCounts, asset_chunk_counts, sizeof(uint32_t) * asset_count);
+        memmove(version_index->m_AssetChunkIndexStarts, asset_chunk_index_starts, sizeof(uint32_t) * asset_count);
+        memmove(version_index->m_AssetChunkIndexes, asset_chunk_indexes, sizeof(uint32_t) * asset_chunk_index_count);
+        memmove(version_index->m_ChunkHashes, chunk_hashes, sizeof(TLongtail_Hash) * chunk_count);
+        memmove(version_index->m_ChunkSizes, chunk_sizes, sizeof(uint32_t) * chunk_count);
+        if (optional_chunk_tags)
+        {
+            memmove(version_index->m_ChunkTags, optional_chunk_tags, sizeof(uint32_t) * chunk_count);
+        }
+        else
+        {
+            memset(version_index->m_ChunkTags, 0, sizeof(uint32_t) * chunk_count);
+        }
+        memmove(version_index->m_NameOffsets, file_infos->m_PathStartOffsets, sizeof(uint32_t) * asset_count);
+        memmove(version_index->m_Permissions, file_infos->m_Permissions, sizeof(uint16_t) * asset_count);
+        memmove(version_index->m_NameData, file_infos->m_PathData, file_infos->m_PathDataSize);
     }
-    *block_index->m_HashIdentifier = hash_api->GetIdentifier(hash_api);
-    *block_index->m_Tag = tag;
-    *block_index->m_ChunkCount = chunk_count;
 
-    *out_block_index = block_index;
+    *out_version_index = version_index;
     return 0;
 }
 
-int Longtail_WriteBlockIndexToBuffer(
-    const struct Longtail_BlockIndex* block_index,
-    void** out_buffer,
-    size_t* out_size)
+static int CreateVersionIndex(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* optional_asset_tags,
+    uint32_t target_chunk_size,
+    const struct Longtail_VersionIndex* optional_previous_version_index,
+    const struct Longtail_FileInfos* optional_previous_file_infos,
+    struct Longtail_VersionIndex** out_version_index)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(block_index, "%p"),
-        LONGTAIL_LOGFIELD(out_buffer, "%p"),
-        LONGTAIL_LOGFIELD(out_size, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_tags, "%u"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(optional_previous_version_index, "%p"),
+        LONGTAIL_LOGFIELD(optional_previous_file_infos, "%p"),
+        LONGTAIL_LOGFIELD(out_version_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, block_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_buffer != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_size != 0, return EINVAL)
+    uint32_t path_count = file_infos == 0 ? 0u : file_infos->m_Count;
 
-    size_t index_data_size = Longtail_GetBlockIndexDataSize(*block_index->m_ChunkCount);
-    *out_buffer = Longtail_Alloc("WriteBlockIndexToBuffer", index_data_size);
-    if (!(*out_buffer))
+    if (path_count == 0)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
-    }
-    memcpy(*out_buffer, &block_index[1], index_data_size);
-    *out_size = index_data_size;
-    return 0;
-}
-
-int Longtail_ReadBlockIndexFromBuffer(
-    const void* buffer,
-    size_t size,
-    struct Longtail_BlockIndex** out_block_index)
-{
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(buffer, "%p"),
-        LONGTAIL_LOGFIELD(size, "%" PRIu64),
-        LONGTAIL_LOGFIELD(out_block_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
+        size_t version_index_size = Longtail_GetVersionIndexSize(path_count, 0, 0, 0);
+        void* version_index_mem = Longtail_Alloc("CreateVersionIndex", version_index_size);
+        if (!version_index_mem)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
 
-    LONGTAIL_VALIDATE_INPUT(ctx, buffer != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, size != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_block_index != 0, return EINVAL)
+        struct Longtail_VersionIndex* version_index;
+        int err = Longtail_BuildVersionIndex(
+            version_index_mem,              // mem
+            version_index_size,             // mem_size
+            file_infos,                          // paths
+            0,                    // path_hashes
+            0,                 // content_hashes
+            0,        // asset_chunk_index_starts
+            0,             // asset_chunk_counts
+            0,       // asset_chunk_index_count
+            0,            // asset_chunk_indexes
+            0,             // chunk_count
+            0,           // chunk_sizes
+            0,           // chunk_hashes
+            0,          // chunk_tags
+            hash_api->GetIdentifier(hash_api),
+            target_chunk_size,
+            &version_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndex() failed with %d", err)
+            return err;
+        }
+        *out_version_index = version_index;
+        return 0;
+    }
 
-    size_t block_index_size = size + sizeof(struct Longtail_BlockIndex);
-    struct Longtail_BlockIndex* block_index = (struct Longtail_BlockIndex*)Longtail_Alloc("ReadBlockIndexFromBuffer", block_index_size);
-    if (!block_index)
+    size_t work_mem_size = (sizeof(TLongtail_Hash) * path_count) +
+        (sizeof(TLongtail_Hash) * path_count) +
+        (sizeof(uint32_t) * path_count) +
+        (sizeof(uint32_t) * path_count);
+    void* work_mem = Longtail_Alloc("CreateVersionIndex", work_mem_size);
+    if (!work_mem)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
-    memcpy(&block_index[1], buffer, size);
-    int err = Longtail_InitBlockIndexFromData(block_index, &block_index[1], size);
+
+    TLongtail_Hash* tmp_path_hashes = (TLongtail_Hash*)work_mem;
+    TLongtail_Hash* tmp_content_hashes = (TLongtail_Hash*)&tmp_path_hashes[path_count];
+    uint32_t* tmp_asset_chunk_counts = (uint32_t*)&tmp_content_hashes[path_count];
+    uint32_t* tmp_asset_chunk_start_index = (uint32_t*)&tmp_asset_chunk_counts[path_count];
+
+    struct ChunkAssetsData* chunk_assets_data;
+
+    int err = optional_previous_version_index ?
+        ChunkChangedAssets(
+            storage_api,
+            hash_api,
+            chunker_api,
+            job_api,
+            progress_api,
+            optional_cancel_api,
+            optional_cancel_token,
+            root_path,
+            file_infos,
+            optional_previous_version_index,
+            optional_previous_file_infos,
+            tmp_path_hashes,
+            tmp_content_hashes,
+            optional_asset_tags,
+            tmp_asset_chunk_start_index,
+            tmp_asset_chunk_counts,
+            target_chunk_size,
+            &chunk_assets_data) :
+        ChunkAssets(
+            storage_api,
+            hash_api,
+            chunker_api,
+            job_api,
+            progress_api,
+            optional_cancel_api,
+            optional_cancel_token,
+            root_path,
+            file_infos,
+            tmp_path_hashes,
+            tmp_content_hashes,
+            optional_asset_tags,
+            tmp_asset_chunk_start_index,
+            tmp_asset_chunk_counts,
+            target_chunk_size,
+            &chunk_assets_data);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitBlockIndexFromData() failed with %d", err)
-        Longtail_Free(block_index);
+        LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "ChunkAssets() failed with %d", err)
+        Longtail_Free(work_mem);
         return err;
     }
-    *out_block_index = block_index;
-    return 0;
-}
 
-int Longtail_WriteBlockIndex(
-    struct Longtail_StorageAPI* storage_api,
-    struct Longtail_BlockIndex* block_index,
-    const char* path)
-{
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(storage_api, "%p"),
-        LONGTAIL_LOGFIELD(block_index, "%p"),
-        LONGTAIL_LOGFIELD(path, "%s")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
+    uint32_t assets_chunk_index_count = chunk_assets_data->m_ChunkCount;
+    uint32_t* asset_chunk_sizes = chunk_assets_data->m_ChunkSizes;
+    uint32_t* asset_chunk_tags = chunk_assets_data->m_ChunkTags;
+    TLongtail_Hash* asset_chunk_hashes = chunk_assets_data->m_ChunkHashes;
 
-    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, block_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
+    size_t work_mem_compact_size = (sizeof(uint32_t) * assets_chunk_index_count) +
+        (sizeof(TLongtail_Hash) * assets_chunk_index_count) + 
+        (sizeof(uint32_t) * assets_chunk_index_count) +
+        (sizeof(uint32_t) * assets_chunk_index_count) +
+        Longtail_LookupTable_GetSize(assets_chunk_index_count);
+    void* work_mem_compact = Longtail_Alloc("CreateVersionIndex", work_mem_compact_size);
+    if (!work_mem_compact)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(chunk_assets_data);
+        Longtail_Free(work_mem);
+        return ENOMEM;
+    }
 
-    int err = EnsureParentPathExists(storage_api, path);
-    if (err)
+    uint32_t* tmp_asset_chunk_indexes = (uint32_t*)work_mem_compact;
+    TLongtail_Hash* tmp_compact_chunk_hashes = (TLongtail_Hash*)&tmp_asset_chunk_indexes[assets_chunk_index_count];
+    uint32_t* tmp_compact_chunk_sizes =  (uint32_t*)&tmp_compact_chunk_hashes[assets_chunk_index_count];
+    uint32_t* tmp_compact_chunk_tags =  (uint32_t*)&tmp_compact_chunk_sizes[assets_chunk_index_count];
+
+    uint32_t unique_chunk_count = 0;
+    struct Longtail_LookupTable* chunk_hash_to_index = Longtail_LookupTable_Create(&tmp_compact_chunk_tags[assets_chunk_index_count], assets_chunk_index_count, 0);
+
+    for (uint32_t c = 0; c < assets_chunk_index_count; ++c)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
-        return err;
+        TLongtail_Hash h = asset_chunk_hashes[c];
+        uint32_t* chunk_index = Longtail_LookupTable_PutUnique(chunk_hash_to_index, h, unique_chunk_count);
+        if (chunk_index == 0)
+        {
+            tmp_compact_chunk_hashes[unique_chunk_count] = h;
+            tmp_compact_chunk_sizes[unique_chunk_count] = asset_chunk_sizes[c];
+            tmp_compact_chunk_tags[unique_chunk_count] = asset_chunk_tags[c];
+            tmp_asset_chunk_indexes[c] = unique_chunk_count;
+            ++unique_chunk_count;
+        }
+        else
+        {
+            tmp_asset_chunk_indexes[c] = *chunk_index;
+        }
     }
-    Longtail_StorageAPI_HOpenFile file_handle;
-    err = storage_api->OpenWriteFile(storage_api, path, 0, &file_handle);
-    if (err)
+
+    size_t version_index_size = Longtail_GetVersionIndexSize(path_count, unique_chunk_count, assets_chunk_index_count, file_infos->m_PathDataSize);
+    void* version_index_mem = Longtail_Alloc("CreateVersionIndex", version_index_size);
+    if (!version_index_mem)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile) failed with %d", err)
-        return err;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(work_mem_compact);
+        Longtail_Free(chunk_assets_data);
+        Longtail_Free(work_mem);
+        return ENOMEM;
     }
-    size_t index_data_size = Longtail_GetBlockIndexDataSize(*block_index->m_ChunkCount);
-    err = storage_api->Write(storage_api, file_handle, 0, index_data_size, &block_index[1]);
-    if (err){
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
-        storage_api->CloseFile(storage_api, file_handle);
-        file_handle = 0;
+
+    struct Longtail_VersionIndex* version_index;
+    err = Longtail_BuildVersionIndex(
+        version_index_mem,              // mem
+        version_index_size,             // mem_size
+        file_infos,                          // paths
+        tmp_path_hashes,                    // path_hashes
+        tmp_content_hashes,                 // content_hashes
+        tmp_asset_chunk_start_index,        // asset_chunk_index_starts
+        tmp_asset_chunk_counts,             // asset_chunk_counts
+        assets_chunk_index_count,       // asset_chunk_index_count
+        tmp_asset_chunk_indexes,            // asset_chunk_indexes
+        unique_chunk_count,             // chunk_count
+        tmp_compact_chunk_sizes,            // chunk_sizes
+        tmp_compact_chunk_hashes,           // chunk_hashes
+        tmp_compact_chunk_tags,// chunk_tags
+        hash_api->GetIdentifier(hash_api),
+        target_chunk_size,
+        &version_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndex() failed with %d", err)
+        Longtail_Free(work_mem_compact);
+        Longtail_Free(version_index_mem);
+        Longtail_Free(chunk_assets_data);
+        Longtail_Free(work_mem);
         return err;
     }
-    storage_api->CloseFile(storage_api, file_handle);
 
+    Longtail_Free(work_mem_compact);
+    Longtail_Free(chunk_assets_data);
+    Longtail_Free(work_mem);
+
+    *out_version_index = version_index;
     return 0;
 }
 
-struct Longtail_BlockIndexHeader
-{
-    TLongtail_Hash m_BlockHash;
-    uint32_t m_HashIdentifier;
-    uint32_t m_ChunkCount;
-    uint32_t m_Tag;
-};
-
-int Longtail_ReadBlockIndex(
+int Longtail_CreateVersionIndex(
     struct Longtail_StorageAPI* storage_api,
-    const char* path,
-    struct Longtail_BlockIndex** out_block_index)
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* optional_asset_tags,
+    uint32_t target_chunk_size,
+    struct Longtail_VersionIndex** out_version_index)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(storage_api, "%p"),
-        LONGTAIL_LOGFIELD(path, "%s"),
-        LONGTAIL_LOGFIELD(out_block_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_tags, "%u"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(out_version_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
 
     LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_block_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || root_path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || target_chunk_size > 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || out_version_index != 0, return EINVAL)
 
-    Longtail_StorageAPI_HOpenFile f;
-    int err = storage_api->OpenReadFile(storage_api, path, &f);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_WARNING : LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
-        return err;
+    return CreateVersionIndex(
+        storage_api,
+        hash_api,
+        chunker_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        root_path,
+        file_infos,
+        optional_asset_tags,
+        target_chunk_size,
+        0,
+        0,
+        out_version_index);
+}
+
+int Longtail_CreateVersionIndexIncremental(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* optional_asset_tags,
+    uint32_t target_chunk_size,
+    const struct Longtail_VersionIndex* previous_version_index,
+    const struct Longtail_FileInfos* previous_file_infos,
+    struct Longtail_VersionIndex** out_version_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_tags, "%u"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(previous_version_index, "%p"),
+        LONGTAIL_LOGFIELD(previous_file_infos, "%p"),
+        LONGTAIL_LOGFIELD(out_version_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || root_path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || target_chunk_size > 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || out_version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, previous_version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, previous_file_infos != 0, return EINVAL)
+
+    return CreateVersionIndex(
+        storage_api,
+        hash_api,
+        chunker_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        root_path,
+        file_infos,
+        optional_asset_tags,
+        target_chunk_size,
+        previous_version_index,
+        previous_file_infos,
+        out_version_index);
+}
+
+int Longtail_WriteVersionIndexToBuffer(
+    const struct Longtail_VersionIndex* version_index,
+    void** out_buffer,
+    size_t* out_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(out_buffer, "%p"),
+        LONGTAIL_LOGFIELD(out_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_buffer != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_size != 0, return EINVAL)
+
+    size_t index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
+    *out_buffer = Longtail_Alloc("WriteVersionIndexToBuffer", index_data_size);
+    if (!(*out_buffer))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
     }
-    uint64_t block_size;
-    err = storage_api->GetSize(storage_api, f, &block_size);
+    memcpy(*out_buffer, &version_index[1], index_data_size);
+    *out_size = index_data_size;
+    return 0;
+}
+
+int Longtail_WriteVersionIndex(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_VersionIndex* version_index,
+    const char* path)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(path, "%s")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
+
+    size_t index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
+
+    int err = EnsureParentPathExists(storage_api, path);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetSize() failed with %d", err)
-        storage_api->CloseFile(storage_api, f);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
         return err;
     }
-    if (block_size < sizeof(struct Longtail_BlockIndexHeader))
+    Longtail_StorageAPI_HOpenFile file_handle;
+    err = storage_api->OpenWriteFile(storage_api, path, 0, &file_handle);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "file size %" PRIu64 " is to small, expected at least %" PRIu64 " bytes", block_size, sizeof(struct Longtail_BlockIndexHeader))
-        storage_api->CloseFile(storage_api, f);
-        return EBADF;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile) failed with %d",err)
+        return err;
     }
-    if (block_size > 0xffffffff)
+    err = storage_api->Write(storage_api, file_handle, 0, index_data_size, &version_index[1]);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "file size %" PRIu64 " is to large, size can be at most %" PRIu64 " bytes", block_size, 0xffffffff)
-        storage_api->CloseFile(storage_api, f);
-        return EBADF;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
+        storage_api->CloseFile(storage_api, file_handle);
+        file_handle = 0;
+        return err;
     }
-    uint64_t read_offset = 0;
+    storage_api->CloseFile(storage_api, file_handle);
+    file_handle = 0;
 
-    struct Longtail_BlockIndexHeader blockIndexHeader;
-    err = storage_api->Read(storage_api, f, read_offset, sizeof(struct Longtail_BlockIndexHeader), &blockIndexHeader);
+    return 0;
+}
+
+int Longtail_ReadVersionIndexFromBuffer(
+    const void* buffer,
+    size_t size,
+    struct Longtail_VersionIndex** out_version_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(buffer, "%p"),
+        LONGTAIL_LOGFIELD(size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_version_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+    LONGTAIL_VALIDATE_INPUT(ctx, buffer != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, size != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
+
+    size_t version_index_size = sizeof(struct Longtail_VersionIndex) + size;
+    struct Longtail_VersionIndex* version_index = (struct Longtail_VersionIndex*)Longtail_Alloc("ReadVersionIndexFromBuffer", version_index_size);
+    if (!version_index)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    memcpy(&version_index[1], buffer, size);
+    int err = InitVersionIndexFromData(version_index, &version_index[1], size);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
-        storage_api->CloseFile(storage_api, f);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "InitVersionIndexFromData() failed with %d", err)
+        Longtail_Free(version_index);
         return err;
     }
-    read_offset += sizeof(struct Longtail_BlockIndexHeader);
+    *out_version_index = version_index;
+    return 0;
+}
 
-    if (blockIndexHeader.m_ChunkCount == 0)
+int Longtail_ReadVersionIndex(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    struct Longtail_VersionIndex** out_version_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(path, "%s"),
+        LONGTAIL_LOGFIELD(out_version_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
+
+    Longtail_StorageAPI_HOpenFile file_handle;
+    int err = storage_api->OpenReadFile(storage_api, path, &file_handle);
+    if (err != 0)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "blockIndexHeader.m_ChunkCount (%u) must be larger than zero", blockIndexHeader.m_ChunkCount)
-        storage_api->CloseFile(storage_api, f);
-        return EBADF;
+        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_WARNING : LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+        return err;
     }
-
-    uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(blockIndexHeader.m_ChunkCount);
-    if (block_index_data_size >= block_size)
+    uint64_t version_index_data_size;
+    err = storage_api->GetSize(storage_api, file_handle, &version_index_data_size);
+    if (err != 0)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_index_data_size %" PRIu64 " is to large, size can be at most %" PRIu64 " bytes", block_index_data_size, block_size)
-        storage_api->CloseFile(storage_api, f);
-        return EBADF;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetSize() failed with %d", err)
+        return err;
     }
-
-    size_t block_index_size = Longtail_GetBlockIndexSize(blockIndexHeader.m_ChunkCount);
-    void* block_index_mem = Longtail_Alloc("ReadBlockIndex", block_index_size);
-    if (!block_index_mem)
+    size_t version_index_size = version_index_data_size + sizeof(struct Longtail_VersionIndex);
+    struct Longtail_VersionIndex* version_index = (struct Longtail_VersionIndex*)Longtail_Alloc("ReadVersionIndex", version_index_size);
+    if (!version_index)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        storage_api->CloseFile(storage_api, f);
-        return ENOMEM;
+        Longtail_Free(version_index);
+        storage_api->CloseFile(storage_api, file_handle);
+        return err;
     }
-    struct Longtail_BlockIndex* block_index = Longtail_InitBlockIndex(block_index_mem, blockIndexHeader.m_ChunkCount);
-    err = storage_api->Read(storage_api, f, 0, block_index_data_size, &block_index[1]);
+    err = storage_api->Read(storage_api, file_handle, 0, version_index_data_size, &version_index[1]);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
-        Longtail_Free(block_index);
-        storage_api->CloseFile(storage_api, f);
+        Longtail_Free(version_index);
+        storage_api->CloseFile(storage_api, file_handle);
+        return err;
+    }
+    err = InitVersionIndexFromData(version_index, &version_index[1], version_index_data_size);
+    storage_api->CloseFile(storage_api, file_handle);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "InitVersionIndexFromData() failed with %d", err)
+        Longtail_Free(version_index);
         return err;
     }
-    storage_api->CloseFile(storage_api, f);
-    *out_block_index = block_index;
-    return 0;
-}
 
-static int DisposeStoredBlock(struct Longtail_StoredBlock* stored_block)
-{
-    Longtail_Free(stored_block);
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Read version index containing %u assets in %u chunks",
+        *version_index->m_AssetCount, *version_index->m_ChunkCount)
+
+    *out_version_index = version_index;
     return 0;
 }
 
-size_t Longtail_GetStoredBlockSize(size_t block_data_size)
+static size_t GetFileInfosDataSize(uint32_t path_count, uint32_t path_data_size)
 {
-    return sizeof(struct Longtail_StoredBlock) + sizeof(struct Longtail_BlockIndex) + block_data_size;
+    return sizeof(uint32_t) +                   // Tag
+        sizeof(uint32_t) +                      // Version
+        sizeof(uint32_t) +                      // Count
+        sizeof(uint32_t) +                      // PathDataSize
+        sizeof(uint64_t) * path_count +         // m_Sizes[path_count]
+        sizeof(uint64_t) * path_count +         // m_ModificationTimes[path_count]
+        sizeof(uint32_t) * path_count +         // m_PathStartOffsets[path_count]
+        sizeof(uint16_t) * path_count +         // m_Permissions[path_count]
+        path_data_size;
 }
 
-int Longtail_InitStoredBlockFromData(
-    struct Longtail_StoredBlock* stored_block,
-    void* block_data,
-    size_t block_data_size)
+int Longtail_WriteFileInfosToBuffer(
+    const struct Longtail_FileInfos* file_infos,
+    void** out_buffer,
+    size_t* out_size)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(stored_block, "%p"),
-        LONGTAIL_LOGFIELD(block_data, "%p"),
-        LONGTAIL_LOGFIELD(block_data_size, "%" PRIu64)
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, stored_block != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, block_data != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, block_data_size > 0, return EINVAL)
-
-    stored_block->m_BlockIndex = (struct Longtail_BlockIndex*)&stored_block[1];
-    int err = Longtail_InitBlockIndexFromData(
-        stored_block->m_BlockIndex,
-        block_data,
-        block_data_size);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitBlockIndexFromData() failed with %d", err)
-        return err;
-    }
-    stored_block->m_BlockData = &((uint8_t*)stored_block->m_BlockIndex)[Longtail_GetBlockIndexSize(*stored_block->m_BlockIndex->m_ChunkCount)];
-    stored_block->m_BlockChunksDataSize = (uint32_t)(block_data_size - Longtail_GetBlockIndexDataSize(*stored_block->m_BlockIndex->m_ChunkCount));
-    stored_block->Dispose = 0;
-    return 0;
-}
-
-int Longtail_CreateStoredBlock(
-    TLongtail_Hash block_hash,
-    uint32_t hash_identifier,
-    uint32_t chunk_count,
-    uint32_t tag,
-    TLongtail_Hash* chunk_hashes,
-    uint32_t* chunk_sizes,
-    uint32_t block_data_size,
-    struct Longtail_StoredBlock** out_stored_block)
-{
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
-        LONGTAIL_LOGFIELD(hash_identifier, "%u"),
-        LONGTAIL_LOGFIELD(chunk_count, "%u"),
-        LONGTAIL_LOGFIELD(tag, "%u"),
-        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
-        LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
-        LONGTAIL_LOGFIELD(block_data_size, "%u"),
-        LONGTAIL_LOGFIELD(out_stored_block, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_stored_block != 0, return EINVAL)
-
-    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
-    size_t stored_block_size = sizeof(struct Longtail_StoredBlock) + block_index_size + block_data_size;
-    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("CreateStoredBlock", stored_block_size);
-    if (stored_block == 0)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
-    }
-    stored_block->m_BlockIndex = Longtail_InitBlockIndex(&stored_block[1], chunk_count);
-    LONGTAIL_FATAL_ASSERT(ctx, stored_block->m_BlockIndex != 0, return EINVAL)
-
-    *stored_block->m_BlockIndex->m_BlockHash = block_hash;
-    *stored_block->m_BlockIndex->m_HashIdentifier = hash_identifier;
-    *stored_block->m_BlockIndex->m_ChunkCount = chunk_count;
-    *stored_block->m_BlockIndex->m_Tag = tag;
-    memmove(stored_block->m_BlockIndex->m_ChunkHashes, chunk_hashes, sizeof(TLongtail_Hash) * chunk_count);
-    memmove(stored_block->m_BlockIndex->m_ChunkSizes, chunk_sizes, sizeof(uint32_t) * chunk_count);
-
-    stored_block->Dispose = DisposeStoredBlock;
-    stored_block->m_BlockData = ((uint8_t*)stored_block->m_BlockIndex) + block_index_size;
-    stored_block->m_BlockChunksDataSize = block_data_size;
-    *out_stored_block = stored_block;
-    return 0;
-}
-
-static int ReadStoredBlock_Dispose(struct Longtail_StoredBlock* stored_block)
-{
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(stored_block, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
-    LONGTAIL_FATAL_ASSERT(ctx, stored_block, return EINVAL)
-
-    Longtail_Free(stored_block);
-    return 0;
-}
-
-int Longtail_WriteStoredBlockToBuffer(
-    const struct Longtail_StoredBlock* stored_block,
-    void** out_buffer,
-    size_t* out_size)
-{
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
         LONGTAIL_LOGFIELD(out_buffer, "%p"),
         LONGTAIL_LOGFIELD(out_size, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, stored_block != 0, return EINVAL)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+    LONGTAIL_VALIDATE_INPUT(ctx, file_infos != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, out_buffer != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, out_size != 0, return EINVAL)
 
-    uint32_t chunk_count = *stored_block->m_BlockIndex->m_ChunkCount;
-    uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(chunk_count);
-
-    size_t size = block_index_data_size + stored_block->m_BlockChunksDataSize;
-
-    void* mem = (uint8_t*)Longtail_Alloc("WriteStoredBlockToBuffer", size);
-    if (!mem)
+    // The arrays of a scanned struct Longtail_FileInfos are sized for its capacity, not its count, so each array is copied separately
+    uint32_t path_count = file_infos->m_Count;
+    uint32_t path_data_size = file_infos->m_PathDataSize;
+    size_t data_size = GetFileInfosDataSize(path_count, path_data_size);
+    char* buffer = (char*)Longtail_Alloc("WriteFileInfosToBuffer", data_size);
+    if (!buffer)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
-    uint8_t* write_ptr = (uint8_t*)mem;
-
-    memcpy(write_ptr, &stored_block->m_BlockIndex[1], block_index_data_size);
-    write_ptr += block_index_data_size;
-    memcpy(write_ptr, stored_block->m_BlockData, stored_block->m_BlockChunksDataSize);
-
-    *out_size = size;
-    *out_buffer = mem;
+    char* p = buffer;
+    uint32_t tag = LONGTAIL_FILE_INFOS_TAG;
+    memcpy(p, &tag, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    uint32_t version = LONGTAIL_FILE_INFOS_VERSION_0_0_1;
+    memcpy(p, &version, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    memcpy(p, &path_count, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    memcpy(p, &path_data_size, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    memcpy(p, file_infos->m_Sizes, sizeof(uint64_t) * path_count);
+    p += sizeof(uint64_t) * path_count;
+    memcpy(p, file_infos->m_ModificationTimes, sizeof(uint64_t) * path_count);
+    p += sizeof(uint64_t) * path_count;
+    memcpy(p, file_infos->m_PathStartOffsets, sizeof(uint32_t) * path_count);
+    p += sizeof(uint32_t) * path_count;
+    memcpy(p, file_infos->m_Permissions, sizeof(uint16_t) * path_count);
+    p += sizeof(uint16_t) * path_count;
+    memcpy(p, file_infos->m_PathData, path_data_size);
+    *out_buffer = buffer;
+    *out_size = data_size;
     return 0;
 }
 
-int Longtail_ReadStoredBlockFromBuffer(
+int Longtail_ReadFileInfosFromBuffer(
     const void* buffer,
     size_t size,
-    struct Longtail_StoredBlock** out_stored_block)
+    struct Longtail_FileInfos** out_file_infos)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(buffer, "%p"),
         LONGTAIL_LOGFIELD(size, "%" PRIu64),
-        LONGTAIL_LOGFIELD(out_stored_block, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
+        LONGTAIL_LOGFIELD(out_file_infos, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
     LONGTAIL_VALIDATE_INPUT(ctx, buffer != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_stored_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_file_infos != 0, return EINVAL)
 
-    size_t block_mem_size = Longtail_GetStoredBlockSize(size);
-    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("ReadStoredBlockFromBuffer", block_mem_size);
-    if (!stored_block)
+    if (size < GetFileInfosDataSize(0, 0))
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "File infos data is truncated, failed with %d", EBADF)
+        return EBADF;
+    }
+    const char* p = (const char*)buffer;
+    uint32_t tag;
+    memcpy(&tag, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    uint32_t version;
+    memcpy(&version, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    uint32_t path_count;
+    memcpy(&path_count, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    uint32_t path_data_size;
+    memcpy(&path_data_size, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    if (tag != LONGTAIL_FILE_INFOS_TAG)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Data is not a file infos, failed with %d", EBADF)
+        return EBADF;
+    }
+    if (version != LONGTAIL_FILE_INFOS_VERSION_0_0_1)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Unsupported file infos version %u, failed with %d", version, EBADF)
+        return EBADF;
+    }
+    if ((path_count == 0) ? (path_data_size != 0) : (path_data_size <= path_count))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "File infos data is malformed, failed with %d", EBADF)
+        return EBADF;
+    }
+    if (size != GetFileInfosDataSize(path_count, path_data_size))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "File infos data size does not match its content, failed with %d", EBADF)
+        return EBADF;
+    }
+
+    struct Longtail_FileInfos* file_infos = CreateFileInfos(path_count, path_data_size);
+    if (!file_infos)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateFileInfos() failed with %d", ENOMEM)
         return ENOMEM;
     }
-    void* block_data = &((uint8_t*)stored_block)[block_mem_size - size];
-    memcpy(block_data, buffer, size);
-    int err = Longtail_InitStoredBlockFromData(
-        stored_block,
-        block_data,
-        size);
-    if (err)
+    memcpy(file_infos->m_Sizes, p, sizeof(uint64_t) * path_count);
+    p += sizeof(uint64_t) * path_count;
+    memcpy(file_infos->m_ModificationTimes, p, sizeof(uint64_t) * path_count);
+    p += sizeof(uint64_t) * path_count;
+    memcpy(file_infos->m_PathStartOffsets, p, sizeof(uint32_t) * path_count);
+    p += sizeof(uint32_t) * path_count;
+    memcpy(file_infos->m_Permissions, p, sizeof(uint16_t) * path_count);
+    p += sizeof(uint16_t) * path_count;
+    memcpy(file_infos->m_PathData, p, path_data_size);
+    file_infos->m_Count = path_count;
+    file_infos->m_PathDataSize = path_data_size;
+
+    if (path_count > 0 && file_infos->m_PathData[path_data_size - 1] != '\0')
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitStoredBlockFromData() failed with %d", err)
-        Longtail_Free(stored_block);
-        return err;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "File infos path data is not terminated, failed with %d", EBADF)
+        Longtail_Free(file_infos);
+        return EBADF;
     }
-    stored_block->Dispose = ReadStoredBlock_Dispose;
-    *out_stored_block = stored_block;
+    for (uint32_t i = 0; i < path_count; ++i)
+    {
+        if (file_infos->m_PathStartOffsets[i] >= path_data_size)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "File infos path offset %u is out of range, failed with %d", file_infos->m_PathStartOffsets[i], EBADF)
+            Longtail_Free(file_infos);
+            return EBADF;
+        }
+    }
+    *out_file_infos = file_infos;
     return 0;
 }
 
-int Longtail_WriteStoredBlock(
+int Longtail_WriteFileInfos(
     struct Longtail_StorageAPI* storage_api,
-    struct Longtail_StoredBlock* stored_block,
+    const struct Longtail_FileInfos* file_infos,
     const char* path)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(storage_api, "%p"),
-        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
         LONGTAIL_LOGFIELD(path, "%s")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
     LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, stored_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, file_infos != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
 
-    Longtail_StorageAPI_HOpenFile block_file_handle;
-    int err = storage_api->OpenWriteFile(storage_api, path, 0, &block_file_handle);
+    void* buffer;
+    size_t size;
+    int err = Longtail_WriteFileInfosToBuffer(file_infos, &buffer, &size);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_WriteFileInfosToBuffer() failed with %d", err)
         return err;
     }
-    uint32_t write_offset = 0;
-    uint32_t chunk_count = *stored_block->m_BlockIndex->m_ChunkCount;
-    uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(chunk_count);
-    err = storage_api->Write(storage_api, block_file_handle, write_offset, block_index_data_size, &stored_block->m_BlockIndex[1]);
+    err = EnsureParentPathExists(storage_api, path);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+        Longtail_Free(buffer);
         return err;
     }
-    write_offset += block_index_data_size;
-
-    err = storage_api->Write(storage_api, block_file_handle, write_offset, stored_block->m_BlockChunksDataSize, stored_block->m_BlockData);
+    Longtail_StorageAPI_HOpenFile file_handle;
+    err = storage_api->OpenWriteFile(storage_api, path, 0, &file_handle);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile() failed with %d", err)
+        Longtail_Free(buffer);
+        return err;
+    }
+    err = storage_api->Write(storage_api, file_handle, 0, size, buffer);
+    storage_api->CloseFile(storage_api, file_handle);
+    Longtail_Free(buffer);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
-        storage_api->CloseFile(storage_api, block_file_handle);
         return err;
     }
-    storage_api->CloseFile(storage_api, block_file_handle);
     return 0;
 }
 
-int Longtail_ReadStoredBlock(
+int Longtail_ReadFileInfos(
     struct Longtail_StorageAPI* storage_api,
     const char* path,
-    struct Longtail_StoredBlock** out_stored_block)
+    struct Longtail_FileInfos** out_file_infos)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(storage_api, "%p"),
         LONGTAIL_LOGFIELD(path, "%s"),
-        LONGTAIL_LOGFIELD(out_stored_block, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
+        LONGTAIL_LOGFIELD(out_file_infos, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
     LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_stored_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_file_infos != 0, return EINVAL)
 
-    Longtail_StorageAPI_HOpenFile f;
-    int err = storage_api->OpenReadFile(storage_api, path, &f);
+    Longtail_StorageAPI_HOpenFile file_handle;
+    int err = storage_api->OpenReadFile(storage_api, path, &file_handle);
     if (err)
     {
-        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_WARNING : LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
         return err;
     }
-    uint64_t stored_block_data_size;
-    err = storage_api->GetSize(storage_api, f, &stored_block_data_size);
+    uint64_t size;
+    err = storage_api->GetSize(storage_api, file_handle, &size);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetSize() failed with %d", err)
-        storage_api->CloseFile(storage_api, f);
+        storage_api->CloseFile(storage_api, file_handle);
         return err;
     }
-    size_t block_mem_size = Longtail_GetStoredBlockSize(stored_block_data_size);
-    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("ReadStoredBlock", block_mem_size);
-    if (!stored_block)
+    void* buffer = Longtail_Alloc("ReadFileInfos", size == 0 ? 1 : (size_t)size);
+    if (!buffer)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        storage_api->CloseFile(storage_api, f);
+        storage_api->CloseFile(storage_api, file_handle);
         return ENOMEM;
     }
-    void* block_data = &((uint8_t*)stored_block)[block_mem_size - stored_block_data_size];
-    err = storage_api->Read(storage_api, f, 0, stored_block_data_size, block_data);
+    err = storage_api->Read(storage_api, file_handle, 0, size, buffer);
+    storage_api->CloseFile(storage_api, file_handle);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
-        Longtail_Free(stored_block);
-        storage_api->CloseFile(storage_api, f);
+        Longtail_Free(buffer);
         return err;
     }
-    storage_api->CloseFile(storage_api, f);
-    err = Longtail_InitStoredBlockFromData(
-        stored_block,
-        block_data,
-        stored_block_data_size);
+    err = Longtail_ReadFileInfosFromBuffer(buffer, (size_t)size, out_file_infos);
+    Longtail_Free(buffer);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitStoredBlockFromData() failed with %d", err)
-        Longtail_Free(stored_block);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_ReadFileInfosFromBuffer() failed with %d", err)
         return err;
     }
-    stored_block->Dispose = ReadStoredBlock_Dispose;
-    *out_stored_block = stored_block;
     return 0;
 }
 
-static uint32_t GetUniqueHashes(
-    uint32_t hash_count,
-    const TLongtail_Hash* hashes,
-    uint32_t* out_unique_hash_indexes)
+size_t Longtail_GetBlockIndexDataSize(uint32_t chunk_count)
 {
+#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(hash_count, "%u"),
-        LONGTAIL_LOGFIELD(hashes, "%p"),
-        LONGTAIL_LOGFIELD(out_unique_hash_indexes, "%p")
+        LONGTAIL_LOGFIELD(chunk_count, "%u")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+    return
+        sizeof(TLongtail_Hash) +                    // m_BlockHash
+        sizeof(uint32_t) +                          // m_HashIdentifier
+        sizeof(uint32_t) +                          // m_ChunkCount
+        sizeof(uint32_t) +                          // m_Tag
+        (sizeof(TLongtail_Hash) * chunk_count) +    // m_ChunkHashes
+        (sizeof(uint32_t) * chunk_count);           // m_ChunkSizes
+}
 
-    LONGTAIL_FATAL_ASSERT(ctx, hash_count != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, hashes != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, hash_count == 0 || out_unique_hash_indexes != 0, return 0)
+struct Longtail_BlockIndex* Longtail_InitBlockIndex(void* mem, uint32_t chunk_count)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(mem, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+    LONGTAIL_VALIDATE_INPUT(ctx, mem != 0, return 0)
 
-    struct Longtail_LookupTable* lookup_table = Longtail_LookupTable_Create(Longtail_Alloc("GetUniqueHashes", Longtail_LookupTable_GetSize(hash_count)), hash_count, 0);
-    if (!lookup_table)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return 0;
-    }
+    struct Longtail_BlockIndex* block_index = (struct Longtail_BlockIndex*)mem;
+    char* p = (char*)&block_index[1];
 
-    uint32_t unique_hash_count = 0;
-    for (uint32_t i = 0; i < hash_count; ++i)
-    {
-        TLongtail_Hash hash = hashes[i];
-        uint32_t* lookup_index = Longtail_LookupTable_PutUnique(lookup_table, hash, unique_hash_count);
-        if (lookup_index == 0)
-        {
-            out_unique_hash_indexes[unique_hash_count++] = i;
-        }
-        else
-        {
-            // Take the last chunk hash we find
-            out_unique_hash_indexes[*lookup_index] = i;
-        }
-    }
-    Longtail_Free(lookup_table);
-    lookup_table = 0;
-    return unique_hash_count;
+    block_index->m_BlockHash = (TLongtail_Hash*)(void*)p;
+    p += sizeof(TLongtail_Hash);
+
+    block_index->m_HashIdentifier = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    block_index->m_ChunkCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    block_index->m_Tag = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    block_index->m_ChunkHashes = (TLongtail_Hash*)(void*)p;
+    p += sizeof(TLongtail_Hash) * chunk_count;
+
+    block_index->m_ChunkSizes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * chunk_count;
+
+    return block_index;
 }
 
-int Longtail_GetRequiredChunkHashes(
-    const struct Longtail_VersionIndex* version_index,
-    const struct Longtail_VersionDiff* version_diff,
-    uint32_t* out_chunk_count,
-    TLongtail_Hash* out_chunk_hashes)
+struct Longtail_BlockIndex* Longtail_CopyBlockIndex(struct Longtail_BlockIndex* block_index)
+{
+    uint32_t chunk_count = *block_index->m_ChunkCount;
+    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
+    void* mem = Longtail_Alloc("Longtail_CopyBlockIndex", block_index_size);
+    struct Longtail_BlockIndex* copy_block_index = Longtail_InitBlockIndex(mem, chunk_count);
+    *copy_block_index->m_BlockHash = *block_index->m_BlockHash;
+    *copy_block_index->m_HashIdentifier = *block_index->m_HashIdentifier;
+    *copy_block_index->m_ChunkCount = *block_index->m_ChunkCount;
+    *copy_block_index->m_Tag = *block_index->m_Tag;
+    memcpy(copy_block_index->m_ChunkHashes, block_index->m_ChunkHashes, sizeof(TLongtail_Hash) * chunk_count);
+    memcpy(copy_block_index->m_ChunkSizes, block_index->m_ChunkSizes, sizeof(uint32_t) * chunk_count);
+    return copy_block_index;
+}
+
+int Longtail_InitBlockIndexFromData(
+    struct Longtail_BlockIndex* block_index,
+    void* data,
+    uint64_t data_size)
 {
+#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(version_diff, "%p"),
-        LONGTAIL_LOGFIELD(out_chunk_count, "%p"),
-        LONGTAIL_LOGFIELD(out_chunk_hashes, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+        LONGTAIL_LOGFIELD(block_index, "%p"),
+        LONGTAIL_LOGFIELD(data, "%p"),
+        LONGTAIL_LOGFIELD(data_size, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+    LONGTAIL_VALIDATE_INPUT(ctx, block_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, data != 0, return EINVAL)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_diff != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_chunk_count != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, (*version_index->m_ChunkCount == 0) ||  out_chunk_hashes != 0, return EINVAL)
+    char* p = (char*)data;
 
-    uint32_t max_chunk_count = *version_index->m_ChunkCount;
-    void* work_mem = Longtail_Alloc("GetRequiredChunkHashes", Longtail_LookupTable_GetSize(max_chunk_count));
-    if (!work_mem)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
-    }
+    block_index->m_BlockHash = (TLongtail_Hash*)(void*)p;
+    p += sizeof(TLongtail_Hash);
 
-    struct Longtail_LookupTable* chunk_lookup = Longtail_LookupTable_Create(work_mem, max_chunk_count, 0);
+    block_index->m_HashIdentifier = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
 
-    uint32_t chunk_count = 0;
+    block_index->m_ChunkCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
 
-    uint32_t added_asset_count = *version_diff->m_TargetAddedCount;
-    for (uint32_t a = 0; a < added_asset_count; ++a)
-    {
-        uint32_t asset_index = version_diff->m_TargetAddedAssetIndexes[a];
-        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
-        uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
-        for (uint32_t ci = 0; ci < asset_chunk_count; ++ci)
-        {
-            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + ci];
-            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
-            if (0 == Longtail_LookupTable_PutUnique(chunk_lookup, chunk_hash, chunk_count))
-            {
-                out_chunk_hashes[chunk_count] = chunk_hash;
-                ++chunk_count;
-            }
-        }
-    }
-    uint32_t modified_asset_count = *version_diff->m_ModifiedContentCount;
-    for (uint32_t a = 0; a < modified_asset_count; ++a)
+    block_index->m_Tag = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    uint32_t chunk_count = *block_index->m_ChunkCount;
+
+    size_t block_index_data_size = Longtail_GetBlockIndexDataSize(chunk_count);
+    if (block_index_data_size > data_size)
     {
-        uint32_t asset_index = version_diff->m_TargetContentModifiedAssetIndexes[a];
-        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
-        uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
-        for (uint32_t ci = 0; ci < asset_chunk_count; ++ci)
-        {
-            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + ci];
-            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
-            if (0 == Longtail_LookupTable_PutUnique(chunk_lookup, chunk_hash, chunk_count))
-            {
-                out_chunk_hashes[chunk_count] = chunk_hash;
-                ++chunk_count;
-            }
-        }
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Chunk count results in block index data %" PRIu64 " larger that data size (%" PRIu64 ")", block_index_data_size, data)
+        return EBADF;
     }
 
-    Longtail_Free(work_mem);
-    *out_chunk_count = chunk_count;
+    block_index->m_ChunkHashes = (TLongtail_Hash*)(void*)p;
+    p += sizeof(TLongtail_Hash) * chunk_count;
+
+    block_index->m_ChunkSizes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * chunk_count;
 
     return 0;
 }
 
-struct ChunkAssetPartReference
+size_t Longtail_GetBlockIndexSize(uint32_t chunk_count)
 {
-    const char* m_AssetPath;
-    uint32_t m_ChunkIndex;
-    uint64_t m_AssetOffset;
-    uint32_t m_Tag;
-};
+    size_t block_index_size =
+        sizeof(struct Longtail_BlockIndex) +
+        Longtail_GetBlockIndexDataSize(chunk_count);
 
-struct AssetPartLookup
-{
-    struct ChunkAssetPartReference* m_ChunkAssetPartReferences;
-    struct Longtail_LookupTable* m_ChunkHashToIndex;
-};
+    return block_index_size;
+}
 
-static int CreateAssetPartLookup(
-    struct Longtail_VersionIndex* version_index,
-    struct AssetPartLookup** out_assert_part_lookup)
+int Longtail_CreateBlockIndex(
+    struct Longtail_HashAPI* hash_api,
+    uint32_t tag,
+    uint32_t chunk_count,
+    const uint32_t* chunk_indexes,
+    const TLongtail_Hash* chunk_hashes,
+    const uint32_t* chunk_sizes,
+    struct Longtail_BlockIndex** out_block_index)
 {
+#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(out_assert_part_lookup, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-
-    LONGTAIL_FATAL_ASSERT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, out_assert_part_lookup != 0, return EINVAL)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(tag, "%u"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_indexes, "%p"),
+        LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
+        LONGTAIL_LOGFIELD(out_block_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    uint32_t asset_chunk_index_count = *version_index->m_AssetChunkIndexCount;
-    size_t asset_part_lookup_size =
-        sizeof(struct AssetPartLookup) +
-        Longtail_LookupTable_GetSize(asset_chunk_index_count) +
-        sizeof(struct ChunkAssetPartReference) * asset_chunk_index_count;
-    struct AssetPartLookup* asset_part_lookup = (struct AssetPartLookup*)Longtail_Alloc("CreateAssetPartLookup", asset_part_lookup_size);
-    if (!asset_part_lookup_size)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_indexes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_hashes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_sizes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_block_index != 0, return EINVAL)
+
+    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
+    void* mem = Longtail_Alloc("CreateBlockIndex", block_index_size);
+    if (mem == 0)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
-    asset_part_lookup->m_ChunkAssetPartReferences = (struct ChunkAssetPartReference*)&asset_part_lookup[1];
-    asset_part_lookup->m_ChunkHashToIndex = Longtail_LookupTable_Create(&asset_part_lookup->m_ChunkAssetPartReferences[asset_chunk_index_count], asset_chunk_index_count, 0);
 
-    uint32_t unique_chunk_count = 0;
-    uint32_t asset_count = *version_index->m_AssetCount;
-    for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
+    struct Longtail_BlockIndex* block_index = Longtail_InitBlockIndex(mem, chunk_count);
+    for (uint32_t i = 0; i < chunk_count; ++i)
     {
-        const char* path = &version_index->m_NameData[version_index->m_NameOffsets[asset_index]];
-        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
-        uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
-        uint64_t asset_chunk_offset = 0;
-        for (uint32_t asset_chunk_index = 0; asset_chunk_index < asset_chunk_count; ++asset_chunk_index)
-        {
-            LONGTAIL_FATAL_ASSERT(ctx, asset_chunk_index_start + asset_chunk_index < *version_index->m_AssetChunkIndexCount, return EINVAL)
-            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + asset_chunk_index];
-            LONGTAIL_FATAL_ASSERT(ctx, chunk_index < *version_index->m_ChunkCount, return EINVAL)
-            uint32_t chunk_size = version_index->m_ChunkSizes[chunk_index];
-            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
-            uint32_t tag = version_index->m_ChunkTags[chunk_index];
-            if (0 == Longtail_LookupTable_PutUnique(asset_part_lookup->m_ChunkHashToIndex, chunk_hash, unique_chunk_count))
-            {
-                struct ChunkAssetPartReference chunk_asset_part_reference =
-                {
-                    path,
-                    unique_chunk_count,
-                    asset_chunk_offset,
-                    tag
-                };
-                asset_part_lookup->m_ChunkAssetPartReferences[unique_chunk_count++] = chunk_asset_part_reference;
-            }
-            asset_chunk_offset += chunk_size;
-        }
+        uint32_t chunk_index = chunk_indexes[i];
+        block_index->m_ChunkHashes[i] = chunk_hashes[chunk_index];
+        block_index->m_ChunkSizes[i] = chunk_sizes[chunk_index];
     }
-    *out_assert_part_lookup = asset_part_lookup;
+    size_t hash_buffer_size = sizeof(TLongtail_Hash) * chunk_count;
+    int err = hash_api->HashBuffer(hash_api, (uint32_t)(hash_buffer_size), (void*)block_index->m_ChunkHashes, block_index->m_BlockHash);
+    if (err != 0)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_api->HashBuffer() failed with %d", err)
+        Longtail_Free(mem);
+        return err;
+    }
+    *block_index->m_HashIdentifier = hash_api->GetIdentifier(hash_api);
+    *block_index->m_Tag = tag;
+    *block_index->m_ChunkCount = chunk_count;
+
+    *out_block_index = block_index;
     return 0;
 }
 
-struct WriteBlockJob
-{
-    struct Longtail_AsyncPutStoredBlockAPI m_AsyncCompleteAPI;
-    struct Longtail_StorageAPI* m_SourceStorageAPI;
-    struct Longtail_BlockStoreAPI* m_BlockStoreAPI;
-    struct Longtail_JobAPI* m_JobAPI;
-    uint32_t m_JobID;
-    struct Longtail_StoredBlock* m_StoredBlock;
-    const char* m_AssetsFolder;
-    const struct Longtail_StoreIndex* m_StoreIndex;
-    struct AssetPartLookup* m_AssetPartLookup;
-    uint32_t m_BlockIndex;
-    int m_Err;
-};
-
-static void BlockWriterJobOnComplete(struct Longtail_AsyncPutStoredBlockAPI* async_complete_api, int err)
+int Longtail_WriteBlockIndexToBuffer(
+    const struct Longtail_BlockIndex* block_index,
+    void** out_buffer,
+    size_t* out_size)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
-        LONGTAIL_LOGFIELD(err, "%d")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+        LONGTAIL_LOGFIELD(block_index, "%p"),
+        LONGTAIL_LOGFIELD(out_buffer, "%p"),
+        LONGTAIL_LOGFIELD(out_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    if (err)
+    LONGTAIL_VALIDATE_INPUT(ctx, block_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_buffer != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_size != 0, return EINVAL)
+
+    size_t index_data_size = Longtail_GetBlockIndexDataSize(*block_index->m_ChunkCount);
+    *out_buffer = Longtail_Alloc("WriteBlockIndexToBuffer", index_data_size);
+    if (!(*out_buffer))
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BlockWriterJobOnComplete() caller failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
     }
-    LONGTAIL_FATAL_ASSERT(ctx, async_complete_api != 0, return)
-    struct WriteBlockJob* job = (struct WriteBlockJob*)async_complete_api;
-    LONGTAIL_FATAL_ASSERT(ctx, job->m_AsyncCompleteAPI.OnComplete != 0, return);
-    LONGTAIL_FATAL_ASSERT(ctx, job->m_StoredBlock != 0, return);
-    LONGTAIL_FATAL_ASSERT(ctx, job->m_JobID != 0, return);
-    uint32_t job_id = job->m_JobID;
-    job->m_StoredBlock->Dispose(job->m_StoredBlock);
-    job->m_StoredBlock = 0;
-    job->m_JobID = 0;
-    job->m_Err = err;
-    job->m_JobAPI->ResumeJob(job->m_JobAPI, job_id);
+    memcpy(*out_buffer, &block_index[1], index_data_size);
+    *out_size = index_data_size;
+    return 0;
 }
 
-static int DisposePutBlock(struct Longtail_StoredBlock* stored_block)
+int Longtail_ReadBlockIndexFromBuffer(
+    const void* buffer,
+    size_t size,
+    struct Longtail_BlockIndex** out_block_index)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(stored_block, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+        LONGTAIL_LOGFIELD(buffer, "%p"),
+        LONGTAIL_LOGFIELD(size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_block_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    Longtail_Free(stored_block);
+    LONGTAIL_VALIDATE_INPUT(ctx, buffer != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, size != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_block_index != 0, return EINVAL)
+
+    size_t block_index_size = size + sizeof(struct Longtail_BlockIndex);
+    struct Longtail_BlockIndex* block_index = (struct Longtail_BlockIndex*)Longtail_Alloc("ReadBlockIndexFromBuffer", block_index_size);
+    if (!block_index)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    memcpy(&block_index[1], buffer, size);
+    int err = Longtail_InitBlockIndexFromData(block_index, &block_index[1], size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitBlockIndexFromData() failed with %d", err)
+        Longtail_Free(block_index);
+        return err;
+    }
+    *out_block_index = block_index;
     return 0;
 }
 
-static int WriteContentBlockJob(void* context, uint32_t job_id, int is_cancelled)
+int Longtail_WriteBlockIndex(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_BlockIndex* block_index,
+    const char* path)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(context, "%p"),
-        LONGTAIL_LOGFIELD(job_id, "%u"),
-        LONGTAIL_LOGFIELD(is_cancelled, "%d")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(block_index, "%p"),
+        LONGTAIL_LOGFIELD(path, "%s")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
-
-    struct WriteBlockJob* job = (struct WriteBlockJob*)context;
-    LONGTAIL_FATAL_ASSERT(ctx, job->m_JobID == 0, return EINVAL);
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, block_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
 
-    if (job->m_AsyncCompleteAPI.OnComplete)
+    int err = EnsureParentPathExists(storage_api, path);
+    if (err)
     {
-        // We got a notification so we are complete
-        job->m_AsyncCompleteAPI.OnComplete = 0;
-        return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+        return err;
     }
-
-    if (is_cancelled)
+    Longtail_StorageAPI_HOpenFile file_handle;
+    err = storage_api->OpenWriteFile(storage_api, path, 0, &file_handle);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "WriteContentBlock was cancelled, failed with %d", ECANCELED)
-        job->m_Err = ECANCELED;
-        return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile) failed with %d", err)
+        return err;
+    }
+    size_t index_data_size = Longtail_GetBlockIndexDataSize(*block_index->m_ChunkCount);
+    err = storage_api->Write(storage_api, file_handle, 0, index_data_size, &block_index[1]);
+    if (err){
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
+        storage_api->CloseFile(storage_api, file_handle);
+        file_handle = 0;
+        return err;
     }
+    storage_api->CloseFile(storage_api, file_handle);
 
-    struct Longtail_StorageAPI* source_storage_api = job->m_SourceStorageAPI;
-    struct Longtail_BlockStoreAPI* block_store_api = job->m_BlockStoreAPI;
+    return 0;
+}
 
-    const struct Longtail_StoreIndex* store_index = job->m_StoreIndex;
+struct Longtail_BlockIndexHeader
+{
+    TLongtail_Hash m_BlockHash;
+    uint32_t m_HashIdentifier;
+    uint32_t m_ChunkCount;
+    uint32_t m_Tag;
+};
 
-    TLongtail_Hash block_hash = store_index->m_BlockHashes[job->m_BlockIndex];
+int Longtail_ReadBlockIndex(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    struct Longtail_BlockIndex** out_block_index)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(path, "%s"),
+        LONGTAIL_LOGFIELD(out_block_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    uint32_t chunk_count = store_index->m_BlockChunkCounts[job->m_BlockIndex];
-    uint32_t first_chunk_index = store_index->m_BlockChunksOffsets[job->m_BlockIndex];
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_block_index != 0, return EINVAL)
 
-    uint32_t block_data_size = 0;
-    for (uint32_t chunk_index = first_chunk_index; chunk_index < first_chunk_index + chunk_count; ++chunk_index)
+    Longtail_StorageAPI_HOpenFile f;
+    int err = storage_api->OpenReadFile(storage_api, path, &f);
+    if (err)
     {
-        uint32_t chunk_size = store_index->m_ChunkSizes[chunk_index];
-        block_data_size += chunk_size;
+        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_WARNING : LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+        return err;
     }
-
-    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
-    size_t stored_block_size = sizeof(struct Longtail_StoredBlock);
-    size_t put_block_mem_size =
-        stored_block_size +
-        block_index_size +
-        block_data_size;
-
-    void* put_block_mem = Longtail_Alloc("WriteContentBlockJob", put_block_mem_size);
-    if (!put_block_mem)
+    uint64_t block_size;
+    err = storage_api->GetSize(storage_api, f, &block_size);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM);
-        job->m_Err = ENOMEM;
-        return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetSize() failed with %d", err)
+        storage_api->CloseFile(storage_api, f);
+        return err;
     }
-
-    char* p = (char*)put_block_mem;
-    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)p;
-    p += stored_block_size;
-    struct Longtail_BlockIndex* block_index_ptr = (struct Longtail_BlockIndex*)p;
-    p += block_index_size;
-    char* block_data_buffer = p;
-
-    char* write_buffer = block_data_buffer;
-    char* write_ptr = write_buffer;
-
-    const char* asset_path = 0;
-    uint32_t tag = 0;
-
-    Longtail_StorageAPI_HOpenFile file_handle = 0;
-    uint64_t asset_file_size = 0;
-
-    for (uint32_t chunk_index = first_chunk_index; chunk_index < first_chunk_index + chunk_count; ++chunk_index)
+    if (block_size < sizeof(struct Longtail_BlockIndexHeader))
     {
-        TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_index];
-        uint32_t chunk_size = store_index->m_ChunkSizes[chunk_index];
-        uint32_t* asset_part_index = Longtail_LookupTable_Get(job->m_AssetPartLookup->m_ChunkHashToIndex, chunk_hash);
-        LONGTAIL_FATAL_ASSERT(ctx, asset_part_index != 0, job->m_Err = EINVAL; return 0)
-        const struct ChunkAssetPartReference* next_asset_part = &job->m_AssetPartLookup->m_ChunkAssetPartReferences[*asset_part_index];
-
-        if (asset_path && tag != next_asset_part->m_Tag)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "WriteContentBlockJob(%p, %u, %d): Warning: Inconsistent tag type for chunks inside block 0x%" PRIx64 ", retaining 0x%" PRIx64 "",
-                context, job_id, is_cancelled,
-                block_hash, tag)
-        }
-        else
-        {
-            tag = next_asset_part->m_Tag;
-        }
-
-        if (next_asset_part->m_AssetPath != asset_path)
-        {
-            if (file_handle)
-            {
-                source_storage_api->CloseFile(source_storage_api, file_handle);
-                file_handle = 0;
-            }
-            LONGTAIL_FATAL_ASSERT(ctx, !IsDirPath(next_asset_part->m_AssetPath), job->m_Err = EINVAL; return 0)
-
-            char* full_path = source_storage_api->ConcatPath(source_storage_api, job->m_AssetsFolder, next_asset_part->m_AssetPath);
-            int err = source_storage_api->OpenReadFile(source_storage_api, full_path, &file_handle);
-            Longtail_Free(full_path);
-            full_path = 0;
-            if (err)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "source_storage_api->OpenReadFile() failed with %d", err);
-                Longtail_Free(put_block_mem);
-                job->m_Err = err;
-                return 0;
-            }
-            uint64_t next_asset_file_size = 0;
-            err = source_storage_api->GetSize(source_storage_api, file_handle, &next_asset_file_size);
-            if (err)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "source_storage_api->GetSize() failed with %d", err);
-                Longtail_Free(put_block_mem);
-                job->m_Err = err;
-                return 0;
-            }
-            asset_file_size = next_asset_file_size;
-            asset_path = next_asset_part->m_AssetPath;
-        }
-
-        uint64_t asset_offset = next_asset_part->m_AssetOffset;
-        if (asset_file_size < (asset_offset + chunk_size))
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Source asset file does not match indexed size %" PRIu64 " < %" PRIu64,
-                asset_file_size, (asset_offset + chunk_size))
-            Longtail_Free(put_block_mem);
-            source_storage_api->CloseFile(source_storage_api, file_handle);
-            job->m_Err = EBADF;
-            return 0;
-        }
-        int err = source_storage_api->Read(source_storage_api, file_handle, asset_offset, chunk_size, write_ptr);
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "source_storage_api->Read() failed with %d", err);
-            Longtail_Free(put_block_mem);
-            source_storage_api->CloseFile(source_storage_api, file_handle);
-            job->m_Err = err;
-            return 0;
-        }
-        write_ptr += chunk_size;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "file size %" PRIu64 " is to small, expected at least %" PRIu64 " bytes", block_size, sizeof(struct Longtail_BlockIndexHeader))
+        storage_api->CloseFile(storage_api, f);
+        return EBADF;
+    }
+    if (block_size > 0xffffffff)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "file size %" PRIu64 " is to large, size can be at most %" PRIu64 " bytes", block_size, 0xffffffff)
+        storage_api->CloseFile(storage_api, f);
+        return EBADF;
     }
+    uint64_t read_offset = 0;
 
-    if (file_handle)
+    struct Longtail_BlockIndexHeader blockIndexHeader;
+    err = storage_api->Read(storage_api, f, read_offset, sizeof(struct Longtail_BlockIndexHeader), &blockIndexHeader);
+    if (err)
     {
-        source_storage_api->CloseFile(source_storage_api, file_handle);
-        file_handle = 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
+        storage_api->CloseFile(storage_api, f);
+        return err;
     }
+    read_offset += sizeof(struct Longtail_BlockIndexHeader);
 
-    Longtail_InitBlockIndex(block_index_ptr, chunk_count);
-    memmove(block_index_ptr->m_ChunkHashes, &store_index->m_ChunkHashes[first_chunk_index], sizeof(TLongtail_Hash) * chunk_count);
-    memmove(block_index_ptr->m_ChunkSizes, &store_index->m_ChunkSizes[first_chunk_index], sizeof(uint32_t) * chunk_count);
-    *block_index_ptr->m_BlockHash = block_hash;
-    *block_index_ptr->m_HashIdentifier = *store_index->m_HashIdentifier;
-    *block_index_ptr->m_Tag = tag;
-    *block_index_ptr->m_ChunkCount = chunk_count;
-    job->m_StoredBlock = stored_block;
-    job->m_StoredBlock->Dispose = DisposePutBlock;
-    job->m_StoredBlock->m_BlockIndex = block_index_ptr;
-    job->m_StoredBlock->m_BlockData = block_data_buffer;
-    job->m_StoredBlock->m_BlockChunksDataSize = block_data_size;
+    if (blockIndexHeader.m_ChunkCount == 0)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "blockIndexHeader.m_ChunkCount (%u) must be larger than zero", blockIndexHeader.m_ChunkCount)
+        storage_api->CloseFile(storage_api, f);
+        return EBADF;
+    }
 
-    job->m_JobID = job_id;
-    job->m_AsyncCompleteAPI.OnComplete = BlockWriterJobOnComplete;
+    uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(blockIndexHeader.m_ChunkCount);
+    if (block_index_data_size >= block_size)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_index_data_size %" PRIu64 " is to large, size can be at most %" PRIu64 " bytes", block_index_data_size, block_size)
+        storage_api->CloseFile(storage_api, f);
+        return EBADF;
+    }
 
-    int err = block_store_api->PutStoredBlock(block_store_api, job->m_StoredBlock, &job->m_AsyncCompleteAPI);
+    size_t block_index_size = Longtail_GetBlockIndexSize(blockIndexHeader.m_ChunkCount);
+    void* block_index_mem = Longtail_Alloc("ReadBlockIndex", block_index_size);
+    if (!block_index_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        storage_api->CloseFile(storage_api, f);
+        return ENOMEM;
+    }
+    struct Longtail_BlockIndex* block_index = Longtail_InitBlockIndex(block_index_mem, blockIndexHeader.m_ChunkCount);
+    err = storage_api->Read(storage_api, f, 0, block_index_data_size, &block_index[1]);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_store_api->PutStoredBlock() failed with %d", err);
-        job->m_StoredBlock->Dispose(job->m_StoredBlock);
-        job->m_StoredBlock = 0;
-        job->m_JobID = 0;
-        job->m_Err = err;
-        return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
+        Longtail_Free(block_index);
+        storage_api->CloseFile(storage_api, f);
+        return err;
     }
+    storage_api->CloseFile(storage_api, f);
+    *out_block_index = block_index;
+    return 0;
+}
 
-    return EBUSY;
+static int DisposeStoredBlock(struct Longtail_StoredBlock* stored_block)
+{
+    Longtail_Free(stored_block);
+    return 0;
 }
 
-int Longtail_WriteContent(
-    struct Longtail_StorageAPI* source_storage_api,
-    struct Longtail_BlockStoreAPI* block_store_api,
-    struct Longtail_JobAPI* job_api,
-    struct Longtail_ProgressAPI* progress_api,
-    struct Longtail_CancelAPI* optional_cancel_api,
-    Longtail_CancelAPI_HCancelToken optional_cancel_token,
-    struct Longtail_StoreIndex* store_index,
-    struct Longtail_VersionIndex* version_index,
-    const char* assets_folder)
+size_t Longtail_GetStoredBlockSize(size_t block_data_size)
+{
+    return sizeof(struct Longtail_StoredBlock) + sizeof(struct Longtail_BlockIndex) + block_data_size;
+}
+
+int Longtail_InitStoredBlockFromData(
+    struct Longtail_StoredBlock* stored_block,
+    void* block_data,
+    size_t block_data_size)
 {
+#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(source_storage_api, "%p"),
-        LONGTAIL_LOGFIELD(block_store_api, "%p"),
-        LONGTAIL_LOGFIELD(job_api, "%p"),
-        LONGTAIL_LOGFIELD(progress_api, "%p"),
-        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
-        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
-        LONGTAIL_LOGFIELD(store_index, "%p"),
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(assets_folder, "%s")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(block_data, "%p"),
+        LONGTAIL_LOGFIELD(block_data_size, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, source_storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, assets_folder != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, stored_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, block_data != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, block_data_size > 0, return EINVAL)
 
-    uint32_t block_count = *store_index->m_BlockCount;
-    if (block_count == 0)
+    stored_block->m_BlockIndex = (struct Longtail_BlockIndex*)&stored_block[1];
+    int err = Longtail_InitBlockIndexFromData(
+        stored_block->m_BlockIndex,
+        block_data,
+        block_data_size);
+    if (err)
     {
-        return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitBlockIndexFromData() failed with %d", err)
+        return err;
     }
+    stored_block->m_BlockData = &((uint8_t*)stored_block->m_BlockIndex)[Longtail_GetBlockIndexSize(*stored_block->m_BlockIndex->m_ChunkCount)];
+    stored_block->m_BlockChunksDataSize = (uint32_t)(block_data_size - Longtail_GetBlockIndexDataSize(*stored_block->m_BlockIndex->m_ChunkCount));
+    stored_block->Dispose = 0;
+    return 0;
+}
 
-    uint32_t version_chunk_count = *version_index->m_ChunkCount;
-    uint32_t version_store_index_chunk_count = *store_index->m_ChunkCount;
-
-    size_t chunk_lookup_size = Longtail_LookupTable_GetSize(version_chunk_count);
-    size_t chunk_sizes_size = sizeof(uint32_t) * version_store_index_chunk_count;
-    size_t write_block_jobs_size = sizeof(struct WriteBlockJob) * block_count;
-    size_t funcs_size = sizeof(Longtail_JobAPI_JobFunc*) * block_count;
-    size_t ctxs_size = sizeof(void*) * block_count;
+int Longtail_CreateStoredBlock(
+    TLongtail_Hash block_hash,
+    uint32_t hash_identifier,
+    uint32_t chunk_count,
+    uint32_t tag,
+    TLongtail_Hash* chunk_hashes,
+    uint32_t* chunk_sizes,
+    uint32_t block_data_size,
+    struct Longtail_StoredBlock** out_stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(hash_identifier, "%u"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(tag, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
+        LONGTAIL_LOGFIELD(block_data_size, "%u"),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    size_t work_mem_size =
-        chunk_lookup_size +
-        chunk_sizes_size +
-        write_block_jobs_size +
-        funcs_size +
-        ctxs_size;
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_stored_block != 0, return EINVAL)
 
-    void* work_mem = Longtail_Alloc("WriteContent", work_mem_size);
-    if (!work_mem)
+    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
+    size_t stored_block_size = sizeof(struct Longtail_StoredBlock) + block_index_size + block_data_size;
+    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("CreateStoredBlock", stored_block_size);
+    if (stored_block == 0)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
+    stored_block->m_BlockIndex = Longtail_InitBlockIndex(&stored_block[1], chunk_count);
+    LONGTAIL_FATAL_ASSERT(ctx, stored_block->m_BlockIndex != 0, return EINVAL)
 
-    char* p = (char*)work_mem;
-
-    struct Longtail_LookupTable* chunk_lookup = Longtail_LookupTable_Create(p, version_chunk_count, 0);
-    p += chunk_lookup_size;
-    uint32_t* chunk_sizes = (uint32_t*)p;
-    p += chunk_sizes_size;
-    struct WriteBlockJob* write_block_jobs = (struct WriteBlockJob*)p;
-    p += write_block_jobs_size;
-    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)p;
-    p += funcs_size;
-    void** ctxs = (void**)p;
+    *stored_block->m_BlockIndex->m_BlockHash = block_hash;
+    *stored_block->m_BlockIndex->m_HashIdentifier = hash_identifier;
+    *stored_block->m_BlockIndex->m_ChunkCount = chunk_count;
+    *stored_block->m_BlockIndex->m_Tag = tag;
+    memmove(stored_block->m_BlockIndex->m_ChunkHashes, chunk_hashes, sizeof(TLongtail_Hash) * chunk_count);
+    memmove(stored_block->m_BlockIndex->m_ChunkSizes, chunk_sizes, sizeof(uint32_t) * chunk_count);
 
-    for (uint32_t c = 0; c < version_chunk_count; ++c)
-    {
-        Longtail_LookupTable_Put(chunk_lookup, version_index->m_ChunkHashes[c], c);
-    }
+    stored_block->Dispose = DisposeStoredBlock;
+    stored_block->m_BlockData = ((uint8_t*)stored_block->m_BlockIndex) + block_index_size;
+    stored_block->m_BlockChunksDataSize = block_data_size;
+    *out_stored_block = stored_block;
+    return 0;
+}
 
-    for (uint32_t c = 0; c < version_store_index_chunk_count; ++c)
-    {
-        uint32_t* version_chunk_index = Longtail_LookupTable_Get(chunk_lookup, store_index->m_ChunkHashes[c]);
-        if (version_chunk_index == 0)
-        {
-            Longtail_Free(work_mem);
-            return EINVAL;
-        }
-        chunk_sizes[c] = version_index->m_ChunkSizes[*version_chunk_index];
-    }
+static int ReadStoredBlock_Dispose(struct Longtail_StoredBlock* stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    struct AssetPartLookup* asset_part_lookup;
-    int err = CreateAssetPartLookup(version_index, &asset_part_lookup);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateAssetPartLookup() failed with %d", err)
-        Longtail_Free(work_mem);
-        return err;
-    }
+    LONGTAIL_FATAL_ASSERT(ctx, stored_block, return EINVAL)
 
-    uint32_t job_count = 0;
-    for (uint32_t block_index = 0; block_index < block_count; ++block_index)
-    {
-        TLongtail_Hash block_hash = store_index->m_BlockHashes[block_index];
+    Longtail_Free(stored_block);
+    return 0;
+}
 
-        struct WriteBlockJob* job = &write_block_jobs[job_count];
-        job->m_AsyncCompleteAPI.m_API.Dispose = 0;
-        job->m_AsyncCompleteAPI.OnComplete = 0;
-        job->m_SourceStorageAPI = source_storage_api;
-        job->m_BlockStoreAPI = block_store_api;
-        job->m_JobAPI = job_api;
-        job->m_JobID = 0;
-        job->m_StoredBlock = 0;
-        job->m_AssetsFolder = assets_folder;
-        job->m_StoreIndex = store_index;
-        job->m_BlockIndex = block_index;
-        job->m_AssetPartLookup = asset_part_lookup;
-        job->m_Err = EINVAL;
+int Longtail_WriteStoredBlockToBuffer(
+    const struct Longtail_StoredBlock* stored_block,
+    void** out_buffer,
+    size_t* out_size)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(out_buffer, "%p"),
+        LONGTAIL_LOGFIELD(out_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-        funcs[job_count] = WriteContentBlockJob;
-        ctxs[job_count] = job;
+    LONGTAIL_VALIDATE_INPUT(ctx, stored_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_buffer != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_size != 0, return EINVAL)
 
-        ++job_count;
-    }
+    uint32_t chunk_count = *stored_block->m_BlockIndex->m_ChunkCount;
+    uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(chunk_count);
 
-    if (job_count == 0)
-    {
-        Longtail_Free(asset_part_lookup);
-        Longtail_Free(work_mem);
-        return 0;
-    }
+    size_t size = block_index_data_size + stored_block->m_BlockChunksDataSize;
 
-    Longtail_JobAPI_Group job_group = 0;
-    err = job_api->ReserveJobs(job_api, job_count, &job_group);
-    if (err)
+    void* mem = (uint8_t*)Longtail_Alloc("WriteStoredBlockToBuffer", size);
+    if (!mem)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
-        Longtail_Free(asset_part_lookup);
-        Longtail_Free(work_mem);
-        return err;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
     }
+    uint8_t* write_ptr = (uint8_t*)mem;
 
-    Longtail_JobAPI_Jobs jobs;
-    err = job_api->CreateJobs(job_api, job_group, job_count, funcs, ctxs, &jobs);
-    LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
-    err = job_api->ReadyJobs(job_api, job_count, jobs);
-    LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+    memcpy(write_ptr, &stored_block->m_BlockIndex[1], block_index_data_size);
+    write_ptr += block_index_data_size;
+    memcpy(write_ptr, stored_block->m_BlockData, stored_block->m_BlockChunksDataSize);
 
-    err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
-        Longtail_Free(asset_part_lookup);
-        Longtail_Free(work_mem);
-        return err;
-    }
+    *out_size = size;
+    *out_buffer = mem;
+    return 0;
+}
 
-    err = 0;
-    while (job_count--)
-    {
-        struct WriteBlockJob* job = &write_block_jobs[job_count];
-        if (job->m_Err)
-        {
-            err = err ? err : job->m_Err;
-        }
-    }
+int Longtail_ReadStoredBlockFromBuffer(
+    const void* buffer,
+    size_t size,
+    struct Longtail_StoredBlock** out_stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(buffer, "%p"),
+        LONGTAIL_LOGFIELD(size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    Longtail_Free(asset_part_lookup);
-    asset_part_lookup = 0;
+    LONGTAIL_VALIDATE_INPUT(ctx, buffer != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_stored_block != 0, return EINVAL)
 
+    size_t block_mem_size = Longtail_GetStoredBlockSize(size);
+    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("ReadStoredBlockFromBuffer", block_mem_size);
+    if (!stored_block)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    void* block_data = &((uint8_t*)stored_block)[block_mem_size - size];
+    memcpy(block_data, buffer, size);
+    int err = Longtail_InitStoredBlockFromData(
+        stored_block,
+        block_data,
+        size);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "WriteBlockJob() failed with %d", err)
-        Longtail_Free(work_mem);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitStoredBlockFromData() failed with %d", err)
+        Longtail_Free(stored_block);
         return err;
     }
-
-    Longtail_Free(work_mem);
+    stored_block->Dispose = ReadStoredBlock_Dispose;
+    *out_stored_block = stored_block;
     return 0;
 }
 
-struct BlockReaderJob
-{
-    struct Longtail_AsyncGetStoredBlockAPI m_AsyncCompleteAPI;
-    struct Longtail_BlockStoreAPI* m_BlockStoreAPI;
-    struct Longtail_JobAPI* m_JobAPI;
-    uint32_t m_JobID;
-    TLongtail_Hash m_BlockHash;
-    struct Longtail_StoredBlock* m_StoredBlock;
-    int m_Err;
-};
-
-void BlockReaderJobOnComplete(struct Longtail_AsyncGetStoredBlockAPI* async_complete_api, struct Longtail_StoredBlock* stored_block, int err)
+int Longtail_WriteStoredBlock(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_StoredBlock* stored_block,
+    const char* path)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
         LONGTAIL_LOGFIELD(stored_block, "%p"),
-        LONGTAIL_LOGFIELD(err, "%d")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+        LONGTAIL_LOGFIELD(path, "%s")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, stored_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
+
+    Longtail_StorageAPI_HOpenFile block_file_handle;
+    int err = storage_api->OpenWriteFile(storage_api, path, 0, &block_file_handle);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BlockReaderJobOnComplete() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenWriteFile() failed with %d", err)
+        return err;
     }
-    LONGTAIL_FATAL_ASSERT(ctx, async_complete_api != 0, return)
-    struct BlockReaderJob* job = (struct BlockReaderJob*)async_complete_api;
-    LONGTAIL_FATAL_ASSERT(ctx, job->m_AsyncCompleteAPI.OnComplete != 0, return);
-    job->m_Err = err;
-    job->m_StoredBlock = stored_block;
-    job->m_JobAPI->ResumeJob(job->m_JobAPI, job->m_JobID);
+    uint32_t write_offset = 0;
+    uint32_t chunk_count = *stored_block->m_BlockIndex->m_ChunkCount;
+    uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(chunk_count);
+    err = storage_api->Write(storage_api, block_file_handle, write_offset, block_index_data_size, &stored_block->m_BlockIndex[1]);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
+        return err;
+    }
+    write_offset += block_index_data_size;
+
+    err = storage_api->Write(storage_api, block_file_handle, write_offset, stored_block->m_BlockChunksDataSize, stored_block->m_BlockData);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Write() failed with %d", err)
+        storage_api->CloseFile(storage_api, block_file_handle);
+        return err;
+    }
+    storage_api->CloseFile(storage_api, block_file_handle);
+    return 0;
 }
 
-static int BlockReader(void* context, uint32_t job_id, int is_cancelled)
+int Longtail_ReadStoredBlock(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    struct Longtail_StoredBlock** out_stored_block)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(context, "%p"),
-        LONGTAIL_LOGFIELD(job_id, "%u"),
-        LONGTAIL_LOGFIELD(is_cancelled, "%d")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(path, "%s"),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_stored_block != 0, return EINVAL)
 
-    struct BlockReaderJob* job = (struct BlockReaderJob*)context;
-
-    if (job->m_AsyncCompleteAPI.OnComplete)
+    Longtail_StorageAPI_HOpenFile f;
+    int err = storage_api->OpenReadFile(storage_api, path, &f);
+    if (err)
     {
-        // We got a notification so we are complete
-        job->m_AsyncCompleteAPI.OnComplete = 0;
-        return 0;
+        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+        return err;
     }
-
-    if (is_cancelled)
+    uint64_t stored_block_data_size;
+    err = storage_api->GetSize(storage_api, f, &stored_block_data_size);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "BlockReader was cancelled, failed with %d", ECANCELED)
-        job->m_Err = ECANCELED;
-        return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->GetSize() failed with %d", err)
+        storage_api->CloseFile(storage_api, f);
+        return err;
     }
-
-    job->m_JobID = job_id;
-    job->m_StoredBlock = 0;
-    job->m_AsyncCompleteAPI.OnComplete = BlockReaderJobOnComplete;
-    
-    int err = job->m_BlockStoreAPI->GetStoredBlock(job->m_BlockStoreAPI, job->m_BlockHash, &job->m_AsyncCompleteAPI);
+    size_t block_mem_size = Longtail_GetStoredBlockSize(stored_block_data_size);
+    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("ReadStoredBlock", block_mem_size);
+    if (!stored_block)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        storage_api->CloseFile(storage_api, f);
+        return ENOMEM;
+    }
+    void* block_data = &((uint8_t*)stored_block)[block_mem_size - stored_block_data_size];
+    err = storage_api->Read(storage_api, f, 0, stored_block_data_size, block_data);
     if (err)
     {
-        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job->m_BlockStoreAPI->GetStoredBlock() failed with %d", err)
-        job->m_Err = err;
-        return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
+        Longtail_Free(stored_block);
+        storage_api->CloseFile(storage_api, f);
+        return err;
     }
-    return EBUSY;
-}
-
-static int WriteReady(void* context, uint32_t job_id, int is_cancelled)
-{
-    // Nothing to do here, we are just a syncronization point
+    storage_api->CloseFile(storage_api, f);
+    err = Longtail_InitStoredBlockFromData(
+        stored_block,
+        block_data,
+        stored_block_data_size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_InitStoredBlockFromData() failed with %d", err)
+        Longtail_Free(stored_block);
+        return err;
+    }
+    stored_block->Dispose = ReadStoredBlock_Dispose;
+    *out_stored_block = stored_block;
     return 0;
 }
 
-#define MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE  64u
-
-struct WritePartialAssetFromBlocksJob
+static uint32_t GetUniqueHashes(
+    uint32_t hash_count,
+    const TLongtail_Hash* hashes,
+    uint32_t* out_unique_hash_indexes)
 {
-    struct Longtail_StorageAPI* m_VersionStorageAPI;
-    struct Longtail_BlockStoreAPI* m_BlockStoreAPI;
-    struct Longtail_JobAPI* m_JobAPI;
-    const struct Longtail_StoreIndex* m_StoreIndex;
-    const struct Longtail_VersionIndex* m_VersionIndex;
-    const char* m_VersionFolder;
-    struct Longtail_LookupTable* m_ChunkHashToBlockIndex;
-    uint32_t m_AssetIndex;
-    int m_RetainPermissions;
-
-    Longtail_JobAPI_Group m_JobGroup;
-    struct BlockReaderJob m_BlockReaderJobs[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
-    uint32_t m_BlockReaderJobCount;
-
-    uint32_t m_AssetChunkIndexOffset;
-    uint32_t m_AssetChunkCount;
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_count, "%u"),
+        LONGTAIL_LOGFIELD(hashes, "%p"),
+        LONGTAIL_LOGFIELD(out_unique_hash_indexes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    Longtail_StorageAPI_HOpenFile m_AssetOutputFile;
+    LONGTAIL_FATAL_ASSERT(ctx, hash_count != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, hashes != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, hash_count == 0 || out_unique_hash_indexes != 0, return 0)
 
-    int m_Err;
-};
+    struct Longtail_LookupTable* lookup_table = Longtail_LookupTable_Create(Longtail_Alloc("GetUniqueHashes", Longtail_LookupTable_GetSize(hash_count)), hash_count, 0);
+    if (!lookup_table)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
 
-int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled);
+    uint32_t unique_hash_count = 0;
+    for (uint32_t i = 0; i < hash_count; ++i)
+    {
+        TLongtail_Hash hash = hashes[i];
+        uint32_t* lookup_index = Longtail_LookupTable_PutUnique(lookup_table, hash, unique_hash_count);
+        if (lookup_index == 0)
+        {
+            out_unique_hash_indexes[unique_hash_count++] = i;
+        }
+        else
+        {
+            // Take the last chunk hash we find
+            out_unique_hash_indexes[*lookup_index] = i;
+        }
+    }
+    Longtail_Free(lookup_table);
+    lookup_table = 0;
+    return unique_hash_count;
+}
 
-// Returns the write sync task, or the write task if there is no need for reading new blocks
-static int CreatePartialAssetWriteJob(
-    struct Longtail_BlockStoreAPI* block_store_api,
-    struct Longtail_StorageAPI* version_storage_api,
-    struct Longtail_JobAPI* job_api,
-    const struct Longtail_StoreIndex* store_index,
+int Longtail_GetRequiredChunkHashes(
     const struct Longtail_VersionIndex* version_index,
-    const char* version_folder,
-    struct Longtail_LookupTable* chunk_hash_to_block_index,
-    uint32_t asset_index,
-    int retain_permissions,
-    Longtail_JobAPI_Group job_group,
-    struct WritePartialAssetFromBlocksJob* job,
-    uint32_t asset_chunk_index_offset,
-    Longtail_StorageAPI_HOpenFile asset_output_file,
-    Longtail_JobAPI_Jobs* out_jobs)
+    const struct Longtail_VersionDiff* version_diff,
+    uint32_t* out_chunk_count,
+    TLongtail_Hash* out_chunk_hashes)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(block_store_api, "%p"),
-        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
-        LONGTAIL_LOGFIELD(job_api, "%p"),
-        LONGTAIL_LOGFIELD(store_index, "%p"),
         LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(version_folder, "%s"),
-        LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
-        LONGTAIL_LOGFIELD(asset_index, "%u"),
-        LONGTAIL_LOGFIELD(retain_permissions, "%d"),
-        LONGTAIL_LOGFIELD(job_group, "%p"),
-        LONGTAIL_LOGFIELD(job, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_index_offset, "%u"),
-        LONGTAIL_LOGFIELD(asset_output_file, "%p"),
-        LONGTAIL_LOGFIELD(out_jobs, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-
-    LONGTAIL_FATAL_ASSERT(ctx, block_store_api !=0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, version_storage_api !=0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, job_api !=0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, store_index !=0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, version_index !=0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, version_folder !=0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, chunk_hash_to_block_index !=0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, asset_index < *version_index->m_AssetCount, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, job !=0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, out_jobs !=0, return EINVAL)
+        LONGTAIL_LOGFIELD(version_diff, "%p"),
+        LONGTAIL_LOGFIELD(out_chunk_count, "%p"),
+        LONGTAIL_LOGFIELD(out_chunk_hashes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
 
-    job->m_VersionStorageAPI = version_storage_api;
-    job->m_BlockStoreAPI = block_store_api;
-    job->m_JobAPI = job_api;
-    job->m_StoreIndex = store_index;
-    job->m_VersionIndex = version_index;
-    job->m_VersionFolder = version_folder;
-    job->m_ChunkHashToBlockIndex = chunk_hash_to_block_index;
-    job->m_AssetIndex = asset_index;
-    job->m_JobGroup = job_group;
-    job->m_RetainPermissions = retain_permissions;
-    job->m_BlockReaderJobCount = 0;
-    job->m_AssetChunkIndexOffset = asset_chunk_index_offset;
-    job->m_AssetChunkCount = 0;
-    job->m_AssetOutputFile = asset_output_file;
-    job->m_Err = EINVAL;
+    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_diff != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_chunk_count != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (*version_index->m_ChunkCount == 0) ||  out_chunk_hashes != 0, return EINVAL)
 
-    uint32_t chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
-    uint32_t chunk_start_index_offset = chunk_index_start + asset_chunk_index_offset;
-    uint32_t chunk_index_end = chunk_index_start + version_index->m_AssetChunkCounts[asset_index];
-    uint32_t chunk_index_offset = chunk_start_index_offset;
+    uint32_t max_chunk_count = *version_index->m_ChunkCount;
+    void* work_mem = Longtail_Alloc("GetRequiredChunkHashes", Longtail_LookupTable_GetSize(max_chunk_count));
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
 
-    Longtail_JobAPI_JobFunc block_read_funcs[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
-    void* block_read_ctx[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+    struct Longtail_LookupTable* chunk_lookup = Longtail_LookupTable_Create(work_mem, max_chunk_count, 0);
 
-    const uint32_t worker_count = job_api->GetWorkerCount(job_api) + 1;
-    const uint32_t max_parallell_block_read_jobs = worker_count < MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE ? worker_count : MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE;
+    uint32_t chunk_count = 0;
 
-    while (chunk_index_offset != chunk_index_end && job->m_BlockReaderJobCount <= max_parallell_block_read_jobs)
+    uint32_t added_asset_count = *version_diff->m_TargetAddedCount;
+    for (uint32_t a = 0; a < added_asset_count; ++a)
     {
-        uint32_t chunk_index = version_index->m_AssetChunkIndexes[chunk_index_offset];
-        TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
-        const uint32_t* block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
-        LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
-        uint32_t block_index = *block_index_ptr;
-        TLongtail_Hash block_hash = store_index->m_BlockHashes[block_index];
-        int has_block = 0;
-        for (uint32_t d = 0; d < job->m_BlockReaderJobCount; ++d)
+        uint32_t asset_index = version_diff->m_TargetAddedAssetIndexes[a];
+        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
+        uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
+        for (uint32_t ci = 0; ci < asset_chunk_count; ++ci)
         {
-            if (job->m_BlockReaderJobs[d].m_BlockHash == block_hash)
+            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + ci];
+            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+            if (0 == Longtail_LookupTable_PutUnique(chunk_lookup, chunk_hash, chunk_count))
             {
-                has_block = 1;
-                break;
+                out_chunk_hashes[chunk_count] = chunk_hash;
+                ++chunk_count;
             }
         }
-        if (!has_block)
+    }
+    uint32_t modified_asset_count = *version_diff->m_ModifiedContentCount;
+    for (uint32_t a = 0; a < modified_asset_count; ++a)
+    {
+        uint32_t asset_index = version_diff->m_TargetContentModifiedAssetIndexes[a];
+        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
+        uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
+        for (uint32_t ci = 0; ci < asset_chunk_count; ++ci)
         {
-            if (job->m_BlockReaderJobCount == max_parallell_block_read_jobs)
+            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + ci];
+            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+            if (0 == Longtail_LookupTable_PutUnique(chunk_lookup, chunk_hash, chunk_count))
             {
-                break;
+                out_chunk_hashes[chunk_count] = chunk_hash;
+                ++chunk_count;
             }
-            struct BlockReaderJob* block_job = &job->m_BlockReaderJobs[job->m_BlockReaderJobCount];
-            block_job->m_BlockStoreAPI = block_store_api;
-            block_job->m_BlockHash = block_hash;
-            block_job->m_AsyncCompleteAPI.m_API.Dispose = 0;
-            block_job->m_AsyncCompleteAPI.OnComplete = 0;
-            block_job->m_JobAPI = job_api;
-            block_job->m_JobID = 0;
-            block_job->m_Err = EINVAL;
-            block_job->m_StoredBlock = 0;
-            block_read_funcs[job->m_BlockReaderJobCount] = BlockReader;
-            block_read_ctx[job->m_BlockReaderJobCount] = block_job;
-            ++job->m_BlockReaderJobCount;
         }
-        ++job->m_AssetChunkCount;
-        ++chunk_index_offset;
-    }
-
-    Longtail_JobAPI_JobFunc write_funcs[1] = { WritePartialAssetFromBlocks };
-    void* write_ctx[1] = { job };
-    Longtail_JobAPI_Jobs write_job;
-    int err = job_api->CreateJobs(job_api, job_group, 1, write_funcs, write_ctx, &write_job);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->CreateJobs() failed with %d", err)
-        return err;
     }
 
-    if (job->m_BlockReaderJobCount > 0)
-    {
-        Longtail_JobAPI_Jobs block_read_jobs;
-        err = job_api->CreateJobs(job_api, job_group, job->m_BlockReaderJobCount, block_read_funcs, block_read_ctx, &block_read_jobs);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
-        Longtail_JobAPI_JobFunc sync_write_funcs[1] = { WriteReady };
-        void* sync_write_ctx[1] = { 0 };
-        Longtail_JobAPI_Jobs write_sync_job;
-        err = job_api->CreateJobs(job_api, job_group, 1, sync_write_funcs, sync_write_ctx, &write_sync_job);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
-
-        err = job_api->AddDependecies(job_api, 1, write_job, 1, write_sync_job);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
-        err = job_api->AddDependecies(job_api, 1, write_job, job->m_BlockReaderJobCount, block_read_jobs);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
-        err = job_api->ReadyJobs(job_api, job->m_BlockReaderJobCount, block_read_jobs);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+    Longtail_Free(work_mem);
+    *out_chunk_count = chunk_count;
 
-        *out_jobs = write_sync_job;
-        return 0;
-    }
-    *out_jobs = write_job;
     return 0;
 }
 
-int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled)
+struct ChunkAssetPartReference
+{
+    const char* m_AssetPath;
+    uint32_t m_ChunkIndex;
+    uint64_t m_AssetOffset;
+    uint32_t m_Tag;
+};
+
+struct AssetPartLookup
+{
+    struct ChunkAssetPartReference* m_ChunkAssetPartReferences;
+    struct Longtail_LookupTable* m_ChunkHashToIndex;
+};
+
+static int CreateAssetPartLookup(
+    struct Longtail_VersionIndex* version_index,
+    struct AssetPartLookup** out_assert_part_lookup)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(context, "%p"),
-        LONGTAIL_LOGFIELD(job_id, "%u"),
-        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(out_assert_part_lookup, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    LONGTAIL_FATAL_ASSERT(ctx, context !=0, return EINVAL)
-    struct WritePartialAssetFromBlocksJob* job = (struct WritePartialAssetFromBlocksJob*)context;
+    LONGTAIL_FATAL_ASSERT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, out_assert_part_lookup != 0, return EINVAL)
 
-    uint32_t block_reader_job_count = job->m_BlockReaderJobCount;
+    uint32_t asset_chunk_index_count = *version_index->m_AssetChunkIndexCount;
+    size_t asset_part_lookup_size =
+        sizeof(struct AssetPartLookup) +
+        Longtail_LookupTable_GetSize(asset_chunk_index_count) +
+        sizeof(struct ChunkAssetPartReference) * asset_chunk_index_count;
+    struct AssetPartLookup* asset_part_lookup = (struct AssetPartLookup*)Longtail_Alloc("CreateAssetPartLookup", asset_part_lookup_size);
+    if (!asset_part_lookup_size)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    asset_part_lookup->m_ChunkAssetPartReferences = (struct ChunkAssetPartReference*)&asset_part_lookup[1];
+    asset_part_lookup->m_ChunkHashToIndex = Longtail_LookupTable_Create(&asset_part_lookup->m_ChunkAssetPartReferences[asset_chunk_index_count], asset_chunk_index_count, 0);
 
-    if ((!job->m_AssetOutputFile) && job->m_AssetChunkIndexOffset)
+    uint32_t unique_chunk_count = 0;
+    uint32_t asset_count = *version_index->m_AssetCount;
+    for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
     {
-        LONGTAIL_FATAL_ASSERT(ctx, job->m_Err != 0, return 0);
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "WritePartialAssetFromBlocks(%p, %u, %d) failed due to previous error",
-            context, job_id, is_cancelled)
-        for (uint32_t d = 0; d < block_reader_job_count; ++d)
+        const char* path = &version_index->m_NameData[version_index->m_NameOffsets[asset_index]];
+        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
+        uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
+        uint64_t asset_chunk_offset = 0;
+        for (uint32_t asset_chunk_index = 0; asset_chunk_index < asset_chunk_count; ++asset_chunk_index)
         {
-            struct Longtail_StoredBlock* stored_block = job->m_BlockReaderJobs[d].m_StoredBlock;
-            if (stored_block && stored_block->Dispose)
+            LONGTAIL_FATAL_ASSERT(ctx, asset_chunk_index_start + asset_chunk_index < *version_index->m_AssetChunkIndexCount, return EINVAL)
+            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + asset_chunk_index];
+            LONGTAIL_FATAL_ASSERT(ctx, chunk_index < *version_index->m_ChunkCount, return EINVAL)
+            uint32_t chunk_size = version_index->m_ChunkSizes[chunk_index];
+            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+            uint32_t tag = version_index->m_ChunkTags[chunk_index];
+            if (0 == Longtail_LookupTable_PutUnique(asset_part_lookup->m_ChunkHashToIndex, chunk_hash, unique_chunk_count))
             {
-                stored_block->Dispose(stored_block);
+                struct ChunkAssetPartReference chunk_asset_part_reference =
+                {
+                    path,
+                    unique_chunk_count,
+                    asset_chunk_offset,
+                    tag
+                };
+                asset_part_lookup->m_ChunkAssetPartReferences[unique_chunk_count++] = chunk_asset_part_reference;
             }
-            job->m_BlockReaderJobs[d].m_StoredBlock = 0;
+            asset_chunk_offset += chunk_size;
         }
-        return 0;
     }
+    *out_assert_part_lookup = asset_part_lookup;
+    return 0;
+}
 
-    if (is_cancelled)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "WritePartialAssetFromBlocks was cancelled, failed with %d", ECANCELED)
+struct WriteBlockJob
+{
+    struct Longtail_AsyncPutStoredBlockAPI m_AsyncCompleteAPI;
+    struct Longtail_StorageAPI* m_SourceStorageAPI;
+    struct Longtail_BlockStoreAPI* m_BlockStoreAPI;
+    struct Longtail_JobAPI* m_JobAPI;
+    uint32_t m_JobID;
+    struct Longtail_StoredBlock* m_StoredBlock;
+    const char* m_AssetsFolder;
+    const struct Longtail_StoreIndex* m_StoreIndex;
+    struct AssetPartLookup* m_AssetPartLookup;
+    uint32_t m_BlockIndex;
+    int m_Err;
+};
 
-        for (uint32_t d = 0; d < block_reader_job_count; ++d)
-        {
-            struct Longtail_StoredBlock* stored_block = job->m_BlockReaderJobs[d].m_StoredBlock;
-            if (stored_block && stored_block->Dispose)
-            {
-                stored_block->Dispose(stored_block);
-            }
-            job->m_BlockReaderJobs[d].m_StoredBlock = 0;
-        }
-        if (job->m_AssetOutputFile)
-        {
-            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-            job->m_AssetOutputFile = 0;
-        }
-        job->m_Err = ECANCELED;
-        return 0;
+static void BlockWriterJobOnComplete(struct Longtail_AsyncPutStoredBlockAPI* async_complete_api, int err)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
+        LONGTAIL_LOGFIELD(err, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BlockWriterJobOnComplete() caller failed with %d", err)
     }
+    LONGTAIL_FATAL_ASSERT(ctx, async_complete_api != 0, return)
+    struct WriteBlockJob* job = (struct WriteBlockJob*)async_complete_api;
+    LONGTAIL_FATAL_ASSERT(ctx, job->m_AsyncCompleteAPI.OnComplete != 0, return);
+    LONGTAIL_FATAL_ASSERT(ctx, job->m_StoredBlock != 0, return);
+    LONGTAIL_FATAL_ASSERT(ctx, job->m_JobID != 0, return);
+    uint32_t job_id = job->m_JobID;
+    job->m_StoredBlock->Dispose(job->m_StoredBlock);
+    job->m_StoredBlock = 0;
+    job->m_JobID = 0;
+    job->m_Err = err;
+    job->m_JobAPI->ResumeJob(job->m_JobAPI, job_id);
+}
 
-    // Need to fetch all the data we need from the context since we will reuse the context
-    int block_reader_errors = 0;
-    TLongtail_Hash block_hashes[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
-    struct Longtail_StoredBlock* stored_block[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
-    for (uint32_t d = 0; d < block_reader_job_count; ++d)
+static int DisposePutBlock(struct Longtail_StoredBlock* stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    Longtail_Free(stored_block);
+    return 0;
+}
+
+// A chunk of a block written by WriteContentBlockJob and where it is found in the source assets
+struct BlockChunkRead
+{
+    const char* m_AssetPath;
+    uint64_t m_AssetOffset;
+    uint32_t m_Size;
+    uint32_t m_BlockOffset;
+};
+
+// Chunks of the same asset that are at most this far apart are fetched with one read, as long as the read
+// does not grow beyond a small multiple of the block data size
+#define BLOCK_CHUNK_READ_MAX_GAP (64u * 1024u)
+#define BLOCK_CHUNK_READ_MAX_SPAN_FACTOR 2u
+
+static int CompareBlockChunkRead(const void* a_ptr, const void* b_ptr)
+{
+    const struct BlockChunkRead* a = (const struct BlockChunkRead*)a_ptr;
+    const struct BlockChunkRead* b = (const struct BlockChunkRead*)b_ptr;
+    if (a->m_AssetPath != b->m_AssetPath)
     {
-        if (job->m_BlockReaderJobs[d].m_Err)
-        {
-            block_reader_errors = block_reader_errors == 0 ? job->m_BlockReaderJobs[d].m_Err : block_reader_errors;
-            block_hashes[d] = 0;
-            stored_block[d] = 0;
-            continue;
-        }
-        block_hashes[d] = job->m_BlockReaderJobs[d].m_BlockHash;
-        stored_block[d] = job->m_BlockReaderJobs[d].m_StoredBlock;
+        return (uintptr_t)a->m_AssetPath < (uintptr_t)b->m_AssetPath ? -1 : 1;
     }
+    if (a->m_AssetOffset != b->m_AssetOffset)
+    {
+        return a->m_AssetOffset < b->m_AssetOffset ? -1 : 1;
+    }
+    return 0;
+}
 
-    if (block_reader_errors)
+// Returns the number of reads, sorted with CompareBlockChunkRead, that are covered by one read starting at the
+// asset offset of the first read and at most max_span_size long unless the first read alone is larger. The span is
+// direct if it can be read straight into the block data, that is when the chunks follow each other without gaps
+// both in the asset and in the block
+static uint32_t GetBlockChunkReadSpan(const struct BlockChunkRead* reads, uint32_t read_count, uint64_t max_span_size, uint64_t* out_span_size, int* out_is_direct)
+{
+    uint64_t span_start = reads[0].m_AssetOffset;
+    uint64_t span_end = span_start + reads[0].m_Size;
+    int is_direct = 1;
+    uint32_t span_read_count = 1;
+    while (span_read_count < read_count)
     {
-        LONGTAIL_LOG(ctx, (block_reader_errors == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "BlockRead() failed with %d", block_reader_errors)
-        for (uint32_t d = 0; d < block_reader_job_count; ++d)
+        const struct BlockChunkRead* prev = &reads[span_read_count - 1];
+        const struct BlockChunkRead* next = &reads[span_read_count];
+        if (next->m_AssetPath != reads[0].m_AssetPath || next->m_AssetOffset > span_end + BLOCK_CHUNK_READ_MAX_GAP)
         {
-            if (stored_block[d] && stored_block[d]->Dispose)
-            {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
-            }
+            break;
         }
-
-        if (job->m_AssetOutputFile)
+        uint64_t next_end = next->m_AssetOffset + next->m_Size;
+        if (next_end - span_start > max_span_size)
         {
-            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-            job->m_AssetOutputFile = 0;
+            break;
         }
-        job->m_Err = block_reader_errors;
-        return 0;
+        if (next->m_AssetOffset != prev->m_AssetOffset + prev->m_Size || next->m_BlockOffset != prev->m_BlockOffset + prev->m_Size)
+        {
+            is_direct = 0;
+        }
+        span_end = next_end > span_end ? next_end : span_end;
+        ++span_read_count;
     }
+    *out_span_size = span_end - span_start;
+    *out_is_direct = is_direct;
+    return span_read_count;
+}
 
-    uint32_t write_chunk_index_offset = job->m_AssetChunkIndexOffset;
-    uint32_t write_chunk_count = job->m_AssetChunkCount;
-    uint32_t asset_chunk_count = job->m_VersionIndex->m_AssetChunkCounts[job->m_AssetIndex];
-    const char* asset_path = &job->m_VersionIndex->m_NameData[job->m_VersionIndex->m_NameOffsets[job->m_AssetIndex]];
+static int WriteContentBlockJob(void* context, uint32_t job_id, int is_cancelled)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    if (!job->m_AssetOutputFile)
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
+
+    struct WriteBlockJob* job = (struct WriteBlockJob*)context;
+    LONGTAIL_FATAL_ASSERT(ctx, job->m_JobID == 0, return EINVAL);
+
+    if (job->m_AsyncCompleteAPI.OnComplete)
     {
-        char* full_asset_path = job->m_VersionStorageAPI->ConcatPath(job->m_VersionStorageAPI, job->m_VersionFolder, asset_path);
-        int err = EnsureParentPathExists(job->m_VersionStorageAPI, full_asset_path);
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
-            Longtail_Free(full_asset_path);
-            for (uint32_t d = 0; d < block_reader_job_count; ++d)
-            {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
-            }
-            job->m_Err = err;
-            return 0;
-        }
-        if (IsDirPath(full_asset_path))
-        {
-            LONGTAIL_FATAL_ASSERT(ctx, block_reader_job_count == 0, job->m_Err = EINVAL; return 0)
-            // Remove trailing forward slash
-            full_asset_path[strlen(full_asset_path) - 1] = '\0';
-            err = SafeCreateDir(job->m_VersionStorageAPI, full_asset_path);
-            if (err)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SafeCreateDir() failed with %d", err)
-                Longtail_Free(full_asset_path);
-                job->m_Err = err;
-                return 0;
-            }
-            Longtail_Free(full_asset_path);
-            job->m_Err = 0;
-            return 0;
-        }
+        // We got a notification so we are complete
+        job->m_AsyncCompleteAPI.OnComplete = 0;
+        return 0;
+    }
 
-        uint16_t permissions;
-        err = job->m_VersionStorageAPI->GetPermissions(job->m_VersionStorageAPI, full_asset_path, &permissions);
-        if (err && (err != ENOENT))
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->GetPermissions() failed with %d", err)
-            Longtail_Free(full_asset_path);
-            for (uint32_t d = 0; d < block_reader_job_count; ++d)
-            {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
-            }
-            job->m_Err = err;
-            return 0;
-        }
+    if (is_cancelled)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "WriteContentBlock was cancelled, failed with %d", ECANCELED)
+        job->m_Err = ECANCELED;
+        return 0;
+    }
 
-        if (err != ENOENT)
-        {
-            if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
-            {
-                err = job->m_VersionStorageAPI->SetPermissions(job->m_VersionStorageAPI, full_asset_path, permissions | (Longtail_StorageAPI_UserWriteAccess));
-                if (err)
-                {
-                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->SetPermissions() failed with %d", err)
-                    Longtail_Free(full_asset_path);
-                    for (uint32_t d = 0; d < block_reader_job_count; ++d)
-                    {
-                        stored_block[d]->Dispose(stored_block[d]);
-                        stored_block[d] = 0;
-                    }
-                    job->m_Err = err;
-                    return 0;
-                }
-            }
-        }
+    struct Longtail_StorageAPI* source_storage_api = job->m_SourceStorageAPI;
+    struct Longtail_BlockStoreAPI* block_store_api = job->m_BlockStoreAPI;
 
-        uint64_t asset_size = job->m_VersionIndex->m_AssetSizes[job->m_AssetIndex];
-        err = job->m_VersionStorageAPI->OpenWriteFile(job->m_VersionStorageAPI, full_asset_path, asset_size, &job->m_AssetOutputFile);
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->OpenWriteFile() failed with %d", err)
-            Longtail_Free(full_asset_path);
-            for (uint32_t d = 0; d < block_reader_job_count; ++d)
-            {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
-            }
-            job->m_Err = err;
-            return 0;
-        }
-        Longtail_Free(full_asset_path);
-        full_asset_path = 0;
-    }
+    const struct Longtail_StoreIndex* store_index = job->m_StoreIndex;
 
-    Longtail_JobAPI_Jobs sync_write_job = 0;
-    if (write_chunk_index_offset + write_chunk_count < asset_chunk_count)
-    {
-        int err = CreatePartialAssetWriteJob(
-            job->m_BlockStoreAPI,
-            job->m_VersionStorageAPI,
-            job->m_JobAPI,
-            job->m_StoreIndex,
-            job->m_VersionIndex,
-            job->m_VersionFolder,
-            job->m_ChunkHashToBlockIndex,
-            job->m_AssetIndex,
-            job->m_RetainPermissions,
-            job->m_JobGroup,
-            job,    // Reuse job
-            write_chunk_index_offset + write_chunk_count,
-            job->m_AssetOutputFile,
-            &sync_write_job);
+    TLongtail_Hash block_hash = store_index->m_BlockHashes[job->m_BlockIndex];
 
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreatePartialAssetWriteJob() failed with %d", err)
-            for (uint32_t d = 0; d < block_reader_job_count; ++d)
-            {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
-            }
-            job->m_Err = err;
-            return 0;
-        }
-        // Reading of blocks will start immediately
+    uint32_t chunk_count = store_index->m_BlockChunkCounts[job->m_BlockIndex];
+    uint32_t first_chunk_index = store_index->m_BlockChunksOffsets[job->m_BlockIndex];
+
+    uint32_t block_data_size = 0;
+    for (uint32_t chunk_index = first_chunk_index; chunk_index < first_chunk_index + chunk_count; ++chunk_index)
+    {
+        uint32_t chunk_size = store_index->m_ChunkSizes[chunk_index];
+        block_data_size += chunk_size;
     }
 
-    uint32_t chunk_index_offset = write_chunk_index_offset;
-    uint32_t chunk_index_start = job->m_VersionIndex->m_AssetChunkIndexStarts[job->m_AssetIndex];
+    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
+    size_t stored_block_size = sizeof(struct Longtail_StoredBlock);
+    size_t put_block_mem_size =
+        stored_block_size +
+        block_index_size +
+        block_data_size;
 
-    uint64_t write_offset = 0;
-    for (uint32_t c = 0; c < chunk_index_offset; ++c)
+    void* put_block_mem = Longtail_Alloc("WriteContentBlockJob", put_block_mem_size);
+    if (!put_block_mem)
     {
-        uint32_t chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[chunk_index_start + c];
-        uint32_t chunk_size = job->m_VersionIndex->m_ChunkSizes[chunk_index];
-        write_offset += chunk_size;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM);
+        job->m_Err = ENOMEM;
+        return 0;
     }
 
-    uint32_t block_chunks_count = 0;
-    for(uint32_t b = 0; b < block_reader_job_count; ++b)
+    char* p = (char*)put_block_mem;
+    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)p;
+    p += stored_block_size;
+    struct Longtail_BlockIndex* block_index_ptr = (struct Longtail_BlockIndex*)p;
+    p += block_index_size;
+    char* block_data_buffer = p;
+
+    struct BlockChunkRead* chunk_reads = (struct BlockChunkRead*)Longtail_Alloc("WriteContentBlockJob", sizeof(struct BlockChunkRead) * chunk_count);
+    if (!chunk_reads)
     {
-        struct Longtail_BlockIndex* block_index = stored_block[b]->m_BlockIndex;
-        block_chunks_count += *block_index->m_ChunkCount;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM);
+        Longtail_Free(put_block_mem);
+        job->m_Err = ENOMEM;
+        return 0;
     }
 
-    size_t block_chunks_lookup_size = Longtail_LookupTable_GetSize(block_chunks_count);
-    size_t chunk_sizes_size = sizeof(uint32_t) * block_chunks_count;
-    size_t chunk_offsets_size = sizeof(uint32_t) * block_chunks_count;
-    size_t block_indexes_size = sizeof(uint32_t) * block_chunks_count;
-    size_t buffer_size = 512*1024;
+    const char* asset_path = 0;
+    uint32_t tag = 0;
+    uint32_t block_offset = 0;
 
-    size_t work_mem_size =
-        block_chunks_lookup_size +
-        chunk_sizes_size +
-        chunk_offsets_size +
-        block_indexes_size +
-        buffer_size;
-    void* work_mem = Longtail_Alloc("WritePartialAssetFromBlocks", work_mem_size);
-    if (!work_mem)
+    for (uint32_t chunk_index = first_chunk_index; chunk_index < first_chunk_index + chunk_count; ++chunk_index)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        for (uint32_t d = 0; d < block_reader_job_count; ++d)
+        TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_index];
+        uint32_t chunk_size = store_index->m_ChunkSizes[chunk_index];
+        uint32_t* asset_part_index = Longtail_LookupTable_Get(job->m_AssetPartLookup->m_ChunkHashToIndex, chunk_hash);
+        LONGTAIL_FATAL_ASSERT(ctx, asset_part_index != 0, Longtail_Free(chunk_reads); Longtail_Free(put_block_mem); job->m_Err = EINVAL; return 0)
+        const struct ChunkAssetPartReference* next_asset_part = &job->m_AssetPartLookup->m_ChunkAssetPartReferences[*asset_part_index];
+
+        if (asset_path && tag != next_asset_part->m_Tag)
         {
-            stored_block[d]->Dispose(stored_block[d]);
-            stored_block[d] = 0;
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "WriteContentBlockJob(%p, %u, %d): Warning: Inconsistent tag type for chunks inside block 0x%" PRIx64 ", retaining 0x%" PRIx64 "",
+                context, job_id, is_cancelled,
+                block_hash, tag)
         }
-        job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-        job->m_AssetOutputFile = 0;
-        if (sync_write_job)
+        else
         {
-            int err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-            LONGTAIL_FATAL_ASSERT(ctx, err == 0, job->m_Err = EINVAL; return 0)
+            tag = next_asset_part->m_Tag;
         }
-        job->m_Err = ENOMEM;
-        return 0;
+        asset_path = next_asset_part->m_AssetPath;
+        LONGTAIL_FATAL_ASSERT(ctx, !IsDirPath(asset_path), Longtail_Free(chunk_reads); Longtail_Free(put_block_mem); job->m_Err = EINVAL; return 0)
+
+        struct BlockChunkRead* chunk_read = &chunk_reads[chunk_index - first_chunk_index];
+        chunk_read->m_AssetPath = asset_path;
+        chunk_read->m_AssetOffset = next_asset_part->m_AssetOffset;
+        chunk_read->m_Size = chunk_size;
+        chunk_read->m_BlockOffset = block_offset;
+        block_offset += chunk_size;
     }
-    char* p = (char*)work_mem;
-    struct Longtail_LookupTable* block_chunks_lookup = Longtail_LookupTable_Create(p, block_chunks_count, 0);
-    p += block_chunks_lookup_size;
-    uint32_t* chunk_sizes = (uint32_t*)p;
-    p += chunk_sizes_size;
-    uint32_t* chunk_offsets = (uint32_t*)p;
-    p += chunk_offsets_size;
-    uint32_t* block_indexes = (uint32_t*)p;
-    p += block_indexes_size;
-    char* buffer = p;
 
-    uint32_t block_chunk_index_offset = 0;
-    for(uint32_t b = 0; b < block_reader_job_count; ++b)
+    // Read the chunks file by file in asset offset order so chunks that are close to each other in a file are
+    // fetched with one read and each file is opened once
+    qsort(chunk_reads, chunk_count, sizeof(struct BlockChunkRead), CompareBlockChunkRead);
+
+    uint64_t max_span_size = (uint64_t)block_data_size * BLOCK_CHUNK_READ_MAX_SPAN_FACTOR;
+    uint64_t scratch_size = 0;
+    for (uint32_t r = 0; r < chunk_count;)
     {
-        uint32_t chunk_offset = 0;
-        struct Longtail_BlockIndex* block_index = stored_block[b]->m_BlockIndex;
-        for (uint32_t c = 0; c < *block_index->m_ChunkCount; ++c)
+        uint64_t span_size;
+        int is_direct;
+        uint32_t span_read_count = GetBlockChunkReadSpan(&chunk_reads[r], chunk_count - r, max_span_size, &span_size, &is_direct);
+        if (!is_direct && span_size > scratch_size)
         {
-            TLongtail_Hash chunk_hash = block_index->m_ChunkHashes[c];
-            uint32_t chunk_size = block_index->m_ChunkSizes[c];
-            chunk_sizes[block_chunk_index_offset] = chunk_size;
-            chunk_offsets[block_chunk_index_offset] = chunk_offset;
-            block_indexes[block_chunk_index_offset] = b;
-            chunk_offset += chunk_size;
-
-            Longtail_LookupTable_Put(block_chunks_lookup, chunk_hash, block_chunk_index_offset);
-
-            block_chunk_index_offset++;
+            scratch_size = span_size;
+        }
+        r += span_read_count;
+    }
+    char* scratch_buffer = 0;
+    if (scratch_size > 0)
+    {
+        scratch_buffer = (char*)Longtail_Alloc("WriteContentBlockJob", (size_t)scratch_size);
+        if (!scratch_buffer)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM);
+            Longtail_Free(chunk_reads);
+            Longtail_Free(put_block_mem);
+            job->m_Err = ENOMEM;
+            return 0;
         }
     }
 
-    size_t buffer_used_size = 0;
-    uint32_t chunk_index_end = write_chunk_index_offset + write_chunk_count;
+    Longtail_StorageAPI_HOpenFile file_handle = 0;
+    uint64_t asset_file_size = 0;
+    asset_path = 0;
 
-    while (chunk_index_offset < chunk_index_end)
+    int err = 0;
+    for (uint32_t r = 0; r < chunk_count && !err;)
     {
-        uint32_t asset_chunk_index = chunk_index_start + chunk_index_offset;
-        uint32_t chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[asset_chunk_index];
-        TLongtail_Hash chunk_hash = job->m_VersionIndex->m_ChunkHashes[chunk_index];
+        const struct BlockChunkRead* span_reads = &chunk_reads[r];
+        uint64_t span_size;
+        int is_direct;
+        uint32_t span_read_count = GetBlockChunkReadSpan(span_reads, chunk_count - r, max_span_size, &span_size, &is_direct);
+        r += span_read_count;
 
-        uint32_t* chunk_block_index = Longtail_LookupTable_Get(block_chunks_lookup, chunk_hash);
-        if (chunk_block_index == 0)
+        if (span_reads[0].m_AssetPath != asset_path)
         {
-            for (uint32_t d = 0; d < block_reader_job_count; ++d)
+            if (file_handle)
             {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
+                source_storage_api->CloseFile(source_storage_api, file_handle);
+                file_handle = 0;
             }
-            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-            job->m_AssetOutputFile = 0;
-            if (sync_write_job)
-            {
-                int err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-                LONGTAIL_FATAL_ASSERT(ctx, err == 0, job->m_Err = EINVAL; return 0)
-            }
-            job->m_Err = EINVAL;
-            Longtail_Free(work_mem);
-            return 0;
-        }
-
-        uint32_t block_index = block_indexes[*chunk_block_index];
-        uint32_t chunk_block_offset = chunk_offsets[*chunk_block_index];
-        uint32_t chunk_size = chunk_sizes[*chunk_block_index];
-        const char* block_data = (char*)stored_block[block_index]->m_BlockData;
-
-        while(chunk_index_offset < (chunk_index_end - 1))
-        {
-            uint32_t next_chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[asset_chunk_index + 1];
-            TLongtail_Hash next_chunk_hash = job->m_VersionIndex->m_ChunkHashes[next_chunk_index];
-
-            uint32_t* next_chunk_block_index = Longtail_LookupTable_Get(block_chunks_lookup, next_chunk_hash);
-            if (next_chunk_block_index == 0)
-            {
-                for (uint32_t d = 0; d < block_reader_job_count; ++d)
-                {
-                    stored_block[d]->Dispose(stored_block[d]);
-                    stored_block[d] = 0;
-                }
-                job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-                job->m_AssetOutputFile = 0;
-                if (sync_write_job)
-                {
-                    int err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-                    LONGTAIL_FATAL_ASSERT(ctx, err == 0, job->m_Err = EINVAL; return 0)
-                }
-                job->m_Err = EINVAL;
-                Longtail_Free(work_mem);
-                return 0;
-            }
-            uint32_t next_block_index = block_indexes[*next_chunk_block_index];
-            if (next_block_index != block_index)
-            {
-                break;
-            }
-            uint32_t next_chunk_block_offset = chunk_offsets[*next_chunk_block_index];
-            if (next_chunk_block_offset != chunk_block_offset + chunk_size)
+            char* full_path = source_storage_api->ConcatPath(source_storage_api, job->m_AssetsFolder, span_reads[0].m_AssetPath);
+            err = source_storage_api->OpenReadFile(source_storage_api, full_path, &file_handle);
+            Longtail_Free(full_path);
+            full_path = 0;
+            if (err)
             {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "source_storage_api->OpenReadFile() failed with %d", err);
                 break;
             }
-            uint32_t next_chunk_size = chunk_sizes[*next_chunk_block_index];
-            chunk_size += next_chunk_size;
-            ++chunk_index_offset;
-        }
-
-        if (buffer_used_size + chunk_size <= buffer_size)
-        {
-            if (buffer_used_size > 0 || (chunk_index_offset < chunk_index_end - 1))
-            {
-                memcpy(&buffer[buffer_used_size], &block_data[chunk_block_offset], chunk_size);
-                buffer_used_size += chunk_size;
-                ++chunk_index_offset;
-                continue;
-            }
-        }
-
-        if (buffer_used_size > 0)
-        {
-            int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, buffer_used_size, buffer);
+            err = source_storage_api->GetSize(source_storage_api, file_handle, &asset_file_size);
             if (err)
             {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
-                job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-                job->m_AssetOutputFile = 0;
-
-                for (uint32_t d = 0; d < block_reader_job_count; ++d)
-                {
-                    stored_block[d]->Dispose(stored_block[d]);
-                    stored_block[d] = 0;
-                }
-                job->m_Err = err;
-                if (sync_write_job)
-                {
-                    int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-                    LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
-                }
-                Longtail_Free(work_mem);
-                return 0;
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "source_storage_api->GetSize() failed with %d", err);
+                break;
             }
-            write_offset += buffer_used_size;
-            buffer_used_size = 0;
+            asset_path = span_reads[0].m_AssetPath;
         }
 
-        if (buffer_used_size + chunk_size <= buffer_size)
+        uint64_t span_offset = span_reads[0].m_AssetOffset;
+        if (asset_file_size < (span_offset + span_size))
         {
-            if (buffer_used_size > 0 || (chunk_index_offset < chunk_index_end - 1))
-            {
-                memcpy(&buffer[buffer_used_size], &block_data[chunk_block_offset], chunk_size);
-                buffer_used_size += chunk_size;
-                ++chunk_index_offset;
-                continue;
-            }
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Source asset file does not match indexed size %" PRIu64 " < %" PRIu64,
+                asset_file_size, (span_offset + span_size))
+            err = EBADF;
+            break;
         }
-
-        int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, chunk_size, &block_data[chunk_block_offset]);
+        char* span_buffer = is_direct ? &block_data_buffer[span_reads[0].m_BlockOffset] : scratch_buffer;
+        err = source_storage_api->Read(source_storage_api, file_handle, span_offset, span_size, span_buffer);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
-            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-            job->m_AssetOutputFile = 0;
-
-            for (uint32_t d = 0; d < block_reader_job_count; ++d)
-            {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
-            }
-            job->m_Err = err;
-            if (sync_write_job)
-            {
-                int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-                LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
-            }
-            Longtail_Free(work_mem);
-            return 0;
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "source_storage_api->Read() failed with %d", err);
+            break;
         }
-        write_offset += chunk_size;
-
-        ++chunk_index_offset;
-    }
-
-    if (buffer_used_size > 0)
-    {
-        int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, buffer_used_size, buffer);
-        if (err)
+        if (!is_direct)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
-            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-            job->m_AssetOutputFile = 0;
-
-            for (uint32_t d = 0; d < block_reader_job_count; ++d)
-            {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
-            }
-            job->m_Err = err;
-            if (sync_write_job)
+            for (uint32_t s = 0; s < span_read_count; ++s)
             {
-                int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-                LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
+                memcpy(&block_data_buffer[span_reads[s].m_BlockOffset], &scratch_buffer[span_reads[s].m_AssetOffset - span_offset], span_reads[s].m_Size);
             }
-            Longtail_Free(work_mem);
-            return 0;
         }
-        write_offset += buffer_used_size;
-        buffer_used_size = 0;
     }
 
-    Longtail_Free(work_mem);
-
-    for (uint32_t d = 0; d < block_reader_job_count; ++d)
+    if (file_handle)
     {
-        stored_block[d]->Dispose(stored_block[d]);
-        stored_block[d] = 0;
+        source_storage_api->CloseFile(source_storage_api, file_handle);
+        file_handle = 0;
     }
-
-    if (sync_write_job)
+    Longtail_Free(scratch_buffer);
+    scratch_buffer = 0;
+    Longtail_Free(chunk_reads);
+    chunk_reads = 0;
+    if (err)
     {
-        // We can now release the next write job which will in turn close the job->m_AssetOutputFile
-        int err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-        if (err)
-        {
-            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-            job->m_Err = err;
-            return 0;
-        }
-        job->m_Err = 0;
+        Longtail_Free(put_block_mem);
+        job->m_Err = err;
         return 0;
     }
 
-    job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-    job->m_AssetOutputFile = 0;
+    Longtail_InitBlockIndex(block_index_ptr, chunk_count);
+    memmove(block_index_ptr->m_ChunkHashes, &store_index->m_ChunkHashes[first_chunk_index], sizeof(TLongtail_Hash) * chunk_count);
+    memmove(block_index_ptr->m_ChunkSizes, &store_index->m_ChunkSizes[first_chunk_index], sizeof(uint32_t) * chunk_count);
+    *block_index_ptr->m_BlockHash = block_hash;
+    *block_index_ptr->m_HashIdentifier = *store_index->m_HashIdentifier;
+    *block_index_ptr->m_Tag = tag;
+    *block_index_ptr->m_ChunkCount = chunk_count;
+    job->m_StoredBlock = stored_block;
+    job->m_StoredBlock->Dispose = DisposePutBlock;
+    job->m_StoredBlock->m_BlockIndex = block_index_ptr;
+    job->m_StoredBlock->m_BlockData = block_data_buffer;
+    job->m_StoredBlock->m_BlockChunksDataSize = block_data_size;
 
-    if (job->m_RetainPermissions)
+    job->m_JobID = job_id;
+    job->m_AsyncCompleteAPI.OnComplete = BlockWriterJobOnComplete;
+
+    err = block_store_api->PutStoredBlock(block_store_api, job->m_StoredBlock, &job->m_AsyncCompleteAPI);
+    if (err)
     {
-        char* full_asset_path = job->m_VersionStorageAPI->ConcatPath(job->m_VersionStorageAPI, job->m_VersionFolder, asset_path);
-        int err = job->m_VersionStorageAPI->SetPermissions(job->m_VersionStorageAPI, full_asset_path, (uint16_t)job->m_VersionIndex->m_Permissions[job->m_AssetIndex]);
-        Longtail_Free(full_asset_path);
-        full_asset_path = 0;
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->SetPermissions() failed with %d", err)
-            job->m_Err = err;
-            return 0;
-        }
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_store_api->PutStoredBlock() failed with %d", err);
+        job->m_StoredBlock->Dispose(job->m_StoredBlock);
+        job->m_StoredBlock = 0;
+        job->m_JobID = 0;
+        job->m_Err = err;
+        return 0;
     }
 
-    job->m_Err = 0;
-    return 0;
+    return EBUSY;
 }
 
-struct WriteAssetsFromBlockJob
-{
-    struct Longtail_StorageAPI* m_VersionStorageAPI;
-    const struct Longtail_VersionIndex* m_VersionIndex;
-    const char* m_VersionFolder;
-    struct BlockReaderJob m_BlockReadJob;
-    uint32_t m_BlockIndex;
-    uint32_t* m_AssetIndexes;
-    uint32_t m_AssetCount;
-    int m_RetainPermissions;
-    int m_Err;
-};
-
-static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled)
+int Longtail_WriteContent(
+    struct Longtail_StorageAPI* source_storage_api,
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    struct Longtail_StoreIndex* store_index,
+    struct Longtail_VersionIndex* version_index,
+    const char* assets_folder)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(context, "%p"),
-        LONGTAIL_LOGFIELD(job_id, "%u"),
-        LONGTAIL_LOGFIELD(is_cancelled, "%d")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-
-    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+        LONGTAIL_LOGFIELD(source_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(assets_folder, "%s")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
-    struct WriteAssetsFromBlockJob* job = (struct WriteAssetsFromBlockJob*)context;
-    struct Longtail_StorageAPI* version_storage_api = job->m_VersionStorageAPI;
-    const char* version_folder = job->m_VersionFolder;
-    const struct Longtail_VersionIndex* version_index = job->m_VersionIndex;
-    uint32_t* asset_indexes = job->m_AssetIndexes;
-    uint32_t asset_count = job->m_AssetCount;
+    LONGTAIL_VALIDATE_INPUT(ctx, source_storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, assets_folder != 0, return EINVAL)
 
-    if (job->m_BlockReadJob.m_Err)
+    uint32_t block_count = *store_index->m_BlockCount;
+    if (block_count == 0)
     {
-        LONGTAIL_LOG(ctx, (job->m_BlockReadJob.m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "BlockReadJob() failed with %d", job->m_BlockReadJob.m_Err)
-        job->m_Err = job->m_BlockReadJob.m_Err;
         return 0;
     }
 
-    if (is_cancelled)
+    uint32_t version_chunk_count = *version_index->m_ChunkCount;
+    uint32_t version_store_index_chunk_count = *store_index->m_ChunkCount;
+
+    size_t chunk_lookup_size = Longtail_LookupTable_GetSize(version_chunk_count);
+    size_t chunk_sizes_size = sizeof(uint32_t) * version_store_index_chunk_count;
+    size_t write_block_jobs_size = sizeof(struct WriteBlockJob) * block_count;
+    size_t funcs_size = sizeof(Longtail_JobAPI_JobFunc*) * block_count;
+    size_t ctxs_size = sizeof(void*) * block_count;
+
+    size_t work_mem_size =
+        chunk_lookup_size +
+        chunk_sizes_size +
+        write_block_jobs_size +
+        funcs_size +
+        ctxs_size;
+
+    void* work_mem = Longtail_Alloc("WriteContent", work_mem_size);
+    if (!work_mem)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "WriteAssetsFromBlock was cancelled, failed with %d", job->m_BlockReadJob.m_Err)
-       job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-       job->m_Err = ECANCELED;
-       return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
     }
 
-    const char* block_data = (char*)job->m_BlockReadJob.m_StoredBlock->m_BlockData;
-    struct Longtail_BlockIndex* block_index = job->m_BlockReadJob.m_StoredBlock->m_BlockIndex;
+    char* p = (char*)work_mem;
 
-    uint32_t block_chunks_count = *block_index->m_ChunkCount;
+    struct Longtail_LookupTable* chunk_lookup = Longtail_LookupTable_Create(p, version_chunk_count, 0);
+    p += chunk_lookup_size;
+    uint32_t* chunk_sizes = (uint32_t*)p;
+    p += chunk_sizes_size;
+    struct WriteBlockJob* write_block_jobs = (struct WriteBlockJob*)p;
+    p += write_block_jobs_size;
+    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)p;
+    p += funcs_size;
+    void** ctxs = (void**)p;
 
-    size_t chuck_offsets_size = sizeof(uint32_t) * block_chunks_count;
-    size_t block_chunks_lookup_size = Longtail_LookupTable_GetSize(block_chunks_count);
-    size_t tmp_mem_size =
-        chuck_offsets_size +
-        block_chunks_lookup_size;
+    for (uint32_t c = 0; c < version_chunk_count; ++c)
+    {
+        Longtail_LookupTable_Put(chunk_lookup, version_index->m_ChunkHashes[c], c);
+    }
 
-    char* tmp_mem = (char*)Longtail_Alloc("WriteAssetsFromBlock", tmp_mem_size);
-    if (!tmp_mem)
+    for (uint32_t c = 0; c < version_store_index_chunk_count; ++c)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-        job->m_BlockReadJob.m_StoredBlock = 0;
-        job->m_Err = ENOMEM;
+        uint32_t* version_chunk_index = Longtail_LookupTable_Get(chunk_lookup, store_index->m_ChunkHashes[c]);
+        if (version_chunk_index == 0)
+        {
+            Longtail_Free(work_mem);
+            return EINVAL;
+        }
+        chunk_sizes[c] = version_index->m_ChunkSizes[*version_chunk_index];
+    }
+
+    struct AssetPartLookup* asset_part_lookup;
+    int err = CreateAssetPartLookup(version_index, &asset_part_lookup);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateAssetPartLookup() failed with %d", err)
+        Longtail_Free(work_mem);
+        return err;
+    }
+
+    uint32_t job_count = 0;
+    for (uint32_t block_index = 0; block_index < block_count; ++block_index)
+    {
+        TLongtail_Hash block_hash = store_index->m_BlockHashes[block_index];
+
+        struct WriteBlockJob* job = &write_block_jobs[job_count];
+        job->m_AsyncCompleteAPI.m_API.Dispose = 0;
+        job->m_AsyncCompleteAPI.OnComplete = 0;
+        job->m_SourceStorageAPI = source_storage_api;
+        job->m_BlockStoreAPI = block_store_api;
+        job->m_JobAPI = job_api;
+        job->m_JobID = 0;
+        job->m_StoredBlock = 0;
+        job->m_AssetsFolder = assets_folder;
+        job->m_StoreIndex = store_index;
+        job->m_BlockIndex = block_index;
+        job->m_AssetPartLookup = asset_part_lookup;
+        job->m_Err = EINVAL;
+
+        funcs[job_count] = WriteContentBlockJob;
+        ctxs[job_count] = job;
+
+        ++job_count;
+    }
+
+    if (job_count == 0)
+    {
+        Longtail_Free(asset_part_lookup);
+        Longtail_Free(work_mem);
         return 0;
     }
-    struct Longtail_LookupTable* block_chunks_lookup = Longtail_LookupTable_Create(tmp_mem, block_chunks_count, 0);
-    uint32_t* chunk_offsets = (uint32_t*)(&tmp_mem[block_chunks_lookup_size]);
-    const uint32_t* chunk_sizes = block_index->m_ChunkSizes;
 
-    uint32_t block_chunk_index_offset = 0;
-    uint32_t chunk_offset = 0;
-    for (uint32_t c = 0; c < block_chunks_count; ++c)
+    Longtail_JobAPI_Group job_group = 0;
+    err = job_api->ReserveJobs(job_api, job_count, &job_group);
+    if (err)
     {
-        TLongtail_Hash chunk_hash = block_index->m_ChunkHashes[c];
-        uint32_t chunk_size = block_index->m_ChunkSizes[c];
-        chunk_offsets[block_chunk_index_offset] = chunk_offset;
-        chunk_offset += chunk_size;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+        Longtail_Free(asset_part_lookup);
+        Longtail_Free(work_mem);
+        return err;
+    }
 
-        Longtail_LookupTable_Put(block_chunks_lookup, chunk_hash, block_chunk_index_offset);
+    Longtail_JobAPI_Jobs jobs;
+    err = job_api->CreateJobs(job_api, job_group, job_count, funcs, ctxs, &jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+    err = job_api->ReadyJobs(job_api, job_count, jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
 
-        block_chunk_index_offset++;
+    err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        Longtail_Free(asset_part_lookup);
+        Longtail_Free(work_mem);
+        return err;
     }
 
-    for (uint32_t i = 0; i < asset_count; ++i)
+    err = 0;
+    while (job_count--)
     {
-        uint32_t asset_index = asset_indexes[i];
-        const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[asset_index]];
-        char* full_asset_path = version_storage_api->ConcatPath(version_storage_api, version_folder, asset_path);
-        int err = EnsureParentPathExists(version_storage_api, full_asset_path);
-        if (err)
+        struct WriteBlockJob* job = &write_block_jobs[job_count];
+        if (job->m_Err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
-            Longtail_Free(full_asset_path);
-            job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-            job->m_BlockReadJob.m_StoredBlock = 0;
-            job->m_Err = err;
-            Longtail_Free(tmp_mem);
-            return 0;
+            err = err ? err : job->m_Err;
         }
+    }
 
-        uint16_t permissions;
-        err = version_storage_api->GetPermissions(version_storage_api, full_asset_path, &permissions);
-        if (err && (err != ENOENT))
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetPermissions() failed with %d", err)
-            Longtail_Free(full_asset_path);
-            job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-            job->m_BlockReadJob.m_StoredBlock = 0;
-            job->m_Err = err;
-            Longtail_Free(tmp_mem);
-            return 0;
-        }
+    Longtail_Free(asset_part_lookup);
+    asset_part_lookup = 0;
 
-        if (err != ENOENT)
-        {
-            if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
-            {
-                err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, permissions | (Longtail_StorageAPI_UserWriteAccess));
-                if (err)
-                {
-                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
-                    Longtail_Free(full_asset_path);
-                    job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-                    job->m_BlockReadJob.m_StoredBlock = 0;
-                    job->m_Err = err;
-                    Longtail_Free(tmp_mem);
-                    return 0;
-                }
-            }
-        }
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "WriteBlockJob() failed with %d", err)
+        Longtail_Free(work_mem);
+        return err;
+    }
 
-        Longtail_StorageAPI_HOpenFile asset_file;
-        err = version_storage_api->OpenWriteFile(version_storage_api, full_asset_path, 0, &asset_file);
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->OpenWriteFile() failed with %d", err)
-            Longtail_Free(full_asset_path);
-            full_asset_path = 0;
-            job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-            job->m_BlockReadJob.m_StoredBlock = 0;
-            job->m_Err = err;
-            Longtail_Free(tmp_mem);
-            return 0;
-        }
+    Longtail_Free(work_mem);
+    return 0;
+}
 
-        uint64_t asset_write_offset = 0;
-        uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
-        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
-        for (uint32_t asset_chunk_index = 0; asset_chunk_index < asset_chunk_count; ++asset_chunk_index)
-        {
-            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + asset_chunk_index];
-            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+static int PutStoredBlockJob(void* context, uint32_t job_id, int is_cancelled)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-            uint32_t* chunk_block_index = Longtail_LookupTable_Get(block_chunks_lookup, chunk_hash);
-            if (chunk_block_index == 0)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", err)
-                version_storage_api->CloseFile(version_storage_api, asset_file);
-                asset_file = 0;
-                Longtail_Free(full_asset_path);
-                full_asset_path = 0;
-                job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-                job->m_BlockReadJob.m_StoredBlock = 0;
-                job->m_Err = err;
-                Longtail_Free(tmp_mem);
-                return 0;
-            }
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
 
-            uint32_t chunk_block_offset = chunk_offsets[*chunk_block_index];
-            uint32_t chunk_size = chunk_sizes[*chunk_block_index];
+    struct WriteBlockJob* job = (struct WriteBlockJob*)context;
+    LONGTAIL_FATAL_ASSERT(ctx, job->m_JobID == 0, return EINVAL);
 
-            while(asset_chunk_index < (asset_chunk_count - 1))
-            {
-                uint32_t next_chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + asset_chunk_index + 1];
-                TLongtail_Hash next_chunk_hash = version_index->m_ChunkHashes[next_chunk_index];
-                uint32_t* next_chunk_block_index = Longtail_LookupTable_Get(block_chunks_lookup, next_chunk_hash);
-                if (next_chunk_block_index == 0)
-                {
-                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", err)
-                    version_storage_api->CloseFile(version_storage_api, asset_file);
-                    asset_file = 0;
-                    Longtail_Free(full_asset_path);
-                    full_asset_path = 0;
-                    job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-                    job->m_BlockReadJob.m_StoredBlock = 0;
-                    job->m_Err = err;
-                    Longtail_Free(tmp_mem);
-                    return 0;
-                }
+    if (job->m_AsyncCompleteAPI.OnComplete)
+    {
+        // We got a notification so we are complete
+        job->m_AsyncCompleteAPI.OnComplete = 0;
+        return 0;
+    }
 
-                uint32_t next_chunk_block_offset = chunk_offsets[*next_chunk_block_index];
-                if (next_chunk_block_offset != chunk_block_offset + chunk_size)
-                {
-                    break;
-                }
-                uint32_t next_chunk_size = chunk_sizes[*next_chunk_block_index];
-                chunk_size += next_chunk_size;
-                ++asset_chunk_index;
-            }
+    LONGTAIL_FATAL_ASSERT(ctx, job->m_StoredBlock != 0, return EINVAL);
 
-            err = version_storage_api->Write(version_storage_api, asset_file, asset_write_offset, chunk_size, &block_data[chunk_block_offset]);
-            if (err)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->Write() failed with %d", err)
-                version_storage_api->CloseFile(version_storage_api, asset_file);
-                asset_file = 0;
-                Longtail_Free(full_asset_path);
-                full_asset_path = 0;
-                job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-                job->m_BlockReadJob.m_StoredBlock = 0;
-                job->m_Err = err;
-                Longtail_Free(tmp_mem);
-                return 0;
-            }
-            asset_write_offset += chunk_size;
-        }
+    if (is_cancelled)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "PutStoredBlockJob was cancelled, failed with %d", ECANCELED)
+        job->m_StoredBlock->Dispose(job->m_StoredBlock);
+        job->m_StoredBlock = 0;
+        job->m_Err = ECANCELED;
+        return 0;
+    }
 
-        version_storage_api->CloseFile(version_storage_api, asset_file);
-        asset_file = 0;
+    job->m_JobID = job_id;
+    job->m_AsyncCompleteAPI.OnComplete = BlockWriterJobOnComplete;
 
-        if (job->m_RetainPermissions)
-        {
-            err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, (uint16_t)version_index->m_Permissions[asset_index]);
-            Longtail_Free(full_asset_path);
-            full_asset_path = 0;
-            if (err)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
-                job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-                job->m_BlockReadJob.m_StoredBlock = 0;
-                job->m_Err = err;
-                Longtail_Free(tmp_mem);
-                return 0;
-            }
-        }
+    int err = job->m_BlockStoreAPI->PutStoredBlock(job->m_BlockStoreAPI, job->m_StoredBlock, &job->m_AsyncCompleteAPI);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_store_api->PutStoredBlock() failed with %d", err);
+        job->m_StoredBlock->Dispose(job->m_StoredBlock);
+        job->m_StoredBlock = 0;
+        job->m_JobID = 0;
+        job->m_AsyncCompleteAPI.OnComplete = 0;
+        job->m_Err = err;
+        return 0;
     }
-    Longtail_Free(tmp_mem);
 
-    job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
-    job->m_BlockReadJob.m_StoredBlock = 0;
-    job->m_Err = 0;
-    return 0;
+    return EBUSY;
 }
 
-struct AssetWriteList
+struct ExistingContentReaderJob
 {
-    uint32_t m_BlockJobCount;
-    uint32_t m_AssetJobCount;
-    uint32_t* m_BlockJobAssetIndexes;
-    uint32_t* m_AssetIndexJobs;
+    struct Longtail_AsyncGetExistingContentAPI m_AsyncCompleteAPI;
+    struct Longtail_BlockStoreAPI* m_BlockStoreAPI;
+    struct Longtail_JobAPI* m_JobAPI;
+    uint32_t m_JobID;
+    uint32_t m_ChunkCount;
+    const TLongtail_Hash* m_ChunkHashes;
+    uint32_t m_MinBlockUsagePercent;
+    struct Longtail_StoreIndex* m_StoreIndex;
+    int m_Err;
 };
 
-struct BlockJobCompareContext
+static void ExistingContentReaderJobOnComplete(struct Longtail_AsyncGetExistingContentAPI* async_complete_api, struct Longtail_StoreIndex* store_index, int err)
 {
-    const struct AssetWriteList* m_AssetWriteList;
-    const uint32_t* asset_chunk_index_starts;
-    const uint32_t* asset_chunk_indexes;
-    const TLongtail_Hash* chunk_hashes;
-    struct Longtail_LookupTable* chunk_hash_to_block_index;
-};
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(err, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-static SORTFUNC(BlockJobCompare)
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ExistingContentReaderJobOnComplete() failed with %d", err)
+    }
+    LONGTAIL_FATAL_ASSERT(ctx, async_complete_api != 0, return)
+    struct ExistingContentReaderJob* job = (struct ExistingContentReaderJob*)async_complete_api;
+    LONGTAIL_FATAL_ASSERT(ctx, job->m_AsyncCompleteAPI.OnComplete != 0, return);
+    job->m_Err = err;
+    job->m_StoreIndex = store_index;
+    job->m_JobAPI->ResumeJob(job->m_JobAPI, job->m_JobID);
+}
+
+static int ExistingContentReader(void* context, uint32_t job_id, int is_cancelled)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(context, "%p"),
-        LONGTAIL_LOGFIELD(a_ptr, "%p"),
-        LONGTAIL_LOGFIELD(b_ptr, "%p")
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
-
-    struct BlockJobCompareContext* c = (struct BlockJobCompareContext*)context;
-    struct Longtail_LookupTable* chunk_hash_to_block_index = c->chunk_hash_to_block_index;
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
 
-    uint32_t a = *(const uint32_t*)a_ptr;
-    uint32_t b = *(const uint32_t*)b_ptr;
+    struct ExistingContentReaderJob* job = (struct ExistingContentReaderJob*)context;
 
-    uint32_t asset_chunk_offset_a = c->asset_chunk_index_starts[a];
-    uint32_t asset_chunk_offset_b = c->asset_chunk_index_starts[b];
-    uint32_t chunk_index_a = c->asset_chunk_indexes[asset_chunk_offset_a];
-    uint32_t chunk_index_b = c->asset_chunk_indexes[asset_chunk_offset_b];
+    if (job->m_AsyncCompleteAPI.OnComplete)
+    {
+        // We got a notification so we are complete
+        job->m_AsyncCompleteAPI.OnComplete = 0;
+        return 0;
+    }
 
-    TLongtail_Hash a_first_chunk_hash = c->chunk_hashes[chunk_index_a];
-    TLongtail_Hash b_first_chunk_hash = c->chunk_hashes[chunk_index_b];
-//    if (a_first_chunk_hash == b_first_chunk_hash)
-//    {
-//        return 0;
-//    }
-    const uint32_t* a_block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, a_first_chunk_hash);
-    LONGTAIL_FATAL_ASSERT(ctx, a_block_index_ptr, return 0)
-    const uint32_t* b_block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, b_first_chunk_hash);
-    LONGTAIL_FATAL_ASSERT(ctx, b_block_index_ptr, return 0)
-    uint32_t a_block_index = *a_block_index_ptr;
-    uint32_t b_block_index = *b_block_index_ptr;
-    if (a_block_index < b_block_index)
+    if (is_cancelled)
     {
-        return -1;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "ExistingContentReader was cancelled, failed with %d", ECANCELED)
+        job->m_Err = ECANCELED;
+        return 0;
     }
-    else if (a_block_index > b_block_index)
+
+    job->m_JobID = job_id;
+    job->m_StoreIndex = 0;
+    job->m_AsyncCompleteAPI.OnComplete = ExistingContentReaderJobOnComplete;
+
+    int err = job->m_BlockStoreAPI->GetExistingContent(job->m_BlockStoreAPI, job->m_ChunkCount, job->m_ChunkHashes, job->m_MinBlockUsagePercent, &job->m_AsyncCompleteAPI);
+    if (err)
     {
-        return 1;
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job->m_BlockStoreAPI->GetExistingContent() failed with %d", err)
+        job->m_AsyncCompleteAPI.OnComplete = 0;
+        job->m_Err = err;
+        return 0;
     }
-    return 0;
+    return EBUSY;
 }
 
+// The source data is chunked in windows of roughly this many max size blocks, the chunk data of a window is
+// kept in memory until the blocks it fills have been handed to the block store. The next window is hashed
+// while the current one is written so at most two windows of chunk data are in memory
+#define INDEX_AND_WRITE_WINDOW_BLOCK_COUNT 32u
 
-static struct AssetWriteList* CreateAssetWriteList(uint32_t asset_count)
+struct IndexAndWriteContent
+{
+    struct Longtail_HashAPI* m_HashAPI;
+    uint32_t m_MaxBlockSize;
+    uint32_t m_MaxChunksPerBlock;
+
+    // Per asset chunk, in version order
+    uint32_t* m_AssetChunkIndexes;
+    TLongtail_Hash* m_AssetChunkHashes;
+    uint32_t m_AssetIndex;
+    uint32_t m_AssetTag;
+
+    // Unique chunks in order of first appearance
+    struct Longtail_LookupTable* m_ChunkHashToIndex;
+    TLongtail_Hash* m_ChunkHashes;
+    uint32_t* m_ChunkSizes;
+    uint32_t* m_ChunkTags;
+
+    // Chunks first seen in the current window and where to find their data
+    uint32_t* m_WindowChunkIndexes;
+    uint32_t* m_WindowChunkAssetIndexes;
+    const uint8_t** m_WindowChunkData;
+    uint8_t** m_WindowRechunkedData;
+    uint8_t* m_WindowChunkIsStored;
+
+    // Blocks in the store holding chunks of the version. A block is used once the chunks of the version seen so far
+    // fill m_MinBlockUsagePercent of it, chunks only found in blocks below that are deferred until all of the
+    // version is chunked so the block usage is evaluated against the whole version
+    uint32_t m_MinBlockUsagePercent;
+    struct Longtail_LookupTable* m_ExistingBlockHashToIndex;
+    uint32_t* m_ExistingBlockChunkOffsets;
+    uint32_t* m_ExistingBlockChunkCounts;
+    uint8_t* m_ExistingBlockIsUsed;
+    TLongtail_Hash* m_ExistingChunkHashes;
+    uint32_t* m_ExistingChunkSizes;
+    struct Longtail_LookupTable* m_UsedChunkHashes;
+    uint32_t* m_DeferredChunkIndexes;
+    uint32_t* m_DeferredChunkAssetIndexes;
+    size_t* m_DeferredChunkDataOffsets;
+    uint8_t* m_DeferredChunkData;
+
+    // The block being filled
+    uint32_t* m_BlockChunkIndexes;
+    uint8_t* m_BlockData;
+    uint32_t m_BlockTag;
+
+    struct Longtail_StoredBlock** m_PendingBlocks;
+    struct Longtail_BlockIndex** m_WrittenBlockIndexes;
+};
+
+static int AddIndexAndWriteChunk(void* context, TLongtail_Hash chunk_hash, uint32_t chunk_size, const uint8_t* chunk_data, int is_rechunked)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(asset_count, "%u")
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(chunk_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(chunk_data, "%p"),
+        LONGTAIL_LOGFIELD(is_rechunked, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    size_t awl_size = sizeof(struct AssetWriteList) + sizeof(uint32_t) * asset_count + sizeof(uint32_t) * asset_count;
-    struct AssetWriteList* awl = (struct AssetWriteList*)(Longtail_Alloc("CreateAssetWriteList", awl_size));
-    if (!awl)
+    LONGTAIL_FATAL_ASSERT(ctx, chunk_data != 0, return EINVAL)
+
+    struct IndexAndWriteContent* c = (struct IndexAndWriteContent*)context;
+
+    if (Longtail_LookupTable_GetSpaceLeft(c->m_ChunkHashToIndex) == 0)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_Alloc() failed with %d", ENOMEM)
-        return 0;
+        uint32_t capacity = (uint32_t)arrlen(c->m_ChunkHashes) * 2;
+        void* lookup_mem = Longtail_Alloc("AddIndexAndWriteChunk", Longtail_LookupTable_GetSize(capacity));
+        if (!lookup_mem)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
+        struct Longtail_LookupTable* chunk_hash_to_index = Longtail_LookupTable_Create(lookup_mem, capacity, c->m_ChunkHashToIndex);
+        Longtail_Free(c->m_ChunkHashToIndex);
+        c->m_ChunkHashToIndex = chunk_hash_to_index;
     }
-    awl->m_BlockJobCount = 0;
-    awl->m_AssetJobCount = 0;
-    awl->m_BlockJobAssetIndexes = (uint32_t*)(void*)&awl[1];
-    awl->m_AssetIndexJobs = &awl->m_BlockJobAssetIndexes[asset_count];
-    return awl;
+
+    uint32_t unique_chunk_count = (uint32_t)arrlen(c->m_ChunkHashes);
+    uint32_t* chunk_index = Longtail_LookupTable_PutUnique(c->m_ChunkHashToIndex, chunk_hash, unique_chunk_count);
+    if (chunk_index == 0)
+    {
+        if (is_rechunked)
+        {
+            uint8_t* rechunked_data = (uint8_t*)Longtail_Alloc("AddIndexAndWriteChunk", chunk_size);
+            if (!rechunked_data)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+                return ENOMEM;
+            }
+            memcpy(rechunked_data, chunk_data, chunk_size);
+            arrpush(c->m_WindowRechunkedData, rechunked_data);
+            chunk_data = rechunked_data;
+        }
+        arrpush(c->m_ChunkHashes, chunk_hash);
+        arrpush(c->m_ChunkSizes, chunk_size);
+        arrpush(c->m_ChunkTags, c->m_AssetTag);
+        arrpush(c->m_WindowChunkIndexes, unique_chunk_count);
+        arrpush(c->m_WindowChunkAssetIndexes, c->m_AssetIndex);
+        arrpush(c->m_WindowChunkData, chunk_data);
+        arrpush(c->m_AssetChunkIndexes, unique_chunk_count);
+    }
+    else
+    {
+        arrpush(c->m_AssetChunkIndexes, *chunk_index);
+    }
+    arrpush(c->m_AssetChunkHashes, chunk_hash);
+    return 0;
 }
 
-static int BuildAssetWriteList(
-    uint32_t asset_count,
-    const uint32_t* optional_asset_indexes,
-    uint32_t* name_offsets,
-    const char* name_data,
-    const TLongtail_Hash* chunk_hashes,
-    const uint32_t* asset_chunk_counts,
-    const uint32_t* asset_chunk_index_starts,
-    const uint32_t* asset_chunk_indexes,
-    struct Longtail_LookupTable* chunk_hash_to_block_index,
-    struct AssetWriteList** out_asset_write_list)
+static int FlushIndexAndWriteBlock(struct IndexAndWriteContent* c)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(asset_count, "%u"),
-        LONGTAIL_LOGFIELD(optional_asset_indexes, "%p"),
-        LONGTAIL_LOGFIELD(name_offsets, "%p"),
-        LONGTAIL_LOGFIELD(name_data, "%p"),
-        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_index_starts, "%p"),
-        LONGTAIL_LOGFIELD(asset_chunk_indexes, "%p"),
-        LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
-        LONGTAIL_LOGFIELD(out_asset_write_list, "%p")
+        LONGTAIL_LOGFIELD(c, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || name_offsets != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || name_data != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || chunk_hashes != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_counts != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_index_starts != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_indexes != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, chunk_hash_to_block_index != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, out_asset_write_list != 0, return EINVAL)
+    uint32_t chunk_count = (uint32_t)arrlen(c->m_BlockChunkIndexes);
+    if (chunk_count == 0)
+    {
+        return 0;
+    }
 
-    struct AssetWriteList* awl = CreateAssetWriteList(asset_count);
-    if (awl == 0)
+    struct Longtail_BlockIndex* block_index;
+    int err = Longtail_CreateBlockIndex(
+        c->m_HashAPI,
+        c->m_BlockTag,
+        chunk_count,
+        c->m_BlockChunkIndexes,
+        c->m_ChunkHashes,
+        c->m_ChunkSizes,
+        &block_index);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateAssetWriteList() CreateAssetWriteList() failed with %d", ENOMEM)
-        return ENOMEM;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateBlockIndex() failed with %d", err)
+        return err;
     }
 
-    for (uint32_t i = 0; i < asset_count; ++i)
+    uint32_t block_data_size = (uint32_t)arrlen(c->m_BlockData);
+    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
+    size_t stored_block_size = sizeof(struct Longtail_StoredBlock);
+    void* put_block_mem = Longtail_Alloc("FlushIndexAndWriteBlock", stored_block_size + block_index_size + block_data_size);
+    if (!put_block_mem)
     {
-        uint32_t asset_index = optional_asset_indexes ? optional_asset_indexes[i] : i;
-        const char* path = &name_data[name_offsets[asset_index]];
-        uint32_t chunk_count = asset_chunk_counts[asset_index];
-        uint32_t asset_chunk_offset = asset_chunk_index_starts[asset_index];
-        if (chunk_count == 0)
-        {
-            awl->m_AssetIndexJobs[awl->m_AssetJobCount] = asset_index;
-            ++awl->m_AssetJobCount;
-            continue;
-        }
-        uint32_t chunk_index = asset_chunk_indexes[asset_chunk_offset];
-        TLongtail_Hash chunk_hash = chunk_hashes[chunk_index];
-        uint32_t* content_block_index = Longtail_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
-        if (content_block_index == 0)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", ENOENT)
-            Longtail_Free(awl);
-            return ENOENT;
-        }
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(block_index);
+        return ENOMEM;
+    }
 
-        int is_block_job = 1;
-        for (uint32_t c = 1; c < chunk_count; ++c)
+    char* p = (char*)put_block_mem;
+    struct Longtail_StoredBlock* stored_block = (struct Longtail_StoredBlock*)p;
+    p += stored_block_size;
+    struct Longtail_BlockIndex* block_index_ptr = (struct Longtail_BlockIndex*)p;
+    p += block_index_size;
+    char* block_data_buffer = p;
+
+    Longtail_InitBlockIndex(block_index_ptr, chunk_count);
+    memmove(block_index_ptr->m_ChunkHashes, block_index->m_ChunkHashes, sizeof(TLongtail_Hash) * chunk_count);
+    memmove(block_index_ptr->m_ChunkSizes, block_index->m_ChunkSizes, sizeof(uint32_t) * chunk_count);
+    *block_index_ptr->m_BlockHash = *block_index->m_BlockHash;
+    *block_index_ptr->m_HashIdentifier = *block_index->m_HashIdentifier;
+    *block_index_ptr->m_Tag = *block_index->m_Tag;
+    *block_index_ptr->m_ChunkCount = chunk_count;
+    memcpy(block_data_buffer, c->m_BlockData, block_data_size);
+    stored_block->Dispose = DisposePutBlock;
+    stored_block->m_BlockIndex = block_index_ptr;
+    stored_block->m_BlockData = block_data_buffer;
+    stored_block->m_BlockChunksDataSize = block_data_size;
+
+    arrpush(c->m_PendingBlocks, stored_block);
+    arrpush(c->m_WrittenBlockIndexes, block_index);
+
+    arrsetlen(c->m_BlockChunkIndexes, 0);
+    arrsetlen(c->m_BlockData, 0);
+    return 0;
+}
+
+// Chunks of a small asset are kept in one block, if they do not fit in the rest of the current block the block is
+// closed early so a downsync of the asset only has to fetch one block. Assets larger than a quarter of a block are
+// packed greedily so closing early never leaves more than a quarter of a block unused. Small assets are also
+// chunked in one part so Longtail_CreateVersionIndexAndWriteContent() sees all their chunks in the same window.
+static int ShouldCloseBlockForAsset(
+    uint32_t block_chunk_count,
+    uint64_t block_size,
+    uint64_t asset_size,
+    uint32_t target_chunk_size,
+    uint32_t asset_chunk_count,
+    uint64_t asset_chunks_size,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block)
+{
+    if (block_chunk_count == 0 || asset_chunk_count == 0)
+    {
+        return 0;
+    }
+    if ((asset_size > (max_block_size / 4)) ||
+        (asset_size >= (uint64_t)target_chunk_size * 1024) ||
+        (asset_chunk_count > (max_chunks_per_block / 4)))
+    {
+        return 0;
+    }
+    // Overshoot by 10% is ok
+    return ((block_chunk_count + asset_chunk_count) > max_chunks_per_block) ||
+        ((block_size + asset_chunks_size) > (max_block_size + (max_block_size / 10)));
+}
+
+// Same packing rules as Longtail_CreateMissingContent()
+static int AddIndexAndWriteBlockChunk(struct IndexAndWriteContent* c, uint32_t chunk_index, const uint8_t* chunk_data)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(c, "%p"),
+        LONGTAIL_LOGFIELD(chunk_index, "%u"),
+        LONGTAIL_LOGFIELD(chunk_data, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    uint32_t chunk_size = c->m_ChunkSizes[chunk_index];
+    uint32_t tag = c->m_ChunkTags[chunk_index];
+    uint32_t chunk_count_in_block = (uint32_t)arrlen(c->m_BlockChunkIndexes);
+    if (chunk_count_in_block > 0)
+    {
+        uint32_t current_size = (uint32_t)arrlen(c->m_BlockData);
+        if ((tag != c->m_BlockTag) ||
+            (chunk_count_in_block == c->m_MaxChunksPerBlock) ||
+            // Overshoot by 10% is ok
+            ((current_size + chunk_size) > (c->m_MaxBlockSize + (c->m_MaxBlockSize / 10))))
         {
-            uint32_t next_chunk_index = asset_chunk_indexes[asset_chunk_offset + c];
-            TLongtail_Hash next_chunk_hash = chunk_hashes[next_chunk_index];
-            uint32_t* next_content_block_index = Longtail_LookupTable_Get(chunk_hash_to_block_index, next_chunk_hash);
-            if (next_content_block_index == 0)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", ENOENT)
-                Longtail_Free(awl);
-                return ENOENT;
-            }
-            if (*content_block_index != *next_content_block_index)
+            int err = FlushIndexAndWriteBlock(c);
+            if (err)
             {
-                is_block_job = 0;
-                // We don't break here since we want to validate that all the chunks are in the content index
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FlushIndexAndWriteBlock() failed with %d", err)
+                return err;
             }
         }
-
-        if (is_block_job)
-        {
-            awl->m_BlockJobAssetIndexes[awl->m_BlockJobCount] = asset_index;
-            ++awl->m_BlockJobCount;
-        }
-        else
-        {
-            awl->m_AssetIndexJobs[awl->m_AssetJobCount] = asset_index;
-            ++awl->m_AssetJobCount;
-        }
     }
-
-    struct BlockJobCompareContext block_job_compare_context = {
-            awl,    // m_AssetWriteList
-            asset_chunk_index_starts,
-            asset_chunk_indexes,
-            chunk_hashes,   // chunk_hashes
-            chunk_hash_to_block_index  // chunk_hash_to_block_index
-        };
-    QSORT(awl->m_BlockJobAssetIndexes, (size_t)awl->m_BlockJobCount, sizeof(uint32_t), BlockJobCompare, &block_job_compare_context);
-
-    *out_asset_write_list = awl;
+    if (arrlen(c->m_BlockChunkIndexes) == 0)
+    {
+        c->m_BlockTag = tag;
+    }
+    arrpush(c->m_BlockChunkIndexes, chunk_index);
+    size_t data_offset = arrlen(c->m_BlockData);
+    arrsetlen(c->m_BlockData, data_offset + chunk_size);
+    memcpy(&c->m_BlockData[data_offset], chunk_data, chunk_size);
     return 0;
 }
 
-static int WriteAssets(
+static int WritePendingIndexAndWriteBlocks(
+    struct IndexAndWriteContent* c,
     struct Longtail_BlockStoreAPI* block_store_api,
-    struct Longtail_StorageAPI* version_storage_api,
     struct Longtail_JobAPI* job_api,
-    struct Longtail_ProgressAPI* progress_api,
     struct Longtail_CancelAPI* optional_cancel_api,
-    Longtail_CancelAPI_HCancelToken optional_cancel_token,
-    const struct Longtail_StoreIndex* store_index,
-    const struct Longtail_VersionIndex* version_index,
-    const char* version_path,
-    struct Longtail_LookupTable* chunk_hash_to_block_index,
-    struct AssetWriteList* awl,
-    int retain_permssions)
+    Longtail_CancelAPI_HCancelToken optional_cancel_token)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(c, "%p"),
         LONGTAIL_LOGFIELD(block_store_api, "%p"),
-        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
         LONGTAIL_LOGFIELD(job_api, "%p"),
-        LONGTAIL_LOGFIELD(progress_api, "%p"),
         LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
-        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
-        LONGTAIL_LOGFIELD(store_index, "%p"),
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(version_path, "%s"),
-        LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
-        LONGTAIL_LOGFIELD(awl, "%p"),
-        LONGTAIL_LOGFIELD(retain_permssions, "%d")
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    LONGTAIL_FATAL_ASSERT(ctx, block_store_api != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, version_storage_api != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, job_api != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, store_index != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, version_path != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, chunk_hash_to_block_index != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, awl != 0, return EINVAL)
-
+    uint32_t job_count = (uint32_t)arrlen(c->m_PendingBlocks);
+    if (job_count == 0)
     {
-        uint32_t j = 0;
-        while (j < awl->m_BlockJobCount)
-        {
-            uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
-            TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
-            const uint32_t* block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
-            if (!block_index_ptr)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", EINVAL)
-                return EINVAL;
-            }
-            uint32_t block_index = *block_index_ptr;
-            TLongtail_Hash block_hash = store_index->m_BlockHashes[block_index];
-
-            ++j;
-            while (j < awl->m_BlockJobCount)
-            {
-                uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
-                TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
-                const uint32_t* next_block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
-                if (!next_block_index_ptr)
-                {
-                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", EINVAL)
-                    return EINVAL;
-                }
-                uint32_t next_block_index = *next_block_index_ptr;
-                if (next_block_index != block_index)
-                {
-                    break;
-                }
-                ++j;
-            }
-        }
+        return 0;
     }
 
-    const uint32_t worker_count = job_api->GetWorkerCount(job_api) + 1;
-    const uint32_t max_parallell_block_read_jobs = worker_count < MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE ? worker_count : MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE;
-
-    uint32_t asset_job_count = 0;
-    for (uint32_t a = 0; a < awl->m_AssetJobCount; ++a)
+    size_t work_mem_size =
+        sizeof(struct WriteBlockJob) * job_count +
+        sizeof(Longtail_JobAPI_JobFunc) * job_count +
+        sizeof(void*) * job_count;
+    void* work_mem = Longtail_Alloc("WritePendingIndexAndWriteBlocks", work_mem_size);
+    if (!work_mem)
     {
-        uint32_t asset_index = awl->m_AssetIndexJobs[a];
-        uint32_t chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
-        uint32_t chunk_count = version_index->m_AssetChunkCounts[asset_index];
-        if (chunk_count == 0)
-        {
-            asset_job_count += 1;   // Write job
-            continue;
-        }
-
-        uint32_t chunk_index_end = chunk_index_start + chunk_count;
-        uint32_t chunk_index_offset = chunk_index_start;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct WriteBlockJob* write_block_jobs = (struct WriteBlockJob*)work_mem;
+    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)&write_block_jobs[job_count];
+    void** ctxs = (void**)&funcs[job_count];
 
-        while(chunk_index_offset != chunk_index_end)
-        {
-            uint32_t block_read_job_count = 0;
-            TLongtail_Hash block_hashes[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
-            while (chunk_index_offset != chunk_index_end && block_read_job_count < max_parallell_block_read_jobs)
-            {
-                uint32_t chunk_index = version_index->m_AssetChunkIndexes[chunk_index_offset];
-                TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
-                const uint32_t* block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
-                LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
-                uint32_t block_index = *block_index_ptr;
-                TLongtail_Hash block_hash = store_index->m_BlockHashes[block_index];
-                int has_block = 0;
-                for (uint32_t d = 0; d < block_read_job_count; ++d)
-                {
-                    if (block_hashes[d] == block_hash)
-                    {
-                        has_block = 1;
-                        break;
-                    }
-                }
-                if (!has_block)
-                {
-                    block_hashes[block_read_job_count++] = block_hash;
-                }
-                ++chunk_index_offset;
-            }
-            asset_job_count += 1;   // Write job
-            asset_job_count += 1;   // Sync job
-            asset_job_count += block_read_job_count;
-        }
+    for (uint32_t j = 0; j < job_count; ++j)
+    {
+        struct WriteBlockJob* job = &write_block_jobs[j];
+        job->m_AsyncCompleteAPI.m_API.Dispose = 0;
+        job->m_AsyncCompleteAPI.OnComplete = 0;
+        job->m_SourceStorageAPI = 0;
+        job->m_BlockStoreAPI = block_store_api;
+        job->m_JobAPI = job_api;
+        job->m_JobID = 0;
+        job->m_StoredBlock = c->m_PendingBlocks[j];
+        job->m_AssetsFolder = 0;
+        job->m_StoreIndex = 0;
+        job->m_BlockIndex = j;
+        job->m_AssetPartLookup = 0;
+        job->m_Err = EINVAL;
+        funcs[j] = PutStoredBlockJob;
+        ctxs[j] = job;
     }
+    arrsetlen(c->m_PendingBlocks, 0);
 
-    int err = block_store_api->PreflightGet(block_store_api, *store_index->m_BlockCount, store_index->m_BlockHashes, 0);
+    Longtail_JobAPI_Group job_group = 0;
+    int err = job_api->ReserveJobs(job_api, job_count, &job_group);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_store_api->PreflightGet() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+        for (uint32_t j = 0; j < job_count; ++j)
+        {
+            write_block_jobs[j].m_StoredBlock->Dispose(write_block_jobs[j].m_StoredBlock);
+        }
+        Longtail_Free(work_mem);
         return err;
     }
 
-    if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
+    Longtail_JobAPI_Jobs jobs;
+    err = job_api->CreateJobs(job_api, job_group, job_count, funcs, ctxs, &jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+    err = job_api->ReadyJobs(job_api, job_count, jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+
+    err = job_api->WaitForAllJobs(job_api, job_group, 0, optional_cancel_api, optional_cancel_token);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Cancelled, failed with %d", ECANCELED)
-        return ECANCELED;
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        Longtail_Free(work_mem);
+        return err;
     }
 
-    struct WriteAssetsFromBlockJob* block_jobs = (struct WriteAssetsFromBlockJob*)Longtail_Alloc("WriteAssets", (size_t)(sizeof(struct WriteAssetsFromBlockJob) * awl->m_BlockJobCount));
-    if (!block_jobs)
+    for (uint32_t j = 0; j < job_count; ++j)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
+        if (write_block_jobs[j].m_Err)
+        {
+            err = err ? err : write_block_jobs[j].m_Err;
+        }
     }
-
-    Longtail_JobAPI_Group job_group = 0;
-    err = job_api->ReserveJobs(job_api, (awl->m_BlockJobCount * 2u) + asset_job_count, &job_group);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
-        Longtail_Free(block_jobs);
-        return err;
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "PutStoredBlockJob() failed with %d", err)
     }
+    Longtail_Free(work_mem);
+    return err;
+}
 
-    uint32_t j = 0;
-    uint32_t block_job_count = 0;
-    while (j < awl->m_BlockJobCount)
-    {
-        uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
-        TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
-        const uint32_t* block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
-        LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
-        uint32_t block_index = *block_index_ptr;
+static int GetExistingIndexAndWriteChunks(
+    struct IndexAndWriteContent* c,
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    uint32_t min_block_usage_percent,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(c, "%p"),
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(min_block_usage_percent, "%u"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-        struct WriteAssetsFromBlockJob* job = &block_jobs[block_job_count++];
-        struct BlockReaderJob* block_job = &job->m_BlockReadJob;
-        block_job->m_BlockStoreAPI = block_store_api;
-        block_job->m_AsyncCompleteAPI.m_API.Dispose = 0;
-        block_job->m_AsyncCompleteAPI.OnComplete = 0;
-        block_job->m_BlockHash = store_index->m_BlockHashes[block_index];
-        block_job->m_JobAPI = job_api;
-        block_job->m_JobID = 0;
-        block_job->m_Err = EINVAL;
-        block_job->m_StoredBlock = 0;
-        Longtail_JobAPI_JobFunc block_read_funcs[1] = { BlockReader };
-        void* block_read_ctxs[1] = {block_job};
-        Longtail_JobAPI_Jobs block_read_job;
-        err = job_api->CreateJobs(job_api, job_group, 1, block_read_funcs, block_read_ctxs, &block_read_job);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+    uint32_t chunk_count = (uint32_t)arrlen(c->m_WindowChunkIndexes);
+    TLongtail_Hash* chunk_hashes = (TLongtail_Hash*)Longtail_Alloc("GetExistingIndexAndWriteChunks", sizeof(TLongtail_Hash) * chunk_count);
+    if (!chunk_hashes)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    for (uint32_t w = 0; w < chunk_count; ++w)
+    {
+        chunk_hashes[w] = c->m_ChunkHashes[c->m_WindowChunkIndexes[w]];
+    }
 
-        job->m_VersionStorageAPI = version_storage_api;
-        job->m_VersionIndex = version_index;
-        job->m_VersionFolder = version_path;
-        job->m_BlockIndex = block_index;
-        job->m_AssetIndexes = &awl->m_BlockJobAssetIndexes[j];
-        job->m_RetainPermissions = retain_permssions;
-        job->m_Err = EINVAL;
+    struct ExistingContentReaderJob job;
+    job.m_AsyncCompleteAPI.m_API.Dispose = 0;
+    job.m_AsyncCompleteAPI.OnComplete = 0;
+    job.m_BlockStoreAPI = block_store_api;
+    job.m_JobAPI = job_api;
+    job.m_JobID = 0;
+    job.m_ChunkCount = chunk_count;
+    job.m_ChunkHashes = chunk_hashes;
+    job.m_MinBlockUsagePercent = min_block_usage_percent;
+    job.m_StoreIndex = 0;
+    job.m_Err = EINVAL;
 
-        job->m_AssetCount = 1;
-        ++j;
-        while (j < awl->m_BlockJobCount)
-        {
-            uint32_t next_asset_index = awl->m_BlockJobAssetIndexes[j];
-            TLongtail_Hash next_first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[next_asset_index]]];
-            uint32_t* next_block_index = Longtail_LookupTable_Get(chunk_hash_to_block_index, next_first_chunk_hash);
-            LONGTAIL_FATAL_ASSERT(ctx, next_block_index != 0, return EINVAL)
-            if (block_index != *next_block_index)
-            {
-                break;
-            }
+    Longtail_JobAPI_Group job_group = 0;
+    int err = job_api->ReserveJobs(job_api, 1, &job_group);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+        Longtail_Free(chunk_hashes);
+        return err;
+    }
 
-            ++job->m_AssetCount;
-            ++j;
-        }
+    Longtail_JobAPI_JobFunc func[1] = { ExistingContentReader };
+    void* ctxs[1] = { &job };
+    Longtail_JobAPI_Jobs jobs;
+    err = job_api->CreateJobs(job_api, job_group, 1, func, ctxs, &jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+    err = job_api->ReadyJobs(job_api, 1, jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
 
-        Longtail_JobAPI_JobFunc funcs[1] = { WriteAssetsFromBlock };
-        void* ctxs[1] = { job };
+    err = job_api->WaitForAllJobs(job_api, job_group, 0, optional_cancel_api, optional_cancel_token);
+    Longtail_Free(chunk_hashes);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        return err;
+    }
+    if (job.m_Err)
+    {
+        LONGTAIL_LOG(ctx, job.m_Err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "ExistingContentReader() failed with %d", job.m_Err)
+        Longtail_Free(job.m_StoreIndex);
+        return job.m_Err;
+    }
+    *out_store_index = job.m_StoreIndex;
+    return 0;
+}
 
-        Longtail_JobAPI_Jobs block_write_job;
-        err = job_api->CreateJobs(job_api, job_group, 1, funcs, ctxs, &block_write_job);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
-        err = job_api->AddDependecies(job_api, 1, block_write_job, 1, block_read_job);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
-        err = job_api->ReadyJobs(job_api, 1, block_read_job);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+static int GrowIndexAndWriteLookup(struct Longtail_LookupTable** lookup, uint32_t add_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(lookup, "%p"),
+        LONGTAIL_LOGFIELD(add_count, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    if (*lookup && Longtail_LookupTable_GetSpaceLeft(*lookup) >= add_count)
+    {
+        return 0;
     }
-/*
-block_readorCount = blocks_remaning > 8 ? 8 : blocks_remaning
+    uint32_t capacity = ((*lookup ? (*lookup)->m_Count : 0) + add_count) * 2;
+    void* lookup_mem = Longtail_Alloc("GrowIndexAndWriteLookup", Longtail_LookupTable_GetSize(capacity));
+    if (!lookup_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct Longtail_LookupTable* grown_lookup = Longtail_LookupTable_Create(lookup_mem, capacity, *lookup);
+    if (*lookup)
+    {
+        Longtail_Free(*lookup);
+    }
+    *lookup = grown_lookup;
+    return 0;
+}
 
-Create block_reador Tasks [block_readorCount]
-Create WriteSync Task
-Create Write Task
-    Depends on block_reador Tasks [block_readorCount]
-    Depends on WriteSync Task
+// Same usage rule as Longtail_GetExistingStoreIndex() but against the chunks of the version seen so far, the
+// usage only grows as more of the version is chunked
+static int IsExistingIndexAndWriteBlockUsed(const struct IndexAndWriteContent* c, uint32_t existing_block_index)
+{
+    uint32_t block_use = 0;
+    uint32_t block_size = 0;
+    uint32_t chunk_offset = c->m_ExistingBlockChunkOffsets[existing_block_index];
+    uint32_t chunk_end = chunk_offset + c->m_ExistingBlockChunkCounts[existing_block_index];
+    for (uint32_t e = chunk_offset; e < chunk_end; ++e)
+    {
+        uint32_t chunk_size = c->m_ExistingChunkSizes[e];
+        block_size += chunk_size;
+        if (Longtail_LookupTable_Get(c->m_ChunkHashToIndex, c->m_ExistingChunkHashes[e]))
+        {
+            block_use += chunk_size;
+        }
+    }
+    if (block_use == 0)
+    {
+        return 0;
+    }
+    uint32_t block_usage_percent = (uint32_t)(((uint64_t)block_use * 100) / block_size);
+    return block_usage_percent >= c->m_MinBlockUsagePercent;
+}
 
-Ready block_reador Tasks [block_readorCount]
-Ready WriteSync Task
+static int UseExistingIndexAndWriteBlock(struct IndexAndWriteContent* c, uint32_t existing_block_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(c, "%p"),
+        LONGTAIL_LOGFIELD(existing_block_index, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-WaitForAllTasks()
+    uint32_t chunk_offset = c->m_ExistingBlockChunkOffsets[existing_block_index];
+    uint32_t chunk_count = c->m_ExistingBlockChunkCounts[existing_block_index];
+    int err = GrowIndexAndWriteLookup(&c->m_UsedChunkHashes, chunk_count);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "GrowIndexAndWriteLookup() failed with %d", err)
+        return err;
+    }
+    for (uint32_t e = chunk_offset; e < chunk_offset + chunk_count; ++e)
+    {
+        Longtail_LookupTable_PutUnique(c->m_UsedChunkHashes, c->m_ExistingChunkHashes[e], existing_block_index);
+    }
+    c->m_ExistingBlockIsUsed[existing_block_index] = 1;
+    return 0;
+}
 
-JOBS:
+// Records the blocks of @p existing_store_index and marks each chunk of the window that is in a used block as
+// stored, chunks that are only in blocks below the minimum usage are moved to the deferred chunks
+static int AddExistingIndexAndWriteChunks(struct IndexAndWriteContent* c, const struct Longtail_StoreIndex* existing_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(c, "%p"),
+        LONGTAIL_LOGFIELD(existing_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-Write Task Execute (When block_reador Tasks [block_readorCount] and WriteSync Task is complete)
-    Newblock_readorCount = blocks_remaning > 8 ? 8 : blocks_remaning
-    if ([block_readorCount] > 0)
-        Create block_reador Tasks for up to remaining blocks [Newblock_readorCount]
-        Create WriteSync Task
-        Create Write Task
-            Depends on block_reador Tasks [Newblock_readorCount]
-            Depends on WriteSync Task
-        Ready block_reador Tasks [Newblock_readorCount]
-    Write and Longtail_Free block_readed Tasks Data [block_readorCount] To Disk
-    if ([block_readorCount] > 0)
-        Ready WriteSync Task
-*/
+    uint32_t existing_block_count = *existing_store_index->m_BlockCount;
+    uint32_t existing_chunk_count = *existing_store_index->m_ChunkCount;
+    int err = GrowIndexAndWriteLookup(&c->m_ExistingBlockHashToIndex, existing_block_count);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "GrowIndexAndWriteLookup() failed with %d", err)
+        return err;
+    }
+    for (uint32_t b = 0; b < existing_block_count; ++b)
+    {
+        uint32_t existing_block_index = (uint32_t)arrlen(c->m_ExistingBlockIsUsed);
+        uint32_t* known_block_index = Longtail_LookupTable_PutUnique(c->m_ExistingBlockHashToIndex, existing_store_index->m_BlockHashes[b], existing_block_index);
+        if (known_block_index)
+        {
+            existing_block_index = *known_block_index;
+        }
+        else
+        {
+            uint32_t block_chunk_offset = existing_store_index->m_BlockChunksOffsets[b];
+            uint32_t block_chunk_count = existing_store_index->m_BlockChunkCounts[b];
+            arrpush(c->m_ExistingBlockChunkOffsets, (uint32_t)arrlen(c->m_ExistingChunkHashes));
+            arrpush(c->m_ExistingBlockChunkCounts, block_chunk_count);
+            arrpush(c->m_ExistingBlockIsUsed, 0);
+            for (uint32_t e = block_chunk_offset; e < block_chunk_offset + block_chunk_count; ++e)
+            {
+                arrpush(c->m_ExistingChunkHashes, existing_store_index->m_ChunkHashes[e]);
+                arrpush(c->m_ExistingChunkSizes, existing_store_index->m_ChunkSizes[e]);
+            }
+        }
+        if (!c->m_ExistingBlockIsUsed[existing_block_index] && IsExistingIndexAndWriteBlockUsed(c, existing_block_index))
+        {
+            err = UseExistingIndexAndWriteBlock(c, existing_block_index);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "UseExistingIndexAndWriteBlock() failed with %d", err)
+                return err;
+            }
+        }
+    }
 
-    size_t asset_jobs_size = sizeof(struct WritePartialAssetFromBlocksJob) * awl->m_AssetJobCount;
-    struct WritePartialAssetFromBlocksJob* asset_jobs = (struct WritePartialAssetFromBlocksJob*)Longtail_Alloc("WriteAssets", asset_jobs_size);
-    if (!asset_jobs)
+    size_t existing_lookup_size = Longtail_LookupTable_GetSize(existing_chunk_count);
+    void* existing_lookup_mem = Longtail_Alloc("AddExistingIndexAndWriteChunks", existing_lookup_size);
+    if (!existing_lookup_mem)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        Longtail_Free(block_jobs);
         return ENOMEM;
     }
-    for (uint32_t a = 0; a < awl->m_AssetJobCount; ++a)
+    struct Longtail_LookupTable* existing_lookup = Longtail_LookupTable_Create(existing_lookup_mem, existing_chunk_count, 0);
+    for (uint32_t e = 0; e < existing_chunk_count; ++e)
     {
-        Longtail_JobAPI_Jobs write_sync_job;
-        err = CreatePartialAssetWriteJob(
-            block_store_api,
-            version_storage_api,
-            job_api,
-            store_index,
-            version_index,
-            version_path,
-            chunk_hash_to_block_index,
-            awl->m_AssetIndexJobs[a],
-            retain_permssions,
-            job_group,
-            &asset_jobs[a],
-            0,
-            (Longtail_StorageAPI_HOpenFile)0,
-            &write_sync_job);
+        Longtail_LookupTable_PutUnique(existing_lookup, existing_store_index->m_ChunkHashes[e], e);
+    }
+
+    uint32_t window_chunk_count = (uint32_t)arrlen(c->m_WindowChunkIndexes);
+    arrsetlen(c->m_WindowChunkIsStored, window_chunk_count);
+    for (uint32_t w = 0; w < window_chunk_count; ++w)
+    {
+        uint32_t chunk_index = c->m_WindowChunkIndexes[w];
+        TLongtail_Hash chunk_hash = c->m_ChunkHashes[chunk_index];
+        int is_existing = Longtail_LookupTable_Get(existing_lookup, chunk_hash) != 0;
+        c->m_WindowChunkIsStored[w] = (uint8_t)is_existing;
+        if (!is_existing || (c->m_UsedChunkHashes && Longtail_LookupTable_Get(c->m_UsedChunkHashes, chunk_hash)))
+        {
+            continue;
+        }
+        uint32_t chunk_size = c->m_ChunkSizes[chunk_index];
+        size_t data_offset = arrlen(c->m_DeferredChunkData);
+        arrsetlen(c->m_DeferredChunkData, data_offset + chunk_size);
+        memcpy(&c->m_DeferredChunkData[data_offset], c->m_WindowChunkData[w], chunk_size);
+        arrpush(c->m_DeferredChunkIndexes, chunk_index);
+        arrpush(c->m_DeferredChunkAssetIndexes, c->m_WindowChunkAssetIndexes[w]);
+        arrpush(c->m_DeferredChunkDataOffsets, data_offset);
+    }
+    Longtail_Free(existing_lookup_mem);
+    return 0;
+}
+
+// Packs the chunks not flagged in @p chunk_is_stored into blocks, the chunks of an asset must be consecutive
+static int PackIndexAndWriteChunks(
+    struct IndexAndWriteContent* c,
+    uint32_t chunk_count,
+    const uint32_t* chunk_indexes,
+    const uint32_t* chunk_asset_indexes,
+    const uint8_t** chunk_data,
+    const uint8_t* chunk_is_stored,
+    const uint64_t* asset_sizes,
+    uint32_t target_chunk_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(c, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_indexes, "%p"),
+        LONGTAIL_LOGFIELD(chunk_asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(chunk_data, "%p"),
+        LONGTAIL_LOGFIELD(chunk_is_stored, "%p"),
+        LONGTAIL_LOGFIELD(asset_sizes, "%p"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    uint32_t packed_asset_index = 0xffffffffu;
+    for (uint32_t w = 0; w < chunk_count; ++w)
+    {
+        if (chunk_is_stored[w])
+        {
+            continue;
+        }
+        uint32_t chunk_index = chunk_indexes[w];
+        uint32_t asset_index = chunk_asset_indexes[w];
+        if (asset_index != packed_asset_index)
+        {
+            packed_asset_index = asset_index;
+            uint32_t asset_chunk_count = 0;
+            uint64_t asset_chunks_size = 0;
+            for (uint32_t aw = w; aw < chunk_count && chunk_asset_indexes[aw] == asset_index; ++aw)
+            {
+                if (chunk_is_stored[aw])
+                {
+                    continue;
+                }
+                ++asset_chunk_count;
+                asset_chunks_size += c->m_ChunkSizes[chunk_indexes[aw]];
+            }
+            if (ShouldCloseBlockForAsset((uint32_t)arrlen(c->m_BlockChunkIndexes), (uint64_t)arrlen(c->m_BlockData), asset_sizes[asset_index], target_chunk_size, asset_chunk_count, asset_chunks_size, c->m_MaxBlockSize, c->m_MaxChunksPerBlock))
+            {
+                int err = FlushIndexAndWriteBlock(c);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FlushIndexAndWriteBlock() failed with %d", err)
+                    return err;
+                }
+            }
+        }
+        int err = AddIndexAndWriteBlockChunk(c, chunk_index, chunk_data[w]);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreatePartialAssetWriteJob() failed with %d", err)
-            Longtail_Free(asset_jobs);
-            Longtail_Free(block_jobs);
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AddIndexAndWriteBlockChunk() failed with %d", err)
             return err;
         }
-        err = job_api->ReadyJobs(job_api, 1, write_sync_job);
-        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
     }
-
-    err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
-    if (err)
+    return 0;
+}
+
+// Called once all of the version is chunked, deferred chunks whose blocks now reach the minimum usage are
+// skipped and the rest are packed into new blocks
+static int PackDeferredIndexAndWriteChunks(
+    struct IndexAndWriteContent* c,
+    const uint64_t* asset_sizes,
+    uint32_t target_chunk_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(c, "%p"),
+        LONGTAIL_LOGFIELD(asset_sizes, "%p"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    uint32_t deferred_chunk_count = (uint32_t)arrlen(c->m_DeferredChunkIndexes);
+    if (deferred_chunk_count == 0)
+    {
+        return 0;
+    }
+
+    uint32_t existing_block_count = (uint32_t)arrlen(c->m_ExistingBlockIsUsed);
+    for (uint32_t b = 0; b < existing_block_count; ++b)
+    {
+        if (!c->m_ExistingBlockIsUsed[b] && IsExistingIndexAndWriteBlockUsed(c, b))
+        {
+            int err = UseExistingIndexAndWriteBlock(c, b);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "UseExistingIndexAndWriteBlock() failed with %d", err)
+                return err;
+            }
+        }
+    }
+
+    size_t work_mem_size =
+        sizeof(const uint8_t*) * deferred_chunk_count +
+        sizeof(uint8_t) * deferred_chunk_count;
+    void* work_mem = Longtail_Alloc("PackDeferredIndexAndWriteChunks", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    const uint8_t** chunk_data = (const uint8_t**)work_mem;
+    uint8_t* chunk_is_stored = (uint8_t*)&chunk_data[deferred_chunk_count];
+    for (uint32_t d = 0; d < deferred_chunk_count; ++d)
+    {
+        chunk_data[d] = &c->m_DeferredChunkData[c->m_DeferredChunkDataOffsets[d]];
+        TLongtail_Hash chunk_hash = c->m_ChunkHashes[c->m_DeferredChunkIndexes[d]];
+        chunk_is_stored[d] = (uint8_t)(c->m_UsedChunkHashes && Longtail_LookupTable_Get(c->m_UsedChunkHashes, chunk_hash));
+    }
+    int err = PackIndexAndWriteChunks(c, deferred_chunk_count, c->m_DeferredChunkIndexes, c->m_DeferredChunkAssetIndexes, chunk_data, chunk_is_stored, asset_sizes, target_chunk_size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PackIndexAndWriteChunks() failed with %d", err)
+    }
+    Longtail_Free(work_mem);
+    return err;
+}
+
+// Reserves and readies the hash jobs of the window starting at @p window_start, the window holds as many jobs as
+// fit in @p window_size but at least one
+static int StartIndexAndWriteWindow(
+    struct Longtail_JobAPI* job_api,
+    uint32_t job_count,
+    const struct HashJob* hash_jobs,
+    Longtail_JobAPI_JobFunc* funcs,
+    void** ctxs,
+    uint64_t window_size,
+    uint32_t window_start,
+    uint32_t* out_window_end,
+    Longtail_JobAPI_Group* out_job_group)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(job_count, "%u"),
+        LONGTAIL_LOGFIELD(hash_jobs, "%p"),
+        LONGTAIL_LOGFIELD(funcs, "%p"),
+        LONGTAIL_LOGFIELD(ctxs, "%p"),
+        LONGTAIL_LOGFIELD(window_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(window_start, "%u"),
+        LONGTAIL_LOGFIELD(out_window_end, "%p"),
+        LONGTAIL_LOGFIELD(out_job_group, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    uint32_t window_end = window_start + 1;
+    uint64_t window_bytes = hash_jobs[window_start].m_SizeRange;
+    while (window_end < job_count && (window_bytes + hash_jobs[window_end].m_SizeRange) <= window_size)
+    {
+        window_bytes += hash_jobs[window_end].m_SizeRange;
+        ++window_end;
+    }
+    uint32_t window_job_count = window_end - window_start;
+
+    Longtail_JobAPI_Group job_group = 0;
+    int err = job_api->ReserveJobs(job_api, window_job_count, &job_group);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+        return err;
+    }
+    Longtail_JobAPI_Jobs jobs;
+    err = job_api->CreateJobs(job_api, job_group, window_job_count, &funcs[window_start], &ctxs[window_start], &jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+    err = job_api->ReadyJobs(job_api, window_job_count, jobs);
+    LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+    *out_window_end = window_end;
+    *out_job_group = job_group;
+    return 0;
+}
+
+static void ClearIndexAndWriteWindow(struct IndexAndWriteContent* c)
+{
+    for (ptrdiff_t r = 0; r < arrlen(c->m_WindowRechunkedData); ++r)
+    {
+        Longtail_Free(c->m_WindowRechunkedData[r]);
+    }
+    arrsetlen(c->m_WindowRechunkedData, 0);
+    arrsetlen(c->m_WindowChunkIndexes, 0);
+    arrsetlen(c->m_WindowChunkAssetIndexes, 0);
+    arrsetlen(c->m_WindowChunkData, 0);
+    arrsetlen(c->m_WindowChunkIsStored, 0);
+}
+
+static void DisposeIndexAndWriteContent(struct IndexAndWriteContent* c)
+{
+    ClearIndexAndWriteWindow(c);
+    for (ptrdiff_t b = 0; b < arrlen(c->m_PendingBlocks); ++b)
+    {
+        c->m_PendingBlocks[b]->Dispose(c->m_PendingBlocks[b]);
+    }
+    for (ptrdiff_t b = 0; b < arrlen(c->m_WrittenBlockIndexes); ++b)
+    {
+        Longtail_Free(c->m_WrittenBlockIndexes[b]);
+    }
+    arrfree(c->m_WrittenBlockIndexes);
+    arrfree(c->m_PendingBlocks);
+    arrfree(c->m_DeferredChunkData);
+    arrfree(c->m_DeferredChunkDataOffsets);
+    arrfree(c->m_DeferredChunkAssetIndexes);
+    arrfree(c->m_DeferredChunkIndexes);
+    if (c->m_UsedChunkHashes)
+    {
+        Longtail_Free(c->m_UsedChunkHashes);
+    }
+    arrfree(c->m_ExistingChunkSizes);
+    arrfree(c->m_ExistingChunkHashes);
+    arrfree(c->m_ExistingBlockIsUsed);
+    arrfree(c->m_ExistingBlockChunkCounts);
+    arrfree(c->m_ExistingBlockChunkOffsets);
+    if (c->m_ExistingBlockHashToIndex)
+    {
+        Longtail_Free(c->m_ExistingBlockHashToIndex);
+    }
+    arrfree(c->m_BlockData);
+    arrfree(c->m_BlockChunkIndexes);
+    arrfree(c->m_WindowRechunkedData);
+    arrfree(c->m_WindowChunkIsStored);
+    arrfree(c->m_WindowChunkData);
+    arrfree(c->m_WindowChunkAssetIndexes);
+    arrfree(c->m_WindowChunkIndexes);
+    arrfree(c->m_ChunkTags);
+    arrfree(c->m_ChunkSizes);
+    arrfree(c->m_ChunkHashes);
+    Longtail_Free(c->m_ChunkHashToIndex);
+    arrfree(c->m_AssetChunkHashes);
+    arrfree(c->m_AssetChunkIndexes);
+}
+
+int Longtail_CreateVersionIndexAndWriteContent(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    struct Longtail_BlockStoreAPI* block_store_api,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* optional_asset_tags,
+    uint32_t target_chunk_size,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    uint32_t min_block_usage_percent,
+    struct Longtail_VersionIndex** out_version_index,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_tags, "%p"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(max_block_size, "%u"),
+        LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
+        LONGTAIL_LOGFIELD(min_block_usage_percent, "%u"),
+        LONGTAIL_LOGFIELD(out_version_index, "%p"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, root_path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, file_infos != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, target_chunk_size > 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, max_block_size > 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, max_chunks_per_block > 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_store_index != 0, return EINVAL)
+
+    uint32_t asset_count = file_infos->m_Count;
+    if (asset_count == 0)
+    {
+        struct Longtail_VersionIndex* version_index;
+        int err = Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, progress_api, optional_cancel_api, optional_cancel_token, root_path, file_infos, optional_asset_tags, target_chunk_size, &version_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateVersionIndex() failed with %d", err)
+            return err;
+        }
+        err = Longtail_CreateStoreIndexFromBlocks(0, 0, out_store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+            Longtail_Free(version_index);
+            return err;
+        }
+        *out_version_index = version_index;
+        return 0;
+    }
+
+    uint64_t max_hash_size = target_chunk_size * 1024;
+    uint64_t window_size = (uint64_t)max_block_size * INDEX_AND_WRITE_WINDOW_BLOCK_COUNT;
+    uint32_t job_count = 0;
+    for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
+    {
+        uint64_t asset_size = file_infos->m_Sizes[asset_index];
+        job_count += (uint32_t)(1 + (asset_size / max_hash_size));
+    }
+
+    size_t work_mem_size =
+        (sizeof(TLongtail_Hash) * asset_count) +
+        (sizeof(TLongtail_Hash) * asset_count) +
+        (sizeof(uint32_t) * asset_count) +
+        (sizeof(uint32_t) * asset_count) +
+        (sizeof(uint32_t) * job_count) +
+        (sizeof(struct HashJob) * job_count) +
+        (sizeof(Longtail_JobAPI_JobFunc) * job_count) +
+        (sizeof(void*) * job_count);
+    void* work_mem = Longtail_Alloc("CreateVersionIndexAndWriteContent", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    TLongtail_Hash* path_hashes = (TLongtail_Hash*)work_mem;
+    TLongtail_Hash* content_hashes = &path_hashes[asset_count];
+    uint32_t* asset_chunk_start_index = (uint32_t*)&content_hashes[asset_count];
+    uint32_t* asset_chunk_counts = &asset_chunk_start_index[asset_count];
+    uint32_t* job_chunk_counts = &asset_chunk_counts[asset_count];
+    struct HashJob* hash_jobs = (struct HashJob*)&job_chunk_counts[job_count];
+    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)&hash_jobs[job_count];
+    void** ctxs = (void**)&funcs[job_count];
+
+    uint32_t job_index = 0;
+    for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
+    {
+        uint64_t asset_size = file_infos->m_Sizes[asset_index];
+        uint64_t asset_part_count = 1 + (asset_size / max_hash_size);
+        for (uint64_t job_part = 0; job_part < asset_part_count; ++job_part)
+        {
+            uint64_t range_start = job_part * max_hash_size;
+            uint64_t job_size = (asset_size - range_start) > max_hash_size ? max_hash_size : (asset_size - range_start);
+
+            struct HashJob* job = &hash_jobs[job_index];
+            job->m_StorageAPI = storage_api;
+            job->m_HashAPI = hash_api;
+            job->m_ChunkerAPI = chunker_api;
+            job->m_RootPath = root_path;
+            job->m_Path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[asset_index]];
+            job->m_PathHash = (job_part == 0) ? &path_hashes[asset_index] : 0;
+            job->m_AssetIndex = asset_index;
+            job->m_StartRange = range_start;
+            job->m_SizeRange = job_size;
+            job->m_AssetSize = asset_size;
+            job->m_AssetChunkCount = &job_chunk_counts[job_index];
+            job->m_ChunkHashes = 0;
+            job->m_ChunkSizes = 0;
+            job->m_ChunkData = 0;
+            job->m_TargetChunkSize = target_chunk_size;
+            job->m_RetainChunkData = 1;
+            job->m_Err = EINVAL;
+            funcs[job_index] = DynamicChunking;
+            ctxs[job_index] = job;
+            ++job_index;
+        }
+    }
+
+    struct IndexAndWriteContent c;
+    memset(&c, 0, sizeof(c));
+    c.m_HashAPI = hash_api;
+    c.m_MaxBlockSize = max_block_size;
+    c.m_MaxChunksPerBlock = max_chunks_per_block;
+    c.m_MinBlockUsagePercent = min_block_usage_percent;
+    uint32_t initial_chunk_capacity = 1024;
+    void* chunk_lookup_mem = Longtail_Alloc("CreateVersionIndexAndWriteContent", Longtail_LookupTable_GetSize(initial_chunk_capacity));
+    if (!chunk_lookup_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(work_mem);
+        return ENOMEM;
+    }
+    c.m_ChunkHashToIndex = Longtail_LookupTable_Create(chunk_lookup_mem, initial_chunk_capacity, 0);
+
+    struct AssetStitcher stitcher;
+    InitAssetStitcher(&stitcher, storage_api, hash_api, chunker_api, root_path, target_chunk_size, 0);
+
+    Longtail_JobAPI_Group job_group = 0;
+    uint32_t window_start = 0;
+    uint32_t window_end = 0;
+    int err = StartIndexAndWriteWindow(job_api, job_count, hash_jobs, funcs, ctxs, window_size, window_start, &window_end, &job_group);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "StartIndexAndWriteWindow() failed with %d", err)
+    }
+    while (window_start < job_count && !err)
+    {
+        err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
+        job_group = 0;
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        }
+
+        for (uint32_t j = window_start; j < window_end && !err; ++j)
+        {
+            if (hash_jobs[j].m_Err)
+            {
+                LONGTAIL_LOG(ctx, (hash_jobs[j].m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "hash_jobs[j].m_Err failed with %d", hash_jobs[j].m_Err)
+                err = hash_jobs[j].m_Err;
+            }
+        }
+
+        // Hash the next window while the chunks of this window are queried and written to the block store
+        uint32_t next_window_end = window_end;
+        if (!err && window_end < job_count)
+        {
+            err = StartIndexAndWriteWindow(job_api, job_count, hash_jobs, funcs, ctxs, window_size, window_end, &next_window_end, &job_group);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "StartIndexAndWriteWindow() failed with %d", err)
+            }
+        }
+
+        for (uint32_t j = window_start; j < window_end && !err; ++j)
+        {
+            const struct HashJob* job = &hash_jobs[j];
+            uint32_t asset_index = job->m_AssetIndex;
+            if (job->m_StartRange == 0)
+            {
+                InitAssetStitcher(&stitcher, storage_api, hash_api, chunker_api, root_path, target_chunk_size, job->m_AssetSize);
+                asset_chunk_start_index[asset_index] = (uint32_t)arrlen(c.m_AssetChunkIndexes);
+                c.m_AssetIndex = asset_index;
+                c.m_AssetTag = optional_asset_tags ? optional_asset_tags[asset_index] : 0;
+            }
+            err = StitchAssetPart(&stitcher, job, AddIndexAndWriteChunk, &c);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "StitchAssetPart() failed with %d", err)
+                break;
+            }
+            int is_last_part = (j + 1 == job_count) || (hash_jobs[j + 1].m_AssetIndex != asset_index);
+            if (is_last_part)
+            {
+                LONGTAIL_FATAL_ASSERT(ctx, stitcher.m_Pos == job->m_AssetSize, err = EINVAL; break)
+                DisposeAssetStitcher(&stitcher);
+                uint32_t chunk_start_index = asset_chunk_start_index[asset_index];
+                asset_chunk_counts[asset_index] = (uint32_t)arrlen(c.m_AssetChunkIndexes) - chunk_start_index;
+                err = hash_api->HashBuffer(hash_api, (uint32_t)(sizeof(TLongtail_Hash) * asset_chunk_counts[asset_index]), &c.m_AssetChunkHashes[chunk_start_index], &content_hashes[asset_index]);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_api->HashBuffer() failed with %d", err)
+                    break;
+                }
+            }
+        }
+
+        uint32_t window_chunk_count = (uint32_t)arrlen(c.m_WindowChunkIndexes);
+        if (!err && window_chunk_count > 0)
+        {
+            // Chunks already in the store are skipped, same as Longtail_CreateMissingContent() does. The store is
+            // queried without a minimum block usage and the usage is evaluated against the whole version instead
+            struct Longtail_StoreIndex* existing_store_index;
+            err = GetExistingIndexAndWriteChunks(&c, block_store_api, job_api, optional_cancel_api, optional_cancel_token, min_block_usage_percent > 100 ? min_block_usage_percent : 0, &existing_store_index);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "GetExistingIndexAndWriteChunks() failed with %d", err)
+            }
+            else
+            {
+                err = AddExistingIndexAndWriteChunks(&c, existing_store_index);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AddExistingIndexAndWriteChunks() failed with %d", err)
+                }
+                else
+                {
+                    err = PackIndexAndWriteChunks(&c, window_chunk_count, c.m_WindowChunkIndexes, c.m_WindowChunkAssetIndexes, c.m_WindowChunkData, c.m_WindowChunkIsStored, file_infos->m_Sizes, target_chunk_size);
+                    if (err)
+                    {
+                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PackIndexAndWriteChunks() failed with %d", err)
+                    }
+                }
+                Longtail_Free(existing_store_index);
+            }
+        }
+
+        for (uint32_t j = window_start; j < window_end; ++j)
+        {
+            Longtail_Free(hash_jobs[j].m_ChunkHashes);
+            hash_jobs[j].m_ChunkHashes = 0;
+            Longtail_Free(hash_jobs[j].m_ChunkData);
+            hash_jobs[j].m_ChunkData = 0;
+        }
+        ClearIndexAndWriteWindow(&c);
+
+        if (!err)
+        {
+            err = WritePendingIndexAndWriteBlocks(&c, block_store_api, job_api, optional_cancel_api, optional_cancel_token);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WritePendingIndexAndWriteBlocks() failed with %d", err)
+            }
+        }
+        window_start = window_end;
+        window_end = next_window_end;
+    }
+    if (job_group)
+    {
+        // The hash jobs of the next window must be done before their chunk data is released
+        job_api->WaitForAllJobs(job_api, job_group, 0, optional_cancel_api, optional_cancel_token);
+    }
+
+    DisposeAssetStitcher(&stitcher);
+
+    if (!err)
+    {
+        err = PackDeferredIndexAndWriteChunks(&c, file_infos->m_Sizes, target_chunk_size);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PackDeferredIndexAndWriteChunks() failed with %d", err)
+        }
+    }
+
+    if (!err)
+    {
+        err = FlushIndexAndWriteBlock(&c);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FlushIndexAndWriteBlock() failed with %d", err)
+        }
+    }
+    if (!err)
+    {
+        err = WritePendingIndexAndWriteBlocks(&c, block_store_api, job_api, optional_cancel_api, optional_cancel_token);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WritePendingIndexAndWriteBlocks() failed with %d", err)
+        }
+    }
+
+    if (err)
+    {
+        for (uint32_t j = 0; j < job_count; ++j)
+        {
+            Longtail_Free(hash_jobs[j].m_ChunkHashes);
+            Longtail_Free(hash_jobs[j].m_ChunkData);
+        }
+        DisposeIndexAndWriteContent(&c);
+        Longtail_Free(work_mem);
+        return err;
+    }
+
+    uint32_t asset_chunk_index_count = (uint32_t)arrlen(c.m_AssetChunkIndexes);
+    uint32_t unique_chunk_count = (uint32_t)arrlen(c.m_ChunkHashes);
+    size_t version_index_size = Longtail_GetVersionIndexSize(asset_count, unique_chunk_count, asset_chunk_index_count, file_infos->m_PathDataSize);
+    void* version_index_mem = Longtail_Alloc("CreateVersionIndexAndWriteContent", version_index_size);
+    if (!version_index_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        DisposeIndexAndWriteContent(&c);
+        Longtail_Free(work_mem);
+        return ENOMEM;
+    }
+
+    struct Longtail_VersionIndex* version_index;
+    err = Longtail_BuildVersionIndex(
+        version_index_mem,
+        version_index_size,
+        file_infos,
+        path_hashes,
+        content_hashes,
+        asset_chunk_start_index,
+        asset_chunk_counts,
+        asset_chunk_index_count,
+        c.m_AssetChunkIndexes,
+        unique_chunk_count,
+        c.m_ChunkSizes,
+        c.m_ChunkHashes,
+        c.m_ChunkTags,
+        hash_api->GetIdentifier(hash_api),
+        target_chunk_size,
+        &version_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndex() failed with %d", err)
+        Longtail_Free(version_index_mem);
+        DisposeIndexAndWriteContent(&c);
+        Longtail_Free(work_mem);
+        return err;
+    }
+
+    err = Longtail_CreateStoreIndexFromBlocks(
+        (uint32_t)arrlen(c.m_WrittenBlockIndexes),
+        (const struct Longtail_BlockIndex**)c.m_WrittenBlockIndexes,
+        out_store_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+        Longtail_Free(version_index);
+        DisposeIndexAndWriteContent(&c);
+        Longtail_Free(work_mem);
+        return err;
+    }
+
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Indexed %u chunks, wrote %u blocks", unique_chunk_count, (uint32_t)arrlen(c.m_WrittenBlockIndexes))
+
+    DisposeIndexAndWriteContent(&c);
+    Longtail_Free(work_mem);
+
+    *out_version_index = version_index;
+    return 0;
+}
+
+struct BlockReaderJob
+{
+    struct Longtail_AsyncGetStoredBlockAPI m_AsyncCompleteAPI;
+    struct Longtail_BlockStoreAPI* m_BlockStoreAPI;
+    struct Longtail_JobAPI* m_JobAPI;
+    uint32_t m_JobID;
+    TLongtail_Hash m_BlockHash;
+    const TLongtail_Hash* m_ChunkHashes;
+    uint32_t m_ChunkCount;
+    struct Longtail_StoredBlock* m_StoredBlock;
+    int m_Err;
+};
+
+void BlockReaderJobOnComplete(struct Longtail_AsyncGetStoredBlockAPI* async_complete_api, struct Longtail_StoredBlock* stored_block, int err)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(async_complete_api, "%p"),
+        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(err, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BlockReaderJobOnComplete() failed with %d", err)
+    }
+    LONGTAIL_FATAL_ASSERT(ctx, async_complete_api != 0, return)
+    struct BlockReaderJob* job = (struct BlockReaderJob*)async_complete_api;
+    LONGTAIL_FATAL_ASSERT(ctx, job->m_AsyncCompleteAPI.OnComplete != 0, return);
+    job->m_Err = err;
+    job->m_StoredBlock = stored_block;
+    job->m_JobAPI->ResumeJob(job->m_JobAPI, job->m_JobID);
+}
+
+static int BlockReader(void* context, uint32_t job_id, int is_cancelled)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
+
+    struct BlockReaderJob* job = (struct BlockReaderJob*)context;
+
+    if (job->m_AsyncCompleteAPI.OnComplete)
+    {
+        // We got a notification so we are complete
+        job->m_AsyncCompleteAPI.OnComplete = 0;
+        return 0;
+    }
+
+    if (is_cancelled)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "BlockReader was cancelled, failed with %d", ECANCELED)
+        job->m_Err = ECANCELED;
+        return 0;
+    }
+
+    job->m_JobID = job_id;
+    job->m_StoredBlock = 0;
+    job->m_AsyncCompleteAPI.OnComplete = BlockReaderJobOnComplete;
+    
+    int err = job->m_ChunkCount > 0 ?
+        Longtail_BlockStore_GetStoredBlockChunks(job->m_BlockStoreAPI, job->m_BlockHash, job->m_ChunkCount, job->m_ChunkHashes, &job->m_AsyncCompleteAPI) :
+        job->m_BlockStoreAPI->GetStoredBlock(job->m_BlockStoreAPI, job->m_BlockHash, &job->m_AsyncCompleteAPI);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "Getting stored block failed with %d", err)
+        job->m_Err = err;
+        return 0;
+    }
+    return EBUSY;
+}
+
+static int WriteReady(void* context, uint32_t job_id, int is_cancelled)
+{
+    // Nothing to do here, we are just a syncronization point
+    return 0;
+}
+
+// Progress journal for Longtail_WriteVersion and Longtail_ChangeVersion.
+// The journal holds a header followed by one record slot for each asset that is moved or written, slots are
+// preallocated so jobs can record a completed asset with a single write at the slot offset without any locking,
+// which relies on StorageAPI::Write at an offset being safe to call for the same file from several jobs.
+// An empty slot (zero path hash) or a torn record does not match any asset and is ignored when the
+// journal is read back.
+#define WRITE_JOURNAL_MAGIC     0x4c544a4eu
+#define WRITE_JOURNAL_VERSION   1u
+#define WRITE_JOURNAL_NO_SLOT   0xffffffffu
+
+struct WriteJournalHeader
+{
+    uint32_t m_Magic;
+    uint32_t m_Version;
+};
+
+struct WriteJournalRecord
+{
+    TLongtail_Hash m_PathHash;
+    TLongtail_Hash m_ContentHash;
+    uint64_t m_AssetSize;
+};
+
+struct WriteJournal
+{
+    struct Longtail_StorageAPI* m_StorageAPI;
+    const struct Longtail_VersionIndex* m_VersionIndex;
+    char* m_Path;
+    Longtail_StorageAPI_HOpenFile m_File;
+    uint32_t* m_AssetSlots;
+    uint8_t* m_IsCompleted;
+    uint32_t m_CompletedCount;
+    int m_IsResumed;
+};
+
+// The journal is kept outside version_path so it is never scanned or removed as an asset of the version
+static int IsPathInFolder(const char* folder_path, const char* path)
+{
+    size_t folder_length = strlen(folder_path);
+    if (folder_length > 0 && folder_path[folder_length - 1] == '/')
+    {
+        --folder_length;
+    }
+    return strncmp(path, folder_path, folder_length) == 0 && (path[folder_length] == '\0' || path[folder_length] == '/');
+}
+
+// Checks that a journaled asset is still present in version_path with the expected size
+static int IsJournaledAssetValid(
+    struct Longtail_StorageAPI* version_storage_api,
+    const struct Longtail_VersionIndex* version_index,
+    const char* version_path,
+    uint32_t asset_index)
+{
+    const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[asset_index]];
+    char* full_asset_path = version_storage_api->ConcatPath(version_storage_api, version_path, asset_path);
+    if (!full_asset_path)
+    {
+        return 0;
+    }
+    if (IsDirPath(full_asset_path))
+    {
+        full_asset_path[strlen(full_asset_path) - 1] = '\0';
+        int is_dir = version_storage_api->IsDir(version_storage_api, full_asset_path);
+        Longtail_Free(full_asset_path);
+        return is_dir;
+    }
+    Longtail_StorageAPI_HOpenFile f;
+    int err = version_storage_api->OpenReadFile(version_storage_api, full_asset_path, &f);
+    Longtail_Free(full_asset_path);
+    if (err)
+    {
+        return 0;
+    }
+    uint64_t size = 0;
+    err = version_storage_api->GetSize(version_storage_api, f, &size);
+    version_storage_api->CloseFile(version_storage_api, f);
+    return (err == 0) && (size == version_index->m_AssetSizes[asset_index]);
+}
+
+// Reads the journal at journal_path if there is one and marks the assets of version_index in version_path
+// that an earlier run completed. Records that don't match version_index or the files on disk are dropped.
+static int OpenWriteJournal(
+    struct Longtail_StorageAPI* version_storage_api,
+    const struct Longtail_VersionIndex* version_index,
+    const char* version_path,
+    const char* journal_path,
+    struct WriteJournal** out_journal)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(journal_path, "%s"),
+        LONGTAIL_LOGFIELD(out_journal, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, version_storage_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_path != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, journal_path != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, out_journal != 0, return EINVAL)
+
+    uint32_t asset_count = *version_index->m_AssetCount;
+    size_t journal_size = sizeof(struct WriteJournal) +
+        sizeof(uint32_t) * asset_count +
+        sizeof(uint8_t) * asset_count;
+    struct WriteJournal* journal = (struct WriteJournal*)Longtail_Alloc("OpenWriteJournal", journal_size);
+    if (!journal)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    journal->m_StorageAPI = version_storage_api;
+    journal->m_VersionIndex = version_index;
+    journal->m_Path = Longtail_Strdup(journal_path);
+    journal->m_File = 0;
+    journal->m_AssetSlots = (uint32_t*)(void*)&journal[1];
+    journal->m_IsCompleted = (uint8_t*)(void*)&journal->m_AssetSlots[asset_count];
+    journal->m_CompletedCount = 0;
+    journal->m_IsResumed = 0;
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        journal->m_AssetSlots[a] = WRITE_JOURNAL_NO_SLOT;
+    }
+    memset(journal->m_IsCompleted, 0, sizeof(uint8_t) * asset_count);
+    if (!journal->m_Path)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Strdup() failed with %d", ENOMEM)
+        Longtail_Free(journal);
+        return ENOMEM;
+    }
+
+    if (!version_storage_api->IsFile(version_storage_api, journal->m_Path))
+    {
+        *out_journal = journal;
+        return 0;
+    }
+
+    Longtail_StorageAPI_HOpenFile f;
+    int err = version_storage_api->OpenReadFile(version_storage_api, journal->m_Path, &f);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->OpenReadFile() failed with %d", err)
+        Longtail_Free(journal->m_Path);
+        Longtail_Free(journal);
+        return err;
+    }
+    uint64_t size = 0;
+    err = version_storage_api->GetSize(version_storage_api, f, &size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetSize() failed with %d", err)
+        version_storage_api->CloseFile(version_storage_api, f);
+        Longtail_Free(journal->m_Path);
+        Longtail_Free(journal);
+        return err;
+    }
+    if (size < sizeof(struct WriteJournalHeader))
+    {
+        version_storage_api->CloseFile(version_storage_api, f);
+        *out_journal = journal;
+        return 0;
+    }
+
+    uint64_t record_count = (size - sizeof(struct WriteJournalHeader)) / sizeof(struct WriteJournalRecord);
+    size_t work_mem_size = Longtail_LookupTable_GetSize(asset_count) +
+        sizeof(struct WriteJournalHeader) +
+        sizeof(struct WriteJournalRecord) * (size_t)record_count;
+    void* work_mem = Longtail_Alloc("OpenWriteJournal", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        version_storage_api->CloseFile(version_storage_api, f);
+        Longtail_Free(journal->m_Path);
+        Longtail_Free(journal);
+        return ENOMEM;
+    }
+    struct Longtail_LookupTable* path_hash_to_asset_index = Longtail_LookupTable_Create(work_mem, asset_count, 0);
+    struct WriteJournalHeader* header = (struct WriteJournalHeader*)(void*)&((char*)work_mem)[Longtail_LookupTable_GetSize(asset_count)];
+    struct WriteJournalRecord* records = (struct WriteJournalRecord*)(void*)&header[1];
+
+    err = version_storage_api->Read(version_storage_api, f, 0, sizeof(struct WriteJournalHeader) + sizeof(struct WriteJournalRecord) * record_count, header);
+    version_storage_api->CloseFile(version_storage_api, f);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->Read() failed with %d", err)
+        Longtail_Free(work_mem);
+        Longtail_Free(journal->m_Path);
+        Longtail_Free(journal);
+        return err;
+    }
+    if (header->m_Magic != WRITE_JOURNAL_MAGIC || header->m_Version != WRITE_JOURNAL_VERSION)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Ignoring journal `%s` with unknown format", journal->m_Path)
+        Longtail_Free(work_mem);
+        *out_journal = journal;
+        return 0;
+    }
+
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        Longtail_LookupTable_PutUnique(path_hash_to_asset_index, version_index->m_PathHashes[a], a);
+    }
+    for (uint64_t r = 0; r < record_count; ++r)
+    {
+        const struct WriteJournalRecord* record = &records[r];
+        const uint32_t* asset_index_ptr = Longtail_LookupTable_Get(path_hash_to_asset_index, record->m_PathHash);
+        if (!asset_index_ptr)
+        {
+            continue;
+        }
+        uint32_t asset_index = *asset_index_ptr;
+        if (journal->m_IsCompleted[asset_index] ||
+            record->m_ContentHash != version_index->m_ContentHashes[asset_index] ||
+            record->m_AssetSize != version_index->m_AssetSizes[asset_index])
+        {
+            continue;
+        }
+        if (!IsJournaledAssetValid(version_storage_api, version_index, version_path, asset_index))
+        {
+            continue;
+        }
+        journal->m_IsCompleted[asset_index] = 1;
+        ++journal->m_CompletedCount;
+    }
+    Longtail_Free(work_mem);
+
+    journal->m_IsResumed = 1;
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Resuming from journal `%s`, %u of %u assets are already written", journal->m_Path, journal->m_CompletedCount, asset_count)
+    *out_journal = journal;
+    return 0;
+}
+
+// Rewrites the journal with the completed assets followed by one empty slot for each of the pending assets
+static int StartWriteJournal(
+    struct WriteJournal* journal,
+    uint32_t pending_count,
+    const uint32_t* pending_asset_indexes)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(journal, "%p"),
+        LONGTAIL_LOGFIELD(pending_count, "%u"),
+        LONGTAIL_LOGFIELD(pending_asset_indexes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, journal != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, journal->m_File == 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, pending_count == 0 || pending_asset_indexes != 0, return EINVAL)
+
+    const struct Longtail_VersionIndex* version_index = journal->m_VersionIndex;
+    uint32_t asset_count = *version_index->m_AssetCount;
+    uint64_t record_count = (uint64_t)journal->m_CompletedCount + pending_count;
+    size_t journal_data_size = sizeof(struct WriteJournalHeader) + sizeof(struct WriteJournalRecord) * (size_t)record_count;
+    struct WriteJournalHeader* header = (struct WriteJournalHeader*)Longtail_Alloc("StartWriteJournal", journal_data_size);
+    if (!header)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    memset(header, 0, journal_data_size);
+    header->m_Magic = WRITE_JOURNAL_MAGIC;
+    header->m_Version = WRITE_JOURNAL_VERSION;
+    struct WriteJournalRecord* records = (struct WriteJournalRecord*)(void*)&header[1];
+    uint32_t slot = 0;
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        if (!journal->m_IsCompleted[a])
+        {
+            continue;
+        }
+        records[slot].m_PathHash = version_index->m_PathHashes[a];
+        records[slot].m_ContentHash = version_index->m_ContentHashes[a];
+        records[slot].m_AssetSize = version_index->m_AssetSizes[a];
+        ++slot;
+    }
+    for (uint32_t p = 0; p < pending_count; ++p)
+    {
+        journal->m_AssetSlots[pending_asset_indexes[p]] = slot++;
+    }
+
+    int err = EnsureParentPathExists(journal->m_StorageAPI, journal->m_Path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+        Longtail_Free(header);
+        return err;
+    }
+    err = journal->m_StorageAPI->OpenWriteFile(journal->m_StorageAPI, journal->m_Path, 0, &journal->m_File);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "journal->m_StorageAPI->OpenWriteFile() failed with %d", err)
+        Longtail_Free(header);
+        return err;
+    }
+    err = journal->m_StorageAPI->Write(journal->m_StorageAPI, journal->m_File, 0, journal_data_size, header);
+    err = err ? err : journal->m_StorageAPI->SetSize(journal->m_StorageAPI, journal->m_File, journal_data_size);
+    Longtail_Free(header);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to write journal `%s`, failed with %d", journal->m_Path, err)
+        journal->m_StorageAPI->CloseFile(journal->m_StorageAPI, journal->m_File);
+        journal->m_File = 0;
+        return err;
+    }
+    return 0;
+}
+
+// Records that asset_index is completely written, safe to call from multiple jobs at once
+static void WriteJournalAsset(
+    struct WriteJournal* optional_journal,
+    uint32_t asset_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(optional_journal, "%p"),
+        LONGTAIL_LOGFIELD(asset_index, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    if (!optional_journal || !optional_journal->m_File)
+    {
+        return;
+    }
+    uint32_t slot = optional_journal->m_AssetSlots[asset_index];
+    if (slot == WRITE_JOURNAL_NO_SLOT)
+    {
+        return;
+    }
+    const struct Longtail_VersionIndex* version_index = optional_journal->m_VersionIndex;
+    struct WriteJournalRecord record;
+    record.m_PathHash = version_index->m_PathHashes[asset_index];
+    record.m_ContentHash = version_index->m_ContentHashes[asset_index];
+    record.m_AssetSize = version_index->m_AssetSizes[asset_index];
+    uint64_t offset = sizeof(struct WriteJournalHeader) + sizeof(struct WriteJournalRecord) * (uint64_t)slot;
+    int err = optional_journal->m_StorageAPI->Write(optional_journal->m_StorageAPI, optional_journal->m_File, offset, sizeof(struct WriteJournalRecord), &record);
+    if (err)
+    {
+        // A missing record only means the asset is written again if the operation is resumed
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to record asset in journal `%s`, failed with %d", optional_journal->m_Path, err)
+    }
+}
+
+// Closes the journal, the journal file is removed when the operation has completed
+static void CloseWriteJournal(
+    struct WriteJournal* journal,
+    int is_complete)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(journal, "%p"),
+        LONGTAIL_LOGFIELD(is_complete, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    if (!journal)
+    {
+        return;
+    }
+    if (journal->m_File)
+    {
+        journal->m_StorageAPI->CloseFile(journal->m_StorageAPI, journal->m_File);
+        journal->m_File = 0;
+    }
+    if (is_complete && journal->m_StorageAPI->IsFile(journal->m_StorageAPI, journal->m_Path))
+    {
+        int err = journal->m_StorageAPI->RemoveFile(journal->m_StorageAPI, journal->m_Path);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "journal->m_StorageAPI->RemoveFile() failed with %d", err)
+        }
+    }
+    Longtail_Free(journal->m_Path);
+    Longtail_Free(journal);
+}
+
+#define MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE  64u
+
+struct WritePartialAssetFromBlocksJob
+{
+    struct Longtail_StorageAPI* m_VersionStorageAPI;
+    struct Longtail_BlockStoreAPI* m_BlockStoreAPI;
+    struct Longtail_JobAPI* m_JobAPI;
+    const struct Longtail_StoreIndex* m_StoreIndex;
+    const struct Longtail_VersionIndex* m_VersionIndex;
+    const char* m_VersionFolder;
+    struct Longtail_LookupTable* m_ChunkHashToBlockIndex;
+    uint32_t m_AssetIndex;
+    int m_RetainPermissions;
+    struct WriteJournal* m_Journal;
+
+    Longtail_JobAPI_Group m_JobGroup;
+    struct BlockReaderJob m_BlockReaderJobs[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+    uint32_t m_BlockReaderJobCount;
+    TLongtail_Hash* m_BlockChunkHashes;
+
+    uint32_t m_AssetChunkIndexOffset;
+    uint32_t m_AssetChunkCount;
+
+    Longtail_StorageAPI_HOpenFile m_AssetOutputFile;
+
+    int m_Err;
+};
+
+int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled);
+
+// Returns the write sync task, or the write task if there is no need for reading new blocks
+static int CreatePartialAssetWriteJob(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_JobAPI* job_api,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    const char* version_folder,
+    struct Longtail_LookupTable* chunk_hash_to_block_index,
+    uint32_t asset_index,
+    int retain_permissions,
+    struct WriteJournal* optional_journal,
+    Longtail_JobAPI_Group job_group,
+    struct WritePartialAssetFromBlocksJob* job,
+    uint32_t asset_chunk_index_offset,
+    Longtail_StorageAPI_HOpenFile asset_output_file,
+    Longtail_JobAPI_Jobs* out_jobs)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(version_folder, "%s"),
+        LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
+        LONGTAIL_LOGFIELD(asset_index, "%u"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d"),
+        LONGTAIL_LOGFIELD(optional_journal, "%p"),
+        LONGTAIL_LOGFIELD(job_group, "%p"),
+        LONGTAIL_LOGFIELD(job, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_index_offset, "%u"),
+        LONGTAIL_LOGFIELD(asset_output_file, "%p"),
+        LONGTAIL_LOGFIELD(out_jobs, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, block_store_api !=0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_storage_api !=0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, job_api !=0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, store_index !=0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_index !=0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_folder !=0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, chunk_hash_to_block_index !=0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, asset_index < *version_index->m_AssetCount, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, job !=0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, out_jobs !=0, return EINVAL)
+
+    job->m_VersionStorageAPI = version_storage_api;
+    job->m_BlockStoreAPI = block_store_api;
+    job->m_JobAPI = job_api;
+    job->m_StoreIndex = store_index;
+    job->m_VersionIndex = version_index;
+    job->m_VersionFolder = version_folder;
+    job->m_ChunkHashToBlockIndex = chunk_hash_to_block_index;
+    job->m_AssetIndex = asset_index;
+    job->m_JobGroup = job_group;
+    job->m_RetainPermissions = retain_permissions;
+    job->m_Journal = optional_journal;
+    job->m_BlockReaderJobCount = 0;
+    job->m_BlockChunkHashes = 0;
+    job->m_AssetChunkIndexOffset = asset_chunk_index_offset;
+    job->m_AssetChunkCount = 0;
+    job->m_AssetOutputFile = asset_output_file;
+    job->m_Err = EINVAL;
+
+    uint32_t chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
+    uint32_t chunk_start_index_offset = chunk_index_start + asset_chunk_index_offset;
+    uint32_t chunk_index_end = chunk_index_start + version_index->m_AssetChunkCounts[asset_index];
+    uint32_t chunk_index_offset = chunk_start_index_offset;
+
+    Longtail_JobAPI_JobFunc block_read_funcs[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+    void* block_read_ctx[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+
+    const uint32_t worker_count = job_api->GetWorkerCount(job_api) + 1;
+    const uint32_t max_parallell_block_read_jobs = worker_count < MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE ? worker_count : MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE;
+
+    while (chunk_index_offset != chunk_index_end && job->m_BlockReaderJobCount <= max_parallell_block_read_jobs)
+    {
+        uint32_t chunk_index = version_index->m_AssetChunkIndexes[chunk_index_offset];
+        TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+        const uint32_t* block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
+        LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
+        uint32_t block_index = *block_index_ptr;
+        TLongtail_Hash block_hash = store_index->m_BlockHashes[block_index];
+        int has_block = 0;
+        for (uint32_t d = 0; d < job->m_BlockReaderJobCount; ++d)
+        {
+            if (job->m_BlockReaderJobs[d].m_BlockHash == block_hash)
+            {
+                has_block = 1;
+                break;
+            }
+        }
+        if (!has_block)
+        {
+            if (job->m_BlockReaderJobCount == max_parallell_block_read_jobs)
+            {
+                break;
+            }
+            struct BlockReaderJob* block_job = &job->m_BlockReaderJobs[job->m_BlockReaderJobCount];
+            block_job->m_BlockStoreAPI = block_store_api;
+            block_job->m_BlockHash = block_hash;
+            block_job->m_ChunkHashes = 0;
+            block_job->m_ChunkCount = 0;
+            block_job->m_AsyncCompleteAPI.m_API.Dispose = 0;
+            block_job->m_AsyncCompleteAPI.OnComplete = 0;
+            block_job->m_JobAPI = job_api;
+            block_job->m_JobID = 0;
+            block_job->m_Err = EINVAL;
+            block_job->m_StoredBlock = 0;
+            block_read_funcs[job->m_BlockReaderJobCount] = BlockReader;
+            block_read_ctx[job->m_BlockReaderJobCount] = block_job;
+            ++job->m_BlockReaderJobCount;
+        }
+        ++job->m_AssetChunkCount;
+        ++chunk_index_offset;
+    }
+
+    // Tell each block reader which chunks this part of the asset needs so the block store can skip decoding the rest of the block
+    if (job->m_BlockReaderJobCount > 0)
+    {
+        job->m_BlockChunkHashes = (TLongtail_Hash*)Longtail_Alloc("CreatePartialAssetWriteJob", sizeof(TLongtail_Hash) * job->m_AssetChunkCount);
+        if (!job->m_BlockChunkHashes)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
+        for (uint32_t pass = 0; pass < 2; ++pass)
+        {
+            // The first pass counts the chunks of each block, the second pass places the hashes grouped by block
+            for (uint32_t c = chunk_start_index_offset; c < chunk_start_index_offset + job->m_AssetChunkCount; ++c)
+            {
+                TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[c]];
+                TLongtail_Hash block_hash = store_index->m_BlockHashes[*Longtail_LookupTable_Get(chunk_hash_to_block_index, chunk_hash)];
+                uint32_t d = 0;
+                while (job->m_BlockReaderJobs[d].m_BlockHash != block_hash)
+                {
+                    ++d;
+                }
+                struct BlockReaderJob* block_job = &job->m_BlockReaderJobs[d];
+                if (pass == 1)
+                {
+                    ((TLongtail_Hash*)block_job->m_ChunkHashes)[block_job->m_ChunkCount] = chunk_hash;
+                }
+                ++block_job->m_ChunkCount;
+            }
+            uint32_t block_chunk_offset = 0;
+            for (uint32_t d = 0; d < job->m_BlockReaderJobCount; ++d)
+            {
+                job->m_BlockReaderJobs[d].m_ChunkHashes = &job->m_BlockChunkHashes[block_chunk_offset];
+                block_chunk_offset += job->m_BlockReaderJobs[d].m_ChunkCount;
+                job->m_BlockReaderJobs[d].m_ChunkCount = pass == 0 ? 0 : job->m_BlockReaderJobs[d].m_ChunkCount;
+            }
+        }
+    }
+
+    Longtail_JobAPI_JobFunc write_funcs[1] = { WritePartialAssetFromBlocks };
+    void* write_ctx[1] = { job };
+    Longtail_JobAPI_Jobs write_job;
+    int err = job_api->CreateJobs(job_api, job_group, 1, write_funcs, write_ctx, &write_job);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->CreateJobs() failed with %d", err)
+        if (job->m_BlockChunkHashes)
+        {
+            Longtail_Free(job->m_BlockChunkHashes);
+            job->m_BlockChunkHashes = 0;
+        }
+        return err;
+    }
+
+    if (job->m_BlockReaderJobCount > 0)
+    {
+        Longtail_JobAPI_Jobs block_read_jobs;
+        err = job_api->CreateJobs(job_api, job_group, job->m_BlockReaderJobCount, block_read_funcs, block_read_ctx, &block_read_jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+        Longtail_JobAPI_JobFunc sync_write_funcs[1] = { WriteReady };
+        void* sync_write_ctx[1] = { 0 };
+        Longtail_JobAPI_Jobs write_sync_job;
+        err = job_api->CreateJobs(job_api, job_group, 1, sync_write_funcs, sync_write_ctx, &write_sync_job);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+
+        err = job_api->AddDependecies(job_api, 1, write_job, 1, write_sync_job);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+        err = job_api->AddDependecies(job_api, 1, write_job, job->m_BlockReaderJobCount, block_read_jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+        err = job_api->ReadyJobs(job_api, job->m_BlockReaderJobCount, block_read_jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+
+        *out_jobs = write_sync_job;
+        return 0;
+    }
+    *out_jobs = write_job;
+    return 0;
+}
+
+int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context !=0, return EINVAL)
+    struct WritePartialAssetFromBlocksJob* job = (struct WritePartialAssetFromBlocksJob*)context;
+
+    // All block readers of this part are done with the chunk hashes
+    if (job->m_BlockChunkHashes)
+    {
+        Longtail_Free(job->m_BlockChunkHashes);
+        job->m_BlockChunkHashes = 0;
+    }
+
+    uint32_t block_reader_job_count = job->m_BlockReaderJobCount;
+
+    if ((!job->m_AssetOutputFile) && job->m_AssetChunkIndexOffset)
+    {
+        LONGTAIL_FATAL_ASSERT(ctx, job->m_Err != 0, return 0);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "WritePartialAssetFromBlocks(%p, %u, %d) failed due to previous error",
+            context, job_id, is_cancelled)
+        for (uint32_t d = 0; d < block_reader_job_count; ++d)
+        {
+            struct Longtail_StoredBlock* stored_block = job->m_BlockReaderJobs[d].m_StoredBlock;
+            if (stored_block && stored_block->Dispose)
+            {
+                stored_block->Dispose(stored_block);
+            }
+            job->m_BlockReaderJobs[d].m_StoredBlock = 0;
+        }
+        return 0;
+    }
+
+    if (is_cancelled)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "WritePartialAssetFromBlocks was cancelled, failed with %d", ECANCELED)
+
+        for (uint32_t d = 0; d < block_reader_job_count; ++d)
+        {
+            struct Longtail_StoredBlock* stored_block = job->m_BlockReaderJobs[d].m_StoredBlock;
+            if (stored_block && stored_block->Dispose)
+            {
+                stored_block->Dispose(stored_block);
+            }
+            job->m_BlockReaderJobs[d].m_StoredBlock = 0;
+        }
+        if (job->m_AssetOutputFile)
+        {
+            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+            job->m_AssetOutputFile = 0;
+        }
+        job->m_Err = ECANCELED;
+        return 0;
+    }
+
+    // Need to fetch all the data we need from the context since we will reuse the context
+    int block_reader_errors = 0;
+    TLongtail_Hash block_hashes[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+    struct Longtail_StoredBlock* stored_block[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+    for (uint32_t d = 0; d < block_reader_job_count; ++d)
+    {
+        if (job->m_BlockReaderJobs[d].m_Err)
+        {
+            block_reader_errors = block_reader_errors == 0 ? job->m_BlockReaderJobs[d].m_Err : block_reader_errors;
+            block_hashes[d] = 0;
+            stored_block[d] = 0;
+            continue;
+        }
+        block_hashes[d] = job->m_BlockReaderJobs[d].m_BlockHash;
+        stored_block[d] = job->m_BlockReaderJobs[d].m_StoredBlock;
+    }
+
+    if (block_reader_errors)
+    {
+        LONGTAIL_LOG(ctx, (block_reader_errors == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "BlockRead() failed with %d", block_reader_errors)
+        for (uint32_t d = 0; d < block_reader_job_count; ++d)
+        {
+            if (stored_block[d] && stored_block[d]->Dispose)
+            {
+                stored_block[d]->Dispose(stored_block[d]);
+                stored_block[d] = 0;
+            }
+        }
+
+        if (job->m_AssetOutputFile)
+        {
+            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+            job->m_AssetOutputFile = 0;
+        }
+        job->m_Err = block_reader_errors;
+        return 0;
+    }
+
+    uint32_t write_chunk_index_offset = job->m_AssetChunkIndexOffset;
+    uint32_t write_chunk_count = job->m_AssetChunkCount;
+    uint32_t asset_chunk_count = job->m_VersionIndex->m_AssetChunkCounts[job->m_AssetIndex];
+    const char* asset_path = &job->m_VersionIndex->m_NameData[job->m_VersionIndex->m_NameOffsets[job->m_AssetIndex]];
+
+    if (!job->m_AssetOutputFile)
+    {
+        char* full_asset_path = job->m_VersionStorageAPI->ConcatPath(job->m_VersionStorageAPI, job->m_VersionFolder, asset_path);
+        int err = EnsureParentPathExists(job->m_VersionStorageAPI, full_asset_path);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+            Longtail_Free(full_asset_path);
+            for (uint32_t d = 0; d < block_reader_job_count; ++d)
+            {
+                stored_block[d]->Dispose(stored_block[d]);
+                stored_block[d] = 0;
+            }
+            job->m_Err = err;
+            return 0;
+        }
+        if (IsDirPath(full_asset_path))
+        {
+            LONGTAIL_FATAL_ASSERT(ctx, block_reader_job_count == 0, job->m_Err = EINVAL; return 0)
+            // Remove trailing forward slash
+            full_asset_path[strlen(full_asset_path) - 1] = '\0';
+            err = SafeCreateDir(job->m_VersionStorageAPI, full_asset_path);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SafeCreateDir() failed with %d", err)
+                Longtail_Free(full_asset_path);
+                job->m_Err = err;
+                return 0;
+            }
+            Longtail_Free(full_asset_path);
+            WriteJournalAsset(job->m_Journal, job->m_AssetIndex);
+            job->m_Err = 0;
+            return 0;
+        }
+
+        uint16_t permissions;
+        err = job->m_VersionStorageAPI->GetPermissions(job->m_VersionStorageAPI, full_asset_path, &permissions);
+        if (err && (err != ENOENT))
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->GetPermissions() failed with %d", err)
+            Longtail_Free(full_asset_path);
+            for (uint32_t d = 0; d < block_reader_job_count; ++d)
+            {
+                stored_block[d]->Dispose(stored_block[d]);
+                stored_block[d] = 0;
+            }
+            job->m_Err = err;
+            return 0;
+        }
+
+        if (err != ENOENT)
+        {
+            if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
+            {
+                err = job->m_VersionStorageAPI->SetPermissions(job->m_VersionStorageAPI, full_asset_path, permissions | (Longtail_StorageAPI_UserWriteAccess));
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->SetPermissions() failed with %d", err)
+                    Longtail_Free(full_asset_path);
+                    for (uint32_t d = 0; d < block_reader_job_count; ++d)
+                    {
+                        stored_block[d]->Dispose(stored_block[d]);
+                        stored_block[d] = 0;
+                    }
+                    job->m_Err = err;
+                    return 0;
+                }
+            }
+        }
+
+        uint64_t asset_size = job->m_VersionIndex->m_AssetSizes[job->m_AssetIndex];
+        err = job->m_VersionStorageAPI->OpenWriteFile(job->m_VersionStorageAPI, full_asset_path, asset_size, &job->m_AssetOutputFile);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->OpenWriteFile() failed with %d", err)
+            Longtail_Free(full_asset_path);
+            for (uint32_t d = 0; d < block_reader_job_count; ++d)
+            {
+                stored_block[d]->Dispose(stored_block[d]);
+                stored_block[d] = 0;
+            }
+            job->m_Err = err;
+            return 0;
+        }
+        Longtail_Free(full_asset_path);
+        full_asset_path = 0;
+    }
+
+    Longtail_JobAPI_Jobs sync_write_job = 0;
+    if (write_chunk_index_offset + write_chunk_count < asset_chunk_count)
+    {
+        int err = CreatePartialAssetWriteJob(
+            job->m_BlockStoreAPI,
+            job->m_VersionStorageAPI,
+            job->m_JobAPI,
+            job->m_StoreIndex,
+            job->m_VersionIndex,
+            job->m_VersionFolder,
+            job->m_ChunkHashToBlockIndex,
+            job->m_AssetIndex,
+            job->m_RetainPermissions,
+            job->m_Journal,
+            job->m_JobGroup,
+            job,    // Reuse job
+            write_chunk_index_offset + write_chunk_count,
+            job->m_AssetOutputFile,
+            &sync_write_job);
+
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreatePartialAssetWriteJob() failed with %d", err)
+            for (uint32_t d = 0; d < block_reader_job_count; ++d)
+            {
+                stored_block[d]->Dispose(stored_block[d]);
+                stored_block[d] = 0;
+            }
+            job->m_Err = err;
+            return 0;
+        }
+        // Reading of blocks will start immediately
+    }
+
+    uint32_t chunk_index_offset = write_chunk_index_offset;
+    uint32_t chunk_index_start = job->m_VersionIndex->m_AssetChunkIndexStarts[job->m_AssetIndex];
+
+    uint64_t write_offset = 0;
+    for (uint32_t c = 0; c < chunk_index_offset; ++c)
+    {
+        uint32_t chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[chunk_index_start + c];
+        uint32_t chunk_size = job->m_VersionIndex->m_ChunkSizes[chunk_index];
+        write_offset += chunk_size;
+    }
+
+    uint32_t block_chunks_count = 0;
+    for(uint32_t b = 0; b < block_reader_job_count; ++b)
+    {
+        struct Longtail_BlockIndex* block_index = stored_block[b]->m_BlockIndex;
+        block_chunks_count += *block_index->m_ChunkCount;
+    }
+
+    size_t block_chunks_lookup_size = Longtail_LookupTable_GetSize(block_chunks_count);
+    size_t chunk_sizes_size = sizeof(uint32_t) * block_chunks_count;
+    size_t chunk_offsets_size = sizeof(uint32_t) * block_chunks_count;
+    size_t block_indexes_size = sizeof(uint32_t) * block_chunks_count;
+    size_t buffer_size = 512*1024;
+
+    size_t work_mem_size =
+        block_chunks_lookup_size +
+        chunk_sizes_size +
+        chunk_offsets_size +
+        block_indexes_size +
+        buffer_size;
+    void* work_mem = Longtail_Alloc("WritePartialAssetFromBlocks", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        for (uint32_t d = 0; d < block_reader_job_count; ++d)
+        {
+            stored_block[d]->Dispose(stored_block[d]);
+            stored_block[d] = 0;
+        }
+        job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+        job->m_AssetOutputFile = 0;
+        if (sync_write_job)
+        {
+            int err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+            LONGTAIL_FATAL_ASSERT(ctx, err == 0, job->m_Err = EINVAL; return 0)
+        }
+        job->m_Err = ENOMEM;
+        return 0;
+    }
+    char* p = (char*)work_mem;
+    struct Longtail_LookupTable* block_chunks_lookup = Longtail_LookupTable_Create(p, block_chunks_count, 0);
+    p += block_chunks_lookup_size;
+    uint32_t* chunk_sizes = (uint32_t*)p;
+    p += chunk_sizes_size;
+    uint32_t* chunk_offsets = (uint32_t*)p;
+    p += chunk_offsets_size;
+    uint32_t* block_indexes = (uint32_t*)p;
+    p += block_indexes_size;
+    char* buffer = p;
+
+    uint32_t block_chunk_index_offset = 0;
+    for(uint32_t b = 0; b < block_reader_job_count; ++b)
+    {
+        uint32_t chunk_offset = 0;
+        struct Longtail_BlockIndex* block_index = stored_block[b]->m_BlockIndex;
+        for (uint32_t c = 0; c < *block_index->m_ChunkCount; ++c)
+        {
+            TLongtail_Hash chunk_hash = block_index->m_ChunkHashes[c];
+            uint32_t chunk_size = block_index->m_ChunkSizes[c];
+            chunk_sizes[block_chunk_index_offset] = chunk_size;
+            chunk_offsets[block_chunk_index_offset] = chunk_offset;
+            block_indexes[block_chunk_index_offset] = b;
+            chunk_offset += chunk_size;
+
+            Longtail_LookupTable_Put(block_chunks_lookup, chunk_hash, block_chunk_index_offset);
+
+            block_chunk_index_offset++;
+        }
+    }
+
+    size_t buffer_used_size = 0;
+    uint32_t chunk_index_end = write_chunk_index_offset + write_chunk_count;
+
+    while (chunk_index_offset < chunk_index_end)
+    {
+        uint32_t asset_chunk_index = chunk_index_start + chunk_index_offset;
+        uint32_t chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[asset_chunk_index];
+        TLongtail_Hash chunk_hash = job->m_VersionIndex->m_ChunkHashes[chunk_index];
+
+        uint32_t* chunk_block_index = Longtail_LookupTable_Get(block_chunks_lookup, chunk_hash);
+        if (chunk_block_index == 0)
+        {
+            for (uint32_t d = 0; d < block_reader_job_count; ++d)
+            {
+                stored_block[d]->Dispose(stored_block[d]);
+                stored_block[d] = 0;
+            }
+            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+            job->m_AssetOutputFile = 0;
+            if (sync_write_job)
+            {
+                int err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+                LONGTAIL_FATAL_ASSERT(ctx, err == 0, job->m_Err = EINVAL; return 0)
+            }
+            job->m_Err = EINVAL;
+            Longtail_Free(work_mem);
+            return 0;
+        }
+
+        uint32_t block_index = block_indexes[*chunk_block_index];
+        uint32_t chunk_block_offset = chunk_offsets[*chunk_block_index];
+        uint32_t chunk_size = chunk_sizes[*chunk_block_index];
+        const char* block_data = (char*)stored_block[block_index]->m_BlockData;
+
+        while(chunk_index_offset < (chunk_index_end - 1))
+        {
+            uint32_t next_chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[asset_chunk_index + 1];
+            TLongtail_Hash next_chunk_hash = job->m_VersionIndex->m_ChunkHashes[next_chunk_index];
+
+            uint32_t* next_chunk_block_index = Longtail_LookupTable_Get(block_chunks_lookup, next_chunk_hash);
+            if (next_chunk_block_index == 0)
+            {
+                for (uint32_t d = 0; d < block_reader_job_count; ++d)
+                {
+                    stored_block[d]->Dispose(stored_block[d]);
+                    stored_block[d] = 0;
+                }
+                job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+                job->m_AssetOutputFile = 0;
+                if (sync_write_job)
+                {
+                    int err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+                    LONGTAIL_FATAL_ASSERT(ctx, err == 0, job->m_Err = EINVAL; return 0)
+                }
+                job->m_Err = EINVAL;
+                Longtail_Free(work_mem);
+                return 0;
+            }
+            uint32_t next_block_index = block_indexes[*next_chunk_block_index];
+            if (next_block_index != block_index)
+            {
+                break;
+            }
+            uint32_t next_chunk_block_offset = chunk_offsets[*next_chunk_block_index];
+            if (next_chunk_block_offset != chunk_block_offset + chunk_size)
+            {
+                break;
+            }
+            uint32_t next_chunk_size = chunk_sizes[*next_chunk_block_index];
+            chunk_size += next_chunk_size;
+            ++chunk_index_offset;
+        }
+
+        if (buffer_used_size + chunk_size <= buffer_size)
+        {
+            if (buffer_used_size > 0 || (chunk_index_offset < chunk_index_end - 1))
+            {
+                memcpy(&buffer[buffer_used_size], &block_data[chunk_block_offset], chunk_size);
+                buffer_used_size += chunk_size;
+                ++chunk_index_offset;
+                continue;
+            }
+        }
+
+        if (buffer_used_size > 0)
+        {
+            int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, buffer_used_size, buffer);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
+                job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+                job->m_AssetOutputFile = 0;
+
+                for (uint32_t d = 0; d < block_reader_job_count; ++d)
+                {
+                    stored_block[d]->Dispose(stored_block[d]);
+                    stored_block[d] = 0;
+                }
+                job->m_Err = err;
+                if (sync_write_job)
+                {
+                    int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+                    LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
+                }
+                Longtail_Free(work_mem);
+                return 0;
+            }
+            write_offset += buffer_used_size;
+            buffer_used_size = 0;
+        }
+
+        if (buffer_used_size + chunk_size <= buffer_size)
+        {
+            if (buffer_used_size > 0 || (chunk_index_offset < chunk_index_end - 1))
+            {
+                memcpy(&buffer[buffer_used_size], &block_data[chunk_block_offset], chunk_size);
+                buffer_used_size += chunk_size;
+                ++chunk_index_offset;
+                continue;
+            }
+        }
+
+        int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, chunk_size, &block_data[chunk_block_offset]);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
+            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+            job->m_AssetOutputFile = 0;
+
+            for (uint32_t d = 0; d < block_reader_job_count; ++d)
+            {
+                stored_block[d]->Dispose(stored_block[d]);
+                stored_block[d] = 0;
+            }
+            job->m_Err = err;
+            if (sync_write_job)
+            {
+                int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+                LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
+            }
+            Longtail_Free(work_mem);
+            return 0;
+        }
+        write_offset += chunk_size;
+
+        ++chunk_index_offset;
+    }
+
+    if (buffer_used_size > 0)
+    {
+        int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, buffer_used_size, buffer);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
+            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+            job->m_AssetOutputFile = 0;
+
+            for (uint32_t d = 0; d < block_reader_job_count; ++d)
+            {
+                stored_block[d]->Dispose(stored_block[d]);
+                stored_block[d] = 0;
+            }
+            job->m_Err = err;
+            if (sync_write_job)
+            {
+                int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+                LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
+            }
+            Longtail_Free(work_mem);
+            return 0;
+        }
+        write_offset += buffer_used_size;
+        buffer_used_size = 0;
+    }
+
+    Longtail_Free(work_mem);
+
+    for (uint32_t d = 0; d < block_reader_job_count; ++d)
+    {
+        stored_block[d]->Dispose(stored_block[d]);
+        stored_block[d] = 0;
+    }
+
+    if (sync_write_job)
+    {
+        // We can now release the next write job which will in turn close the job->m_AssetOutputFile
+        int err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+        if (err)
+        {
+            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+            job->m_Err = err;
+            return 0;
+        }
+        job->m_Err = 0;
+        return 0;
+    }
+
+    job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+    job->m_AssetOutputFile = 0;
+
+    if (job->m_RetainPermissions)
+    {
+        char* full_asset_path = job->m_VersionStorageAPI->ConcatPath(job->m_VersionStorageAPI, job->m_VersionFolder, asset_path);
+        int err = job->m_VersionStorageAPI->SetPermissions(job->m_VersionStorageAPI, full_asset_path, (uint16_t)job->m_VersionIndex->m_Permissions[job->m_AssetIndex]);
+        Longtail_Free(full_asset_path);
+        full_asset_path = 0;
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->SetPermissions() failed with %d", err)
+            job->m_Err = err;
+            return 0;
+        }
+    }
+
+    WriteJournalAsset(job->m_Journal, job->m_AssetIndex);
+    job->m_Err = 0;
+    return 0;
+}
+
+struct WriteAssetsFromBlockJob
+{
+    struct Longtail_StorageAPI* m_VersionStorageAPI;
+    const struct Longtail_VersionIndex* m_VersionIndex;
+    const char* m_VersionFolder;
+    struct BlockReaderJob m_BlockReadJob;
+    uint32_t m_BlockIndex;
+    uint32_t* m_AssetIndexes;
+    uint32_t m_AssetCount;
+    int m_RetainPermissions;
+    struct WriteJournal* m_Journal;
+    int m_Err;
+};
+
+static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+
+    struct WriteAssetsFromBlockJob* job = (struct WriteAssetsFromBlockJob*)context;
+    struct Longtail_StorageAPI* version_storage_api = job->m_VersionStorageAPI;
+    const char* version_folder = job->m_VersionFolder;
+    const struct Longtail_VersionIndex* version_index = job->m_VersionIndex;
+    uint32_t* asset_indexes = job->m_AssetIndexes;
+    uint32_t asset_count = job->m_AssetCount;
+
+    if (job->m_BlockReadJob.m_Err)
+    {
+        LONGTAIL_LOG(ctx, (job->m_BlockReadJob.m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "BlockReadJob() failed with %d", job->m_BlockReadJob.m_Err)
+        job->m_Err = job->m_BlockReadJob.m_Err;
+        return 0;
+    }
+
+    if (is_cancelled)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "WriteAssetsFromBlock was cancelled, failed with %d", job->m_BlockReadJob.m_Err)
+       job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+       job->m_Err = ECANCELED;
+       return 0;
+    }
+
+    const char* block_data = (char*)job->m_BlockReadJob.m_StoredBlock->m_BlockData;
+    struct Longtail_BlockIndex* block_index = job->m_BlockReadJob.m_StoredBlock->m_BlockIndex;
+
+    uint32_t block_chunks_count = *block_index->m_ChunkCount;
+
+    size_t chuck_offsets_size = sizeof(uint32_t) * block_chunks_count;
+    size_t block_chunks_lookup_size = Longtail_LookupTable_GetSize(block_chunks_count);
+    size_t tmp_mem_size =
+        chuck_offsets_size +
+        block_chunks_lookup_size;
+
+    char* tmp_mem = (char*)Longtail_Alloc("WriteAssetsFromBlock", tmp_mem_size);
+    if (!tmp_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+        job->m_BlockReadJob.m_StoredBlock = 0;
+        job->m_Err = ENOMEM;
+        return 0;
+    }
+    struct Longtail_LookupTable* block_chunks_lookup = Longtail_LookupTable_Create(tmp_mem, block_chunks_count, 0);
+    uint32_t* chunk_offsets = (uint32_t*)(&tmp_mem[block_chunks_lookup_size]);
+    const uint32_t* chunk_sizes = block_index->m_ChunkSizes;
+
+    uint32_t block_chunk_index_offset = 0;
+    uint32_t chunk_offset = 0;
+    for (uint32_t c = 0; c < block_chunks_count; ++c)
+    {
+        TLongtail_Hash chunk_hash = block_index->m_ChunkHashes[c];
+        uint32_t chunk_size = block_index->m_ChunkSizes[c];
+        chunk_offsets[block_chunk_index_offset] = chunk_offset;
+        chunk_offset += chunk_size;
+
+        Longtail_LookupTable_Put(block_chunks_lookup, chunk_hash, block_chunk_index_offset);
+
+        block_chunk_index_offset++;
+    }
+
+    for (uint32_t i = 0; i < asset_count; ++i)
+    {
+        uint32_t asset_index = asset_indexes[i];
+        const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[asset_index]];
+        char* full_asset_path = version_storage_api->ConcatPath(version_storage_api, version_folder, asset_path);
+        int err = EnsureParentPathExists(version_storage_api, full_asset_path);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+            Longtail_Free(full_asset_path);
+            job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+            job->m_BlockReadJob.m_StoredBlock = 0;
+            job->m_Err = err;
+            Longtail_Free(tmp_mem);
+            return 0;
+        }
+
+        uint16_t permissions;
+        err = version_storage_api->GetPermissions(version_storage_api, full_asset_path, &permissions);
+        if (err && (err != ENOENT))
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetPermissions() failed with %d", err)
+            Longtail_Free(full_asset_path);
+            job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+            job->m_BlockReadJob.m_StoredBlock = 0;
+            job->m_Err = err;
+            Longtail_Free(tmp_mem);
+            return 0;
+        }
+
+        if (err != ENOENT)
+        {
+            if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
+            {
+                err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, permissions | (Longtail_StorageAPI_UserWriteAccess));
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
+                    Longtail_Free(full_asset_path);
+                    job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+                    job->m_BlockReadJob.m_StoredBlock = 0;
+                    job->m_Err = err;
+                    Longtail_Free(tmp_mem);
+                    return 0;
+                }
+            }
+        }
+
+        Longtail_StorageAPI_HOpenFile asset_file;
+        err = version_storage_api->OpenWriteFile(version_storage_api, full_asset_path, 0, &asset_file);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->OpenWriteFile() failed with %d", err)
+            Longtail_Free(full_asset_path);
+            full_asset_path = 0;
+            job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+            job->m_BlockReadJob.m_StoredBlock = 0;
+            job->m_Err = err;
+            Longtail_Free(tmp_mem);
+            return 0;
+        }
+
+        uint64_t asset_write_offset = 0;
+        uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
+        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
+        for (uint32_t asset_chunk_index = 0; asset_chunk_index < asset_chunk_count; ++asset_chunk_index)
+        {
+            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + asset_chunk_index];
+            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+
+            uint32_t* chunk_block_index = Longtail_LookupTable_Get(block_chunks_lookup, chunk_hash);
+            if (chunk_block_index == 0)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", err)
+                version_storage_api->CloseFile(version_storage_api, asset_file);
+                asset_file = 0;
+                Longtail_Free(full_asset_path);
+                full_asset_path = 0;
+                job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+                job->m_BlockReadJob.m_StoredBlock = 0;
+                job->m_Err = err;
+                Longtail_Free(tmp_mem);
+                return 0;
+            }
+
+            uint32_t chunk_block_offset = chunk_offsets[*chunk_block_index];
+            uint32_t chunk_size = chunk_sizes[*chunk_block_index];
+
+            while(asset_chunk_index < (asset_chunk_count - 1))
+            {
+                uint32_t next_chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + asset_chunk_index + 1];
+                TLongtail_Hash next_chunk_hash = version_index->m_ChunkHashes[next_chunk_index];
+                uint32_t* next_chunk_block_index = Longtail_LookupTable_Get(block_chunks_lookup, next_chunk_hash);
+                if (next_chunk_block_index == 0)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", err)
+                    version_storage_api->CloseFile(version_storage_api, asset_file);
+                    asset_file = 0;
+                    Longtail_Free(full_asset_path);
+                    full_asset_path = 0;
+                    job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+                    job->m_BlockReadJob.m_StoredBlock = 0;
+                    job->m_Err = err;
+                    Longtail_Free(tmp_mem);
+                    return 0;
+                }
+
+                uint32_t next_chunk_block_offset = chunk_offsets[*next_chunk_block_index];
+                if (next_chunk_block_offset != chunk_block_offset + chunk_size)
+                {
+                    break;
+                }
+                uint32_t next_chunk_size = chunk_sizes[*next_chunk_block_index];
+                chunk_size += next_chunk_size;
+                ++asset_chunk_index;
+            }
+
+            err = version_storage_api->Write(version_storage_api, asset_file, asset_write_offset, chunk_size, &block_data[chunk_block_offset]);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->Write() failed with %d", err)
+                version_storage_api->CloseFile(version_storage_api, asset_file);
+                asset_file = 0;
+                Longtail_Free(full_asset_path);
+                full_asset_path = 0;
+                job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+                job->m_BlockReadJob.m_StoredBlock = 0;
+                job->m_Err = err;
+                Longtail_Free(tmp_mem);
+                return 0;
+            }
+            asset_write_offset += chunk_size;
+        }
+
+        version_storage_api->CloseFile(version_storage_api, asset_file);
+        asset_file = 0;
+
+        if (job->m_RetainPermissions)
+        {
+            err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, (uint16_t)version_index->m_Permissions[asset_index]);
+            Longtail_Free(full_asset_path);
+            full_asset_path = 0;
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
+                job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+                job->m_BlockReadJob.m_StoredBlock = 0;
+                job->m_Err = err;
+                Longtail_Free(tmp_mem);
+                return 0;
+            }
+        }
+        WriteJournalAsset(job->m_Journal, asset_index);
+    }
+    Longtail_Free(tmp_mem);
+
+    job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+    job->m_BlockReadJob.m_StoredBlock = 0;
+    job->m_Err = 0;
+    return 0;
+}
+
+struct AssetWriteList
+{
+    uint32_t m_BlockJobCount;
+    uint32_t m_AssetJobCount;
+    uint32_t* m_BlockJobAssetIndexes;
+    uint32_t* m_AssetIndexJobs;
+};
+
+struct BlockJobCompareContext
+{
+    const struct AssetWriteList* m_AssetWriteList;
+    const uint32_t* asset_chunk_index_starts;
+    const uint32_t* asset_chunk_indexes;
+    const TLongtail_Hash* chunk_hashes;
+    struct Longtail_LookupTable* chunk_hash_to_block_index;
+};
+
+static SORTFUNC(BlockJobCompare)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(a_ptr, "%p"),
+        LONGTAIL_LOGFIELD(b_ptr, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
+
+    struct BlockJobCompareContext* c = (struct BlockJobCompareContext*)context;
+    struct Longtail_LookupTable* chunk_hash_to_block_index = c->chunk_hash_to_block_index;
+
+    uint32_t a = *(const uint32_t*)a_ptr;
+    uint32_t b = *(const uint32_t*)b_ptr;
+
+    uint32_t asset_chunk_offset_a = c->asset_chunk_index_starts[a];
+    uint32_t asset_chunk_offset_b = c->asset_chunk_index_starts[b];
+    uint32_t chunk_index_a = c->asset_chunk_indexes[asset_chunk_offset_a];
+    uint32_t chunk_index_b = c->asset_chunk_indexes[asset_chunk_offset_b];
+
+    TLongtail_Hash a_first_chunk_hash = c->chunk_hashes[chunk_index_a];
+    TLongtail_Hash b_first_chunk_hash = c->chunk_hashes[chunk_index_b];
+//    if (a_first_chunk_hash == b_first_chunk_hash)
+//    {
+//        return 0;
+//    }
+    const uint32_t* a_block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, a_first_chunk_hash);
+    LONGTAIL_FATAL_ASSERT(ctx, a_block_index_ptr, return 0)
+    const uint32_t* b_block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, b_first_chunk_hash);
+    LONGTAIL_FATAL_ASSERT(ctx, b_block_index_ptr, return 0)
+    uint32_t a_block_index = *a_block_index_ptr;
+    uint32_t b_block_index = *b_block_index_ptr;
+    if (a_block_index < b_block_index)
+    {
+        return -1;
+    }
+    else if (a_block_index > b_block_index)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+
+static struct AssetWriteList* CreateAssetWriteList(uint32_t asset_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(asset_count, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    size_t awl_size = sizeof(struct AssetWriteList) + sizeof(uint32_t) * asset_count + sizeof(uint32_t) * asset_count;
+    struct AssetWriteList* awl = (struct AssetWriteList*)(Longtail_Alloc("CreateAssetWriteList", awl_size));
+    if (!awl)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
+    awl->m_BlockJobCount = 0;
+    awl->m_AssetJobCount = 0;
+    awl->m_BlockJobAssetIndexes = (uint32_t*)(void*)&awl[1];
+    awl->m_AssetIndexJobs = &awl->m_BlockJobAssetIndexes[asset_count];
+    return awl;
+}
+
+static int BuildAssetWriteList(
+    uint32_t asset_count,
+    const uint32_t* optional_asset_indexes,
+    uint32_t* name_offsets,
+    const char* name_data,
+    const TLongtail_Hash* chunk_hashes,
+    const uint32_t* asset_chunk_counts,
+    const uint32_t* asset_chunk_index_starts,
+    const uint32_t* asset_chunk_indexes,
+    struct Longtail_LookupTable* chunk_hash_to_block_index,
+    struct AssetWriteList** out_asset_write_list)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(asset_count, "%u"),
+        LONGTAIL_LOGFIELD(optional_asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(name_offsets, "%p"),
+        LONGTAIL_LOGFIELD(name_data, "%p"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_index_starts, "%p"),
+        LONGTAIL_LOGFIELD(asset_chunk_indexes, "%p"),
+        LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
+        LONGTAIL_LOGFIELD(out_asset_write_list, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || name_offsets != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || name_data != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || chunk_hashes != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_counts != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_index_starts != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_indexes != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, chunk_hash_to_block_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, out_asset_write_list != 0, return EINVAL)
+
+    struct AssetWriteList* awl = CreateAssetWriteList(asset_count);
+    if (awl == 0)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateAssetWriteList() CreateAssetWriteList() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+
+    for (uint32_t i = 0; i < asset_count; ++i)
+    {
+        uint32_t asset_index = optional_asset_indexes ? optional_asset_indexes[i] : i;
+        const char* path = &name_data[name_offsets[asset_index]];
+        uint32_t chunk_count = asset_chunk_counts[asset_index];
+        uint32_t asset_chunk_offset = asset_chunk_index_starts[asset_index];
+        if (chunk_count == 0)
+        {
+            awl->m_AssetIndexJobs[awl->m_AssetJobCount] = asset_index;
+            ++awl->m_AssetJobCount;
+            continue;
+        }
+        uint32_t chunk_index = asset_chunk_indexes[asset_chunk_offset];
+        TLongtail_Hash chunk_hash = chunk_hashes[chunk_index];
+        uint32_t* content_block_index = Longtail_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
+        if (content_block_index == 0)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", ENOENT)
+            Longtail_Free(awl);
+            return ENOENT;
+        }
+
+        int is_block_job = 1;
+        for (uint32_t c = 1; c < chunk_count; ++c)
+        {
+            uint32_t next_chunk_index = asset_chunk_indexes[asset_chunk_offset + c];
+            TLongtail_Hash next_chunk_hash = chunk_hashes[next_chunk_index];
+            uint32_t* next_content_block_index = Longtail_LookupTable_Get(chunk_hash_to_block_index, next_chunk_hash);
+            if (next_content_block_index == 0)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", ENOENT)
+                Longtail_Free(awl);
+                return ENOENT;
+            }
+            if (*content_block_index != *next_content_block_index)
+            {
+                is_block_job = 0;
+                // We don't break here since we want to validate that all the chunks are in the content index
+            }
+        }
+
+        if (is_block_job)
+        {
+            awl->m_BlockJobAssetIndexes[awl->m_BlockJobCount] = asset_index;
+            ++awl->m_BlockJobCount;
+        }
+        else
+        {
+            awl->m_AssetIndexJobs[awl->m_AssetJobCount] = asset_index;
+            ++awl->m_AssetJobCount;
+        }
+    }
+
+    struct BlockJobCompareContext block_job_compare_context = {
+            awl,    // m_AssetWriteList
+            asset_chunk_index_starts,
+            asset_chunk_indexes,
+            chunk_hashes,   // chunk_hashes
+            chunk_hash_to_block_index  // chunk_hash_to_block_index
+        };
+    QSORT(awl->m_BlockJobAssetIndexes, (size_t)awl->m_BlockJobCount, sizeof(uint32_t), BlockJobCompare, &block_job_compare_context);
+
+    *out_asset_write_list = awl;
+    return 0;
+}
+
+static int WriteAssets(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    const char* version_path,
+    struct Longtail_LookupTable* chunk_hash_to_block_index,
+    struct AssetWriteList* awl,
+    struct WriteJournal* optional_journal,
+    int retain_permssions)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
+        LONGTAIL_LOGFIELD(awl, "%p"),
+        LONGTAIL_LOGFIELD(optional_journal, "%p"),
+        LONGTAIL_LOGFIELD(retain_permssions, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, block_store_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_storage_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, store_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_path != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, chunk_hash_to_block_index != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, awl != 0, return EINVAL)
+
+    {
+        uint32_t j = 0;
+        while (j < awl->m_BlockJobCount)
+        {
+            uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
+            TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
+            const uint32_t* block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
+            if (!block_index_ptr)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", EINVAL)
+                return EINVAL;
+            }
+            uint32_t block_index = *block_index_ptr;
+            TLongtail_Hash block_hash = store_index->m_BlockHashes[block_index];
+
+            ++j;
+            while (j < awl->m_BlockJobCount)
+            {
+                uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
+                TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
+                const uint32_t* next_block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
+                if (!next_block_index_ptr)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_LookupTable_Get() failed with %d", EINVAL)
+                    return EINVAL;
+                }
+                uint32_t next_block_index = *next_block_index_ptr;
+                if (next_block_index != block_index)
+                {
+                    break;
+                }
+                ++j;
+            }
+        }
+    }
+
+    const uint32_t worker_count = job_api->GetWorkerCount(job_api) + 1;
+    const uint32_t max_parallell_block_read_jobs = worker_count < MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE ? worker_count : MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE;
+
+    uint32_t asset_job_count = 0;
+    for (uint32_t a = 0; a < awl->m_AssetJobCount; ++a)
+    {
+        uint32_t asset_index = awl->m_AssetIndexJobs[a];
+        uint32_t chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
+        uint32_t chunk_count = version_index->m_AssetChunkCounts[asset_index];
+        if (chunk_count == 0)
+        {
+            asset_job_count += 1;   // Write job
+            continue;
+        }
+
+        uint32_t chunk_index_end = chunk_index_start + chunk_count;
+        uint32_t chunk_index_offset = chunk_index_start;
+
+        while(chunk_index_offset != chunk_index_end)
+        {
+            uint32_t block_read_job_count = 0;
+            TLongtail_Hash block_hashes[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+            while (chunk_index_offset != chunk_index_end && block_read_job_count < max_parallell_block_read_jobs)
+            {
+                uint32_t chunk_index = version_index->m_AssetChunkIndexes[chunk_index_offset];
+                TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+                const uint32_t* block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
+                LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
+                uint32_t block_index = *block_index_ptr;
+                TLongtail_Hash block_hash = store_index->m_BlockHashes[block_index];
+                int has_block = 0;
+                for (uint32_t d = 0; d < block_read_job_count; ++d)
+                {
+                    if (block_hashes[d] == block_hash)
+                    {
+                        has_block = 1;
+                        break;
+                    }
+                }
+                if (!has_block)
+                {
+                    block_hashes[block_read_job_count++] = block_hash;
+                }
+                ++chunk_index_offset;
+            }
+            asset_job_count += 1;   // Write job
+            asset_job_count += 1;   // Sync job
+            asset_job_count += block_read_job_count;
+        }
+    }
+
+    int err = block_store_api->PreflightGet(block_store_api, *store_index->m_BlockCount, store_index->m_BlockHashes, 0);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_store_api->PreflightGet() failed with %d", err)
+        return err;
+    }
+
+    if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Cancelled, failed with %d", ECANCELED)
+        return ECANCELED;
+    }
+
+    struct WriteAssetsFromBlockJob* block_jobs = (struct WriteAssetsFromBlockJob*)Longtail_Alloc("WriteAssets", (size_t)(sizeof(struct WriteAssetsFromBlockJob) * awl->m_BlockJobCount));
+    if (!block_jobs)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+
+    Longtail_JobAPI_Group job_group = 0;
+    err = job_api->ReserveJobs(job_api, (awl->m_BlockJobCount * 2u) + asset_job_count, &job_group);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+        Longtail_Free(block_jobs);
+        return err;
+    }
+
+    uint32_t j = 0;
+    uint32_t block_job_count = 0;
+    while (j < awl->m_BlockJobCount)
+    {
+        uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
+        TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
+        const uint32_t* block_index_ptr = Longtail_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
+        LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
+        uint32_t block_index = *block_index_ptr;
+
+        struct WriteAssetsFromBlockJob* job = &block_jobs[block_job_count++];
+        struct BlockReaderJob* block_job = &job->m_BlockReadJob;
+        block_job->m_BlockStoreAPI = block_store_api;
+        block_job->m_AsyncCompleteAPI.m_API.Dispose = 0;
+        block_job->m_AsyncCompleteAPI.OnComplete = 0;
+        block_job->m_BlockHash = store_index->m_BlockHashes[block_index];
+        block_job->m_ChunkHashes = 0;
+        block_job->m_ChunkCount = 0;
+        block_job->m_JobAPI = job_api;
+        block_job->m_JobID = 0;
+        block_job->m_Err = EINVAL;
+        block_job->m_StoredBlock = 0;
+        Longtail_JobAPI_JobFunc block_read_funcs[1] = { BlockReader };
+        void* block_read_ctxs[1] = {block_job};
+        Longtail_JobAPI_Jobs block_read_job;
+        err = job_api->CreateJobs(job_api, job_group, 1, block_read_funcs, block_read_ctxs, &block_read_job);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+
+        job->m_VersionStorageAPI = version_storage_api;
+        job->m_VersionIndex = version_index;
+        job->m_VersionFolder = version_path;
+        job->m_BlockIndex = block_index;
+        job->m_AssetIndexes = &awl->m_BlockJobAssetIndexes[j];
+        job->m_RetainPermissions = retain_permssions;
+        job->m_Journal = optional_journal;
+        job->m_Err = EINVAL;
+
+        job->m_AssetCount = 1;
+        ++j;
+        while (j < awl->m_BlockJobCount)
+        {
+            uint32_t next_asset_index = awl->m_BlockJobAssetIndexes[j];
+            TLongtail_Hash next_first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[next_asset_index]]];
+            uint32_t* next_block_index = Longtail_LookupTable_Get(chunk_hash_to_block_index, next_first_chunk_hash);
+            LONGTAIL_FATAL_ASSERT(ctx, next_block_index != 0, return EINVAL)
+            if (block_index != *next_block_index)
+            {
+                break;
+            }
+
+            ++job->m_AssetCount;
+            ++j;
+        }
+
+        Longtail_JobAPI_JobFunc funcs[1] = { WriteAssetsFromBlock };
+        void* ctxs[1] = { job };
+
+        Longtail_JobAPI_Jobs block_write_job;
+        err = job_api->CreateJobs(job_api, job_group, 1, funcs, ctxs, &block_write_job);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+        err = job_api->AddDependecies(job_api, 1, block_write_job, 1, block_read_job);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+        err = job_api->ReadyJobs(job_api, 1, block_read_job);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+    }
+/*
+block_readorCount = blocks_remaning > 8 ? 8 : blocks_remaning
+
+Create block_reador Tasks [block_readorCount]
+Create WriteSync Task
+Create Write Task
+    Depends on block_reador Tasks [block_readorCount]
+    Depends on WriteSync Task
+
+Ready block_reador Tasks [block_readorCount]
+Ready WriteSync Task
+
+WaitForAllTasks()
+
+JOBS:
+
+Write Task Execute (When block_reador Tasks [block_readorCount] and WriteSync Task is complete)
+    Newblock_readorCount = blocks_remaning > 8 ? 8 : blocks_remaning
+    if ([block_readorCount] > 0)
+        Create block_reador Tasks for up to remaining blocks [Newblock_readorCount]
+        Create WriteSync Task
+        Create Write Task
+            Depends on block_reador Tasks [Newblock_readorCount]
+            Depends on WriteSync Task
+        Ready block_reador Tasks [Newblock_readorCount]
+    Write and Longtail_Free block_readed Tasks Data [block_readorCount] To Disk
+    if ([block_readorCount] > 0)
+        Ready WriteSync Task
+*/
+
+    size_t asset_jobs_size = sizeof(struct WritePartialAssetFromBlocksJob) * awl->m_AssetJobCount;
+    struct WritePartialAssetFromBlocksJob* asset_jobs = (struct WritePartialAssetFromBlocksJob*)Longtail_Alloc("WriteAssets", asset_jobs_size);
+    if (!asset_jobs)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(block_jobs);
+        return ENOMEM;
+    }
+    for (uint32_t a = 0; a < awl->m_AssetJobCount; ++a)
+    {
+        Longtail_JobAPI_Jobs write_sync_job;
+        err = CreatePartialAssetWriteJob(
+            block_store_api,
+            version_storage_api,
+            job_api,
+            store_index,
+            version_index,
+            version_path,
+            chunk_hash_to_block_index,
+            awl->m_AssetIndexJobs[a],
+            retain_permssions,
+            optional_journal,
+            job_group,
+            &asset_jobs[a],
+            0,
+            (Longtail_StorageAPI_HOpenFile)0,
+            &write_sync_job);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreatePartialAssetWriteJob() failed with %d", err)
+            Longtail_Free(asset_jobs);
+            Longtail_Free(block_jobs);
+            return err;
+        }
+        err = job_api->ReadyJobs(job_api, 1, write_sync_job);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+    }
+
+    err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        Longtail_Free(asset_jobs);
+        Longtail_Free(block_jobs);
+        return err;
+    }
+
+    err = 0;
+    for (uint32_t b = 0; b < block_job_count; ++b)
+    {
+        struct WriteAssetsFromBlockJob* job = &block_jobs[b];
+        if (job->m_Err)
+        {
+            LONGTAIL_LOG(ctx, (job->m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteAssetsFromBlockJob failed with %d", job->m_Err)
+            err = err ? err : job->m_Err;
+        }
+    }
+    for (uint32_t a = 0; a < awl->m_AssetJobCount; ++a)
+    {
+        struct WritePartialAssetFromBlocksJob* job = &asset_jobs[a];
+        if (job->m_Err)
+        {
+            const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[job->m_AssetIndex]];
+            LONGTAIL_LOG(ctx, (job->m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WritePartialAssetFromBlocksJob failed with %d", job->m_Err)
+            if (err == 0)
+            {
+                err = job->m_Err;
+            }
+            else if ((err == ENOTRECOVERABLE) && (job->m_Err != ENOTRECOVERABLE))
+            {
+                err = job->m_Err;
+            }
+        }
+    }
+
+    Longtail_Free(asset_jobs);
+    Longtail_Free(block_jobs);
+
+    return err;
+}
+
+int Longtail_WriteVersion(
+    struct Longtail_BlockStoreAPI* block_storage_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    const char* version_path,
+    int retain_permissions)
+{
+    return Longtail_WriteVersionJournaled(
+        block_storage_api,
+        version_storage_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        store_index,
+        version_index,
+        version_path,
+        0,
+        retain_permissions);
+}
+
+int Longtail_WriteVersionJournaled(
+    struct Longtail_BlockStoreAPI* block_storage_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    const char* version_path,
+    const char* optional_journal_path,
+    int retain_permissions)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(optional_journal_path, "%s"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, optional_journal_path == 0 || !IsPathInFolder(version_path, optional_journal_path), return EINVAL)
+
+    if (*version_index->m_AssetCount == 0)
+    {
+        return 0;
+    }
+
+    uint32_t block_count = *store_index->m_BlockCount;
+    uint32_t chunk_count = *store_index->m_ChunkCount;
+    struct Longtail_LookupTable* chunk_hash_to_block_index = Longtail_LookupTable_Create(Longtail_Alloc("WriteVersion", Longtail_LookupTable_GetSize(chunk_count)), chunk_count, 0);
+    if (!chunk_hash_to_block_index)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
+        uint32_t chunk_index_offset = store_index->m_BlockChunksOffsets[b];
+        for (uint32_t c = 0; c < block_chunk_count; ++c)
+    {
+            uint32_t chunk_index = chunk_index_offset + c;
+            TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_index];
+            Longtail_LookupTable_PutUnique(chunk_hash_to_block_index, chunk_hash, b);
+        }
+        chunk_index_offset += block_chunk_count;
+    }
+
+    uint32_t asset_count = *version_index->m_AssetCount;
+
+    // Assets recorded in the journal by an earlier, interrupted, run are not written again
+    struct WriteJournal* journal = 0;
+    uint32_t* pending_asset_indexes = 0;
+    uint32_t pending_count = asset_count;
+    if (optional_journal_path)
+    {
+        int err = OpenWriteJournal(version_storage_api, version_index, version_path, optional_journal_path, &journal);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "OpenWriteJournal() failed with %d", err)
+            Longtail_Free(chunk_hash_to_block_index);
+            return err;
+        }
+        pending_asset_indexes = (uint32_t*)Longtail_Alloc("WriteVersion", sizeof(uint32_t) * asset_count);
+        if (!pending_asset_indexes)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            CloseWriteJournal(journal, 0);
+            Longtail_Free(chunk_hash_to_block_index);
+            return ENOMEM;
+        }
+        pending_count = 0;
+        for (uint32_t a = 0; a < asset_count; ++a)
+        {
+            if (!journal->m_IsCompleted[a])
+            {
+                pending_asset_indexes[pending_count++] = a;
+            }
+        }
+        err = StartWriteJournal(journal, pending_count, pending_asset_indexes);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "StartWriteJournal() failed with %d", err)
+            Longtail_Free(pending_asset_indexes);
+            CloseWriteJournal(journal, 0);
+            Longtail_Free(chunk_hash_to_block_index);
+            return err;
+        }
+        if (pending_count == 0)
+        {
+            Longtail_Free(pending_asset_indexes);
+            CloseWriteJournal(journal, 1);
+            Longtail_Free(chunk_hash_to_block_index);
+            return 0;
+        }
+    }
+
+    struct AssetWriteList* awl;
+    int err = BuildAssetWriteList(
+        pending_count,
+        pending_asset_indexes,
+        version_index->m_NameOffsets,
+        version_index->m_NameData,
+        version_index->m_ChunkHashes,
+        version_index->m_AssetChunkCounts,
+        version_index->m_AssetChunkIndexStarts,
+        version_index->m_AssetChunkIndexes,
+        chunk_hash_to_block_index,
+        &awl);
+
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BuildAssetWriteList() failed with %d", err)
+        Longtail_Free(pending_asset_indexes);
+        CloseWriteJournal(journal, 0);
+        Longtail_Free(chunk_hash_to_block_index);
+        return err;
+    }
+
+    err = WriteAssets(
+        block_storage_api,
+        version_storage_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        store_index,
+        version_index,
+        version_path,
+        chunk_hash_to_block_index,
+        awl,
+        journal,
+        retain_permissions);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "WriteAssets() failed with %d", err)
+    }
+
+    Longtail_Free(awl);
+    Longtail_Free(pending_asset_indexes);
+    CloseWriteJournal(journal, err == 0);
+    Longtail_Free(chunk_hash_to_block_index);
+
+    return err;
+}
+
+static int CompareHash(const void* a_ptr, const void* b_ptr) 
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(a_ptr, "%p"),
+        LONGTAIL_LOGFIELD(b_ptr, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
+
+    TLongtail_Hash a = *((const TLongtail_Hash*)a_ptr);
+    TLongtail_Hash b = *((const TLongtail_Hash*)b_ptr);
+    if (a > b) return  1;
+    if (a < b) return -1;
+    return 0;
+}
+
+static uint32_t MakeUnique(TLongtail_Hash* hashes, uint32_t count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hashes, "%p"),
+        LONGTAIL_LOGFIELD(count, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, count == 0 || hashes != 0, return 0)
+
+    uint32_t w = 0;
+    uint32_t r = 0;
+    while (r < count)
+    {
+        hashes[w] = hashes[r];
+        ++r;
+        while (r < count && hashes[r - 1] == hashes[r])
+        {
+            ++r;
+        }
+        ++w;
+    }
+    return w;
+}
+
+static int DiffHashes(
+    const TLongtail_Hash* reference_hashes,
+    uint32_t reference_hash_count,
+    const TLongtail_Hash* new_hashes,
+    uint32_t new_hash_count,
+    uint32_t* added_hash_count,
+    TLongtail_Hash* added_hashes,
+    uint32_t* removed_hash_count,
+    TLongtail_Hash* removed_hashes)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(reference_hashes, "%p"),
+        LONGTAIL_LOGFIELD(reference_hash_count, "%u"),
+        LONGTAIL_LOGFIELD(new_hashes, "%p"),
+        LONGTAIL_LOGFIELD(new_hash_count, "%u"),
+        LONGTAIL_LOGFIELD(added_hash_count, "%p"),
+        LONGTAIL_LOGFIELD(added_hashes, "%p"),
+        LONGTAIL_LOGFIELD(removed_hash_count, "%p"),
+        LONGTAIL_LOGFIELD(removed_hashes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, reference_hash_count == 0 || reference_hashes != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, new_hash_count == 0 || added_hashes != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, added_hash_count != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, added_hashes != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, (removed_hash_count == 0 && removed_hashes == 0) || (removed_hash_count != 0 && removed_hashes != 0), return EINVAL)
+
+    size_t work_mem_size = (sizeof(TLongtail_Hash) * reference_hash_count) +
+        (sizeof(TLongtail_Hash) * new_hash_count);
+    void* work_mem = Longtail_Alloc("DiffHashes", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+
+    TLongtail_Hash* tmp_refs = (TLongtail_Hash*)work_mem;
+    TLongtail_Hash* tmp_news = (TLongtail_Hash*)&tmp_refs[reference_hash_count];
+
+    memmove(tmp_refs, reference_hashes, (size_t)(sizeof(TLongtail_Hash) * reference_hash_count));
+    memmove(tmp_news, new_hashes, (size_t)(sizeof(TLongtail_Hash) * new_hash_count));
+
+    qsort(&tmp_refs[0], (size_t)reference_hash_count, sizeof(TLongtail_Hash), CompareHash);
+    reference_hash_count = MakeUnique(&tmp_refs[0], reference_hash_count);
+
+    qsort(&tmp_news[0], (size_t)new_hash_count, sizeof(TLongtail_Hash), CompareHash);
+    new_hash_count = MakeUnique(&tmp_news[0], new_hash_count);
+
+    uint32_t removed = 0;
+    uint32_t added = 0;
+    uint32_t ni = 0;
+    uint32_t ri = 0;
+    while (ri < reference_hash_count && ni < new_hash_count)
+    {
+        if (tmp_refs[ri] == tmp_news[ni])
+        {
+            ++ri;
+            ++ni;
+            continue;
+        }
+        else if (tmp_refs[ri] < tmp_news[ni])
+        {
+            if (removed_hashes)
+            {
+                removed_hashes[removed] = tmp_refs[ri];
+            }
+            ++removed;
+            ++ri;
+        }
+        else if (tmp_refs[ri] > tmp_news[ni])
+        {
+            added_hashes[added++] = tmp_news[ni++];
+        }
+    }
+    while (ni < new_hash_count)
+    {
+        added_hashes[added++] = tmp_news[ni++];
+    }
+    *added_hash_count = added;
+    while (ri < reference_hash_count)
+    {
+        if (removed_hashes)
+        {
+            removed_hashes[removed] = tmp_refs[ri];
+        }
+        ++removed;
+        ++ri;
+    }
+    if (removed_hash_count)
+    {
+        *removed_hash_count = removed;
+    }
+
+    Longtail_Free(work_mem);
+    work_mem = 0;
+
+    if (added > 0)
+    {
+        // Reorder the new hashes so they are in the same order that they where when they were created
+        // so chunks that belongs together are group together in blocks
+        struct Longtail_LookupTable* added_hashes_lookup = Longtail_LookupTable_Create(Longtail_Alloc("DiffHashes", Longtail_LookupTable_GetSize(added)), added, 0);
+        if (!added_hashes_lookup)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
+        for (uint32_t i = 0; i < added; ++i)
+        {
+            Longtail_LookupTable_Put(added_hashes_lookup, added_hashes[i], i);
+        }
+        added = 0;
+        for (uint32_t i = 0; i < new_hash_count; ++i)
+        {
+            TLongtail_Hash hash = new_hashes[i];
+            if (Longtail_LookupTable_Get(added_hashes_lookup, hash) == 0)
+            {
+                continue;
+            }
+            added_hashes[added++] = hash;
+        }
+        Longtail_Free(added_hashes_lookup);
+    }
+    return 0;
+}
+
+// Packs the chunks at @p chunk_indexes in order into blocks. If @p optional_asset_chunk_counts is given the chunks
+// are grouped by asset, @p asset_count entries with the number of consecutive chunks in @p chunk_indexes and the
+// size in @p optional_asset_sizes for each asset.
+static int PackStoreIndex(
+    struct Longtail_HashAPI* hash_api,
+    uint32_t chunk_count,
+    const uint32_t* chunk_indexes,
+    uint32_t asset_count,
+    const uint32_t* optional_asset_chunk_counts,
+    const uint64_t* optional_asset_sizes,
+    uint32_t target_chunk_size,
+    const TLongtail_Hash* chunk_hashes,
+    const uint32_t* chunk_sizes,
+    const uint32_t* optional_chunk_tags,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_indexes, "%p"),
+        LONGTAIL_LOGFIELD(asset_count, "%u"),
+        LONGTAIL_LOGFIELD(optional_asset_chunk_counts, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_sizes, "%p"),
+        LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
+        LONGTAIL_LOGFIELD(optional_chunk_tags, "%p"),
+        LONGTAIL_LOGFIELD(max_block_size, "%u"),
+        LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    size_t work_mem_size = (sizeof(struct Longtail_BlockIndex*) * chunk_count) +
+        (sizeof(uint32_t) * max_chunks_per_block);
+    void* work_mem = Longtail_Alloc("PackStoreIndex", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct Longtail_BlockIndex** tmp_block_indexes = (struct Longtail_BlockIndex**)work_mem;
+    uint32_t* tmp_stored_chunk_indexes = (uint32_t*)&tmp_block_indexes[chunk_count];
+
+    uint32_t block_count = 0;
+    uint32_t chunk_count_in_block = 0;
+    uint64_t current_size = 0;
+    uint32_t current_tag = 0;
+
+    uint32_t asset_index = 0;
+    uint32_t asset_chunk_end = 0;
+
+    int err = 0;
+    for (uint32_t i = 0; i <= chunk_count && !err; ++i)
+    {
+        int close_block = (i == chunk_count);
+        uint32_t chunk_index = 0;
+        uint32_t chunk_size = 0;
+        uint32_t tag = 0;
+        if (!close_block)
+        {
+            chunk_index = chunk_indexes[i];
+            chunk_size = chunk_sizes[chunk_index];
+            tag = optional_chunk_tags ? optional_chunk_tags[chunk_index] : 0;
+
+            if (optional_asset_chunk_counts && i == asset_chunk_end)
+            {
+                while (optional_asset_chunk_counts[asset_index] == 0)
+                {
+                    ++asset_index;
+                }
+                LONGTAIL_FATAL_ASSERT(ctx, asset_index < asset_count, return EINVAL)
+                uint32_t asset_chunk_count = optional_asset_chunk_counts[asset_index];
+                uint64_t asset_chunks_size = 0;
+                for (uint32_t a = i; a < i + asset_chunk_count; ++a)
+                {
+                    asset_chunks_size += chunk_sizes[chunk_indexes[a]];
+                }
+                asset_chunk_end = i + asset_chunk_count;
+                close_block = ShouldCloseBlockForAsset(chunk_count_in_block, current_size, optional_asset_sizes[asset_index], target_chunk_size, asset_chunk_count, asset_chunks_size, max_block_size, max_chunks_per_block);
+                ++asset_index;
+            }
+
+            if (chunk_count_in_block > 0)
+            {
+                close_block = close_block ||
+                    (tag != current_tag) ||
+                    // Break if resulting chunk count will exceed max_chunks_per_block
+                    (chunk_count_in_block == max_chunks_per_block) ||
+                    // Overshoot by 10% is ok
+                    ((current_size + chunk_size) > (max_block_size + (max_block_size / 10)));
+            }
+        }
+
+        if (close_block && chunk_count_in_block > 0)
+        {
+            err = Longtail_CreateBlockIndex(
+                hash_api,
+                current_tag,
+                chunk_count_in_block,
+                tmp_stored_chunk_indexes,
+                chunk_hashes,
+                chunk_sizes,
+                &tmp_block_indexes[block_count]);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateBlockIndex() failed with %d", err)
+                break;
+            }
+            ++block_count;
+            chunk_count_in_block = 0;
+            current_size = 0;
+        }
+
+        if (i < chunk_count)
+        {
+            if (chunk_count_in_block == 0)
+            {
+                current_tag = tag;
+            }
+            tmp_stored_chunk_indexes[chunk_count_in_block++] = chunk_index;
+            current_size += chunk_size;
+        }
+    }
+
+    if (!err)
+    {
+        err = Longtail_CreateStoreIndexFromBlocks(
+            block_count,
+            (const struct Longtail_BlockIndex**)tmp_block_indexes,
+            out_store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+        }
+    }
+
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        Longtail_Free(tmp_block_indexes[b]);
+    }
+    Longtail_Free(work_mem);
+    return err;
+}
+
+int Longtail_CreateStoreIndex(
+    struct Longtail_HashAPI* hash_api,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    const uint32_t* chunk_sizes,
+    const uint32_t* optional_chunk_tags,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
+        LONGTAIL_LOGFIELD(optional_chunk_tags, "%p"),
+        LONGTAIL_LOGFIELD(max_block_size, "%u"),
+        LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || max_block_size != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || max_chunks_per_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_store_index != 0, return EINVAL)
+
+    if (chunk_count == 0)
+    {
+        int err = Longtail_CreateStoreIndexFromBlocks(0, 0, out_store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+            return err;
+        }
+        return 0;
+    }
+
+    uint32_t* tmp_chunk_indexes = (uint32_t*)Longtail_Alloc("Longtail_CreateStoreIndex", sizeof(uint32_t) * chunk_count);
+    if (!tmp_chunk_indexes)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    uint32_t unique_chunk_count = GetUniqueHashes((uint32_t)chunk_count, chunk_hashes, tmp_chunk_indexes);
+
+    int err = PackStoreIndex(
+        hash_api,
+        unique_chunk_count,
+        tmp_chunk_indexes,
+        0,
+        0,
+        0,
+        0,
+        chunk_hashes,
+        chunk_sizes,
+        optional_chunk_tags,
+        max_block_size,
+        max_chunks_per_block,
+        out_store_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PackStoreIndex() failed with %d", err)
+    }
+    Longtail_Free(tmp_chunk_indexes);
+    return err;
+}
+
+int Longtail_CreateMissingContent(
+    struct Longtail_HashAPI* hash_api,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(max_block_size, "%u"),
+        LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, max_block_size != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, max_chunks_per_block != 0, return EINVAL)
+
+    uint32_t chunk_count = *version_index->m_ChunkCount;
+    size_t added_hashes_size = sizeof(TLongtail_Hash) * chunk_count;
+    TLongtail_Hash* added_hashes = (TLongtail_Hash*)Longtail_Alloc("CreateMissingContent", added_hashes_size);
+    if (!added_hashes)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+
+    uint32_t added_hash_count = 0;
+    int err = DiffHashes(
+        store_index->m_ChunkHashes,
+        *store_index->m_ChunkCount,
+        version_index->m_ChunkHashes,
+        chunk_count,
+        &added_hash_count,
+        added_hashes,
+        0,
+        0);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "DiffHashes() failed with %d", err)
+        Longtail_Free(added_hashes);
+        return err;
+    }
+
+    if (added_hash_count == 0)
+    {
+        Longtail_Free(added_hashes);
+        err = Longtail_CreateStoreIndexFromBlocks(
+            0,
+            0,
+            out_store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+        }
+        return err;
+    }
+
+    // Added chunks are packed per asset in version order, see ShouldCloseBlockForAsset()
+    uint32_t asset_count = *version_index->m_AssetCount;
+    size_t added_lookup_size = Longtail_LookupTable_GetSize(added_hash_count);
+    size_t work_mem_size =
+        added_lookup_size +
+        (sizeof(uint8_t) * added_hash_count) +
+        (sizeof(uint32_t) * added_hash_count) +
+        (sizeof(uint32_t) * asset_count);
+    void* work_mem = Longtail_Alloc("CreateMissingContent", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(added_hashes);
+        return ENOMEM;
+    }
+    char* p = (char*)work_mem;
+    struct Longtail_LookupTable* added_lookup = Longtail_LookupTable_Create(p, added_hash_count, 0);
+    p += added_lookup_size;
+    uint32_t* packed_chunk_indexes = (uint32_t*)p;
+    p += sizeof(uint32_t) * added_hash_count;
+    uint32_t* asset_packed_chunk_counts = (uint32_t*)p;
+    p += sizeof(uint32_t) * asset_count;
+    uint8_t* is_packed = (uint8_t*)p;
+    memset(is_packed, 0, added_hash_count);
+
+    for (uint32_t j = 0; j < added_hash_count; ++j)
+    {
+        Longtail_LookupTable_Put(added_lookup, added_hashes[j], j);
+    }
+
+    uint32_t packed_chunk_count = 0;
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        uint32_t asset_chunk_start = version_index->m_AssetChunkIndexStarts[a];
+        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[a];
+        uint32_t asset_packed_chunk_start = packed_chunk_count;
+        for (uint32_t c = 0; c < asset_chunk_count; ++c)
+        {
+            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_start + c];
+            const uint32_t* added_index = Longtail_LookupTable_Get(added_lookup, version_index->m_ChunkHashes[chunk_index]);
+            if (added_index == 0 || is_packed[*added_index])
+            {
+                continue;
+            }
+            is_packed[*added_index] = 1;
+            packed_chunk_indexes[packed_chunk_count++] = chunk_index;
+        }
+        asset_packed_chunk_counts[a] = packed_chunk_count - asset_packed_chunk_start;
+    }
+    LONGTAIL_FATAL_ASSERT(ctx, packed_chunk_count == added_hash_count, return EINVAL)
+
+    err = PackStoreIndex(
+        hash_api,
+        packed_chunk_count,
+        packed_chunk_indexes,
+        asset_count,
+        asset_packed_chunk_counts,
+        version_index->m_AssetSizes,
+        *version_index->m_TargetChunkSize,
+        version_index->m_ChunkHashes,
+        version_index->m_ChunkSizes,
+        version_index->m_ChunkTags,
+        max_block_size,
+        max_chunks_per_block,
+        out_store_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PackStoreIndex() failed with %d", err)
+    }
+
+    Longtail_Free(work_mem);
+    Longtail_Free(added_hashes);
+
+    return err;
+}
+
+int Longtail_GetBlocksTouchedPerAsset(
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    uint32_t* out_asset_count,
+    uint64_t* out_blocks_touched_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(out_asset_count, "%p"),
+        LONGTAIL_LOGFIELD(out_blocks_touched_count, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_asset_count != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_blocks_touched_count != 0, return EINVAL)
+
+    uint32_t block_count = *store_index->m_BlockCount;
+    uint32_t store_chunk_count = *store_index->m_ChunkCount;
+    size_t chunk_to_block_lookup_size = Longtail_LookupTable_GetSize(store_chunk_count);
+    size_t work_mem_size = chunk_to_block_lookup_size + (sizeof(uint32_t) * block_count);
+    void* work_mem = Longtail_Alloc("GetBlocksTouchedPerAsset", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct Longtail_LookupTable* chunk_to_block_lookup = Longtail_LookupTable_Create(work_mem, store_chunk_count, 0);
+    // The last asset, plus one, that touched each block
+    uint32_t* block_last_asset = (uint32_t*)&((char*)work_mem)[chunk_to_block_lookup_size];
+    memset(block_last_asset, 0, sizeof(uint32_t) * block_count);
+
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        uint32_t block_chunk_offset = store_index->m_BlockChunksOffsets[b];
+        uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
+        for (uint32_t c = 0; c < block_chunk_count; ++c)
+        {
+            Longtail_LookupTable_PutUnique(chunk_to_block_lookup, store_index->m_ChunkHashes[block_chunk_offset + c], b);
+        }
+    }
+
+    uint32_t asset_count = 0;
+    uint64_t blocks_touched_count = 0;
+    for (uint32_t a = 0; a < *version_index->m_AssetCount; ++a)
+    {
+        uint32_t asset_chunk_start = version_index->m_AssetChunkIndexStarts[a];
+        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[a];
+        uint32_t asset_blocks_touched = 0;
+        for (uint32_t c = 0; c < asset_chunk_count; ++c)
+        {
+            uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_start + c];
+            const uint32_t* block_index = Longtail_LookupTable_Get(chunk_to_block_lookup, version_index->m_ChunkHashes[chunk_index]);
+            if (block_index == 0 || block_last_asset[*block_index] == a + 1)
+            {
+                continue;
+            }
+            block_last_asset[*block_index] = a + 1;
+            ++asset_blocks_touched;
+        }
+        if (asset_blocks_touched > 0)
+        {
+            ++asset_count;
+            blocks_touched_count += asset_blocks_touched;
+        }
+    }
+
+    Longtail_Free(work_mem);
+    *out_asset_count = asset_count;
+    *out_blocks_touched_count = blocks_touched_count;
+    return 0;
+}
+
+int Longtail_GetMissingChunks(
+    const struct Longtail_StoreIndex* store_index,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    uint32_t* out_chunk_count,
+    TLongtail_Hash* out_missing_chunk_hashes)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(out_chunk_count, "%p"),
+        LONGTAIL_LOGFIELD(out_missing_chunk_hashes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_chunk_count != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (out_missing_chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count <= 0xffffffffu, return EINVAL)
+
+    uint32_t reference_chunk_count = *store_index->m_ChunkCount;
+    void* chunk_to_reference_block_index_lookup_mem = Longtail_Alloc("GetMissingChunks", Longtail_LookupTable_GetSize(reference_chunk_count));
+    if (!chunk_to_reference_block_index_lookup_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct Longtail_LookupTable* chunk_to_reference_block_index_lookup = Longtail_LookupTable_Create(chunk_to_reference_block_index_lookup_mem, reference_chunk_count, 0);
+    LONGTAIL_FATAL_ASSERT(ctx, chunk_to_reference_block_index_lookup != 0, return EINVAL )
+
+    uint32_t reference_block_count = *store_index->m_BlockCount;
+    for (uint32_t b = 0; b < reference_block_count; ++b)
+    {
+        uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
+        uint32_t chunk_index_offset = store_index->m_BlockChunksOffsets[b];
+        for (uint32_t c = 0; c < block_chunk_count; ++c)
+    {
+            uint32_t chunk_index = chunk_index_offset + c;
+            TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_index];
+            Longtail_LookupTable_PutUnique(chunk_to_reference_block_index_lookup, chunk_hash, b);
+        }
+    }
+
+    uint32_t missing_chunk_count = 0;
+    for (uint32_t c = 0; c < (uint32_t)chunk_count; ++c)
+    {
+        TLongtail_Hash chunk_hash = chunk_hashes[c];
+        if (Longtail_LookupTable_Get(chunk_to_reference_block_index_lookup, chunk_hash))
+        {
+            continue;
+        }
+        out_missing_chunk_hashes[missing_chunk_count++] = chunk_hash;
+    }
+    Longtail_Free(chunk_to_reference_block_index_lookup);
+    *out_chunk_count = missing_chunk_count;
+    return 0;
+}
+
+static SORTFUNC(SortBlockUsageHighToLow)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(a_ptr, "%p"),
+        LONGTAIL_LOGFIELD(b_ptr, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
+
+    const uint32_t* block_usages = (const uint32_t*)context;
+    const uint32_t a_index = *(const uint32_t*)a_ptr;
+    const uint32_t b_index = *(const uint32_t*)b_ptr;
+    const uint32_t a_usage = block_usages[a_index];
+    const uint32_t b_usage = block_usages[b_index];
+    return (a_usage < b_usage) ?
+        1 : ((a_usage > b_usage) ?
+            -1 : ((a_index < b_index) ?
+                -1 : ((a_index == b_index) ?
+                    0 : 1)));
+}
+
+int Longtail_GetExistingStoreIndex(
+    const struct Longtail_StoreIndex* store_index,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunks,
+    uint32_t min_block_usage_percent,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunks, "%p"),
+        LONGTAIL_LOGFIELD(min_block_usage_percent, "%u"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunks != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_store_index != 0, return EINVAL)
+
+    uint32_t hash_identifier = *store_index->m_HashIdentifier;
+    uint32_t store_block_count = *store_index->m_BlockCount;
+    uint32_t store_chunk_count = *store_index->m_ChunkCount;
+
+    size_t chunk_to_index_lookup_size = Longtail_LookupTable_GetSize(chunk_count);
+    size_t block_to_index_lookup_size = Longtail_LookupTable_GetSize(store_block_count);
+    size_t chunk_to_store_index_lookup_size = Longtail_LookupTable_GetSize(chunk_count);
+    size_t found_store_block_hashes_size = sizeof(TLongtail_Hash) * store_block_count;
+    size_t block_uses_percent_size = sizeof(uint32_t) * store_block_count;
+    size_t block_index_size = sizeof(uint32_t) * store_block_count;
+    size_t block_order_size = sizeof(uint32_t) * store_block_count;
+
+    size_t tmp_mem_size = chunk_to_index_lookup_size +
+        block_to_index_lookup_size +
+        chunk_to_store_index_lookup_size +
+        found_store_block_hashes_size +
+        block_uses_percent_size +
+        block_index_size +
+        block_order_size;
+
+    void* tmp_mem = Longtail_Alloc("Longtail_GetExistingStoreIndex", tmp_mem_size);
+    if (!tmp_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    char* p = (char*)tmp_mem;
+
+    struct Longtail_LookupTable* chunk_to_index_lookup = Longtail_LookupTable_Create(p, chunk_count, 0);
+    p += chunk_to_index_lookup_size;
+
+    struct Longtail_LookupTable* block_to_index_lookup = Longtail_LookupTable_Create(p, store_block_count, 0);
+    p += block_to_index_lookup_size;
+
+    struct Longtail_LookupTable* chunk_to_store_index_lookup = Longtail_LookupTable_Create(p, chunk_count, 0);
+    p += chunk_to_store_index_lookup_size;
+
+    TLongtail_Hash* found_store_block_hashes = (TLongtail_Hash*)p;
+    p += found_store_block_hashes_size;
+
+    uint32_t* block_uses_percent = (uint32_t*)p;
+    p += block_uses_percent_size;
+
+    uint32_t* block_index = (uint32_t*)p;
+    p += block_index_size;
+
+    uint32_t* block_order = (uint32_t*)p;
+    p += block_order_size;
+
+    uint32_t unique_chunk_count = 0;
+    for (uint32_t i = 0; i < chunk_count; ++i)
+    {
+        TLongtail_Hash chunk_hash = chunks[i];
+        uint32_t* c_ptr = Longtail_LookupTable_PutUnique(chunk_to_index_lookup, chunk_hash, i);
+        if (c_ptr)
+        {
+            continue;
+        }
+        ++unique_chunk_count;
+    }
+
+    uint32_t found_block_count = 0;
+    uint32_t found_chunk_count = 0;
+    if (min_block_usage_percent <= 100)
+    {
+        uint32_t potential_block_count = 0;
+        for (uint32_t b = 0; b < store_block_count; ++b)
+        {
+            uint32_t block_use = 0;
+            uint32_t block_size = 0;
+            TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
+            uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
+            uint32_t chunk_offset = store_index->m_BlockChunksOffsets[b];
+            for (uint32_t c = 0; c < block_chunk_count; ++c)
+            {
+                uint32_t chunk_size = store_index->m_ChunkSizes[chunk_offset];
+                TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_offset];
+                ++chunk_offset;
+                block_size += chunk_size;
+                if (Longtail_LookupTable_Get(chunk_to_index_lookup, chunk_hash))
+                {
+                    block_use += chunk_size;
+                }
+            }
+            if (block_use > 0)
+            {
+                uint32_t block_usage_percent = (uint32_t)(((uint64_t)block_use * 100) / block_size);
+                if (min_block_usage_percent > 0 &&
+                    block_usage_percent < min_block_usage_percent) {
+                    continue;
+                }
+
+                block_order[potential_block_count] = potential_block_count;
+                block_index[potential_block_count] = b;
+                block_uses_percent[potential_block_count] = block_usage_percent;
+
+                ++potential_block_count;
+            }
+        }
+
+        if (potential_block_count == 0)
+        {
+            Longtail_Free(tmp_mem);
+            return Longtail_CreateStoreIndexFromBlocks(
+                0,
+                0,
+                out_store_index);
+        }
+
+        // Favour blocks we use more data out of - if a chunk is in mutliple blocks we want to pick
+        // the blocks that has highest ratio of use inside the block.
+        // This does not guarantee a perfect block match as one block can be a 100% match which
+        // could lead to skipping part or whole of another 100% match block resulting in us
+        // picking a block that we will not use 100% of
+        QSORT(block_order, potential_block_count, sizeof(uint32_t), SortBlockUsageHighToLow, (void*)block_uses_percent);
+
+        for (uint32_t bo = 0; (bo < potential_block_count) && (found_chunk_count < unique_chunk_count); ++bo)
+        {
+            uint32_t pb = block_order[bo];
+            uint32_t b = block_index[pb];
+
+            TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
+            uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
+            uint32_t store_chunk_index_offset = store_index->m_BlockChunksOffsets[b];
+            uint32_t current_found_block_index = found_block_count;
+            for (uint32_t c = 0; c < block_chunk_count; ++c)
+            {
+                TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[store_chunk_index_offset];
+                if (!Longtail_LookupTable_Get(chunk_to_index_lookup, chunk_hash))
+                {
+                    ++store_chunk_index_offset;
+                    continue;
+                }
+                if (Longtail_LookupTable_PutUnique(chunk_to_store_index_lookup, chunk_hash, store_chunk_index_offset))
+                {
+                    ++store_chunk_index_offset;
+                    continue;
+                }
+                found_chunk_count++;
+                if (current_found_block_index == found_block_count)
+                {
+                    uint32_t* block_index_ptr = Longtail_LookupTable_PutUnique(block_to_index_lookup, block_hash, current_found_block_index);
+                    if (block_index_ptr == 0)
+                    {
+                        found_store_block_hashes[found_block_count++] = block_hash;
+                    }
+                    ++store_chunk_index_offset;
+                    continue;
+                }
+                ++store_chunk_index_offset;
+            }
+        }
+    }
+
+    if (found_block_count == 0)
+    {
+        Longtail_Free(tmp_mem);
+        return Longtail_CreateStoreIndexFromBlocks(
+            0,
+            0,
+            out_store_index);
+    }
+
+    // We have a list of block hashes we want to keep in found_store_block_hashes
+    // We have a lookup from block hash to block index in store index in block_to_index_lookup
+
+    size_t block_hash_lookup_size = Longtail_LookupTable_GetSize(found_block_count);
+    size_t block_index_header_ptrs_size = sizeof(struct LongtailBlockIndex*) * found_block_count;
+    size_t block_index_headers_size = sizeof(struct Longtail_BlockIndex) * found_block_count;
+    size_t tmp_mem_2_size = block_index_header_ptrs_size +
+        block_index_headers_size +
+        block_hash_lookup_size;
+    void* tmp_mem_2 = Longtail_Alloc("Longtail_GetExistingStoreIndex", tmp_mem_2_size);
+    if (!tmp_mem_2){
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(tmp_mem);
+        return ENOMEM;
+
+    }
+    struct Longtail_BlockIndex** block_index_header_ptrs = (struct Longtail_BlockIndex**)tmp_mem_2;
+    struct Longtail_BlockIndex* block_index_headers = (struct Longtail_BlockIndex*)&block_index_header_ptrs[found_block_count];
+    struct Longtail_LookupTable* block_hash_lookup = Longtail_LookupTable_Create(&((char*)block_index_headers)[block_index_headers_size], found_block_count, 0);
+    for (uint32_t b = 0; b < store_block_count; ++b)
+    {
+        TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
+        if (0 == Longtail_LookupTable_Get(block_to_index_lookup, block_hash))
+        {
+            continue;
+        }
+        Longtail_LookupTable_Put(block_hash_lookup, block_hash, b);
+    }
+
+    for (uint32_t b = 0; b < found_block_count; ++b)
+    {
+        TLongtail_Hash block_hash = found_store_block_hashes[b];
+        uint32_t store_block_index = *Longtail_LookupTable_Get(block_hash_lookup, block_hash);
+        uint32_t block_chunk_count = store_index->m_BlockChunkCounts[store_block_index];
+        uint32_t block_chunk_index_offset = store_index->m_BlockChunksOffsets[store_block_index];
+        block_index_headers[b].m_BlockHash = &store_index->m_BlockHashes[store_block_index];
+        block_index_headers[b].m_HashIdentifier = store_index->m_HashIdentifier;
+        block_index_headers[b].m_ChunkCount = &store_index->m_BlockChunkCounts[store_block_index];
+        block_index_headers[b].m_Tag = &store_index->m_BlockTags[block_chunk_index_offset];
+        block_index_headers[b].m_ChunkHashes = &store_index->m_ChunkHashes[block_chunk_index_offset];
+        block_index_headers[b].m_ChunkSizes = &store_index->m_ChunkSizes[block_chunk_index_offset];
+        block_index_header_ptrs[b] = &block_index_headers[b];
+    }
+    Longtail_Free(tmp_mem);
+
+    int err = Longtail_CreateStoreIndexFromBlocks(
+        found_block_count,
+        (const struct Longtail_BlockIndex**)block_index_header_ptrs,
+        out_store_index);
+    Longtail_Free(tmp_mem_2);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+        return err;
+    }
+    return 0;
+}
+
+static int CompareHashes(const void* a_ptr, const void* b_ptr)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(a_ptr, "%p"),
+        LONGTAIL_LOGFIELD(b_ptr, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
+
+    TLongtail_Hash a = *(const TLongtail_Hash*)a_ptr;
+    TLongtail_Hash b = *(const TLongtail_Hash*)b_ptr;
+    return (a > b) ? 1 : (a < b) ? -1 : 0;
+}
+
+static SORTFUNC(SortPathShortToLong)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(a_ptr, "%p"),
+        LONGTAIL_LOGFIELD(b_ptr, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
+
+    const struct Longtail_VersionIndex* version_index = (const struct Longtail_VersionIndex*)context;
+    uint32_t a = *(const uint32_t*)a_ptr;
+    uint32_t b = *(const uint32_t*)b_ptr;
+    const char* a_path = &version_index->m_NameData[version_index->m_NameOffsets[a]];
+    const char* b_path = &version_index->m_NameData[version_index->m_NameOffsets[b]];
+    size_t a_len = strlen(a_path);
+    size_t b_len = strlen(b_path);
+    return (a_len > b_len) ? 1 : (a_len < b_len) ? -1 : 0;
+}
+
+static SORTFUNC(SortPathLongToShort)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(a_ptr, "%p"),
+        LONGTAIL_LOGFIELD(b_ptr, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
+
+    const struct Longtail_VersionIndex* version_index = (const struct Longtail_VersionIndex*)context;
+    uint32_t a = *(const uint32_t*)a_ptr;
+    uint32_t b = *(const uint32_t*)b_ptr;
+    const char* a_path = &version_index->m_NameData[version_index->m_NameOffsets[a]];
+    const char* b_path = &version_index->m_NameData[version_index->m_NameOffsets[b]];
+    size_t a_len = strlen(a_path);
+    size_t b_len = strlen(b_path);
+    return (a_len < b_len) ? 1 : (a_len > b_len) ? -1 : 0;
+}
+
+static size_t GetVersionDiffDataSize(uint32_t removed_count, uint32_t added_count, uint32_t modified_content_count, uint32_t modified_permission_count, uint32_t moved_count)
+{
+    return
+        sizeof(uint32_t) +                              // m_SourceRemovedCount
+        sizeof(uint32_t) +                              // m_TargetAddedCount
+        sizeof(uint32_t) +                              // m_ModifiedContentCount
+        sizeof(uint32_t) +                              // m_ModifiedPermissionsCount
+        sizeof(uint32_t) +                              // m_MovedCount
+        sizeof(uint32_t) * removed_count +              // m_SourceRemovedAssetIndexes
+        sizeof(uint32_t) * added_count +                // m_TargetAddedAssetIndexes
+        sizeof(uint32_t) * modified_content_count +     // m_SourceContentModifiedAssetIndexes
+        sizeof(uint32_t) * modified_content_count +     // m_TargetContentModifiedAssetIndexes
+        sizeof(uint32_t) * modified_permission_count +  // m_SourcePermissionsModifiedAssetIndexes
+        sizeof(uint32_t) * modified_permission_count +  // m_TargetPermissionsModifiedAssetIndexes
+        sizeof(uint32_t) * moved_count +                // m_SourceMovedAssetIndexes
+        sizeof(uint32_t) * moved_count;                 // m_TargetMovedAssetIndexes
+}
+
+static size_t GetVersionDiffSize(uint32_t removed_count, uint32_t added_count, uint32_t modified_content_count, uint32_t modified_permission_count, uint32_t moved_count)
+{
+    return sizeof(struct Longtail_VersionDiff) +
+        GetVersionDiffDataSize(removed_count, added_count, modified_content_count, modified_permission_count, moved_count);
+}
+
+static void InitVersionDiff(struct Longtail_VersionDiff* version_diff)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version_diff, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, version_diff != 0, return)
+
+    char* p = (char*)version_diff;
+    p += sizeof(struct Longtail_VersionDiff);
+
+    version_diff->m_SourceRemovedCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    version_diff->m_TargetAddedCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    version_diff->m_ModifiedContentCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    version_diff->m_ModifiedPermissionsCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    version_diff->m_MovedCount = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t);
+
+    uint32_t removed_count = *version_diff->m_SourceRemovedCount;
+    uint32_t added_count = *version_diff->m_TargetAddedCount;
+    uint32_t modified_content_count = *version_diff->m_ModifiedContentCount;
+    uint32_t modified_permissions_count = *version_diff->m_ModifiedPermissionsCount;
+    uint32_t moved_count = *version_diff->m_MovedCount;
+
+    version_diff->m_SourceRemovedAssetIndexes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * removed_count;
+
+    version_diff->m_TargetAddedAssetIndexes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * added_count;
+
+    version_diff->m_SourceContentModifiedAssetIndexes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * modified_content_count;
+
+    version_diff->m_TargetContentModifiedAssetIndexes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * modified_content_count;
+
+    version_diff->m_SourcePermissionsModifiedAssetIndexes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * modified_permissions_count;
+
+    version_diff->m_TargetPermissionsModifiedAssetIndexes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * modified_permissions_count;
+
+    version_diff->m_SourceMovedAssetIndexes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * moved_count;
+
+    version_diff->m_TargetMovedAssetIndexes = (uint32_t*)(void*)p;
+    p += sizeof(uint32_t) * moved_count;
+}
+
+int Longtail_CreateVersionDiff(
+    struct Longtail_HashAPI* hash_api,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    struct Longtail_VersionDiff** out_version_diff)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(source_version, "%p"),
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(out_version_diff, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, source_version != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, target_version != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_version_diff != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api->GetIdentifier(hash_api) == *source_version->m_HashIdentifier, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api->GetIdentifier(hash_api) == *target_version->m_HashIdentifier, return EINVAL)
+
+    uint32_t source_asset_count = *source_version->m_AssetCount;
+    uint32_t target_asset_count = *target_version->m_AssetCount;
+
+    size_t source_asset_lookup_table_size = Longtail_LookupTable_GetSize(source_asset_count);
+    size_t target_asset_lookup_table_size = Longtail_LookupTable_GetSize(target_asset_count);
+
+    size_t work_mem_size =
+        source_asset_lookup_table_size +
+        target_asset_lookup_table_size +
+        source_asset_lookup_table_size +
+        sizeof(uint32_t) * source_asset_count +
+        sizeof(uint32_t) * source_asset_count +
+        sizeof(uint32_t) * source_asset_count +
+        sizeof(TLongtail_Hash) * source_asset_count +
+        sizeof(TLongtail_Hash) * target_asset_count +
+        sizeof(uint32_t) * source_asset_count +
+        sizeof(uint32_t) * target_asset_count +
+        sizeof(uint32_t) * source_asset_count +
+        sizeof(uint32_t) * target_asset_count +
+        sizeof(uint32_t) * source_asset_count +
+        sizeof(uint32_t) * target_asset_count;
+    void* work_mem = Longtail_Alloc("CreateVersionDiff", work_mem_size);
+    uint8_t* p = (uint8_t*)work_mem;
+
+    struct Longtail_LookupTable* source_path_hash_to_index = Longtail_LookupTable_Create(p, source_asset_count ,0);
+    p += source_asset_lookup_table_size;
+    struct Longtail_LookupTable* target_path_hash_to_index = Longtail_LookupTable_Create(p, target_asset_count ,0);
+    p += target_asset_lookup_table_size;
+    struct Longtail_LookupTable* content_hash_to_removed = Longtail_LookupTable_Create(p, source_asset_count ,0);
+    p += source_asset_lookup_table_size;
+
+    TLongtail_Hash* source_path_hashes = (TLongtail_Hash*)p;
+    TLongtail_Hash* target_path_hashes = &source_path_hashes[source_asset_count];
+
+    uint32_t* removed_source_asset_indexes = (uint32_t*)&target_path_hashes[target_asset_count];
+    uint32_t* added_target_asset_indexes = &removed_source_asset_indexes[source_asset_count];
+
+    uint32_t* modified_source_content_indexes = &added_target_asset_indexes[target_asset_count];
+    uint32_t* modified_target_content_indexes = &modified_source_content_indexes[source_asset_count];
+
+    uint32_t* modified_source_permissions_indexes = &modified_target_content_indexes[target_asset_count];
+    uint32_t* modified_target_permissions_indexes = &modified_source_permissions_indexes[source_asset_count];
+
+    uint32_t* moved_source_asset_indexes = &modified_target_permissions_indexes[target_asset_count];
+    uint32_t* moved_target_asset_indexes = &moved_source_asset_indexes[source_asset_count];
+    uint32_t* next_removed_with_content = &moved_target_asset_indexes[source_asset_count];
+
+    for (uint32_t i = 0; i < source_asset_count; ++i)
+    {
+        // We are re-hashing since we might have an older version hash that is incompatible
+        const char* path = &source_version->m_NameData[source_version->m_NameOffsets[i]];
+        int err = Longtail_GetPathHash(hash_api, path, &source_path_hashes[i]);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_GetPathHash() failed with %d", err)
+            Longtail_Free(work_mem);
+            return err;
+        }
+        Longtail_LookupTable_Put(source_path_hash_to_index, source_path_hashes[i], i);
+    }
+
+    for (uint32_t i = 0; i < target_asset_count; ++i)
+    {
+        // We are re-hashing since we might have an older version hash that is incompatible
+        const char* path = &target_version->m_NameData[target_version->m_NameOffsets[i]];
+        int err = Longtail_GetPathHash(hash_api, path, &target_path_hashes[i]);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_GetPathHash() failed with %d", err)
+            Longtail_Free(work_mem);
+            return err;
+        }
+        Longtail_LookupTable_Put(target_path_hash_to_index, target_path_hashes[i], i);
+    }
+
+    qsort(source_path_hashes, source_asset_count, sizeof(TLongtail_Hash), CompareHashes);
+    qsort(target_path_hashes, target_asset_count, sizeof(TLongtail_Hash), CompareHashes);
+
+    const uint32_t max_modified_content_count = source_asset_count < target_asset_count ? source_asset_count : target_asset_count;
+    const uint32_t max_modified_permission_count = source_asset_count < target_asset_count ? source_asset_count : target_asset_count;
+    const uint32_t indexes_count = source_asset_count + target_asset_count + max_modified_content_count + max_modified_content_count + max_modified_permission_count + max_modified_permission_count;
+
+    uint32_t source_removed_count = 0;
+    uint32_t target_added_count = 0;
+    uint32_t modified_content_count = 0;
+    uint32_t modified_permissions_count = 0;
+
+    uint32_t source_index = 0;
+    uint32_t target_index = 0;
+    while (source_index < source_asset_count && target_index < target_asset_count)
+    {
+        TLongtail_Hash source_path_hash = source_path_hashes[source_index];
+        TLongtail_Hash target_path_hash = target_path_hashes[target_index];
+        const uint32_t* source_asset_index_ptr = Longtail_LookupTable_Get(source_path_hash_to_index, source_path_hash);
+        LONGTAIL_FATAL_ASSERT(ctx, source_asset_index_ptr, return EINVAL)
+        uint32_t source_asset_index = *source_asset_index_ptr;
+        const uint32_t* target_asset_index_ptr = Longtail_LookupTable_Get(target_path_hash_to_index, target_path_hash);
+        LONGTAIL_FATAL_ASSERT(ctx, target_asset_index_ptr, return EINVAL)
+        uint32_t target_asset_index = *target_asset_index_ptr;
+
+        const char* source_path = &source_version->m_NameData[source_version->m_NameOffsets[source_asset_index]];
+        const char* target_path = &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]];
+
+        if (source_path_hash == target_path_hash)
+        {
+            TLongtail_Hash source_content_hash = source_version->m_ContentHashes[source_asset_index];
+            TLongtail_Hash target_content_hash = target_version->m_ContentHashes[target_asset_index];
+            if (source_content_hash != target_content_hash)
+            {
+                modified_source_content_indexes[modified_content_count] = source_asset_index;
+                modified_target_content_indexes[modified_content_count] = target_asset_index;
+                ++modified_content_count;
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching content for asset %s", source_path)
+            }
+            else
+            {
+                uint16_t source_permissions = source_version->m_Permissions[source_asset_index];
+                uint16_t target_permissions = target_version->m_Permissions[target_asset_index];
+                if (source_permissions != target_permissions)
+                {
+                    modified_source_permissions_indexes[modified_permissions_count] = source_asset_index;
+                    modified_target_permissions_indexes[modified_permissions_count] = target_asset_index;
+                    ++modified_permissions_count;
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching permissions for asset %s", source_path)
+                }
+            }
+
+            ++source_index;
+            ++target_index;
+        }
+        else if (source_path_hash < target_path_hash)
+        {
+            const uint32_t* source_asset_index_ptr = Longtail_LookupTable_Get(source_path_hash_to_index, source_path_hash);
+            LONGTAIL_FATAL_ASSERT(ctx, source_asset_index_ptr, return EINVAL)
+            source_asset_index = *source_asset_index_ptr;
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Removed asset %s", source_path)
+            removed_source_asset_indexes[source_removed_count] = source_asset_index;
+            ++source_removed_count;
+            ++source_index;
+        }
+        else
+        {
+            const uint32_t* target_asset_index_ptr = Longtail_LookupTable_Get(target_path_hash_to_index, target_path_hash);
+            LONGTAIL_FATAL_ASSERT(ctx, target_asset_index_ptr, return EINVAL)
+            target_asset_index = *target_asset_index_ptr;
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Added asset %s", target_path)
+            added_target_asset_indexes[target_added_count] = target_asset_index;
+            ++target_added_count;
+            ++target_index;
+        } 
+    }
+    while (source_index < source_asset_count)
     {
-        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
-        Longtail_Free(asset_jobs);
-        Longtail_Free(block_jobs);
-        return err;
+        // source_path_hash removed
+        TLongtail_Hash source_path_hash = source_path_hashes[source_index];
+        const uint32_t* source_asset_index_ptr = Longtail_LookupTable_Get(source_path_hash_to_index, source_path_hash);
+        LONGTAIL_FATAL_ASSERT(ctx, source_asset_index_ptr, return EINVAL)
+        uint32_t source_asset_index = *source_asset_index_ptr;
+        const char* source_path = &source_version->m_NameData[source_version->m_NameOffsets[source_asset_index]];
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Removed asset %s", source_path)
+        removed_source_asset_indexes[source_removed_count] = source_asset_index;
+        ++source_removed_count;
+        ++source_index;
+    }
+    while (target_index < target_asset_count)
+    {
+        // target_path_hash added
+        TLongtail_Hash target_path_hash = target_path_hashes[target_index];
+        const uint32_t* target_asset_index_ptr = Longtail_LookupTable_Get(target_path_hash_to_index, target_path_hash);
+        LONGTAIL_FATAL_ASSERT(ctx, target_asset_index_ptr, return EINVAL)
+        uint32_t target_asset_index = *target_asset_index_ptr;
+        const char* target_path = &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]];
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Added asset %s", target_path)
+        added_target_asset_indexes[target_added_count] = target_asset_index;
+        ++target_added_count;
+        ++target_index;
     }
 
-    err = 0;
-    for (uint32_t b = 0; b < block_job_count; ++b)
+    // A removed file and an added file with the same content are moved instead of removed and written again
+    uint32_t moved_count = 0;
+    if (source_removed_count > 0 && target_added_count > 0)
     {
-        struct WriteAssetsFromBlockJob* job = &block_jobs[b];
-        if (job->m_Err)
+        for (uint32_t r = source_removed_count; r-- > 0;)
         {
-            LONGTAIL_LOG(ctx, (job->m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteAssetsFromBlockJob failed with %d", job->m_Err)
-            err = err ? err : job->m_Err;
+            uint32_t source_asset_index = removed_source_asset_indexes[r];
+            const char* source_path = &source_version->m_NameData[source_version->m_NameOffsets[source_asset_index]];
+            if (source_version->m_AssetSizes[source_asset_index] == 0 || IsDirPath(source_path))
+            {
+                continue;
+            }
+            next_removed_with_content[r] = 0xffffffff;
+            uint32_t* first_removed_ptr = Longtail_LookupTable_PutUnique(content_hash_to_removed, source_version->m_ContentHashes[source_asset_index], r);
+            if (first_removed_ptr)
+            {
+                next_removed_with_content[r] = *first_removed_ptr;
+                *first_removed_ptr = r;
+            }
         }
-    }
-    for (uint32_t a = 0; a < awl->m_AssetJobCount; ++a)
-    {
-        struct WritePartialAssetFromBlocksJob* job = &asset_jobs[a];
-        if (job->m_Err)
+        for (uint32_t a = 0; a < target_added_count; ++a)
         {
-            const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[job->m_AssetIndex]];
-            LONGTAIL_LOG(ctx, (job->m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WritePartialAssetFromBlocksJob failed with %d", job->m_Err)
-            if (err == 0)
+            uint32_t target_asset_index = added_target_asset_indexes[a];
+            uint64_t target_asset_size = target_version->m_AssetSizes[target_asset_index];
+            if (target_asset_size == 0)
             {
-                err = job->m_Err;
+                continue;
             }
-            else if ((err == ENOTRECOVERABLE) && (job->m_Err != ENOTRECOVERABLE))
+            uint32_t* removed_ptr = Longtail_LookupTable_Get(content_hash_to_removed, target_version->m_ContentHashes[target_asset_index]);
+            if (removed_ptr == 0)
             {
-                err = job->m_Err;
+                continue;
+            }
+            while (*removed_ptr != 0xffffffff && source_version->m_AssetSizes[removed_source_asset_indexes[*removed_ptr]] != target_asset_size)
+            {
+                removed_ptr = &next_removed_with_content[*removed_ptr];
+            }
+            uint32_t r = *removed_ptr;
+            if (r == 0xffffffff)
+            {
+                continue;
+            }
+            *removed_ptr = next_removed_with_content[r];
+            uint32_t source_asset_index = removed_source_asset_indexes[r];
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Moved asset %s to %s",
+                &source_version->m_NameData[source_version->m_NameOffsets[source_asset_index]],
+                &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]])
+            moved_source_asset_indexes[moved_count] = source_asset_index;
+            moved_target_asset_indexes[moved_count] = target_asset_index;
+            ++moved_count;
+            removed_source_asset_indexes[r] = 0xffffffff;
+            added_target_asset_indexes[a] = 0xffffffff;
+        }
+        uint32_t remaining_count = 0;
+        for (uint32_t r = 0; r < source_removed_count; ++r)
+        {
+            if (removed_source_asset_indexes[r] != 0xffffffff)
+            {
+                removed_source_asset_indexes[remaining_count++] = removed_source_asset_indexes[r];
+            }
+        }
+        source_removed_count = remaining_count;
+        remaining_count = 0;
+        for (uint32_t a = 0; a < target_added_count; ++a)
+        {
+            if (added_target_asset_indexes[a] != 0xffffffff)
+            {
+                added_target_asset_indexes[remaining_count++] = added_target_asset_indexes[a];
             }
         }
+        target_added_count = remaining_count;
     }
 
-    Longtail_Free(asset_jobs);
-    Longtail_Free(block_jobs);
-
-    return err;
-}
-
-int Longtail_WriteVersion(
-    struct Longtail_BlockStoreAPI* block_storage_api,
-    struct Longtail_StorageAPI* version_storage_api,
-    struct Longtail_JobAPI* job_api,
-    struct Longtail_ProgressAPI* progress_api,
-    struct Longtail_CancelAPI* optional_cancel_api,
-    Longtail_CancelAPI_HCancelToken optional_cancel_token,
-    const struct Longtail_StoreIndex* store_index,
-    const struct Longtail_VersionIndex* version_index,
-    const char* version_path,
-    int retain_permissions)
-{
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(block_storage_api, "%p"),
-        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
-        LONGTAIL_LOGFIELD(job_api, "%p"),
-        LONGTAIL_LOGFIELD(progress_api, "%p"),
-        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
-        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
-        LONGTAIL_LOGFIELD(store_index, "%p"),
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(version_path, "%s"),
-        LONGTAIL_LOGFIELD(retain_permissions, "%d")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, block_storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_path != 0, return EINVAL)
-
-    if (*version_index->m_AssetCount == 0)
+    if (source_removed_count > 0)
     {
-        return 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Found %u removed assets", source_removed_count)
     }
-
-    uint32_t block_count = *store_index->m_BlockCount;
-    uint32_t chunk_count = *store_index->m_ChunkCount;
-    struct Longtail_LookupTable* chunk_hash_to_block_index = Longtail_LookupTable_Create(Longtail_Alloc("WriteVersion", Longtail_LookupTable_GetSize(chunk_count)), chunk_count, 0);
-    if (!chunk_hash_to_block_index)
+    if (target_added_count > 0)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Found %u added assets", target_added_count)
     }
-    for (uint32_t b = 0; b < block_count; ++b)
+    if (modified_content_count > 0)
     {
-        uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
-        uint32_t chunk_index_offset = store_index->m_BlockChunksOffsets[b];
-        for (uint32_t c = 0; c < block_chunk_count; ++c)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching content for %u assets found", modified_content_count)
+    }
+    if (modified_permissions_count > 0)
     {
-            uint32_t chunk_index = chunk_index_offset + c;
-            TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_index];
-            Longtail_LookupTable_PutUnique(chunk_hash_to_block_index, chunk_hash, b);
-        }
-        chunk_index_offset += block_chunk_count;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching permission for %u assets found", modified_permissions_count)
     }
-
-    uint32_t asset_count = *version_index->m_AssetCount;
-
-    struct AssetWriteList* awl;
-    int err = BuildAssetWriteList(
-        asset_count,
-        0,
-        version_index->m_NameOffsets,
-        version_index->m_NameData,
-        version_index->m_ChunkHashes,
-        version_index->m_AssetChunkCounts,
-        version_index->m_AssetChunkIndexStarts,
-        version_index->m_AssetChunkIndexes,
-        chunk_hash_to_block_index,
-        &awl);
-
-    if (err)
+    if (moved_count > 0)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BuildAssetWriteList() failed with %d", err)
-        Longtail_Free(chunk_hash_to_block_index);
-        return err;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Found %u moved assets", moved_count)
     }
 
-    err = WriteAssets(
-        block_storage_api,
-        version_storage_api,
-        job_api,
-        progress_api,
-        optional_cancel_api,
-        optional_cancel_token,
-        store_index,
-        version_index,
-        version_path,
-        chunk_hash_to_block_index,
-        awl,
-        retain_permissions);
-    if (err)
+    size_t version_diff_size = GetVersionDiffSize(source_removed_count, target_added_count, modified_content_count, modified_permissions_count, moved_count);
+    struct Longtail_VersionDiff* version_diff = (struct Longtail_VersionDiff*)Longtail_Alloc("CreateVersionDiff", version_diff_size);
+    if (!version_diff)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "WriteAssets() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(work_mem);
+        return ENOMEM;
     }
+    uint32_t* counts_ptr = (uint32_t*)(void*)&version_diff[1];
+    counts_ptr[0] = source_removed_count;
+    counts_ptr[1] = target_added_count;
+    counts_ptr[2] = modified_content_count;
+    counts_ptr[3] = modified_permissions_count;
+    counts_ptr[4] = moved_count;
+    InitVersionDiff(version_diff);
 
-    Longtail_Free(awl);
-    Longtail_Free(chunk_hash_to_block_index);
+    memmove(version_diff->m_SourceRemovedAssetIndexes, removed_source_asset_indexes, sizeof(uint32_t) * source_removed_count);
+    memmove(version_diff->m_TargetAddedAssetIndexes, added_target_asset_indexes, sizeof(uint32_t) * target_added_count);
+    memmove(version_diff->m_SourceContentModifiedAssetIndexes, modified_source_content_indexes, sizeof(uint32_t) * modified_content_count);
+    memmove(version_diff->m_TargetContentModifiedAssetIndexes, modified_target_content_indexes, sizeof(uint32_t) * modified_content_count);
+    memmove(version_diff->m_SourcePermissionsModifiedAssetIndexes, modified_source_permissions_indexes, sizeof(uint32_t) * modified_permissions_count);
+    memmove(version_diff->m_TargetPermissionsModifiedAssetIndexes, modified_target_permissions_indexes, sizeof(uint32_t) * modified_permissions_count);
+    memmove(version_diff->m_SourceMovedAssetIndexes, moved_source_asset_indexes, sizeof(uint32_t) * moved_count);
+    memmove(version_diff->m_TargetMovedAssetIndexes, moved_target_asset_indexes, sizeof(uint32_t) * moved_count);
 
-    return err;
+    QSORT(version_diff->m_SourceRemovedAssetIndexes, source_removed_count, sizeof(uint32_t), SortPathLongToShort, (void*)source_version);
+    QSORT(version_diff->m_TargetAddedAssetIndexes, target_added_count, sizeof(uint32_t), SortPathShortToLong, (void*)target_version);
+
+    Longtail_Free(work_mem);
+    *out_version_diff = version_diff;
+    return 0;
 }
 
-static int CompareHash(const void* a_ptr, const void* b_ptr) 
+static SORTFUNC(SortPathLexical)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
         LONGTAIL_LOGFIELD(a_ptr, "%p"),
         LONGTAIL_LOGFIELD(b_ptr, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
@@ -5800,1121 +10823,1428 @@ static int CompareHash(const void* a_ptr, const void* b_ptr)
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
     LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
     LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
 
-    TLongtail_Hash a = *((const TLongtail_Hash*)a_ptr);
-    TLongtail_Hash b = *((const TLongtail_Hash*)b_ptr);
-    if (a > b) return  1;
-    if (a < b) return -1;
-    return 0;
+    const struct Longtail_VersionIndex* version_index = (const struct Longtail_VersionIndex*)context;
+    uint32_t a = *(const uint32_t*)a_ptr;
+    uint32_t b = *(const uint32_t*)b_ptr;
+    const char* a_path = &version_index->m_NameData[version_index->m_NameOffsets[a]];
+    const char* b_path = &version_index->m_NameData[version_index->m_NameOffsets[b]];
+    return strcmp(a_path, b_path);
 }
 
-static uint32_t MakeUnique(TLongtail_Hash* hashes, uint32_t count)
+// Returns the first position in sorted_asset_indexes where the asset path is not less than the first path_length characters of path
+static uint32_t LowerBoundSortedPath(
+    const struct Longtail_VersionIndex* version_index,
+    const uint32_t* sorted_asset_indexes,
+    uint32_t count,
+    const char* path,
+    size_t path_length)
 {
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(hashes, "%p"),
-        LONGTAIL_LOGFIELD(count, "%u")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-
-    LONGTAIL_FATAL_ASSERT(ctx, count == 0 || hashes != 0, return 0)
-
-    uint32_t w = 0;
-    uint32_t r = 0;
-    while (r < count)
+    uint32_t first = 0;
+    while (count > 0)
     {
-        hashes[w] = hashes[r];
-        ++r;
-        while (r < count && hashes[r - 1] == hashes[r])
+        uint32_t step = count / 2;
+        const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[sorted_asset_indexes[first + step]]];
+        if (strncmp(asset_path, path, path_length) < 0)
         {
-            ++r;
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
         }
-        ++w;
     }
-    return w;
+    return first;
 }
 
-static int DiffHashes(
-    const TLongtail_Hash* reference_hashes,
-    uint32_t reference_hash_count,
-    const TLongtail_Hash* new_hashes,
-    uint32_t new_hash_count,
-    uint32_t* added_hash_count,
-    TLongtail_Hash* added_hashes,
-    uint32_t* removed_hash_count,
-    TLongtail_Hash* removed_hashes)
+// Finds the removed source assets that are in the way of a moved asset, a file on the parent path of the move target or
+// a folder at the move target. The conflicting moves are flagged in out_is_deferred_move and have to wait until the
+// conflicting removed assets, including the content of conflicting folders, returned in out_conflict_asset_indexes are removed
+static int FindMoveConflicts(
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const struct Longtail_VersionDiff* version_diff,
+    uint8_t* out_is_deferred_move,
+    uint32_t* out_conflict_asset_indexes,
+    uint32_t* out_conflict_count)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(reference_hashes, "%p"),
-        LONGTAIL_LOGFIELD(reference_hash_count, "%u"),
-        LONGTAIL_LOGFIELD(new_hashes, "%p"),
-        LONGTAIL_LOGFIELD(new_hash_count, "%u"),
-        LONGTAIL_LOGFIELD(added_hash_count, "%p"),
-        LONGTAIL_LOGFIELD(added_hashes, "%p"),
-        LONGTAIL_LOGFIELD(removed_hash_count, "%p"),
-        LONGTAIL_LOGFIELD(removed_hashes, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+        LONGTAIL_LOGFIELD(source_version, "%p"),
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(version_diff, "%p"),
+        LONGTAIL_LOGFIELD(out_is_deferred_move, "%p"),
+        LONGTAIL_LOGFIELD(out_conflict_asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(out_conflict_count, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
-    LONGTAIL_FATAL_ASSERT(ctx, reference_hash_count == 0 || reference_hashes != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, new_hash_count == 0 || added_hashes != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, added_hash_count != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, added_hashes != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, (removed_hash_count == 0 && removed_hashes == 0) || (removed_hash_count != 0 && removed_hashes != 0), return EINVAL)
+    uint32_t moved_count = *version_diff->m_MovedCount;
+    uint32_t remove_count = *version_diff->m_SourceRemovedCount;
+    memset(out_is_deferred_move, 0, moved_count);
+    *out_conflict_count = 0;
+    if (remove_count == 0)
+    {
+        return 0;
+    }
 
-    size_t work_mem_size = (sizeof(TLongtail_Hash) * reference_hash_count) +
-        (sizeof(TLongtail_Hash) * new_hash_count);
-    void* work_mem = Longtail_Alloc("DiffHashes", work_mem_size);
+    size_t sorted_size = sizeof(uint32_t) * remove_count;
+    size_t is_conflict_size = remove_count;
+    void* work_mem = Longtail_Alloc("FindMoveConflicts", sorted_size + is_conflict_size);
     if (!work_mem)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
+    uint32_t* sorted_remove_asset_indexes = (uint32_t*)work_mem;
+    uint8_t* is_conflict = (uint8_t*)&sorted_remove_asset_indexes[remove_count];
+    memcpy(sorted_remove_asset_indexes, version_diff->m_SourceRemovedAssetIndexes, sorted_size);
+    memset(is_conflict, 0, is_conflict_size);
+    QSORT(sorted_remove_asset_indexes, remove_count, sizeof(uint32_t), SortPathLexical, (void*)source_version);
 
-    TLongtail_Hash* tmp_refs = (TLongtail_Hash*)work_mem;
-    TLongtail_Hash* tmp_news = (TLongtail_Hash*)&tmp_refs[reference_hash_count];
+    size_t max_target_path_length = 0;
+    for (uint32_t m = 0; m < moved_count; ++m)
+    {
+        uint32_t target_asset_index = version_diff->m_TargetMovedAssetIndexes[m];
+        size_t target_path_length = strlen(&target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]]);
+        max_target_path_length = target_path_length > max_target_path_length ? target_path_length : max_target_path_length;
+    }
+    char* dir_key = (char*)Longtail_Alloc("FindMoveConflicts", max_target_path_length + 1);
+    if (!dir_key)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(work_mem);
+        return ENOMEM;
+    }
 
-    memmove(tmp_refs, reference_hashes, (size_t)(sizeof(TLongtail_Hash) * reference_hash_count));
-    memmove(tmp_news, new_hashes, (size_t)(sizeof(TLongtail_Hash) * new_hash_count));
+    for (uint32_t m = 0; m < moved_count; ++m)
+    {
+        uint32_t target_asset_index = version_diff->m_TargetMovedAssetIndexes[m];
+        const char* target_asset_path = &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]];
+        size_t target_path_length = strlen(target_asset_path);
+        for (size_t c = 0; c <= target_path_length; ++c)
+        {
+            if (target_asset_path[c] != '/' && target_asset_path[c] != '\0')
+            {
+                continue;
+            }
+            // A removed file at a parent path, or a removed folder at the target path
+            int is_dir = target_asset_path[c] == '\0';
+            const char* key = target_asset_path;
+            size_t key_length = c;
+            if (is_dir)
+            {
+                memcpy(dir_key, target_asset_path, c);
+                dir_key[c] = '/';
+                key = dir_key;
+                key_length = c + 1;
+            }
+            uint32_t r = LowerBoundSortedPath(source_version, sorted_remove_asset_indexes, remove_count, key, key_length);
+            if (!is_dir)
+            {
+                const char* removed_path = r < remove_count ? &source_version->m_NameData[source_version->m_NameOffsets[sorted_remove_asset_indexes[r]]] : 0;
+                if (removed_path && strncmp(removed_path, key, key_length) == 0 && removed_path[key_length] == '\0')
+                {
+                    is_conflict[r] = 1;
+                    out_is_deferred_move[m] = 1;
+                }
+                continue;
+            }
+            // The folder sorts first followed by its content
+            while (r < remove_count)
+            {
+                const char* removed_path = &source_version->m_NameData[source_version->m_NameOffsets[sorted_remove_asset_indexes[r]]];
+                if (strncmp(removed_path, key, key_length) != 0)
+                {
+                    break;
+                }
+                is_conflict[r++] = 1;
+                out_is_deferred_move[m] = 1;
+            }
+        }
+    }
+    Longtail_Free(dir_key);
 
-    qsort(&tmp_refs[0], (size_t)reference_hash_count, sizeof(TLongtail_Hash), CompareHash);
-    reference_hash_count = MakeUnique(&tmp_refs[0], reference_hash_count);
+    uint32_t conflict_count = 0;
+    for (uint32_t r = 0; r < remove_count; ++r)
+    {
+        if (is_conflict[r])
+        {
+            out_conflict_asset_indexes[conflict_count++] = sorted_remove_asset_indexes[r];
+        }
+    }
+    Longtail_Free(work_mem);
+    *out_conflict_count = conflict_count;
+    return 0;
+}
 
-    qsort(&tmp_news[0], (size_t)new_hash_count, sizeof(TLongtail_Hash), CompareHash);
-    new_hash_count = MakeUnique(&tmp_news[0], new_hash_count);
+// Returns non-zero if the paths are different but only differ by letter case
+static int IsCaseOnlyRename(const char* source_path, const char* target_path)
+{
+    if (strcmp(source_path, target_path) == 0)
+    {
+        return 0;
+    }
+    while (*source_path && tolower((unsigned char)*source_path) == tolower((unsigned char)*target_path))
+    {
+        ++source_path;
+        ++target_path;
+    }
+    return *source_path == '\0' && *target_path == '\0';
+}
 
-    uint32_t removed = 0;
-    uint32_t added = 0;
-    uint32_t ni = 0;
-    uint32_t ri = 0;
-    while (ri < reference_hash_count && ni < new_hash_count)
+// Moves unchanged files from their source path to their target path, replacing any untracked file at the target path.
+// Only the moves where optional_is_deferred_move matches deferred are applied, without optional_is_deferred_move all moves are applied.
+// Completed moves are recorded in optional_journal and moves recorded by an earlier, interrupted, run are skipped
+static int MoveAssets(
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const struct Longtail_VersionDiff* version_diff,
+    const char* version_path,
+    const uint8_t* optional_is_deferred_move,
+    uint8_t deferred,
+    struct WriteJournal* optional_journal,
+    int retain_permissions)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(source_version, "%p"),
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(version_diff, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(optional_is_deferred_move, "%p"),
+        LONGTAIL_LOGFIELD(deferred, "%u"),
+        LONGTAIL_LOGFIELD(optional_journal, "%p"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    uint32_t moved_count = *version_diff->m_MovedCount;
+    for (uint32_t m = 0; m < moved_count; ++m)
     {
-        if (tmp_refs[ri] == tmp_news[ni])
+        if ((optional_is_deferred_move ? optional_is_deferred_move[m] : 0) != deferred)
         {
-            ++ri;
-            ++ni;
             continue;
         }
-        else if (tmp_refs[ri] < tmp_news[ni])
-        {
-            if (removed_hashes)
+        if ((m & 0x7f) == 0x7f) {
+            if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
             {
-                removed_hashes[removed] = tmp_refs[ri];
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Operation cancelled, failed with %d", ECANCELED)
+                return ECANCELED;
             }
-            ++removed;
-            ++ri;
         }
-        else if (tmp_refs[ri] > tmp_news[ni])
+        uint32_t source_asset_index = version_diff->m_SourceMovedAssetIndexes[m];
+        uint32_t target_asset_index = version_diff->m_TargetMovedAssetIndexes[m];
+        if (optional_journal && optional_journal->m_IsCompleted[target_asset_index])
         {
-            added_hashes[added++] = tmp_news[ni++];
+            // Already moved by an earlier, interrupted, run
+            continue;
         }
-    }
-    while (ni < new_hash_count)
-    {
-        added_hashes[added++] = tmp_news[ni++];
-    }
-    *added_hash_count = added;
-    while (ri < reference_hash_count)
-    {
-        if (removed_hashes)
+        const char* source_asset_path = &source_version->m_NameData[source_version->m_NameOffsets[source_asset_index]];
+        const char* target_asset_path = &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]];
+        char* full_source_path = version_storage_api->ConcatPath(version_storage_api, version_path, source_asset_path);
+        char* full_target_path = version_storage_api->ConcatPath(version_storage_api, version_path, target_asset_path);
+
+        if (!version_storage_api->IsFile(version_storage_api, full_source_path))
         {
-            removed_hashes[removed] = tmp_refs[ri];
+            // Fail before the target path is touched, whatever is at the target path is not known to be the moved file
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Moved file `%s` is missing, failed with %d", full_source_path, ENOENT)
+            Longtail_Free(full_target_path);
+            Longtail_Free(full_source_path);
+            return ENOENT;
         }
-        ++removed;
-        ++ri;
-    }
-    if (removed_hash_count)
-    {
-        *removed_hash_count = removed;
-    }
 
-    Longtail_Free(work_mem);
-    work_mem = 0;
+        if (IsCaseOnlyRename(source_asset_path, target_asset_path))
+        {
+            // On a case insensitive file system the target path is the source file, move it out of the way first
+            size_t temp_path_size = strlen(full_source_path) + 16;
+            char* full_temp_path = (char*)Longtail_Alloc("MoveAssets", temp_path_size);
+            if (!full_temp_path)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+                Longtail_Free(full_target_path);
+                Longtail_Free(full_source_path);
+                return ENOMEM;
+            }
+            sprintf(full_temp_path, "%s.longtail_mv", full_source_path);
+            int err = version_storage_api->RenameFile(version_storage_api, full_source_path, full_temp_path);
+            Longtail_Free(full_source_path);
+            full_source_path = full_temp_path;
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->RenameFile() failed with %d", err)
+                Longtail_Free(full_target_path);
+                Longtail_Free(full_source_path);
+                return err;
+            }
+        }
 
-    if (added > 0)
-    {
-        // Reorder the new hashes so they are in the same order that they where when they were created
-        // so chunks that belongs together are group together in blocks
-        struct Longtail_LookupTable* added_hashes_lookup = Longtail_LookupTable_Create(Longtail_Alloc("DiffHashes", Longtail_LookupTable_GetSize(added)), added, 0);
-        if (!added_hashes_lookup)
+        int err = EnsureParentPathExists(version_storage_api, full_target_path);
+        if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-            return ENOMEM;
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "EnsureParentPathExists() failed with %d", err)
+            Longtail_Free(full_target_path);
+            Longtail_Free(full_source_path);
+            return err;
         }
-        for (uint32_t i = 0; i < added; ++i)
+        if (version_storage_api->IsFile(version_storage_api, full_target_path))
         {
-            Longtail_LookupTable_Put(added_hashes_lookup, added_hashes[i], i);
+            uint16_t permissions = 0;
+            err = version_storage_api->GetPermissions(version_storage_api, full_target_path, &permissions);
+            if (!err && !(permissions & Longtail_StorageAPI_UserWriteAccess))
+            {
+                err = version_storage_api->SetPermissions(version_storage_api, full_target_path, permissions | Longtail_StorageAPI_UserWriteAccess);
+            }
+            err = err ? err : version_storage_api->RemoveFile(version_storage_api, full_target_path);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Can't replace file `%s`, failed with %d", full_target_path, err)
+                Longtail_Free(full_target_path);
+                Longtail_Free(full_source_path);
+                return err;
+            }
         }
-        added = 0;
-        for (uint32_t i = 0; i < new_hash_count; ++i)
+        err = version_storage_api->RenameFile(version_storage_api, full_source_path, full_target_path);
+        if (err)
         {
-            TLongtail_Hash hash = new_hashes[i];
-            if (Longtail_LookupTable_Get(added_hashes_lookup, hash) == 0)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->RenameFile() failed with %d", err)
+            Longtail_Free(full_target_path);
+            Longtail_Free(full_source_path);
+            return err;
+        }
+        uint16_t target_permissions = (uint16_t)target_version->m_Permissions[target_asset_index];
+        if (retain_permissions && target_permissions != (uint16_t)source_version->m_Permissions[source_asset_index])
+        {
+            err = version_storage_api->SetPermissions(version_storage_api, full_target_path, target_permissions);
+            if (err)
             {
-                continue;
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
+                Longtail_Free(full_target_path);
+                Longtail_Free(full_source_path);
+                return err;
             }
-            added_hashes[added++] = hash;
         }
-        Longtail_Free(added_hashes_lookup);
+        WriteJournalAsset(optional_journal, target_asset_index);
+        Longtail_Free(full_target_path);
+        Longtail_Free(full_source_path);
     }
     return 0;
 }
 
-int Longtail_CreateStoreIndex(
-    struct Longtail_HashAPI* hash_api,
-    uint32_t chunk_count,
-    const TLongtail_Hash* chunk_hashes,
-    const uint32_t* chunk_sizes,
-    const uint32_t* optional_chunk_tags,
-    uint32_t max_block_size,
-    uint32_t max_chunks_per_block,
-    struct Longtail_StoreIndex** out_store_index)
+// Number of removed assets handled by each removal job
+#define REMOVE_ASSETS_BATCH_COUNT   256u
+#define REMOVE_ASSETS_RETRY_COUNT   10u
+
+// Removes one asset of the source version, *out_removed is set to zero if the asset still exists and should be retried
+static int RemoveAsset(
+    struct Longtail_StorageAPI* version_storage_api,
+    const struct Longtail_VersionIndex* source_version,
+    const char* version_path,
+    uint32_t asset_index,
+    int is_last_attempt,
+    int* out_removed)
 {
+#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(hash_api, "%p"),
-        LONGTAIL_LOGFIELD(chunk_count, "%u"),
-        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
-        LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
-        LONGTAIL_LOGFIELD(optional_chunk_tags, "%p"),
-        LONGTAIL_LOGFIELD(max_block_size, "%u"),
-        LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
-        LONGTAIL_LOGFIELD(out_store_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(source_version, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(asset_index, "%u"),
+        LONGTAIL_LOGFIELD(is_last_attempt, "%d"),
+        LONGTAIL_LOGFIELD(out_removed, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || hash_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || max_block_size != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || max_chunks_per_block != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_store_index != 0, return EINVAL)
+    *out_removed = 0;
+    const char* asset_path = &source_version->m_NameData[source_version->m_NameOffsets[asset_index]];
+    char* full_asset_path = version_storage_api->ConcatPath(version_storage_api, version_path, asset_path);
+    int is_dir = IsDirPath(asset_path);
+    if (is_dir)
+    {
+        full_asset_path[strlen(full_asset_path) - 1] = '\0';
+    }
+    int exists = is_dir ? version_storage_api->IsDir(version_storage_api, full_asset_path) : version_storage_api->IsFile(version_storage_api, full_asset_path);
+    if (!exists)
+    {
+        Longtail_Free(full_asset_path);
+        *out_removed = 1;
+        return 0;
+    }
+    uint16_t permissions = 0;
+    int err = version_storage_api->GetPermissions(version_storage_api, full_asset_path, &permissions);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetPermissions() failed with %d", err)
+        Longtail_Free(full_asset_path);
+        return err;
+    }
+    if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
+    {
+        uint16_t write_access = is_dir ? (Longtail_StorageAPI_UserWriteAccess | Longtail_StorageAPI_GroupWriteAccess | Longtail_StorageAPI_OtherWriteAccess) : Longtail_StorageAPI_UserWriteAccess;
+        err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, permissions | write_access);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
+            Longtail_Free(full_asset_path);
+            return err;
+        }
+    }
+    if (is_dir)
+    {
+        err = version_storage_api->RemoveDir(version_storage_api, full_asset_path);
+        exists = err ? version_storage_api->IsDir(version_storage_api, full_asset_path) : 0;
+    }
+    else
+    {
+        err = version_storage_api->RemoveFile(version_storage_api, full_asset_path);
+        exists = err ? version_storage_api->IsFile(version_storage_api, full_asset_path) : 0;
+    }
+    if (exists)
+    {
+        if (is_last_attempt)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Can't remove %s `%s`, failed with %d", is_dir ? "dir" : "file", full_asset_path, err)
+            Longtail_Free(full_asset_path);
+            return err;
+        }
+        Longtail_Free(full_asset_path);
+        return 0;
+    }
+    Longtail_Free(full_asset_path);
+    *out_removed = 1;
+    return 0;
+}
+
+struct RemoveAssetsJob
+{
+    struct Longtail_StorageAPI* m_VersionStorageAPI;
+    const struct Longtail_VersionIndex* m_SourceVersion;
+    const char* m_VersionPath;
+    uint32_t* m_AssetIndexes;
+    uint32_t m_AssetCount;
+    int m_IsLastAttempt;
+    uint32_t m_RemovedCount;
+    int m_Err;
+};
+
+// Removed assets are marked with 0xffffffff in m_AssetIndexes so they are skipped when retrying
+static int RemoveAssetsJob(void* context, uint32_t job_id, int is_cancelled)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
 
-    if (chunk_count == 0)
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+    struct RemoveAssetsJob* job = (struct RemoveAssetsJob*)context;
+    if (is_cancelled)
     {
-        int err = Longtail_CreateStoreIndexFromBlocks(0, 0, out_store_index);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Cancelled, failed with %d", ECANCELED)
+        job->m_Err = ECANCELED;
+        return 0;
+    }
+    for (uint32_t r = 0; r < job->m_AssetCount; ++r)
+    {
+        uint32_t asset_index = job->m_AssetIndexes[r];
+        if (asset_index == 0xffffffff)
+        {
+            continue;
+        }
+        int removed = 0;
+        int err = RemoveAsset(job->m_VersionStorageAPI, job->m_SourceVersion, job->m_VersionPath, asset_index, job->m_IsLastAttempt, &removed);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
-            return err;
+            job->m_Err = err;
+            return 0;
+        }
+        if (removed)
+        {
+            job->m_AssetIndexes[r] = 0xffffffff;
+            ++job->m_RemovedCount;
         }
-        return 0;
     }
+    job->m_Err = 0;
+    return 0;
+}
 
-    size_t work_mem_size = (sizeof(uint32_t) * chunk_count) +
-        (sizeof(struct Longtail_BlockIndex*) * chunk_count) +
-        (sizeof(uint32_t) * max_chunks_per_block);
-    void* work_mem = Longtail_Alloc("Longtail_CreateStoreIndex", work_mem_size);
+// Removes the assets using parallel jobs, files are removed first followed by the folders one depth level
+// at a time starting with the deepest so a folder is only removed once its content has been removed
+static int RemoveAssets(
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_VersionIndex* source_version,
+    const char* version_path,
+    uint32_t remove_count,
+    const uint32_t* remove_asset_indexes)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(source_version, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(remove_count, "%u"),
+        LONGTAIL_LOGFIELD(remove_asset_indexes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    uint32_t max_job_count = (remove_count + REMOVE_ASSETS_BATCH_COUNT - 1) / REMOVE_ASSETS_BATCH_COUNT;
+    size_t remove_order_size = sizeof(uint64_t) * remove_count;
+    size_t asset_indexes_size = sizeof(uint32_t) * remove_count;
+    size_t jobs_size = sizeof(struct RemoveAssetsJob) * max_job_count;
+    size_t funcs_size = sizeof(Longtail_JobAPI_JobFunc) * max_job_count;
+    size_t ctxs_size = sizeof(void*) * max_job_count;
+    size_t work_mem_size = remove_order_size + asset_indexes_size + jobs_size + funcs_size + ctxs_size;
+    void* work_mem = Longtail_Alloc("RemoveAssets", work_mem_size);
     if (!work_mem)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
-    uint32_t* tmp_chunk_indexes = (uint32_t*)work_mem;
-    struct Longtail_BlockIndex** tmp_block_indexes = (struct Longtail_BlockIndex**)&tmp_chunk_indexes[chunk_count];
-    uint32_t* tmp_stored_chunk_indexes = (uint32_t*)&tmp_block_indexes[chunk_count];
-    uint32_t unique_chunk_count = GetUniqueHashes((uint32_t)chunk_count, chunk_hashes, tmp_chunk_indexes);
-
-    uint32_t i = 0;
-    uint32_t block_count = 0;
+    char* p = (char*)work_mem;
+    uint64_t* remove_order = (uint64_t*)p;
+    p += remove_order_size;
+    struct RemoveAssetsJob* jobs = (struct RemoveAssetsJob*)p;
+    p += jobs_size;
+    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)p;
+    p += funcs_size;
+    void** ctxs = (void**)p;
+    p += ctxs_size;
+    uint32_t* asset_indexes = (uint32_t*)p;
 
-    while (i < unique_chunk_count)
+    // Sort key is zero for files and decreases with folder depth, the asset index is kept in the low bits
+    for (uint32_t r = 0; r < remove_count; ++r)
     {
-        uint32_t chunk_count_in_block = 0;
-
-        uint32_t chunk_index = tmp_chunk_indexes[i];
-
-        uint32_t current_size = chunk_sizes[chunk_index];
-        uint32_t current_tag = optional_chunk_tags ? optional_chunk_tags[chunk_index] : 0;
+        uint32_t asset_index = remove_asset_indexes[r];
+        const char* asset_path = &source_version->m_NameData[source_version->m_NameOffsets[asset_index]];
+        uint32_t level = 0;
+        if (IsDirPath(asset_path))
+        {
+            uint32_t depth = 0;
+            for (const char* s = asset_path; s[1] != '\0'; ++s)
+            {
+                depth += (*s == '/') ? 1 : 0;
+            }
+            level = 0xffffffffu - depth;
+        }
+        remove_order[r] = (((uint64_t)level) << 32) | asset_index;
+    }
+    qsort(remove_order, remove_count, sizeof(uint64_t), CompareHash);
+    for (uint32_t r = 0; r < remove_count; ++r)
+    {
+        asset_indexes[r] = (uint32_t)(remove_order[r] & 0xffffffffu);
+    }
 
-        tmp_stored_chunk_indexes[chunk_count_in_block] = chunk_index;
-        ++chunk_count_in_block;
+    int err = 0;
+    uint32_t retry_count = REMOVE_ASSETS_RETRY_COUNT;
+    uint32_t successful_remove_count = 0;
+    while (retry_count && (successful_remove_count < remove_count) && !err)
+    {
+        if (retry_count < REMOVE_ASSETS_RETRY_COUNT)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Longtail_ChangeVersion: Retrying removal of remaning %u assets in %s", remove_count - successful_remove_count, version_path)
+        }
+        --retry_count;
 
-        while((i + 1) < unique_chunk_count)
+        uint32_t level_start = 0;
+        while (level_start < remove_count && !err)
         {
-            chunk_index = tmp_chunk_indexes[(i + 1)];
-            uint32_t chunk_size = chunk_sizes[chunk_index];
-            uint32_t tag = optional_chunk_tags ? optional_chunk_tags[chunk_index] : 0;
+            uint32_t level = (uint32_t)(remove_order[level_start] >> 32);
+            uint32_t level_end = level_start + 1;
+            while (level_end < remove_count && (uint32_t)(remove_order[level_end] >> 32) == level)
+            {
+                ++level_end;
+            }
 
-            if (tag != current_tag)
+            uint32_t job_count = 0;
+            for (uint32_t r = level_start; r < level_end; r += REMOVE_ASSETS_BATCH_COUNT)
             {
-                break;
+                uint32_t batch_count = (level_end - r) < REMOVE_ASSETS_BATCH_COUNT ? (level_end - r) : REMOVE_ASSETS_BATCH_COUNT;
+                struct RemoveAssetsJob* job = &jobs[job_count];
+                job->m_VersionStorageAPI = version_storage_api;
+                job->m_SourceVersion = source_version;
+                job->m_VersionPath = version_path;
+                job->m_AssetIndexes = &asset_indexes[r];
+                job->m_AssetCount = batch_count;
+                job->m_IsLastAttempt = retry_count == 0;
+                job->m_RemovedCount = 0;
+                job->m_Err = EINVAL;
+                funcs[job_count] = RemoveAssetsJob;
+                ctxs[job_count] = job;
+                ++job_count;
             }
+            level_start = level_end;
 
-            // Break if resulting chunk count will exceed max_chunks_per_block
-            if (chunk_count_in_block == max_chunks_per_block)
+            Longtail_JobAPI_Group job_group = 0;
+            err = job_api->ReserveJobs(job_api, job_count, &job_group);
+            if (err)
             {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
                 break;
             }
-
-            // Overshoot by 10% is ok
-            if ((current_size + chunk_size) > (max_block_size + (max_block_size / 10)))
+            Longtail_JobAPI_Jobs remove_jobs;
+            err = job_api->CreateJobs(job_api, job_group, job_count, funcs, ctxs, &remove_jobs);
+            LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+            err = job_api->ReadyJobs(job_api, job_count, remove_jobs);
+            LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+            err = job_api->WaitForAllJobs(job_api, job_group, 0, optional_cancel_api, optional_cancel_token);
+            if (err)
             {
+                LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
                 break;
             }
-
-            current_size += chunk_size;
-            tmp_stored_chunk_indexes[chunk_count_in_block] = chunk_index;
-            ++chunk_count_in_block;
-
-            ++i;
-        }
-
-        int err = Longtail_CreateBlockIndex(
-            hash_api,
-            current_tag,
-            chunk_count_in_block,
-            tmp_stored_chunk_indexes,
-            chunk_hashes,
-            chunk_sizes,
-            &tmp_block_indexes[block_count]);
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateBlockIndex() failed with %d", err)
-            Longtail_Free(work_mem);
-            return err;
+            for (uint32_t j = 0; j < job_count; ++j)
+            {
+                successful_remove_count += jobs[j].m_RemovedCount;
+                err = err ? err : jobs[j].m_Err;
+            }
         }
-
-        ++block_count;
-        ++i;
     }
-
-    int err = Longtail_CreateStoreIndexFromBlocks(
-        block_count,
-        (const struct Longtail_BlockIndex**)tmp_block_indexes,
-        out_store_index);
+    Longtail_Free(work_mem);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "RemoveAssetsJob() failed with %d", err)
         return err;
     }
-
-    for (uint32_t b = 0; b < block_count; ++b)
-    {
-        struct Longtail_BlockIndex* block_index = tmp_block_indexes[b];
-        Longtail_Free(block_index);
-        block_index = 0;
-    }
-    Longtail_Free(work_mem);
-    return err;
+    return 0;
 }
 
-int Longtail_CreateMissingContent(
+// Modified assets that share at least this much content with the local source asset are patched from the local file
+#define LOCAL_PATCH_MIN_REUSE_SIZE      (64u * 1024u)
+#define LOCAL_PATCH_COPY_BUFFER_SIZE    (512u * 1024u)
+#define LOCAL_PATCH_STAGING_SUFFIX      ".longtail_patch"
+// Assets are patched this many at a time, a block holding missing chunks for several assets in a batch is only read once
+#define LOCAL_PATCH_BATCH_ASSET_COUNT   64u
+
+struct MissingAssetChunk
+{
+    uint64_t m_AssetOffset;
+    TLongtail_Hash m_ChunkHash;
+    uint32_t m_ChunkSize;
+    uint32_t m_BlockSlot;
+};
+
+// Copies the chunks of the target asset that are present in the source asset file and lists the chunks that must be read from blocks.
+// Each local chunk is hashed before it is copied, a chunk that no longer matches its hash is read from blocks instead
+static int CopyLocalAssetChunks(
+    struct Longtail_StorageAPI* version_storage_api,
     struct Longtail_HashAPI* hash_api,
-    const struct Longtail_StoreIndex* store_index,
-    const struct Longtail_VersionIndex* version_index,
-    uint32_t max_block_size,
-    uint32_t max_chunks_per_block,
-    struct Longtail_StoreIndex** out_store_index)
+    const struct Longtail_VersionIndex* target_version,
+    uint32_t target_asset_index,
+    const struct Longtail_LookupTable* source_chunk_lookup,
+    const uint64_t* source_chunk_offsets,
+    Longtail_StorageAPI_HOpenFile source_file,
+    Longtail_StorageAPI_HOpenFile target_file,
+    char* buffer,
+    uint64_t buffer_size,
+    struct MissingAssetChunk** out_missing_chunks,
+    uint64_t* out_reused_size)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
         LONGTAIL_LOGFIELD(hash_api, "%p"),
-        LONGTAIL_LOGFIELD(store_index, "%p"),
-        LONGTAIL_LOGFIELD(version_index, "%p"),
-        LONGTAIL_LOGFIELD(max_block_size, "%u"),
-        LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
-        LONGTAIL_LOGFIELD(out_store_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, max_block_size != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, max_chunks_per_block != 0, return EINVAL)
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(target_asset_index, "%u"),
+        LONGTAIL_LOGFIELD(source_chunk_lookup, "%p"),
+        LONGTAIL_LOGFIELD(source_chunk_offsets, "%p"),
+        LONGTAIL_LOGFIELD(source_file, "%p"),
+        LONGTAIL_LOGFIELD(target_file, "%p"),
+        LONGTAIL_LOGFIELD(buffer, "%p"),
+        LONGTAIL_LOGFIELD(buffer_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_missing_chunks, "%p"),
+        LONGTAIL_LOGFIELD(out_reused_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    uint32_t chunk_count = *version_index->m_ChunkCount;
-    size_t added_hashes_size = sizeof(TLongtail_Hash) * chunk_count;
-    TLongtail_Hash* added_hashes = (TLongtail_Hash*)Longtail_Alloc("CreateMissingContent", added_hashes_size);
-    if (!added_hashes)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
-    }
+    uint32_t target_chunk_start = target_version->m_AssetChunkIndexStarts[target_asset_index];
+    uint32_t target_chunk_count = target_version->m_AssetChunkCounts[target_asset_index];
 
-    uint32_t added_hash_count = 0;
-    int err = DiffHashes(
-        store_index->m_ChunkHashes,
-        *store_index->m_ChunkCount,
-        version_index->m_ChunkHashes,
-        chunk_count,
-        &added_hash_count,
-        added_hashes,
-        0,
-        0);
-    if (err)
+    struct MissingAssetChunk* missing_chunks = 0;
+    uint64_t reused_size = 0;
+    uint64_t target_offset = 0;
+    uint32_t c = 0;
+    while (c < target_chunk_count)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "DiffHashes() failed with %d", err)
-        Longtail_Free(added_hashes);
-        return err;
-    }
+        uint32_t chunk_index = target_version->m_AssetChunkIndexes[target_chunk_start + c];
+        TLongtail_Hash chunk_hash = target_version->m_ChunkHashes[chunk_index];
+        uint32_t chunk_size = target_version->m_ChunkSizes[chunk_index];
 
-    if (added_hash_count == 0)
-    {
-        Longtail_Free(added_hashes);
-        err = Longtail_CreateStoreIndexFromBlocks(
-            0,
-            0,
-            out_store_index);
-        if (err)
+        const uint32_t* source_chunk = Longtail_LookupTable_Get(source_chunk_lookup, chunk_hash);
+        if (source_chunk == 0)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+            struct MissingAssetChunk missing_chunk = { target_offset, chunk_hash, chunk_size, 0 };
+            arrput(missing_chunks, missing_chunk);
+            target_offset += chunk_size;
+            ++c;
+            continue;
         }
-        return err;
-    }
 
-    size_t chunk_index_lookup_size = Longtail_LookupTable_GetSize(chunk_count);
-    size_t tmp_diff_chunk_sizes_size = sizeof(uint32_t) * added_hash_count;
-    size_t tmp_diff_chunk_tags_size = sizeof(uint32_t) * added_hash_count;
-    size_t work_mem_size =
-        chunk_index_lookup_size +
-        tmp_diff_chunk_sizes_size +
-        tmp_diff_chunk_tags_size;
-    void* work_mem = Longtail_Alloc("CreateMissingContent", work_mem_size);
-    if (!work_mem)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        Longtail_Free(added_hashes);
-        return ENOMEM;
-    }
-    char* p = (char*)work_mem;
-    struct Longtail_LookupTable* chunk_index_lookup = Longtail_LookupTable_Create(p, chunk_count, 0);
-    p += chunk_index_lookup_size;
-    uint32_t* tmp_diff_chunk_sizes = (uint32_t*)p;
-    p += tmp_diff_chunk_sizes_size;
-    uint32_t* tmp_diff_chunk_tags = (uint32_t*)p;
+        // Read as many whole chunks as fit in the buffer while the following chunks are also adjacent in the source asset
+        uint64_t source_offset = source_chunk_offsets[*source_chunk];
+        uint64_t read_size = chunk_size;
+        uint32_t read_end = c + 1;
+        while (read_end < target_chunk_count)
+        {
+            uint32_t next_chunk_index = target_version->m_AssetChunkIndexes[target_chunk_start + read_end];
+            uint32_t next_chunk_size = target_version->m_ChunkSizes[next_chunk_index];
+            const uint32_t* next_source_chunk = Longtail_LookupTable_Get(source_chunk_lookup, target_version->m_ChunkHashes[next_chunk_index]);
+            if (next_source_chunk == 0 || source_chunk_offsets[*next_source_chunk] != source_offset + read_size || read_size + next_chunk_size > buffer_size)
+            {
+                break;
+            }
+            read_size += next_chunk_size;
+            ++read_end;
+        }
 
-    for (uint32_t i = 0; i < chunk_count; ++i)
-    {
-        Longtail_LookupTable_Put(chunk_index_lookup, version_index->m_ChunkHashes[i], i);
-    }
+        int err = version_storage_api->Read(version_storage_api, source_file, source_offset, read_size, buffer);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->Read() failed with %d", err)
+            arrfree(missing_chunks);
+            return err;
+        }
 
-    for (uint32_t j = 0; j < added_hash_count; ++j)
-    {
-        const uint32_t* chunk_index_ptr = Longtail_LookupTable_Get(chunk_index_lookup, added_hashes[j]);
-        LONGTAIL_FATAL_ASSERT(ctx, chunk_index_ptr, return EINVAL)
-        uint32_t chunk_index = *chunk_index_ptr;
-        tmp_diff_chunk_sizes[j] = version_index->m_ChunkSizes[chunk_index];
-        tmp_diff_chunk_tags[j] = version_index->m_ChunkTags[chunk_index];
-    }
+        uint64_t buffer_offset = 0;
+        uint64_t write_offset = 0;
+        uint64_t write_size = 0;
+        while (c < read_end)
+        {
+            chunk_index = target_version->m_AssetChunkIndexes[target_chunk_start + c];
+            chunk_hash = target_version->m_ChunkHashes[chunk_index];
+            chunk_size = target_version->m_ChunkSizes[chunk_index];
+            ++c;
 
-    err = Longtail_CreateStoreIndex(
-        hash_api,
-        added_hash_count,
-        added_hashes,
-        tmp_diff_chunk_sizes,
-        tmp_diff_chunk_tags,
-        max_block_size,
-        max_chunks_per_block,
-        out_store_index);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexRaw() failed with %d", err)
+            TLongtail_Hash local_chunk_hash;
+            err = hash_api->HashBuffer(hash_api, chunk_size, &buffer[buffer_offset], &local_chunk_hash);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_api->HashBuffer() failed with %d", err)
+                arrfree(missing_chunks);
+                return err;
+            }
+            int is_verified = local_chunk_hash == chunk_hash;
+            if (is_verified)
+            {
+                write_offset = write_size == 0 ? buffer_offset : write_offset;
+                write_size += chunk_size;
+            }
+            if (write_size > 0 && (!is_verified || c == read_end))
+            {
+                err = version_storage_api->Write(version_storage_api, target_file, target_offset + write_offset, write_size, &buffer[write_offset]);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->Write() failed with %d", err)
+                    arrfree(missing_chunks);
+                    return err;
+                }
+                reused_size += write_size;
+                write_size = 0;
+            }
+            if (!is_verified)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Local chunk 0x%" PRIx64 " does not match its hash, reading it from blocks", chunk_hash)
+                struct MissingAssetChunk missing_chunk = { target_offset + buffer_offset, chunk_hash, chunk_size, 0 };
+                arrput(missing_chunks, missing_chunk);
+            }
+            buffer_offset += chunk_size;
+        }
+        target_offset += read_size;
     }
-
-    Longtail_Free(work_mem);
-    Longtail_Free(added_hashes);
-
-    return err;
+    *out_missing_chunks = missing_chunks;
+    *out_reused_size = reused_size;
+    return 0;
 }
 
-int Longtail_GetMissingChunks(
-    const struct Longtail_StoreIndex* store_index,
-    uint32_t chunk_count,
-    const TLongtail_Hash* chunk_hashes,
-    uint32_t* out_chunk_count,
-    TLongtail_Hash* out_missing_chunk_hashes)
+struct PatchAssetJob
 {
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(store_index, "%p"),
-        LONGTAIL_LOGFIELD(chunk_count, "%u"),
-        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
-        LONGTAIL_LOGFIELD(out_chunk_count, "%p"),
-        LONGTAIL_LOGFIELD(out_missing_chunk_hashes, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_chunk_count != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (out_missing_chunk_hashes != 0), return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count <= 0xffffffffu, return EINVAL)
-
-    uint32_t reference_chunk_count = *store_index->m_ChunkCount;
-    void* chunk_to_reference_block_index_lookup_mem = Longtail_Alloc("GetMissingChunks", Longtail_LookupTable_GetSize(reference_chunk_count));
-    if (!chunk_to_reference_block_index_lookup_mem)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return ENOMEM;
-    }
-    struct Longtail_LookupTable* chunk_to_reference_block_index_lookup = Longtail_LookupTable_Create(chunk_to_reference_block_index_lookup_mem, reference_chunk_count, 0);
-    LONGTAIL_FATAL_ASSERT(ctx, chunk_to_reference_block_index_lookup != 0, return EINVAL )
+    struct Longtail_StorageAPI* m_VersionStorageAPI;
+    struct Longtail_HashAPI* m_HashAPI;
+    const struct Longtail_VersionIndex* m_SourceVersion;
+    const struct Longtail_VersionIndex* m_TargetVersion;
+    const char* m_VersionPath;
+    uint32_t m_SourceAssetIndex;
+    uint32_t m_TargetAssetIndex;
+    // Set while the asset is being patched, the target file is open and the source asset is in the staging file
+    char* m_FullAssetPath;
+    char* m_StagingPath;
+    Longtail_StorageAPI_HOpenFile m_TargetFile;
+    struct MissingAssetChunk* m_MissingChunks;
+    uint64_t m_ReusedSize;
+    int m_Err;
+};
 
-    uint32_t reference_block_count = *store_index->m_BlockCount;
-    for (uint32_t b = 0; b < reference_block_count; ++b)
+// Closes the target asset and moves the source asset back so the folder still matches the source version
+static void AbortPatchAsset(struct PatchAssetJob* job)
+{
+    struct Longtail_StorageAPI* version_storage_api = job->m_VersionStorageAPI;
+    if (job->m_TargetFile)
     {
-        uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
-        uint32_t chunk_index_offset = store_index->m_BlockChunksOffsets[b];
-        for (uint32_t c = 0; c < block_chunk_count; ++c)
+        version_storage_api->CloseFile(version_storage_api, job->m_TargetFile);
+        job->m_TargetFile = 0;
+    }
+    if (job->m_StagingPath)
     {
-            uint32_t chunk_index = chunk_index_offset + c;
-            TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_index];
-            Longtail_LookupTable_PutUnique(chunk_to_reference_block_index_lookup, chunk_hash, b);
-        }
+        version_storage_api->RemoveFile(version_storage_api, job->m_FullAssetPath);
+        version_storage_api->RenameFile(version_storage_api, job->m_StagingPath, job->m_FullAssetPath);
+        Longtail_Free(job->m_StagingPath);
+        job->m_StagingPath = 0;
     }
-
-    uint32_t missing_chunk_count = 0;
-    for (uint32_t c = 0; c < (uint32_t)chunk_count; ++c)
+    if (job->m_FullAssetPath)
     {
-        TLongtail_Hash chunk_hash = chunk_hashes[c];
-        if (Longtail_LookupTable_Get(chunk_to_reference_block_index_lookup, chunk_hash))
-        {
-            continue;
-        }
-        out_missing_chunk_hashes[missing_chunk_count++] = chunk_hash;
+        Longtail_Free(job->m_FullAssetPath);
+        job->m_FullAssetPath = 0;
     }
-    Longtail_Free(chunk_to_reference_block_index_lookup);
-    *out_chunk_count = missing_chunk_count;
-    return 0;
+    arrfree(job->m_MissingChunks);
 }
 
-static SORTFUNC(SortBlockUsageHighToLow)
+// Closes the patched target asset and removes the staging file
+static int FinishPatchAsset(struct PatchAssetJob* job, int retain_permissions)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(context, "%p"),
-        LONGTAIL_LOGFIELD(a_ptr, "%p"),
-        LONGTAIL_LOGFIELD(b_ptr, "%p")
+        LONGTAIL_LOGFIELD(job, "%p"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
 
-    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
+    struct Longtail_StorageAPI* version_storage_api = job->m_VersionStorageAPI;
+    version_storage_api->CloseFile(version_storage_api, job->m_TargetFile);
+    job->m_TargetFile = 0;
+    arrfree(job->m_MissingChunks);
 
-    const uint32_t* block_usages = (const uint32_t*)context;
-    const uint32_t a_index = *(const uint32_t*)a_ptr;
-    const uint32_t b_index = *(const uint32_t*)b_ptr;
-    const uint32_t a_usage = block_usages[a_index];
-    const uint32_t b_usage = block_usages[b_index];
-    return (a_usage < b_usage) ?
-        1 : ((a_usage > b_usage) ?
-            -1 : ((a_index < b_index) ?
-                -1 : ((a_index == b_index) ?
-                    0 : 1)));
+    int err = version_storage_api->RemoveFile(version_storage_api, job->m_StagingPath);
+    Longtail_Free(job->m_StagingPath);
+    job->m_StagingPath = 0;
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->RemoveFile() failed with %d", err)
+    }
+    else if (retain_permissions)
+    {
+        err = version_storage_api->SetPermissions(version_storage_api, job->m_FullAssetPath, (uint16_t)job->m_TargetVersion->m_Permissions[job->m_TargetAssetIndex]);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
+        }
+    }
+    Longtail_Free(job->m_FullAssetPath);
+    job->m_FullAssetPath = 0;
+    return err;
 }
 
-int Longtail_GetExistingStoreIndex(
-    const struct Longtail_StoreIndex* store_index,
-    uint32_t chunk_count,
-    const TLongtail_Hash* chunks,
-    uint32_t min_block_usage_percent,
-    struct Longtail_StoreIndex** out_store_index)
+// Moves the local source asset to a staging file and writes the chunks it shares with the target asset to a new target file.
+// The target file is left open with the list of chunks that must be read from blocks.
+// Nothing is done if the asset does not share enough content with the local file, it should then be written from blocks
+static int StartPatchAsset(struct PatchAssetJob* job)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(store_index, "%p"),
-        LONGTAIL_LOGFIELD(chunk_count, "%u"),
-        LONGTAIL_LOGFIELD(chunks, "%p"),
-        LONGTAIL_LOGFIELD(min_block_usage_percent, "%u"),
-        LONGTAIL_LOGFIELD(out_store_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunks != 0), return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_store_index != 0, return EINVAL)
+        LONGTAIL_LOGFIELD(job, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    uint32_t hash_identifier = *store_index->m_HashIdentifier;
-    uint32_t store_block_count = *store_index->m_BlockCount;
-    uint32_t store_chunk_count = *store_index->m_ChunkCount;
+    struct Longtail_StorageAPI* version_storage_api = job->m_VersionStorageAPI;
+    const struct Longtail_VersionIndex* source_version = job->m_SourceVersion;
+    const struct Longtail_VersionIndex* target_version = job->m_TargetVersion;
+    uint32_t source_asset_index = job->m_SourceAssetIndex;
+    uint32_t target_asset_index = job->m_TargetAssetIndex;
 
-    size_t chunk_to_index_lookup_size = Longtail_LookupTable_GetSize(chunk_count);
-    size_t block_to_index_lookup_size = Longtail_LookupTable_GetSize(store_block_count);
-    size_t chunk_to_store_index_lookup_size = Longtail_LookupTable_GetSize(chunk_count);
-    size_t found_store_block_hashes_size = sizeof(TLongtail_Hash) * store_block_count;
-    size_t block_uses_percent_size = sizeof(uint32_t) * store_block_count;
-    size_t block_index_size = sizeof(uint32_t) * store_block_count;
-    size_t block_order_size = sizeof(uint32_t) * store_block_count;
+    const char* asset_path = &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]];
+    uint32_t source_chunk_count = source_version->m_AssetChunkCounts[source_asset_index];
+    uint32_t target_chunk_count = target_version->m_AssetChunkCounts[target_asset_index];
+    if (source_chunk_count == 0 || target_chunk_count == 0 || IsDirPath(asset_path))
+    {
+        return 0;
+    }
 
-    size_t tmp_mem_size = chunk_to_index_lookup_size +
-        block_to_index_lookup_size +
-        chunk_to_store_index_lookup_size +
-        found_store_block_hashes_size +
-        block_uses_percent_size +
-        block_index_size +
-        block_order_size;
+    uint32_t target_chunk_start = target_version->m_AssetChunkIndexStarts[target_asset_index];
+    uint64_t buffer_size = LOCAL_PATCH_COPY_BUFFER_SIZE;
+    for (uint32_t c = 0; c < target_chunk_count; ++c)
+    {
+        uint32_t chunk_size = target_version->m_ChunkSizes[target_version->m_AssetChunkIndexes[target_chunk_start + c]];
+        buffer_size = chunk_size > buffer_size ? chunk_size : buffer_size;
+    }
 
-    void* tmp_mem = Longtail_Alloc("Longtail_GetExistingStoreIndex", tmp_mem_size);
-    if (!tmp_mem)
+    size_t source_chunk_lookup_size = Longtail_LookupTable_GetSize(source_chunk_count);
+    size_t source_chunk_offsets_size = sizeof(uint64_t) * source_chunk_count;
+    size_t work_mem_size = source_chunk_lookup_size + source_chunk_offsets_size + (size_t)buffer_size;
+    void* work_mem = Longtail_Alloc("PatchAssetFromLocalChunks", work_mem_size);
+    if (!work_mem)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
-    char* p = (char*)tmp_mem;
-
-    struct Longtail_LookupTable* chunk_to_index_lookup = Longtail_LookupTable_Create(p, chunk_count, 0);
-    p += chunk_to_index_lookup_size;
-
-    struct Longtail_LookupTable* block_to_index_lookup = Longtail_LookupTable_Create(p, store_block_count, 0);
-    p += block_to_index_lookup_size;
-
-    struct Longtail_LookupTable* chunk_to_store_index_lookup = Longtail_LookupTable_Create(p, chunk_count, 0);
-    p += chunk_to_store_index_lookup_size;
-
-    TLongtail_Hash* found_store_block_hashes = (TLongtail_Hash*)p;
-    p += found_store_block_hashes_size;
-
-    uint32_t* block_uses_percent = (uint32_t*)p;
-    p += block_uses_percent_size;
-
-    uint32_t* block_index = (uint32_t*)p;
-    p += block_index_size;
-
-    uint32_t* block_order = (uint32_t*)p;
-    p += block_order_size;
+    char* p = (char*)work_mem;
+    struct Longtail_LookupTable* source_chunk_lookup = Longtail_LookupTable_Create(p, source_chunk_count, 0);
+    p += source_chunk_lookup_size;
+    uint64_t* source_chunk_offsets = (uint64_t*)(void*)p;
+    p += source_chunk_offsets_size;
+    char* buffer = p;
 
-    uint32_t unique_chunk_count = 0;
-    for (uint32_t i = 0; i < chunk_count; ++i)
+    uint32_t source_chunk_start = source_version->m_AssetChunkIndexStarts[source_asset_index];
+    uint64_t source_offset = 0;
+    for (uint32_t c = 0; c < source_chunk_count; ++c)
     {
-        TLongtail_Hash chunk_hash = chunks[i];
-        uint32_t* c_ptr = Longtail_LookupTable_PutUnique(chunk_to_index_lookup, chunk_hash, i);
-        if (c_ptr)
-        {
-            continue;
-        }
-        ++unique_chunk_count;
+        uint32_t chunk_index = source_version->m_AssetChunkIndexes[source_chunk_start + c];
+        source_chunk_offsets[c] = source_offset;
+        Longtail_LookupTable_PutUnique(source_chunk_lookup, source_version->m_ChunkHashes[chunk_index], c);
+        source_offset += source_version->m_ChunkSizes[chunk_index];
     }
 
-    uint32_t found_block_count = 0;
-    uint32_t found_chunk_count = 0;
-    if (min_block_usage_percent <= 100)
+    uint64_t reuse_size = 0;
+    for (uint32_t c = 0; c < target_chunk_count; ++c)
     {
-        uint32_t potential_block_count = 0;
-        for (uint32_t b = 0; b < store_block_count; ++b)
-        {
-            uint32_t block_use = 0;
-            uint32_t block_size = 0;
-            TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
-            uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
-            uint32_t chunk_offset = store_index->m_BlockChunksOffsets[b];
-            for (uint32_t c = 0; c < block_chunk_count; ++c)
-            {
-                uint32_t chunk_size = store_index->m_ChunkSizes[chunk_offset];
-                TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_offset];
-                ++chunk_offset;
-                block_size += chunk_size;
-                if (Longtail_LookupTable_Get(chunk_to_index_lookup, chunk_hash))
-                {
-                    block_use += chunk_size;
-                }
-            }
-            if (block_use > 0)
-            {
-                uint32_t block_usage_percent = (uint32_t)(((uint64_t)block_use * 100) / block_size);
-                if (min_block_usage_percent > 0 &&
-                    block_usage_percent < min_block_usage_percent) {
-                    continue;
-                }
-
-                block_order[potential_block_count] = potential_block_count;
-                block_index[potential_block_count] = b;
-                block_uses_percent[potential_block_count] = block_usage_percent;
-
-                ++potential_block_count;
-            }
-        }
-
-        if (potential_block_count == 0)
+        uint32_t chunk_index = target_version->m_AssetChunkIndexes[target_chunk_start + c];
+        if (Longtail_LookupTable_Get(source_chunk_lookup, target_version->m_ChunkHashes[chunk_index]))
         {
-            Longtail_Free(tmp_mem);
-            return Longtail_CreateStoreIndexFromBlocks(
-                0,
-                0,
-                out_store_index);
+            reuse_size += target_version->m_ChunkSizes[chunk_index];
         }
+    }
+    if (reuse_size < LOCAL_PATCH_MIN_REUSE_SIZE)
+    {
+        Longtail_Free(work_mem);
+        return 0;
+    }
 
-        // Favour blocks we use more data out of - if a chunk is in mutliple blocks we want to pick
-        // the blocks that has highest ratio of use inside the block.
-        // This does not guarantee a perfect block match as one block can be a 100% match which
-        // could lead to skipping part or whole of another 100% match block resulting in us
-        // picking a block that we will not use 100% of
-        QSORT(block_order, potential_block_count, sizeof(uint32_t), SortBlockUsageHighToLow, (void*)block_uses_percent);
-
-        for (uint32_t bo = 0; (bo < potential_block_count) && (found_chunk_count < unique_chunk_count); ++bo)
-        {
-            uint32_t pb = block_order[bo];
-            uint32_t b = block_index[pb];
-
-            TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
-            uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
-            uint32_t store_chunk_index_offset = store_index->m_BlockChunksOffsets[b];
-            uint32_t current_found_block_index = found_block_count;
-            for (uint32_t c = 0; c < block_chunk_count; ++c)
-            {
-                TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[store_chunk_index_offset];
-                if (!Longtail_LookupTable_Get(chunk_to_index_lookup, chunk_hash))
-                {
-                    ++store_chunk_index_offset;
-                    continue;
-                }
-                if (Longtail_LookupTable_PutUnique(chunk_to_store_index_lookup, chunk_hash, store_chunk_index_offset))
-                {
-                    ++store_chunk_index_offset;
-                    continue;
-                }
-                found_chunk_count++;
-                if (current_found_block_index == found_block_count)
-                {
-                    uint32_t* block_index_ptr = Longtail_LookupTable_PutUnique(block_to_index_lookup, block_hash, current_found_block_index);
-                    if (block_index_ptr == 0)
-                    {
-                        found_store_block_hashes[found_block_count++] = block_hash;
-                    }
-                    ++store_chunk_index_offset;
-                    continue;
-                }
-                ++store_chunk_index_offset;
-            }
-        }
+    char* full_asset_path = version_storage_api->ConcatPath(version_storage_api, job->m_VersionPath, asset_path);
+    if (!full_asset_path)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->ConcatPath() failed with %d", ENOMEM)
+        Longtail_Free(work_mem);
+        return ENOMEM;
     }
 
-    if (found_block_count == 0)
+    // Only consider the local file if it still has the size of the source asset, its chunks are verified when copied
+    Longtail_StorageAPI_HOpenFile source_file;
+    int err = version_storage_api->OpenReadFile(version_storage_api, full_asset_path, &source_file);
+    if (err)
     {
-        Longtail_Free(tmp_mem);
-        return Longtail_CreateStoreIndexFromBlocks(
-            0,
-            0,
-            out_store_index);
+        Longtail_Free(full_asset_path);
+        Longtail_Free(work_mem);
+        return 0;
+    }
+    uint64_t local_size = 0;
+    err = version_storage_api->GetSize(version_storage_api, source_file, &local_size);
+    version_storage_api->CloseFile(version_storage_api, source_file);
+    source_file = 0;
+    if (err || local_size != source_version->m_AssetSizes[source_asset_index])
+    {
+        Longtail_Free(full_asset_path);
+        Longtail_Free(work_mem);
+        return 0;
     }
 
-    // We have a list of block hashes we want to keep in found_store_block_hashes
-    // We have a lookup from block hash to block index in store index in block_to_index_lookup
+    uint16_t permissions = 0;
+    err = version_storage_api->GetPermissions(version_storage_api, full_asset_path, &permissions);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetPermissions() failed with %d", err)
+        Longtail_Free(full_asset_path);
+        Longtail_Free(work_mem);
+        return err;
+    }
+    if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
+    {
+        err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, permissions | (Longtail_StorageAPI_UserWriteAccess));
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
+            Longtail_Free(full_asset_path);
+            Longtail_Free(work_mem);
+            return err;
+        }
+    }
 
-    size_t block_hash_lookup_size = Longtail_LookupTable_GetSize(found_block_count);
-    size_t block_index_header_ptrs_size = sizeof(struct LongtailBlockIndex*) * found_block_count;
-    size_t block_index_headers_size = sizeof(struct Longtail_BlockIndex) * found_block_count;
-    size_t tmp_mem_2_size = block_index_header_ptrs_size +
-        block_index_headers_size +
-        block_hash_lookup_size;
-    void* tmp_mem_2 = Longtail_Alloc("Longtail_GetExistingStoreIndex", tmp_mem_2_size);
-    if (!tmp_mem_2){
+    size_t full_asset_path_length = strlen(full_asset_path);
+    char* staging_path = (char*)Longtail_Alloc("PatchAssetFromLocalChunks", full_asset_path_length + sizeof(LOCAL_PATCH_STAGING_SUFFIX));
+    if (!staging_path)
+    {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        Longtail_Free(tmp_mem);
+        Longtail_Free(full_asset_path);
+        Longtail_Free(work_mem);
         return ENOMEM;
+    }
+    memcpy(staging_path, full_asset_path, full_asset_path_length);
+    memcpy(&staging_path[full_asset_path_length], LOCAL_PATCH_STAGING_SUFFIX, sizeof(LOCAL_PATCH_STAGING_SUFFIX));
 
+    if (version_storage_api->IsFile(version_storage_api, staging_path))
+    {
+        // Left behind by an interrupted update
+        version_storage_api->RemoveFile(version_storage_api, staging_path);
     }
-    struct Longtail_BlockIndex** block_index_header_ptrs = (struct Longtail_BlockIndex**)tmp_mem_2;
-    struct Longtail_BlockIndex* block_index_headers = (struct Longtail_BlockIndex*)&block_index_header_ptrs[found_block_count];
-    struct Longtail_LookupTable* block_hash_lookup = Longtail_LookupTable_Create(&((char*)block_index_headers)[block_index_headers_size], found_block_count, 0);
-    for (uint32_t b = 0; b < store_block_count; ++b)
+    err = version_storage_api->RenameFile(version_storage_api, full_asset_path, staging_path);
+    if (err)
     {
-        TLongtail_Hash block_hash = store_index->m_BlockHashes[b];
-        if (0 == Longtail_LookupTable_Get(block_to_index_lookup, block_hash))
-        {
-            continue;
-        }
-        Longtail_LookupTable_Put(block_hash_lookup, block_hash, b);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->RenameFile() failed with %d", err)
+        Longtail_Free(staging_path);
+        Longtail_Free(full_asset_path);
+        Longtail_Free(work_mem);
+        return err;
     }
+    job->m_FullAssetPath = full_asset_path;
+    job->m_StagingPath = staging_path;
 
-    for (uint32_t b = 0; b < found_block_count; ++b)
+    err = version_storage_api->OpenReadFile(version_storage_api, staging_path, &source_file);
+    if (err)
     {
-        TLongtail_Hash block_hash = found_store_block_hashes[b];
-        uint32_t store_block_index = *Longtail_LookupTable_Get(block_hash_lookup, block_hash);
-        uint32_t block_chunk_count = store_index->m_BlockChunkCounts[store_block_index];
-        uint32_t block_chunk_index_offset = store_index->m_BlockChunksOffsets[store_block_index];
-        block_index_headers[b].m_BlockHash = &store_index->m_BlockHashes[store_block_index];
-        block_index_headers[b].m_HashIdentifier = store_index->m_HashIdentifier;
-        block_index_headers[b].m_ChunkCount = &store_index->m_BlockChunkCounts[store_block_index];
-        block_index_headers[b].m_Tag = &store_index->m_BlockTags[block_chunk_index_offset];
-        block_index_headers[b].m_ChunkHashes = &store_index->m_ChunkHashes[block_chunk_index_offset];
-        block_index_headers[b].m_ChunkSizes = &store_index->m_ChunkSizes[block_chunk_index_offset];
-        block_index_header_ptrs[b] = &block_index_headers[b];
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->OpenReadFile() failed with %d", err)
+        Longtail_Free(work_mem);
+        AbortPatchAsset(job);
+        return err;
     }
-    Longtail_Free(tmp_mem);
-
-    int err = Longtail_CreateStoreIndexFromBlocks(
-        found_block_count,
-        (const struct Longtail_BlockIndex**)block_index_header_ptrs,
-        out_store_index);
-    Longtail_Free(tmp_mem_2);
+    err = version_storage_api->OpenWriteFile(version_storage_api, full_asset_path, target_version->m_AssetSizes[target_asset_index], &job->m_TargetFile);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->OpenWriteFile() failed with %d", err)
+        version_storage_api->CloseFile(version_storage_api, source_file);
+        Longtail_Free(work_mem);
+        AbortPatchAsset(job);
+        return err;
+    }
+    err = CopyLocalAssetChunks(
+        version_storage_api,
+        job->m_HashAPI,
+        target_version,
+        target_asset_index,
+        source_chunk_lookup,
+        source_chunk_offsets,
+        source_file,
+        job->m_TargetFile,
+        buffer,
+        buffer_size,
+        &job->m_MissingChunks,
+        &job->m_ReusedSize);
+    version_storage_api->CloseFile(version_storage_api, source_file);
+    Longtail_Free(work_mem);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CopyLocalAssetChunks() failed with %d", err)
+        AbortPatchAsset(job);
         return err;
     }
     return 0;
 }
 
-static int CompareHashes(const void* a_ptr, const void* b_ptr)
-{
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(a_ptr, "%p"),
-        LONGTAIL_LOGFIELD(b_ptr, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
-    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
-
-    TLongtail_Hash a = *(const TLongtail_Hash*)a_ptr;
-    TLongtail_Hash b = *(const TLongtail_Hash*)b_ptr;
-    return (a > b) ? 1 : (a < b) ? -1 : 0;
-}
-
-static SORTFUNC(SortPathShortToLong)
-{
-#if defined(LONGTAIL_ASSERTS)
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(context, "%p"),
-        LONGTAIL_LOGFIELD(a_ptr, "%p"),
-        LONGTAIL_LOGFIELD(b_ptr, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-
-    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
-
-    const struct Longtail_VersionIndex* version_index = (const struct Longtail_VersionIndex*)context;
-    uint32_t a = *(const uint32_t*)a_ptr;
-    uint32_t b = *(const uint32_t*)b_ptr;
-    const char* a_path = &version_index->m_NameData[version_index->m_NameOffsets[a]];
-    const char* b_path = &version_index->m_NameData[version_index->m_NameOffsets[b]];
-    size_t a_len = strlen(a_path);
-    size_t b_len = strlen(b_path);
-    return (a_len > b_len) ? 1 : (a_len < b_len) ? -1 : 0;
-}
-
-static SORTFUNC(SortPathLongToShort)
+static int PatchAssetFromLocalChunks(void* context, uint32_t job_id, int is_cancelled)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(context, "%p"),
-        LONGTAIL_LOGFIELD(a_ptr, "%p"),
-        LONGTAIL_LOGFIELD(b_ptr, "%p")
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 #else
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
     LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
-    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
-
-    const struct Longtail_VersionIndex* version_index = (const struct Longtail_VersionIndex*)context;
-    uint32_t a = *(const uint32_t*)a_ptr;
-    uint32_t b = *(const uint32_t*)b_ptr;
-    const char* a_path = &version_index->m_NameData[version_index->m_NameOffsets[a]];
-    const char* b_path = &version_index->m_NameData[version_index->m_NameOffsets[b]];
-    size_t a_len = strlen(a_path);
-    size_t b_len = strlen(b_path);
-    return (a_len < b_len) ? 1 : (a_len > b_len) ? -1 : 0;
-}
-
-static size_t GetVersionDiffDataSize(uint32_t removed_count, uint32_t added_count, uint32_t modified_content_count, uint32_t modified_permission_count)
-{
-    return
-        sizeof(uint32_t) +                              // m_SourceRemovedCount
-        sizeof(uint32_t) +                              // m_TargetAddedCount
-        sizeof(uint32_t) +                              // m_ModifiedContentCount
-        sizeof(uint32_t) +                              // m_ModifiedPermissionsCount
-        sizeof(uint32_t) * removed_count +              // m_SourceRemovedAssetIndexes
-        sizeof(uint32_t) * added_count +                // m_TargetAddedAssetIndexes
-        sizeof(uint32_t) * modified_content_count +     // m_SourceContentModifiedAssetIndexes
-        sizeof(uint32_t) * modified_content_count +     // m_TargetContentModifiedAssetIndexes
-        sizeof(uint32_t) * modified_permission_count +  // m_SourcePermissionsModifiedAssetIndexes
-        sizeof(uint32_t) * modified_permission_count;   // m_TargetPermissionsModifiedAssetIndexes
-}
-
-static size_t GetVersionDiffSize(uint32_t removed_count, uint32_t added_count, uint32_t modified_content_count, uint32_t modified_permission_count)
-{
-    return sizeof(struct Longtail_VersionDiff) +
-        GetVersionDiffDataSize(removed_count, added_count, modified_content_count, modified_permission_count);
+    struct PatchAssetJob* job = (struct PatchAssetJob*)context;
+    if (is_cancelled)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Cancelled, failed with %d", ECANCELED)
+        job->m_Err = ECANCELED;
+        return 0;
+    }
+    job->m_Err = StartPatchAsset(job);
+    return 0;
 }
 
-static void InitVersionDiff(struct Longtail_VersionDiff* version_diff)
+// Reads the blocks holding the missing chunks of the patched assets, a few blocks at a time, and writes the chunks to the target assets
+static int WriteMissingAssetChunks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    struct Longtail_LookupTable* chunk_hash_to_block_index,
+    uint32_t patch_job_count,
+    struct PatchAssetJob* patch_jobs)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(version_diff, "%p")
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
+        LONGTAIL_LOGFIELD(patch_job_count, "%u"),
+        LONGTAIL_LOGFIELD(patch_jobs, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    LONGTAIL_FATAL_ASSERT(ctx, version_diff != 0, return)
-
-    char* p = (char*)version_diff;
-    p += sizeof(struct Longtail_VersionDiff);
-
-    version_diff->m_SourceRemovedCount = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
-
-    version_diff->m_TargetAddedCount = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
-
-    version_diff->m_ModifiedContentCount = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
-
-    version_diff->m_ModifiedPermissionsCount = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t);
-
-    uint32_t removed_count = *version_diff->m_SourceRemovedCount;
-    uint32_t added_count = *version_diff->m_TargetAddedCount;
-    uint32_t modified_content_count = *version_diff->m_ModifiedContentCount;
-    uint32_t modified_permissions_count = *version_diff->m_ModifiedPermissionsCount;
-
-    version_diff->m_SourceRemovedAssetIndexes = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t) * removed_count;
-
-    version_diff->m_TargetAddedAssetIndexes = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t) * added_count;
-
-    version_diff->m_SourceContentModifiedAssetIndexes = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t) * modified_content_count;
-
-    version_diff->m_TargetContentModifiedAssetIndexes = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t) * modified_content_count;
-
-    version_diff->m_SourcePermissionsModifiedAssetIndexes = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t) * modified_permissions_count;
-
-    version_diff->m_TargetPermissionsModifiedAssetIndexes = (uint32_t*)(void*)p;
-    p += sizeof(uint32_t) * modified_permissions_count;
-}
-
-int Longtail_CreateVersionDiff(
-    struct Longtail_HashAPI* hash_api,
-    const struct Longtail_VersionIndex* source_version,
-    const struct Longtail_VersionIndex* target_version,
-    struct Longtail_VersionDiff** out_version_diff)
-{
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(hash_api, "%p"),
-        LONGTAIL_LOGFIELD(source_version, "%p"),
-        LONGTAIL_LOGFIELD(target_version, "%p"),
-        LONGTAIL_LOGFIELD(out_version_diff, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, source_version != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, target_version != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_version_diff != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, hash_api->GetIdentifier(hash_api) == *source_version->m_HashIdentifier, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, hash_api->GetIdentifier(hash_api) == *target_version->m_HashIdentifier, return EINVAL)
-
-    uint32_t source_asset_count = *source_version->m_AssetCount;
-    uint32_t target_asset_count = *target_version->m_AssetCount;
-
-    size_t source_asset_lookup_table_size = Longtail_LookupTable_GetSize(source_asset_count);
-    size_t target_asset_lookup_table_size = Longtail_LookupTable_GetSize(target_asset_count);
-
-    size_t work_mem_size =
-        source_asset_lookup_table_size +
-        target_asset_lookup_table_size +
-        sizeof(TLongtail_Hash) * source_asset_count +
-        sizeof(TLongtail_Hash) * target_asset_count +
-        sizeof(uint32_t) * source_asset_count +
-        sizeof(uint32_t) * target_asset_count +
-        sizeof(uint32_t) * source_asset_count +
-        sizeof(uint32_t) * target_asset_count +
-        sizeof(uint32_t) * source_asset_count +
-        sizeof(uint32_t) * target_asset_count;
-    void* work_mem = Longtail_Alloc("CreateVersionDiff", work_mem_size);
-    uint8_t* p = (uint8_t*)work_mem;
+    uint32_t missing_chunk_count = 0;
+    for (uint32_t j = 0; j < patch_job_count; ++j)
+    {
+        missing_chunk_count += (uint32_t)arrlen(patch_jobs[j].m_MissingChunks);
+    }
+    if (missing_chunk_count == 0)
+    {
+        return 0;
+    }
 
-    struct Longtail_LookupTable* source_path_hash_to_index = Longtail_LookupTable_Create(p, source_asset_count ,0);
-    p += source_asset_lookup_table_size;
-    struct Longtail_LookupTable* target_path_hash_to_index = Longtail_LookupTable_Create(p, target_asset_count ,0);
-    p += target_asset_lookup_table_size;
+    size_t block_slot_lookup_size = Longtail_LookupTable_GetSize(missing_chunk_count);
+    size_t block_indexes_size = sizeof(uint32_t) * missing_chunk_count;
+    void* work_mem = Longtail_Alloc("WriteMissingAssetChunks", block_slot_lookup_size + block_indexes_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct Longtail_LookupTable* block_slot_lookup = Longtail_LookupTable_Create(work_mem, missing_chunk_count, 0);
+    uint32_t* block_indexes = (uint32_t*)(void*)&((char*)work_mem)[block_slot_lookup_size];
 
-    TLongtail_Hash* source_path_hashes = (TLongtail_Hash*)p;
-    TLongtail_Hash* target_path_hashes = &source_path_hashes[source_asset_count];
+    // Blocks holding missing chunks for several assets are only read once
+    uint32_t block_count = 0;
+    for (uint32_t j = 0; j < patch_job_count; ++j)
+    {
+        struct MissingAssetChunk* missing_chunks = patch_jobs[j].m_MissingChunks;
+        uint32_t job_missing_chunk_count = (uint32_t)arrlen(missing_chunks);
+        for (uint32_t m = 0; m < job_missing_chunk_count; ++m)
+        {
+            const uint32_t* block_index = Longtail_LookupTable_Get(chunk_hash_to_block_index, missing_chunks[m].m_ChunkHash);
+            if (block_index == 0)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Chunk 0x%" PRIx64 " is not in the store index, failed with %d", missing_chunks[m].m_ChunkHash, ENOENT)
+                Longtail_Free(work_mem);
+                return ENOENT;
+            }
+            const uint32_t* block_slot = Longtail_LookupTable_PutUnique(block_slot_lookup, *block_index, block_count);
+            if (block_slot)
+            {
+                missing_chunks[m].m_BlockSlot = *block_slot;
+                continue;
+            }
+            missing_chunks[m].m_BlockSlot = block_count;
+            block_indexes[block_count++] = *block_index;
+        }
+    }
 
-    uint32_t* removed_source_asset_indexes = (uint32_t*)&target_path_hashes[target_asset_count];
-    uint32_t* added_target_asset_indexes = &removed_source_asset_indexes[source_asset_count];
+    const uint32_t worker_count = job_api->GetWorkerCount(job_api) + 1;
+    const uint32_t max_parallell_block_read_jobs = worker_count < MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE ? worker_count : MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE;
 
-    uint32_t* modified_source_content_indexes = &added_target_asset_indexes[target_asset_count];
-    uint32_t* modified_target_content_indexes = &modified_source_content_indexes[source_asset_count];
+    for (uint32_t batch_start = 0; batch_start < block_count; batch_start += max_parallell_block_read_jobs)
+    {
+        uint32_t batch_count = (block_count - batch_start) < max_parallell_block_read_jobs ? (block_count - batch_start) : max_parallell_block_read_jobs;
 
-    uint32_t* modified_source_permissions_indexes = &modified_target_content_indexes[target_asset_count];
-    uint32_t* modified_target_permissions_indexes = &modified_source_permissions_indexes[source_asset_count];
+        struct BlockReaderJob block_reader_jobs[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+        Longtail_JobAPI_JobFunc block_read_funcs[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+        void* block_read_ctxs[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
+        for (uint32_t b = 0; b < batch_count; ++b)
+        {
+            struct BlockReaderJob* block_job = &block_reader_jobs[b];
+            block_job->m_BlockStoreAPI = block_store_api;
+            block_job->m_BlockHash = store_index->m_BlockHashes[block_indexes[batch_start + b]];
+            block_job->m_ChunkHashes = 0;
+            block_job->m_ChunkCount = 0;
+            block_job->m_AsyncCompleteAPI.m_API.Dispose = 0;
+            block_job->m_AsyncCompleteAPI.OnComplete = 0;
+            block_job->m_JobAPI = job_api;
+            block_job->m_JobID = 0;
+            block_job->m_Err = EINVAL;
+            block_job->m_StoredBlock = 0;
+            block_read_funcs[b] = BlockReader;
+            block_read_ctxs[b] = block_job;
+        }
 
-    for (uint32_t i = 0; i < source_asset_count; ++i)
-    {
-        // We are re-hashing since we might have an older version hash that is incompatible
-        const char* path = &source_version->m_NameData[source_version->m_NameOffsets[i]];
-        int err = Longtail_GetPathHash(hash_api, path, &source_path_hashes[i]);
+        Longtail_JobAPI_Group job_group = 0;
+        int err = job_api->ReserveJobs(job_api, batch_count, &job_group);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_GetPathHash() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
             Longtail_Free(work_mem);
             return err;
         }
-        Longtail_LookupTable_Put(source_path_hash_to_index, source_path_hashes[i], i);
-    }
+        Longtail_JobAPI_Jobs block_read_jobs;
+        err = job_api->CreateJobs(job_api, job_group, batch_count, block_read_funcs, block_read_ctxs, &block_read_jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, Longtail_Free(work_mem); return err)
+        err = job_api->ReadyJobs(job_api, batch_count, block_read_jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, Longtail_Free(work_mem); return err)
+        err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        }
+        for (uint32_t b = 0; b < batch_count && err == 0; ++b)
+        {
+            err = block_reader_jobs[b].m_Err;
+        }
 
-    for (uint32_t i = 0; i < target_asset_count; ++i)
-    {
-        // We are re-hashing since we might have an older version hash that is incompatible
-        const char* path = &target_version->m_NameData[target_version->m_NameOffsets[i]];
-        int err = Longtail_GetPathHash(hash_api, path, &target_path_hashes[i]);
+        for (uint32_t j = 0; j < patch_job_count && err == 0; ++j)
+        {
+            const struct MissingAssetChunk* missing_chunks = patch_jobs[j].m_MissingChunks;
+            uint32_t job_missing_chunk_count = (uint32_t)arrlen(missing_chunks);
+            for (uint32_t m = 0; m < job_missing_chunk_count && err == 0; ++m)
+            {
+                const struct MissingAssetChunk* missing_chunk = &missing_chunks[m];
+                if (missing_chunk->m_BlockSlot < batch_start || missing_chunk->m_BlockSlot >= batch_start + batch_count)
+                {
+                    continue;
+                }
+                const struct Longtail_StoredBlock* stored_block = block_reader_jobs[missing_chunk->m_BlockSlot - batch_start].m_StoredBlock;
+                const struct Longtail_BlockIndex* block_index = stored_block->m_BlockIndex;
+                uint32_t block_chunk_count = *block_index->m_ChunkCount;
+                uint32_t chunk_offset = 0;
+                uint32_t c = 0;
+                while (c < block_chunk_count && block_index->m_ChunkHashes[c] != missing_chunk->m_ChunkHash)
+                {
+                    chunk_offset += block_index->m_ChunkSizes[c];
+                    ++c;
+                }
+                if (c == block_chunk_count)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Chunk 0x%" PRIx64 " is not in block 0x%" PRIx64 ", failed with %d", missing_chunk->m_ChunkHash, *block_index->m_BlockHash, EBADF)
+                    err = EBADF;
+                    break;
+                }
+                err = version_storage_api->Write(version_storage_api, patch_jobs[j].m_TargetFile, missing_chunk->m_AssetOffset, missing_chunk->m_ChunkSize, &((const char*)stored_block->m_BlockData)[chunk_offset]);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->Write() failed with %d", err)
+                }
+            }
+        }
+
+        for (uint32_t b = 0; b < batch_count; ++b)
+        {
+            struct Longtail_StoredBlock* stored_block = block_reader_jobs[b].m_StoredBlock;
+            if (stored_block && stored_block->Dispose)
+            {
+                stored_block->Dispose(stored_block);
+            }
+        }
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_GetPathHash() failed with %d", err)
             Longtail_Free(work_mem);
             return err;
         }
-        Longtail_LookupTable_Put(target_path_hash_to_index, target_path_hashes[i], i);
     }
+    Longtail_Free(work_mem);
+    return 0;
+}
 
-    qsort(source_path_hashes, source_asset_count, sizeof(TLongtail_Hash), CompareHashes);
-    qsort(target_path_hashes, target_asset_count, sizeof(TLongtail_Hash), CompareHashes);
-
-    const uint32_t max_modified_content_count = source_asset_count < target_asset_count ? source_asset_count : target_asset_count;
-    const uint32_t max_modified_permission_count = source_asset_count < target_asset_count ? source_asset_count : target_asset_count;
-    const uint32_t indexes_count = source_asset_count + target_asset_count + max_modified_content_count + max_modified_content_count + max_modified_permission_count + max_modified_permission_count;
+// Patches the modified assets from the chunks they share with the local source assets, only the missing chunks are read from blocks.
+// Assets are prepared in parallel jobs a batch at a time, the source asset is moved to a staging file while the target asset is
+// written and is restored if writing fails. Target asset indexes of assets that could not be patched are returned in
+// out_unpatched_asset_indexes, they should be written from blocks
+static int PatchAssetsFromLocalChunks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const char* version_path,
+    struct Longtail_LookupTable* chunk_hash_to_block_index,
+    struct WriteJournal* optional_journal,
+    int retain_permissions,
+    uint32_t asset_count,
+    const uint32_t* source_asset_indexes,
+    const uint32_t* target_asset_indexes,
+    uint32_t* out_unpatched_asset_indexes,
+    uint32_t* out_unpatched_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(source_version, "%p"),
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
+        LONGTAIL_LOGFIELD(optional_journal, "%p"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d"),
+        LONGTAIL_LOGFIELD(asset_count, "%u"),
+        LONGTAIL_LOGFIELD(source_asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(target_asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(out_unpatched_asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(out_unpatched_count, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    uint32_t source_removed_count = 0;
-    uint32_t target_added_count = 0;
-    uint32_t modified_content_count = 0;
-    uint32_t modified_permissions_count = 0;
+    struct PatchAssetJob patch_jobs[LOCAL_PATCH_BATCH_ASSET_COUNT];
+    Longtail_JobAPI_JobFunc patch_funcs[LOCAL_PATCH_BATCH_ASSET_COUNT];
+    void* patch_ctxs[LOCAL_PATCH_BATCH_ASSET_COUNT];
 
-    uint32_t source_index = 0;
-    uint32_t target_index = 0;
-    while (source_index < source_asset_count && target_index < target_asset_count)
+    uint32_t unpatched_count = 0;
+    uint32_t patched_count = 0;
+    for (uint32_t batch_start = 0; batch_start < asset_count; batch_start += LOCAL_PATCH_BATCH_ASSET_COUNT)
     {
-        TLongtail_Hash source_path_hash = source_path_hashes[source_index];
-        TLongtail_Hash target_path_hash = target_path_hashes[target_index];
-        const uint32_t* source_asset_index_ptr = Longtail_LookupTable_Get(source_path_hash_to_index, source_path_hash);
-        LONGTAIL_FATAL_ASSERT(ctx, source_asset_index_ptr, return EINVAL)
-        uint32_t source_asset_index = *source_asset_index_ptr;
-        const uint32_t* target_asset_index_ptr = Longtail_LookupTable_Get(target_path_hash_to_index, target_path_hash);
-        LONGTAIL_FATAL_ASSERT(ctx, target_asset_index_ptr, return EINVAL)
-        uint32_t target_asset_index = *target_asset_index_ptr;
+        uint32_t batch_count = (asset_count - batch_start) < LOCAL_PATCH_BATCH_ASSET_COUNT ? (asset_count - batch_start) : LOCAL_PATCH_BATCH_ASSET_COUNT;
+        for (uint32_t j = 0; j < batch_count; ++j)
+        {
+            struct PatchAssetJob* job = &patch_jobs[j];
+            job->m_VersionStorageAPI = version_storage_api;
+            job->m_HashAPI = hash_api;
+            job->m_SourceVersion = source_version;
+            job->m_TargetVersion = target_version;
+            job->m_VersionPath = version_path;
+            job->m_SourceAssetIndex = source_asset_indexes[batch_start + j];
+            job->m_TargetAssetIndex = target_asset_indexes[batch_start + j];
+            job->m_FullAssetPath = 0;
+            job->m_StagingPath = 0;
+            job->m_TargetFile = 0;
+            job->m_MissingChunks = 0;
+            job->m_ReusedSize = 0;
+            job->m_Err = EINVAL;
+            patch_funcs[j] = PatchAssetFromLocalChunks;
+            patch_ctxs[j] = job;
+        }
 
-        const char* source_path = &source_version->m_NameData[source_version->m_NameOffsets[source_asset_index]];
-        const char* target_path = &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]];
+        Longtail_JobAPI_Group job_group = 0;
+        int err = job_api->ReserveJobs(job_api, batch_count, &job_group);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+            return err;
+        }
+        Longtail_JobAPI_Jobs jobs;
+        err = job_api->CreateJobs(job_api, job_group, batch_count, patch_funcs, patch_ctxs, &jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+        err = job_api->ReadyJobs(job_api, batch_count, jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, err == 0, return err)
+        err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        }
+        for (uint32_t j = 0; j < batch_count && err == 0; ++j)
+        {
+            err = patch_jobs[j].m_Err;
+        }
 
-        if (source_path_hash == target_path_hash)
+        if (err == 0)
         {
-            TLongtail_Hash source_content_hash = source_version->m_ContentHashes[source_asset_index];
-            TLongtail_Hash target_content_hash = target_version->m_ContentHashes[target_asset_index];
-            if (source_content_hash != target_content_hash)
+            err = WriteMissingAssetChunks(
+                block_store_api,
+                version_storage_api,
+                job_api,
+                progress_api,
+                optional_cancel_api,
+                optional_cancel_token,
+                store_index,
+                chunk_hash_to_block_index,
+                batch_count,
+                patch_jobs);
+            if (err)
             {
-                modified_source_content_indexes[modified_content_count] = source_asset_index;
-                modified_target_content_indexes[modified_content_count] = target_asset_index;
-                ++modified_content_count;
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching content for asset %s", source_path)
+                LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteMissingAssetChunks() failed with %d", err)
             }
-            else
+        }
+
+        for (uint32_t j = 0; j < batch_count; ++j)
+        {
+            struct PatchAssetJob* job = &patch_jobs[j];
+            if (job->m_TargetFile == 0)
             {
-                uint16_t source_permissions = source_version->m_Permissions[source_asset_index];
-                uint16_t target_permissions = target_version->m_Permissions[target_asset_index];
-                if (source_permissions != target_permissions)
-                {
-                    modified_source_permissions_indexes[modified_permissions_count] = source_asset_index;
-                    modified_target_permissions_indexes[modified_permissions_count] = target_asset_index;
-                    ++modified_permissions_count;
-                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching permissions for asset %s", source_path)
-                }
+                out_unpatched_asset_indexes[unpatched_count++] = job->m_TargetAssetIndex;
+                continue;
             }
-
-            ++source_index;
-            ++target_index;
+            if (err)
+            {
+                AbortPatchAsset(job);
+                continue;
+            }
+            const char* asset_path = &target_version->m_NameData[target_version->m_NameOffsets[job->m_TargetAssetIndex]];
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Patched `%s` reusing %" PRIu64 " of %" PRIu64 " bytes from the local file", asset_path, job->m_ReusedSize, target_version->m_AssetSizes[job->m_TargetAssetIndex])
+            err = FinishPatchAsset(job, retain_permissions);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FinishPatchAsset() failed with %d", err)
+                continue;
+            }
+            WriteJournalAsset(optional_journal, job->m_TargetAssetIndex);
+            ++patched_count;
         }
-        else if (source_path_hash < target_path_hash)
+        if (err)
         {
-            const uint32_t* source_asset_index_ptr = Longtail_LookupTable_Get(source_path_hash_to_index, source_path_hash);
-            LONGTAIL_FATAL_ASSERT(ctx, source_asset_index_ptr, return EINVAL)
-            source_asset_index = *source_asset_index_ptr;
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Removed asset %s", source_path)
-            removed_source_asset_indexes[source_removed_count] = source_asset_index;
-            ++source_removed_count;
-            ++source_index;
+            return err;
         }
-        else
-        {
-            const uint32_t* target_asset_index_ptr = Longtail_LookupTable_Get(target_path_hash_to_index, target_path_hash);
-            LONGTAIL_FATAL_ASSERT(ctx, target_asset_index_ptr, return EINVAL)
-            target_asset_index = *target_asset_index_ptr;
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Added asset %s", target_path)
-            added_target_asset_indexes[target_added_count] = target_asset_index;
-            ++target_added_count;
-            ++target_index;
-        } 
-    }
-    while (source_index < source_asset_count)
-    {
-        // source_path_hash removed
-        TLongtail_Hash source_path_hash = source_path_hashes[source_index];
-        const uint32_t* source_asset_index_ptr = Longtail_LookupTable_Get(source_path_hash_to_index, source_path_hash);
-        LONGTAIL_FATAL_ASSERT(ctx, source_asset_index_ptr, return EINVAL)
-        uint32_t source_asset_index = *source_asset_index_ptr;
-        const char* source_path = &source_version->m_NameData[source_version->m_NameOffsets[source_asset_index]];
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Removed asset %s", source_path)
-        removed_source_asset_indexes[source_removed_count] = source_asset_index;
-        ++source_removed_count;
-        ++source_index;
     }
-    while (target_index < target_asset_count)
+    if (patched_count > 0)
     {
-        // target_path_hash added
-        TLongtail_Hash target_path_hash = target_path_hashes[target_index];
-        const uint32_t* target_asset_index_ptr = Longtail_LookupTable_Get(target_path_hash_to_index, target_path_hash);
-        LONGTAIL_FATAL_ASSERT(ctx, target_asset_index_ptr, return EINVAL)
-        uint32_t target_asset_index = *target_asset_index_ptr;
-        const char* target_path = &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]];
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Added asset %s", target_path)
-        added_target_asset_indexes[target_added_count] = target_asset_index;
-        ++target_added_count;
-        ++target_index;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_ChangeVersion: Patched %u of %u modified assets from local content", patched_count, asset_count)
     }
-    if (source_removed_count > 0)
+    *out_unpatched_count = unpatched_count;
+    return 0;
+}
+
+// Starts the journal with one slot for each moved, added and modified asset that the journal does not hold yet
+static int StartChangeVersionJournal(
+    struct WriteJournal* journal,
+    const struct Longtail_VersionDiff* version_diff)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(journal, "%p"),
+        LONGTAIL_LOGFIELD(version_diff, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    uint32_t moved_count = *version_diff->m_MovedCount;
+    uint32_t added_count = *version_diff->m_TargetAddedCount;
+    uint32_t modified_content_count = *version_diff->m_ModifiedContentCount;
+    uint32_t* pending_asset_indexes = (uint32_t*)Longtail_Alloc("ChangeVersion", sizeof(uint32_t) * (moved_count + added_count + modified_content_count + 1));
+    if (!pending_asset_indexes)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Found %u removed assets", source_removed_count)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
     }
-    if (target_added_count > 0)
+    const uint8_t* is_journaled = journal->m_IsCompleted;
+    uint32_t pending_count = 0;
+    for (uint32_t i = 0; i < moved_count; ++i)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Found %u added assets", target_added_count)
+        uint32_t asset_index = version_diff->m_TargetMovedAssetIndexes[i];
+        if (!is_journaled[asset_index])
+        {
+            pending_asset_indexes[pending_count++] = asset_index;
+        }
     }
-    if (modified_content_count > 0)
+    for (uint32_t i = 0; i < added_count; ++i)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching content for %u assets found", modified_content_count)
+        uint32_t asset_index = version_diff->m_TargetAddedAssetIndexes[i];
+        if (!is_journaled[asset_index])
+        {
+            pending_asset_indexes[pending_count++] = asset_index;
+        }
     }
-    if (modified_permissions_count > 0)
+    for (uint32_t i = 0; i < modified_content_count; ++i)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching permission for %u assets found", modified_permissions_count)
+        uint32_t asset_index = version_diff->m_TargetContentModifiedAssetIndexes[i];
+        if (!is_journaled[asset_index])
+        {
+            pending_asset_indexes[pending_count++] = asset_index;
+        }
     }
-
-    size_t version_diff_size = GetVersionDiffSize(source_removed_count, target_added_count, modified_content_count, modified_permissions_count);
-    struct Longtail_VersionDiff* version_diff = (struct Longtail_VersionDiff*)Longtail_Alloc("CreateVersionDiff", version_diff_size);
-    if (!version_diff)
+    int err = StartWriteJournal(journal, pending_count, pending_asset_indexes);
+    Longtail_Free(pending_asset_indexes);
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        Longtail_Free(work_mem);
-        return ENOMEM;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "StartWriteJournal() failed with %d", err)
+        return err;
     }
-    uint32_t* counts_ptr = (uint32_t*)(void*)&version_diff[1];
-    counts_ptr[0] = source_removed_count;
-    counts_ptr[1] = target_added_count;
-    counts_ptr[2] = modified_content_count;
-    counts_ptr[3] = modified_permissions_count;
-    InitVersionDiff(version_diff);
-
-    memmove(version_diff->m_SourceRemovedAssetIndexes, removed_source_asset_indexes, sizeof(uint32_t) * source_removed_count);
-    memmove(version_diff->m_TargetAddedAssetIndexes, added_target_asset_indexes, sizeof(uint32_t) * target_added_count);
-    memmove(version_diff->m_SourceContentModifiedAssetIndexes, modified_source_content_indexes, sizeof(uint32_t) * modified_content_count);
-    memmove(version_diff->m_TargetContentModifiedAssetIndexes, modified_target_content_indexes, sizeof(uint32_t) * modified_content_count);
-    memmove(version_diff->m_SourcePermissionsModifiedAssetIndexes, modified_source_permissions_indexes, sizeof(uint32_t) * modified_permissions_count);
-    memmove(version_diff->m_TargetPermissionsModifiedAssetIndexes, modified_target_permissions_indexes, sizeof(uint32_t) * modified_permissions_count);
-
-    QSORT(version_diff->m_SourceRemovedAssetIndexes, source_removed_count, sizeof(uint32_t), SortPathLongToShort, (void*)source_version);
-    QSORT(version_diff->m_TargetAddedAssetIndexes, target_added_count, sizeof(uint32_t), SortPathShortToLong, (void*)target_version);
-
-    Longtail_Free(work_mem);
-    *out_version_diff = version_diff;
     return 0;
 }
 
-int Longtail_ChangeVersion(
+static int ChangeVersion(
     struct Longtail_BlockStoreAPI* block_store_api,
     struct Longtail_StorageAPI* version_storage_api,
     struct Longtail_HashAPI* hash_api,
@@ -6927,6 +12257,7 @@ int Longtail_ChangeVersion(
     const struct Longtail_VersionIndex* target_version,
     const struct Longtail_VersionDiff* version_diff,
     const char* version_path,
+    struct WriteJournal* optional_journal,
     int retain_permissions)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -6942,17 +12273,9 @@ int Longtail_ChangeVersion(
         LONGTAIL_LOGFIELD(target_version, "%p"),
         LONGTAIL_LOGFIELD(version_diff, "%p"),
         LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(optional_journal, "%p"),
         LONGTAIL_LOGFIELD(retain_permissions, "%d")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_storage_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, source_version != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, target_version != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, version_diff != 0, return EINVAL)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
     int err = EnsureParentPathExists(version_storage_api, version_path);
     if (err)
@@ -6967,137 +12290,124 @@ int Longtail_ChangeVersion(
         return err;
     }
 
-    uint32_t remove_count = *version_diff->m_SourceRemovedCount;
-    LONGTAIL_FATAL_ASSERT(ctx, remove_count <= *source_version->m_AssetCount, return EINVAL);
-    if (remove_count > 0)
+    // Moved, added and modified assets recorded in the journal by an earlier, interrupted, run are not moved or written again
+    const uint8_t* is_journaled = optional_journal ? optional_journal->m_IsCompleted : 0;
+    if (optional_journal)
+    {
+        err = StartChangeVersionJournal(optional_journal, version_diff);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "StartChangeVersionJournal() failed with %d", err)
+            return err;
+        }
+    }
+
+    // Moves are applied first since the parent folders of moved files may be removed, moves with a removed
+    // asset in the way of the target path are applied once the removed assets in the way are gone
+    uint32_t moved_count = *version_diff->m_MovedCount;
+    LONGTAIL_FATAL_ASSERT(ctx, moved_count <= *source_version->m_AssetCount, return EINVAL);
+    if (moved_count > 0)
     {
-        uint32_t* remove_indexes = (uint32_t*)Longtail_Alloc("ChangeVersion", sizeof(uint32_t) * remove_count);
-        if (!remove_indexes)
+        uint32_t conflict_max_count = *version_diff->m_SourceRemovedCount;
+        size_t is_deferred_move_size = moved_count;
+        size_t conflict_asset_indexes_size = sizeof(uint32_t) * conflict_max_count;
+        void* move_work_mem = Longtail_Alloc("ChangeVersion", conflict_asset_indexes_size + is_deferred_move_size);
+        if (!move_work_mem)
         {
             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
             return ENOMEM;
         }
-        memcpy(remove_indexes, version_diff->m_SourceRemovedAssetIndexes, sizeof(uint32_t) * remove_count);
-
-        uint32_t retry_count = 10;
-        uint32_t successful_remove_count = 0;
-        while (retry_count && (successful_remove_count < remove_count))
+        uint32_t* conflict_asset_indexes = (uint32_t*)move_work_mem;
+        uint8_t* is_deferred_move = (uint8_t*)&conflict_asset_indexes[conflict_max_count];
+        uint32_t conflict_count = 0;
+        err = FindMoveConflicts(
+            source_version,
+            target_version,
+            version_diff,
+            is_deferred_move,
+            conflict_asset_indexes,
+            &conflict_count);
+        if (err)
         {
-            if (retry_count < 10)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FindMoveConflicts() failed with %d", err)
+            Longtail_Free(move_work_mem);
+            return err;
+        }
+        err = MoveAssets(
+            version_storage_api,
+            optional_cancel_api,
+            optional_cancel_token,
+            source_version,
+            target_version,
+            version_diff,
+            version_path,
+            is_deferred_move,
+            0,
+            optional_journal,
+            retain_permissions);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "MoveAssets() failed with %d", err)
+            Longtail_Free(move_work_mem);
+            return err;
+        }
+        if (conflict_count > 0)
+        {
+            err = RemoveAssets(
+                version_storage_api,
+                job_api,
+                optional_cancel_api,
+                optional_cancel_token,
+                source_version,
+                version_path,
+                conflict_count,
+                conflict_asset_indexes);
+            if (err)
             {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Longtail_ChangeVersion: Retrying removal of remaning %u assets in %s", remove_count - successful_remove_count, version_path)
-            }
-            --retry_count;
-            if ((successful_remove_count & 0x7f) == 0x7f) {
-                if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
-                {
-                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Opeation cancelled, failed with %d", ECANCELED)
-                    return ECANCELED;
-                }
+                LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "RemoveAssets() failed with %d", err)
+                Longtail_Free(move_work_mem);
+                return err;
             }
-            for (uint32_t r = 0; r < remove_count; ++r)
+            err = MoveAssets(
+                version_storage_api,
+                optional_cancel_api,
+                optional_cancel_token,
+                source_version,
+                target_version,
+                version_diff,
+                version_path,
+                is_deferred_move,
+                1,
+                optional_journal,
+                retain_permissions);
+            if (err)
             {
-                uint32_t asset_index = remove_indexes[r];
-                if (asset_index == 0xffffffff)
-                {
-                    continue;
-                }
-                const char* asset_path = &source_version->m_NameData[source_version->m_NameOffsets[asset_index]];
-                char* full_asset_path = version_storage_api->ConcatPath(version_storage_api, version_path, asset_path);
-                if (IsDirPath(asset_path))
-                {
-                    full_asset_path[strlen(full_asset_path) - 1] = '\0';
-                    if (!version_storage_api->IsDir(version_storage_api, full_asset_path))
-                    {
-                        remove_indexes[r] = 0xffffffff;
-                        Longtail_Free(full_asset_path);
-                        continue;
-                    }
-                    uint16_t permissions = 0;
-                    err = version_storage_api->GetPermissions(version_storage_api, full_asset_path, &permissions);
-                    if (err)
-                    {
-                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetPermissions() failed with %d", err)
-                        Longtail_Free(full_asset_path);
-                        Longtail_Free(remove_indexes);
-                        return err;
-                    }
-                    if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
-                    {
-                        err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, permissions | (Longtail_StorageAPI_UserWriteAccess | Longtail_StorageAPI_GroupWriteAccess | Longtail_StorageAPI_OtherWriteAccess));
-                        if (err)
-                        {
-                            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
-                            Longtail_Free(full_asset_path);
-                            Longtail_Free(remove_indexes);
-                            return err;
-                        }
-                    }
-                    err = version_storage_api->RemoveDir(version_storage_api, full_asset_path);
-                    if (err && version_storage_api->IsDir(version_storage_api, full_asset_path))
-                    {
-                        if (!retry_count)
-                        {
-                            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Can't to remove dir `%s`, failed with %d", full_asset_path, err)
-                            Longtail_Free(full_asset_path);
-                            Longtail_Free(remove_indexes);
-                            return err;
-                        }
-                        Longtail_Free(full_asset_path);
-                        full_asset_path = 0;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (!version_storage_api->IsFile(version_storage_api, full_asset_path))
-                    {
-                        remove_indexes[r] = 0xffffffff;
-                        Longtail_Free(full_asset_path);
-                        continue;
-                    }
-                    uint16_t permissions = 0;
-                    err = version_storage_api->GetPermissions(version_storage_api, full_asset_path, &permissions);
-                    if (err)
-                    {
-                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetPermissions() failed with %d", err)
-                        Longtail_Free(full_asset_path);
-                        Longtail_Free(remove_indexes);
-                        return err;
-                    }
-                    if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
-                    {
-                        err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, permissions | (Longtail_StorageAPI_UserWriteAccess));
-                        if (err)
-                        {
-                            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
-                            Longtail_Free(full_asset_path);
-                            Longtail_Free(remove_indexes);
-                            return err;
-                        }
-                    }
-                    err = version_storage_api->RemoveFile(version_storage_api, full_asset_path);
-                    if (err && version_storage_api->IsFile(version_storage_api, full_asset_path))
-                    {
-                        if (!retry_count)
-                        {
-                            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Can't to file dir `%s`, failed with %d", full_asset_path, err)
-                            Longtail_Free(full_asset_path);
-                            Longtail_Free(remove_indexes);
-                            return err;
-                        }
-                        Longtail_Free(full_asset_path);
-                        full_asset_path = 0;
-                        continue;
-                    }
-                }
-                Longtail_Free(full_asset_path);
-                full_asset_path = 0;
-                remove_indexes[r] = 0xffffffff;
-                ++successful_remove_count;
+                LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "MoveAssets() failed with %d", err)
+                Longtail_Free(move_work_mem);
+                return err;
             }
         }
-        Longtail_Free(remove_indexes);
+        Longtail_Free(move_work_mem);
+    }
+
+    uint32_t remove_count = *version_diff->m_SourceRemovedCount;
+    LONGTAIL_FATAL_ASSERT(ctx, remove_count <= *source_version->m_AssetCount, return EINVAL);
+    if (remove_count > 0)
+    {
+        err = RemoveAssets(
+            version_storage_api,
+            job_api,
+            optional_cancel_api,
+            optional_cancel_token,
+            source_version,
+            version_path,
+            remove_count,
+            version_diff->m_SourceRemovedAssetIndexes);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "RemoveAssets() failed with %d", err)
+            return err;
+        }
     }
 
     uint32_t added_count = *version_diff->m_TargetAddedCount;
@@ -7110,7 +12420,8 @@ int Longtail_ChangeVersion(
         uint32_t chunk_count = (uint32_t)*store_index->m_ChunkCount;
         size_t chunk_hash_to_block_index_size = Longtail_LookupTable_GetSize(chunk_count);
         size_t asset_indexes_size = sizeof(uint32_t) * write_asset_count;
-        size_t work_mem_size = chunk_hash_to_block_index_size + asset_indexes_size;
+        size_t patch_asset_indexes_size = sizeof(uint32_t) * modified_content_count;
+        size_t work_mem_size = chunk_hash_to_block_index_size + asset_indexes_size + patch_asset_indexes_size * 2;
 
         void* work_mem = Longtail_Alloc("ChangeVersion", work_mem_size);
         if (!work_mem)
@@ -7123,6 +12434,10 @@ int Longtail_ChangeVersion(
         struct Longtail_LookupTable* chunk_hash_to_block_index = Longtail_LookupTable_Create(p, chunk_count, 0);
         p += chunk_hash_to_block_index_size;
         uint32_t* asset_indexes = (uint32_t*)p;
+        p += asset_indexes_size;
+        uint32_t* patch_source_asset_indexes = (uint32_t*)p;
+        p += patch_asset_indexes_size;
+        uint32_t* patch_target_asset_indexes = (uint32_t*)p;
 
         uint32_t block_count = *store_index->m_BlockCount;
         for (uint32_t b = 0; b < block_count; ++b)
@@ -7137,57 +12452,119 @@ int Longtail_ChangeVersion(
             }
         }
 
+        write_asset_count = 0;
         for (uint32_t i = 0; i < added_count; ++i)
         {
-            asset_indexes[i] = version_diff->m_TargetAddedAssetIndexes[i];
+            uint32_t asset_index = version_diff->m_TargetAddedAssetIndexes[i];
+            if (is_journaled && is_journaled[asset_index])
+            {
+                continue;
+            }
+            asset_indexes[write_asset_count++] = asset_index;
         }
+
+        // A local file that is not in the journal may have been partially written by an interrupted run.
+        // Local chunks are verified with hash_api so it must be the hash the target version was indexed with
+        int allow_patching = (optional_journal == 0 || !optional_journal->m_IsResumed) &&
+            hash_api->GetIdentifier(hash_api) == *target_version->m_HashIdentifier;
+
+        // Modified assets that share most of their content with the local file are patched,
+        // the rest are written from blocks together with the added assets
+        uint32_t patch_count = 0;
         for (uint32_t i = 0; i < modified_content_count; ++i)
         {
-            asset_indexes[added_count + i] = version_diff->m_TargetContentModifiedAssetIndexes[i];
+            uint32_t target_asset_index = version_diff->m_TargetContentModifiedAssetIndexes[i];
+            if (is_journaled && is_journaled[target_asset_index])
+            {
+                continue;
+            }
+            if (!allow_patching)
+            {
+                asset_indexes[write_asset_count++] = target_asset_index;
+                continue;
+            }
+            patch_source_asset_indexes[patch_count] = version_diff->m_SourceContentModifiedAssetIndexes[i];
+            patch_target_asset_indexes[patch_count] = target_asset_index;
+            ++patch_count;
+        }
+        if (patch_count > 0)
+        {
+            uint32_t unpatched_count = 0;
+            err = PatchAssetsFromLocalChunks(
+                block_store_api,
+                version_storage_api,
+                hash_api,
+                job_api,
+                progress_api,
+                optional_cancel_api,
+                optional_cancel_token,
+                store_index,
+                source_version,
+                target_version,
+                version_path,
+                chunk_hash_to_block_index,
+                optional_journal,
+                retain_permissions,
+                patch_count,
+                patch_source_asset_indexes,
+                patch_target_asset_indexes,
+                &asset_indexes[write_asset_count],
+                &unpatched_count);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, err == ECANCELED ?  LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "PatchAssetsFromLocalChunks() failed with %d", err)
+                Longtail_Free(work_mem);
+                return err;
+            }
+            write_asset_count += unpatched_count;
         }
 
-        struct AssetWriteList* awl;
-        err = BuildAssetWriteList(
-            write_asset_count,
-            asset_indexes,
-            target_version->m_NameOffsets,
-            target_version->m_NameData,
-            target_version->m_ChunkHashes,
-            target_version->m_AssetChunkCounts,
-            target_version->m_AssetChunkIndexStarts,
-            target_version->m_AssetChunkIndexes,
-            chunk_hash_to_block_index,
-            &awl);
-
-        if (err)
+        if (write_asset_count > 0)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BuildAssetWriteList() failed with %d", err)
-            Longtail_Free(work_mem);
-            return err;
-        }
+            struct AssetWriteList* awl;
+            err = BuildAssetWriteList(
+                write_asset_count,
+                asset_indexes,
+                target_version->m_NameOffsets,
+                target_version->m_NameData,
+                target_version->m_ChunkHashes,
+                target_version->m_AssetChunkCounts,
+                target_version->m_AssetChunkIndexStarts,
+                target_version->m_AssetChunkIndexes,
+                chunk_hash_to_block_index,
+                &awl);
 
-        err = WriteAssets(
-            block_store_api,
-            version_storage_api,
-            job_api,
-            progress_api,
-            optional_cancel_api,
-            optional_cancel_token,
-            store_index,
-            target_version,
-            version_path,
-            chunk_hash_to_block_index,
-            awl,
-            retain_permissions);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BuildAssetWriteList() failed with %d", err)
+                Longtail_Free(work_mem);
+                return err;
+            }
 
-        Longtail_Free(awl);
-        awl = 0;
+            err = WriteAssets(
+                block_store_api,
+                version_storage_api,
+                job_api,
+                progress_api,
+                optional_cancel_api,
+                optional_cancel_token,
+                store_index,
+                target_version,
+                version_path,
+                chunk_hash_to_block_index,
+                awl,
+                optional_journal,
+                retain_permissions);
 
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, err == ECANCELED ?  LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteAssets() failed with %d", err)
-            Longtail_Free(work_mem);
-            return err;
+            Longtail_Free(awl);
+            awl = 0;
+
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, err == ECANCELED ?  LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteAssets() failed with %d", err)
+                Longtail_Free(work_mem);
+                return err;
+            }
         }
 
         Longtail_Free(work_mem);
@@ -7224,6 +12601,112 @@ int Longtail_ChangeVersion(
     return err;
 }
 
+int Longtail_ChangeVersion(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const struct Longtail_VersionDiff* version_diff,
+    const char* version_path,
+    int retain_permissions)
+{
+    return Longtail_ChangeVersionJournaled(
+        block_store_api,
+        version_storage_api,
+        hash_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        store_index,
+        source_version,
+        target_version,
+        version_diff,
+        version_path,
+        0,
+        retain_permissions);
+}
+
+int Longtail_ChangeVersionJournaled(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const struct Longtail_VersionDiff* version_diff,
+    const char* version_path,
+    const char* optional_journal_path,
+    int retain_permissions)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(source_version, "%p"),
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(version_diff, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(optional_journal_path, "%s"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_INFO)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, store_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, source_version != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, target_version != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, version_diff != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, optional_journal_path == 0 || (version_path != 0 && !IsPathInFolder(version_path, optional_journal_path)), return EINVAL)
+
+    struct WriteJournal* journal = 0;
+    if (optional_journal_path)
+    {
+        int err = OpenWriteJournal(version_storage_api, target_version, version_path, optional_journal_path, &journal);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "OpenWriteJournal() failed with %d", err)
+            return err;
+        }
+    }
+
+    int err = ChangeVersion(
+        block_store_api,
+        version_storage_api,
+        hash_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        store_index,
+        source_version,
+        target_version,
+        version_diff,
+        version_path,
+        journal,
+        retain_permissions);
+
+    CloseWriteJournal(journal, err == 0);
+    return err;
+}
+
 size_t Longtail_GetStoreIndexDataSize(uint32_t block_count, uint32_t chunk_count)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -8182,6 +13665,7 @@ uint32_t Longtail_BlockIndex_GetBlockChunksDataSize(struct Longtail_StoredBlock*
 uint32_t Longtail_FileInfos_GetCount(const struct Longtail_FileInfos* file_infos) { return file_infos->m_Count; }
 const char* Longtail_FileInfos_GetPath(const struct Longtail_FileInfos* file_infos, uint32_t index) { return &file_infos->m_PathData[file_infos->m_PathStartOffsets[index]]; }
 uint64_t Longtail_FileInfos_GetSize(const struct Longtail_FileInfos* file_infos, uint32_t index) { return file_infos->m_Sizes[index]; }
+uint64_t Longtail_FileInfos_GetModificationTime(const struct Longtail_FileInfos* file_infos, uint32_t index) { return file_infos->m_ModificationTimes[index]; }
 const uint16_t* Longtail_FileInfos_GetPermissions(const struct Longtail_FileInfos* file_infos, uint32_t index) { return file_infos->m_Permissions; }
 
 uint32_t Longtail_VersionIndex_GetVersion(const struct Longtail_VersionIndex* version_index) { return *version_index->m_Version; }
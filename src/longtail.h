@@ -206,6 +206,7 @@ typedef int (*Longtail_Hash_BeginContextFunc)(struct Longtail_HashAPI* hash_api,
 typedef void (*Longtail_Hash_HashFunc)(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context, uint32_t length, const void* data);
 typedef uint64_t (*Longtail_Hash_EndContextFunc)(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context);
 typedef int (*Longtail_Hash_HashBufferFunc)(struct Longtail_HashAPI* hash_api, uint32_t length, const void* data, uint64_t* out_hash);
+typedef int (*Longtail_Hash_HashBuffersFunc)(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes);
 
 struct Longtail_HashAPI
 {
@@ -215,10 +216,16 @@ struct Longtail_HashAPI
     Longtail_Hash_HashFunc Hash;
     Longtail_Hash_EndContextFunc EndContext;
     Longtail_Hash_HashBufferFunc HashBuffer;
+    Longtail_Hash_HashBuffersFunc HashBuffers;
 };
 
 LONGTAIL_EXPORT uint64_t Longtail_GetHashAPISize();
 
+/*! @brief Initializes a struct Longtail_HashAPI in @p mem.
+ *
+ * HashBuffers is set to a function that calls @p hash_buffer_func for each buffer, use Longtail_MakeHashAPIWithBatch()
+ * for hash apis that can hash several buffers side by side.
+ */
 LONGTAIL_EXPORT struct Longtail_HashAPI* Longtail_MakeHashAPI(
     void* mem,
     Longtail_DisposeFunc dispose_func,
@@ -228,12 +235,42 @@ LONGTAIL_EXPORT struct Longtail_HashAPI* Longtail_MakeHashAPI(
     Longtail_Hash_EndContextFunc end_context_func,
     Longtail_Hash_HashBufferFunc hash_buffer_func);
 
+/*! @brief Initializes a struct Longtail_HashAPI in @p mem with a HashBuffers implementation.
+ *
+ * @p optional_hash_buffers_func may be null for hash apis that can only hash one buffer at a time, HashBuffers is
+ * then set to a function that calls @p hash_buffer_func for each buffer so HashBuffers is always safe to call.
+ * Hash apis that fill in struct Longtail_HashAPI themselves can leave HashBuffers null, Longtail_Hash_HashBuffers() falls back the same way.
+ */
+LONGTAIL_EXPORT struct Longtail_HashAPI* Longtail_MakeHashAPIWithBatch(
+    void* mem,
+    Longtail_DisposeFunc dispose_func,
+    Longtail_Hash_GetIdentifierFunc get_identifier_func,
+    Longtail_Hash_BeginContextFunc begin_context_func,
+    Longtail_Hash_HashFunc hash_func,
+    Longtail_Hash_EndContextFunc end_context_func,
+    Longtail_Hash_HashBufferFunc hash_buffer_func,
+    Longtail_Hash_HashBuffersFunc optional_hash_buffers_func);
+
 LONGTAIL_EXPORT uint32_t Longtail_Hash_GetIdentifier(struct Longtail_HashAPI* hash_api);
 LONGTAIL_EXPORT int Longtail_Hash_BeginContext(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext* out_context);
 LONGTAIL_EXPORT void Longtail_Hash_Hash(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context, uint32_t length, const void* data);
 LONGTAIL_EXPORT uint64_t Longtail_Hash_EndContext(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context);
 LONGTAIL_EXPORT int Longtail_Hash_HashBuffer(struct Longtail_HashAPI* hash_api, uint32_t length, const void* data, uint64_t* out_hash);
 
+/*! @brief Hashes a number of independent buffers in one call.
+ *
+ * Gives the same hashes as calling HashBuffer() for each buffer but lets the hash api hash several buffers
+ * side by side. Hash apis without a HashBuffers implementation fall back to calling HashBuffer() for each buffer.
+ *
+ * @param[in] hash_api      An implementation of struct Longtail_HashAPI
+ * @param[in] count         Number of buffers to hash
+ * @param[in] lengths       Length of each buffer, @p count entries
+ * @param[in] datas         Pointer to the data of each buffer, @p count entries
+ * @param[out] out_hashes   Resulting hash of each buffer, @p count entries
+ * @return                  Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_Hash_HashBuffers(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes);
+
 ////////////// Longtail_HashRegistryAPI
 
 struct Longtail_HashRegistryAPI;
@@ -330,6 +367,7 @@ struct Longtail_StorageAPI_EntryProperties
     uint64_t m_Size;
     uint16_t m_Permissions;
     int m_IsDir;
+    uint64_t m_ModificationTime;    // Storage specific time stamp, only compared for equality, zero if unknown
 };
 
 struct Longtail_StorageAPI;
@@ -708,6 +746,14 @@ enum
     Longtail_BlockStoreAPI_StatU64_Flush_FailCount,
 
     Longtail_BlockStoreAPI_StatU64_GetStats_Count,
+
+    // New stats are appended before Longtail_BlockStoreAPI_StatU64_Count so existing stat indexes keep their values
+    Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Count,
+    Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Byte_Count,
+    Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheMiss_Count,
+    Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheMiss_Byte_Count,
+    Longtail_BlockStoreAPI_StatU64_CacheEvict_Count,
+    Longtail_BlockStoreAPI_StatU64_CacheEvict_Byte_Count,
         Longtail_BlockStoreAPI_StatU64_Count
 };
 
@@ -723,6 +769,7 @@ typedef int (*Longtail_BlockStore_GetExistingContentFunc)(struct Longtail_BlockS
 typedef int (*Longtail_BlockStore_PruneBlocksFunc)(struct Longtail_BlockStoreAPI* block_store_api, uint32_t block_keep_count, const TLongtail_Hash* block_keep_hashes, struct Longtail_AsyncPruneBlocksAPI* async_complete_api);
 typedef int (*Longtail_BlockStore_GetStatsFunc)(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_BlockStore_Stats* out_stats);
 typedef int (*Longtail_BlockStore_FlushFunc)(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_AsyncFlushAPI* async_complete_api);
+typedef int (*Longtail_BlockStore_GetStoredBlockChunksFunc)(struct Longtail_BlockStoreAPI* block_store_api, uint64_t block_hash, uint32_t chunk_count, const TLongtail_Hash* chunk_hashes, struct Longtail_AsyncGetStoredBlockAPI* async_complete_api);
 
 struct Longtail_BlockStoreAPI
 {
@@ -734,6 +781,9 @@ struct Longtail_BlockStoreAPI
     Longtail_BlockStore_PruneBlocksFunc PruneBlocks;
     Longtail_BlockStore_GetStatsFunc GetStats;
     Longtail_BlockStore_FlushFunc Flush;
+    // Optional, set to zero by Longtail_MakeBlockStoreAPI(). Appending this member changed the size of
+    // struct Longtail_BlockStoreAPI, block stores built against an older longtail.h must be rebuilt
+    Longtail_BlockStore_GetStoredBlockChunksFunc GetStoredBlockChunks;
 };
 
 
@@ -758,6 +808,26 @@ LONGTAIL_EXPORT int Longtail_BlockStore_PruneBlocks(struct Longtail_BlockStoreAP
 LONGTAIL_EXPORT int Longtail_BlockStore_GetStats(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_BlockStore_Stats* out_stats);
 LONGTAIL_EXPORT int Longtail_BlockStore_Flush(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_AsyncFlushAPI* async_complete_api);
 
+/*! @brief Gets a stored block holding at least the chunks @p chunk_hashes of block @p block_hash.
+ *
+ * Lets a block store that can decode part of a block, such as a seekable compressed block, skip the chunks that
+ * are not needed. The block index of the stored block describes the chunks it holds, hashes in @p chunk_hashes
+ * that are not part of the block are ignored. @p chunk_hashes only needs to be valid during the call.
+ * Block stores without a GetStoredBlockChunks implementation return the full block from GetStoredBlock().
+ * Block stores that wrap another block store must forward the call so partial reads reach the backing store.
+ *
+ * Adding GetStoredBlockChunks to struct Longtail_BlockStoreAPI is an ABI break, block store implementations
+ * built against an older longtail.h must be rebuilt.
+ *
+ * @param[in] block_store_api       An implementation of struct Longtail_BlockStoreAPI
+ * @param[in] block_hash            The hash of the block
+ * @param[in] chunk_count           Number of chunks in @p chunk_hashes
+ * @param[in] chunk_hashes          The hashes of the chunks that are needed
+ * @param[in] async_complete_api    Called with the stored block on completion
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_BlockStore_GetStoredBlockChunks(struct Longtail_BlockStoreAPI* block_store_api, uint64_t block_hash, uint32_t chunk_count, const TLongtail_Hash* chunk_hashes, struct Longtail_AsyncGetStoredBlockAPI* async_complete_api);
+
 typedef void (*Longtail_Assert)(const char* expression, const char* file, int line);
 LONGTAIL_EXPORT void Longtail_SetAssert(Longtail_Assert assert_func);
 
@@ -909,6 +979,30 @@ LONGTAIL_EXPORT int Longtail_GetFilesRecursively(
     const char* root_path,
     struct Longtail_FileInfos** out_file_infos);
 
+/*! @brief Get all files and directories in a path recursivley, listing directories in parallel.
+ *
+ * Same result and ordering as Longtail_GetFilesRecursively() but all directories at the same depth are listed
+ * using @p job_api. The struct Longtail_PathFilterAPI is called from the job threads and must be thread safe.
+ * Free the struct Longtail_FileInfos using Longtail_Free()
+ *
+ * @param[in] storage_api           An implementation of struct Longtail_StorageAPI interface.
+ * @param[in] job_api               An implementation of struct Longtail_JobAPI interface.
+ * @param[in] path_filter_api       An implementation of struct Longtail_PathFilter interface or null if no filtering is required
+ * @param[in] optional_cancel_api   An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
+ * @param[in] optional_cancel_token A cancel token or null if @p optional_cancel_api is null
+ * @param[in] root_path             Root path to search for files and directories - may not be null
+ * @param[out] out_file_infos       Pointer to a struct Longtail_FileInfos* pointer which will be set on success
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_GetFilesRecursivelyParallel(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_PathFilterAPI* path_filter_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    struct Longtail_FileInfos** out_file_infos);
+
 /*! @brief Create a version index for a struct Longtail_FileInfos.
  *
  * All files are chunked and hashes to create a struct VersionIndex, allocated using Longtail_Alloc()
@@ -941,6 +1035,46 @@ LONGTAIL_EXPORT int Longtail_CreateVersionIndex(
     uint32_t target_chunk_size,
     struct Longtail_VersionIndex** out_version_index);
 
+/*! @brief Create a version index for a struct Longtail_FileInfos reusing the chunks of unchanged files.
+ *
+ * Works like Longtail_CreateVersionIndex() but files whose path, size and modification time match an entry in
+ * @p previous_file_infos are not read, their chunks are copied from @p previous_version_index.
+ * Files with an unknown (zero) modification time are always chunked.
+ * If @p previous_version_index was created with a different hash api or target chunk size all files are chunked.
+ * The chunker must be the same as the one used to create @p previous_version_index.
+ * Free the version index with Longtail_Free()
+ *
+ * @param[in] storage_api               An implementation of struct Longtail_StorageAPI interface.
+ * @param[in] hash_api                  An implementation of struct Longtail_HashAPI interface.
+ * @param[in] chunker_api               An implementation of struct Longtail_ChunkerAPI interface.
+ * @param[in] job_api                   An implementation of struct Longtail_JobAPI interface
+ * @param[in] progress_api              An implementation of struct Longtail_JobAPI interface or null if no progress indication is required
+ * @param[in] optional_cancel_api       An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
+ * @param[in] optional_cancel_token     A cancel token or null if @p optional_cancel_api is null
+ * @param[in] root_path                 Root path for files in @p file_infos
+ * @param[in] optional_asset_tags       An array with a tag for each entry in @p file_infos, usually a compression tag, set to zero if no tags are wanted
+ * @param[in] target_chunk_size         The target size of chunks, with minimum size set to @target_chunk_size / 8 and maximum size set to @p target_chunk_size * 2
+ * @param[in] previous_version_index    The version index previously created from @p previous_file_infos
+ * @param[in] previous_file_infos       The struct Longtail_FileInfos @p previous_version_index was created from
+ * @param[out] out_version_index        Pointer to a struct Longtail_VersionIndex* pointer which will be set on success
+ * @return                              Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_CreateVersionIndexIncremental(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* optional_asset_tags,
+    uint32_t target_chunk_size,
+    const struct Longtail_VersionIndex* previous_version_index,
+    const struct Longtail_FileInfos* previous_file_infos,
+    struct Longtail_VersionIndex** out_version_index);
+
 /*! @brief Writes a struct Longtail_VersionIndex to a byte buffer.
  *
  * Serializes a struct Longtail_VersionIndex to a buffer which is allocated using Longtail_Alloc()
@@ -999,6 +1133,64 @@ LONGTAIL_EXPORT int Longtail_ReadVersionIndex(
     const char* path,
     struct Longtail_VersionIndex** out_version_index);
 
+/*! @brief Writes a struct Longtail_FileInfos to a byte buffer.
+ *
+ * Serializes a struct Longtail_FileInfos, including modification times, to a buffer which is allocated using Longtail_Alloc().
+ * Together with the version index created from it this is the state Longtail_CreateVersionIndexIncremental() needs from the previous run
+ *
+ * @param[in] file_infos            Pointer to an initialized struct Longtail_FileInfos
+ * @param[out] out_buffer           Pointer to a buffer pointer intitialized on success
+ * @param[out] out_size             Pointer to a size variable intitialized on success
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_WriteFileInfosToBuffer(
+    const struct Longtail_FileInfos* file_infos,
+    void** out_buffer,
+    size_t* out_size);
+
+/*! @brief Reads a struct Longtail_FileInfos from a byte buffer.
+ *
+ * Deserializes a struct Longtail_FileInfos from a buffer, the struct Longtail_FileInfos is allocated using Longtail_Alloc()
+ *
+ * @param[in] buffer                Buffer containing the serialized struct Longtail_FileInfos
+ * @param[in] size                  Size of the buffer
+ * @param[out] out_file_infos       Pointer to an struct Longtail_FileInfos pointer
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_ReadFileInfosFromBuffer(
+    const void* buffer,
+    size_t size,
+    struct Longtail_FileInfos** out_file_infos);
+
+/*! @brief Writes a struct Longtail_FileInfos.
+ *
+ * Serializes a struct Longtail_FileInfos to a file in a struct Longtail_StorageAPI at the specified path.
+ *
+ * @param[in] storage_api           An initialized struct Longtail_StorageAPI
+ * @param[in] file_infos            Pointer to an initialized struct Longtail_FileInfos
+ * @param[in] path                  A path in the storage api to store the file infos to
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_WriteFileInfos(
+    struct Longtail_StorageAPI* storage_api,
+    const struct Longtail_FileInfos* file_infos,
+    const char* path);
+
+/*! @brief Reads a struct Longtail_FileInfos.
+ *
+ * Deserializes a struct Longtail_FileInfos from a file in a struct Longtail_StorageAPI at the specified path.
+ * The file must exist.
+ *
+ * @param[in] storage_api           An initialized struct Longtail_StorageAPI
+ * @param[in] path                  A path in the storage api to read the file infos from
+ * @param[out] out_file_infos       Pointer to an struct Longtail_FileInfos pointer
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_ReadFileInfos(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    struct Longtail_FileInfos** out_file_infos);
+
 /*! @brief Get the chunks required to go to @p version_index by applying @p version_diff.
  *
  * Gets all the chunks required to apply @p version_diff which is a subset of all chunks in @p version_index
@@ -1042,10 +1234,61 @@ LONGTAIL_EXPORT int Longtail_WriteContent(
     struct Longtail_VersionIndex* version_index,
     const char* assets_folder);
 
+/*! @brief Create a version index and write the content blocks in a single pass over the source data.
+ *
+ * Chunks and hashes all files like Longtail_CreateVersionIndex() and hands the chunk data straight to block
+ * assembly instead of reading the source data a second time in Longtail_WriteContent().
+ * Chunks that already exist in @p block_store_api are skipped, the remaining chunks are packed into blocks with the
+ * same rules as Longtail_CreateStoreIndex() so the result matches Longtail_CreateVersionIndex() followed by
+ * Longtail_CreateMissingContent() and Longtail_WriteContent().
+ * The source data is processed in windows of chunks and the next window is hashed while the current one is
+ * queried and written. @p min_block_usage_percent is evaluated against all chunks of the version, chunks that are
+ * only found in blocks below the minimum usage are kept in memory until the whole version is chunked.
+ * Free the version index and store index with Longtail_Free()
+ *
+ * @param[in] storage_api               An implementation of struct Longtail_StorageAPI interface.
+ * @param[in] hash_api                  An implementation of struct Longtail_HashAPI interface.
+ * @param[in] chunker_api               An implementation of struct Longtail_ChunkerAPI interface.
+ * @param[in] job_api                   An implementation of struct Longtail_JobAPI interface
+ * @param[in] progress_api              An implementation of struct Longtail_JobAPI interface or null if no progress indication is required
+ * @param[in] optional_cancel_api       An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
+ * @param[in] optional_cancel_token     A cancel token or null if @p optional_cancel_api is null
+ * @param[in] block_store_api           An initialized struct Longtail_BlockStoreAPI to write blocks to
+ * @param[in] root_path                 Root path for files in @p file_infos
+ * @param[in] file_infos                The files to index
+ * @param[in] optional_asset_tags       An array with a tag for each entry in @p file_infos, usually a compression tag, set to zero if no tags are wanted
+ * @param[in] target_chunk_size         The target size of chunks, with minimum size set to @target_chunk_size / 8 and maximum size set to @p target_chunk_size * 2
+ * @param[in] max_block_size            The maximum size if bytes one block is allowed to be
+ * @param[in] max_chunks_per_block      The maximum number of chunks allowed inside one block
+ * @param[in] min_block_usage_percent   Passed on to Longtail_BlockStore_GetExistingContent()
+ * @param[out] out_version_index        Pointer to a struct Longtail_VersionIndex* pointer which will be set on success
+ * @param[out] out_store_index          Pointer to a struct Longtail_StoreIndex* pointer which will be set to the blocks written on success
+ * @return                              Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_CreateVersionIndexAndWriteContent(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    struct Longtail_BlockStoreAPI* block_store_api,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* optional_asset_tags,
+    uint32_t target_chunk_size,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    uint32_t min_block_usage_percent,
+    struct Longtail_VersionIndex** out_version_index,
+    struct Longtail_StoreIndex** out_store_index);
+
 /*! @brief Generate a store index with what is missing.
  *
  * Any content in @p version_index that is not present in @p store_index will be included in @p out_store_index
  * Chunks that are not present in @p store_index will be bundled up in blocks according to @p max_block_size and @p max_chunks_per_block.
+ * Chunks are packed asset by asset in version order and the chunks of small assets are kept in a single block.
  *
  * @param[in] hash_api              An implementation of struct Longtail_HashAPI interface. This must match the hashing api used to create both store index index and version index
  * @param[in] store_index           The known store index to check against
@@ -1063,6 +1306,23 @@ LONGTAIL_EXPORT int Longtail_CreateMissingContent(
     uint32_t max_chunks_per_block,
     struct Longtail_StoreIndex** out_store_index);
 
+/*! @brief Counts how many blocks the assets of a version are spread over.
+ *
+ * For each asset in @p version_index that has chunks in @p store_index, counts the distinct blocks of @p store_index
+ * holding its chunks. The average number of blocks a downsync of a single asset fetches is
+ * @p out_blocks_touched_count / @p out_asset_count. Chunks that are not in @p store_index are ignored.
+ *
+ * @param[in] store_index                   The store index with the blocks of the version content
+ * @param[in] version_index                 The version index
+ * @param[out] out_asset_count              Number of assets with chunks in @p store_index
+ * @param[out] out_blocks_touched_count     Sum of the number of blocks touched by each asset
+ * @return                                  Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_GetBlocksTouchedPerAsset(
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    uint32_t* out_asset_count,
+    uint64_t* out_blocks_touched_count);
 
 /*! @brief Generates an array of all chunks missing in a store index.
  *
@@ -1114,10 +1374,45 @@ LONGTAIL_EXPORT int Longtail_WriteVersion(
     const char* version_path,
     int retain_permissions);
 
+/*! @brief Unpack and write a version, recording progress in a journal.
+ *
+ * Works like Longtail_WriteVersion() but each completed asset is recorded in a journal file at @p optional_journal_path.
+ * If the operation is interrupted, the next call with the same journal only writes the assets that are not recorded
+ * in the journal or no longer match it. The journal is removed when the operation completes.
+ * The journal must not be inside @p version_path so it is never mistaken for an asset of the version.
+ *
+ * @param[in] block_storage_api     An implementation of struct Longtail_BlockStoreAPI interface
+ * @param[in] version_storage_api   An implementation of struct Longtail_StorageAPI interface
+ * @param[in] job_api               An implementation of struct Longtail_JobAPI interface
+ * @param[in] progress_api          An initialized struct Longtail_ProgressAPI, or 0 for no progress reporting
+ * @param[in] optional_cancel_api   An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
+ * @param[in] optional_cancel_token A cancel token or null if @p optional_cancel_api is null
+ * @param[in] store_index           The store index for @p block_store_api
+ * @param[in] version_index         The version index for the version to write
+ * @param[in] version_path          The path in @p version_storage_api to write the version to
+ * @param[in] optional_journal_path The path in @p version_storage_api of the progress journal, or null to disable the journal
+ * @param[in] retain_permissions    Flag for setting permissions - 0 = don't set permissions, 1 = set permissions
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_WriteVersionJournaled(
+    struct Longtail_BlockStoreAPI* block_storage_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    const char* version_path,
+    const char* optional_journal_path,
+    int retain_permissions);
+
 /*! @brief Get the difference between to struct Longtail_VersionIndex.
  *
  * Returns a struct Longtail_VersionDiff with the additions, modifications and deletions required to change
  * a version from @p source_version to @p target_version.
+ * A removed file and an added file with the same content hash and size are reported as a move instead of
+ * a deletion and an addition.
  *
  * @param[in] hash_api             An implementation of struct Longtail_HashAPI interface
  * @param[in] source_version       The version index we have
@@ -1137,6 +1432,10 @@ LONGTAIL_EXPORT int Longtail_CreateVersionDiff(
  * Uses @p store_index to know where chunks are located in blocks - this can either be the full
  * store index of @p block_storage_api or a store index that is slimmed down using Longtail_BlockStore_GetExistingContent.
  * Blocks are fetched from @p block_storage_api on demand.
+ * Modified assets that share content with the local file in @p version_path (as described by @p source_version)
+ * are patched by copying the shared chunks from the local file, only the remaining chunks are read from blocks.
+ * Moved assets are renamed in @p version_path, before removed assets are deleted using jobs from @p job_api.
+ * Removal finishes before any assets are written.
  *
  * @param[in] block_storage_api     An implementation of struct Longtail_BlockStoreAPI interface
  * @param[in] version_storage_api   An implementation of struct Longtail_StorageAPI interface
@@ -1168,6 +1467,45 @@ LONGTAIL_EXPORT int Longtail_ChangeVersion(
     const char* version_path,
     int retain_permissions);
 
+/*! @brief Unpack and modify a version, recording progress in a journal.
+ *
+ * Works like Longtail_ChangeVersion() but each moved and written asset is recorded in a journal file at @p optional_journal_path.
+ * If the operation is interrupted, the next call with the same journal skips the recorded assets that still match
+ * @p target_version, so @p source_version does not need to be rescanned. The journal is removed when the operation completes.
+ * The journal must not be inside @p version_path so it is never mistaken for an asset of the version.
+ *
+ * @param[in] block_storage_api     An implementation of struct Longtail_BlockStoreAPI interface
+ * @param[in] version_storage_api   An implementation of struct Longtail_StorageAPI interface
+ * @param[in] hash_api              An implementation of struct Longtail_HashAPI interface
+ * @param[in] job_api               An implementation of struct Longtail_JobAPI interface
+ * @param[in] progress_api          An initialized struct Longtail_ProgressAPI, or 0 for no progress reporting
+ * @param[in] optional_cancel_api   An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
+ * @param[in] optional_cancel_token A cancel token or null if @p optional_cancel_api is null
+ * @param[in] store_index           @p target_version retargetted to @p block_storage_api (see Longtail_BlockStoreAPI::GetExistingContent)
+ * @param[in] source_version        The version index for the current version
+ * @param[in] target_version        The version index for the target version
+ * @param[in] version_diff          The version diff between @p source_version and @p target_version
+ * @param[in] version_path          The path in @p version_storage_api to update
+ * @param[in] optional_journal_path The path in @p version_storage_api of the progress journal, or null to disable the journal
+ * @param[in] retain_permissions    Flag for setting permissions - 0 = don't set permissions, 1 = set permissions
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_ChangeVersionJournaled(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const struct Longtail_VersionDiff* version_diff,
+    const char* version_path,
+    const char* optional_journal_path,
+    int retain_permissions);
+
 /*! @brief Get the size of the block index data.
  *
  * This size is just for the data of the block index excluding the struct Longtail_BlockIndex.
@@ -1443,12 +1781,14 @@ struct Longtail_FileInfos
     uint32_t* m_PathStartOffsets;
     uint16_t* m_Permissions;
     char* m_PathData;
+    uint64_t* m_ModificationTimes;
 };
 
 LONGTAIL_EXPORT uint32_t Longtail_FileInfos_GetCount(const struct Longtail_FileInfos* file_infos);
 LONGTAIL_EXPORT const char* Longtail_FileInfos_GetPath(const struct Longtail_FileInfos* file_infos, uint32_t index);
 LONGTAIL_EXPORT const struct Longtail_Paths* Longtail_FileInfos_GetPaths(const struct Longtail_FileInfos* file_infos);
 LONGTAIL_EXPORT uint64_t Longtail_FileInfos_GetSize(const struct Longtail_FileInfos* file_infos, uint32_t index);
+LONGTAIL_EXPORT uint64_t Longtail_FileInfos_GetModificationTime(const struct Longtail_FileInfos* file_infos, uint32_t index);
 LONGTAIL_EXPORT const uint16_t* Longtail_FileInfos_GetPermissions(const struct Longtail_FileInfos* file_infos, uint32_t index);
 
 struct Longtail_StoreIndex
@@ -1663,6 +2003,9 @@ struct Longtail_VersionDiff
     uint32_t* m_TargetContentModifiedAssetIndexes;
     uint32_t* m_SourcePermissionsModifiedAssetIndexes;
     uint32_t* m_TargetPermissionsModifiedAssetIndexes;
+    uint32_t* m_MovedCount;
+    uint32_t* m_SourceMovedAssetIndexes;
+    uint32_t* m_TargetMovedAssetIndexes;
 };
 
 int Longtail_GetPathHash(struct Longtail_HashAPI* hash_api, const char* path, TLongtail_Hash* out_hash);
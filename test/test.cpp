@@ -13,7 +13,9 @@
 #include "../lib/cacheblockstore/longtail_cacheblockstore.h"
 #include "../lib/compressblockstore/longtail_compressblockstore.h"
 #include "../lib/compressionregistry/longtail_full_compression_registry.h"
+#include "../lib/compressionregistry/longtail_zstd_compression_registry.h"
 #include "../lib/filestorage/longtail_filestorage.h"
+#include "../lib/fastcdcchunker/longtail_fastcdcchunker.h"
 #include "../lib/fsblockstore/longtail_fsblockstore.h"
 #include "../lib/hpcdcchunker/longtail_hpcdcchunker.h"
 #include "../lib/hashregistry/longtail_full_hash_registry.h"
@@ -22,6 +24,7 @@
 #include "../lib/lz4/longtail_lz4.h"
 #include "../lib/memstorage/longtail_memstorage.h"
 #include "../lib/meowhash/longtail_meowhash.h"
+#include "../lib/seedblockstore/longtail_seedblockstore.h"
 #include "../lib/shareblockstore/longtail_shareblockstore.h"
 #include "../lib/zstd/longtail_zstd.h"
 
@@ -32,6 +35,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <math.h>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #define TEST_LOG(fmt, ...) \
     fprintf(stderr, "--- ");fprintf(stderr, fmt, __VA_ARGS__);
@@ -358,6 +367,99 @@ TEST(Longtail, Longtail_MeowHash)
     Longtail_DisposeAPI(&hash_api->m_API);
 }
 
+static void TestHashBuffers(struct Longtail_HashAPI* hash_api)
+{
+    // Lengths around the block and chunk boundaries of the hashers, with repeats so lanes fill up
+    const uint32_t buffer_count = 3 * 2100;
+    uint8_t* data = (uint8_t*)Longtail_Alloc(0, 2100);
+    for (uint32_t i = 0; i < 2100; ++i)
+    {
+        data[i] = (uint8_t)(i * 31 + 7);
+    }
+    uint32_t* lengths = (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * buffer_count);
+    const void** datas = (const void**)Longtail_Alloc(0, sizeof(const void*) * buffer_count);
+    uint64_t* hashes = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * buffer_count);
+    for (uint32_t b = 0; b < buffer_count; ++b)
+    {
+        lengths[b] = (b * 7) % 2100;
+        datas[b] = &data[2100 - lengths[b]];
+    }
+    ASSERT_EQ(0, Longtail_Hash_HashBuffers(hash_api, buffer_count, lengths, datas, hashes));
+    for (uint32_t b = 0; b < buffer_count; ++b)
+    {
+        uint64_t hash;
+        ASSERT_EQ(0, hash_api->HashBuffer(hash_api, lengths[b], datas[b], &hash));
+        ASSERT_EQ(hash, hashes[b]);
+    }
+    Longtail_Free(hashes);
+    Longtail_Free(datas);
+    Longtail_Free(lengths);
+    Longtail_Free(data);
+}
+
+TEST(Longtail, Longtail_HashBuffers)
+{
+    struct Longtail_HashAPI* blake2_hash_api = Longtail_CreateBlake2HashAPI();
+    TestHashBuffers(blake2_hash_api);
+    Longtail_DisposeAPI(&blake2_hash_api->m_API);
+
+    struct Longtail_HashAPI* blake3_hash_api = Longtail_CreateBlake3HashAPI();
+    TestHashBuffers(blake3_hash_api);
+    Longtail_DisposeAPI(&blake3_hash_api->m_API);
+
+    struct Longtail_HashAPI* meow_hash_api = Longtail_CreateMeowHashAPI();
+    TestHashBuffers(meow_hash_api);
+    Longtail_DisposeAPI(&meow_hash_api->m_API);
+}
+
+struct SingleBufferHashAPI
+{
+    struct Longtail_HashAPI m_API;
+    struct Longtail_HashAPI* m_BackingAPI;
+
+    static void Dispose(struct Longtail_API* api) { Longtail_Free(api); }
+    static uint32_t GetIdentifier(struct Longtail_HashAPI* hash_api) { return ((SingleBufferHashAPI*)hash_api)->m_BackingAPI->GetIdentifier(((SingleBufferHashAPI*)hash_api)->m_BackingAPI); }
+    static int HashBuffer(struct Longtail_HashAPI* hash_api, uint32_t length, const void* data, uint64_t* out_hash)
+    {
+        struct Longtail_HashAPI* backing_api = ((SingleBufferHashAPI*)hash_api)->m_BackingAPI;
+        return backing_api->HashBuffer(backing_api, length, data, out_hash);
+    }
+};
+
+TEST(Longtail, Longtail_MakeHashAPIWithoutHashBuffers)
+{
+    struct Longtail_HashAPI* blake3_hash_api = Longtail_CreateBlake3HashAPI();
+    void* mem = Longtail_Alloc(0, sizeof(struct SingleBufferHashAPI));
+    ASSERT_NE((void*)0, mem);
+    struct Longtail_HashAPI* hash_api = Longtail_MakeHashAPI(
+        mem,
+        SingleBufferHashAPI::Dispose,
+        SingleBufferHashAPI::GetIdentifier,
+        0,
+        0,
+        0,
+        SingleBufferHashAPI::HashBuffer);
+    ((struct SingleBufferHashAPI*)hash_api)->m_BackingAPI = blake3_hash_api;
+
+    // Callers that use the HashBuffers member directly must not crash on hash apis that only implement HashBuffer
+    ASSERT_NE((Longtail_Hash_HashBuffersFunc)0, hash_api->HashBuffers);
+    const char* texts[2] = { "first", "second buffer" };
+    const void* datas[2] = { texts[0], texts[1] };
+    const uint32_t lengths[2] = { (uint32_t)strlen(texts[0]), (uint32_t)strlen(texts[1]) };
+    uint64_t hashes[2];
+    ASSERT_EQ(0, hash_api->HashBuffers(hash_api, 2, lengths, datas, hashes));
+    for (uint32_t b = 0; b < 2; ++b)
+    {
+        uint64_t hash;
+        ASSERT_EQ(0, blake3_hash_api->HashBuffer(blake3_hash_api, lengths[b], datas[b], &hash));
+        ASSERT_EQ(hash, hashes[b]);
+    }
+    TestHashBuffers(hash_api);
+
+    Longtail_DisposeAPI(&hash_api->m_API);
+    Longtail_DisposeAPI(&blake3_hash_api->m_API);
+}
+
 TEST(Longtail, Longtail_CreateBlockIndex)
 {
     struct Longtail_HashAPI* hash_api = Longtail_CreateMeowHashAPI();
@@ -851,6 +953,232 @@ TEST(Longtail, Longtail_CreateStoreIndexFromContentIndex)
     SAFE_DISPOSE_API(hash_api);
 }
 
+TEST(Longtail, LookupTable)
+{
+    const uint32_t capacity = 10000;
+    struct Longtail_LookupTable* lut = Longtail_LookupTable_Create(Longtail_Alloc(0, Longtail_LookupTable_GetSize(capacity)), capacity, 0);
+    ASSERT_NE((struct Longtail_LookupTable*)0, lut);
+    ASSERT_EQ(capacity, Longtail_LookupTable_GetSpaceLeft(lut));
+    ASSERT_EQ((uint32_t*)0, Longtail_LookupTable_Get(lut, 0));
+
+    // Small integer keys and hash like keys
+    for (uint32_t i = 0; i < capacity / 2; ++i)
+    {
+        ASSERT_EQ(0, Longtail_LookupTable_Put(lut, i, i + 1));
+        ASSERT_EQ((uint32_t*)0, Longtail_LookupTable_PutUnique(lut, 0x9e3779b97f4a7c15ull * (i + 1) ^ 0xdeadbeefull, i + 2));
+    }
+    ASSERT_EQ(0u, Longtail_LookupTable_GetSpaceLeft(lut));
+    for (uint32_t i = 0; i < capacity / 2; ++i)
+    {
+        uint32_t* v = Longtail_LookupTable_Get(lut, i);
+        ASSERT_NE((uint32_t*)0, v);
+        ASSERT_EQ(i + 1, *v);
+        v = Longtail_LookupTable_PutUnique(lut, 0x9e3779b97f4a7c15ull * (i + 1) ^ 0xdeadbeefull, 0);
+        ASSERT_NE((uint32_t*)0, v);
+        ASSERT_EQ(i + 2, *v);
+    }
+    ASSERT_EQ((uint32_t*)0, Longtail_LookupTable_Get(lut, capacity));
+
+    // Putting an existing key keeps the first value
+    ASSERT_EQ(0, Longtail_LookupTable_Put(lut, 17, 4711));
+    ASSERT_EQ(18u, *Longtail_LookupTable_Get(lut, 17));
+
+    // Values are writable through the returned pointer
+    *Longtail_LookupTable_Get(lut, 17) = 4711;
+    ASSERT_EQ(4711u, *Longtail_LookupTable_Get(lut, 17));
+
+    // Grow by copying into a larger table
+    struct Longtail_LookupTable* grown_lut = Longtail_LookupTable_Create(Longtail_Alloc(0, Longtail_LookupTable_GetSize(capacity * 2)), capacity * 2, lut);
+    ASSERT_NE((struct Longtail_LookupTable*)0, grown_lut);
+    Longtail_Free(lut);
+    ASSERT_EQ(capacity, Longtail_LookupTable_GetSpaceLeft(grown_lut));
+    ASSERT_EQ(4711u, *Longtail_LookupTable_Get(grown_lut, 17));
+    for (uint32_t i = 0; i < capacity / 2; ++i)
+    {
+        if (i != 17)
+        {
+            ASSERT_EQ(i + 1, *Longtail_LookupTable_Get(grown_lut, i));
+        }
+        ASSERT_EQ(i + 2, *Longtail_LookupTable_Get(grown_lut, 0x9e3779b97f4a7c15ull * (i + 1) ^ 0xdeadbeefull));
+    }
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        ASSERT_EQ((uint32_t*)0, Longtail_LookupTable_PutUnique(grown_lut, 0xf00000000ull + i, i));
+    }
+    ASSERT_EQ(0u, Longtail_LookupTable_GetSpaceLeft(grown_lut));
+    ASSERT_EQ(capacity - 1, *Longtail_LookupTable_Get(grown_lut, 0xf00000000ull + capacity - 1));
+    Longtail_Free(grown_lut);
+
+    // Zero capacity table has no entries but can be queried
+    struct Longtail_LookupTable* empty_lut = Longtail_LookupTable_Create(Longtail_Alloc(0, Longtail_LookupTable_GetSize(0)), 0, 0);
+    ASSERT_EQ((uint32_t*)0, Longtail_LookupTable_Get(empty_lut, 0));
+    ASSERT_EQ(0u, Longtail_LookupTable_GetSpaceLeft(empty_lut));
+    Longtail_Free(empty_lut);
+}
+
+// Lookup table benchmark, build with LONGTAIL_BENCHMARKS defined to run it
+#if defined(LONGTAIL_BENCHMARKS)
+// Chained lookup table that Longtail_LookupTable used to be, kept as a reference for LookupTableSpeed
+struct ChainedLookupTable
+{
+    uint32_t m_BucketCount;
+    uint32_t m_Count;
+    uint32_t* m_Buckets;
+    uint64_t* m_Keys;
+    uint32_t* m_Values;
+    uint32_t* m_NextIndex;
+};
+
+static size_t ChainedLookupTable_GetSize(uint32_t capacity, uint32_t* out_bucket_count)
+{
+    uint32_t bucket_count = 1;
+    while (bucket_count < (capacity / 4))
+    {
+        bucket_count <<= 1;
+    }
+    *out_bucket_count = bucket_count;
+    return sizeof(struct ChainedLookupTable) + sizeof(uint32_t) * bucket_count + (sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint32_t)) * capacity;
+}
+
+static struct ChainedLookupTable* ChainedLookupTable_Create(void* mem, uint32_t capacity)
+{
+    struct ChainedLookupTable* lut = (struct ChainedLookupTable*)mem;
+    ChainedLookupTable_GetSize(capacity, &lut->m_BucketCount);
+    lut->m_Count = 0;
+    lut->m_Buckets = (uint32_t*)&lut[1];
+    lut->m_Keys = (uint64_t*)&lut->m_Buckets[lut->m_BucketCount];
+    lut->m_Values = (uint32_t*)&lut->m_Keys[capacity];
+    lut->m_NextIndex = &lut->m_Values[capacity];
+    memset(lut->m_Buckets, 0xff, sizeof(uint32_t) * lut->m_BucketCount);
+    memset(lut->m_NextIndex, 0xff, sizeof(uint32_t) * capacity);
+    return lut;
+}
+
+static uint32_t* ChainedLookupTable_PutUnique(struct ChainedLookupTable* lut, uint64_t key, uint32_t value)
+{
+    uint32_t* slot = &lut->m_Buckets[key & (lut->m_BucketCount - 1)];
+    while (*slot != 0xffffffffu)
+    {
+        if (lut->m_Keys[*slot] == key)
+        {
+            return &lut->m_Values[*slot];
+        }
+        slot = &lut->m_NextIndex[*slot];
+    }
+    uint32_t entry_index = lut->m_Count++;
+    lut->m_Keys[entry_index] = key;
+    lut->m_Values[entry_index] = value;
+    *slot = entry_index;
+    return 0;
+}
+
+static uint32_t* ChainedLookupTable_Get(const struct ChainedLookupTable* lut, uint64_t key)
+{
+    uint32_t index = lut->m_Buckets[key & (lut->m_BucketCount - 1)];
+    while (index != 0xffffffffu)
+    {
+        if (lut->m_Keys[index] == key)
+        {
+            return &lut->m_Values[index];
+        }
+        index = lut->m_NextIndex[index];
+    }
+    return 0;
+}
+
+TEST(Longtail, LookupTableSpeed)
+{
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    const uint32_t counts[] = {16384, 1024 * 1024, 4 * 1024 * 1024};
+    const uint32_t max_count = counts[sizeof(counts) / sizeof(counts[0]) - 1];
+
+    // Chunk hashes as keys, the second half are looked up but never inserted
+    TLongtail_Hash* keys = (TLongtail_Hash*)Longtail_Alloc(0, sizeof(TLongtail_Hash) * max_count * 2);
+    for (uint32_t i = 0; i < max_count * 2; ++i)
+    {
+        hash_api->HashBuffer(hash_api, sizeof(uint32_t), &i, &keys[i]);
+    }
+    uint32_t* lookup_order = (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * max_count);
+    TLongtail_Hash* lookup_keys = (TLongtail_Hash*)Longtail_Alloc(0, sizeof(TLongtail_Hash) * max_count);
+
+    for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        uint32_t count = counts[c];
+        srand(2020);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            lookup_order[i] = (((uint32_t)rand() << 16) ^ (uint32_t)rand()) % count;
+            lookup_keys[i] = keys[lookup_order[i]];
+        }
+
+        uint32_t bucket_count;
+        size_t chained_size = ChainedLookupTable_GetSize(count, &bucket_count);
+        void* chained_mem = Longtail_Alloc(0, chained_size);
+        jc_test_time_t start = jc_test_get_time();
+        struct ChainedLookupTable* chained = ChainedLookupTable_Create(chained_mem, count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ChainedLookupTable_PutUnique(chained, keys[i], i);
+        }
+        jc_test_time_t chained_build_us = jc_test_get_time() - start;
+        uint64_t chained_sum = 0;
+        start = jc_test_get_time();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            chained_sum += *ChainedLookupTable_Get(chained, lookup_keys[i]);
+        }
+        jc_test_time_t chained_hit_us = jc_test_get_time() - start;
+        uint32_t chained_miss_count = 0;
+        start = jc_test_get_time();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            chained_miss_count += ChainedLookupTable_Get(chained, keys[count + i]) == 0;
+        }
+        jc_test_time_t chained_miss_us = jc_test_get_time() - start;
+        Longtail_Free(chained);
+
+        size_t lut_size = Longtail_LookupTable_GetSize(count);
+        void* lut_mem = Longtail_Alloc(0, lut_size);
+        start = jc_test_get_time();
+        struct Longtail_LookupTable* lut = Longtail_LookupTable_Create(lut_mem, count, 0);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Longtail_LookupTable_PutUnique(lut, keys[i], i);
+        }
+        jc_test_time_t lut_build_us = jc_test_get_time() - start;
+        uint64_t lut_sum = 0;
+        start = jc_test_get_time();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            lut_sum += *Longtail_LookupTable_Get(lut, lookup_keys[i]);
+        }
+        jc_test_time_t lut_hit_us = jc_test_get_time() - start;
+        uint32_t lut_miss_count = 0;
+        start = jc_test_get_time();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            lut_miss_count += Longtail_LookupTable_Get(lut, keys[count + i]) == 0;
+        }
+        jc_test_time_t lut_miss_us = jc_test_get_time() - start;
+        Longtail_Free(lut);
+
+        ASSERT_EQ(chained_sum, lut_sum);
+        ASSERT_EQ(count, chained_miss_count);
+        ASSERT_EQ(count, lut_miss_count);
+
+        TEST_LOG("LookupTable %8u entries: chained build %6.1f ms, hit %6.1f ms, miss %6.1f ms, %5.1f bytes/entry\n",
+            count, chained_build_us / 1000.0, chained_hit_us / 1000.0, chained_miss_us / 1000.0, (double)chained_size / count)
+        TEST_LOG("LookupTable %8u entries: grouped build %6.1f ms, hit %6.1f ms, miss %6.1f ms, %5.1f bytes/entry\n",
+            count, lut_build_us / 1000.0, lut_hit_us / 1000.0, lut_miss_us / 1000.0, (double)lut_size / count)
+    }
+
+    Longtail_Free(lookup_keys);
+    Longtail_Free(lookup_order);
+    Longtail_Free(keys);
+    SAFE_DISPOSE_API(hash_api);
+}
+#endif // defined(LONGTAIL_BENCHMARKS)
+
 static struct Longtail_StoredBlock* TestCreateStoredBlock(
     struct Longtail_HashAPI* hash_api,
     uint8_t seed,
@@ -1553,10 +1881,11 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
     Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
     Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
     Longtail_BlockStoreAPI* local_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, local_storage_api, "chunks", 0);
-    Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(local_block_store_api, 3);
+    Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateSizedLRUBlockStoreAPI(local_block_store_api, 12288);
 
     static const uint32_t BLOCK_COUNT = 7;
     TLongtail_Hash block_hashes[BLOCK_COUNT];
+    uint64_t block_sizes[BLOCK_COUNT];
 
     {
         static const uint32_t BLOCK_CHUNK_COUNT = 2;
@@ -1567,6 +1896,7 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
         putCB.Wait();
         ASSERT_EQ(0, putCB.m_Err);
         block_hashes[0] = *block->m_BlockIndex->m_BlockHash;
+        block_sizes[0] = Longtail_GetBlockIndexDataSize(*block->m_BlockIndex->m_ChunkCount) + block->m_BlockChunksDataSize;
         block->Dispose(block);
     }
 
@@ -1579,6 +1909,7 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
         putCB.Wait();
         ASSERT_EQ(0, putCB.m_Err);
         block_hashes[1] = *block->m_BlockIndex->m_BlockHash;
+        block_sizes[1] = Longtail_GetBlockIndexDataSize(*block->m_BlockIndex->m_ChunkCount) + block->m_BlockChunksDataSize;
         block->Dispose(block);
     }
 
@@ -1591,6 +1922,7 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
         putCB.Wait();
         ASSERT_EQ(0, putCB.m_Err);
         block_hashes[2] = *block->m_BlockIndex->m_BlockHash;
+        block_sizes[2] = Longtail_GetBlockIndexDataSize(*block->m_BlockIndex->m_ChunkCount) + block->m_BlockChunksDataSize;
         block->Dispose(block);
     }
 
@@ -1603,6 +1935,7 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
         putCB.Wait();
         ASSERT_EQ(0, putCB.m_Err);
         block_hashes[3] = *block->m_BlockIndex->m_BlockHash;
+        block_sizes[3] = Longtail_GetBlockIndexDataSize(*block->m_BlockIndex->m_ChunkCount) + block->m_BlockChunksDataSize;
         block->Dispose(block);
     }
 
@@ -1615,6 +1948,7 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
         putCB.Wait();
         ASSERT_EQ(0, putCB.m_Err);
         block_hashes[4] = *block->m_BlockIndex->m_BlockHash;
+        block_sizes[4] = Longtail_GetBlockIndexDataSize(*block->m_BlockIndex->m_ChunkCount) + block->m_BlockChunksDataSize;
         block->Dispose(block);
     }
 
@@ -1627,6 +1961,7 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
         putCB.Wait();
         ASSERT_EQ(0, putCB.m_Err);
         block_hashes[5] = *block->m_BlockIndex->m_BlockHash;
+        block_sizes[5] = Longtail_GetBlockIndexDataSize(*block->m_BlockIndex->m_ChunkCount) + block->m_BlockChunksDataSize;
         block->Dispose(block);
     }
 
@@ -1639,6 +1974,7 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
         putCB.Wait();
         ASSERT_EQ(0, putCB.m_Err);
         block_hashes[6] = *block->m_BlockIndex->m_BlockHash;
+        block_sizes[6] = Longtail_GetBlockIndexDataSize(*block->m_BlockIndex->m_ChunkCount) + block->m_BlockChunksDataSize;
         block->Dispose(block);
     }
 
@@ -1734,6 +2070,70 @@ TEST(Longtail, Longtail_TestLRUBlockStore)
     ASSERT_EQ(BLOCK_COUNT + 6, lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
     ASSERT_EQ(BLOCK_COUNT + 3, local_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
 
+    // Block 4 is larger than the LRU and is never cached, blocks 0-3 are evicted to make room for 5 and 6,
+    // 0 and 3 are evicted again before the final requests
+    ASSERT_EQ(3, lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Count]);
+    ASSERT_EQ(block_sizes[6] + block_sizes[5] + block_sizes[3], lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Byte_Count]);
+    ASSERT_EQ(BLOCK_COUNT + 3, lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheMiss_Count]);
+    uint64_t all_block_sizes = 0;
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        all_block_sizes += block_sizes[b];
+    }
+    ASSERT_EQ(all_block_sizes + block_sizes[0] + block_sizes[3] + block_sizes[0], lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheMiss_Byte_Count]);
+    ASSERT_EQ(6, lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_CacheEvict_Count]);
+    ASSERT_EQ(block_sizes[0] + block_sizes[1] + block_sizes[2] + block_sizes[3] + block_sizes[0] + block_sizes[6], lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_CacheEvict_Byte_Count]);
+
+    SAFE_DISPOSE_API(lru_block_store_api);
+    SAFE_DISPOSE_API(local_block_store_api);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(local_storage_api);
+}
+
+TEST(Longtail, Longtail_TestLRUBlockStoreCount)
+{
+    Longtail_StorageAPI* local_storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* local_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, local_storage_api, "chunks", 0);
+    Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(local_block_store_api, 3);
+
+    static const uint32_t BLOCK_COUNT = 4;
+    TLongtail_Hash block_hashes[BLOCK_COUNT];
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        const uint32_t block_chunk_sizes[2] = {1024u * (b + 1), 333};
+        Longtail_StoredBlock* block = GenerateStoredBlock(hash_api, 2, block_chunk_sizes);
+        struct TestAsyncPutBlockComplete putCB;
+        ASSERT_EQ(0, lru_block_store_api->PutStoredBlock(lru_block_store_api, block, &putCB.m_API));
+        putCB.Wait();
+        ASSERT_EQ(0, putCB.m_Err);
+        block_hashes[b] = *block->m_BlockIndex->m_BlockHash;
+        block->Dispose(block);
+    }
+
+    // The LRU holds three blocks regardless of their size, block 0 and then block 1 are evicted
+    const uint32_t get_order[6] = {0, 1, 2, 3, 3, 0};
+    for (uint32_t g = 0; g < 6; ++g)
+    {
+        struct TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(0, lru_block_store_api->GetStoredBlock(lru_block_store_api, block_hashes[get_order[g]], &getCB.m_API));
+        getCB.Wait();
+        ASSERT_EQ(0, getCB.m_Err);
+        struct Longtail_StoredBlock* get_block = getCB.m_StoredBlock;
+        if (get_block->Dispose)
+        {
+            get_block->Dispose(get_block);
+        }
+    }
+
+    Longtail_BlockStore_Stats lru_stats;
+    lru_block_store_api->GetStats(lru_block_store_api, &lru_stats);
+    ASSERT_EQ(1, lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheHit_Count]);
+    ASSERT_EQ(5, lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_CacheMiss_Count]);
+    ASSERT_EQ(2, lru_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_CacheEvict_Count]);
+
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(local_block_store_api);
     SAFE_DISPOSE_API(job_api);
@@ -1991,98 +2391,482 @@ TEST(Longtail, Longtail_CompressBlockStore)
     SAFE_DISPOSE_API(local_storage_api);
 }
 
-TEST(Longtail, Longtail_TestGetFilesRecursively)
+TEST(Longtail, Longtail_SeekableCompressBlockStore)
 {
-    Longtail_StorageAPI* storage = Longtail_CreateInMemStorageAPI();
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* local_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "chunks", 0);
+    Longtail_BlockStoreAPI* seekable_block_store_api = Longtail_CreateSeekableCompressBlockStoreAPI(local_block_store_api, compression_registry, 8192);
+    Longtail_BlockStoreAPI* compress_block_store_api = Longtail_CreateCompressBlockStoreAPI(local_block_store_api, compression_registry);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, seekable_block_store_api);
 
-    const uint32_t ASSET_COUNT = 10u;
+    // 16 chunks of 2048 bytes gives four frames of four chunks each
+    const uint32_t chunk_count = 16;
+    const uint32_t chunk_size = 2048;
+    TLongtail_Hash chunk_hashes[chunk_count];
+    uint32_t chunk_sizes[chunk_count];
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        chunk_hashes[c] = 0x1000 + c;
+        chunk_sizes[c] = chunk_size;
+    }
+    Longtail_StoredBlock* put_block;
+    ASSERT_EQ(0, Longtail_CreateStoredBlock(
+        0xdeadbeef,
+        hash_api->GetIdentifier(hash_api),
+        chunk_count,
+        Longtail_GetZStdDefaultQuality(),
+        chunk_hashes,
+        chunk_sizes,
+        chunk_count * chunk_size,
+        &put_block));
+    uint8_t* block_data = (uint8_t*)put_block->m_BlockData;
+    for (uint32_t i = 0; i < chunk_count * chunk_size; ++i)
+    {
+        block_data[i] = (uint8_t)((i / chunk_size) * 7 + ((i % 64) < 32 ? 1 : 0));
+    }
 
-    const char* TEST_FILENAMES[ASSET_COUNT] = {
-        "ContentChangedSameLength.txt",
-        "WillBeRenamed.txt",
-        "ContentSameButShorter.txt",
-        "folder/ContentSameButLonger.txt",
-        "OldRenamedFolder/MovedToNewFolder.txt",
-        "JustDifferent.txt",
-        "EmptyFileInFolder/.init.py",
-        "a/file/in/folder/LongWithChangedStart.dll",
-        "a/file/in/other/folder/LongChangedAtEnd.exe",
-        "permissions_changed.txt"
-    };
+    struct TestAsyncPutBlockComplete putCB;
+    ASSERT_EQ(0, seekable_block_store_api->PutStoredBlock(seekable_block_store_api, put_block, &putCB.m_API));
+    putCB.Wait();
+    ASSERT_EQ(0, putCB.m_Err);
 
-    const char* TEST_STRINGS[ASSET_COUNT] = {
-        "This is the first test string which is fairly long and should - reconstructed properly, than you very much",
-        "Short string",
-        "Another sample string that does not match any other string but -reconstructed properly, than you very much",
-        "Short string",
-        "This is the documentation we are all craving to understand the complexities of life",
-        "More than chunk less than block",
-        "",
-        "A very long file that should be able to be recreated"
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 2 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 3 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 4 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 5 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 6 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 7 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 8 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 9 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 10 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 11 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 12 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 13 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 14 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 15 in a long sequence of stuff."
-            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 16 in a long sequence of stuff."
-            "And in the end it is not the same, it is different, just because why not",
-        "A very long file that should be able to be recreated"
-            "Another big file but this does not contain the data as the one above, however it does start out the same as the other file,right?"
-            "Yet we also repeat this line, this is the first time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the second time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the third time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the fourth time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the fifth time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the sixth time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the eigth time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the ninth time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the tenth time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the elevth time you see this, but it will also show up again and again with only small changes"
-            "Yet we also repeat this line, this is the twelth time you see this, but it will also show up again and again with only small changes"
-            "I realize I'm not very good at writing out the numbering with the 'th stuff at the end. Not much reason to use that before."
-            "0123456789876543213241247632464358091345+2438568736283249873298ntyvntrndwoiy78n43ctyermdr498xrnhse78tnls43tc49mjrx3hcnthv4t"
-            "liurhe ngvh43oecgclri8fhso7r8ab3gwc409nu3p9t757nvv74oe8nfyiecffömocsrhf ,jsyvblse4tmoxw3umrc9sen8tyn8öoerucdlc4igtcov8evrnocs8lhrf"
-            "That will look like garbage, will that really be a good idea?"
-            "This is the end tough...",
-        "Content stays the same but permissions change"
-    };
+    struct TestAsyncGetBlockComplete getRawCB;
+    ASSERT_EQ(0, local_block_store_api->GetStoredBlock(local_block_store_api, 0xdeadbeef, &getRawCB.m_API));
+    getRawCB.Wait();
+    ASSERT_EQ(0, getRawCB.m_Err);
+    Longtail_StoredBlock* raw_block = getRawCB.m_StoredBlock;
+    uint32_t* header = (uint32_t*)raw_block->m_BlockData;
+    ASSERT_EQ(chunk_count * chunk_size, header[0]);
+    ASSERT_EQ(0xffffffffu, header[1]);
+    ASSERT_EQ(4u, header[2]);
+
+    // Chunks spanning the second and third frame
+    uint8_t* chunks_data = (uint8_t*)Longtail_Alloc(0, chunk_count * chunk_size);
+    ASSERT_EQ(0, Longtail_DecompressBlockChunks(compression_registry, raw_block, 5, 6, chunks_data));
+    ASSERT_EQ(0, memcmp(chunks_data, &block_data[5 * chunk_size], 6 * chunk_size));
+
+    // Frames that are not requested are not decompressed
+    uint8_t* last_frame_data = (uint8_t*)&header[3 + 2 * 4] + header[4] + header[6] + header[8];
+    memset(last_frame_data, 0, 4);
+    ASSERT_EQ(0, Longtail_DecompressBlockChunks(compression_registry, raw_block, 0, 12, chunks_data));
+    ASSERT_EQ(0, memcmp(chunks_data, block_data, 12 * chunk_size));
+    ASSERT_NE(0, Longtail_DecompressBlockChunks(compression_registry, raw_block, 11, 2, chunks_data));
+
+    // A frame table that does not match the block index or the block data is rejected
+    header[2] = 0x7fffffffu;
+    ASSERT_EQ(EBADF, Longtail_DecompressBlockChunks(compression_registry, raw_block, 0, 4, chunks_data));
+    header[2] = 4u;
+    header[3] += 1;
+    ASSERT_EQ(EBADF, Longtail_DecompressBlockChunks(compression_registry, raw_block, 0, 4, chunks_data));
+    header[3] -= 1;
+    header[4] += raw_block->m_BlockChunksDataSize;
+    ASSERT_EQ(EBADF, Longtail_DecompressBlockChunks(compression_registry, raw_block, 0, 4, chunks_data));
+    header[4] -= raw_block->m_BlockChunksDataSize;
+    header[0] += 1;
+    ASSERT_EQ(EBADF, Longtail_DecompressBlockChunks(compression_registry, raw_block, 0, 4, chunks_data));
+    header[0] -= 1;
+    uint32_t raw_block_chunks_data_size = raw_block->m_BlockChunksDataSize;
+    raw_block->m_BlockChunksDataSize = 10;
+    ASSERT_EQ(EBADF, Longtail_DecompressBlockChunks(compression_registry, raw_block, 0, 4, chunks_data));
+    raw_block->m_BlockChunksDataSize = raw_block_chunks_data_size;
+    ASSERT_EQ(0, Longtail_DecompressBlockChunks(compression_registry, raw_block, 0, 4, chunks_data));
+    Longtail_Free(chunks_data);
+    raw_block->Dispose(raw_block);
+
+    // Seekable blocks are read back whole by any compress block store
+    struct TestAsyncGetBlockComplete getCB1;
+    ASSERT_EQ(0, seekable_block_store_api->GetStoredBlock(seekable_block_store_api, 0xdeadbeef, &getCB1.m_API));
+    getCB1.Wait();
+    ASSERT_EQ(0, getCB1.m_Err);
+    ASSERT_EQ(chunk_count * chunk_size, getCB1.m_StoredBlock->m_BlockChunksDataSize);
+    ASSERT_EQ(0, memcmp(getCB1.m_StoredBlock->m_BlockData, block_data, chunk_count * chunk_size));
+    getCB1.m_StoredBlock->Dispose(getCB1.m_StoredBlock);
 
-    const size_t TEST_SIZES[ASSET_COUNT] = {
-        strlen(TEST_STRINGS[0]) + 1,
-        strlen(TEST_STRINGS[1]) + 1,
-        strlen(TEST_STRINGS[2]) + 1,
-        strlen(TEST_STRINGS[3]) + 1,
-        strlen(TEST_STRINGS[4]) + 1,
-        strlen(TEST_STRINGS[5]) + 1,
-        strlen(TEST_STRINGS[6]) + 1,
-        strlen(TEST_STRINGS[7]) + 1,
-        strlen(TEST_STRINGS[8]) + 1,
-        strlen(TEST_STRINGS[9]) + 1
-    };
+    struct TestAsyncGetBlockComplete getCB2;
+    ASSERT_EQ(0, compress_block_store_api->GetStoredBlock(compress_block_store_api, 0xdeadbeef, &getCB2.m_API));
+    getCB2.Wait();
+    ASSERT_EQ(0, getCB2.m_Err);
+    ASSERT_EQ(0, memcmp(getCB2.m_StoredBlock->m_BlockData, block_data, chunk_count * chunk_size));
+    getCB2.m_StoredBlock->Dispose(getCB2.m_StoredBlock);
 
-    const uint16_t TEST_PERMISSIONS[ASSET_COUNT] = {
-        0644,
-        0644,
-        0644,
-        0644,
-        0644,
-        0644,
-        0644,
-        0644,
-        0755,
-        0646
-    };
+    // A partial get only decodes the range of chunks that covers the requested chunks
+    TLongtail_Hash requested_chunk_hashes[3] = { 0x1009, 0x1005, 0xbad };
+    struct TestAsyncGetBlockComplete getCB3;
+    ASSERT_EQ(0, Longtail_BlockStore_GetStoredBlockChunks(seekable_block_store_api, 0xdeadbeef, 3, requested_chunk_hashes, &getCB3.m_API));
+    getCB3.Wait();
+    ASSERT_EQ(0, getCB3.m_Err);
+    Longtail_StoredBlock* partial_block = getCB3.m_StoredBlock;
+    ASSERT_EQ(0xdeadbeef, *partial_block->m_BlockIndex->m_BlockHash);
+    ASSERT_EQ(Longtail_GetZStdDefaultQuality(), *partial_block->m_BlockIndex->m_Tag);
+    ASSERT_EQ(5u, *partial_block->m_BlockIndex->m_ChunkCount);
+    ASSERT_EQ(0x1005u, partial_block->m_BlockIndex->m_ChunkHashes[0]);
+    ASSERT_EQ(0x1009u, partial_block->m_BlockIndex->m_ChunkHashes[4]);
+    ASSERT_EQ(5 * chunk_size, partial_block->m_BlockChunksDataSize);
+    ASSERT_EQ(0, memcmp(partial_block->m_BlockData, &block_data[5 * chunk_size], 5 * chunk_size));
+    partial_block->Dispose(partial_block);
+
+    put_block->Dispose(put_block);
 
-    for (uint32_t i = 0; i < ASSET_COUNT; ++i)
+    SAFE_DISPOSE_API(compress_block_store_api);
+    SAFE_DISPOSE_API(seekable_block_store_api);
+    SAFE_DISPOSE_API(local_block_store_api);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+TEST(Longtail, Longtail_SeekableCompressBlockStoreWrapped)
+{
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* remote_fs_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "remote", 0);
+    Longtail_BlockStoreAPI* remote_block_store_api = Longtail_CreateSeekableCompressBlockStoreAPI(remote_fs_block_store_api, compression_registry, 8192);
+    Longtail_BlockStoreAPI* local_fs_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "local", 0);
+    Longtail_BlockStoreAPI* local_block_store_api = Longtail_CreateSeekableCompressBlockStoreAPI(local_fs_block_store_api, compression_registry, 8192);
+    Longtail_BlockStoreAPI* cache_block_store_api = Longtail_CreateCacheBlockStoreAPI(job_api, local_block_store_api, remote_block_store_api);
+    Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(cache_block_store_api, 4);
+    Longtail_BlockStoreAPI* share_block_store_api = Longtail_CreateShareBlockStoreAPI(lru_block_store_api);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, share_block_store_api);
+
+    const uint32_t chunk_count = 16;
+    const uint32_t chunk_size = 2048;
+    TLongtail_Hash chunk_hashes[chunk_count];
+    uint32_t chunk_sizes[chunk_count];
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        chunk_hashes[c] = 0x1000 + c;
+        chunk_sizes[c] = chunk_size;
+    }
+    Longtail_StoredBlock* put_block;
+    ASSERT_EQ(0, Longtail_CreateStoredBlock(
+        0xdeadbeef,
+        hash_api->GetIdentifier(hash_api),
+        chunk_count,
+        Longtail_GetZStdDefaultQuality(),
+        chunk_hashes,
+        chunk_sizes,
+        chunk_count * chunk_size,
+        &put_block));
+    uint8_t* block_data = (uint8_t*)put_block->m_BlockData;
+    for (uint32_t i = 0; i < chunk_count * chunk_size; ++i)
+    {
+        block_data[i] = (uint8_t)((i / chunk_size) * 7 + ((i % 64) < 32 ? 1 : 0));
+    }
+
+    struct TestAsyncPutBlockComplete putCB;
+    ASSERT_EQ(0, remote_block_store_api->PutStoredBlock(remote_block_store_api, put_block, &putCB.m_API));
+    putCB.Wait();
+    ASSERT_EQ(0, putCB.m_Err);
+
+    // A block missing from the local cache is fetched and cached whole
+    TLongtail_Hash requested_chunk_hashes[3] = { 0x1009, 0x1005, 0xbad };
+    struct TestAsyncGetBlockComplete getCB1;
+    ASSERT_EQ(0, Longtail_BlockStore_GetStoredBlockChunks(share_block_store_api, 0xdeadbeef, 3, requested_chunk_hashes, &getCB1.m_API));
+    getCB1.Wait();
+    ASSERT_EQ(0, getCB1.m_Err);
+    ASSERT_EQ(chunk_count, *getCB1.m_StoredBlock->m_BlockIndex->m_ChunkCount);
+    ASSERT_EQ(0, memcmp(getCB1.m_StoredBlock->m_BlockData, block_data, chunk_count * chunk_size));
+    getCB1.m_StoredBlock->Dispose(getCB1.m_StoredBlock);
+
+    TestAsyncFlushComplete flushCB;
+    ASSERT_EQ(0, share_block_store_api->Flush(share_block_store_api, &flushCB.m_API));
+    flushCB.Wait();
+    ASSERT_EQ(0, flushCB.m_Err);
+
+    // The partial get reaches the seekable local store through the share, LRU and cache block stores
+    struct TestAsyncGetBlockComplete getCB2;
+    ASSERT_EQ(0, Longtail_BlockStore_GetStoredBlockChunks(share_block_store_api, 0xdeadbeef, 3, requested_chunk_hashes, &getCB2.m_API));
+    getCB2.Wait();
+    ASSERT_EQ(0, getCB2.m_Err);
+    Longtail_StoredBlock* partial_block = getCB2.m_StoredBlock;
+    ASSERT_EQ(0xdeadbeef, *partial_block->m_BlockIndex->m_BlockHash);
+    ASSERT_EQ(5u, *partial_block->m_BlockIndex->m_ChunkCount);
+    ASSERT_EQ(0x1005u, partial_block->m_BlockIndex->m_ChunkHashes[0]);
+    ASSERT_EQ(0x1009u, partial_block->m_BlockIndex->m_ChunkHashes[4]);
+    ASSERT_EQ(0, memcmp(partial_block->m_BlockData, &block_data[5 * chunk_size], 5 * chunk_size));
+    partial_block->Dispose(partial_block);
+
+    // The partial block is not kept by the LRU block store, a full get still returns every chunk
+    struct TestAsyncGetBlockComplete getCB3;
+    ASSERT_EQ(0, share_block_store_api->GetStoredBlock(share_block_store_api, 0xdeadbeef, &getCB3.m_API));
+    getCB3.Wait();
+    ASSERT_EQ(0, getCB3.m_Err);
+    ASSERT_EQ(chunk_count, *getCB3.m_StoredBlock->m_BlockIndex->m_ChunkCount);
+    ASSERT_EQ(0, memcmp(getCB3.m_StoredBlock->m_BlockData, block_data, chunk_count * chunk_size));
+    getCB3.m_StoredBlock->Dispose(getCB3.m_StoredBlock);
+
+    put_block->Dispose(put_block);
+
+    SAFE_DISPOSE_API(share_block_store_api);
+    SAFE_DISPOSE_API(lru_block_store_api);
+    SAFE_DISPOSE_API(cache_block_store_api);
+    SAFE_DISPOSE_API(local_block_store_api);
+    SAFE_DISPOSE_API(local_fs_block_store_api);
+    SAFE_DISPOSE_API(remote_block_store_api);
+    SAFE_DISPOSE_API(remote_fs_block_store_api);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+TEST(Longtail, Longtail_ZStdDictionaryCompression)
+{
+    // Small records with a lot of shared structure, typical for config and metadata files
+    const uint32_t sample_count = 32;
+    char samples[sample_count][256];
+    const void* sample_ptrs[sample_count];
+    uint32_t sample_sizes[sample_count];
+    for (uint32_t s = 0; s < sample_count; ++s)
+    {
+        sample_sizes[s] = (uint32_t)snprintf(samples[s], sizeof(samples[s]),
+            "{\"name\": \"asset_%u\", \"type\": \"texture\", \"format\": \"bc7_unorm\", \"width\": %u, \"height\": %u, \"mips\": %u, \"streaming\": true, \"group\": \"environment/props\"}\n",
+            s, 256u << (s % 4), 128u << (s % 3), 1 + (s % 9));
+        sample_ptrs[s] = samples[s];
+    }
+
+    void* dictionary;
+    uint32_t dictionary_size;
+    ASSERT_EQ(0, Longtail_ZStdBuildDictionary(sample_count - 1, sample_ptrs, sample_sizes, 2048, &dictionary, &dictionary_size));
+    ASSERT_GE(2048u, dictionary_size);
+
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    ASSERT_EQ(0, Longtail_ZStdWriteDictionary(storage_api, "dictionaries", 7, dictionary, dictionary_size));
+    Longtail_Free(dictionary);
+
+    Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateZStdDictionaryCompressionRegistry(storage_api, "dictionaries");
+    ASSERT_NE((Longtail_CompressionRegistryAPI*)0, compression_registry);
+
+    const uint32_t dictionary_type = Longtail_GetZStdDictionaryQuality(7);
+    Longtail_CompressionAPI* compression_api;
+    uint32_t settings_id;
+    ASSERT_EQ(0, compression_registry->GetCompressionAPI(compression_registry, dictionary_type, &compression_api, &settings_id));
+
+    // The last sample is not part of the dictionary
+    const char* record = samples[sample_count - 1];
+    uint32_t record_size = sample_sizes[sample_count - 1];
+    size_t max_compressed_size = compression_api->GetMaxCompressedSize(compression_api, settings_id, record_size);
+    char* compressed = (char*)Longtail_Alloc(0, max_compressed_size);
+    size_t dictionary_compressed_size;
+    ASSERT_EQ(0, compression_api->Compress(compression_api, settings_id, record, compressed, record_size, max_compressed_size, &dictionary_compressed_size));
+    char decompressed[256];
+    size_t decompressed_size;
+    ASSERT_EQ(0, compression_api->Decompress(compression_api, compressed, decompressed, dictionary_compressed_size, sizeof(decompressed), &decompressed_size));
+    ASSERT_EQ(record_size, decompressed_size);
+    ASSERT_EQ(0, memcmp(decompressed, record, record_size));
+
+    size_t plain_compressed_size;
+    ASSERT_EQ(0, compression_api->Compress(compression_api, Longtail_GetZStdDefaultQuality(), record, compressed, record_size, max_compressed_size, &plain_compressed_size));
+    ASSERT_LT(dictionary_compressed_size * 2, plain_compressed_size);
+    Longtail_Free(compressed);
+
+    // Blocks tagged with the dictionary type round trip through the compress block store
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* local_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "chunks", 0);
+    Longtail_BlockStoreAPI* compress_block_store_api = Longtail_CreateCompressBlockStoreAPI(local_block_store_api, compression_registry);
+
+    TLongtail_Hash chunk_hashes[sample_count];
+    uint32_t chunks_size = 0;
+    for (uint32_t s = 0; s < sample_count; ++s)
+    {
+        chunk_hashes[s] = 0x2000 + s;
+        chunks_size += sample_sizes[s];
+    }
+    Longtail_StoredBlock* put_block;
+    ASSERT_EQ(0, Longtail_CreateStoredBlock(
+        0xfeedface,
+        hash_api->GetIdentifier(hash_api),
+        sample_count,
+        dictionary_type,
+        chunk_hashes,
+        sample_sizes,
+        chunks_size,
+        &put_block));
+    char* block_data = (char*)put_block->m_BlockData;
+    for (uint32_t s = 0; s < sample_count; ++s)
+    {
+        memcpy(block_data, samples[s], sample_sizes[s]);
+        block_data += sample_sizes[s];
+    }
+
+    struct TestAsyncPutBlockComplete putCB;
+    ASSERT_EQ(0, compress_block_store_api->PutStoredBlock(compress_block_store_api, put_block, &putCB.m_API));
+    putCB.Wait();
+    ASSERT_EQ(0, putCB.m_Err);
+
+    struct TestAsyncGetBlockComplete getCB;
+    ASSERT_EQ(0, compress_block_store_api->GetStoredBlock(compress_block_store_api, 0xfeedface, &getCB.m_API));
+    getCB.Wait();
+    ASSERT_EQ(0, getCB.m_Err);
+    ASSERT_EQ(dictionary_type, *getCB.m_StoredBlock->m_BlockIndex->m_Tag);
+    ASSERT_EQ(chunks_size, getCB.m_StoredBlock->m_BlockChunksDataSize);
+    ASSERT_EQ(0, memcmp(getCB.m_StoredBlock->m_BlockData, put_block->m_BlockData, chunks_size));
+    getCB.m_StoredBlock->Dispose(getCB.m_StoredBlock);
+    put_block->Dispose(put_block);
+
+    SAFE_DISPOSE_API(compress_block_store_api);
+    SAFE_DISPOSE_API(local_block_store_api);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+TEST(Longtail, Longtail_FullDictionaryCompressionRegistry)
+{
+    const uint32_t sample_count = 16;
+    char samples[sample_count][128];
+    const void* sample_ptrs[sample_count];
+    uint32_t sample_sizes[sample_count];
+    for (uint32_t s = 0; s < sample_count; ++s)
+    {
+        sample_sizes[s] = (uint32_t)snprintf(samples[s], sizeof(samples[s]),
+            "[material_%u]\nshader = \"lit_opaque\"\nalbedo = \"textures/albedo_%u.dds\"\nroughness = %u\n",
+            s, s * 3, s % 5);
+        sample_ptrs[s] = samples[s];
+    }
+
+    void* dictionary;
+    uint32_t dictionary_size;
+    ASSERT_EQ(0, Longtail_ZStdBuildDictionary(sample_count - 1, sample_ptrs, sample_sizes, 1024, &dictionary, &dictionary_size));
+
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+
+    // A store without a dictionary folder still gets all the regular compression types
+    Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullDictionaryCompressionRegistry(storage_api, "store/dictionaries");
+    ASSERT_NE((Longtail_CompressionRegistryAPI*)0, compression_registry);
+    Longtail_CompressionAPI* compression_api;
+    uint32_t settings_id;
+    ASSERT_EQ(0, compression_registry->GetCompressionAPI(compression_registry, Longtail_GetBrotliGenericDefaultQuality(), &compression_api, &settings_id));
+    ASSERT_EQ(0, compression_registry->GetCompressionAPI(compression_registry, Longtail_GetLZ4DefaultQuality(), &compression_api, &settings_id));
+    ASSERT_EQ(ENOENT, compression_registry->GetCompressionAPI(compression_registry, Longtail_GetZStdDictionaryQuality(0x1a), &compression_api, &settings_id));
+    SAFE_DISPOSE_API(compression_registry);
+
+    ASSERT_EQ(0, Longtail_ZStdWriteDictionary(storage_api, "store/dictionaries", 0x1a, dictionary, dictionary_size));
+    Longtail_Free(dictionary);
+
+    compression_registry = Longtail_CreateFullDictionaryCompressionRegistry(storage_api, "store/dictionaries");
+    ASSERT_NE((Longtail_CompressionRegistryAPI*)0, compression_registry);
+    ASSERT_EQ(0, compression_registry->GetCompressionAPI(compression_registry, Longtail_GetZStdMaxQuality(), &compression_api, &settings_id));
+    ASSERT_EQ(0, compression_registry->GetCompressionAPI(compression_registry, Longtail_GetZStdDictionaryQuality(0x1a), &compression_api, &settings_id));
+    ASSERT_EQ(Longtail_GetZStdDictionaryQuality(0x1a), settings_id);
+
+    const char* record = samples[sample_count - 1];
+    uint32_t record_size = sample_sizes[sample_count - 1];
+    size_t max_compressed_size = compression_api->GetMaxCompressedSize(compression_api, settings_id, record_size);
+    char* compressed = (char*)Longtail_Alloc(0, max_compressed_size);
+    size_t compressed_size;
+    ASSERT_EQ(0, compression_api->Compress(compression_api, settings_id, record, compressed, record_size, max_compressed_size, &compressed_size));
+    char decompressed[128];
+    size_t decompressed_size;
+    ASSERT_EQ(0, compression_api->Decompress(compression_api, compressed, decompressed, compressed_size, sizeof(decompressed), &decompressed_size));
+    ASSERT_EQ(record_size, decompressed_size);
+    ASSERT_EQ(0, memcmp(decompressed, record, record_size));
+    Longtail_Free(compressed);
+
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+TEST(Longtail, Longtail_TestGetFilesRecursively)
+{
+    Longtail_StorageAPI* storage = Longtail_CreateInMemStorageAPI();
+
+    const uint32_t ASSET_COUNT = 10u;
+
+    const char* TEST_FILENAMES[ASSET_COUNT] = {
+        "ContentChangedSameLength.txt",
+        "WillBeRenamed.txt",
+        "ContentSameButShorter.txt",
+        "folder/ContentSameButLonger.txt",
+        "OldRenamedFolder/MovedToNewFolder.txt",
+        "JustDifferent.txt",
+        "EmptyFileInFolder/.init.py",
+        "a/file/in/folder/LongWithChangedStart.dll",
+        "a/file/in/other/folder/LongChangedAtEnd.exe",
+        "permissions_changed.txt"
+    };
+
+    const char* TEST_STRINGS[ASSET_COUNT] = {
+        "This is the first test string which is fairly long and should - reconstructed properly, than you very much",
+        "Short string",
+        "Another sample string that does not match any other string but -reconstructed properly, than you very much",
+        "Short string",
+        "This is the documentation we are all craving to understand the complexities of life",
+        "More than chunk less than block",
+        "",
+        "A very long file that should be able to be recreated"
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 2 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 3 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 4 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 5 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 6 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 7 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 8 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 9 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 10 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 11 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 12 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 13 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 14 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 15 in a long sequence of stuff."
+            "Lots of repeating stuff, some good, some bad but still it is repeating. This is the number 16 in a long sequence of stuff."
+            "And in the end it is not the same, it is different, just because why not",
+        "A very long file that should be able to be recreated"
+            "Another big file but this does not contain the data as the one above, however it does start out the same as the other file,right?"
+            "Yet we also repeat this line, this is the first time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the second time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the third time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the fourth time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the fifth time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the sixth time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the eigth time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the ninth time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the tenth time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the elevth time you see this, but it will also show up again and again with only small changes"
+            "Yet we also repeat this line, this is the twelth time you see this, but it will also show up again and again with only small changes"
+            "I realize I'm not very good at writing out the numbering with the 'th stuff at the end. Not much reason to use that before."
+            "0123456789876543213241247632464358091345+2438568736283249873298ntyvntrndwoiy78n43ctyermdr498xrnhse78tnls43tc49mjrx3hcnthv4t"
+            "liurhe ngvh43oecgclri8fhso7r8ab3gwc409nu3p9t757nvv74oe8nfyiecffömocsrhf ,jsyvblse4tmoxw3umrc9sen8tyn8öoerucdlc4igtcov8evrnocs8lhrf"
+            "That will look like garbage, will that really be a good idea?"
+            "This is the end tough...",
+        "Content stays the same but permissions change"
+    };
+
+    const size_t TEST_SIZES[ASSET_COUNT] = {
+        strlen(TEST_STRINGS[0]) + 1,
+        strlen(TEST_STRINGS[1]) + 1,
+        strlen(TEST_STRINGS[2]) + 1,
+        strlen(TEST_STRINGS[3]) + 1,
+        strlen(TEST_STRINGS[4]) + 1,
+        strlen(TEST_STRINGS[5]) + 1,
+        strlen(TEST_STRINGS[6]) + 1,
+        strlen(TEST_STRINGS[7]) + 1,
+        strlen(TEST_STRINGS[8]) + 1,
+        strlen(TEST_STRINGS[9]) + 1
+    };
+
+    const uint16_t TEST_PERMISSIONS[ASSET_COUNT] = {
+        0644,
+        0644,
+        0644,
+        0644,
+        0644,
+        0644,
+        0644,
+        0644,
+        0755,
+        0646
+    };
+
+    for (uint32_t i = 0; i < ASSET_COUNT; ++i)
     {
         const char* file_name = TEST_FILENAMES[i];
         ASSERT_NE(0, CreateParentPath(storage, file_name));
@@ -2134,6 +2918,74 @@ TEST(Longtail, Longtail_TestGetFilesRecursively)
     SAFE_DISPOSE_API(storage);
 }
 
+TEST(Longtail, Longtail_TestGetFilesRecursivelyParallel)
+{
+    Longtail_StorageAPI* storage = Longtail_CreateInMemStorageAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(4, 0);
+
+    // Enough folders at each depth to spread the listing over several jobs
+    char file_name[64];
+    for (uint32_t a = 0; a < 6; ++a)
+    {
+        for (uint32_t b = 0; b < 5; ++b)
+        {
+            for (uint32_t f = 0; f < 3; ++f)
+            {
+                sprintf(file_name, "root/dir%u/sub%u/file%u.txt", a, b, f);
+                ASSERT_NE(0, CreateParentPath(storage, file_name));
+                Longtail_StorageAPI_HOpenFile w;
+                ASSERT_EQ(0, storage->OpenWriteFile(storage, file_name, 0, &w));
+                ASSERT_EQ(0, storage->Write(storage, w, 0, strlen(file_name), file_name));
+                storage->CloseFile(storage, w);
+            }
+        }
+        sprintf(file_name, "root/file%u.txt", a);
+        Longtail_StorageAPI_HOpenFile w;
+        ASSERT_EQ(0, storage->OpenWriteFile(storage, file_name, 0, &w));
+        storage->CloseFile(storage, w);
+    }
+
+    struct TestFolderFilter
+    {
+        struct Longtail_PathFilterAPI m_API;
+
+        static int IncludeFunc(struct Longtail_PathFilterAPI* path_filter_api, const char* root_path, const char* asset_path, const char* asset_name, int is_dir, uint64_t size, uint16_t permissions)
+        {
+            return !(is_dir && strcmp(asset_name, "sub2") == 0);
+        }
+    } test_filter;
+    test_filter.m_API.m_API.Dispose = 0;
+    test_filter.m_API.Include = TestFolderFilter::IncludeFunc;
+
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        struct Longtail_PathFilterAPI* path_filter_api = pass == 0 ? 0 : &test_filter.m_API;
+        Longtail_FileInfos* file_infos;
+        ASSERT_EQ(0, Longtail_GetFilesRecursively(storage, path_filter_api, 0, 0, "root", &file_infos));
+        Longtail_FileInfos* parallel_file_infos;
+        ASSERT_EQ(0, Longtail_GetFilesRecursivelyParallel(storage, job_api, path_filter_api, 0, 0, "root", &parallel_file_infos));
+
+        ASSERT_EQ(pass == 0 ? 6u + 6u + 6u * 5u + 6u * 5u * 3u : 6u + 6u + 6u * 4u + 6u * 4u * 3u, file_infos->m_Count);
+        ASSERT_EQ(file_infos->m_Count, parallel_file_infos->m_Count);
+        for (uint32_t i = 0; i < file_infos->m_Count; ++i)
+        {
+            ASSERT_STREQ(Longtail_FileInfos_GetPath(file_infos, i), Longtail_FileInfos_GetPath(parallel_file_infos, i));
+            ASSERT_EQ(file_infos->m_Sizes[i], parallel_file_infos->m_Sizes[i]);
+            ASSERT_EQ(file_infos->m_Permissions[i], parallel_file_infos->m_Permissions[i]);
+        }
+        Longtail_Free(parallel_file_infos);
+        Longtail_Free(file_infos);
+    }
+
+    Longtail_FileInfos* missing_file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursivelyParallel(storage, job_api, 0, 0, 0, "missing", &missing_file_infos));
+    ASSERT_EQ(0u, missing_file_infos->m_Count);
+    Longtail_Free(missing_file_infos);
+
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(storage);
+}
+
 TEST(Longtail, Longtail_WriteContent)
 {
     static const uint32_t MAX_BLOCK_SIZE = 32u;
@@ -2469,6 +3321,9 @@ TEST(Longtail, EmptyFolderGetRequiredChunkHashes)
             &zero,
             &zero,
             &zero,
+            &zero,
+            &zero,
+            &zero,
             &zero
         };
 
@@ -2796,8 +3651,10 @@ TEST(Longtail, Longtail_VersionDiff)
         &version_diff));
     ASSERT_NE((Longtail_VersionDiff*)0, version_diff);
 
-    ASSERT_EQ(3u, *version_diff->m_SourceRemovedCount);
-    ASSERT_EQ(3u, *version_diff->m_TargetAddedCount);
+    // The renamed and the moved files are moves, only the folders are removed and added
+    ASSERT_EQ(1u, *version_diff->m_SourceRemovedCount);
+    ASSERT_EQ(1u, *version_diff->m_TargetAddedCount);
+    ASSERT_EQ(2u, *version_diff->m_MovedCount);
     ASSERT_EQ(6u, *version_diff->m_ModifiedContentCount);
     ASSERT_EQ(1u, *version_diff->m_ModifiedPermissionsCount);
 
@@ -3237,17 +4094,889 @@ TEST(Longtail, ChunkerLargeFile)
     SAFE_DISPOSE_API(chunker_api);
 }
 
-TEST(Longtail, FileSystemStorage)
+struct MemoryChunkerFeeder
 {
-    Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+    const uint8_t* data;
+    uint64_t size;
+    uint64_t offset;
+
+    static int FeederFunc(void* context, Longtail_ChunkerAPI_HChunker chunker, uint32_t requested_size, char* buffer, uint32_t* out_size)
+    {
+        MemoryChunkerFeeder* c = (MemoryChunkerFeeder*)context;
+        uint64_t left = c->size - c->offset;
+        uint32_t read_count = left < requested_size ? (uint32_t)left : requested_size;
+        memcpy(buffer, &c->data[c->offset], read_count);
+        c->offset += read_count;
+        *out_size = read_count;
+        return 0;
+    }
+};
 
-    const uint32_t ASSET_COUNT = 9u;
+static uint32_t ChunkMemory(
+    Longtail_ChunkerAPI* chunker_api,
+    const uint8_t* data,
+    uint64_t size,
+    uint32_t min_chunk_size,
+    uint32_t avg_chunk_size,
+    uint32_t max_chunk_size,
+    uint64_t* out_chunk_offsets,
+    uint32_t max_chunk_count)
+{
+    Longtail_ChunkerAPI_HChunker chunker;
+    if (chunker_api->CreateChunker(chunker_api, min_chunk_size, avg_chunk_size, max_chunk_size, &chunker))
+    {
+        return 0;
+    }
+    MemoryChunkerFeeder feeder_context = {data, size, 0};
+    uint32_t chunk_count = 0;
+    Longtail_Chunker_ChunkRange r;
+    while (chunk_count < max_chunk_count && 0 == chunker_api->NextChunk(chunker_api, chunker, MemoryChunkerFeeder::FeederFunc, &feeder_context, &r))
+    {
+        out_chunk_offsets[chunk_count++] = r.offset + r.len;
+    }
+    chunker_api->DisposeChunker(chunker_api, chunker);
+    return chunk_count;
+}
 
-    const char* TEST_FILENAMES[] = {
-        "ContentChangedSameLength.txt",
-        "WillBeRenamed.txt",
-        "ContentSameButShorter.txt",
-        "folder/ContentSameButLonger.txt",
+TEST(Longtail, ChunkerSIMDMatchesScalar)
+{
+    Longtail_ChunkerAPI* scalar_chunker_api = Longtail_CreateHPCDCScalarChunkerAPI();
+    // The SSE4.1 scanner is forced so it is tested even when the CPU picks AVX2
+    Longtail_ChunkerAPI* sse41_chunker_api = Longtail_CreateHPCDCSSE41ChunkerAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+
+    const uint64_t data_size = 4 * 1024 * 1024 + 77;
+    uint8_t* data = (uint8_t*)Longtail_Alloc(0, data_size);
+    srand(4711);
+    for (uint64_t i = 0; i < data_size; ++i)
+    {
+        // Mix in some low entropy runs so we get chunks that hit the max size
+        data[i] = ((i / 65536) % 5 == 3) ? (uint8_t)(i & 7) : (uint8_t)rand();
+    }
+
+    const uint32_t max_chunk_count = (uint32_t)(data_size / 48) + 1;
+    uint64_t* expected_offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+    uint64_t* offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+
+    const uint32_t target_chunk_sizes[] = {64, 1024, 4096, 8192, 32768, 65536, 131072};
+    for (uint32_t t = 0; t < sizeof(target_chunk_sizes) / sizeof(target_chunk_sizes[0]); ++t)
+    {
+        uint32_t target_chunk_size = target_chunk_sizes[t];
+        uint32_t min_chunk_size = target_chunk_size / 8 < 48 ? 48 : target_chunk_size / 8;
+        uint32_t avg_chunk_size = target_chunk_size / 2 < 48 ? 48 : target_chunk_size / 2;
+        uint32_t max_chunk_size = target_chunk_size * 2;
+        uint32_t expected_count = ChunkMemory(scalar_chunker_api, data, data_size, min_chunk_size, avg_chunk_size, max_chunk_size, expected_offsets, max_chunk_count);
+        ASSERT_NE(0u, expected_count);
+        ASSERT_EQ(data_size, expected_offsets[expected_count - 1]);
+        uint32_t count = ChunkMemory(chunker_api, data, data_size, min_chunk_size, avg_chunk_size, max_chunk_size, offsets, max_chunk_count);
+        ASSERT_EQ(expected_count, count);
+        ASSERT_EQ(0, memcmp(expected_offsets, offsets, sizeof(uint64_t) * count));
+        if (sse41_chunker_api)
+        {
+            count = ChunkMemory(sse41_chunker_api, data, data_size, min_chunk_size, avg_chunk_size, max_chunk_size, offsets, max_chunk_count);
+            ASSERT_EQ(expected_count, count);
+            ASSERT_EQ(0, memcmp(expected_offsets, offsets, sizeof(uint64_t) * count));
+        }
+    }
+
+    Longtail_Free(offsets);
+    Longtail_Free(expected_offsets);
+    Longtail_Free(data);
+
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(sse41_chunker_api);
+    SAFE_DISPOSE_API(scalar_chunker_api);
+}
+
+// Throughput benchmark, build with LONGTAIL_BENCHMARKS defined to run it
+#if defined(LONGTAIL_BENCHMARKS)
+TEST(Longtail, ChunkerThroughput)
+{
+    FILE* large_file = fopen("testdata/chunker.input", "rb");
+    ASSERT_NE((FILE*)0, large_file);
+    fseek(large_file, 0, SEEK_END);
+    long file_size = ftell(large_file);
+    fseek(large_file, 0, SEEK_SET);
+
+    const uint32_t repeat_count = 16;
+    uint64_t data_size = (uint64_t)file_size * repeat_count;
+    uint8_t* data = (uint8_t*)Longtail_Alloc(0, data_size);
+    ASSERT_EQ(1u, fread(data, (size_t)file_size, 1, large_file));
+    fclose(large_file);
+    for (uint32_t r = 1; r < repeat_count; ++r)
+    {
+        memcpy(&data[file_size * r], data, (size_t)file_size);
+    }
+
+    Longtail_ChunkerAPI* scalar_chunker_api = Longtail_CreateHPCDCScalarChunkerAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+
+    const uint32_t target_chunk_size = 32768;
+    const uint32_t max_chunk_count = (uint32_t)(data_size / (target_chunk_size / 8)) + 1;
+    uint64_t* expected_offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+    uint64_t* offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+
+    jc_test_time_t scalar_start = jc_test_get_time();
+    uint32_t expected_count = ChunkMemory(scalar_chunker_api, data, data_size, target_chunk_size / 8, target_chunk_size / 2, target_chunk_size * 2, expected_offsets, max_chunk_count);
+    jc_test_time_t scalar_us = jc_test_get_time() - scalar_start;
+
+    jc_test_time_t start = jc_test_get_time();
+    uint32_t count = ChunkMemory(chunker_api, data, data_size, target_chunk_size / 8, target_chunk_size / 2, target_chunk_size * 2, offsets, max_chunk_count);
+    jc_test_time_t us = jc_test_get_time() - start;
+
+    ASSERT_EQ(expected_count, count);
+    ASSERT_EQ(0, memcmp(expected_offsets, offsets, sizeof(uint64_t) * count));
+
+    double mb = (double)data_size / (1024.0 * 1024.0);
+    TEST_LOG("HPCDC scalar: %.1f MB/s, default: %.1f MB/s (%u chunks)\n",
+        mb / ((double)(scalar_us ? scalar_us : 1) / 1000000.0),
+        mb / ((double)(us ? us : 1) / 1000000.0),
+        count)
+
+    Longtail_Free(offsets);
+    Longtail_Free(expected_offsets);
+    Longtail_Free(data);
+
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(scalar_chunker_api);
+}
+#endif // defined(LONGTAIL_BENCHMARKS)
+
+TEST(Longtail, FastCDCChunker)
+{
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateFastCDCChunkerAPI();
+    ASSERT_NE((Longtail_ChunkerAPI*)0, chunker_api);
+
+    uint32_t chunker_min_size;
+    ASSERT_EQ(0, chunker_api->GetMinChunkSize(chunker_api, &chunker_min_size));
+
+    const uint64_t data_size = 4 * 1024 * 1024 + 77;
+    const uint64_t shift = 4711;
+    uint8_t* data = (uint8_t*)Longtail_Alloc(0, data_size + shift);
+    srand(1337);
+    for (uint64_t i = 0; i < data_size + shift; ++i)
+    {
+        data[i] = ((i / 65536) % 5 == 3) ? (uint8_t)(i & 7) : (uint8_t)rand();
+    }
+
+    const uint32_t max_chunk_count = (uint32_t)((data_size + shift) / chunker_min_size) + 1;
+    uint64_t* offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+    uint64_t* shifted_offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+
+    const uint32_t target_chunk_sizes[] = {1024, 8192, 32768, 131072};
+    for (uint32_t t = 0; t < sizeof(target_chunk_sizes) / sizeof(target_chunk_sizes[0]); ++t)
+    {
+        uint32_t target_chunk_size = target_chunk_sizes[t];
+        uint32_t min_chunk_size = target_chunk_size / 8 < chunker_min_size ? chunker_min_size : target_chunk_size / 8;
+        uint32_t avg_chunk_size = target_chunk_size / 2;
+        uint32_t max_chunk_size = target_chunk_size * 2;
+
+        uint32_t count = ChunkMemory(chunker_api, &data[shift], data_size, min_chunk_size, avg_chunk_size, max_chunk_size, offsets, max_chunk_count);
+        ASSERT_NE(0u, count);
+        ASSERT_EQ(data_size, offsets[count - 1]);
+        uint64_t chunk_start = 0;
+        for (uint32_t c = 0; c < count; ++c)
+        {
+            uint64_t chunk_size = offsets[c] - chunk_start;
+            ASSERT_LE(chunk_size, max_chunk_size);
+            if (c + 1 < count)
+            {
+                ASSERT_GE(chunk_size, min_chunk_size);
+            }
+            chunk_start = offsets[c];
+        }
+
+        // Prepending data should only change the boundaries close to the start
+        uint32_t shifted_count = ChunkMemory(chunker_api, data, data_size + shift, min_chunk_size, avg_chunk_size, max_chunk_size, shifted_offsets, max_chunk_count);
+        ASSERT_NE(0u, shifted_count);
+        uint32_t matching_count = 0;
+        uint32_t s = 0;
+        for (uint32_t c = 0; c < count; ++c)
+        {
+            while (s < shifted_count && shifted_offsets[s] < offsets[c] + shift)
+            {
+                ++s;
+            }
+            if (s < shifted_count && shifted_offsets[s] == offsets[c] + shift)
+            {
+                ++matching_count;
+            }
+        }
+        ASSERT_GE(matching_count + 4, count);
+    }
+
+    Longtail_Free(shifted_offsets);
+    Longtail_Free(offsets);
+    Longtail_Free(data);
+
+    SAFE_DISPOSE_API(chunker_api);
+}
+
+// Chunker comparison benchmark, build with LONGTAIL_BENCHMARKS defined to run it
+#if defined(LONGTAIL_BENCHMARKS)
+static int CompareHashes(const void* a, const void* b)
+{
+    TLongtail_Hash ha = *(const TLongtail_Hash*)a;
+    TLongtail_Hash hb = *(const TLongtail_Hash*)b;
+    return (ha < hb) ? -1 : ((ha > hb) ? 1 : 0);
+}
+
+struct ChunkerStats
+{
+    uint32_t m_ChunkCount;
+    double m_SizeStdDev;
+    double m_DedupRatio;
+    double m_MBPerSecond;
+};
+
+// Chunks `base` and `modified`, reports how many bytes of `modified` is covered by chunks found in `base`
+static void GetChunkerStats(
+    Longtail_ChunkerAPI* chunker_api,
+    Longtail_HashAPI* hash_api,
+    const uint8_t* base,
+    uint64_t base_size,
+    const uint8_t* modified,
+    uint64_t modified_size,
+    uint32_t target_chunk_size,
+    ChunkerStats* out_stats)
+{
+    uint32_t chunker_min_size;
+    chunker_api->GetMinChunkSize(chunker_api, &chunker_min_size);
+    uint32_t min_chunk_size = target_chunk_size / 8 < chunker_min_size ? chunker_min_size : target_chunk_size / 8;
+    uint32_t max_chunk_count = (uint32_t)((base_size > modified_size ? base_size : modified_size) / min_chunk_size) + 1;
+    uint64_t* base_offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+    uint64_t* offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+    TLongtail_Hash* base_hashes = (TLongtail_Hash*)Longtail_Alloc(0, sizeof(TLongtail_Hash) * max_chunk_count);
+
+    jc_test_time_t start = jc_test_get_time();
+    uint32_t base_count = ChunkMemory(chunker_api, base, base_size, min_chunk_size, target_chunk_size / 2, target_chunk_size * 2, base_offsets, max_chunk_count);
+    jc_test_time_t us = jc_test_get_time() - start;
+
+    uint32_t count = ChunkMemory(chunker_api, modified, modified_size, min_chunk_size, target_chunk_size / 2, target_chunk_size * 2, offsets, max_chunk_count);
+
+    uint64_t chunk_start = 0;
+    for (uint32_t c = 0; c < base_count; ++c)
+    {
+        hash_api->HashBuffer(hash_api, (uint32_t)(base_offsets[c] - chunk_start), &base[chunk_start], &base_hashes[c]);
+        chunk_start = base_offsets[c];
+    }
+    qsort(base_hashes, base_count, sizeof(TLongtail_Hash), CompareHashes);
+
+    double mean_size = (double)base_size / base_count;
+    double variance = 0.0;
+    chunk_start = 0;
+    for (uint32_t c = 0; c < base_count; ++c)
+    {
+        double d = (double)(base_offsets[c] - chunk_start) - mean_size;
+        variance += d * d;
+        chunk_start = base_offsets[c];
+    }
+
+    uint64_t reused_size = 0;
+    chunk_start = 0;
+    for (uint32_t c = 0; c < count; ++c)
+    {
+        TLongtail_Hash h;
+        hash_api->HashBuffer(hash_api, (uint32_t)(offsets[c] - chunk_start), &modified[chunk_start], &h);
+        if (bsearch(&h, base_hashes, base_count, sizeof(TLongtail_Hash), CompareHashes))
+        {
+            reused_size += offsets[c] - chunk_start;
+        }
+        chunk_start = offsets[c];
+    }
+
+    out_stats->m_ChunkCount = base_count;
+    out_stats->m_SizeStdDev = sqrt(variance / base_count);
+    out_stats->m_DedupRatio = (double)reused_size / (double)modified_size;
+    out_stats->m_MBPerSecond = ((double)base_size / (1024.0 * 1024.0)) / ((double)(us ? us : 1) / 1000000.0);
+
+    Longtail_Free(base_hashes);
+    Longtail_Free(offsets);
+    Longtail_Free(base_offsets);
+}
+
+TEST(Longtail, ChunkerCompareFastCDCHPCDC)
+{
+    FILE* large_file = fopen("testdata/chunker.input", "rb");
+    ASSERT_NE((FILE*)0, large_file);
+    fseek(large_file, 0, SEEK_END);
+    long file_size = ftell(large_file);
+    fseek(large_file, 0, SEEK_SET);
+
+    const uint32_t repeat_count = 16;
+    uint64_t base_size = (uint64_t)file_size * repeat_count;
+    uint8_t* base = (uint8_t*)Longtail_Alloc(0, base_size);
+    ASSERT_EQ(1u, fread(base, (size_t)file_size, 1, large_file));
+    fclose(large_file);
+    for (uint32_t r = 1; r < repeat_count; ++r)
+    {
+        for (long i = 0; i < file_size; ++i)
+        {
+            base[file_size * r + i] = base[i] ^ (uint8_t)(r * 31);
+        }
+    }
+
+    // The modified version has a small insert, removal and overwrite in every 256KB of the base version
+    const uint64_t edit_interval = 256 * 1024;
+    uint8_t* modified = (uint8_t*)Longtail_Alloc(0, base_size + (base_size / edit_interval + 1) * 64);
+    uint64_t modified_size = 0;
+    srand(4711);
+    for (uint64_t offset = 0; offset < base_size; offset += edit_interval)
+    {
+        uint64_t size = (base_size - offset) < edit_interval ? (base_size - offset) : edit_interval;
+        uint64_t insert_pos = (uint64_t)rand() % (size / 4);
+        uint64_t remove_pos = size / 4 + (uint64_t)rand() % (size / 4);
+        uint64_t overwrite_pos = size / 2 + (uint64_t)rand() % (size / 4);
+        memcpy(&modified[modified_size], &base[offset], insert_pos);
+        modified_size += insert_pos;
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+            modified[modified_size++] = (uint8_t)rand();
+        }
+        memcpy(&modified[modified_size], &base[offset + insert_pos], remove_pos - insert_pos);
+        modified_size += remove_pos - insert_pos;
+        uint64_t rest_start = remove_pos + 48;
+        memcpy(&modified[modified_size], &base[offset + rest_start], size - rest_start);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            modified[modified_size + (overwrite_pos - rest_start) + i] ^= 0x5a;
+        }
+        modified_size += size - rest_start;
+    }
+
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* hpcdc_chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_ChunkerAPI* fastcdc_chunker_api = Longtail_CreateFastCDCChunkerAPI();
+
+    const uint32_t target_chunk_size = 32768;
+    ChunkerStats hpcdc_stats;
+    GetChunkerStats(hpcdc_chunker_api, hash_api, base, base_size, modified, modified_size, target_chunk_size, &hpcdc_stats);
+    ChunkerStats fastcdc_stats;
+    GetChunkerStats(fastcdc_chunker_api, hash_api, base, base_size, modified, modified_size, target_chunk_size, &fastcdc_stats);
+
+    TEST_LOG("HPCDC:   %u chunks, size stddev %.0f, dedup %.1f%%, %.1f MB/s\n", hpcdc_stats.m_ChunkCount, hpcdc_stats.m_SizeStdDev, hpcdc_stats.m_DedupRatio * 100.0, hpcdc_stats.m_MBPerSecond)
+    TEST_LOG("FastCDC: %u chunks, size stddev %.0f, dedup %.1f%%, %.1f MB/s\n", fastcdc_stats.m_ChunkCount, fastcdc_stats.m_SizeStdDev, fastcdc_stats.m_DedupRatio * 100.0, fastcdc_stats.m_MBPerSecond)
+
+    ASSERT_LT(fastcdc_stats.m_SizeStdDev, hpcdc_stats.m_SizeStdDev);
+    ASSERT_GT(fastcdc_stats.m_DedupRatio, 0.5);
+    ASSERT_GT(hpcdc_stats.m_DedupRatio, 0.5);
+
+    SAFE_DISPOSE_API(fastcdc_chunker_api);
+    SAFE_DISPOSE_API(hpcdc_chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+
+    Longtail_Free(modified);
+    Longtail_Free(base);
+}
+#endif // defined(LONGTAIL_BENCHMARKS)
+
+TEST(Longtail, ChunkLargeAssetsInParts)
+{
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
+
+    // Sizes are picked so assets are split in parts of target_chunk_size * 1024 bytes, including one asset
+    // that is an exact multiple of the part size
+    const char* asset_paths[] = {"large/a.bin", "large/b.bin", "large/c.bin"};
+    const uint64_t asset_sizes[] = {9 * 1024 * 1024 + 13, 3 * 128 * 1024, 77777};
+    const uint32_t asset_count = sizeof(asset_paths) / sizeof(asset_paths[0]);
+
+    uint8_t* data = (uint8_t*)Longtail_Alloc(0, asset_sizes[0]);
+    srand(1234);
+    for (uint64_t i = 0; i < asset_sizes[0]; ++i)
+    {
+        // Low entropy runs gives max sized chunks which makes the parts go out of sync with a single chunking pass
+        data[i] = ((i / 40000) % 3 == 1) ? (uint8_t)(i & 3) : (uint8_t)rand();
+    }
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        ASSERT_NE(0, CreateParentPath(storage_api, asset_paths[a]));
+        Longtail_StorageAPI_HOpenFile w;
+        ASSERT_EQ(0, storage_api->OpenWriteFile(storage_api, asset_paths[a], 0, &w));
+        ASSERT_EQ(0, storage_api->Write(storage_api, w, 0, asset_sizes[a], data));
+        storage_api->CloseFile(storage_api, w);
+    }
+
+    Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, "large", &file_infos));
+
+    const uint32_t max_chunk_count = (uint32_t)(asset_sizes[0] / 48) + 1;
+    uint64_t* offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * max_chunk_count);
+
+    Longtail_ChunkerAPI* chunker_apis[] = {Longtail_CreateHPCDCChunkerAPI(), Longtail_CreateFastCDCChunkerAPI()};
+    const uint32_t target_chunk_sizes[] = {128, 4096};
+    for (uint32_t c = 0; c < sizeof(chunker_apis) / sizeof(chunker_apis[0]); ++c)
+    {
+        Longtail_ChunkerAPI* chunker_api = chunker_apis[c];
+        uint32_t chunker_min_size;
+        ASSERT_EQ(0, chunker_api->GetMinChunkSize(chunker_api, &chunker_min_size));
+        for (uint32_t t = 0; t < sizeof(target_chunk_sizes) / sizeof(target_chunk_sizes[0]); ++t)
+        {
+            uint32_t target_chunk_size = target_chunk_sizes[t];
+            Longtail_VersionIndex* vindex;
+            ASSERT_EQ(0, Longtail_CreateVersionIndex(
+                storage_api,
+                hash_api,
+                chunker_api,
+                job_api,
+                0,
+                0,
+                0,
+                "large",
+                file_infos,
+                0,
+                target_chunk_size,
+                &vindex));
+
+            uint32_t min_chunk_size = target_chunk_size / 8 < chunker_min_size ? chunker_min_size : target_chunk_size / 8;
+            uint32_t avg_chunk_size = target_chunk_size / 2 < chunker_min_size ? chunker_min_size : target_chunk_size / 2;
+            uint32_t max_chunk_size = target_chunk_size * 2;
+            for (uint32_t a = 0; a < *vindex->m_AssetCount; ++a)
+            {
+                uint64_t asset_size = vindex->m_AssetSizes[a];
+                uint32_t expected_count = ChunkMemory(chunker_api, data, asset_size, min_chunk_size, avg_chunk_size, max_chunk_size, offsets, max_chunk_count);
+                ASSERT_EQ(expected_count, vindex->m_AssetChunkCounts[a]);
+                uint32_t chunk_index_start = vindex->m_AssetChunkIndexStarts[a];
+                uint64_t offset = 0;
+                for (uint32_t i = 0; i < expected_count; ++i)
+                {
+                    uint32_t chunk_index = vindex->m_AssetChunkIndexes[chunk_index_start + i];
+                    uint32_t chunk_size = vindex->m_ChunkSizes[chunk_index];
+                    TLongtail_Hash chunk_hash;
+                    ASSERT_EQ(0, hash_api->HashBuffer(hash_api, chunk_size, &data[offset], &chunk_hash));
+                    ASSERT_EQ(chunk_hash, vindex->m_ChunkHashes[chunk_index]);
+                    offset += chunk_size;
+                    ASSERT_EQ(offsets[i], offset);
+                }
+                ASSERT_EQ(asset_size, offset);
+            }
+            Longtail_Free(vindex);
+        }
+        SAFE_DISPOSE_API(chunker_api);
+    }
+
+    Longtail_Free(offsets);
+    Longtail_Free(file_infos);
+    Longtail_Free(data);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+TEST(Longtail, CreateVersionIndexAndWriteContent)
+{
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
+    Longtail_BlockStoreAPI* reference_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "reference_store", 0);
+    Longtail_BlockStoreAPI* block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "store", 0);
+
+    const uint32_t target_chunk_size = 128;
+    const uint32_t max_block_size = 16384;
+    const uint32_t max_chunks_per_block = 64;
+
+    const uint64_t data_size = 3 * 1024 * 1024 + 77;
+    uint8_t* data = (uint8_t*)Longtail_Alloc(0, data_size);
+    srand(4711);
+    for (uint64_t i = 0; i < data_size; ++i)
+    {
+        data[i] = ((i / 30000) % 4 == 1) ? (uint8_t)(i & 7) : (uint8_t)rand();
+    }
+
+    // The seed version is uploaded first so the second version finds some of its chunks in the store
+    const char* asset_paths[] = {
+        "seed/a.bin", "seed/b.bin", "seed/empty.txt",
+        "version/big.bin", "version/a_copy.bin", "version/tail.bin", "version/small.txt", "version/empty.txt", "version/folder/c.bin"};
+    const uint64_t asset_offsets[] = {
+        0, 900000, 0,
+        0, 0, 2000000, 17, 0, 2500000};
+    const uint64_t asset_sizes[] = {
+        200000, 300000, 0,
+        data_size, 200000, data_size - 2000000, 31, 0, 150000};
+    for (uint32_t a = 0; a < sizeof(asset_paths) / sizeof(asset_paths[0]); ++a)
+    {
+        ASSERT_NE(0, CreateParentPath(storage_api, asset_paths[a]));
+        Longtail_StorageAPI_HOpenFile w;
+        ASSERT_EQ(0, storage_api->OpenWriteFile(storage_api, asset_paths[a], 0, &w));
+        if (asset_sizes[a])
+        {
+            ASSERT_EQ(0, storage_api->Write(storage_api, w, 0, asset_sizes[a], &data[asset_offsets[a]]));
+        }
+        storage_api->CloseFile(storage_api, w);
+    }
+
+    const char* version_paths[] = {"seed", "version"};
+    for (uint32_t v = 0; v < sizeof(version_paths) / sizeof(version_paths[0]); ++v)
+    {
+        Longtail_FileInfos* file_infos;
+        ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, version_paths[v], &file_infos));
+        uint32_t* tags = (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * file_infos->m_Count);
+        for (uint32_t a = 0; a < file_infos->m_Count; ++a)
+        {
+            tags[a] = (a % 3 == 2) ? 0x2000u : 0x1000u;
+        }
+
+        Longtail_VersionIndex* reference_version_index;
+        ASSERT_EQ(0, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, version_paths[v], file_infos, tags, target_chunk_size, &reference_version_index));
+        Longtail_StoreIndex* existing_store_index = SyncGetExistingContent(reference_block_store_api, *reference_version_index->m_ChunkCount, reference_version_index->m_ChunkHashes, 0);
+        ASSERT_NE((Longtail_StoreIndex*)0, existing_store_index);
+        Longtail_StoreIndex* reference_store_index;
+        ASSERT_EQ(0, Longtail_CreateMissingContent(hash_api, existing_store_index, reference_version_index, max_block_size, max_chunks_per_block, &reference_store_index));
+        ASSERT_EQ(0, Longtail_WriteContent(storage_api, reference_block_store_api, job_api, 0, 0, 0, reference_store_index, reference_version_index, version_paths[v]));
+
+        Longtail_VersionIndex* version_index;
+        Longtail_StoreIndex* store_index;
+        ASSERT_EQ(0, Longtail_CreateVersionIndexAndWriteContent(
+            storage_api,
+            hash_api,
+            chunker_api,
+            job_api,
+            0,
+            0,
+            0,
+            block_store_api,
+            version_paths[v],
+            file_infos,
+            tags,
+            target_chunk_size,
+            max_block_size,
+            max_chunks_per_block,
+            0,
+            &version_index,
+            &store_index));
+
+        void* reference_buffer;
+        size_t reference_size;
+        ASSERT_EQ(0, Longtail_WriteVersionIndexToBuffer(reference_version_index, &reference_buffer, &reference_size));
+        void* buffer;
+        size_t size;
+        ASSERT_EQ(0, Longtail_WriteVersionIndexToBuffer(version_index, &buffer, &size));
+        ASSERT_EQ(reference_size, size);
+        ASSERT_EQ(0, memcmp(reference_buffer, buffer, size));
+        Longtail_Free(buffer);
+        Longtail_Free(reference_buffer);
+
+        ASSERT_LT(1u, *store_index->m_BlockCount);
+        ASSERT_EQ(*reference_store_index->m_BlockCount, *store_index->m_BlockCount);
+        ASSERT_EQ(*reference_store_index->m_ChunkCount, *store_index->m_ChunkCount);
+        ASSERT_EQ(0, memcmp(reference_store_index->m_BlockHashes, store_index->m_BlockHashes, sizeof(TLongtail_Hash) * *store_index->m_BlockCount));
+        ASSERT_EQ(0, memcmp(reference_store_index->m_ChunkHashes, store_index->m_ChunkHashes, sizeof(TLongtail_Hash) * *store_index->m_ChunkCount));
+
+        for (uint32_t b = 0; b < *store_index->m_BlockCount; ++b)
+        {
+            TestAsyncGetBlockComplete reference_get_cb;
+            ASSERT_EQ(0, reference_block_store_api->GetStoredBlock(reference_block_store_api, store_index->m_BlockHashes[b], &reference_get_cb.m_API));
+            reference_get_cb.Wait();
+            ASSERT_EQ(0, reference_get_cb.m_Err);
+            TestAsyncGetBlockComplete get_cb;
+            ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, store_index->m_BlockHashes[b], &get_cb.m_API));
+            get_cb.Wait();
+            ASSERT_EQ(0, get_cb.m_Err);
+            ASSERT_EQ(reference_get_cb.m_StoredBlock->m_BlockChunksDataSize, get_cb.m_StoredBlock->m_BlockChunksDataSize);
+            ASSERT_EQ(0, memcmp(reference_get_cb.m_StoredBlock->m_BlockData, get_cb.m_StoredBlock->m_BlockData, get_cb.m_StoredBlock->m_BlockChunksDataSize));
+            reference_get_cb.m_StoredBlock->Dispose(reference_get_cb.m_StoredBlock);
+            get_cb.m_StoredBlock->Dispose(get_cb.m_StoredBlock);
+        }
+
+        Longtail_Free(store_index);
+        Longtail_Free(version_index);
+        Longtail_Free(reference_store_index);
+        Longtail_Free(existing_store_index);
+        Longtail_Free(reference_version_index);
+        Longtail_Free(tags);
+        Longtail_Free(file_infos);
+    }
+
+    Longtail_Free(data);
+    SAFE_DISPOSE_API(block_store_api);
+    SAFE_DISPOSE_API(reference_block_store_api);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+TEST(Longtail, CreateVersionIndexAndWriteContentMinBlockUsage)
+{
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
+    Longtail_BlockStoreAPI* block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "store", 0);
+
+    const uint32_t target_chunk_size = 128;
+    const uint32_t max_block_size = 4096;
+    const uint32_t max_chunks_per_block = 64;
+
+    // a.bin and b.bin share one block in the store and each use about half of it, mid.bin is large enough to put
+    // them in different windows
+    const char* asset_paths[] = {"a.bin", "mid.bin", "b.bin"};
+    const uint64_t asset_sizes[] = {1000, 300000, 1000};
+    const uint16_t asset_permissions[] = {0644, 0644, 0644};
+    srand(1234);
+    for (uint32_t a = 0; a < 3; ++a)
+    {
+        char* path = storage_api->ConcatPath(storage_api, "data", asset_paths[a]);
+        ASSERT_NE(0, CreateParentPath(storage_api, path));
+        uint8_t* data = (uint8_t*)Longtail_Alloc(0, asset_sizes[a]);
+        for (uint64_t i = 0; i < asset_sizes[a]; ++i)
+        {
+            data[i] = (uint8_t)rand();
+        }
+        Longtail_StorageAPI_HOpenFile w;
+        ASSERT_EQ(0, storage_api->OpenWriteFile(storage_api, path, 0, &w));
+        ASSERT_EQ(0, storage_api->Write(storage_api, w, 0, asset_sizes[a], data));
+        storage_api->CloseFile(storage_api, w);
+        Longtail_Free(data);
+        Longtail_Free(path);
+    }
+
+    const char* seed_paths[] = {"a.bin", "b.bin"};
+    const uint64_t seed_sizes[] = {1000, 1000};
+    Longtail_FileInfos* seed_file_infos;
+    ASSERT_EQ(0, Longtail_MakeFileInfos(2, seed_paths, seed_sizes, asset_permissions, &seed_file_infos));
+    Longtail_VersionIndex* seed_version_index;
+    Longtail_StoreIndex* seed_store_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndexAndWriteContent(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, block_store_api, "data", seed_file_infos, 0, target_chunk_size, max_block_size, max_chunks_per_block, 0, &seed_version_index, &seed_store_index));
+    ASSERT_EQ(1u, *seed_store_index->m_BlockCount);
+    uint32_t seed_chunk_count = *seed_store_index->m_ChunkCount;
+    uint32_t a_chunk_count = seed_version_index->m_AssetChunkCounts[0];
+    ASSERT_LT(0u, a_chunk_count);
+    ASSERT_LT(a_chunk_count, seed_chunk_count);
+
+    // With both a.bin and b.bin in the version the block is fully used even if they are in different windows,
+    // without b.bin the block is only about half used and the chunks of a.bin are written again
+    const uint32_t version_asset_counts[] = {3, 2};
+    const uint32_t expected_seed_chunk_counts[] = {0, a_chunk_count};
+    for (uint32_t v = 0; v < 2; ++v)
+    {
+        Longtail_FileInfos* file_infos;
+        ASSERT_EQ(0, Longtail_MakeFileInfos(version_asset_counts[v], asset_paths, asset_sizes, asset_permissions, &file_infos));
+        Longtail_VersionIndex* version_index;
+        Longtail_StoreIndex* store_index;
+        ASSERT_EQ(0, Longtail_CreateVersionIndexAndWriteContent(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, block_store_api, "data", file_infos, 0, target_chunk_size, max_block_size, max_chunks_per_block, 80, &version_index, &store_index));
+        ASSERT_LT(0u, *store_index->m_BlockCount);
+        uint32_t written_seed_chunk_count = 0;
+        for (uint32_t c = 0; c < *store_index->m_ChunkCount; ++c)
+        {
+            for (uint32_t s = 0; s < seed_chunk_count; ++s)
+            {
+                written_seed_chunk_count += (store_index->m_ChunkHashes[c] == seed_store_index->m_ChunkHashes[s]) ? 1 : 0;
+            }
+        }
+        ASSERT_EQ(expected_seed_chunk_counts[v], written_seed_chunk_count);
+        Longtail_Free(store_index);
+        Longtail_Free(version_index);
+        Longtail_Free(file_infos);
+    }
+
+    Longtail_Free(seed_store_index);
+    Longtail_Free(seed_version_index);
+    Longtail_Free(seed_file_infos);
+    SAFE_DISPOSE_API(block_store_api);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+// Read speed benchmark, build with LONGTAIL_BENCHMARKS defined to run it
+#if defined(LONGTAIL_BENCHMARKS)
+TEST(Longtail, FileSystemStorageReadSpeed)
+{
+    Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+
+    const char* path = "testdata/read_speed.bin";
+    const uint64_t file_size = 32 * 1024 * 1024;
+    uint8_t* data = (uint8_t*)Longtail_Alloc(0, file_size);
+    srand(2020);
+    for (uint64_t i = 0; i < file_size; ++i)
+    {
+        data[i] = (uint8_t)rand();
+    }
+    Longtail_StorageAPI_HOpenFile w;
+    ASSERT_EQ(0, storage_api->OpenWriteFile(storage_api, path, 0, &w));
+    ASSERT_EQ(0, storage_api->Write(storage_api, w, 0, file_size, data));
+    storage_api->CloseFile(storage_api, w);
+
+    Longtail_StorageAPI_HOpenFile r;
+    ASSERT_EQ(0, storage_api->OpenReadFile(storage_api, path, &r));
+    uint64_t size;
+    ASSERT_EQ(0, storage_api->GetSize(storage_api, r, &size));
+    ASSERT_EQ(file_size, size);
+
+    // Min, average and max chunk size for the default target chunk size of 32KB plus a typical block size
+    const uint32_t read_sizes[] = {4096, 16384, 65536, 1024 * 1024};
+    uint8_t* buffer = (uint8_t*)Longtail_Alloc(0, read_sizes[3]);
+    for (uint32_t s = 0; s < sizeof(read_sizes) / sizeof(read_sizes[0]); ++s)
+    {
+        uint32_t read_size = read_sizes[s];
+        uint32_t read_count = (uint32_t)(file_size / read_size);
+
+        jc_test_time_t start = jc_test_get_time();
+        for (uint32_t i = 0; i < read_count; ++i)
+        {
+            ASSERT_EQ(0, storage_api->Read(storage_api, r, (uint64_t)i * read_size, read_size, buffer));
+        }
+        jc_test_time_t sequential_us = jc_test_get_time() - start;
+        ASSERT_EQ(0, memcmp(&data[file_size - read_size], buffer, read_size));
+
+        uint64_t* offsets = (uint64_t*)Longtail_Alloc(0, sizeof(uint64_t) * read_count);
+        for (uint32_t i = 0; i < read_count; ++i)
+        {
+            offsets[i] = (((uint64_t)rand() << 16) ^ (uint64_t)rand()) % (file_size - read_size);
+        }
+        start = jc_test_get_time();
+        for (uint32_t i = 0; i < read_count; ++i)
+        {
+            ASSERT_EQ(0, storage_api->Read(storage_api, r, offsets[i], read_size, buffer));
+        }
+        jc_test_time_t random_us = jc_test_get_time() - start;
+        ASSERT_EQ(0, memcmp(&data[offsets[read_count - 1]], buffer, read_size));
+        Longtail_Free(offsets);
+
+        TEST_LOG("Read %7u bytes: sequential %.1f MB/s, random %.1f MB/s\n",
+            read_size,
+            (double)file_size / (sequential_us ? (double)sequential_us : 1.0),
+            (double)file_size / (random_us ? (double)random_us : 1.0))
+    }
+
+    ASSERT_NE(0, storage_api->Read(storage_api, r, file_size - 10, 20, buffer));
+
+    storage_api->CloseFile(storage_api, r);
+    ASSERT_EQ(0, storage_api->RemoveFile(storage_api, path));
+    Longtail_Free(buffer);
+    Longtail_Free(data);
+    SAFE_DISPOSE_API(storage_api);
+}
+#endif // defined(LONGTAIL_BENCHMARKS)
+
+// Compression throughput benchmark, build with LONGTAIL_BENCHMARKS defined to run it
+#if defined(LONGTAIL_BENCHMARKS)
+struct CompressionSpeedJob
+{
+    Longtail_CompressionAPI* m_CompressionAPI;
+    uint32_t m_SettingsID;
+    const char* m_Data;
+    size_t m_Size;
+    uint32_t m_BlockCount;
+    int m_Err;
+
+    static int JobFunc(void* context, uint32_t job_id, int is_cancelled)
+    {
+        CompressionSpeedJob* job = (CompressionSpeedJob*)context;
+        Longtail_CompressionAPI* compression_api = job->m_CompressionAPI;
+        size_t max_compressed_size = compression_api->GetMaxCompressedSize(compression_api, job->m_SettingsID, job->m_Size);
+        char* compressed = (char*)Longtail_Alloc(0, max_compressed_size);
+        char* decompressed = (char*)Longtail_Alloc(0, job->m_Size);
+        job->m_Err = 0;
+        for (uint32_t b = 0; b < job->m_BlockCount && job->m_Err == 0; ++b)
+        {
+            size_t compressed_size;
+            job->m_Err = compression_api->Compress(compression_api, job->m_SettingsID, job->m_Data, compressed, job->m_Size, max_compressed_size, &compressed_size);
+            if (job->m_Err == 0)
+            {
+                size_t decompressed_size;
+                job->m_Err = compression_api->Decompress(compression_api, compressed, decompressed, compressed_size, job->m_Size, &decompressed_size);
+                if (job->m_Err == 0 && (decompressed_size != job->m_Size || memcmp(decompressed, job->m_Data, job->m_Size) != 0))
+                {
+                    job->m_Err = EBADF;
+                }
+            }
+        }
+        Longtail_Free(decompressed);
+        Longtail_Free(compressed);
+        return 0;
+    }
+};
+
+TEST(Longtail, CompressionSpeed)
+{
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(4, 0);
+    Longtail_CompressionAPI* zstd_api = Longtail_CreateZStdCompressionAPI();
+    Longtail_CompressionAPI* lz4_api = Longtail_CreateLZ4CompressionAPI();
+    Longtail_CompressionAPI* brotli_api = Longtail_CreateBrotliCompressionAPI();
+
+    // Blocks of somewhat compressible data, compressed and decompressed round trip from concurrent jobs
+    const size_t block_size = 16384;
+    char* data = (char*)Longtail_Alloc(0, block_size);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < block_size; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (char)('a' + ((seed >> 24) % 8) + ((i / 16) % 4));
+    }
+
+    struct
+    {
+        const char* m_Name;
+        Longtail_CompressionAPI* m_CompressionAPI;
+        uint32_t m_SettingsID;
+        uint32_t m_BlockCount;
+    } codecs[] = {
+        {"zstd min", zstd_api, Longtail_GetZStdMinQuality(), 128},
+        {"zstd default", zstd_api, Longtail_GetZStdDefaultQuality(), 128},
+        {"lz4", lz4_api, Longtail_GetLZ4DefaultQuality(), 512},
+        {"brotli min", brotli_api, Longtail_GetBrotliGenericMinQuality(), 128}
+    };
+
+    const uint32_t job_count = 8;
+    for (uint32_t c = 0; c < sizeof(codecs) / sizeof(codecs[0]); ++c)
+    {
+        CompressionSpeedJob jobs[job_count];
+        Longtail_JobAPI_JobFunc job_funcs[job_count];
+        void* job_ctxs[job_count];
+        for (uint32_t j = 0; j < job_count; ++j)
+        {
+            jobs[j].m_CompressionAPI = codecs[c].m_CompressionAPI;
+            jobs[j].m_SettingsID = codecs[c].m_SettingsID;
+            jobs[j].m_Data = data;
+            jobs[j].m_Size = block_size;
+            jobs[j].m_BlockCount = codecs[c].m_BlockCount;
+            jobs[j].m_Err = EINVAL;
+            job_funcs[j] = CompressionSpeedJob::JobFunc;
+            job_ctxs[j] = &jobs[j];
+        }
+
+        jc_test_time_t start = jc_test_get_time();
+        Longtail_JobAPI_Group job_group;
+        ASSERT_EQ(0, job_api->ReserveJobs(job_api, job_count, &job_group));
+        Longtail_JobAPI_Jobs job_handles;
+        ASSERT_EQ(0, job_api->CreateJobs(job_api, job_group, job_count, job_funcs, job_ctxs, &job_handles));
+        ASSERT_EQ(0, job_api->ReadyJobs(job_api, job_count, job_handles));
+        ASSERT_EQ(0, job_api->WaitForAllJobs(job_api, job_group, 0, 0, 0));
+        jc_test_time_t elapsed_us = jc_test_get_time() - start;
+
+        for (uint32_t j = 0; j < job_count; ++j)
+        {
+            ASSERT_EQ(0, jobs[j].m_Err);
+        }
+        TEST_LOG("%-12s: %.0f blocks/s\n",
+            codecs[c].m_Name,
+            (double)(job_count * codecs[c].m_BlockCount) * 1000000.0 / (elapsed_us ? (double)elapsed_us : 1.0))
+    }
+
+    Longtail_Free(data);
+    SAFE_DISPOSE_API(brotli_api);
+    SAFE_DISPOSE_API(lz4_api);
+    SAFE_DISPOSE_API(zstd_api);
+    SAFE_DISPOSE_API(job_api);
+}
+#endif // defined(LONGTAIL_BENCHMARKS)
+
+TEST(Longtail, FileSystemStorage)
+{
+    Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+
+    const uint32_t ASSET_COUNT = 9u;
+
+    const char* TEST_FILENAMES[] = {
+        "ContentChangedSameLength.txt",
+        "WillBeRenamed.txt",
+        "ContentSameButShorter.txt",
+        "folder/ContentSameButLonger.txt",
         "OldRenamedFolder/MovedToNewFolder.txt",
         "JustDifferent.txt",
         "EmptyFileInFolder/.init.py",
@@ -4384,11 +6113,94 @@ TEST(Longtail, TestFileScanCancelOperation)
     Longtail_FileInfos* file_infos;
     ASSERT_EQ(0, cancel_api->Cancel(cancel_api, cancel_token));
     ASSERT_EQ(ECANCELED, Longtail_GetFilesRecursively(storage_api, 0, cancel_api, cancel_token, "testdata", &file_infos));
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(2, 0);
+    ASSERT_EQ(ECANCELED, Longtail_GetFilesRecursivelyParallel(storage_api, job_api, 0, cancel_api, cancel_token, "testdata", &file_infos));
+    SAFE_DISPOSE_API(job_api);
     ASSERT_EQ(0, cancel_api->DisposeToken(cancel_api, cancel_token));
     SAFE_DISPOSE_API(cancel_api);
     SAFE_DISPOSE_API(storage_api);
 }
 
+TEST(Longtail, TestFSIteratorEntryProperties)
+{
+    Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+    const char* root_path = "testdata_fsiterator";
+    const char* folder_path = "testdata_fsiterator/folder";
+    const char* root_file_path = "testdata_fsiterator/root.txt";
+    const char* nested_file_path = "testdata_fsiterator/folder/nested.txt";
+    const char* root_data = "root file";
+    const char* nested_data = "a longer file in a nested folder";
+
+    storage_api->RemoveFile(storage_api, nested_file_path);
+    storage_api->RemoveFile(storage_api, root_file_path);
+    storage_api->RemoveDir(storage_api, folder_path);
+    storage_api->RemoveDir(storage_api, root_path);
+
+    ASSERT_EQ(0, storage_api->CreateDir(storage_api, root_path));
+    ASSERT_EQ(0, storage_api->CreateDir(storage_api, folder_path));
+    ASSERT_EQ(0, storage_api->SetPermissions(storage_api, folder_path, 0750));
+    Longtail_StorageAPI_HOpenFile f;
+    ASSERT_EQ(0, storage_api->OpenWriteFile(storage_api, root_file_path, 0, &f));
+    ASSERT_EQ(0, storage_api->Write(storage_api, f, 0, strlen(root_data), root_data));
+    storage_api->CloseFile(storage_api, f);
+    ASSERT_EQ(0, storage_api->SetPermissions(storage_api, root_file_path, 0640));
+    ASSERT_EQ(0, storage_api->OpenWriteFile(storage_api, nested_file_path, 0, &f));
+    ASSERT_EQ(0, storage_api->Write(storage_api, f, 0, strlen(nested_data), nested_data));
+    storage_api->CloseFile(storage_api, f);
+    ASSERT_EQ(0, storage_api->SetPermissions(storage_api, nested_file_path, 0600));
+#if !defined(_WIN32)
+    // Fifos are neither files nor directories and must not be part of the scan
+    ASSERT_EQ(0, mkfifo("testdata_fsiterator/folder/fifo", 0644));
+    // Links are not followed, a link back to the parent folder must not make the scan loop
+    ASSERT_EQ(0, symlink("..", "testdata_fsiterator/folder/loop"));
+    ASSERT_EQ(0, symlink("../root.txt", "testdata_fsiterator/folder/link.txt"));
+#endif
+
+    Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, root_path, &file_infos));
+    ASSERT_EQ(3u, file_infos->m_Count);
+    int found_folder = 0;
+    int found_root_file = 0;
+    int found_nested_file = 0;
+    for (uint32_t i = 0; i < file_infos->m_Count; ++i)
+    {
+        const char* path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[i]];
+        if (strcmp(path, "folder/") == 0)
+        {
+            ASSERT_EQ(0u, file_infos->m_Sizes[i]);
+            ASSERT_EQ(0750, file_infos->m_Permissions[i]);
+            ++found_folder;
+        }
+        else if (strcmp(path, "root.txt") == 0)
+        {
+            ASSERT_EQ(strlen(root_data), file_infos->m_Sizes[i]);
+            ASSERT_EQ(0640, file_infos->m_Permissions[i]);
+            ++found_root_file;
+        }
+        else if (strcmp(path, "folder/nested.txt") == 0)
+        {
+            ASSERT_EQ(strlen(nested_data), file_infos->m_Sizes[i]);
+            ASSERT_EQ(0600, file_infos->m_Permissions[i]);
+            ++found_nested_file;
+        }
+    }
+    ASSERT_EQ(1, found_folder);
+    ASSERT_EQ(1, found_root_file);
+    ASSERT_EQ(1, found_nested_file);
+    Longtail_Free(file_infos);
+
+#if !defined(_WIN32)
+    ASSERT_EQ(0, unlink("testdata_fsiterator/folder/link.txt"));
+    ASSERT_EQ(0, unlink("testdata_fsiterator/folder/loop"));
+    ASSERT_EQ(0, unlink("testdata_fsiterator/folder/fifo"));
+#endif
+    ASSERT_EQ(0, storage_api->RemoveFile(storage_api, nested_file_path));
+    ASSERT_EQ(0, storage_api->RemoveFile(storage_api, root_file_path));
+    ASSERT_EQ(0, storage_api->RemoveDir(storage_api, folder_path));
+    ASSERT_EQ(0, storage_api->RemoveDir(storage_api, root_path));
+    SAFE_DISPOSE_API(storage_api);
+}
+
 TEST(Longtail, TestCreateVersionCancelOperation)
 {
     struct Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
@@ -5274,108 +7086,634 @@ TEST(Longtail, VersionLocalContent)
         version2_block_store_store_index,
         &block_store_store_index_2));
 
-    ASSERT_EQ(0, Longtail_ValidateStore(
-        block_store_store_index_2,
-        version2_index));
-    ASSERT_EQ(0, Longtail_ValidateStore(
-        block_store_store_index_2,
-        version1_index));
-    ASSERT_NE(0, Longtail_ValidateStore(
-        block_store_store_index_1,
-        version2_index));
+    ASSERT_EQ(0, Longtail_ValidateStore(
+        block_store_store_index_2,
+        version2_index));
+    ASSERT_EQ(0, Longtail_ValidateStore(
+        block_store_store_index_2,
+        version1_index));
+    ASSERT_NE(0, Longtail_ValidateStore(
+        block_store_store_index_1,
+        version2_index));
+
+    Longtail_Free(block_store_store_index_2);
+
+    Longtail_Free(version2_missing_content_index);
+
+    Longtail_Free(version2_block_store_store_index);
+
+    Longtail_Free(version2_index);
+
+    Longtail_Free(version2_file_infos);
+
+    Longtail_Free(block_store_store_index_1);
+
+    Longtail_Free(version1_missing_content_index);
+
+    Longtail_Free(version1_block_store_store_index);
+
+    Longtail_Free(version1_index);
+
+    Longtail_Free(version1_file_infos);
+
+    SAFE_DISPOSE_API(block_store);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(storage_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(chunker_api);
+}
+
+struct FailableStorageAPI
+{
+    struct Longtail_StorageAPI m_API;
+    struct Longtail_StorageAPI* m_BackingAPI;
+    int m_PassCount;
+    int m_WriteError;
+    TLongtail_Atomic32 m_OpenReadCount;
+    TLongtail_Atomic32 m_ReadCount;
+    HLongtail_Sema m_WriteGate;
+    HLongtail_Sema m_WriteEntered;
+
+    static void Dispose(struct Longtail_API* api) { Longtail_Free(api); }
+    static int OpenReadFile(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HOpenFile* out_open_file) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; Longtail_AtomicAdd32(&api->m_OpenReadCount, 1); return api->m_BackingAPI->OpenReadFile(api->m_BackingAPI, path, out_open_file);}
+    static int GetSize(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t* out_size) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->GetSize(api->m_BackingAPI, f, out_size);}
+    static int Read(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length, void* output) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; Longtail_AtomicAdd32(&api->m_ReadCount, 1); return api->m_BackingAPI->Read(api->m_BackingAPI, f, offset, length, output);}
+    static int OpenWriteFile(struct Longtail_StorageAPI* storage_api, const char* path, uint64_t initial_size, Longtail_StorageAPI_HOpenFile* out_open_file) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->OpenWriteFile(api->m_BackingAPI, path, initial_size, out_open_file);}
+    static int Write(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length, const void* input) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; HLongtail_Sema write_gate = api->m_WriteGate; if (write_gate) { Longtail_PostSema(api->m_WriteEntered, 1); Longtail_WaitSema(write_gate, LONGTAIL_TIMEOUT_INFINITE); } return ((api->m_PassCount-- <= 0) && offset > 0 && api->m_WriteError != 0) ? api->m_WriteError : api->m_BackingAPI->Write(api->m_BackingAPI, f, offset, length, input);}
+    static int SetSize(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t length) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->SetSize(api->m_BackingAPI, f, length);}
+    static int SetPermissions(struct Longtail_StorageAPI* storage_api, const char* path, uint16_t permissions) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->SetPermissions(api->m_BackingAPI, path, permissions);}
+    static int GetPermissions(struct Longtail_StorageAPI* storage_api, const char* path, uint16_t* out_permissions) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->GetPermissions(api->m_BackingAPI, path, out_permissions);}
+    static void CloseFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->CloseFile(api->m_BackingAPI, f);}
+    static int CreateDir(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->CreateDir(api->m_BackingAPI, path);}
+    static int RenameFile(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->RenameFile(api->m_BackingAPI, source_path, target_path);}
+    static char* ConcatPath(struct Longtail_StorageAPI* storage_api, const char* root_path, const char* sub_path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->ConcatPath(api->m_BackingAPI, root_path, sub_path);}
+    static int IsDir(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->IsDir(api->m_BackingAPI, path);}
+    static int IsFile(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->IsFile(api->m_BackingAPI, path);}
+    static int RemoveDir(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->RemoveDir(api->m_BackingAPI, path);}
+    static int RemoveFile(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->RemoveFile(api->m_BackingAPI, path);}
+    static int StartFind(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HIterator* out_iterator) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->StartFind(api->m_BackingAPI, path, out_iterator);}
+    static int FindNext(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->FindNext(api->m_BackingAPI, iterator);}
+    static void CloseFind(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->CloseFind(api->m_BackingAPI, iterator);}
+    static int GetEntryProperties(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator, struct Longtail_StorageAPI_EntryProperties* out_properties) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->GetEntryProperties(api->m_BackingAPI, iterator, out_properties);}
+    static int LockFile(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HLockFile* out_lock_file) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->LockFile(api->m_BackingAPI, path, out_lock_file);}
+    static int UnlockFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HLockFile lock_file) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->UnlockFile(api->m_BackingAPI, lock_file);}
+};
+
+struct FailableStorageAPI* CreateFailableStorageAPI(struct Longtail_StorageAPI* backing_api)
+{
+    void* mem = Longtail_Alloc(0, sizeof(struct FailableStorageAPI));
+    struct Longtail_StorageAPI* api = Longtail_MakeStorageAPI(
+        mem,
+        FailableStorageAPI::Dispose,
+        FailableStorageAPI::OpenReadFile,
+        FailableStorageAPI::GetSize,
+        FailableStorageAPI::Read,
+        FailableStorageAPI::OpenWriteFile,
+        FailableStorageAPI::Write,
+        FailableStorageAPI::SetSize,
+        FailableStorageAPI::SetPermissions,
+        FailableStorageAPI::GetPermissions,
+        FailableStorageAPI::CloseFile,
+        FailableStorageAPI::CreateDir,
+        FailableStorageAPI::RenameFile,
+        FailableStorageAPI::ConcatPath,
+        FailableStorageAPI::IsDir,
+        FailableStorageAPI::IsFile,
+        FailableStorageAPI::RemoveDir,
+        FailableStorageAPI::RemoveFile,
+        FailableStorageAPI::StartFind,
+        FailableStorageAPI::FindNext,
+        FailableStorageAPI::CloseFind,
+        FailableStorageAPI::GetEntryProperties,
+        FailableStorageAPI::LockFile,
+        FailableStorageAPI::UnlockFile);
+    struct FailableStorageAPI* failable_storage_api = (struct FailableStorageAPI*)api;
+    failable_storage_api->m_BackingAPI = backing_api;
+    failable_storage_api->m_PassCount = 0x7fffffff;
+    failable_storage_api->m_WriteError = 0;
+    failable_storage_api->m_OpenReadCount = 0;
+    failable_storage_api->m_ReadCount = 0;
+    failable_storage_api->m_WriteGate = 0;
+    failable_storage_api->m_WriteEntered = 0;
+    return failable_storage_api;
+}
+
+static void WriteTestFile(Longtail_StorageAPI* storage_api, const char* path, const char* content)
+{
+    ASSERT_NE(0, CreateParentPath(storage_api, path));
+    Longtail_StorageAPI_HOpenFile w;
+    ASSERT_EQ(0, storage_api->OpenWriteFile(storage_api, path, 0, &w));
+    ASSERT_EQ(0, storage_api->Write(storage_api, w, 0, strlen(content), content));
+    storage_api->CloseFile(storage_api, w);
+}
+
+TEST(Longtail, Longtail_CreateVersionIndexIncremental)
+{
+    Longtail_StorageAPI* mem_storage = Longtail_CreateInMemStorageAPI();
+    struct FailableStorageAPI* storage = CreateFailableStorageAPI(mem_storage);
+    Longtail_StorageAPI* storage_api = &storage->m_API;
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+
+    WriteTestFile(storage_api, "source/a.txt", "The first file");
+    WriteTestFile(storage_api, "source/b.txt", "The second file");
+    WriteTestFile(storage_api, "source/folder/c.txt", "The third file in a folder");
+    WriteTestFile(storage_api, "source/folder/d.txt", "The fourth file in a folder");
+
+    Longtail_FileInfos* previous_file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, "source", &previous_file_infos));
+    for (uint32_t f = 0; f < previous_file_infos->m_Count; ++f)
+    {
+        ASSERT_NE(0u, Longtail_FileInfos_GetModificationTime(previous_file_infos, f));
+    }
+    Longtail_VersionIndex* previous_version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", previous_file_infos, 0, 16, &previous_version_index));
+    ASSERT_EQ(4, storage->m_OpenReadCount);
+
+    // Same size but new content, plus one new file
+    WriteTestFile(storage_api, "source/b.txt", "The SECOND file");
+    WriteTestFile(storage_api, "source/folder/e.txt", "A new file");
+
+    Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, "source", &file_infos));
+
+    storage->m_OpenReadCount = 0;
+    Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndexIncremental(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 16, previous_version_index, previous_file_infos, &version_index));
+    ASSERT_EQ(2, storage->m_OpenReadCount);
+
+    Longtail_VersionIndex* full_version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 16, &full_version_index));
+
+    void* buffer;
+    size_t size;
+    ASSERT_EQ(0, Longtail_WriteVersionIndexToBuffer(version_index, &buffer, &size));
+    void* full_buffer;
+    size_t full_size;
+    ASSERT_EQ(0, Longtail_WriteVersionIndexToBuffer(full_version_index, &full_buffer, &full_size));
+    ASSERT_EQ(full_size, size);
+    ASSERT_EQ(0, memcmp(full_buffer, buffer, size));
+    Longtail_Free(full_buffer);
+    Longtail_Free(buffer);
+
+    // Storages that can't tell us the modification time always get chunked
+    Longtail_FileInfos* untimed_file_infos;
+    const char* untimed_paths[1] = {"a.txt"};
+    uint64_t untimed_sizes[1] = {strlen("The first file")};
+    uint16_t untimed_permissions[1] = {0644};
+    ASSERT_EQ(0, Longtail_MakeFileInfos(1, untimed_paths, untimed_sizes, untimed_permissions, &untimed_file_infos));
+    storage->m_OpenReadCount = 0;
+    Longtail_VersionIndex* untimed_version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndexIncremental(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", untimed_file_infos, 0, 16, previous_version_index, previous_file_infos, &untimed_version_index));
+    ASSERT_EQ(1, storage->m_OpenReadCount);
+    Longtail_Free(untimed_version_index);
+    Longtail_Free(untimed_file_infos);
+
+    Longtail_Free(full_version_index);
+    Longtail_Free(version_index);
+    Longtail_Free(file_infos);
+    Longtail_Free(previous_version_index);
+    Longtail_Free(previous_file_infos);
+
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+    SAFE_DISPOSE_API(mem_storage);
+}
+
+TEST(Longtail, Longtail_CreateVersionIndexIncrementalFromSavedState)
+{
+    Longtail_StorageAPI* mem_storage = Longtail_CreateInMemStorageAPI();
+    struct FailableStorageAPI* storage = CreateFailableStorageAPI(mem_storage);
+    Longtail_StorageAPI* storage_api = &storage->m_API;
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+
+    WriteTestFile(storage_api, "source/a.txt", "The first file");
+    WriteTestFile(storage_api, "source/b.txt", "The second file");
+    WriteTestFile(storage_api, "source/folder/c.txt", "The third file in a folder");
+
+    // First run, index everything and save the scan state
+    {
+        Longtail_FileInfos* file_infos;
+        ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, "source", &file_infos));
+        Longtail_VersionIndex* version_index;
+        ASSERT_EQ(0, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 16, &version_index));
+        ASSERT_EQ(0, Longtail_WriteFileInfos(storage_api, file_infos, "state/scan.lfi"));
+        ASSERT_EQ(0, Longtail_WriteVersionIndex(storage_api, version_index, "state/scan.lvi"));
+
+        Longtail_FileInfos* read_file_infos;
+        ASSERT_EQ(0, Longtail_ReadFileInfos(storage_api, "state/scan.lfi", &read_file_infos));
+        ASSERT_EQ(file_infos->m_Count, read_file_infos->m_Count);
+        for (uint32_t f = 0; f < file_infos->m_Count; ++f)
+        {
+            ASSERT_STREQ(Longtail_FileInfos_GetPath(file_infos, f), Longtail_FileInfos_GetPath(read_file_infos, f));
+            ASSERT_EQ(file_infos->m_Sizes[f], read_file_infos->m_Sizes[f]);
+            ASSERT_EQ(file_infos->m_ModificationTimes[f], read_file_infos->m_ModificationTimes[f]);
+            ASSERT_EQ(file_infos->m_Permissions[f], read_file_infos->m_Permissions[f]);
+        }
+        Longtail_Free(read_file_infos);
+
+        void* buffer;
+        size_t size;
+        ASSERT_EQ(0, Longtail_WriteFileInfosToBuffer(file_infos, &buffer, &size));
+        ASSERT_EQ(EBADF, Longtail_ReadFileInfosFromBuffer(buffer, size - 1, &read_file_infos));
+        // A file infos written by another format version is rejected so the caller rescans instead
+        ((uint32_t*)buffer)[1] += 1;
+        ASSERT_EQ(EBADF, Longtail_ReadFileInfosFromBuffer(buffer, size, &read_file_infos));
+        ((uint32_t*)buffer)[1] -= 1;
+        ((uint32_t*)buffer)[0] = 0;
+        ASSERT_EQ(EBADF, Longtail_ReadFileInfosFromBuffer(buffer, size, &read_file_infos));
+        Longtail_Free(buffer);
+
+        Longtail_Free(version_index);
+        Longtail_Free(file_infos);
+    }
+
+    WriteTestFile(storage_api, "source/b.txt", "The SECOND file");
+
+    // Second run, only the changed file is read
+    Longtail_FileInfos* previous_file_infos;
+    ASSERT_EQ(0, Longtail_ReadFileInfos(storage_api, "state/scan.lfi", &previous_file_infos));
+    Longtail_VersionIndex* previous_version_index;
+    ASSERT_EQ(0, Longtail_ReadVersionIndex(storage_api, "state/scan.lvi", &previous_version_index));
+    Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, "source", &file_infos));
+    storage->m_OpenReadCount = 0;
+    Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndexIncremental(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 16, previous_version_index, previous_file_infos, &version_index));
+    ASSERT_EQ(1, storage->m_OpenReadCount);
+
+    Longtail_VersionIndex* full_version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 16, &full_version_index));
+    void* buffer;
+    size_t size;
+    ASSERT_EQ(0, Longtail_WriteVersionIndexToBuffer(version_index, &buffer, &size));
+    void* full_buffer;
+    size_t full_size;
+    ASSERT_EQ(0, Longtail_WriteVersionIndexToBuffer(full_version_index, &full_buffer, &full_size));
+    ASSERT_EQ(full_size, size);
+    ASSERT_EQ(0, memcmp(full_buffer, buffer, size));
+    Longtail_Free(full_buffer);
+    Longtail_Free(buffer);
+
+    Longtail_Free(full_version_index);
+    Longtail_Free(version_index);
+    Longtail_Free(file_infos);
+    Longtail_Free(previous_version_index);
+    Longtail_Free(previous_file_infos);
+
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+    SAFE_DISPOSE_API(mem_storage);
+}
+
+TEST(Longtail, Longtail_CreateVersionIndexSmallAssets)
+{
+    Longtail_StorageAPI* mem_storage = Longtail_CreateInMemStorageAPI();
+    struct FailableStorageAPI* storage = CreateFailableStorageAPI(mem_storage);
+    Longtail_StorageAPI* storage_api = &storage->m_API;
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+
+    // Enough small files to fill several batches, with a file that needs the chunker in between
+    const uint32_t small_file_count = 600;
+    char path[64];
+    char content[128];
+    for (uint32_t f = 0; f < small_file_count; ++f)
+    {
+        sprintf(path, "source/%03u.txt", f);
+        sprintf(content, "Content of small file number %u", f * 7919);
+        WriteTestFile(storage_api, path, content);
+    }
+    char* large_content = (char*)Longtail_Alloc(0, 262145);
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < 262144; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        large_content[i] = (char)('a' + (seed >> 27));
+    }
+    large_content[262144] = 0;
+    WriteTestFile(storage_api, "source/300_large.txt", large_content);
+    Longtail_Free(large_content);
+
+    Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, "source", &file_infos));
+    ASSERT_EQ(small_file_count + 1, file_infos->m_Count);
+
+    Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 32768, &version_index));
+    ASSERT_EQ(small_file_count + 1, (uint32_t)storage->m_OpenReadCount);
+
+    uint32_t large_asset_count = 0;
+    for (uint32_t a = 0; a < *version_index->m_AssetCount; ++a)
+    {
+        const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[a]];
+        uint32_t chunk_index = version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[a]];
+        if (strcmp(asset_path, "300_large.txt") == 0)
+        {
+            ASSERT_LT(1u, version_index->m_AssetChunkCounts[a]);
+            ++large_asset_count;
+            continue;
+        }
+        unsigned int f;
+        ASSERT_EQ(1, sscanf(asset_path, "%03u.txt", &f));
+        sprintf(content, "Content of small file number %u", f * 7919);
+        ASSERT_EQ(1u, version_index->m_AssetChunkCounts[a]);
+        ASSERT_EQ(strlen(content), version_index->m_ChunkSizes[chunk_index]);
+        uint64_t content_hash;
+        ASSERT_EQ(0, hash_api->HashBuffer(hash_api, (uint32_t)strlen(content), content, &content_hash));
+        ASSERT_EQ(content_hash, version_index->m_ChunkHashes[chunk_index]);
+    }
+    ASSERT_EQ(1u, large_asset_count);
+    Longtail_Free(version_index);
+
+    // A failing asset in a batch fails the whole index
+    ASSERT_EQ(0, storage_api->RemoveFile(storage_api, "source/123.txt"));
+    ASSERT_EQ(ENOENT, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 32768, &version_index));
+
+    Longtail_Free(file_infos);
+
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+    SAFE_DISPOSE_API(mem_storage);
+}
+
+TEST(Longtail, Longtail_CreateMissingContentKeepsSmallAssetsInOneBlock)
+{
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+
+    // Small multi-chunk assets that do not line up with the block size
+    const uint32_t file_count = 40;
+    const uint32_t file_size = 2500;
+    char path[64];
+    char* content = (char*)Longtail_Alloc(0, file_size + 1);
+    uint32_t seed = 1;
+    for (uint32_t f = 0; f < file_count; ++f)
+    {
+        for (uint32_t i = 0; i < file_size; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            content[i] = (char)('a' + (seed >> 27));
+        }
+        content[file_size] = 0;
+        sprintf(path, "source/%03u.txt", f);
+        WriteTestFile(storage_api, path, content);
+    }
+    Longtail_Free(content);
+
+    Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, "source", &file_infos));
+    Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 1024, &version_index));
+    Longtail_Free(file_infos);
+
+    const uint32_t max_block_size = 16384;
+    const uint32_t max_chunks_per_block = 64;
+    Longtail_StoreIndex* empty_store_index;
+    ASSERT_EQ(0, Longtail_CreateStoreIndexFromBlocks(0, 0, &empty_store_index));
 
-    Longtail_Free(block_store_store_index_2);
+    Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, Longtail_CreateMissingContent(hash_api, empty_store_index, version_index, max_block_size, max_chunks_per_block, &store_index));
+    ASSERT_EQ(*version_index->m_ChunkCount, *store_index->m_ChunkCount);
 
-    Longtail_Free(version2_missing_content_index);
+    uint32_t asset_count;
+    uint64_t blocks_touched_count;
+    ASSERT_EQ(0, Longtail_GetBlocksTouchedPerAsset(store_index, version_index, &asset_count, &blocks_touched_count));
+    ASSERT_EQ(file_count, asset_count);
+    ASSERT_EQ(file_count, blocks_touched_count);
 
-    Longtail_Free(version2_block_store_store_index);
+    // Packing chunks without asset information splits some assets over two blocks
+    Longtail_StoreIndex* chunk_packed_store_index;
+    ASSERT_EQ(0, Longtail_CreateStoreIndex(
+        hash_api,
+        *version_index->m_ChunkCount,
+        version_index->m_ChunkHashes,
+        version_index->m_ChunkSizes,
+        version_index->m_ChunkTags,
+        max_block_size,
+        max_chunks_per_block,
+        &chunk_packed_store_index));
+    ASSERT_EQ(0, Longtail_GetBlocksTouchedPerAsset(chunk_packed_store_index, version_index, &asset_count, &blocks_touched_count));
+    ASSERT_EQ(file_count, asset_count);
+    ASSERT_LT((uint64_t)file_count, blocks_touched_count);
+
+    // Chunks missing from the store are not counted
+    ASSERT_EQ(0, Longtail_GetBlocksTouchedPerAsset(empty_store_index, version_index, &asset_count, &blocks_touched_count));
+    ASSERT_EQ(0u, asset_count);
+    ASSERT_EQ(0u, blocks_touched_count);
+
+    Longtail_Free(chunk_packed_store_index);
+    Longtail_Free(store_index);
+    Longtail_Free(empty_store_index);
+    Longtail_Free(version_index);
 
-    Longtail_Free(version2_index);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+}
 
-    Longtail_Free(version2_file_infos);
+static void WriteContentAndValidateBlocks(
+    Longtail_StorageAPI* source_storage,
+    Longtail_HashAPI* hash_api,
+    Longtail_JobAPI* job_api,
+    Longtail_BlockStoreAPI* block_store_api,
+    Longtail_StoreIndex* store_index,
+    Longtail_VersionIndex* version_index)
+{
+    ASSERT_EQ(0, Longtail_WriteContent(source_storage, block_store_api, job_api, 0, 0, 0, store_index, version_index, "source"));
+    for (uint32_t b = 0; b < *store_index->m_BlockCount; ++b)
+    {
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, store_index->m_BlockHashes[b], &getCB.m_API));
+        getCB.Wait();
+        ASSERT_EQ(0, getCB.m_Err);
+        Longtail_StoredBlock* stored_block = getCB.m_StoredBlock;
+        const uint8_t* chunk_data = (const uint8_t*)stored_block->m_BlockData;
+        for (uint32_t c = 0; c < *stored_block->m_BlockIndex->m_ChunkCount; ++c)
+        {
+            uint64_t chunk_hash;
+            ASSERT_EQ(0, hash_api->HashBuffer(hash_api, stored_block->m_BlockIndex->m_ChunkSizes[c], chunk_data, &chunk_hash));
+            ASSERT_EQ(stored_block->m_BlockIndex->m_ChunkHashes[c], chunk_hash);
+            chunk_data += stored_block->m_BlockIndex->m_ChunkSizes[c];
+        }
+        stored_block->Dispose(stored_block);
+    }
+}
 
-    Longtail_Free(block_store_store_index_1);
+TEST(Longtail, Longtail_WriteContentCoalescedReads)
+{
+    Longtail_StorageAPI* mem_storage = Longtail_CreateInMemStorageAPI();
+    struct FailableStorageAPI* storage = CreateFailableStorageAPI(mem_storage);
+    Longtail_StorageAPI* storage_api = &storage->m_API;
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, mem_storage, "chunks", 0);
 
-    Longtail_Free(version1_missing_content_index);
+    const uint32_t file_count = 3;
+    const uint32_t file_size = 128 * 1024;
+    char* content = (char*)Longtail_Alloc(0, file_size + 1);
+    uint32_t seed = 4711;
+    for (uint32_t f = 0; f < file_count; ++f)
+    {
+        for (uint32_t i = 0; i < file_size; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            content[i] = (char)('a' + (seed >> 27));
+        }
+        content[file_size] = 0;
+        char path[64];
+        sprintf(path, "source/file%u.bin", f);
+        WriteTestFile(storage_api, path, content);
+    }
+    Longtail_Free(content);
 
-    Longtail_Free(version1_block_store_store_index);
+    Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(storage_api, 0, 0, 0, "source", &file_infos));
+    Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "source", file_infos, 0, 4096, &version_index));
+    uint32_t chunk_count = *version_index->m_ChunkCount;
+    ASSERT_LT(file_count * 4, chunk_count);
 
-    Longtail_Free(version1_index);
+    // Chunks in version order end up back to back in a block and are read straight into the block data
+    Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, Longtail_CreateStoreIndex(hash_api, chunk_count, version_index->m_ChunkHashes, version_index->m_ChunkSizes, 0, 1024 * 1024, 1024, &store_index));
+    ASSERT_EQ(1u, *store_index->m_BlockCount);
+    storage->m_OpenReadCount = 0;
+    storage->m_ReadCount = 0;
+    WriteContentAndValidateBlocks(storage_api, hash_api, job_api, block_store_api, store_index, version_index);
+    ASSERT_EQ((int32_t)file_count, storage->m_OpenReadCount);
+    ASSERT_EQ((int32_t)file_count, storage->m_ReadCount);
+    Longtail_Free(store_index);
 
-    Longtail_Free(version1_file_infos);
+    // Chunks in reverse order are still fetched with one read per file
+    TLongtail_Hash* reversed_hashes = (TLongtail_Hash*)Longtail_Alloc(0, sizeof(TLongtail_Hash) * chunk_count);
+    uint32_t* reversed_sizes = (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * chunk_count);
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        reversed_hashes[c] = version_index->m_ChunkHashes[chunk_count - 1 - c];
+        reversed_sizes[c] = version_index->m_ChunkSizes[chunk_count - 1 - c];
+    }
+    ASSERT_EQ(0, Longtail_CreateStoreIndex(hash_api, chunk_count, reversed_hashes, reversed_sizes, 0, 1024 * 1024, 1024, &store_index));
+    Longtail_Free(reversed_sizes);
+    Longtail_Free(reversed_hashes);
+    ASSERT_EQ(1u, *store_index->m_BlockCount);
+    storage->m_OpenReadCount = 0;
+    storage->m_ReadCount = 0;
+    WriteContentAndValidateBlocks(storage_api, hash_api, job_api, block_store_api, store_index, version_index);
+    ASSERT_EQ((int32_t)file_count, storage->m_OpenReadCount);
+    ASSERT_EQ((int32_t)file_count, storage->m_ReadCount);
+    Longtail_Free(store_index);
 
-    SAFE_DISPOSE_API(block_store);
+    Longtail_Free(version_index);
+    Longtail_Free(file_infos);
+
+    SAFE_DISPOSE_API(block_store_api);
     SAFE_DISPOSE_API(job_api);
-    SAFE_DISPOSE_API(storage_api);
-    SAFE_DISPOSE_API(hash_api);
     SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+    SAFE_DISPOSE_API(mem_storage);
 }
 
-struct FailableStorageAPI
+struct FSBlockStorePutBlockWorkerContext
 {
-    struct Longtail_StorageAPI m_API;
-    struct Longtail_StorageAPI* m_BackingAPI;
-    int m_PassCount;
-    int m_WriteError;
-
-    static void Dispose(struct Longtail_API* api) { Longtail_Free(api); }
-    static int OpenReadFile(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HOpenFile* out_open_file) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->OpenReadFile(api->m_BackingAPI, path, out_open_file);}
-    static int GetSize(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t* out_size) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->GetSize(api->m_BackingAPI, f, out_size);}
-    static int Read(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length, void* output) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->Read(api->m_BackingAPI, f, offset, length, output);}
-    static int OpenWriteFile(struct Longtail_StorageAPI* storage_api, const char* path, uint64_t initial_size, Longtail_StorageAPI_HOpenFile* out_open_file) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->OpenWriteFile(api->m_BackingAPI, path, initial_size, out_open_file);}
-    static int Write(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length, const void* input) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return ((api->m_PassCount-- <= 0) && offset > 0 && api->m_WriteError != 0) ? api->m_WriteError : api->m_BackingAPI->Write(api->m_BackingAPI, f, offset, length, input);}
-    static int SetSize(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t length) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->SetSize(api->m_BackingAPI, f, length);}
-    static int SetPermissions(struct Longtail_StorageAPI* storage_api, const char* path, uint16_t permissions) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->SetPermissions(api->m_BackingAPI, path, permissions);}
-    static int GetPermissions(struct Longtail_StorageAPI* storage_api, const char* path, uint16_t* out_permissions) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->GetPermissions(api->m_BackingAPI, path, out_permissions);}
-    static void CloseFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->CloseFile(api->m_BackingAPI, f);}
-    static int CreateDir(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->CreateDir(api->m_BackingAPI, path);}
-    static int RenameFile(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->RenameFile(api->m_BackingAPI, source_path, target_path);}
-    static char* ConcatPath(struct Longtail_StorageAPI* storage_api, const char* root_path, const char* sub_path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->ConcatPath(api->m_BackingAPI, root_path, sub_path);}
-    static int IsDir(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->IsDir(api->m_BackingAPI, path);}
-    static int IsFile(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->IsFile(api->m_BackingAPI, path);}
-    static int RemoveDir(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->RemoveDir(api->m_BackingAPI, path);}
-    static int RemoveFile(struct Longtail_StorageAPI* storage_api, const char* path) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->RemoveFile(api->m_BackingAPI, path);}
-    static int StartFind(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HIterator* out_iterator) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->StartFind(api->m_BackingAPI, path, out_iterator);}
-    static int FindNext(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->FindNext(api->m_BackingAPI, iterator);}
-    static void CloseFind(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->CloseFind(api->m_BackingAPI, iterator);}
-    static int GetEntryProperties(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator, struct Longtail_StorageAPI_EntryProperties* out_properties) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->GetEntryProperties(api->m_BackingAPI, iterator, out_properties);}
-    static int LockFile(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HLockFile* out_lock_file) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->LockFile(api->m_BackingAPI, path, out_lock_file);}
-    static int UnlockFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HLockFile lock_file) { struct FailableStorageAPI* api = (struct FailableStorageAPI*)storage_api; return api->m_BackingAPI->UnlockFile(api->m_BackingAPI, lock_file);}
+    Longtail_BlockStoreAPI* block_store_api;
+    Longtail_StoredBlock* stored_block;
+    TestAsyncPutBlockComplete* put_cb;
 };
 
-struct FailableStorageAPI* CreateFailableStorageAPI(struct Longtail_StorageAPI* backing_api)
+static int FSBlockStorePutBlockWorker(void* context_data)
 {
-    void* mem = Longtail_Alloc(0, sizeof(struct FailableStorageAPI));
-    struct Longtail_StorageAPI* api = Longtail_MakeStorageAPI(
-        mem,
-        FailableStorageAPI::Dispose,
-        FailableStorageAPI::OpenReadFile,
-        FailableStorageAPI::GetSize,
-        FailableStorageAPI::Read,
-        FailableStorageAPI::OpenWriteFile,
-        FailableStorageAPI::Write,
-        FailableStorageAPI::SetSize,
-        FailableStorageAPI::SetPermissions,
-        FailableStorageAPI::GetPermissions,
-        FailableStorageAPI::CloseFile,
-        FailableStorageAPI::CreateDir,
-        FailableStorageAPI::RenameFile,
-        FailableStorageAPI::ConcatPath,
-        FailableStorageAPI::IsDir,
-        FailableStorageAPI::IsFile,
-        FailableStorageAPI::RemoveDir,
-        FailableStorageAPI::RemoveFile,
-        FailableStorageAPI::StartFind,
-        FailableStorageAPI::FindNext,
-        FailableStorageAPI::CloseFind,
-        FailableStorageAPI::GetEntryProperties,
-        FailableStorageAPI::LockFile,
-        FailableStorageAPI::UnlockFile);
-    struct FailableStorageAPI* failable_storage_api = (struct FailableStorageAPI*)api;
-    failable_storage_api->m_BackingAPI = backing_api;
-    failable_storage_api->m_PassCount = 0x7fffffff;
-    failable_storage_api->m_WriteError = 0;
-    return failable_storage_api;
+    struct FSBlockStorePutBlockWorkerContext* context = (struct FSBlockStorePutBlockWorkerContext*)context_data;
+    return context->block_store_api->PutStoredBlock(context->block_store_api, context->stored_block, &context->put_cb->m_API);
+}
+
+TEST(Longtail, Longtail_FSBlockStoreGetDuringPut)
+{
+    Longtail_StorageAPI* mem_storage = Longtail_CreateInMemStorageAPI();
+    struct FailableStorageAPI* gated_storage_api = CreateFailableStorageAPI(mem_storage);
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, &gated_storage_api->m_API, "chunks", 0);
+
+    ASSERT_EQ(0, Longtail_CreateSema(Longtail_Alloc(0, Longtail_GetSemaSize()), 0, &gated_storage_api->m_WriteGate));
+    ASSERT_EQ(0, Longtail_CreateSema(Longtail_Alloc(0, Longtail_GetSemaSize()), 0, &gated_storage_api->m_WriteEntered));
+    HLongtail_Sema write_gate = gated_storage_api->m_WriteGate;
+    HLongtail_Sema write_entered = gated_storage_api->m_WriteEntered;
+
+    struct Longtail_StoredBlock* put_block = TestCreateStoredBlock(hash_api, 7, 3, 1024);
+    TLongtail_Hash block_hash = *put_block->m_BlockIndex->m_BlockHash;
+
+    TestAsyncPutBlockComplete putCB;
+    struct FSBlockStorePutBlockWorkerContext put_context = { block_store_api, put_block, &putCB };
+    HLongtail_Thread put_thread;
+    ASSERT_EQ(0, Longtail_CreateThread(Longtail_Alloc(0, Longtail_GetThreadSize()), FSBlockStorePutBlockWorker, 0, &put_context, -1, &put_thread));
+
+    // Wait until the put is stuck writing the block
+    ASSERT_EQ(0, Longtail_WaitSema(write_entered, LONGTAIL_TIMEOUT_INFINITE));
+
+    // The gets must not block, they complete when the put has written the block
+    TestAsyncGetBlockComplete getCB1;
+    TestAsyncGetBlockComplete getCB2;
+    ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, block_hash, &getCB1.m_API));
+    ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, block_hash, &getCB2.m_API));
+    ASSERT_EQ((Longtail_StoredBlock*)0, getCB1.m_StoredBlock);
+    ASSERT_EQ((Longtail_StoredBlock*)0, getCB2.m_StoredBlock);
+    ASSERT_EQ(EINVAL, getCB1.m_Err);
+    ASSERT_EQ(EINVAL, getCB2.m_Err);
+
+    gated_storage_api->m_WriteGate = 0;
+    ASSERT_EQ(0, Longtail_PostSema(write_gate, 1));
+
+    ASSERT_EQ(0, Longtail_JoinThread(put_thread, LONGTAIL_TIMEOUT_INFINITE));
+    Longtail_DeleteThread(put_thread);
+    Longtail_Free(put_thread);
+    putCB.Wait();
+    ASSERT_EQ(0, putCB.m_Err);
+
+    getCB1.Wait();
+    getCB2.Wait();
+    ASSERT_EQ(0, getCB1.m_Err);
+    ASSERT_EQ(0, getCB2.m_Err);
+    ASSERT_NE((Longtail_StoredBlock*)0, getCB1.m_StoredBlock);
+    ASSERT_NE((Longtail_StoredBlock*)0, getCB2.m_StoredBlock);
+    ASSERT_EQ(block_hash, *getCB1.m_StoredBlock->m_BlockIndex->m_BlockHash);
+    ASSERT_EQ(put_block->m_BlockChunksDataSize, getCB2.m_StoredBlock->m_BlockChunksDataSize);
+    ASSERT_EQ(0, memcmp(put_block->m_BlockData, getCB1.m_StoredBlock->m_BlockData, put_block->m_BlockChunksDataSize));
+    ASSERT_EQ(0, memcmp(put_block->m_BlockData, getCB2.m_StoredBlock->m_BlockData, put_block->m_BlockChunksDataSize));
+    getCB1.m_StoredBlock->Dispose(getCB1.m_StoredBlock);
+    getCB2.m_StoredBlock->Dispose(getCB2.m_StoredBlock);
+    put_block->Dispose(put_block);
+
+    Longtail_BlockStore_Stats stats;
+    block_store_api->GetStats(block_store_api, &stats);
+    ASSERT_EQ(2, stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+    ASSERT_EQ(0, stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount]);
+    ASSERT_EQ(6, stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count]);
+
+    SAFE_DISPOSE_API(block_store_api);
+    Longtail_DeleteSema(write_entered);
+    Longtail_Free(write_entered);
+    Longtail_DeleteSema(write_gate);
+    Longtail_Free(write_gate);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(&gated_storage_api->m_API);
+    SAFE_DISPOSE_API(mem_storage);
 }
 
 TEST(Longtail, TestChangeVersionDiskFull)
@@ -5735,51 +8073,174 @@ TEST(Longtail, TestLongtailBlockFS)
                 }
             }
 
-            block_store_fs->CloseFile(block_store_fs, block_store_file);
+            block_store_fs->CloseFile(block_store_fs, block_store_file);
+
+            Longtail_StorageAPI_HOpenFile open_file;
+            ASSERT_EQ(0, mem_storage->OpenReadFile(mem_storage, full_path, &open_file));
+            uint64_t validate_size;
+            ASSERT_EQ(0, mem_storage->GetSize(mem_storage, open_file, &validate_size));
+            char* validate_buf = (char*)Longtail_Alloc(0, validate_size);
+            ASSERT_EQ(0, mem_storage->Read(mem_storage, open_file, 0, validate_size, validate_buf));
+            mem_storage->CloseFile(mem_storage, open_file);
+
+            ASSERT_EQ(size, validate_size);
+            const uint8_t* p1 = (const uint8_t*)buf;
+            const uint8_t* p2 = (const uint8_t*)validate_buf;
+            for (uint64_t i = 0; i < size; ++i)
+            {
+                if (p1[i] != p2[i])
+                {
+                    ASSERT_TRUE(false);
+                }
+            }
+
+//            data_read_count += size;
+
+            Longtail_Free(buf);
+
+            Longtail_Free(validate_buf);
+        }
+        Longtail_Free(full_path);
+    }
+
+    SAFE_DISPOSE_API(block_store_fs);
+
+//    printf("\nDone...\n");
+
+    Longtail_Free(block_store_store_index);
+    block_store_store_index = 0;
+
+    Longtail_Free(vindex);
+    vindex = 0;
+
+    Longtail_Free(compression_types);
+    compression_types = 0;
+
+    Longtail_Free(version_paths);
+    version_paths = 0;
+    SAFE_DISPOSE_API(block_store);
+    SAFE_DISPOSE_API(raw_block_store);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(mem_storage);
+}
+
+TEST(Longtail, TestSeekableCompressBlockStoreReadVersion)
+{
+    static const uint32_t MAX_BLOCK_SIZE = 65536;
+    static const uint32_t MAX_CHUNKS_PER_BLOCK = 64u;
+
+    Longtail_StorageAPI* mem_storage = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(4, 0);
+    Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
+    Longtail_BlockStoreAPI* raw_block_store = Longtail_CreateFSBlockStoreAPI(job_api, mem_storage, "store", 0);
+    Longtail_BlockStoreAPI* block_store = Longtail_CreateSeekableCompressBlockStoreAPI(raw_block_store, compression_registry, 4096);
+
+    // Assets that span several blocks are written from partial blocks
+    CreateRandomContent(mem_storage, "source", 8, 1024, MAX_BLOCK_SIZE * 3);
+
+    Longtail_FileInfos* version_paths;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(mem_storage, 0, 0, 0, "source", &version_paths));
+    uint32_t* compression_types = SetAssetTags(mem_storage, version_paths, Longtail_GetZStdDefaultQuality());
+    Longtail_VersionIndex* vindex;
+    ASSERT_EQ(0, Longtail_CreateVersionIndex(
+        mem_storage,
+        hash_api,
+        chunker_api,
+        job_api,
+        0,
+        0,
+        0,
+        "source",
+        version_paths,
+        compression_types,
+        MAX_BLOCK_SIZE / MAX_CHUNKS_PER_BLOCK,
+        &vindex));
+
+    struct Longtail_StoreIndex* existing_store_index = SyncGetExistingContent(block_store, *vindex->m_ChunkCount, vindex->m_ChunkHashes, 0);
+    struct Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, Longtail_CreateMissingContent(
+        hash_api,
+        existing_store_index,
+        vindex,
+        MAX_BLOCK_SIZE,
+        MAX_CHUNKS_PER_BLOCK,
+        &store_index));
+    Longtail_Free(existing_store_index);
+    ASSERT_EQ(0, Longtail_WriteContent(
+        mem_storage,
+        block_store,
+        job_api,
+        0,
+        0,
+        0,
+        store_index,
+        vindex,
+        "source"));
+    ASSERT_EQ(0, Longtail_WriteVersion(
+        block_store,
+        mem_storage,
+        job_api,
+        0,
+        0,
+        0,
+        store_index,
+        vindex,
+        "target",
+        1));
+
+    struct Longtail_StorageAPI* block_store_fs = Longtail_CreateBlockStoreStorageAPI(
+        hash_api,
+        job_api,
+        block_store,
+        store_index,
+        vindex);
+    ASSERT_NE((struct Longtail_StorageAPI*)0, block_store_fs);
 
+    for (uint32_t f = 0; f < version_paths->m_Count; ++f)
+    {
+        const char* path = &version_paths->m_PathData[version_paths->m_PathStartOffsets[f]];
+        char* source_path = mem_storage->ConcatPath(mem_storage, "source", path);
+        char* target_path = mem_storage->ConcatPath(mem_storage, "target", path);
+        if (mem_storage->IsFile(mem_storage, source_path))
+        {
+            uint64_t size = version_paths->m_Sizes[f];
+            char* source_buf = (char*)Longtail_Alloc(0, size);
+            char* target_buf = (char*)Longtail_Alloc(0, size);
             Longtail_StorageAPI_HOpenFile open_file;
-            ASSERT_EQ(0, mem_storage->OpenReadFile(mem_storage, full_path, &open_file));
-            uint64_t validate_size;
-            ASSERT_EQ(0, mem_storage->GetSize(mem_storage, open_file, &validate_size));
-            char* validate_buf = (char*)Longtail_Alloc(0, validate_size);
-            ASSERT_EQ(0, mem_storage->Read(mem_storage, open_file, 0, validate_size, validate_buf));
+            ASSERT_EQ(0, mem_storage->OpenReadFile(mem_storage, source_path, &open_file));
+            ASSERT_EQ(0, mem_storage->Read(mem_storage, open_file, 0, size, source_buf));
             mem_storage->CloseFile(mem_storage, open_file);
-
-            ASSERT_EQ(size, validate_size);
-            const uint8_t* p1 = (const uint8_t*)buf;
-            const uint8_t* p2 = (const uint8_t*)validate_buf;
-            for (uint64_t i = 0; i < size; ++i)
-            {
-                if (p1[i] != p2[i])
-                {
-                    ASSERT_TRUE(false);
-                }
-            }
-
-//            data_read_count += size;
-
-            Longtail_Free(buf);
-
-            Longtail_Free(validate_buf);
+            ASSERT_EQ(0, mem_storage->OpenReadFile(mem_storage, target_path, &open_file));
+            ASSERT_EQ(0, mem_storage->Read(mem_storage, open_file, 0, size, target_buf));
+            mem_storage->CloseFile(mem_storage, open_file);
+            ASSERT_EQ(0, memcmp(source_buf, target_buf, size));
+
+            // A read from the middle of the asset only needs some of the chunks of a block
+            memset(target_buf, 0, size);
+            uint64_t read_start = size / 3;
+            uint64_t read_size = size / 3 + 1;
+            ASSERT_EQ(0, block_store_fs->OpenReadFile(block_store_fs, path, &open_file));
+            ASSERT_EQ(0, block_store_fs->Read(block_store_fs, open_file, read_start, read_size, target_buf));
+            block_store_fs->CloseFile(block_store_fs, open_file);
+            ASSERT_EQ(0, memcmp(&source_buf[read_start], target_buf, read_size));
+
+            Longtail_Free(target_buf);
+            Longtail_Free(source_buf);
         }
-        Longtail_Free(full_path);
+        Longtail_Free(target_path);
+        Longtail_Free(source_path);
     }
 
     SAFE_DISPOSE_API(block_store_fs);
-
-//    printf("\nDone...\n");
-
-    Longtail_Free(block_store_store_index);
-    block_store_store_index = 0;
-
+    Longtail_Free(store_index);
     Longtail_Free(vindex);
-    vindex = 0;
-
     Longtail_Free(compression_types);
-    compression_types = 0;
-
     Longtail_Free(version_paths);
-    version_paths = 0;
     SAFE_DISPOSE_API(block_store);
     SAFE_DISPOSE_API(raw_block_store);
     SAFE_DISPOSE_API(compression_registry);
@@ -6261,6 +8722,10 @@ static int ValidateVersion(
     {
         return EINVAL;
     }
+    if (*version_diff->m_MovedCount != 0)
+    {
+        return EINVAL;
+    }
     if (*version_diff->m_TargetAddedCount != 0)
     {
         return EINVAL;
@@ -6282,6 +8747,104 @@ static int ValidateVersion(
     return 0;
 }
 
+// Chunking and block settings for the tests that upload a version folder and change another folder to it
+static const uint32_t VERSION_TEST_TARGET_CHUNK_SIZE = 16384;
+static const uint32_t VERSION_TEST_MAX_BLOCK_SIZE = 65536;
+static const uint32_t VERSION_TEST_MAX_CHUNKS_PER_BLOCK = 1024u;
+
+// Fills @p data with xorshift noise, @p seed carries the state so consecutive calls continue the sequence
+static void FillXorShiftTestData(uint32_t* seed, uint8_t* data, uint32_t size)
+{
+    uint32_t s = *seed;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        data[i] = (uint8_t)s;
+    }
+    *seed = s;
+}
+
+struct VersionTestContext
+{
+    Longtail_StorageAPI* m_StorageAPI;
+    Longtail_HashAPI* m_HashAPI;
+    Longtail_ChunkerAPI* m_ChunkerAPI;
+    Longtail_JobAPI* m_JobAPI;
+    Longtail_BlockStoreAPI* m_BlockStoreAPI;
+
+    VersionTestContext()
+        : m_StorageAPI(Longtail_CreateInMemStorageAPI())
+        , m_HashAPI(Longtail_CreateBlake3HashAPI())
+        , m_ChunkerAPI(Longtail_CreateHPCDCChunkerAPI())
+        , m_JobAPI(Longtail_CreateBikeshedJobAPI(0, 0))
+        , m_BlockStoreAPI(0)
+    {
+        m_BlockStoreAPI = Longtail_CreateFSBlockStoreAPI(m_JobAPI, m_StorageAPI, "store", 0);
+    }
+    ~VersionTestContext()
+    {
+        SAFE_DISPOSE_API(m_BlockStoreAPI);
+        SAFE_DISPOSE_API(m_JobAPI);
+        SAFE_DISPOSE_API(m_ChunkerAPI);
+        SAFE_DISPOSE_API(m_HashAPI);
+        SAFE_DISPOSE_API(m_StorageAPI);
+    }
+
+    // Disposes and recreates the block store, the stats start over but the stored blocks are kept
+    void ReopenBlockStore()
+    {
+        SAFE_DISPOSE_API(m_BlockStoreAPI);
+        m_BlockStoreAPI = Longtail_CreateFSBlockStoreAPI(m_JobAPI, m_StorageAPI, "store", 0);
+    }
+
+    int WriteAsset(const char* path, const void* data, uint64_t size)
+    {
+        if (!CreateParentPath(m_StorageAPI, path))
+        {
+            return EINVAL;
+        }
+        Longtail_StorageAPI_HOpenFile f;
+        int err = m_StorageAPI->OpenWriteFile(m_StorageAPI, path, 0, &f);
+        if (err)
+        {
+            return err;
+        }
+        err = m_StorageAPI->Write(m_StorageAPI, f, 0, size, data);
+        m_StorageAPI->CloseFile(m_StorageAPI, f);
+        return err;
+    }
+
+    int Upload(const char* source_path, const char* version_index_path)
+    {
+        return UploadFolder(m_StorageAPI, m_HashAPI, m_ChunkerAPI, m_JobAPI, m_BlockStoreAPI, source_path, version_index_path, VERSION_TEST_TARGET_CHUNK_SIZE, VERSION_TEST_MAX_BLOCK_SIZE, VERSION_TEST_MAX_CHUNKS_PER_BLOCK);
+    }
+
+    int Download(Longtail_BlockStoreAPI* block_store_api, const char* version_index_path, const char* target_path)
+    {
+        return DownloadFolder(m_StorageAPI, m_HashAPI, m_ChunkerAPI, m_JobAPI, block_store_api, version_index_path, target_path, VERSION_TEST_TARGET_CHUNK_SIZE, VERSION_TEST_MAX_BLOCK_SIZE, VERSION_TEST_MAX_CHUNKS_PER_BLOCK);
+    }
+
+    int Validate(const char* expected_content_path, const char* content_path)
+    {
+        return ValidateVersion(m_StorageAPI, m_HashAPI, m_ChunkerAPI, m_JobAPI, expected_content_path, content_path, VERSION_TEST_TARGET_CHUNK_SIZE);
+    }
+
+    int CreateVersionIndex(const char* root_path, Longtail_VersionIndex** out_version_index)
+    {
+        struct Longtail_FileInfos* file_infos;
+        int err = Longtail_GetFilesRecursively(m_StorageAPI, 0, 0, 0, root_path, &file_infos);
+        if (err)
+        {
+            return err;
+        }
+        err = Longtail_CreateVersionIndex(m_StorageAPI, m_HashAPI, m_ChunkerAPI, m_JobAPI, 0, 0, 0, root_path, file_infos, 0, VERSION_TEST_TARGET_CHUNK_SIZE, out_version_index);
+        Longtail_Free(file_infos);
+        return err;
+    }
+};
+
 struct CaptureBlockStore
 {
     struct Longtail_BlockStoreAPI m_API;
@@ -6371,92 +8934,551 @@ struct Longtail_BlockStoreAPI* CaptureBlockStoreInit(struct CaptureBlockStore* s
 }
 
 
-TEST(Longtail, TestCacheBlockStoreGetExistingContent)
+TEST(Longtail, TestCacheBlockStoreGetExistingContent)
+{
+    static const uint32_t TARGET_CHUNK_SIZE = 8192;
+    static const uint32_t MAX_BLOCK_SIZE = 26973;
+    static const uint32_t MAX_CHUNKS_PER_BLOCK = 11u;
+
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* local_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "cache-store", 0);
+    Longtail_BlockStoreAPI* remote_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "remote-store", 0);
+    CaptureBlockStore remote_capture_store_api_instance;
+    Longtail_BlockStoreAPI* remote_capture_store_api = CaptureBlockStoreInit(&remote_capture_store_api_instance, remote_block_store_api);
+    Longtail_BlockStoreAPI* cache_block_store_api = Longtail_CreateCacheBlockStoreAPI(job_api, local_block_store_api, remote_capture_store_api);
+
+    CreateRandomContent(storage_api, "version1", 3/*MAX_CHUNKS_PER_BLOCK * 3*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+    ASSERT_EQ(0, CopyDir(storage_api, "version1", "version2"));
+    CreateRandomContent(storage_api, "version2", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+    ASSERT_EQ(0, CopyDir(storage_api, "version2", "version3"));
+    CreateRandomContent(storage_api, "version3", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+    ASSERT_EQ(0, CopyDir(storage_api, "version3", "version4"));
+    CreateRandomContent(storage_api, "version4", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+    CreateRandomContent(storage_api, "version5", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+    CreateRandomContent(storage_api, "version6", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+    ASSERT_EQ(0, CopyDir(storage_api, "version6", "version7"));
+    CreateRandomContent(storage_api, "version7", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+    ASSERT_EQ(0, CopyDir(storage_api, "version4", "version8"));
+    ASSERT_EQ(0, CopyDir(storage_api, "version5", "version8"));
+    CreateRandomContent(storage_api, "version8", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+
+    const char* version_names[8] = {"version1", "version2", "version3", "version4", "version5", "version6", "version7", "version8"};
+
+    for (uint32_t v = 0; v < 8; ++v)
+    {
+        char lvi_name[64];
+        sprintf(lvi_name, "%s.lvi", version_names[v]);
+        ASSERT_EQ(0, UploadFolder(storage_api, hash_api, chunker_api, job_api, remote_block_store_api, version_names[v], lvi_name, TARGET_CHUNK_SIZE, MAX_BLOCK_SIZE, MAX_CHUNKS_PER_BLOCK));
+    }
+
+    for (uint32_t v = 0; v < 8; ++v)
+    {
+        SAFE_DISPOSE_API(cache_block_store_api);
+        SAFE_DISPOSE_API(remote_capture_store_api);
+        SAFE_DISPOSE_API(remote_block_store_api);
+        SAFE_DISPOSE_API(local_block_store_api);
+
+        local_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "cache-store", 0);
+        remote_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "remote-store", 0);
+        remote_capture_store_api = CaptureBlockStoreInit(&remote_capture_store_api_instance, remote_block_store_api);
+        cache_block_store_api = Longtail_CreateCacheBlockStoreAPI(job_api, local_block_store_api, remote_capture_store_api);
+
+        for (uint32_t w = v; w < 8; ++w)
+        {
+            char lvi_name[64];
+            sprintf(lvi_name, "%s.lvi", version_names[w]);
+            ASSERT_EQ(0, DownloadFolder(storage_api, hash_api, chunker_api, job_api, cache_block_store_api, lvi_name, "current", TARGET_CHUNK_SIZE, MAX_BLOCK_SIZE, MAX_CHUNKS_PER_BLOCK));
+
+            {
+                TestAsyncFlushComplete flushCB;
+                ASSERT_EQ(0, cache_block_store_api->Flush(cache_block_store_api, &flushCB.m_API));
+                flushCB.Wait();
+                ASSERT_EQ(0, flushCB.m_Err);
+            }
+            {
+                TestAsyncFlushComplete flushCB;
+                ASSERT_EQ(0, local_block_store_api->Flush(local_block_store_api, &flushCB.m_API));
+                flushCB.Wait();
+                ASSERT_EQ(0, flushCB.m_Err);
+            }
+
+
+            ASSERT_EQ(0, ValidateVersion(storage_api, hash_api, chunker_api, job_api,  version_names[w], "current", TARGET_CHUNK_SIZE));
+        }
+    }
+
+    SAFE_DISPOSE_API(cache_block_store_api);
+    SAFE_DISPOSE_API(remote_capture_store_api);
+    SAFE_DISPOSE_API(remote_block_store_api);
+    SAFE_DISPOSE_API(local_block_store_api);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+TEST(Longtail, Longtail_ChangeVersionPatchesFromLocalContent)
+{
+    VersionTestContext t;
+
+    // A large asset where only a small range in the middle changes between the versions
+    const uint32_t asset_size = 2 * 1024 * 1024;
+    uint8_t* asset_data = (uint8_t*)Longtail_Alloc(0, asset_size);
+    uint32_t seed = 0x9e3779b9u;
+    FillXorShiftTestData(&seed, asset_data, asset_size);
+    const char* asset_paths[3] = { "version1/big.bin", "current/big.bin", "version2/big.bin" };
+    for (uint32_t a = 0; a < 3; ++a)
+    {
+        if (a == 2)
+        {
+            memset(&asset_data[asset_size / 2], 0x55, 4096);
+        }
+        ASSERT_EQ(0, t.WriteAsset(asset_paths[a], asset_data, asset_size));
+    }
+    Longtail_Free(asset_data);
+
+    ASSERT_EQ(0, t.Upload("version2", "version2.lvi"));
+    Longtail_BlockStore_Stats upload_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &upload_stats));
+    uint64_t block_count = upload_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Count];
+    ASSERT_LT(16u, block_count);
+
+    ASSERT_EQ(0, t.Download(t.m_BlockStoreAPI, "version2.lvi", "current"));
+    ASSERT_EQ(0, t.Validate("version2", "current"));
+    ASSERT_EQ(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current/big.bin.longtail_patch"));
+
+    // Only the blocks holding the changed chunks are read
+    Longtail_BlockStore_Stats download_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &download_stats));
+    ASSERT_GE(2u, download_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+}
+
+TEST(Longtail, Longtail_ChangeVersionPatchVerifiesLocalChunks)
+{
+    VersionTestContext t;
+
+    // Several large assets where a small range changes between the versions, all of them are patched in one batch
+    const uint32_t asset_count = 3;
+    const uint32_t asset_size = 1024 * 1024;
+    const char* asset_names[asset_count] = { "a.bin", "b.bin", "c.bin" };
+    uint8_t* asset_data = (uint8_t*)Longtail_Alloc(0, asset_size);
+    uint32_t seed = 0x2545f491u;
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        FillXorShiftTestData(&seed, asset_data, asset_size);
+        const char* folders[3] = { "version1", "current", "version2" };
+        for (uint32_t f = 0; f < 3; ++f)
+        {
+            if (f == 2)
+            {
+                memset(&asset_data[asset_size / 2], 0x33, 4096);
+            }
+            char asset_path[64];
+            sprintf(asset_path, "%s/%s", folders[f], asset_names[a]);
+            ASSERT_EQ(0, t.WriteAsset(asset_path, asset_data, asset_size));
+        }
+    }
+    Longtail_Free(asset_data);
+
+    ASSERT_EQ(0, t.Upload("version1", "version1.lvi"));
+    ASSERT_EQ(0, t.Upload("version2", "version2.lvi"));
+
+    // The local copy of a.bin is damaged without changing its size, the source version index still describes version1
+    {
+        uint8_t* local_data = (uint8_t*)Longtail_Alloc(0, asset_size);
+        Longtail_StorageAPI_HOpenFile file;
+        ASSERT_EQ(0, t.m_StorageAPI->OpenReadFile(t.m_StorageAPI, "current/a.bin", &file));
+        ASSERT_EQ(0, t.m_StorageAPI->Read(t.m_StorageAPI, file, 0, asset_size, local_data));
+        t.m_StorageAPI->CloseFile(t.m_StorageAPI, file);
+        memcpy(&local_data[100000], "corrupted chunk!", 16);
+        ASSERT_EQ(0, t.WriteAsset("current/a.bin", local_data, asset_size));
+        Longtail_Free(local_data);
+    }
+
+    Longtail_VersionIndex* source_version;
+    ASSERT_EQ(0, Longtail_ReadVersionIndex(t.m_StorageAPI, "version1.lvi", &source_version));
+    Longtail_VersionIndex* target_version;
+    ASSERT_EQ(0, Longtail_ReadVersionIndex(t.m_StorageAPI, "version2.lvi", &target_version));
+    Longtail_VersionDiff* version_diff;
+    ASSERT_EQ(0, Longtail_CreateVersionDiff(t.m_HashAPI, source_version, target_version, &version_diff));
+    ASSERT_EQ(asset_count, *version_diff->m_ModifiedContentCount);
+
+    TLongtail_Hash* required_chunk_hashes = (TLongtail_Hash*)Longtail_Alloc(0, sizeof(TLongtail_Hash) * (*target_version->m_ChunkCount));
+    uint32_t required_chunk_count = 0;
+    ASSERT_EQ(0, Longtail_GetRequiredChunkHashes(target_version, version_diff, &required_chunk_count, required_chunk_hashes));
+    Longtail_StoreIndex* store_index = SyncGetExistingContent(t.m_BlockStoreAPI, required_chunk_count, required_chunk_hashes, 0);
+    ASSERT_NE((Longtail_StoreIndex*)0, store_index);
+    Longtail_Free(required_chunk_hashes);
+
+    Longtail_BlockStore_Stats before_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &before_stats));
+    ASSERT_EQ(0, Longtail_ChangeVersion(t.m_BlockStoreAPI, t.m_StorageAPI, t.m_HashAPI, t.m_JobAPI, 0, 0, 0, store_index, source_version, target_version, version_diff, "current", 1));
+    Longtail_BlockStore_Stats after_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &after_stats));
+
+    // The damaged chunk is read from blocks and the assets are still patched rather than rewritten
+    ASSERT_EQ(0, t.Validate("version2", "current"));
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        char staging_path[64];
+        sprintf(staging_path, "current/%s.longtail_patch", asset_names[a]);
+        ASSERT_EQ(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, staging_path));
+    }
+    uint64_t block_read_count = after_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count] - before_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count];
+    ASSERT_GE(asset_count * 2u + 2u, block_read_count);
+    ASSERT_LT(0u, block_read_count);
+
+    Longtail_Free(store_index);
+    Longtail_Free(version_diff);
+    Longtail_Free(target_version);
+    Longtail_Free(source_version);
+}
+
+TEST(Longtail, Longtail_ChangeVersionRemovesNestedAssets)
+{
+    VersionTestContext t;
+
+    // Enough files in nested folders to need several removal jobs per level, some of them read only
+    ASSERT_EQ(0, t.WriteAsset("version2/keep.txt", "keep", 4));
+    ASSERT_EQ(0, t.WriteAsset("current/keep.txt", "keep", 4));
+    for (uint32_t i = 0; i < 640; ++i)
+    {
+        char path[64];
+        sprintf(path, "current/d%u/s%u/f%u.txt", i % 4, (i / 4) % 4, i);
+        ASSERT_EQ(0, t.WriteAsset(path, path, (uint64_t)strlen(path)));
+        if ((i % 7) == 0)
+        {
+            ASSERT_EQ(0, t.m_StorageAPI->SetPermissions(t.m_StorageAPI, path, Longtail_StorageAPI_UserReadAccess));
+        }
+    }
+
+    ASSERT_EQ(0, t.Upload("version2", "version2.lvi"));
+    ASSERT_EQ(0, t.Download(t.m_BlockStoreAPI, "version2.lvi", "current"));
+    ASSERT_EQ(0, t.Validate("version2", "current"));
+    ASSERT_EQ(0, t.m_StorageAPI->IsDir(t.m_StorageAPI, "current/d0"));
+    ASSERT_NE(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current/keep.txt"));
+}
+
+TEST(Longtail, Longtail_ChangeVersionMovesAssets)
+{
+    VersionTestContext t;
+
+    // Two large assets move to new folders unchanged and a small asset is added
+    const uint32_t asset_size = 512 * 1024;
+    uint8_t* asset_data = (uint8_t*)Longtail_Alloc(0, asset_size);
+    uint32_t seed = 0x6b43a9b5u;
+    FillXorShiftTestData(&seed, asset_data, asset_size);
+    struct
+    {
+        const char* m_Path;
+        uint32_t m_Offset;
+        uint32_t m_Size;
+    } assets[5] = {
+        { "current/old/a.bin", 0, asset_size / 2 },
+        { "current/old/b.bin", asset_size / 2, asset_size / 2 },
+        { "version2/new/dir/a.bin", 0, asset_size / 2 },
+        { "version2/b.bin", asset_size / 2, asset_size / 2 },
+        { "version2/c.txt", 17, 1024 } };
+    for (uint32_t a = 0; a < 5; ++a)
+    {
+        ASSERT_EQ(0, t.WriteAsset(assets[a].m_Path, &asset_data[assets[a].m_Offset], assets[a].m_Size));
+    }
+    Longtail_Free(asset_data);
+
+    ASSERT_EQ(0, t.Upload("version2", "version2.lvi"));
+    Longtail_BlockStore_Stats upload_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &upload_stats));
+    ASSERT_LT(4u, upload_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Count]);
+
+    ASSERT_EQ(0, t.Download(t.m_BlockStoreAPI, "version2.lvi", "current"));
+    ASSERT_EQ(0, t.Validate("version2", "current"));
+    ASSERT_EQ(0, t.m_StorageAPI->IsDir(t.m_StorageAPI, "current/old"));
+
+    // Only the block with the added asset is read
+    Longtail_BlockStore_Stats download_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &download_stats));
+    ASSERT_EQ(1u, download_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+}
+
+TEST(Longtail, Longtail_ChangeVersionMovesIntoRemovedPaths)
+{
+    VersionTestContext t;
+
+    // The removed file `x` becomes a folder holding a moved file and the removed folder `z` becomes a moved file
+    struct
+    {
+        const char* m_Path;
+        const char* m_Content;
+    } assets[7] = {
+        { "current/x", "removed file" },
+        { "current/w/y", "moved into removed file path" },
+        { "current/z/old.txt", "removed folder content" },
+        { "current/v.txt", "moved onto removed folder path" },
+        { "version2/x/y", "moved into removed file path" },
+        { "version2/z", "moved onto removed folder path" },
+        { "version2/keep.txt", "keep" } };
+    for (uint32_t a = 0; a < 7; ++a)
+    {
+        ASSERT_EQ(0, t.WriteAsset(assets[a].m_Path, assets[a].m_Content, (uint64_t)strlen(assets[a].m_Content)));
+    }
+
+    ASSERT_EQ(0, t.Upload("version2", "version2.lvi"));
+    ASSERT_EQ(0, t.Download(t.m_BlockStoreAPI, "version2.lvi", "current"));
+    ASSERT_EQ(0, t.Validate("version2", "current"));
+    ASSERT_NE(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current/x/y"));
+    ASSERT_NE(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current/z"));
+    ASSERT_EQ(0, t.m_StorageAPI->IsDir(t.m_StorageAPI, "current/w"));
+
+    // Only the block with the added asset is read
+    Longtail_BlockStore_Stats download_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &download_stats));
+    ASSERT_EQ(1u, download_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+}
+
+TEST(Longtail, Longtail_WriteVersionResumesFromJournal)
+{
+    VersionTestContext t;
+
+    const uint32_t asset_count = 16;
+    const uint32_t asset_size = 32 * 1024;
+    uint8_t* asset_data = (uint8_t*)Longtail_Alloc(0, asset_size);
+    uint32_t seed = 0x1b873593u;
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        FillXorShiftTestData(&seed, asset_data, asset_size);
+        char path[64];
+        sprintf(path, "version/folder%02u/asset.bin", a);
+        ASSERT_EQ(0, t.WriteAsset(path, asset_data, asset_size));
+    }
+    Longtail_Free(asset_data);
+
+    ASSERT_EQ(0, t.Upload("version", "version.lvi"));
+    struct Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, Longtail_ReadVersionIndex(t.m_StorageAPI, "version.lvi", &version_index));
+    struct Longtail_StoreIndex* store_index = SyncGetExistingContent(t.m_BlockStoreAPI, *version_index->m_ChunkCount, version_index->m_ChunkHashes, 0);
+    ASSERT_NE((Longtail_StoreIndex*)0, store_index);
+    uint32_t block_count = *store_index->m_BlockCount;
+    ASSERT_LT(4u, block_count);
+
+    // A file that blocks the creation of one asset folder interrupts the first write after the other assets are written
+    ASSERT_EQ(0, t.WriteAsset("target/folder05", "", 0));
+
+    ASSERT_NE(0, Longtail_WriteVersionJournaled(t.m_BlockStoreAPI, t.m_StorageAPI, t.m_JobAPI, 0, 0, 0, store_index, version_index, "target", "target.journal", 1));
+    ASSERT_NE(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "target.journal"));
+
+    // The resumed write only reads the blocks for the asset that was not completed
+    ASSERT_EQ(0, t.m_StorageAPI->RemoveFile(t.m_StorageAPI, "target/folder05"));
+    t.ReopenBlockStore();
+    ASSERT_EQ(0, Longtail_WriteVersionJournaled(t.m_BlockStoreAPI, t.m_StorageAPI, t.m_JobAPI, 0, 0, 0, store_index, version_index, "target", "target.journal", 1));
+    ASSERT_EQ(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "target.journal"));
+    ASSERT_EQ(0, t.Validate("version", "target"));
+
+    Longtail_BlockStore_Stats resume_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &resume_stats));
+    ASSERT_NE(0u, resume_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+    ASSERT_GE(2u, resume_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+
+    Longtail_Free(store_index);
+    Longtail_Free(version_index);
+}
+
+// One asset is moved, one is removed and one is modified with a small change, returns the uploaded target version
+static void WriteJournalTestVersions(VersionTestContext* t, Longtail_VersionIndex** out_target_version, Longtail_StoreIndex** out_store_index)
+{
+    const uint32_t asset_size = 256 * 1024;
+    uint8_t* asset_data = (uint8_t*)Longtail_Alloc(0, asset_size);
+    uint32_t seed = 0x85ebca6bu;
+    FillXorShiftTestData(&seed, asset_data, asset_size);
+    const char* asset_paths[6] = { "current/old/moved.bin", "current/removed.bin", "current/modified.bin", "version2/new/moved.bin", "version2/modified.bin", "version2/keep.txt" };
+    for (uint32_t a = 0; a < 6; ++a)
+    {
+        if (a == 4)
+        {
+            memset(&asset_data[asset_size / 2], 0x55, 4096);
+        }
+        uint32_t offset = (a == 0 || a == 3) ? 0 : (a == 1) ? asset_size / 4 : (a == 5) ? 17 : asset_size / 2;
+        uint32_t size = (a == 0 || a == 3) ? 32768 : (a == 1) ? 16384 : (a == 5) ? 4 : asset_size / 2;
+        ASSERT_EQ(0, t->WriteAsset(asset_paths[a], &asset_data[offset], size));
+    }
+    Longtail_Free(asset_data);
+
+    ASSERT_EQ(0, t->Upload("version2", "version2.lvi"));
+    ASSERT_EQ(0, Longtail_ReadVersionIndex(t->m_StorageAPI, "version2.lvi", out_target_version));
+    *out_store_index = SyncGetExistingContent(t->m_BlockStoreAPI, *(*out_target_version)->m_ChunkCount, (*out_target_version)->m_ChunkHashes, 0);
+    ASSERT_NE((Longtail_StoreIndex*)0, *out_store_index);
+}
+
+TEST(Longtail, Longtail_ChangeVersionResumesFromJournal)
+{
+    VersionTestContext t;
+
+    struct Longtail_VersionIndex* target_version;
+    struct Longtail_StoreIndex* store_index;
+    WriteJournalTestVersions(&t, &target_version, &store_index);
+
+    struct Longtail_VersionIndex* source_version;
+    ASSERT_EQ(0, t.CreateVersionIndex("current", &source_version));
+    struct Longtail_VersionDiff* version_diff;
+    ASSERT_EQ(0, Longtail_CreateVersionDiff(t.m_HashAPI, source_version, target_version, &version_diff));
+    ASSERT_EQ(1u, *version_diff->m_MovedCount);
+    ASSERT_EQ(1u, *version_diff->m_ModifiedContentCount);
+
+    // A folder in the way of the patch staging file interrupts the first change after the move
+    ASSERT_EQ(0, t.m_StorageAPI->CreateDir(t.m_StorageAPI, "current/modified.bin.longtail_patch"));
+    ASSERT_NE(0, Longtail_ChangeVersionJournaled(t.m_BlockStoreAPI, t.m_StorageAPI, t.m_HashAPI, t.m_JobAPI, 0, 0, 0, store_index, source_version, target_version, version_diff, "current", "current.journal", 1));
+    ASSERT_NE(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current.journal"));
+    ASSERT_NE(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current/new/moved.bin"));
+    ASSERT_EQ(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current/old/moved.bin"));
+    ASSERT_EQ(0, t.m_StorageAPI->RemoveDir(t.m_StorageAPI, "current/modified.bin.longtail_patch"));
+
+    // Without the journal the missing move source is an error and the file at the move target is left alone
+    ASSERT_EQ(ENOENT, Longtail_ChangeVersion(t.m_BlockStoreAPI, t.m_StorageAPI, t.m_HashAPI, t.m_JobAPI, 0, 0, 0, store_index, source_version, target_version, version_diff, "current", 1));
+    ASSERT_NE(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current/new/moved.bin"));
+
+    // The journaled move is skipped and the local file is not patched since it may have been partially written
+    t.ReopenBlockStore();
+    ASSERT_EQ(0, Longtail_ChangeVersionJournaled(t.m_BlockStoreAPI, t.m_StorageAPI, t.m_HashAPI, t.m_JobAPI, 0, 0, 0, store_index, source_version, target_version, version_diff, "current", "current.journal", 1));
+    ASSERT_EQ(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current.journal"));
+    ASSERT_EQ(0, t.Validate("version2", "current"));
+
+    Longtail_BlockStore_Stats resume_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &resume_stats));
+    ASSERT_LT(2u, resume_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+
+    Longtail_Free(version_diff);
+    Longtail_Free(source_version);
+    Longtail_Free(store_index);
+    Longtail_Free(target_version);
+}
+
+TEST(Longtail, Longtail_ChangeVersionRescanSkipsJournal)
 {
-    static const uint32_t TARGET_CHUNK_SIZE = 8192;
-    static const uint32_t MAX_BLOCK_SIZE = 26973;
-    static const uint32_t MAX_CHUNKS_PER_BLOCK = 11u;
+    VersionTestContext t;
 
-    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
-    Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
-    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
-    Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
-    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
-    Longtail_BlockStoreAPI* local_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "cache-store", 0);
-    Longtail_BlockStoreAPI* remote_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "remote-store", 0);
-    CaptureBlockStore remote_capture_store_api_instance;
-    Longtail_BlockStoreAPI* remote_capture_store_api = CaptureBlockStoreInit(&remote_capture_store_api_instance, remote_block_store_api);
-    Longtail_BlockStoreAPI* cache_block_store_api = Longtail_CreateCacheBlockStoreAPI(job_api, local_block_store_api, remote_capture_store_api);
+    struct Longtail_VersionIndex* target_version;
+    struct Longtail_StoreIndex* store_index;
+    WriteJournalTestVersions(&t, &target_version, &store_index);
 
-    CreateRandomContent(storage_api, "version1", 3/*MAX_CHUNKS_PER_BLOCK * 3*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
-    ASSERT_EQ(0, CopyDir(storage_api, "version1", "version2"));
-    CreateRandomContent(storage_api, "version2", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
-    ASSERT_EQ(0, CopyDir(storage_api, "version2", "version3"));
-    CreateRandomContent(storage_api, "version3", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
-    ASSERT_EQ(0, CopyDir(storage_api, "version3", "version4"));
-    CreateRandomContent(storage_api, "version4", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
-    CreateRandomContent(storage_api, "version5", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
-    CreateRandomContent(storage_api, "version6", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
-    ASSERT_EQ(0, CopyDir(storage_api, "version6", "version7"));
-    CreateRandomContent(storage_api, "version7", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
-    ASSERT_EQ(0, CopyDir(storage_api, "version4", "version8"));
-    ASSERT_EQ(0, CopyDir(storage_api, "version5", "version8"));
-    CreateRandomContent(storage_api, "version8", 1/*MAX_CHUNKS_PER_BLOCK*/, 0, MAX_BLOCK_SIZE / 2 /*(MAX_BLOCK_SIZE * 3) >> 1*/);
+    for (uint32_t attempt = 0; attempt < 2; ++attempt)
+    {
+        // The resumed change rescans the folder, the journal is kept outside it so it is not picked up as an asset
+        struct Longtail_VersionIndex* source_version;
+        ASSERT_EQ(0, t.CreateVersionIndex("current", &source_version));
+        struct Longtail_VersionDiff* version_diff;
+        ASSERT_EQ(0, Longtail_CreateVersionDiff(t.m_HashAPI, source_version, target_version, &version_diff));
+        if (attempt == 0)
+        {
+            ASSERT_EQ(0, t.m_StorageAPI->CreateDir(t.m_StorageAPI, "current/modified.bin.longtail_patch"));
+            ASSERT_NE(0, Longtail_ChangeVersionJournaled(t.m_BlockStoreAPI, t.m_StorageAPI, t.m_HashAPI, t.m_JobAPI, 0, 0, 0, store_index, source_version, target_version, version_diff, "current", "current.journal", 1));
+            ASSERT_NE(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current.journal"));
+            ASSERT_EQ(0, t.m_StorageAPI->RemoveDir(t.m_StorageAPI, "current/modified.bin.longtail_patch"));
+        }
+        else
+        {
+            ASSERT_EQ(0u, *version_diff->m_SourceRemovedCount);
+            ASSERT_EQ(0u, *version_diff->m_MovedCount);
+            ASSERT_EQ(0, Longtail_ChangeVersionJournaled(t.m_BlockStoreAPI, t.m_StorageAPI, t.m_HashAPI, t.m_JobAPI, 0, 0, 0, store_index, source_version, target_version, version_diff, "current", "current.journal", 1));
+            ASSERT_EQ(0, t.m_StorageAPI->IsFile(t.m_StorageAPI, "current.journal"));
+        }
+        Longtail_Free(version_diff);
+        Longtail_Free(source_version);
+    }
+    ASSERT_EQ(0, t.Validate("version2", "current"));
 
-    const char* version_names[8] = {"version1", "version2", "version3", "version4", "version5", "version6", "version7", "version8"};
+    Longtail_Free(store_index);
+    Longtail_Free(target_version);
+}
 
-    for (uint32_t v = 0; v < 8; ++v)
+TEST(Longtail, Longtail_SeedBlockStore)
+{
+    VersionTestContext t;
+
+    // The seed folder holds the previous version of an asset, the new version changes a small range and adds an asset
+    const uint32_t asset_size = 2 * 1024 * 1024;
+    uint8_t* asset_data = (uint8_t*)Longtail_Alloc(0, asset_size);
+    uint32_t seed = 0x2545f491u;
+    FillXorShiftTestData(&seed, asset_data, asset_size);
+    const char* asset_paths[3] = { "seed/big.bin", "version2/big.bin", "version2/extra.bin" };
+    for (uint32_t a = 0; a < 3; ++a)
     {
-        char lvi_name[64];
-        sprintf(lvi_name, "%s.lvi", version_names[v]);
-        ASSERT_EQ(0, UploadFolder(storage_api, hash_api, chunker_api, job_api, remote_block_store_api, version_names[v], lvi_name, TARGET_CHUNK_SIZE, MAX_BLOCK_SIZE, MAX_CHUNKS_PER_BLOCK));
+        if (a == 1)
+        {
+            memset(&asset_data[asset_size / 3], 0x55, 4096);
+        }
+        uint32_t size = (a == 2) ? 8192 : asset_size;
+        ASSERT_EQ(0, t.WriteAsset(asset_paths[a], &asset_data[asset_size - size], size));
     }
+    Longtail_Free(asset_data);
+    ASSERT_EQ(0, t.m_StorageAPI->CreateDir(t.m_StorageAPI, "target"));
 
-    for (uint32_t v = 0; v < 8; ++v)
-    {
-        SAFE_DISPOSE_API(cache_block_store_api);
-        SAFE_DISPOSE_API(remote_capture_store_api);
-        SAFE_DISPOSE_API(remote_block_store_api);
-        SAFE_DISPOSE_API(local_block_store_api);
+    ASSERT_EQ(0, t.Upload("version2", "version2.lvi"));
 
-        local_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "cache-store", 0);
-        remote_block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "remote-store", 0);
-        remote_capture_store_api = CaptureBlockStoreInit(&remote_capture_store_api_instance, remote_block_store_api);
-        cache_block_store_api = Longtail_CreateCacheBlockStoreAPI(job_api, local_block_store_api, remote_capture_store_api);
+    struct Longtail_VersionIndex* seed_version_index;
+    ASSERT_EQ(0, t.CreateVersionIndex("seed", &seed_version_index));
 
-        for (uint32_t w = v; w < 8; ++w)
-        {
-            char lvi_name[64];
-            sprintf(lvi_name, "%s.lvi", version_names[w]);
-            ASSERT_EQ(0, DownloadFolder(storage_api, hash_api, chunker_api, job_api, cache_block_store_api, lvi_name, "current", TARGET_CHUNK_SIZE, MAX_BLOCK_SIZE, MAX_CHUNKS_PER_BLOCK));
+    Longtail_BlockStoreAPI* seed_block_store_api = Longtail_CreateSeedBlockStoreAPI(t.m_StorageAPI, t.m_HashAPI, "seed", seed_version_index, t.m_BlockStoreAPI);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, seed_block_store_api);
 
-            {
-                TestAsyncFlushComplete flushCB;
-                ASSERT_EQ(0, cache_block_store_api->Flush(cache_block_store_api, &flushCB.m_API));
-                flushCB.Wait();
-                ASSERT_EQ(0, flushCB.m_Err);
-            }
-            {
-                TestAsyncFlushComplete flushCB;
-                ASSERT_EQ(0, local_block_store_api->Flush(local_block_store_api, &flushCB.m_API));
-                flushCB.Wait();
-                ASSERT_EQ(0, flushCB.m_Err);
-            }
+    ASSERT_EQ(0, t.Download(seed_block_store_api, "version2.lvi", "target"));
+    ASSERT_EQ(0, t.Validate("version2", "target"));
 
+    // Only the blocks holding the changed and added chunks are read from the remote store
+    Longtail_BlockStore_Stats remote_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &remote_stats));
+    ASSERT_LT(16u, remote_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Count]);
+    ASSERT_GE(3u, remote_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+    Longtail_BlockStore_Stats seed_stats;
+    ASSERT_EQ(0, seed_block_store_api->GetStats(seed_block_store_api, &seed_stats));
+    ASSERT_LT(0u, seed_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count]);
+
+    SAFE_DISPOSE_API(seed_block_store_api);
+    Longtail_Free(seed_version_index);
+}
 
-            ASSERT_EQ(0, ValidateVersion(storage_api, hash_api, chunker_api, job_api,  version_names[w], "current", TARGET_CHUNK_SIZE));
-        }
-    }
+TEST(Longtail, Longtail_SeedBlockStoreDamagedSeed)
+{
+    VersionTestContext t;
 
-    SAFE_DISPOSE_API(cache_block_store_api);
-    SAFE_DISPOSE_API(remote_capture_store_api);
-    SAFE_DISPOSE_API(remote_block_store_api);
-    SAFE_DISPOSE_API(local_block_store_api);
-    SAFE_DISPOSE_API(job_api);
-    SAFE_DISPOSE_API(chunker_api);
-    SAFE_DISPOSE_API(hash_api);
-    SAFE_DISPOSE_API(compression_registry);
-    SAFE_DISPOSE_API(storage_api);
+    const uint32_t asset_size = 2 * 1024 * 1024;
+    uint8_t* asset_data = (uint8_t*)Longtail_Alloc(0, asset_size);
+    uint32_t seed = 0x2545f491u;
+    FillXorShiftTestData(&seed, asset_data, asset_size);
+    ASSERT_EQ(0, t.WriteAsset("seed/big.bin", asset_data, asset_size));
+    ASSERT_EQ(0, t.WriteAsset("version2/big.bin", asset_data, asset_size));
+    ASSERT_EQ(0, t.m_StorageAPI->CreateDir(t.m_StorageAPI, "target"));
+
+    ASSERT_EQ(0, t.Upload("version2", "version2.lvi"));
+
+    struct Longtail_VersionIndex* seed_version_index;
+    ASSERT_EQ(0, t.CreateVersionIndex("seed", &seed_version_index));
+
+    // The seed file changes after the seed version index was created, same size but different content in the middle
+    memset(&asset_data[asset_size / 2], 0xaa, 8192);
+    ASSERT_EQ(0, t.WriteAsset("seed/big.bin", asset_data, asset_size));
+    Longtail_Free(asset_data);
+
+    Longtail_BlockStoreAPI* seed_block_store_api = Longtail_CreateSeedBlockStoreAPI(t.m_StorageAPI, t.m_HashAPI, "seed", seed_version_index, t.m_BlockStoreAPI);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, seed_block_store_api);
+
+    // The damaged seed chunks are read from the remote store instead
+    ASSERT_EQ(0, t.Download(seed_block_store_api, "version2.lvi", "target"));
+    ASSERT_EQ(0, t.Validate("version2", "target"));
+
+    Longtail_BlockStore_Stats remote_stats;
+    ASSERT_EQ(0, t.m_BlockStoreAPI->GetStats(t.m_BlockStoreAPI, &remote_stats));
+    ASSERT_LT(0u, remote_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count]);
+    ASSERT_LT(remote_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count], remote_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Count]);
+    Longtail_BlockStore_Stats seed_stats;
+    ASSERT_EQ(0, seed_block_store_api->GetStats(seed_block_store_api, &seed_stats));
+    ASSERT_EQ(0u, seed_stats.m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount]);
+
+    SAFE_DISPOSE_API(seed_block_store_api);
+    Longtail_Free(seed_version_index);
 }
 
 TEST(Longtail, TestFileSystemLock)
@@ -6847,6 +9869,349 @@ TEST(Longtail, Longtail_PruneFSBlockStore)
 }
 
 
+static uint32_t CountFilesInDir(Longtail_StorageAPI* storage_api, const char* path)
+{
+    uint32_t count = 0;
+    Longtail_StorageAPI_HIterator it;
+    int err = storage_api->StartFind(storage_api, path, &it);
+    while (err == 0)
+    {
+        ++count;
+        err = storage_api->FindNext(storage_api, it);
+    }
+    if (count > 0)
+    {
+        storage_api->CloseFind(storage_api, it);
+    }
+    return count;
+}
+
+// Removes the store index snapshot and journal so the store has to rebuild its index from the block data
+static void RemoveStoreIndexFiles(Longtail_StorageAPI* storage_api)
+{
+    if (storage_api->IsFile(storage_api, "store/store.lsi"))
+    {
+        ASSERT_EQ(0, storage_api->RemoveFile(storage_api, "store/store.lsi"));
+    }
+    char entry_paths[32][64];
+    uint32_t entry_count = 0;
+    Longtail_StorageAPI_HIterator it;
+    int err = storage_api->StartFind(storage_api, "store/journal", &it);
+    if (err == 0)
+    {
+        while (err == 0 && entry_count < 32)
+        {
+            Longtail_StorageAPI_EntryProperties properties;
+            ASSERT_EQ(0, storage_api->GetEntryProperties(storage_api, it, &properties));
+            snprintf(entry_paths[entry_count++], 64, "store/journal/%s", properties.m_Name);
+            err = storage_api->FindNext(storage_api, it);
+        }
+        storage_api->CloseFind(storage_api, it);
+    }
+    for (uint32_t e = 0; e < entry_count; ++e)
+    {
+        ASSERT_EQ(0, storage_api->RemoveFile(storage_api, entry_paths[e]));
+    }
+}
+
+TEST(Longtail, Longtail_PackedFSBlockStore)
+{
+    static const uint32_t BLOCK_COUNT = 6;
+    static const uint32_t CHUNKS_PER_BLOCK = 4;
+    static const uint32_t CHUNK_SIZE = 1024;
+    // Room for two blocks per segment
+    static const uint64_t MAX_SEGMENT_SIZE = 10000;
+
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* block_store_api = Longtail_CreatePackedFSBlockStoreAPI(job_api, storage_api, "store", MAX_SEGMENT_SIZE);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+
+    Longtail_StoredBlock* blocks[BLOCK_COUNT];
+    TLongtail_Hash block_hashes[BLOCK_COUNT];
+    TLongtail_Hash chunk_hashes[BLOCK_COUNT * CHUNKS_PER_BLOCK];
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        blocks[b] = TestCreateStoredBlock(hash_api, (uint8_t)(b + 1), CHUNKS_PER_BLOCK, CHUNK_SIZE);
+        ASSERT_NE((Longtail_StoredBlock*)0, blocks[b]);
+        block_hashes[b] = *blocks[b]->m_BlockIndex->m_BlockHash;
+        memcpy(&chunk_hashes[b * CHUNKS_PER_BLOCK], blocks[b]->m_BlockIndex->m_ChunkHashes, sizeof(TLongtail_Hash) * CHUNKS_PER_BLOCK);
+        TestAsyncPutBlockComplete putCB;
+        ASSERT_EQ(0, block_store_api->PutStoredBlock(block_store_api, blocks[b], &putCB.m_API));
+        putCB.Wait();
+        ASSERT_EQ(0, putCB.m_Err);
+    }
+
+    // Block 0 is in a sealed segment, block 5 is in the segment that is still being written
+    for (uint32_t b = 0; b < BLOCK_COUNT; b += BLOCK_COUNT - 1)
+    {
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, block_hashes[b], &getCB.m_API));
+        getCB.Wait();
+        ASSERT_EQ(0, getCB.m_Err);
+        ASSERT_EQ(blocks[b]->m_BlockChunksDataSize, getCB.m_StoredBlock->m_BlockChunksDataSize);
+        ASSERT_EQ(0, memcmp(blocks[b]->m_BlockData, getCB.m_StoredBlock->m_BlockData, blocks[b]->m_BlockChunksDataSize));
+        getCB.m_StoredBlock->Dispose(getCB.m_StoredBlock);
+    }
+
+    TestAsyncFlushComplete flushCB;
+    ASSERT_EQ(0, block_store_api->Flush(block_store_api, &flushCB.m_API));
+    flushCB.Wait();
+    ASSERT_EQ(0, flushCB.m_Err);
+    SAFE_DISPOSE_API(block_store_api);
+
+    // Three segments, each with an offset index, and no per-block files
+    ASSERT_EQ(6u, CountFilesInDir(storage_api, "store/packs"));
+    ASSERT_EQ(0, storage_api->IsDir(storage_api, "store/chunks"));
+
+    // Without a store index the content is rebuilt from the segments
+    RemoveStoreIndexFiles(storage_api);
+    block_store_api = Longtail_CreatePackedFSBlockStoreAPI(job_api, storage_api, "store", MAX_SEGMENT_SIZE);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+
+    TestAsyncGetExistingContentComplete getExistingCB;
+    ASSERT_EQ(0, block_store_api->GetExistingContent(block_store_api, BLOCK_COUNT * CHUNKS_PER_BLOCK, chunk_hashes, 0, &getExistingCB.m_API));
+    getExistingCB.Wait();
+    ASSERT_EQ(0, getExistingCB.m_Err);
+    ASSERT_EQ(BLOCK_COUNT, *getExistingCB.m_StoreIndex->m_BlockCount);
+    Longtail_Free(getExistingCB.m_StoreIndex);
+
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, block_hashes[b], &getCB.m_API));
+        getCB.Wait();
+        ASSERT_EQ(0, getCB.m_Err);
+        ASSERT_EQ(0, memcmp(blocks[b]->m_BlockData, getCB.m_StoredBlock->m_BlockData, blocks[b]->m_BlockChunksDataSize));
+        getCB.m_StoredBlock->Dispose(getCB.m_StoredBlock);
+    }
+
+    // Blocks 2 and 3 share a segment which is removed once both are pruned
+    TLongtail_Hash keep_hashes[4] = {block_hashes[0], block_hashes[1], block_hashes[4], block_hashes[5]};
+    TestAsyncPruneBlocksComplete pruneCB;
+    ASSERT_EQ(0, block_store_api->PruneBlocks(block_store_api, 4, keep_hashes, &pruneCB.m_API));
+    pruneCB.Wait();
+    ASSERT_EQ(0, pruneCB.m_Err);
+    ASSERT_EQ(2, pruneCB.m_PruneCount);
+    ASSERT_EQ(4u, CountFilesInDir(storage_api, "store/packs"));
+    {
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(ENOENT, block_store_api->GetStoredBlock(block_store_api, block_hashes[2], &getCB.m_API));
+    }
+    SAFE_DISPOSE_API(block_store_api);
+
+    // A new store finds the blocks through the offset indexes
+    block_store_api = Longtail_CreatePackedFSBlockStoreAPI(job_api, storage_api, "store", MAX_SEGMENT_SIZE);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+    {
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, block_hashes[4], &getCB.m_API));
+        getCB.Wait();
+        ASSERT_EQ(0, getCB.m_Err);
+        ASSERT_EQ(0, memcmp(blocks[4]->m_BlockData, getCB.m_StoredBlock->m_BlockData, blocks[4]->m_BlockChunksDataSize));
+        getCB.m_StoredBlock->Dispose(getCB.m_StoredBlock);
+    }
+    {
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(ENOENT, block_store_api->GetStoredBlock(block_store_api, block_hashes[3], &getCB.m_API));
+    }
+    SAFE_DISPOSE_API(block_store_api);
+
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        blocks[b]->Dispose(blocks[b]);
+    }
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+
+
+TEST(Longtail, Longtail_PackedFSBlockStoreInterleavedPutGet)
+{
+    static const uint32_t BLOCK_COUNT = 8;
+    static const uint32_t CHUNKS_PER_BLOCK = 4;
+    static const uint32_t CHUNK_SIZE = 1024;
+    static const uint64_t MAX_SEGMENT_SIZE = 1024 * 1024;
+
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* block_store_api = Longtail_CreatePackedFSBlockStoreAPI(job_api, storage_api, "store", MAX_SEGMENT_SIZE);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+
+    // Reading a block of the segment that is being written, or flushing the store, must not seal the segment
+    TLongtail_Hash block_hashes[BLOCK_COUNT];
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        Longtail_StoredBlock* block = TestCreateStoredBlock(hash_api, (uint8_t)(b + 1), CHUNKS_PER_BLOCK, CHUNK_SIZE);
+        ASSERT_NE((Longtail_StoredBlock*)0, block);
+        block_hashes[b] = *block->m_BlockIndex->m_BlockHash;
+        TestAsyncPutBlockComplete putCB;
+        ASSERT_EQ(0, block_store_api->PutStoredBlock(block_store_api, block, &putCB.m_API));
+        putCB.Wait();
+        ASSERT_EQ(0, putCB.m_Err);
+
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, block_hashes[b], &getCB.m_API));
+        getCB.Wait();
+        ASSERT_EQ(0, getCB.m_Err);
+        ASSERT_EQ(block->m_BlockChunksDataSize, getCB.m_StoredBlock->m_BlockChunksDataSize);
+        ASSERT_EQ(0, memcmp(block->m_BlockData, getCB.m_StoredBlock->m_BlockData, block->m_BlockChunksDataSize));
+        getCB.m_StoredBlock->Dispose(getCB.m_StoredBlock);
+        block->Dispose(block);
+
+        TestAsyncFlushComplete flushCB;
+        ASSERT_EQ(0, block_store_api->Flush(block_store_api, &flushCB.m_API));
+        flushCB.Wait();
+        ASSERT_EQ(0, flushCB.m_Err);
+    }
+
+    // One segment and the offset index of its flushed blocks
+    ASSERT_EQ(2u, CountFilesInDir(storage_api, "store/packs"));
+    SAFE_DISPOSE_API(block_store_api);
+
+    // Disposing the store seals the segment
+    ASSERT_EQ(2u, CountFilesInDir(storage_api, "store/packs"));
+    block_store_api = Longtail_CreatePackedFSBlockStoreAPI(job_api, storage_api, "store", MAX_SEGMENT_SIZE);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, block_hashes[b], &getCB.m_API));
+        getCB.Wait();
+        ASSERT_EQ(0, getCB.m_Err);
+        getCB.m_StoredBlock->Dispose(getCB.m_StoredBlock);
+    }
+    SAFE_DISPOSE_API(block_store_api);
+
+    // A store that flushed but never sealed its segment leaves the offset index in the .tmp file,
+    // the blocks are still found without a store index
+    char index_path[64] = "";
+    Longtail_StorageAPI_HIterator it;
+    ASSERT_EQ(0, storage_api->StartFind(storage_api, "store/packs", &it));
+    do
+    {
+        Longtail_StorageAPI_EntryProperties properties;
+        ASSERT_EQ(0, storage_api->GetEntryProperties(storage_api, it, &properties));
+        if (strstr(properties.m_Name, ".lpi"))
+        {
+            snprintf(index_path, sizeof(index_path), "store/packs/%s", properties.m_Name);
+        }
+    } while (storage_api->FindNext(storage_api, it) == 0);
+    storage_api->CloseFind(storage_api, it);
+    ASSERT_NE(0u, (uint32_t)strlen(index_path));
+    char tmp_index_path[64];
+    strcpy(tmp_index_path, index_path);
+    strcpy(&tmp_index_path[strlen(tmp_index_path) - 4], ".tmp");
+    ASSERT_EQ(0, storage_api->RenameFile(storage_api, index_path, tmp_index_path));
+    RemoveStoreIndexFiles(storage_api);
+
+    block_store_api = Longtail_CreatePackedFSBlockStoreAPI(job_api, storage_api, "store", MAX_SEGMENT_SIZE);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        TestAsyncGetBlockComplete getCB;
+        ASSERT_EQ(0, block_store_api->GetStoredBlock(block_store_api, block_hashes[b], &getCB.m_API));
+        getCB.Wait();
+        ASSERT_EQ(0, getCB.m_Err);
+        getCB.m_StoredBlock->Dispose(getCB.m_StoredBlock);
+    }
+    SAFE_DISPOSE_API(block_store_api);
+
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+static void PutAndFlushTestBlock(Longtail_BlockStoreAPI* block_store_api, Longtail_StoredBlock* stored_block)
+{
+    TestAsyncPutBlockComplete putCB;
+    ASSERT_EQ(0, block_store_api->PutStoredBlock(block_store_api, stored_block, &putCB.m_API));
+    putCB.Wait();
+    ASSERT_EQ(0, putCB.m_Err);
+    TestAsyncFlushComplete flushCB;
+    ASSERT_EQ(0, block_store_api->Flush(block_store_api, &flushCB.m_API));
+    flushCB.Wait();
+    ASSERT_EQ(0, flushCB.m_Err);
+}
+
+static uint32_t GetTestStoreBlockCount(Longtail_BlockStoreAPI* block_store_api, uint32_t chunk_count, const TLongtail_Hash* chunk_hashes)
+{
+    TestAsyncGetExistingContentComplete getExistingCB;
+    if (block_store_api->GetExistingContent(block_store_api, chunk_count, chunk_hashes, 0, &getExistingCB.m_API))
+    {
+        return 0;
+    }
+    getExistingCB.Wait();
+    if (getExistingCB.m_Err)
+    {
+        return 0;
+    }
+    uint32_t block_count = *getExistingCB.m_StoreIndex->m_BlockCount;
+    Longtail_Free(getExistingCB.m_StoreIndex);
+    return block_count;
+}
+
+TEST(Longtail, Longtail_FSBlockStoreIndexJournal)
+{
+    static const uint32_t BLOCK_COUNT = 35;
+    static const uint32_t CHUNKS_PER_BLOCK = 2;
+    static const uint32_t CHUNK_SIZE = 64;
+
+    Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(0, 0);
+    Longtail_BlockStoreAPI* block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "store", 0);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+
+    Longtail_StoredBlock* blocks[BLOCK_COUNT];
+    TLongtail_Hash chunk_hashes[BLOCK_COUNT * CHUNKS_PER_BLOCK];
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        blocks[b] = TestCreateStoredBlock(hash_api, (uint8_t)(b + 1), CHUNKS_PER_BLOCK, CHUNK_SIZE);
+        ASSERT_NE((Longtail_StoredBlock*)0, blocks[b]);
+        memcpy(&chunk_hashes[b * CHUNKS_PER_BLOCK], blocks[b]->m_BlockIndex->m_ChunkHashes, sizeof(TLongtail_Hash) * CHUNKS_PER_BLOCK);
+    }
+
+    // Each flush adds a journal entry for its blocks instead of rewriting the snapshot
+    for (uint32_t b = 0; b < 3; ++b)
+    {
+        PutAndFlushTestBlock(block_store_api, blocks[b]);
+    }
+    ASSERT_EQ(3u, CountFilesInDir(storage_api, "store/journal"));
+    ASSERT_EQ(0, storage_api->IsFile(storage_api, "store/store.lsi"));
+    SAFE_DISPOSE_API(block_store_api);
+
+    block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "store", 0);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+    ASSERT_EQ(3u, GetTestStoreBlockCount(block_store_api, BLOCK_COUNT * CHUNKS_PER_BLOCK, chunk_hashes));
+
+    // A long journal is compacted into the snapshot
+    for (uint32_t b = 3; b < BLOCK_COUNT; ++b)
+    {
+        PutAndFlushTestBlock(block_store_api, blocks[b]);
+    }
+    ASSERT_NE(0, storage_api->IsFile(storage_api, "store/store.lsi"));
+    ASSERT_EQ(3u, CountFilesInDir(storage_api, "store/journal"));
+    ASSERT_EQ(BLOCK_COUNT, GetTestStoreBlockCount(block_store_api, BLOCK_COUNT * CHUNKS_PER_BLOCK, chunk_hashes));
+    SAFE_DISPOSE_API(block_store_api);
+
+    block_store_api = Longtail_CreateFSBlockStoreAPI(job_api, storage_api, "store", 0);
+    ASSERT_NE((Longtail_BlockStoreAPI*)0, block_store_api);
+    ASSERT_EQ(BLOCK_COUNT, GetTestStoreBlockCount(block_store_api, BLOCK_COUNT * CHUNKS_PER_BLOCK, chunk_hashes));
+    SAFE_DISPOSE_API(block_store_api);
+
+    for (uint32_t b = 0; b < BLOCK_COUNT; ++b)
+    {
+        blocks[b]->Dispose(blocks[b]);
+    }
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(storage_api);
+    SAFE_DISPOSE_API(hash_api);
+}
 
 TEST(Longtail, Longtail_Archive)
 {